@@ -0,0 +1,297 @@
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include "../common/config_manager.h"
+#include "../common/logger.h"
+#include "../daemon/app_config.h"
+#include "../daemon/cec_daemon.h"
+#include "load_generator.h"
+
+/**
+ * cec-control-bench: start a CECDaemon on the simulated bus inside this
+ * process, drive it over its real Unix socket from client threads, and
+ * report throughput and per-type latency. Everything between the
+ * client and the simulated adapter — SocketServer, CommandDispatcher,
+ * the throttler, AdapterWorker, MainThreadWork — is the code the
+ * daemon ships with.
+ */
+
+namespace cec_control {
+
+namespace {
+
+constexpr std::string_view kDefaultMix =
+    "4:status 0; 2:volume up 5; 2:volume down 5; 1:power on 0; 1:active-source";
+
+struct BenchOptions {
+    LoadProfile profile;
+    std::string mix{kDefaultMix};
+    std::string configFile;
+    std::string replayFile;
+    std::optional<uint32_t> commandLatencyMs;
+    std::optional<uint32_t> nackPercent;
+    bool verbose = false;
+};
+
+void printUsage(const char* programName) {
+    std::cout
+        << "Usage: " << programName << " [OPTIONS]\n"
+        << "\n"
+        << "Run a daemon on the simulated CEC bus and load it over its socket.\n"
+        << "\n"
+        << "OPTIONS:\n"
+        << "  --clients N          Connections, one thread each (default: 4)\n"
+        << "  --depth N            Requests in flight per connection (default: 1)\n"
+        << "  --requests N         Requests to send in all (default: 20000)\n"
+        << "  --mix SPEC           Weighted commands, e.g. \"4:status 0; volume up 5\"\n"
+        << "                       (default: \"" << kDefaultMix << "\")\n"
+        << "  --burst N            Send bursts of N, each answered before the next\n"
+        << "  --pause MS           Idle time after each burst (default: 0)\n"
+        << "  --reconnect-every N  Open a new connection every N requests\n"
+        << "  --exec CLIENT        Run the CLIENT binary once per request instead, and\n"
+        << "                       time each run from startup to exit\n"
+        << "  --no-wait            Pass --no-wait to each --exec run\n"
+        << "  --config FILE        Daemon configuration, [Simulator] included\n"
+        << "  --latency MS         Simulated command latency (overrides the file)\n"
+        << "  --nack PCT           Simulated unacknowledged commands (overrides the file)\n"
+        << "  --replay FILE        Play a [Daemon] CaptureFile recording back on the bus\n"
+        << "  --seed N             Seed for the command picks\n"
+        << "  -v, --verbose        Log daemon activity to stderr\n"
+        << "  -h, --help           Show this help message\n"
+        << "\n"
+        << "All connections come from this process, so the daemon's per-peer\n"
+        << "in-flight cap applies to them together. Commands to one device are\n"
+        << "paced by [Throttler] as on a real bus.\n";
+}
+
+std::optional<std::size_t> parseCount(std::string_view text) {
+    std::size_t value = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size()) return std::nullopt;
+    return value;
+}
+
+/** Parse argv into @p out; false, with the reason on stderr, on a bad option. */
+bool parseOptions(int argc, char* argv[], BenchOptions& out, bool& help) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            help = true;
+            return true;
+        }
+        if (arg == "-v" || arg == "--verbose") {
+            out.verbose = true;
+            continue;
+        }
+        if (arg == "--no-wait") {
+            out.profile.noWait = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: unknown option or missing value: " << arg << '\n';
+            return false;
+        }
+        const std::string_view value = argv[++i];
+        if (arg == "--mix") {
+            out.mix.assign(value);
+            continue;
+        }
+        if (arg == "--config") {
+            out.configFile.assign(value);
+            continue;
+        }
+        if (arg == "--exec") {
+            out.profile.clientBinary.assign(value);
+            continue;
+        }
+        if (arg == "--replay") {
+            out.replayFile.assign(value);
+            continue;
+        }
+        const std::optional<std::size_t> count = parseCount(value);
+        if (!count) {
+            std::cerr << "Error: " << arg << " expects a number, got '" << value << "'\n";
+            return false;
+        }
+        LoadProfile& profile = out.profile;
+        if (arg == "--clients") {
+            profile.clients = *count;
+        } else if (arg == "--depth") {
+            profile.depth = *count;
+        } else if (arg == "--requests") {
+            profile.requests = *count;
+        } else if (arg == "--burst") {
+            profile.burst = *count;
+        } else if (arg == "--pause") {
+            profile.pause = std::chrono::milliseconds(*count);
+        } else if (arg == "--reconnect-every") {
+            profile.reconnectEvery = *count;
+        } else if (arg == "--latency") {
+            out.commandLatencyMs = static_cast<uint32_t>(*count);
+        } else if (arg == "--nack") {
+            out.nackPercent = static_cast<uint32_t>(std::min<std::size_t>(*count, 100));
+        } else if (arg == "--seed") {
+            profile.seed = static_cast<uint32_t>(*count);
+        } else {
+            std::cerr << "Error: unknown option: " << arg << '\n';
+            return false;
+        }
+    }
+    if (out.profile.clients == 0 || out.profile.depth == 0) {
+        std::cerr << "Error: --clients and --depth must be at least 1\n";
+        return false;
+    }
+    if (out.profile.noWait && out.profile.clientBinary.empty()) {
+        std::cerr << "Error: --no-wait applies to --exec runs only\n";
+        return false;
+    }
+    return true;
+}
+
+/** The daemon's configuration: the file's, or defaults, on the simulated bus. */
+AppConfig benchConfig(const BenchOptions& options) {
+    AppConfig config;
+    if (!options.configFile.empty()) {
+        ConfigManager file(options.configFile);
+        if (!file.load()) {
+            LOG_WARNING("Failed to load ", options.configFile, ", using defaults");
+        }
+        config = loadAppConfig(file);
+    }
+    config.simulator.enabled = true;
+    if (options.commandLatencyMs) config.simulator.commandLatencyMs = *options.commandLatencyMs;
+    if (options.nackPercent) config.simulator.nackPercent = *options.nackPercent;
+    if (!options.replayFile.empty()) config.simulator.replayFile = options.replayFile;
+    // Nothing here should reach the host: no logind, no suspend.
+    config.daemon.enablePowerMonitor = false;
+    config.daemon.maxConnections = static_cast<uint32_t>(std::clamp<std::size_t>(
+        std::max<std::size_t>(config.daemon.maxConnections, options.profile.clients),
+        1, kMaxClientConnections));
+    return config;
+}
+
+int runBench(const BenchOptions& options) {
+    LogConfig logging;
+    logging.lowLevelSink  = LogSink::Stderr;
+    logging.highLevelSink = LogSink::Stderr;
+    logging.minLevel      = options.verbose ? LogLevel::DEBUG : LogLevel::WARNING;
+    Logger::getInstance().configure(logging);
+    const LogContextScope logContext(LogContext{LogSubsystem::Daemon});
+
+    std::string err;
+    std::optional<std::vector<WeightedCommand>> mix = parseCommandMix(options.mix, err);
+    if (!mix) {
+        std::cerr << "Error: " << err << '\n';
+        return EXIT_FAILURE;
+    }
+    LoadProfile profile = options.profile;
+    profile.mix = std::move(*mix);
+
+    // A private socket, so a daemon already running on this machine is
+    // neither disturbed nor measured.
+    char dir[] = "/tmp/cec-control-bench.XXXXXX";
+    if (::mkdtemp(dir) == nullptr) {
+        std::cerr << "Error: cannot create a socket directory\n";
+        return EXIT_FAILURE;
+    }
+    const std::string socketPath = std::string(dir) + "/cec-control.sock";
+    ::setenv("CEC_CONTROL_SOCKET", socketPath.c_str(), 1);
+
+    // --exec runs come from a process forked off here, before the
+    // daemon exists: the daemon reaps every child of its own process,
+    // and would take the runs' exit statuses. The runner waits on @c go
+    // for the socket, prints the report itself, and closing @c done on
+    // exit tells the driver below it has finished.
+    const bool spawned = !profile.clientBinary.empty();
+    int go[2]   = {-1, -1};
+    int done[2] = {-1, -1};
+    if (spawned) {
+        if (::pipe(go) != 0 || ::pipe(done) != 0) {
+            std::cerr << "Error: cannot create the runner's pipes\n";
+            return EXIT_FAILURE;
+        }
+        std::cout.flush();
+        const pid_t runner = ::fork();
+        if (runner < 0) {
+            std::cerr << "Error: cannot fork the client runner\n";
+            return EXIT_FAILURE;
+        }
+        if (runner == 0) {
+            ::close(go[1]);
+            ::close(done[0]);
+            char started = 0;
+            if (::read(go[0], &started, 1) != 1) ::_exit(EXIT_FAILURE);
+            printReport(runLoad(profile, socketPath), std::cout);
+            std::cout.flush();
+            ::_exit(EXIT_SUCCESS);
+        }
+        ::close(go[0]);
+        ::close(done[1]);
+    }
+
+    int status = EXIT_FAILURE;
+    {
+        // Constructed here, before any thread exists, so every thread
+        // started below inherits the daemon's blocked signal mask and
+        // the driver's SIGTERM lands on its signalfd.
+        CECDaemon daemon(benchConfig(options), options.configFile);
+        if (daemon.start()) {
+            LoadReport report;
+            std::thread driver([&] {
+                if (spawned) {
+                    char ignored = 0;
+                    (void)::write(go[1], "g", 1);
+                    while (::read(done[0], &ignored, 1) < 0 && errno == EINTR) {}
+                } else {
+                    report = runLoad(profile, socketPath);
+                }
+                ::kill(::getpid(), SIGTERM);
+            });
+            daemon.run();
+            daemon.stop();
+            driver.join();
+            if (!spawned) printReport(report, std::cout);
+            status = EXIT_SUCCESS;
+        } else {
+            std::cerr << "Error: the daemon failed to start\n";
+            daemon.stop();
+        }
+    }
+    if (spawned) {
+        // Closing @c go unblocks a runner the daemon never started.
+        ::close(go[1]);
+        ::close(done[0]);
+    }
+    ::unlink(socketPath.c_str());
+    ::rmdir(dir);
+    return status;
+}
+
+} // namespace
+
+} // namespace cec_control
+
+int main(int argc, char* argv[]) {
+    using namespace cec_control;
+
+    BenchOptions options;
+    bool help = false;
+    if (!parseOptions(argc, argv, options, help)) return EXIT_FAILURE;
+    if (help) {
+        printUsage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+    return runBench(options);
+}
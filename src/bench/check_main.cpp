@@ -0,0 +1,270 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../common/boot_clock.h"
+#include "../common/deadline.h"
+#include "../common/event_loop.h"
+#include "../common/logger.h"
+#include "../common/loop_timer.h"
+#include "../common/main_thread_work.h"
+#include "../common/messages.h"
+#include "../common/unix_socket.h"
+#include "../daemon/adapter_lifecycle.h"
+#include "../daemon/app_config.h"
+#include "../daemon/cec/adapter_worker.h"
+#include "../daemon/cec/simulated_adapter.h"
+#include "../daemon/command_dispatcher.h"
+#include "../daemon/device_state_cache.h"
+#include "../daemon/power/suspend_queue.h"
+#include "../daemon/socket_server.h"
+#include "../daemon/standby_policy.h"
+
+/**
+ * cec-control-check: checks of daemon logic that depends on things a
+ * running daemon cannot be made to do on demand, such as a night of
+ * suspend, or cannot show from outside, such as what the request path
+ * allocates. Each case drives the code directly, with time passed in
+ * rather than waited for, and prints one line —
+ *
+ *   ok   suspend_queue_expiry
+ *   FAIL suspend_queue_expiry: entry past its TTL was replayed
+ *
+ * Exits non-zero if any case failed.
+ */
+
+namespace {
+
+/** Heap allocations so far, by every thread; counted by the operator new below. */
+std::atomic<uint64_t> g_allocations{0};
+
+} // namespace
+
+// Counting replacements for the global allocation functions; the
+// aligned and nothrow forms are left as the library's.
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+// Kept out of line: inlined, GCC pairs the free with a new expression
+// at the call site and warns of a mismatch.
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace cec_control {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+/** Why a case failed; empty when it passed. */
+using Failure = std::string_view;
+
+struct Case {
+    std::string_view         name;
+    std::function<Failure()> body;
+};
+
+// -- SuspendQueue ------------------------------------------------------
+
+Failure suspendQueueExpiry() {
+    SuspendQueue queue;
+    queue.setLimits(SuspendQueue::Limits{0, 60s});
+    queue.enterSuspended();
+
+    // Queued before an overnight suspend, drained at wake.
+    const SuspendQueue::Clock::time_point asleep = SuspendQueue::Clock::now();
+    if (!queue.push(Message(MessageType::CMD_POWER_ON, 0), asleep)) return "push refused";
+    if (!queue.drain(asleep + 8h).empty()) return "entry past its TTL was replayed";
+
+    // Drained inside its TTL, it runs.
+    if (!queue.push(Message(MessageType::CMD_POWER_ON, 0), asleep)) return "push refused";
+    if (queue.drain(asleep + 59s).size() != 1) return "entry inside its TTL was dropped";
+    return {};
+}
+
+Failure suspendQueueClock() {
+    // The queue must age entries on the clock that counts the time
+    // asleep: CLOCK_BOOTTIME, not the steady clock, which stops.
+    if (!std::is_same_v<SuspendQueue::Clock, BootClock>) return "queue not on the boot clock";
+
+    // And BootClock must be that clock: a reading between two of
+    // CLOCK_BOOTTIME's own, on its epoch.
+    const auto boottime = [] {
+        timespec ts{};
+        ::clock_gettime(CLOCK_BOOTTIME, &ts);
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    };
+    const auto before = boottime();
+    const auto read   = BootClock::now().time_since_epoch();
+    const auto after  = boottime();
+    if (read < before || read > after) return "boot clock does not read CLOCK_BOOTTIME";
+    return {};
+}
+
+// -- Request path ------------------------------------------------------
+
+/**
+ * Send kRequests commands of @p type to a daemon's socket, one at a
+ * time, and count the heap allocations made, by any thread, while they
+ * are answered. The daemon side is the real request path: SocketServer
+ * framing and reply queue, CommandDispatcher and its throttled
+ * execution, AdapterWorker, on a simulated bus with no latency or
+ * pacing. Once the queues are warm, none of it may touch the heap.
+ */
+Failure requestPathAllocations(MessageType type) {
+    constexpr uint64_t kWarmup   = 64;
+    constexpr uint64_t kRequests = 10'000;
+
+    AppConfig config;
+    config.simulator.enabled          = true;
+    config.simulator.commandLatencyMs = 0;
+    config.simulator.queryLatencyMs   = 0;
+    config.throttler.baseIntervalMs   = 0;
+    config.throttler.minIntervalMs    = 0;
+    config.throttler.busIntervalMs    = 0;
+
+    auto adapter = std::make_unique<SimulatedCecAdapter>(config.adapter, config.simulator,
+                                                         ICecAdapter::Callbacks{});
+    if (!adapter->initialize() || !adapter->openConnection()) return "simulator did not open";
+    AdapterWorker worker(std::move(adapter), config.dispatcher.maxQueuedCommands);
+
+    MainThreadWork work;
+    EventLoop      loop;
+    LoopTimer      idleTimer{loop};
+    LoopTimer      keyRepeatTimer{loop};
+    AdapterLifecycle lifecycle(worker, work, PowerFanoutConfig{}, idleTimer,
+                               std::chrono::milliseconds(0));
+    DeviceStateCache stateCache(config.stateCache, worker, work);
+    StandbyPolicy    standbyPolicy(false, [] {});
+    CommandDispatcher dispatcher(config, worker, work, lifecycle, standbyPolicy,
+                                 stateCache, keyRepeatTimer);
+
+    const std::string socketPath =
+        "/tmp/cec-control-check-" + std::to_string(::getpid()) + ".sock";
+    SocketServer server(loop, socketPath);
+    server.setCommandHandler([&dispatcher](Message command, ResponseSink reply,
+                                           const RequestOptions& options) {
+        dispatcher.dispatch(std::move(command), std::move(reply), options);
+    });
+    if (!server.start()) return "socket server did not start";
+    if (!loop.add(work.fd(), static_cast<uint32_t>(EventPoller::Event::READ),
+                  [&work](uint32_t) { work.drain(); })) {
+        return "work queue not registered";
+    }
+    worker.start();
+
+    // The client runs beside the loop and writes into these only
+    // before it posts the loop's stop, so the join orders the reads.
+    Failure  failure;
+    uint64_t allocations = 0;
+    std::thread client([&] {
+        UnixSocket socket = UnixSocket::connect(socketPath, Deadline::in(1s));
+        if (!socket) {
+            failure = "could not connect";
+        } else {
+            uint64_t counted = 0;
+            for (uint64_t i = 0; i < kWarmup + kRequests; ++i) {
+                if (i == kWarmup) counted = g_allocations.load(std::memory_order_relaxed);
+
+                const auto requestId = static_cast<RequestId>(i + 1);
+                uint8_t frame[MAX_FRAME_SIZE];
+                const std::size_t len = serializeFrameTo(requestId, Message(type, 5),
+                                                         frame, sizeof(frame));
+                if (::send(socket.get(), frame, len, MSG_NOSIGNAL) !=
+                    static_cast<ssize_t>(len)) {
+                    failure = "send failed";
+                    break;
+                }
+                pollfd ready{socket.get(), POLLIN, 0};
+                if (::poll(&ready, 1, 1000) <= 0) {
+                    failure = "no reply within a second";
+                    break;
+                }
+                const ssize_t got = ::recv(socket.get(), frame, sizeof(frame), 0);
+                const auto reply = got > 0 ? deserializeFrame(frame, static_cast<std::size_t>(got))
+                                           : std::nullopt;
+                if (!reply || reply->requestId != requestId ||
+                    reply->message.type != MessageType::RESP_SUCCESS) {
+                    failure = "request not answered with success";
+                    break;
+                }
+            }
+            allocations = g_allocations.load(std::memory_order_relaxed) - counted;
+        }
+        work.post([&loop] { loop.stop(); });
+    });
+    loop.run();
+    client.join();
+
+    server.stop();
+    dispatcher.shutdown();
+    lifecycle.shutdown();
+    worker.stop();
+    loop.remove(work.fd());
+    ::unlink(socketPath.c_str());
+
+    if (!failure.empty()) return failure;
+    if (allocations != 0) {
+        std::cout << "     " << allocations << " allocations over " << kRequests
+                  << " requests\n";
+        return "request path allocated";
+    }
+    return {};
+}
+
+std::vector<Case> cases() {
+    return {
+        {"suspend_queue_expiry", suspendQueueExpiry},
+        {"suspend_queue_clock", suspendQueueClock},
+        // A plain adapter call, and one that goes through coalescing.
+        {"request_path_allocations", [] { return requestPathAllocations(MessageType::CMD_POWER_ON); }},
+        {"coalesced_path_allocations", [] { return requestPathAllocations(MessageType::CMD_VOLUME_UP); }},
+    };
+}
+
+} // namespace
+
+} // namespace cec_control
+
+int main(int argc, char* argv[]) {
+    using namespace cec_control;
+
+    // Optional filter: run only the cases whose name contains it.
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+    if (filter == "-h" || filter == "--help") {
+        std::cout << "Usage: " << argv[0] << " [NAME_SUBSTRING]\n";
+        return EXIT_SUCCESS;
+    }
+    // The code under check logs what it drops; keep that off the report.
+    Logger::getInstance().configure(LogConfig{});
+
+    bool failed = false;
+    for (const Case& c : cases()) {
+        if (!filter.empty() && c.name.find(filter) == std::string_view::npos) continue;
+        const Failure failure = c.body();
+        if (failure.empty()) {
+            std::cout << "ok   " << c.name << "\n";
+        } else {
+            std::cout << "FAIL " << c.name << ": " << failure << "\n";
+            failed = true;
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,386 @@
+#include "load_generator.h"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <variant>
+
+#include "../client/async_client.h"
+#include "../common/command_registry.h"
+#include "../daemon/metrics.h"
+
+namespace cec_control {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::vector<std::string_view> splitWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    while (true) {
+        text = trim(text);
+        if (text.empty()) return words;
+        std::size_t end = 0;
+        while (end < text.size() && !std::isspace(static_cast<unsigned char>(text[end]))) ++end;
+        words.push_back(text.substr(0, end));
+        text.remove_prefix(end);
+    }
+}
+
+/** Fold one reply (or the failure to get one) into @p results. */
+void record(TypeResults& results, const AsyncClient::Result& result,
+            Clock::duration elapsed) {
+    const auto* reply = std::get_if<Message>(&result);
+    if (reply == nullptr) {
+        ++results.failed;
+        return;
+    }
+    results.latenciesUs.push_back(static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    switch (reply->type) {
+        case MessageType::RESP_SUCCESS:   ++results.success;  break;
+        case MessageType::RESP_BUSY:      ++results.busy;     break;
+        case MessageType::RESP_NOT_READY: ++results.notReady; break;
+        default:                          ++results.error;    break;
+    }
+}
+
+void merge(TypeResults& into, TypeResults& from) {
+    into.latenciesUs.insert(into.latenciesUs.end(), from.latenciesUs.begin(),
+                            from.latenciesUs.end());
+    into.success  += from.success;
+    into.error    += from.error;
+    into.busy     += from.busy;
+    into.notReady += from.notReady;
+    into.failed   += from.failed;
+}
+
+/**
+ * One client thread: a connection, its in-flight window, and the
+ * results its replies have produced. Replies land on the
+ * @c AsyncClient reader thread, hence the lock.
+ */
+class LoadClient {
+public:
+    LoadClient(const LoadProfile& profile, const std::string& socketPath,
+               std::size_t quota, uint32_t seed)
+        : m_profile(profile), m_quota(quota), m_rng(seed), m_client(socketPath) {}
+
+    /** Send the whole quota and wait for the last reply. */
+    void run() {
+        std::vector<double> weights;
+        for (const auto& entry : m_profile.mix) weights.push_back(entry.weight);
+        std::discrete_distribution<std::size_t> pick(weights.begin(), weights.end());
+
+        const std::size_t burst = m_profile.burst > 0 ? m_profile.burst : m_quota;
+        std::size_t sent = 0;
+        std::size_t onConnection = 0;
+        while (sent < m_quota) {
+            for (std::size_t inBurst = 0; inBurst < burst && sent < m_quota; ++inBurst) {
+                if (m_profile.reconnectEvery > 0 && onConnection == m_profile.reconnectEvery) {
+                    waitFor(0);
+                    m_client.close();
+                    onConnection = 0;
+                    ++m_connections;
+                }
+                waitFor(m_profile.depth - 1);
+                send(m_profile.mix[pick(m_rng)].command);
+                ++sent;
+                ++onConnection;
+            }
+            if (m_profile.burst > 0) {
+                waitFor(0);
+                std::this_thread::sleep_for(m_profile.pause);
+            }
+        }
+        waitFor(0);
+        m_client.close();
+    }
+
+    [[nodiscard]] std::size_t connections() const noexcept { return m_connections; }
+
+    /** Results so far; call once @c run has returned. */
+    [[nodiscard]] std::map<MessageType, TypeResults>& results() noexcept { return m_results; }
+
+private:
+    void send(const Message& command) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_inFlight;
+        }
+        // Not under the lock: a failed send calls back on this thread.
+        const MessageType type = command.type;
+        const Clock::time_point start = Clock::now();
+        m_client.send(command, [this, type, start](AsyncClient::Result result) {
+            const Clock::duration elapsed = Clock::now() - start;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            record(m_results[type], result, elapsed);
+            --m_inFlight;
+            m_drained.notify_one();
+        });
+    }
+
+    /** Block until no more than @p limit requests are outstanding. */
+    void waitFor(std::size_t limit) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_drained.wait(lock, [&] { return m_inFlight <= limit; });
+    }
+
+    const LoadProfile& m_profile;
+    const std::size_t  m_quota;
+    std::mt19937       m_rng;
+    std::size_t        m_connections = 1;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_drained;
+    std::size_t             m_inFlight = 0;
+    std::map<MessageType, TypeResults> m_results;
+
+    // Last, so it is destroyed first: its destructor joins the reader
+    // thread, which may still be leaving a callback that holds m_mutex.
+    AsyncClient m_client;
+};
+
+/**
+ * One client thread that runs the client executable once per request,
+ * each with its output discarded and the exit status as the outcome:
+ * 0 is success, @c EX_TEMPFAIL busy (the CLI does not tell busy from
+ * not ready), anything else an error, and a run that could not start
+ * or was killed a failure.
+ *
+ * Not for a process hosting the daemon: its SIGCHLD handler reaps
+ * every child, and would take the exit statuses first.
+ */
+class SpawnClient {
+public:
+    SpawnClient(const LoadProfile& profile, std::size_t quota, uint32_t seed)
+        : m_profile(profile), m_quota(quota), m_rng(seed) {}
+
+    void run() {
+        std::vector<double> weights;
+        for (const auto& entry : m_profile.mix) weights.push_back(entry.weight);
+        std::discrete_distribution<std::size_t> pick(weights.begin(), weights.end());
+
+        for (std::size_t sent = 0; sent < m_quota; ++sent) {
+            if (m_profile.burst > 0 && sent > 0 && sent % m_profile.burst == 0) {
+                std::this_thread::sleep_for(m_profile.pause);
+            }
+            spawn(m_profile.mix[pick(m_rng)]);
+        }
+    }
+
+    [[nodiscard]] std::size_t connections() const noexcept { return m_quota; }
+    [[nodiscard]] std::map<MessageType, TypeResults>& results() noexcept { return m_results; }
+
+private:
+    void spawn(const WeightedCommand& entry) {
+        TypeResults& results = m_results[entry.command.type];
+
+        std::vector<std::string> args{m_profile.clientBinary};
+        for (const std::string_view word : splitWords(entry.text)) args.emplace_back(word);
+        if (m_profile.noWait) args.emplace_back("--no-wait");
+        std::vector<char*> argv;
+        for (auto& arg : args) argv.push_back(arg.data());
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        ::posix_spawn_file_actions_init(&actions);
+        ::posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        ::posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+        const Clock::time_point start = Clock::now();
+        pid_t pid = -1;
+        const int rc = ::posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        ::posix_spawn_file_actions_destroy(&actions);
+        int status = 0;
+        if (rc != 0 || ::waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+            ++results.failed;
+            return;
+        }
+        results.latenciesUs.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start)
+                .count()));
+        switch (WEXITSTATUS(status)) {
+            case EXIT_SUCCESS: ++results.success; break;
+            case EX_TEMPFAIL:  ++results.busy;    break;
+            default:           ++results.error;   break;
+        }
+    }
+
+    const LoadProfile& m_profile;
+    const std::size_t  m_quota;
+    std::mt19937       m_rng;
+    std::map<MessageType, TypeResults> m_results;
+};
+
+/** Run @p clients on a thread each and fold what they produced into one report. */
+template <typename Client>
+LoadReport runClients(std::vector<std::unique_ptr<Client>>& clients) {
+    const Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    for (auto& client : clients) {
+        threads.emplace_back([&client] { client->run(); });
+    }
+    for (auto& thread : threads) thread.join();
+
+    LoadReport report;
+    report.wallTime = Clock::now() - start;
+    for (auto& client : clients) {
+        report.connections += client->connections();
+        for (auto& [type, results] : client->results()) merge(report.byType[type], results);
+    }
+    return report;
+}
+
+/** Nearest-rank percentile of sorted @p samples; 0 when empty. */
+uint32_t percentile(const std::vector<uint32_t>& samples, double p) {
+    if (samples.empty()) return 0;
+    const auto rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(samples.size())));
+    return samples[std::clamp<std::size_t>(rank, 1, samples.size()) - 1];
+}
+
+void printRow(std::ostream& out, std::string_view label, TypeResults& results) {
+    std::sort(results.latenciesUs.begin(), results.latenciesUs.end());
+    const uint64_t count = results.latenciesUs.size() + results.failed;
+    out << std::left << std::setw(14) << label << std::right
+        << std::setw(9) << count
+        << std::setw(9) << results.success
+        << std::setw(7) << results.error
+        << std::setw(7) << results.busy
+        << std::setw(7) << results.notReady
+        << std::setw(7) << results.failed
+        << std::setw(10) << percentile(results.latenciesUs, 0.50)
+        << std::setw(10) << percentile(results.latenciesUs, 0.99)
+        << std::setw(10) << percentile(results.latenciesUs, 0.999)
+        << std::setw(10) << (results.latenciesUs.empty() ? 0 : results.latenciesUs.back())
+        << '\n';
+}
+
+} // namespace
+
+std::optional<std::vector<WeightedCommand>> parseCommandMix(std::string_view spec,
+                                                            std::string& err) {
+    std::vector<WeightedCommand> mix;
+    while (!spec.empty()) {
+        const std::size_t end = std::min(spec.find(';'), spec.size());
+        std::string_view entry = trim(spec.substr(0, end));
+        spec.remove_prefix(std::min(end + 1, spec.size()));
+        if (entry.empty()) continue;
+
+        uint32_t weight = 1;
+        if (const std::size_t colon = entry.find(':'); colon != std::string_view::npos) {
+            const std::string_view digits = trim(entry.substr(0, colon));
+            if (digits.empty() || digits.size() > 6 ||
+                !std::all_of(digits.begin(), digits.end(),
+                             [](unsigned char c) { return std::isdigit(c) != 0; })) {
+                err = "invalid weight in mix entry '" + std::string(entry) + "'";
+                return std::nullopt;
+            }
+            weight = static_cast<uint32_t>(std::stoul(std::string(digits)));
+            entry  = trim(entry.substr(colon + 1));
+        }
+        if (weight == 0) continue;
+
+        std::vector<std::string_view> words = splitWords(entry);
+        const CommandSpec* command = words.empty() ? nullptr : findByName(words.front());
+        if (command == nullptr) {
+            err = "unknown command in mix entry '" + std::string(entry) + "'";
+            return std::nullopt;
+        }
+        if (command->type == MessageType::CMD_SUBSCRIBE) {
+            err = "subscribe cannot be part of a mix";
+            return std::nullopt;
+        }
+        words.erase(words.begin());
+        std::string parseErr;
+        std::optional<Message> message = command->parse(words, parseErr);
+        if (!message) {
+            err = "mix entry '" + std::string(entry) + "': " + parseErr;
+            return std::nullopt;
+        }
+        mix.push_back(WeightedCommand{std::string(entry), std::move(*message), weight});
+    }
+    if (mix.empty()) {
+        err = "the command mix is empty";
+        return std::nullopt;
+    }
+    return mix;
+}
+
+LoadReport runLoad(const LoadProfile& profile, const std::string& socketPath) {
+    const uint32_t seed = profile.seed != 0 ? profile.seed : std::random_device{}();
+    // Spread the remainder so the quotas add up to the total.
+    const auto quotaOf = [&profile](std::size_t i) {
+        return profile.requests / profile.clients +
+               (i < profile.requests % profile.clients ? 1 : 0);
+    };
+
+    if (!profile.clientBinary.empty()) {
+        // The runs find the daemon through CEC_CONTROL_SOCKET.
+        std::vector<std::unique_ptr<SpawnClient>> clients;
+        for (std::size_t i = 0; i < profile.clients; ++i) {
+            clients.push_back(std::make_unique<SpawnClient>(
+                profile, quotaOf(i), seed + static_cast<uint32_t>(i)));
+        }
+        LoadReport report = runClients(clients);
+        report.spawned = true;
+        return report;
+    }
+
+    std::vector<std::unique_ptr<LoadClient>> clients;
+    for (std::size_t i = 0; i < profile.clients; ++i) {
+        clients.push_back(std::make_unique<LoadClient>(
+            profile, socketPath, quotaOf(i), seed + static_cast<uint32_t>(i)));
+    }
+    return runClients(clients);
+}
+
+void printReport(const LoadReport& report, std::ostream& out) {
+    TypeResults all;
+    for (auto [type, results] : report.byType) merge(all, results);
+
+    const double seconds = std::chrono::duration<double>(report.wallTime).count();
+    const uint64_t answered = all.latenciesUs.size();
+    const double rate = seconds > 0 ? static_cast<double>(answered) / seconds : 0.0;
+    out << std::fixed << std::setprecision(2);
+    if (report.spawned) {
+        out << answered << " client runs in " << seconds << " s: " << rate
+            << " runs/s; latency is startup to exit\n\n";
+    } else {
+        out << answered << " replies in " << seconds << " s over "
+            << report.connections << " connection(s): " << rate << " req/s\n\n";
+    }
+
+    out << std::left << std::setw(14) << "type" << std::right
+        << std::setw(9) << "count" << std::setw(9) << "ok" << std::setw(7) << "error"
+        << std::setw(7) << "busy" << std::setw(7) << "!ready" << std::setw(7) << "failed"
+        << std::setw(10) << "p50_us" << std::setw(10) << "p99_us"
+        << std::setw(10) << "p999_us" << std::setw(10) << "max_us" << '\n';
+    for (auto [type, results] : report.byType) printRow(out, dispatchLabel(type), results);
+    printRow(out, "all", all);
+}
+
+} // namespace cec_control
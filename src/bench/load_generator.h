@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/messages.h"
+
+namespace cec_control {
+
+/** One entry of a benchmark's command mix. */
+struct WeightedCommand {
+    std::string text;     ///< As typed on the command line, e.g. "volume up 5".
+    Message     command;
+    uint32_t    weight = 1;
+};
+
+/**
+ * Parse a command mix: `;`-separated entries in client command syntax,
+ * each optionally prefixed with `WEIGHT:` (e.g. "4:status 0;volume up 5").
+ * Returns nullopt with @p err set on the first entry that does not
+ * parse or that would hold the session open (@c subscribe).
+ */
+std::optional<std::vector<WeightedCommand>> parseCommandMix(std::string_view spec,
+                                                            std::string& err);
+
+/**
+ * Shape of the load one benchmark run applies. Each of @c clients
+ * threads owns one connection and keeps up to @c depth requests in
+ * flight on it; together they send @c requests in all.
+ */
+struct LoadProfile {
+    std::size_t clients = 4;
+    std::size_t depth   = 1;
+    std::size_t requests = 20000;
+    /**
+     * Send requests in bursts of this many, waiting for each burst to
+     * be answered and then @c pause before the next; 0 keeps the
+     * window full throughout.
+     */
+    std::size_t               burst = 0;
+    std::chrono::milliseconds pause{0};
+    /** Reconnect after this many requests on a connection; 0 = never. */
+    std::size_t               reconnectEvery = 0;
+    std::vector<WeightedCommand> mix;
+    uint32_t                  seed = 0;  ///< 0 = different every run.
+    /**
+     * Client executable to run once per request instead of sending it
+     * over a held connection, so the latency is a whole invocation's,
+     * process startup to exit. Empty = in-process connections. @c depth
+     * and @c reconnectEvery do not apply: each run is one connection.
+     */
+    std::string               clientBinary;
+    /** Pass `--no-wait` to each run of @c clientBinary. */
+    bool                      noWait = false;
+};
+
+/** Outcomes and round-trip times for requests of one @c MessageType. */
+struct TypeResults {
+    std::vector<uint32_t> latenciesUs;  ///< Every completed request, in µs.
+    uint64_t success  = 0;
+    uint64_t error    = 0;              ///< RESP_ERROR or an unexpected reply.
+    uint64_t busy     = 0;
+    uint64_t notReady = 0;
+    uint64_t failed   = 0;              ///< Transport failure; no reply.
+};
+
+/** What one @c runLoad produced. */
+struct LoadReport {
+    std::chrono::steady_clock::duration wallTime{};
+    std::size_t                         connections = 0;
+    bool                                spawned = false;  ///< Client runs, not replies.
+    std::map<MessageType, TypeResults>  byType;
+};
+
+/**
+ * Drive the daemon listening on @p socketPath with @p profile and
+ * return the results once every request has been answered. Blocks the
+ * calling thread; the clients run on their own. With
+ * @c LoadProfile::clientBinary set, the runs' exit statuses are lost to
+ * a daemon in the same process, so call it from another.
+ */
+LoadReport runLoad(const LoadProfile& profile, const std::string& socketPath);
+
+/**
+ * Write @p report as a table: throughput, then per type the request
+ * count, outcome counts and p50/p99/p999/max latency.
+ */
+void printReport(const LoadReport& report, std::ostream& out);
+
+} // namespace cec_control
@@ -0,0 +1,282 @@
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../common/command_registry.h"
+#include "../common/event_loop.h"
+#include "../common/event_poller.h"
+#include "../common/logger.h"
+#include "../common/main_thread_work.h"
+#include "../common/messages.h"
+#include "../daemon/command_dispatch.h"
+#include "../daemon/command_throttler.h"
+
+/**
+ * cec-control-microbench: fixed-iteration timings of the primitives on
+ * the request path. Each case runs a set number of operations and
+ * prints one JSON object per line —
+ *
+ *   {"name":"message_serialize","threads":1,"iterations":2000000,"total_ns":...,"ns_per_op":...}
+ *
+ * so a run can be saved as a baseline and compared with a later one.
+ * Iteration counts never depend on the machine, which keeps runs of
+ * different builds comparable op for op.
+ */
+
+namespace cec_control {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** Keep @p value alive as far as the optimiser can tell. */
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Case {
+    std::string_view name;
+    std::size_t      threads;
+    uint64_t         iterations;
+    /** Runs the whole case and returns its elapsed wall time. */
+    std::function<Clock::duration(uint64_t iterations)> body;
+};
+
+/** Time @p fn over @p iterations calls on the calling thread. */
+template <typename Fn>
+Clock::duration timeLoop(uint64_t iterations, Fn&& fn) {
+    const Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) fn(i);
+    return Clock::now() - start;
+}
+
+// -- Message -----------------------------------------------------------
+
+Clock::duration serializeInto(uint64_t iterations) {
+    const Message message(MessageType::CMD_VOLUME_SET, 5, {30});
+    uint8_t buffer[MAX_FRAME_SIZE];
+    return timeLoop(iterations, [&](uint64_t) {
+        keep(message.serializeTo(buffer, sizeof(buffer)));
+        keep(buffer[0]);
+    });
+}
+
+Clock::duration serializeVector(uint64_t iterations) {
+    const Message message(MessageType::CMD_VOLUME_SET, 5, {30});
+    return timeLoop(iterations, [&](uint64_t) { keep(message.serialize().size()); });
+}
+
+Clock::duration deserialize(uint64_t iterations) {
+    const std::vector<uint8_t> wire = Message(MessageType::CMD_VOLUME_SET, 5, {30}).serialize();
+    return timeLoop(iterations, [&](uint64_t) {
+        keep(Message::deserialize(wire.data(), wire.size())->deviceId);
+    });
+}
+
+// -- MainThreadWork ----------------------------------------------------
+
+/**
+ * @p producers threads post @p iterations closures between them while
+ * this thread waits on the wake fd and drains, as the daemon loop does.
+ */
+Clock::duration postAndDrain(std::size_t producers, uint64_t iterations) {
+    MainThreadWork work;
+    uint64_t ran = 0;
+    const uint64_t perProducer = iterations / producers;
+    const uint64_t total       = perProducer * producers;
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) {}
+            for (uint64_t i = 0; i < perProducer; ++i) work.post([&ran] { ++ran; });
+        });
+    }
+
+    const Clock::time_point start = Clock::now();
+    go.store(true, std::memory_order_release);
+    pollfd wake{work.fd(), POLLIN, 0};
+    while (ran < total) {
+        ::poll(&wake, 1, 100);
+        work.drain();
+    }
+    const Clock::duration elapsed = Clock::now() - start;
+    for (auto& thread : threads) thread.join();
+    return elapsed;
+}
+
+// -- CommandThrottler --------------------------------------------------
+
+/**
+ * @p threads callers reserving slots across all sixteen lanes. The
+ * throttler hands out instants and never sleeps, so this is the CAS
+ * traffic alone; nothing waits for the slots it returns.
+ */
+Clock::duration reserveSlots(std::size_t threads, uint64_t iterations) {
+    CommandThrottler throttler{ThrottlerConfig{}};
+    const uint64_t perThread = iterations / threads;
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> callers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        callers.emplace_back([&, t] {
+            while (!go.load(std::memory_order_acquire)) {}
+            for (uint64_t i = 0; i < perThread; ++i) {
+                keep(throttler.reserveSlot(static_cast<uint8_t>((t + i) % 16)));
+            }
+        });
+    }
+    const Clock::time_point start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& caller : callers) caller.join();
+    return Clock::now() - start;
+}
+
+// -- EventLoop ---------------------------------------------------------
+
+/**
+ * One eventfd that its own handler re-arms: every pass of the loop is
+ * a wait, one dispatch, a read and a write.
+ */
+Clock::duration loopDispatch(uint64_t iterations) {
+    EventLoop loop;
+    const int fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) return {};
+    uint64_t handled = 0;
+    const bool added = loop.add(fd, static_cast<uint32_t>(EventPoller::Event::READ),
+                                [&](uint32_t) {
+        uint64_t value = 0;
+        keep(::read(fd, &value, sizeof(value)));
+        if (++handled == iterations) {
+            loop.stop();
+            return;
+        }
+        value = 1;
+        keep(::write(fd, &value, sizeof(value)));
+    });
+    if (!added) {
+        ::close(fd);
+        return {};
+    }
+    const Clock::time_point start = Clock::now();
+    loop.run();
+    const Clock::duration elapsed = Clock::now() - start;
+    loop.remove(fd);
+    ::close(fd);
+    return elapsed;
+}
+
+// -- Registry lookups --------------------------------------------------
+
+Clock::duration lookupByName(uint64_t iterations) {
+    return timeLoop(iterations, [](uint64_t i) {
+        keep(findByName(kCommands[i % kCommands.size()].name));
+    });
+}
+
+Clock::duration lookupByType(uint64_t iterations) {
+    return timeLoop(iterations, [](uint64_t i) {
+        keep(findByType(kCommands[i % kCommands.size()].type));
+    });
+}
+
+Clock::duration lookupDispatch(uint64_t iterations) {
+    return timeLoop(iterations, [](uint64_t i) {
+        keep(findDispatchByType(kCommands[i % kCommands.size()].type));
+    });
+}
+
+// -- Logger ------------------------------------------------------------
+
+/** Log at @p level into a /dev/null file sink that passes INFO and up. */
+Clock::duration logAt(LogLevel level, uint64_t iterations) {
+    LogConfig cfg;
+    cfg.filePath = "/dev/null";
+    cfg.minLevel = LogLevel::INFO;
+    Logger::getInstance().configure(cfg);
+    const Clock::duration elapsed = timeLoop(iterations, [level](uint64_t i) {
+        switch (level) {
+            case LogLevel::DEBUG:
+                LOG_DEBUG("Sending command to device ", 5, " attempt ", i);
+                break;
+            case LogLevel::INFO:
+                LOG_INFO("Sending command to device ", 5, " attempt ", i);
+                break;
+            default:
+                LOG_WARNING("Sending command to device ", 5, " attempt ", i);
+                break;
+        }
+    });
+    Logger::getInstance().configure(LogConfig{});
+    return elapsed;
+}
+
+std::vector<Case> cases() {
+    std::vector<Case> all = {
+        {"message_serialize_into", 1, 5'000'000, serializeInto},
+        {"message_serialize", 1, 2'000'000, serializeVector},
+        {"message_deserialize", 1, 5'000'000, deserialize},
+        {"main_thread_work_post_drain", 1, 1'000'000,
+         [](uint64_t n) { return postAndDrain(1, n); }},
+        {"main_thread_work_post_drain", 4, 1'000'000,
+         [](uint64_t n) { return postAndDrain(4, n); }},
+        {"throttler_reserve_slot", 1, 2'000'000,
+         [](uint64_t n) { return reserveSlots(1, n); }},
+        {"throttler_reserve_slot", 4, 2'000'000,
+         [](uint64_t n) { return reserveSlots(4, n); }},
+        {"event_loop_dispatch", 1, 200'000, loopDispatch},
+        {"registry_find_by_name", 1, 5'000'000, lookupByName},
+        {"registry_find_by_type", 1, 5'000'000, lookupByType},
+        {"registry_find_dispatch_by_type", 1, 5'000'000, lookupDispatch},
+        // DEBUG is below the configured level: the cost of a filtered call.
+        {"logger_debug_filtered", 1, 5'000'000,
+         [](uint64_t n) { return logAt(LogLevel::DEBUG, n); }},
+        {"logger_info", 1, 500'000, [](uint64_t n) { return logAt(LogLevel::INFO, n); }},
+        {"logger_warning", 1, 500'000,
+         [](uint64_t n) { return logAt(LogLevel::WARNING, n); }},
+    };
+    return all;
+}
+
+void report(const Case& c, Clock::duration elapsed) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    std::cout << "{\"name\":\"" << c.name << "\",\"threads\":" << c.threads
+              << ",\"iterations\":" << c.iterations << ",\"total_ns\":" << ns
+              << ",\"ns_per_op\":"
+              << static_cast<double>(ns) / static_cast<double>(c.iterations) << "}\n";
+}
+
+} // namespace
+
+} // namespace cec_control
+
+int main(int argc, char* argv[]) {
+    using namespace cec_control;
+
+    // Optional filter: run only the cases whose name contains it.
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+    if (filter == "-h" || filter == "--help") {
+        std::cout << "Usage: " << argv[0] << " [NAME_SUBSTRING]\n";
+        return EXIT_SUCCESS;
+    }
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(2);
+    for (const Case& c : cases()) {
+        if (!filter.empty() && c.name.find(filter) == std::string_view::npos) continue;
+        report(c, c.body(c.iterations));
+    }
+    return EXIT_SUCCESS;
+}
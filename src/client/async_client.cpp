@@ -0,0 +1,285 @@
+#include "async_client.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <cerrno>
+#include <utility>
+#include <vector>
+
+#include "../common/system_paths.h"
+
+namespace cec_control {
+
+namespace {
+
+/** Reader poll timeout; bounds how late a response timeout fires. */
+constexpr int kPollIntervalMs = 200;
+
+constexpr auto kConnectTimeout = std::chrono::seconds(2);
+
+/** Request id of the hello; ordinary requests start at 1. */
+constexpr RequestId kHelloRequestId = 0;
+
+} // namespace
+
+AsyncClient::AsyncClient(std::string socketPath)
+    : m_socketPath(socketPath.empty() ? SystemPaths::getSocketPath()
+                                      : std::move(socketPath)) {}
+
+AsyncClient::~AsyncClient() {
+    close();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_connected.notify_all();
+    if (m_reader.joinable()) m_reader.join();
+}
+
+std::optional<ClientError> AsyncClient::connect() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return connectLocked();
+}
+
+std::optional<ClientError> AsyncClient::connectLocked() {
+    if (m_socket) return std::nullopt;
+
+    const auto open = [this](UnixSocket& socket) -> std::optional<ClientError> {
+        socket = UnixSocket::connect(m_socketPath, Deadline::in(kConnectTimeout));
+        if (!socket.valid()) {
+            const int err = errno;
+            return ClientError{classifyConnectErrno(err), err, m_socketPath};
+        }
+        // Bounds a send into a daemon that has stopped reading, and the
+        // wait for the hello's reply. Later receives are polled, so the
+        // receive timeout matters only then.
+        if (!socket.setIoTimeout(kResponseTimeout)) {
+            const int err = errno;
+            return ClientError{ClientErrorKind::ConnectFailed, err,
+                               "could not set I/O timeout on socket"};
+        }
+        return std::nullopt;
+    };
+
+    UnixSocket socket;
+    if (auto failure = open(socket)) return failure;
+    const std::optional<uint8_t> agreed = negotiate(socket);
+    if (!agreed) {
+        // Dropped on the hello: a daemon from before framing versions.
+        if (auto failure = open(socket)) return failure;
+    }
+
+    m_socket   = std::make_shared<UnixSocket>(std::move(socket));
+    m_protocol = agreed.value_or(kProtocolLegacy);
+    if (!m_reader.joinable()) {
+        m_reader = std::thread([this]() { readLoop(); });
+    }
+    m_connected.notify_all();
+    return std::nullopt;
+}
+
+std::optional<uint8_t> AsyncClient::negotiate(const UnixSocket& socket) {
+    const auto hello = serializeFrame(kHelloRequestId,
+                                      Message(MessageType::CMD_HELLO, 0, {kProtocolVersion}));
+    if (::send(socket.get(), hello.data(), hello.size(), MSG_NOSIGNAL) !=
+        static_cast<ssize_t>(hello.size())) {
+        return std::nullopt;
+    }
+    std::array<uint8_t, MAX_FRAME_SIZE> buffer;
+    ssize_t received = 0;
+    do {
+        received = ::recv(socket.get(), buffer.data(), buffer.size(), 0);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) return std::nullopt;
+
+    const auto reply = deserializeFrame(buffer.data(), static_cast<std::size_t>(received));
+    if (!reply || reply->requestId != kHelloRequestId ||
+        reply->message.type != MessageType::RESP_SUCCESS || reply->message.data.size() != 1) {
+        return std::nullopt;
+    }
+    const uint8_t agreed = reply->message.data[0];
+    if (agreed < kProtocolLegacy || agreed > kProtocolVersion) return std::nullopt;
+    return agreed;
+}
+
+void AsyncClient::close() {
+    PendingMap pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pending = disconnectLocked();
+    }
+    failAll(std::move(pending), ClientError{ClientErrorKind::NotConnected, 0, "closed"});
+}
+
+bool AsyncClient::isConnected() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_socket != nullptr;
+}
+
+uint8_t AsyncClient::protocol() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_socket ? m_protocol : kProtocolLegacy;
+}
+
+void AsyncClient::send(const Message& command, Callback done) {
+    send(command, RequestOptions{}, std::move(done));
+}
+
+void AsyncClient::send(const Message& command, const RequestOptions& options, Callback done) {
+    std::optional<ClientError> failure;
+    PendingMap orphaned;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        failure = connectLocked();
+        if (!failure) {
+            // Tags wrap at 16 bits; skip any still awaiting a reply.
+            RequestId requestId = m_nextRequestId++;
+            while (m_pending.count(requestId) != 0) requestId = m_nextRequestId++;
+
+            const auto frame = serializeFrame(m_protocol, requestId, options, command);
+            const ssize_t sent = ::send(m_socket->get(), frame.data(), frame.size(),
+                                        MSG_NOSIGNAL);
+            // On a legacy connection the flag never left, so the daemon
+            // replies as usual.
+            const bool awaitReply = !options.noReply || m_protocol == kProtocolLegacy;
+            if (sent == static_cast<ssize_t>(frame.size()) && awaitReply) {
+                m_pending.emplace(requestId,
+                                  Pending{std::move(done), Clock::now() + kResponseTimeout});
+                return;
+            }
+            if (sent == static_cast<ssize_t>(frame.size())) {
+                failure.reset();
+            } else {
+                // SEQPACKET sends are all-or-nothing; anything else means
+                // the connection is unusable for every request on it.
+                failure  = ClientError{ClientErrorKind::SendFailed, sent < 0 ? errno : 0, ""};
+                orphaned = disconnectLocked();
+            }
+        }
+    }
+    failAll(std::move(orphaned), ClientError{ClientErrorKind::PeerClosed, 0, ""});
+    if (!done) return;
+    if (failure) {
+        done(std::move(*failure));
+    } else {
+        done(Message(MessageType::RESP_SUCCESS));
+    }
+}
+
+std::future<AsyncClient::Result> AsyncClient::send(const Message& command) {
+    return send(command, RequestOptions{});
+}
+
+std::future<AsyncClient::Result> AsyncClient::send(const Message& command,
+                                                   const RequestOptions& options) {
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+    send(command, options, [promise](Result result) { promise->set_value(std::move(result)); });
+    return future;
+}
+
+void AsyncClient::readLoop() {
+    while (true) {
+        std::shared_ptr<UnixSocket> socket;
+        uint8_t protocol = kProtocolLegacy;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_connected.wait(lock, [this]() { return m_stopping || m_socket; });
+            if (m_stopping) return;
+            socket   = m_socket;
+            protocol = m_protocol;
+        }
+
+        pollfd pfd{socket->get(), POLLIN, 0};
+        const int ready = ::poll(&pfd, 1, kPollIntervalMs);
+        if (ready > 0) receiveFrom(socket, protocol);
+        expireOverdue();
+    }
+}
+
+void AsyncClient::receiveFrom(const std::shared_ptr<UnixSocket>& socket, uint8_t protocol) {
+    std::array<uint8_t, MAX_FRAME_SIZE> buffer;
+    ssize_t received = 0;
+    do {
+        received = ::recv(socket->get(), buffer.data(), buffer.size(),
+                          MSG_DONTWAIT | MSG_TRUNC);
+    } while (received < 0 && errno == EINTR);
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+    std::optional<ClientError> failure;
+    if (received == 0) {
+        failure = ClientError{ClientErrorKind::PeerClosed, 0, ""};
+    } else if (received < 0) {
+        failure = ClientError{ClientErrorKind::ReceiveFailed, errno, ""};
+    } else if (static_cast<std::size_t>(received) > buffer.size()) {
+        failure = ClientError{ClientErrorKind::OversizedResponse, 0,
+                              std::to_string(received) + " bytes"};
+    }
+
+    std::optional<Frame> frame;
+    if (!failure) {
+        frame = deserializeFrame(protocol, buffer.data(), static_cast<std::size_t>(received));
+        if (!frame) failure = ClientError{ClientErrorKind::MalformedResponse, 0, ""};
+    }
+
+    if (failure) {
+        // Every request on this connection is lost with it. A socket we
+        // no longer hold was closed on purpose; its waiters are answered.
+        PendingMap pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_socket == socket) pending = disconnectLocked();
+        }
+        failAll(std::move(pending), *failure);
+        return;
+    }
+
+    Callback done;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(frame->requestId);
+        if (it == m_pending.end()) return;  // Already timed out.
+        done = std::move(it->second.done);
+        m_pending.erase(it);
+    }
+    if (done) done(std::move(frame->message));
+}
+
+void AsyncClient::expireOverdue() {
+    std::vector<Callback> overdue;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto now = Clock::now();
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            if (it->second.deadline <= now) {
+                overdue.push_back(std::move(it->second.done));
+                it = m_pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& done : overdue) {
+        if (done) done(ClientError{ClientErrorKind::ResponseTimeout, 0, ""});
+    }
+}
+
+AsyncClient::PendingMap AsyncClient::disconnectLocked() {
+    if (m_socket) {
+        // Wakes the reader's poll; the descriptor closes when its
+        // reference, and ours, are gone.
+        m_socket->shutdownBoth();
+        m_socket.reset();
+    }
+    return std::exchange(m_pending, {});
+}
+
+void AsyncClient::failAll(PendingMap pending, const ClientError& error) {
+    for (auto& [_, request] : pending) {
+        if (request.done) request.done(error);
+    }
+}
+
+} // namespace cec_control
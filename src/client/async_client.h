@@ -0,0 +1,156 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "../common/messages.h"
+#include "../common/unix_socket.h"
+#include "socket_client.h"
+
+namespace cec_control {
+
+/**
+ * Long-lived, pipelined client for the daemon's control socket.
+ *
+ * Where @c SocketClient is one blocking exchange at a time, an
+ * @c AsyncClient keeps its connection open across calls and lets any
+ * number of requests be outstanding at once: @c send frames the
+ * command under a fresh @c RequestId and returns immediately, and a
+ * reader thread matches each response to its request by that tag —
+ * the daemon may answer out of order. The reply is delivered either to
+ * a callback or through a @c std::future.
+ *
+ * ## Threading
+ *
+ * @c send and @c close may be called from any thread, including from
+ * a callback. Callbacks run on the reader thread, one at a time, and
+ * should return promptly: the next reply waits for them. The reader is
+ * started by the first connection and lives as long as the client.
+ *
+ * ## Failures
+ *
+ * Every request is answered exactly once. If the daemon closes the
+ * connection or the socket fails, all outstanding requests complete
+ * with the corresponding @c ClientError and the client drops to
+ * disconnected; the next @c send reconnects. A request with no reply
+ * after @c kResponseTimeout completes with @c ResponseTimeout, and a
+ * late reply to it is discarded.
+ *
+ * ## Framing
+ *
+ * Each connection opens with a @c CMD_HELLO, so requests can carry
+ * @c RequestOptions. A daemon that predates the hello drops the
+ * connection instead of answering it; the client then reconnects and
+ * stays on the legacy framing, where options are not sent and every
+ * request waits for its reply.
+ */
+class AsyncClient {
+public:
+    using Result   = SocketClient::SendResult;
+    using Callback = std::function<void(Result)>;
+
+    /** Longest a request waits for its reply. */
+    static constexpr auto kResponseTimeout = std::chrono::seconds(10);
+
+    explicit AsyncClient(std::string socketPath = {});
+    ~AsyncClient();
+
+    AsyncClient(const AsyncClient&)            = delete;
+    AsyncClient& operator=(const AsyncClient&) = delete;
+
+    /**
+     * Connect if not already connected. Returns nullopt on success.
+     * Optional: @c send connects on demand.
+     */
+    std::optional<ClientError> connect();
+
+    /** Fail every outstanding request and close the connection. Idempotent. */
+    void close();
+
+    [[nodiscard]] bool isConnected() const;
+    [[nodiscard]] const std::string& socketPath() const noexcept { return m_socketPath; }
+
+    /**
+     * Send @p command; @p done receives the reply or the failure. On a
+     * failure to connect or send, @p done runs before @c send returns,
+     * on the calling thread.
+     */
+    void send(const Message& command, Callback done);
+
+    /** As above, with the outcome delivered through a future. */
+    [[nodiscard]] std::future<Result> send(const Message& command);
+
+    /**
+     * Send @p command with per-request @p options. With
+     * @c RequestOptions::noReply the daemon answers nothing, so @p done
+     * receives @c RESP_SUCCESS as soon as the frame is sent: it reports
+     * delivery, not the outcome.
+     */
+    void send(const Message& command, const RequestOptions& options, Callback done);
+    [[nodiscard]] std::future<Result> send(const Message& command, const RequestOptions& options);
+
+    /** Framing version of the current connection; @c kProtocolLegacy when disconnected. */
+    [[nodiscard]] uint8_t protocol() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Callback          done;
+        Clock::time_point deadline;
+    };
+
+    /** Under @c m_mutex: the connect half of @c connect. */
+    std::optional<ClientError> connectLocked();
+
+    /**
+     * Say hello on a fresh @p socket and block for the reply.
+     * @return the framing version agreed, or nullopt if the daemon
+     *         closed the connection or gave no usable answer.
+     */
+    static std::optional<uint8_t> negotiate(const UnixSocket& socket);
+
+    using PendingMap = std::unordered_map<RequestId, Pending>;
+
+    /** Reader-thread body: receive, match, time out. */
+    void readLoop();
+
+    /** Reader side: one datagram from @p socket, framed as @p protocol, ready to read. */
+    void receiveFrom(const std::shared_ptr<UnixSocket>& socket, uint8_t protocol);
+
+    /** Reader side: complete requests past their deadline. */
+    void expireOverdue();
+
+    /**
+     * Detach every outstanding request and drop the connection. The
+     * caller completes the returned requests with its error after
+     * releasing @c m_mutex, so no callback runs under the lock.
+     */
+    PendingMap disconnectLocked();
+
+    static void failAll(PendingMap pending, const ClientError& error);
+
+    std::string m_socketPath;
+
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_connected;  ///< Signalled on connect and on stop.
+    bool                    m_stopping = false;
+    // Shared with the reader, which holds its own reference while it
+    // polls: a concurrent close() can drop ours without the descriptor
+    // number being reused under the reader's feet.
+    std::shared_ptr<UnixSocket> m_socket;
+    uint8_t                     m_protocol = kProtocolLegacy;  ///< Of m_socket.
+    std::thread                 m_reader;
+    RequestId                   m_nextRequestId = 1;
+    PendingMap                  m_pending;
+};
+
+} // namespace cec_control
@@ -1,36 +1,424 @@
 #include "cec_client.h"
 
+#include <poll.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <ostream>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+#include "../common/argument_parser.h"
 
 namespace cec_control {
 
 namespace {
 
+/**
+ * Requests a session keeps outstanding before it stops reading stdin.
+ * Matches the daemon's per-connection pipeline depth: anything beyond it
+ * would only wait in the socket buffer, with its response timeout
+ * already running.
+ */
+constexpr std::size_t kSessionMaxInFlight = 8;
+
+/** How often a session with replies outstanding looks for them. */
+constexpr int kSessionPollMs = 20;
+
 /** strerror() for an errno value, with a sensible fallback for the unset case. */
 const char* strerrorOr(int err) noexcept {
     return err == 0 ? "operation failed" : std::strerror(err);
 }
 
+/** Label for one per-step result byte of a batch response. */
+const char* stepResultLabel(uint8_t raw) noexcept {
+    switch (static_cast<MessageType>(raw)) {
+        case MessageType::RESP_SUCCESS: return "ok";
+        case MessageType::RESP_BUSY:    return "busy";
+        case MessageType::RESP_UNREACHABLE: return "unreachable";
+        default:                        return "failed";
+    }
+}
+
+/** True for the read-only commands whose payload is encodeDeviceStates. */
+bool isQuery(MessageType type) noexcept {
+    return type == MessageType::CMD_QUERY_STATUS ||
+           type == MessageType::CMD_QUERY_DEVICES ||
+           type == MessageType::CMD_QUERY_ACTIVE_SOURCE;
+}
+
+/** True for `trace dump`, which takes one round-trip per chunk. */
+bool isTraceDump(const Message& command) noexcept {
+    return command.type == MessageType::CMD_TRACE && !command.data.empty() &&
+           command.data[0] == static_cast<uint8_t>(TraceOp::Dump);
+}
+
+/** Whitespace-separated tokens of @p line, as the shell would split them. */
+std::vector<std::string_view> splitWords(std::string_view line) {
+    std::vector<std::string_view> words;
+    std::size_t pos = 0;
+    while (true) {
+        pos = line.find_first_not_of(" \t\r", pos);
+        if (pos == std::string_view::npos) break;
+        const std::size_t end = line.find_first_of(" \t\r", pos);
+        words.push_back(line.substr(pos, end - pos));
+        if (end == std::string_view::npos) break;
+        pos = end;
+    }
+    return words;
+}
+
+/** Label for a raw CEC power-status byte. */
+const char* powerStatusLabel(uint8_t raw) noexcept {
+    switch (raw) {
+        case 0:  return "on";
+        case 1:  return "standby";
+        case 2:  return "turning on";
+        case 3:  return "turning off";
+        default: return "unknown";
+    }
+}
+
+/** CEC physical address in its conventional dotted form, e.g. "1.0.0.0". */
+std::string formatPhysicalAddress(uint16_t address) {
+    if (address == kPhysicalAddressUnknown) return "unknown";
+    std::string out;
+    for (int shift = 12; shift >= 0; shift -= 4) {
+        if (!out.empty()) out += '.';
+        out += "0123456789abcdef"[(address >> shift) & 0xF];
+    }
+    return out;
+}
+
+/**
+ * One subscription event as a line: the event name, then `key=value`
+ * fields, e.g. `active-source address=1.0.0.0 device=4`.
+ */
+std::ostream& operator<<(std::ostream& os, const BusEvent& event) {
+    os << busEventName(event.kind);
+    switch (event.kind) {
+        case BusEventKind::TvPowerReport: {
+            std::string label = powerStatusLabel(event.powerStatus);
+            std::replace(label.begin(), label.end(), ' ', '-');
+            os << " power=" << label;
+            break;
+        }
+        case BusEventKind::ActiveSource:
+            os << " address=" << formatPhysicalAddress(event.physicalAddress);
+            break;
+        case BusEventKind::RawFrame: {
+            char hex[4];
+            std::snprintf(hex, sizeof(hex), "%02x", event.frame.opcode);
+            os << " to=" << static_cast<int>(event.frame.destination) << " opcode=" << hex;
+            if (event.frame.parameterCount > 0) {
+                os << " params=";
+                for (uint8_t i = 0; i < event.frame.parameterCount; ++i) {
+                    std::snprintf(hex, sizeof(hex), "%02x", event.frame.parameters[i]);
+                    os << (i > 0 ? ":" : "") << hex;
+                }
+            }
+            break;
+        }
+        case BusEventKind::Overflow:
+            os << " dropped=" << event.dropped;
+            break;
+        default:
+            break;
+    }
+    if (event.logicalAddress != kLogicalAddressUnknown) {
+        os << " device=" << static_cast<int>(event.logicalAddress);
+    }
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const DeviceState& state) {
+    os << "Device " << static_cast<int>(state.logicalAddress)
+       << ": power " << powerStatusLabel(state.powerStatus)
+       << ", address " << formatPhysicalAddress(state.physicalAddress);
+    if (!state.osdName.empty()) os << ", name \"" << state.osdName << '"';
+    return os;
+}
+
 } // namespace
 
-CECClient::CECClient(std::string socketPath)
-    : m_socketClient(std::move(socketPath)) {}
+CECClient::CECClient(std::string socketPath, AdapterSelector adapter)
+    : m_socketClient(std::move(socketPath)),
+      m_asyncClient(m_socketClient.socketPath()) {
+    m_options.adapter = adapter;
+}
 
-int CECClient::execute(const Message& command) {
-    if (auto err = m_socketClient.connect()) {
+bool CECClient::connect() {
+    if (m_options.adapter.empty()) {
+        if (auto err = m_socketClient.connect()) {
+            renderConnectError(*err);
+            return false;
+        }
+        return true;
+    }
+    if (auto err = m_asyncClient.connect()) {
         renderConnectError(*err);
+        return false;
+    }
+    if (m_asyncClient.protocol() == kProtocolLegacy) {
+        std::cerr << "Error: the daemon is too old to select an adapter; "
+                     "run the command without --adapter=\n";
+        return false;
+    }
+    return true;
+}
+
+SocketClient::SendResult CECClient::roundTrip(const Message& command) {
+    if (m_options.adapter.empty()) return m_socketClient.sendCommand(command);
+    return m_asyncClient.send(command, m_options).get();
+}
+
+int CECClient::execute(const Message& command) {
+    if (!connect()) return EXIT_FAILURE;
+
+    if (isTraceDump(command)) {
+        return dumpTrace([this](const Message& request) { return roundTrip(request); });
+    }
+    if (command.type == MessageType::CMD_SUBSCRIBE) {
+        return streamEvents(command);
+    }
+
+    auto result = roundTrip(command);
+    if (auto* err = std::get_if<ClientError>(&result)) {
+        renderTransportError(*err);
         return EXIT_FAILURE;
     }
+    return renderResponse(command, std::get<Message>(result));
+}
 
+int CECClient::post(const Message& command) {
+    if (!connect()) return EXIT_FAILURE;
+    if (m_options.adapter.empty()) {
+        if (auto err = m_socketClient.post(command)) {
+            renderTransportError(*err);
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    RequestOptions options = m_options;
+    options.noReply = true;
+    auto result = m_asyncClient.send(command, options).get();
+    if (auto* err = std::get_if<ClientError>(&result)) {
+        renderTransportError(*err);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int CECClient::runSession() {
+    if (m_options.adapter.empty()) {
+        if (auto err = m_asyncClient.connect()) {
+            renderConnectError(*err);
+            return EXIT_FAILURE;
+        }
+    } else if (!connect()) {
+        return EXIT_FAILURE;
+    }
+
+    struct InFlight {
+        Message                                command;
+        std::future<SocketClient::SendResult> reply;
+    };
+    std::deque<InFlight> inFlight;
+    int exitCode = EXIT_SUCCESS;
+    const auto record = [&exitCode](int code) {
+        if (exitCode == EXIT_SUCCESS) exitCode = code;
+    };
+
+    // Render the oldest outstanding reply, waiting for it, and retire it.
+    const auto renderFront = [&] {
+        auto& front = inFlight.front();
+        auto result = front.reply.get();
+        if (auto* err = std::get_if<ClientError>(&result)) {
+            renderTransportError(*err);
+            record(EXIT_FAILURE);
+        } else {
+            record(renderResponse(front.command, std::get<Message>(result)));
+        }
+        inFlight.pop_front();
+    };
+
+    // Render replies from the front of the queue: all of them, or only
+    // those already in when @p wait is false, so output stays in input
+    // order while later commands are still outstanding.
+    const auto settle = [&](bool wait) {
+        while (!inFlight.empty()) {
+            if (!wait && inFlight.front().reply.wait_for(std::chrono::seconds(0)) !=
+                             std::future_status::ready) {
+                return;
+            }
+            renderFront();
+        }
+        std::cout.flush();
+    };
+
+    // Returns false once the session should end.
+    std::size_t lineNumber = 0;
+    const auto handleLine = [&](std::string_view line) -> bool {
+        ++lineNumber;
+        const auto words = splitWords(line);
+        if (words.empty() || words.front().front() == '#') return true;
+        if (words.size() == 1 && (words.front() == "quit" || words.front() == "exit")) {
+            return false;
+        }
+
+        auto parsed = ArgumentParser::parseCommand(words);
+        if (auto* err = std::get_if<ParseError>(&parsed)) {
+            settle(true);
+            std::string_view message = err->message;
+            constexpr std::string_view kPrefix = "Error: ";
+            if (message.substr(0, kPrefix.size()) == kPrefix) message.remove_prefix(kPrefix.size());
+            std::cerr << "Error: line " << lineNumber << ": " << message << '\n';
+            record(EXIT_FAILURE);
+            return true;
+        }
+        Message command = std::move(std::get<Message>(parsed));
+
+        if (command.type == MessageType::CMD_SUBSCRIBE) {
+            // Events would share the session's connection with its
+            // replies; a subscriber wants a connection of its own.
+            std::cerr << "Error: line " << lineNumber
+                      << ": subscribe is not available in a session\n";
+            record(EXIT_FAILURE);
+            return true;
+        }
+        if (isTraceDump(command)) {
+            // Its chunks are sequential; let everything before it finish.
+            settle(true);
+            record(dumpTrace([this](const Message& request) {
+                return m_asyncClient.send(request, m_options).get();
+            }));
+            std::cout.flush();
+            return true;
+        }
+
+        // A full window retires its oldest request before sending.
+        if (inFlight.size() >= kSessionMaxInFlight) {
+            renderFront();
+            std::cout.flush();
+        }
+        auto reply = m_asyncClient.send(command, m_options);
+        inFlight.push_back(InFlight{std::move(command), std::move(reply)});
+        return true;
+    };
+
+    std::string pending;
+    char buffer[4096];
+    bool open = true;
+    while (open) {
+        settle(false);
+
+        pollfd pfd{STDIN_FILENO, POLLIN, 0};
+        const int ready = ::poll(&pfd, 1, inFlight.empty() ? -1 : kSessionPollMs);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "Error: failed to read commands: " << strerrorOr(errno) << '\n';
+            record(EXIT_FAILURE);
+            break;
+        }
+        if (ready <= 0) continue;
+
+        const ssize_t n = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            std::cerr << "Error: failed to read commands: " << strerrorOr(errno) << '\n';
+            record(EXIT_FAILURE);
+            break;
+        }
+        if (n == 0) {
+            // End of input; a last line without its newline still counts.
+            if (!pending.empty()) handleLine(pending);
+            break;
+        }
+
+        pending.append(buffer, static_cast<std::size_t>(n));
+        std::size_t start = 0;
+        while (open) {
+            const std::size_t nl = pending.find('\n', start);
+            if (nl == std::string::npos) break;
+            open = handleLine(std::string_view(pending).substr(start, nl - start));
+            start = nl + 1;
+        }
+        pending.erase(0, start);
+    }
+
+    settle(true);
+    m_asyncClient.close();
+    return exitCode;
+}
+
+int CECClient::dumpTrace(const RoundTrip& roundTrip) {
+    std::string json;
+    for (uint32_t chunk = 0; chunk <= 0xFFFF; ++chunk) {
+        const Message request(MessageType::CMD_TRACE, 0,
+                              {static_cast<uint8_t>(TraceOp::Dump),
+                               static_cast<uint8_t>(chunk >> 8),
+                               static_cast<uint8_t>(chunk & 0xFF)});
+        auto result = roundTrip(request);
+        if (auto* err = std::get_if<ClientError>(&result)) {
+            renderTransportError(*err);
+            return EXIT_FAILURE;
+        }
+        const Message& response = std::get<Message>(result);
+        if (response.type != MessageType::RESP_SUCCESS) {
+            return renderResponse(request, response);
+        }
+        if (response.data.empty()) {
+            std::cerr << "Error: daemon returned a malformed trace chunk\n";
+            return EXIT_FAILURE;
+        }
+        json.append(response.data.begin() + 1, response.data.end());
+        if (response.data[0] == 0) {
+            std::cout << json;
+            return EXIT_SUCCESS;
+        }
+    }
+    std::cerr << "Error: trace dump did not terminate\n";
+    return EXIT_FAILURE;
+}
+
+int CECClient::streamEvents(const Message& command) {
     auto result = m_socketClient.sendCommand(command);
     if (auto* err = std::get_if<ClientError>(&result)) {
         renderTransportError(*err);
         return EXIT_FAILURE;
     }
-    return renderResponse(std::get<Message>(result));
+    const Message& response = std::get<Message>(result);
+    if (response.type != MessageType::RESP_SUCCESS) {
+        return renderResponse(command, response);
+    }
+
+    while (true) {
+        auto next = m_socketClient.receive();
+        if (auto* err = std::get_if<ClientError>(&next)) {
+            // A quiet bus is not a failure.
+            if (err->kind == ClientErrorKind::ResponseTimeout) continue;
+            renderTransportError(*err);
+            return EXIT_FAILURE;
+        }
+        const Message& message = std::get<Message>(next);
+        if (message.type != MessageType::RESP_EVENT) continue;
+        const auto event = decodeBusEvent(message.data);
+        if (!event) {
+            std::cerr << "Error: daemon returned a malformed event\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << *event << std::endl;
+    }
 }
 
 void CECClient::renderConnectError(const ClientError& err) const {
@@ -93,13 +481,74 @@ void CECClient::renderTransportError(const ClientError& err) const {
     }
 }
 
-int CECClient::renderResponse(const Message& response) const {
+int CECClient::renderResponse(const Message& command, const Message& response) const {
+    if (isQuery(command.type) && response.type == MessageType::RESP_SUCCESS) {
+        return renderDeviceStates(command, response);
+    }
+    if (command.type == MessageType::CMD_STATS &&
+        response.type == MessageType::RESP_SUCCESS) {
+        // The daemon's report is already formatted text.
+        std::cout.write(reinterpret_cast<const char*>(response.data.data()),
+                        static_cast<std::streamsize>(response.data.size()));
+        return EXIT_SUCCESS;
+    }
+    // Otherwise only batch responses carry a payload: one result byte
+    // per step.
+    for (std::size_t i = 0; i < response.data.size(); ++i) {
+        std::cout << "Step " << (i + 1) << ": "
+                  << stepResultLabel(response.data[i]) << '\n';
+    }
     if (response.type == MessageType::RESP_SUCCESS) {
         std::cout << "Command executed successfully\n";
         return EXIT_SUCCESS;
     }
+    if (response.type == MessageType::RESP_BUSY) {
+        std::cerr << "Error: daemon is busy, try again later\n";
+        return EX_TEMPFAIL;
+    }
+    if (response.type == MessageType::RESP_NOT_READY) {
+        std::cerr << "Error: daemon is still opening the CEC adapter, try again later\n";
+        return EX_TEMPFAIL;
+    }
+    if (response.type == MessageType::RESP_UNREACHABLE) {
+        std::cerr << "Error: device is not responding; commands to it fail without being sent "
+                     "until it answers again\n";
+        return EX_UNAVAILABLE;
+    }
+    if (response.type == MessageType::RESP_RATE_LIMITED) {
+        std::cerr << "Error: too many requests from this user, slow down and try again\n";
+        return EX_TEMPFAIL;
+    }
     std::cerr << "Error: command failed\n";
     return EXIT_FAILURE;
 }
 
+int CECClient::renderDeviceStates(const Message& command, const Message& response) const {
+    const auto states = decodeDeviceStates(response.data);
+    if (!states) {
+        std::cerr << "Error: daemon returned a malformed device list\n";
+        return EXIT_FAILURE;
+    }
+    if (command.type == MessageType::CMD_QUERY_ACTIVE_SOURCE) {
+        const DeviceState active = states->empty() ? DeviceState{} : states->front();
+        if (active.physicalAddress == kPhysicalAddressUnknown) {
+            std::cout << "Active source: unknown\n";
+        } else if (active.logicalAddress == kLogicalAddressUnknown) {
+            std::cout << "Active source: address "
+                      << formatPhysicalAddress(active.physicalAddress) << '\n';
+        } else {
+            std::cout << "Active source: " << active << '\n';
+        }
+        return EXIT_SUCCESS;
+    }
+    if (states->empty()) {
+        std::cout << "No devices found\n";
+        return EXIT_SUCCESS;
+    }
+    for (const auto& state : *states) {
+        std::cout << state << '\n';
+    }
+    return EXIT_SUCCESS;
+}
+
 } // namespace cec_control
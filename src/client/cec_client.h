@@ -1,8 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <string>
 
 #include "../common/messages.h"
+#include "async_client.h"
 #include "socket_client.h"
 
 namespace cec_control {
@@ -15,10 +17,18 @@ namespace cec_control {
  * standard streams. Stdout carries the human-readable success line; stderr
  * carries every diagnostic so that pipelines consuming stdout see only the
  * positive result.
+ *
+ * A session (@c runSession) instead keeps one pipelined connection open
+ * for a stream of commands read from stdin.
+ *
+ * With an @p adapter selected every request goes out on the
+ * @c AsyncClient instead, whose version 2 framing carries the selector;
+ * a daemon that only speaks the legacy framing is refused rather than
+ * sent commands it would run on its default adapter.
  */
 class CECClient {
 public:
-    explicit CECClient(std::string socketPath);
+    explicit CECClient(std::string socketPath, AdapterSelector adapter = {});
 
     CECClient(const CECClient&) = delete;
     CECClient& operator=(const CECClient&) = delete;
@@ -26,16 +36,64 @@ public:
     /**
      * Connect, send @p command, render the result. Returns a process exit
      * code: EXIT_SUCCESS only when the daemon acknowledged the command with
-     * RESP_SUCCESS.
+     * RESP_SUCCESS, EX_TEMPFAIL when it refused with RESP_BUSY,
+     * RESP_NOT_READY or RESP_RATE_LIMITED, EX_UNAVAILABLE when the target device's breaker
+     * answered RESP_UNREACHABLE.
      */
     int execute(const Message& command);
 
+    /**
+     * Connect and send @p command without waiting for its reply
+     * (`--no-wait`). EXIT_SUCCESS once the request is queued on the
+     * socket; whether the daemon then ran it is not reported.
+     */
+    int post(const Message& command);
+
+    /**
+     * Read commands from stdin, one per line in command-line syntax
+     * (`power on 0`), and send each as soon as it is read, several in
+     * flight at once over one connection. Results are rendered in input
+     * order, each as @c execute would. Blank lines and lines starting
+     * with '#' are skipped; `quit` or `exit` ends the session, as does
+     * end of input once every reply is in. Returns the exit code of the
+     * first line that failed, or EXIT_SUCCESS.
+     */
+    int runSession();
+
 private:
+    using RoundTrip = std::function<SocketClient::SendResult(const Message&)>;
+
+    /**
+     * Connect whichever client carries this run's requests. False once
+     * the failure has been rendered.
+     */
+    bool connect();
+
+    /** One blocking exchange over that client. */
+    SocketClient::SendResult roundTrip(const Message& command);
+
+    /**
+     * Walk every chunk of a `trace dump`, one @p roundTrip each, and
+     * write the reassembled JSON to stdout. Nothing is written unless
+     * every chunk arrived.
+     */
+    int  dumpTrace(const RoundTrip& roundTrip);
+
+    /**
+     * Send a @c CMD_SUBSCRIBE and print each event the daemon then
+     * pushes, one line apiece, until the connection ends. Only a
+     * failure returns.
+     */
+    int  streamEvents(const Message& command);
+
     void renderConnectError(const ClientError& err) const;
     void renderTransportError(const ClientError& err) const;
-    int  renderResponse(const Message& response) const;
+    int  renderResponse(const Message& command, const Message& response) const;
+    int  renderDeviceStates(const Message& command, const Message& response) const;
 
-    SocketClient m_socketClient;
+    SocketClient   m_socketClient;
+    AsyncClient    m_asyncClient;  ///< Sessions and adapter selection; connects on first use.
+    RequestOptions m_options;      ///< Sent with every request on @c m_asyncClient.
 };
 
 } // namespace cec_control
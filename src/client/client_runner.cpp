@@ -1,13 +1,96 @@
 #include "client_runner.h"
 
 #include "cec_client.h"
+#include "fleet_client.h"
+#include "flight_dump.h"
+#include "../common/network_token.h"
 
+#include <limits.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 namespace cec_control {
 
+namespace {
+
+constexpr const char* kDaemonProgram = "cec-controld";
+
+/**
+ * Append the hosts listed in @p path to @p hosts: one HOST:PORT per
+ * line, blank lines and '#' comments skipped. False if it cannot be read.
+ */
+bool readHostsFile(const std::string& path, std::vector<std::string>& hosts) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(std::min(line.find('#'), line.size()));
+        const auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) continue;
+        const auto last = line.find_last_not_of(" \t\r");
+        hosts.push_back(line.substr(first, last - first + 1));
+    }
+    return !in.bad();
+}
+
+std::string withErrno(const char* what, int err) {
+    return err != 0 ? std::string(what) + ": " + std::strerror(err) : std::string(what);
+}
+
+/** One host's outcome in a word or two, e.g. "ok" or "refused". */
+std::string outcomeLabel(const std::variant<Message, ClientError>& outcome) {
+    if (const auto* reply = std::get_if<Message>(&outcome)) {
+        switch (reply->type) {
+            case MessageType::RESP_SUCCESS:      return "ok";
+            case MessageType::RESP_ERROR:        return "error";
+            case MessageType::RESP_BUSY:         return "busy";
+            case MessageType::RESP_NOT_READY:    return "not-ready";
+            case MessageType::RESP_UNREACHABLE:  return "unreachable";
+            case MessageType::RESP_RATE_LIMITED: return "rate-limited";
+            default:                             return "unexpected reply";
+        }
+    }
+    const auto& err = std::get<ClientError>(outcome);
+    switch (err.kind) {
+        case ClientErrorKind::DaemonUnavailable: return "refused";
+        case ClientErrorKind::ConnectTimeout:    return "connect timeout";
+        case ClientErrorKind::ConnectFailed:
+            return err.errnoCode != 0 ? withErrno("connect failed", err.errnoCode)
+                                      : "connect failed: " + err.detail;
+        case ClientErrorKind::SendFailed:        return withErrno("send failed", err.errnoCode);
+        case ClientErrorKind::PeerClosed:        return "closed";
+        case ClientErrorKind::ResponseTimeout:   return "timeout";
+        case ClientErrorKind::ReceiveFailed:     return withErrno("receive failed", err.errnoCode);
+        case ClientErrorKind::MalformedResponse: return "malformed reply";
+        case ClientErrorKind::AuthFailed:        return "token refused";
+        default:                                 return "failed";
+    }
+}
+
+double toMs(std::chrono::microseconds us) {
+    return static_cast<double>(us.count()) / 1000.0;
+}
+
+/** The @p q quantile of sorted, non-empty @p values, nearest rank. */
+std::chrono::microseconds quantile(const std::vector<std::chrono::microseconds>& values,
+                                   double q) {
+    const auto rank = static_cast<std::size_t>(q * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(rank, values.size() - 1)];
+}
+
+} // namespace
+
 int ClientRunner::run(const RunClient& action) {
     // The logger keeps its silent default on the client path. Every
     // diagnostic the client surfaces is rendered through CECClient onto
@@ -15,8 +98,20 @@ int ClientRunner::run(const RunClient& action) {
     // downstream pipelines parse the success line cleanly.
 
     try {
-        CECClient client(action.socketPathOverride);
-        return client.execute(action.command);
+        CECClient client(action.socketPathOverride, action.adapter);
+        return action.noWait ? client.post(action.command)
+                             : client.execute(action.command);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
+
+int ClientRunner::runSession(const RunSession& action) {
+    try {
+        CECClient client(action.socketPathOverride, action.adapter);
+        return client.runSession();
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << '\n';
@@ -24,4 +119,98 @@ int ClientRunner::run(const RunClient& action) {
     }
 }
 
+int ClientRunner::runFlightDump(const RunFlightDump& action) {
+    try {
+        return FlightDump::print(action.path, std::cout);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
+
+int ClientRunner::runFleet(const RunFleet& action) {
+    try {
+        std::vector<std::string> hosts = action.hosts;
+        if (!action.hostsFile.empty() && !readHostsFile(action.hostsFile, hosts)) {
+            std::cerr << "Error: cannot read " << action.hostsFile << ": "
+                      << std::strerror(errno) << '\n';
+            return EXIT_FAILURE;
+        }
+        if (hosts.empty()) {
+            std::cerr << "Error: no hosts to send to\n";
+            return EXIT_FAILURE;
+        }
+        std::string error;
+        auto token = readNetworkToken(action.tokenFile, error);
+        if (!token) {
+            std::cerr << "Error: " << error << '\n';
+            return EXIT_FAILURE;
+        }
+
+        const FleetClient fleet(std::move(*token), std::chrono::milliseconds(action.timeoutMs));
+        const auto started = std::chrono::steady_clock::now();
+        const std::vector<FleetResult> results = fleet.run(hosts, action.command);
+        const auto wall = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started);
+
+        std::size_t width = 4;
+        for (const FleetResult& result : results) width = std::max(width, result.host.size());
+
+        std::vector<std::chrono::microseconds> answered;
+        std::size_t ok = 0;
+        char latency[32];
+        for (const FleetResult& result : results) {
+            const bool replied = std::holds_alternative<Message>(result.outcome);
+            if (replied) answered.push_back(result.latency);
+            if (replied && std::get<Message>(result.outcome).type == MessageType::RESP_SUCCESS) {
+                ++ok;
+            }
+            std::snprintf(latency, sizeof(latency), "%9.1f ms", toMs(result.latency));
+            std::cout << result.host << std::string(width - result.host.size() + 2, ' ')
+                      << latency << "  " << outcomeLabel(result.outcome) << '\n';
+        }
+
+        std::cout << results.size() << (results.size() == 1 ? " host: " : " hosts: ") << ok << " ok, " << (results.size() - ok)
+                  << " failed";
+        if (!answered.empty()) {
+            std::sort(answered.begin(), answered.end());
+            char summary[128];
+            std::snprintf(summary, sizeof(summary),
+                          "; reply ms min %.1f median %.1f p95 %.1f max %.1f",
+                          toMs(answered.front()), toMs(quantile(answered, 0.5)),
+                          toMs(quantile(answered, 0.95)), toMs(answered.back()));
+            std::cout << summary;
+        }
+        std::snprintf(latency, sizeof(latency), "%.1f", toMs(wall));
+        std::cout << "; wall " << latency << " ms\n";
+        return ok == results.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+}
+
+int ClientRunner::execDaemon(int argc, char* const argv[]) {
+    // argv is {program, "daemon", OPTIONS...}; the daemon takes OPTIONS.
+    std::vector<char*> args{const_cast<char*>(kDaemonProgram)};
+    for (int i = 2; i < argc; ++i) args.push_back(argv[i]);
+    args.push_back(nullptr);
+
+    // The sibling first, so a build tree or a non-default prefix runs
+    // the daemon it was built with.
+    char self[PATH_MAX];
+    const ssize_t length = ::readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length > 0) {
+        std::string path(self, static_cast<std::size_t>(length));
+        path.erase(path.rfind('/') + 1);
+        path += kDaemonProgram;
+        ::execv(path.c_str(), args.data());
+    }
+    ::execvp(kDaemonProgram, args.data());
+    std::cerr << "Error: cannot run " << kDaemonProgram << ": " << std::strerror(errno) << '\n';
+    return EXIT_FAILURE;
+}
+
 } // namespace cec_control
@@ -17,9 +17,38 @@ public:
     /**
      * Execute the client command described by @p action and return a process
      * exit code. EXIT_SUCCESS only when the daemon acknowledged with
-     * RESP_SUCCESS. Catches std::exception so main() does not need to.
+     * RESP_SUCCESS; EX_TEMPFAIL when it was too busy to take the
+     * command or its adapter was not open yet. Catches std::exception so main() does not need to.
      */
     static int run(const RunClient& action);
+
+    /**
+     * Run a stdin command session (see @c CECClient::runSession). The
+     * exit code is that of the first command that failed, or
+     * EXIT_SUCCESS.
+     */
+    static int runSession(const RunSession& action);
+
+    /**
+     * Print the flight recording named by @p action (see
+     * @c FlightDump). Needs no daemon and no socket.
+     */
+    static int runFlightDump(const RunFlightDump& action);
+
+    /**
+     * Send one command to every host of @p action (see @c FleetClient)
+     * and print a line per host and a summary. EXIT_SUCCESS only when
+     * every host answered RESP_SUCCESS.
+     */
+    static int runFleet(const RunFleet& action);
+
+    /**
+     * Hand `cec-control daemon OPTIONS...` (@p argv) over to the daemon
+     * executable, which this binary does not contain: exec
+     * @c cec-controld from this binary's own directory, else from
+     * $PATH, with the OPTIONS. Returns only if neither would run.
+     */
+    static int execDaemon(int argc, char* const argv[]);
 };
 
 } // namespace cec_control
@@ -0,0 +1,246 @@
+#include "fleet_client.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <utility>
+
+#include "../common/event_poller.h"
+#include "../common/inet_address.h"
+#include "../common/unix_socket.h"
+
+namespace cec_control {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr RequestId kHelloRequestId   = 0;
+constexpr RequestId kCommandRequestId = 1;
+
+constexpr std::uint32_t READ_BIT  = static_cast<std::uint32_t>(EventPoller::Event::READ);
+constexpr std::uint32_t WRITE_BIT = static_cast<std::uint32_t>(EventPoller::Event::WRITE);
+
+constexpr std::size_t kReadyPerWait = 64;
+
+/** One host's connection through the run. */
+struct Attempt {
+    UnixSocket                fd;
+    bool                      connecting = true;
+    bool                      done       = false;
+    std::vector<std::uint8_t> output;
+    std::size_t               sent = 0;
+    std::vector<std::uint8_t> input;
+};
+
+/** @p host as a socket address: numeric first, else through the resolver. */
+std::variant<sockaddr_in, ClientError> resolve(const std::string& host) {
+    if (const auto addr = parseInetAddress(host)) return *addr;
+
+    const auto colon = host.rfind(':');
+    uint16_t port = 0;
+    if (colon != std::string::npos && colon > 0) {
+        const char* first = host.data() + colon + 1;
+        const char* last  = host.data() + host.size();
+        const auto [end, ec] = std::from_chars(first, last, port);
+        if (ec != std::errc{} || end != last) port = 0;
+    }
+    if (port == 0) {
+        return ClientError{ClientErrorKind::ConnectFailed, 0, "want HOST:PORT"};
+    }
+
+    addrinfo hints{};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    const int rc = ::getaddrinfo(host.substr(0, colon).c_str(), nullptr, &hints, &found);
+    if (rc != 0 || found == nullptr) {
+        return ClientError{ClientErrorKind::ConnectFailed, 0, ::gai_strerror(rc)};
+    }
+    sockaddr_in addr = *reinterpret_cast<const sockaddr_in*>(found->ai_addr);
+    ::freeaddrinfo(found);
+    addr.sin_port = htons(port);
+    return addr;
+}
+
+/** Append @p message, framed for the network endpoint, to @p out. */
+void appendFrame(std::vector<std::uint8_t>& out, RequestId requestId, const Message& message) {
+    std::array<std::uint8_t, kStreamPrefixSize + MAX_FRAME_SIZE> buffer;
+    const std::size_t len = serializeFrameTo(kProtocolVersion, requestId, RequestOptions{},
+                                             message, buffer.data() + kStreamPrefixSize,
+                                             buffer.size() - kStreamPrefixSize);
+    buffer[0] = static_cast<std::uint8_t>(len & 0xFF);
+    buffer[1] = static_cast<std::uint8_t>(len >> 8);
+    out.insert(out.end(), buffer.data(), buffer.data() + kStreamPrefixSize + len);
+}
+
+/** A connect that failed, by its socket error. */
+ClientError connectError(int err, const std::string& host) {
+    return ClientError{classifyConnectErrno(err), err, host};
+}
+
+} // namespace
+
+FleetClient::FleetClient(std::string token, std::chrono::milliseconds timeout)
+    : m_token(std::move(token)), m_timeout(timeout) {}
+
+std::vector<FleetResult> FleetClient::run(const std::vector<std::string>& hosts,
+                                          const Message& command) const {
+    const auto start    = Clock::now();
+    const auto deadline = start + m_timeout;
+
+    // What every host is sent, framed once.
+    std::vector<std::uint8_t> hello{kProtocolVersion};
+    hello.insert(hello.end(), m_token.begin(), m_token.end());
+    std::vector<std::uint8_t> request;
+    appendFrame(request, kHelloRequestId, Message(MessageType::CMD_HELLO, 0, hello));
+    appendFrame(request, kCommandRequestId, command);
+
+    std::vector<FleetResult> results;
+    results.reserve(hosts.size());
+    std::vector<Attempt> attempts(hosts.size());
+    EventPoller poller;
+    std::size_t open = 0;
+
+    const auto finish = [&](std::size_t i, std::variant<Message, ClientError> outcome) {
+        Attempt& attempt = attempts[i];
+        if (attempt.fd.valid()) {
+            (void)poller.remove(attempt.fd.get());
+            attempt.fd.reset();
+        }
+        attempt.done        = true;
+        results[i].outcome  = std::move(outcome);
+        results[i].latency  = std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - start);
+        --open;
+    };
+
+    for (std::size_t i = 0; i < hosts.size(); ++i) {
+        results.push_back(FleetResult{hosts[i], ClientError{ClientErrorKind::ResponseTimeout, 0, hosts[i]}});
+        ++open;
+        auto addr = resolve(hosts[i]);
+        if (auto* err = std::get_if<ClientError>(&addr)) {
+            finish(i, std::move(*err));
+            continue;
+        }
+
+        Attempt& attempt = attempts[i];
+        attempt.fd = UnixSocket(::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+        if (!attempt.fd.valid()) {
+            finish(i, ClientError{ClientErrorKind::ConnectFailed, errno, hosts[i]});
+            continue;
+        }
+        const int noDelay = 1;
+        (void)::setsockopt(attempt.fd.get(), IPPROTO_TCP, TCP_NODELAY, &noDelay,
+                           sizeof(noDelay));
+        const auto& target = std::get<sockaddr_in>(addr);
+        if (::connect(attempt.fd.get(), reinterpret_cast<const sockaddr*>(&target),
+                      sizeof(target)) < 0 &&
+            errno != EINPROGRESS) {
+            finish(i, connectError(errno, hosts[i]));
+            continue;
+        }
+        attempt.output = request;
+        if (!poller.add(attempt.fd.get(), WRITE_BIT, &attempt)) {
+            finish(i, ClientError{ClientErrorKind::ConnectFailed, errno, hosts[i]});
+        }
+    }
+
+    std::array<EventPoller::Ready, kReadyPerWait> ready;
+    std::array<std::uint8_t, kStreamPrefixSize + MAX_FRAME_SIZE> buffer;
+    while (open > 0) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - Clock::now()).count();
+        if (left <= 0) break;
+        const int count = poller.wait(ready.data(), ready.size(), static_cast<int>(left) + 1);
+        if (count < 0) break;
+
+        for (int r = 0; r < count; ++r) {
+            const std::size_t i = static_cast<Attempt*>(ready[r].tag) - attempts.data();
+            Attempt& attempt = attempts[i];
+            const std::uint32_t events = ready[r].events;
+            if (attempt.done) continue;
+
+            if (attempt.connecting) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                if (::getsockopt(attempt.fd.get(), SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+                    err = errno;
+                }
+                if (err != 0) {
+                    finish(i, connectError(err, hosts[i]));
+                    continue;
+                }
+                attempt.connecting = false;
+            }
+
+            if ((events & WRITE_BIT) && attempt.sent < attempt.output.size()) {
+                const ssize_t sent = ::send(attempt.fd.get(), attempt.output.data() + attempt.sent,
+                                            attempt.output.size() - attempt.sent, MSG_NOSIGNAL);
+                if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    finish(i, ClientError{ClientErrorKind::SendFailed, errno, hosts[i]});
+                    continue;
+                }
+                if (sent > 0) attempt.sent += static_cast<std::size_t>(sent);
+                if (attempt.sent == attempt.output.size() &&
+                    !poller.modify(attempt.fd.get(), READ_BIT, &attempt)) {
+                    finish(i, ClientError{ClientErrorKind::ReceiveFailed, errno, hosts[i]});
+                    continue;
+                }
+            }
+
+            if (!(events & (READ_BIT | EventPoller::ERROR_EVENTS))) continue;
+            const ssize_t got = ::recv(attempt.fd.get(), buffer.data(), buffer.size(), 0);
+            if (got < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                finish(i, ClientError{ClientErrorKind::ReceiveFailed, errno, hosts[i]});
+                continue;
+            }
+            if (got == 0) {
+                finish(i, ClientError{ClientErrorKind::PeerClosed, 0, hosts[i]});
+                continue;
+            }
+            attempt.input.insert(attempt.input.end(), buffer.data(), buffer.data() + got);
+
+            // At most two frames come back: the hello's reply, then the command's.
+            std::size_t consumed = 0;
+            while (!attempt.done && attempt.input.size() - consumed >= kStreamPrefixSize) {
+                const std::uint8_t* prefix = attempt.input.data() + consumed;
+                const std::size_t   len    = prefix[0] | (static_cast<std::size_t>(prefix[1]) << 8);
+                if (attempt.input.size() - consumed < kStreamPrefixSize + len) break;
+                consumed += kStreamPrefixSize + len;
+
+                auto frame = deserializeFrame(kProtocolVersion, prefix + kStreamPrefixSize, len);
+                if (!frame) {
+                    finish(i, ClientError{ClientErrorKind::MalformedResponse, 0, hosts[i]});
+                } else if (frame->requestId == kHelloRequestId) {
+                    if (frame->message.type != MessageType::RESP_SUCCESS) {
+                        finish(i, ClientError{ClientErrorKind::AuthFailed, 0, hosts[i]});
+                    }
+                } else if (frame->requestId == kCommandRequestId) {
+                    finish(i, std::move(frame->message));
+                }
+            }
+            if (!attempt.done) {
+                attempt.input.erase(attempt.input.begin(),
+                                    attempt.input.begin() + static_cast<std::ptrdiff_t>(consumed));
+            }
+        }
+    }
+
+    // Still open at the deadline.
+    for (std::size_t i = 0; i < attempts.size(); ++i) {
+        if (attempts[i].done) continue;
+        finish(i, ClientError{attempts[i].connecting ? ClientErrorKind::ConnectTimeout
+                                                     : ClientErrorKind::ResponseTimeout,
+                              0, hosts[i]});
+    }
+    return results;
+}
+
+} // namespace cec_control
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "../common/messages.h"
+#include "socket_client.h"
+
+namespace cec_control {
+
+/** What one daemon of a fleet made of the request. */
+struct FleetResult {
+    std::string                        host;     ///< As given to @c FleetClient::run.
+    std::variant<Message, ClientError> outcome;
+    /** From the start of the run to the reply or the failure. */
+    std::chrono::microseconds          latency{0};
+};
+
+/**
+ * Sends one command to many daemons' network endpoints (see
+ * @c NetworkServer) at once, from one thread.
+ *
+ * Every host gets a non-blocking TCP connection, all of them on one
+ * @c EventPoller. As each connect completes, the hello with the token
+ * and the command go out together in one write, since the daemon reads
+ * a connection's frames in order; the run thus costs each host its
+ * connect and one round trip, however many hosts there are. Host names
+ * are resolved, one after another, before any connection starts.
+ *
+ * Failures are per host and never end the run: each host's
+ * @c FleetResult holds its reply or the @c ClientError it came to,
+ * with @c ResponseTimeout for a host still silent when the run's
+ * timeout expires.
+ */
+class FleetClient {
+public:
+    static constexpr auto kDefaultTimeout = std::chrono::seconds(10);
+
+    /** @param token The endpoints' shared secret; see @c readNetworkToken. */
+    explicit FleetClient(std::string token,
+                         std::chrono::milliseconds timeout = kDefaultTimeout);
+
+    /**
+     * Send @p command to each of @p hosts, given as @c HOST:PORT, and
+     * block until every one has answered or failed. Results are in the
+     * order of @p hosts.
+     */
+    [[nodiscard]] std::vector<FleetResult> run(const std::vector<std::string>& hosts,
+                                               const Message& command) const;
+
+private:
+    std::string               m_token;
+    std::chrono::milliseconds m_timeout;
+};
+
+} // namespace cec_control
@@ -0,0 +1,191 @@
+#include "flight_dump.h"
+
+#include "../common/flight_log.h"
+#include "../common/messages.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string_view>
+
+namespace cec_control {
+
+namespace {
+
+using flight_log::Entry;
+using flight_log::Event;
+
+/** Wire message type as the dump names it, e.g. "power-on" or "busy". */
+std::string_view messageTypeName(uint8_t type) noexcept {
+    switch (static_cast<MessageType>(type)) {
+        case MessageType::CMD_VOLUME_UP:           return "volume-up";
+        case MessageType::CMD_VOLUME_DOWN:         return "volume-down";
+        case MessageType::CMD_VOLUME_MUTE:         return "volume-mute";
+        case MessageType::CMD_POWER_ON:            return "power-on";
+        case MessageType::CMD_POWER_OFF:           return "power-off";
+        case MessageType::CMD_CHANGE_SOURCE:       return "source";
+        case MessageType::CMD_RESTART_ADAPTER:     return "restart";
+        case MessageType::CMD_SUSPEND:             return "suspend";
+        case MessageType::CMD_RESUME:              return "resume";
+        case MessageType::CMD_AUTO_STANDBY:        return "auto-standby";
+        case MessageType::CMD_KEY:                 return "key";
+        case MessageType::CMD_BATCH:               return "batch";
+        case MessageType::CMD_QUERY_STATUS:        return "status";
+        case MessageType::CMD_QUERY_DEVICES:       return "devices";
+        case MessageType::CMD_QUERY_ACTIVE_SOURCE: return "active-source";
+        case MessageType::CMD_STATS:               return "stats";
+        case MessageType::CMD_TRACE:               return "trace";
+        case MessageType::CMD_SUBSCRIBE:           return "subscribe";
+        case MessageType::CMD_SCENE:               return "scene";
+        case MessageType::CMD_VOLUME_SET:          return "volume-set";
+        case MessageType::CMD_KEY_DOWN:            return "hold";
+        case MessageType::CMD_KEY_UP:              return "release";
+        case MessageType::CMD_RAW_TRANSMIT:        return "raw";
+        case MessageType::CMD_KEY_SEQUENCE:        return "keys";
+        case MessageType::CMD_HELLO:               return "hello";
+        case MessageType::RESP_SUCCESS:            return "ok";
+        case MessageType::RESP_ERROR:              return "error";
+        case MessageType::RESP_BUSY:               return "busy";
+        case MessageType::RESP_EVENT:              return "event";
+        case MessageType::RESP_NOT_READY:          return "not-ready";
+        case MessageType::RESP_UNREACHABLE:        return "unreachable";
+        case MessageType::RESP_RATE_LIMITED:       return "rate-limited";
+    }
+    return "unknown";
+}
+
+/** Matches @c WorkPriority, which lives with the daemon. */
+std::string_view priorityName(uint8_t priority) noexcept {
+    switch (priority) {
+        case 0:  return "lifecycle";
+        case 1:  return "interactive";
+        case 2:  return "background";
+        default: return "unknown";
+    }
+}
+
+/** @c AdapterWorker::kNoLane: a job that orders against nothing. */
+constexpr uint16_t kNoLane = 0xFF;
+
+/** Local wall-clock time of @p us, to the microsecond. */
+std::string formatTime(int64_t us) {
+    const std::time_t seconds = static_cast<std::time_t>(us / 1000000);
+    std::tm local{};
+    ::localtime_r(&seconds, &local);
+    char text[40];
+    const std::size_t n = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    std::snprintf(text + n, sizeof(text) - n, ".%06lld",
+                  static_cast<long long>(us % 1000000));
+    return text;
+}
+
+std::string formatPhysicalAddress(uint32_t address) {
+    if (address > 0xFFFF || address == kPhysicalAddressUnknown) return "unknown";
+    char text[8];
+    std::snprintf(text, sizeof(text), "%x.%x.%x.%x", (address >> 12) & 0xF,
+                  (address >> 8) & 0xF, (address >> 4) & 0xF, address & 0xF);
+    return text;
+}
+
+std::string hexByte(uint32_t value) {
+    char text[4];
+    std::snprintf(text, sizeof(text), "%02x", value & 0xFF);
+    return text;
+}
+
+/** The event and its fields, e.g. `request power-on device=0 session=3 id=7`. */
+void printEvent(std::ostream& out, const Entry& entry) {
+    switch (entry.event) {
+        case Event::Milestone:
+            out << flight_log::milestoneName(entry.detail);
+            if (entry.arg == 0) out << " failed";
+            return;
+        case Event::Request:
+            out << "request " << messageTypeName(entry.detail) << " device=" << entry.id
+                << " session=" << entry.value << " id=" << entry.arg;
+            return;
+        case Event::Reply:
+            out << "reply " << messageTypeName(entry.detail) << " session=" << entry.value
+                << " id=" << entry.arg;
+            return;
+        case Event::JobStart:
+        case Event::JobEnd:
+            out << (entry.event == Event::JobStart ? "job-start " : "job-end ")
+                << priorityName(entry.detail);
+            if (entry.arg != kNoLane) out << " lane=" << entry.arg;
+            if (entry.event == Event::JobEnd) {
+                out << ' ' << flight_log::jobOutcomeName(entry.id) << " took="
+                    << entry.value << "us";
+            }
+            return;
+        case Event::Throttle:
+            out << "throttle " << flight_log::throttleDecisionName(entry.detail)
+                << " device=" << entry.arg;
+            if (entry.value != 0) out << " wait=" << entry.value << "us";
+            return;
+        case Event::Observation: {
+            using flight_log::ObservationKind;
+            out << "observe " << flight_log::observationKindName(entry.detail);
+            if (entry.arg != kLogicalAddressUnknown) out << " device=" << entry.arg;
+            switch (static_cast<ObservationKind>(entry.detail)) {
+                case ObservationKind::TvPowerReport:
+                case ObservationKind::PowerReport:
+                    out << " power=" << hexByte(entry.id);
+                    break;
+                case ObservationKind::ActiveSource:
+                case ObservationKind::PhysicalAddressReport:
+                    out << " address=" << formatPhysicalAddress(entry.id);
+                    break;
+                case ObservationKind::RawFrame:
+                    out << " opcode=" << hexByte(entry.id);
+                    break;
+                default:
+                    break;
+            }
+            return;
+        }
+    }
+    out << "unknown event " << static_cast<int>(entry.event);
+}
+
+} // namespace
+
+int FlightDump::print(const std::string& path, std::ostream& out) {
+    if (::access(path.c_str(), R_OK) != 0) {
+        std::cerr << "Error: cannot read " << path << ": " << std::strerror(errno) << '\n';
+        return EXIT_FAILURE;
+    }
+    flight_log::FlightLogReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Error: " << path << " is not a flight recording this client can read\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Entry> entries = reader.read();
+    const auto pid = static_cast<pid_t>(reader.recorderPid());
+    const bool running = pid > 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+    out << "# flight recording of pid " << pid << (running ? " (running)" : " (not running)")
+        << ", started " << formatTime(reader.startedUs()) << ", " << entries.size()
+        << " records\n";
+
+    std::array<std::string, flight_log::kRingCount> threads;
+    for (std::size_t ring = 0; ring < threads.size(); ++ring) {
+        const auto [name, tid] = reader.thread(static_cast<uint8_t>(ring));
+        threads[ring] = (name.empty() ? std::string("?") : name) + '/' + std::to_string(tid);
+    }
+    for (const Entry& entry : entries) {
+        out << formatTime(entry.timeUs) << ' ' << threads[entry.ring] << ' ';
+        printEvent(out, entry);
+        out << '\n';
+    }
+    return out ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace cec_control
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+namespace cec_control {
+
+/**
+ * `cec-control flight-dump`: decode the daemon's flight recorder (see
+ * @c flight_log) into one line per record, oldest first. Reads the file
+ * directly, so it works whether the daemon is running, stopped or
+ * crashed, and never touches the control socket.
+ */
+class FlightDump {
+public:
+    /**
+     * Print the recording at @p path to @p out. Returns a process exit
+     * code: EXIT_FAILURE, with the reason on stderr, if @p path is not
+     * a flight recorder this client can read.
+     */
+    static int print(const std::string& path, std::ostream& out);
+};
+
+} // namespace cec_control
@@ -9,8 +9,6 @@
 
 namespace cec_control {
 
-namespace {
-
 ClientErrorKind classifyConnectErrno(int err) noexcept {
     switch (err) {
         case ENOENT:
@@ -23,8 +21,6 @@ ClientErrorKind classifyConnectErrno(int err) noexcept {
     }
 }
 
-} // namespace
-
 SocketClient::SocketClient(std::string socketPath)
     : m_socketPath(socketPath.empty() ? SystemPaths::getSocketPath()
                                       : std::move(socketPath)) {}
@@ -53,7 +49,48 @@ SocketClient::SendResult SocketClient::sendCommand(const Message& command) {
         return ClientError{ClientErrorKind::NotConnected, 0, m_socketPath};
     }
 
-    const auto outBuf = command.serialize();
+    // One request at a time, so the tag only has to tell this exchange
+    // apart from a stale reply to an earlier one.
+    const RequestId requestId = m_nextRequestId++;
+    if (auto err = sendFrame(requestId, command)) {
+        return std::move(*err);
+    }
+
+    auto received = receiveFrame();
+    if (auto* err = std::get_if<ClientError>(&received)) {
+        return std::move(*err);
+    }
+    Frame& response = std::get<Frame>(received);
+    if (response.requestId != requestId) {
+        return ClientError{ClientErrorKind::MalformedResponse, 0,
+                           "response for request " +
+                           std::to_string(response.requestId) +
+                           ", expected " + std::to_string(requestId)};
+    }
+    return std::move(response.message);
+}
+
+std::optional<ClientError> SocketClient::post(const Message& command) {
+    if (!m_socket.valid()) {
+        return ClientError{ClientErrorKind::NotConnected, 0, m_socketPath};
+    }
+    return sendFrame(m_nextRequestId++, command);
+}
+
+SocketClient::SendResult SocketClient::receive() {
+    if (!m_socket.valid()) {
+        return ClientError{ClientErrorKind::NotConnected, 0, m_socketPath};
+    }
+    auto received = receiveFrame();
+    if (auto* err = std::get_if<ClientError>(&received)) {
+        return std::move(*err);
+    }
+    return std::move(std::get<Frame>(received).message);
+}
+
+std::optional<ClientError> SocketClient::sendFrame(RequestId requestId,
+                                                   const Message& command) {
+    const auto outBuf = serializeFrame(requestId, command);
     const ssize_t sent = ::send(m_socket.get(), outBuf.data(), outBuf.size(), MSG_NOSIGNAL);
     if (sent < 0) {
         return ClientError{ClientErrorKind::SendFailed, errno, ""};
@@ -65,8 +102,11 @@ SocketClient::SendResult SocketClient::sendCommand(const Message& command) {
                            "short send (" + std::to_string(sent) + "/" +
                            std::to_string(outBuf.size()) + ")"};
     }
+    return std::nullopt;
+}
 
-    std::array<uint8_t, MAX_MESSAGE_SIZE> buffer;
+std::variant<Frame, ClientError> SocketClient::receiveFrame() {
+    std::array<uint8_t, MAX_FRAME_SIZE> buffer;
     const ssize_t received = ::recv(m_socket.get(), buffer.data(), buffer.size(), MSG_TRUNC);
     if (received == 0) {
         return ClientError{ClientErrorKind::PeerClosed, 0, ""};
@@ -83,11 +123,11 @@ SocketClient::SendResult SocketClient::sendCommand(const Message& command) {
                            std::to_string(received) + " bytes"};
     }
 
-    auto response = Message::deserialize(buffer.data(), static_cast<std::size_t>(received));
-    if (!response) {
+    auto frame = deserializeFrame(buffer.data(), static_cast<std::size_t>(received));
+    if (!frame) {
         return ClientError{ClientErrorKind::MalformedResponse, 0, ""};
     }
-    return std::move(*response);
+    return std::move(*frame);
 }
 
 } // namespace cec_control
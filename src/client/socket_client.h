@@ -26,8 +26,12 @@ enum class ClientErrorKind {
     ReceiveFailed,        // any other recv-time failure
     OversizedResponse,    // datagram larger than our buffer
     MalformedResponse,    // wire format was rejected by the parser
+    AuthFailed,           // a network endpoint refused the token
 };
 
+/** Map a failed connect's errno to its @c ClientErrorKind. */
+ClientErrorKind classifyConnectErrno(int err) noexcept;
+
 /**
  * Structured failure value. errnoCode is 0 when the failure was not produced
  * by a syscall; detail is a free-form context string (socket path, byte
@@ -61,18 +65,45 @@ public:
     /** Establish the connection. Returns nullopt on success. */
     std::optional<ClientError> connect();
 
-    /** Send a command and block until the daemon responds. */
+    /**
+     * Send a command and block until the daemon responds. The request
+     * is framed with a fresh @c RequestId and the response must echo
+     * it.
+     */
     SendResult sendCommand(const Message& command);
 
+    /**
+     * Send a command and return without reading its reply: nullopt once
+     * the kernel has queued the datagram. The daemon runs a request it
+     * has read even if the connection closes behind it, and drops the
+     * reply.
+     */
+    std::optional<ClientError> post(const Message& command);
+
+    /**
+     * Block for the next message the daemon pushes unprompted, such as
+     * a @c RESP_EVENT after @c CMD_SUBSCRIBE. @c ResponseTimeout here
+     * only means nothing arrived within the I/O timeout; the
+     * connection is still usable.
+     */
+    SendResult receive();
+
     bool isConnected() const noexcept { return m_socket.valid(); }
     const std::string& socketPath() const noexcept { return m_socketPath; }
 
 private:
+    /** Frame @p command as @p requestId and send it as one datagram. */
+    std::optional<ClientError> sendFrame(RequestId requestId, const Message& command);
+
+    /** Receive and parse one frame, whatever request it answers. */
+    std::variant<Frame, ClientError> receiveFrame();
+
     static constexpr auto CONNECT_TIMEOUT = std::chrono::seconds(2);
     static constexpr auto IO_TIMEOUT      = std::chrono::seconds(10);
 
     std::string m_socketPath;
     UnixSocket  m_socket;
+    RequestId   m_nextRequestId = 1;
 };
 
 } // namespace cec_control
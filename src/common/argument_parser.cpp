@@ -1,7 +1,9 @@
 #include "argument_parser.h"
 
 #include "command_registry.h"
+#include "system_paths.h"
 
+#include <charconv>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -12,6 +14,20 @@ namespace cec_control {
 namespace {
 
 constexpr std::string_view kSocketPathPrefix = "--socket-path=";
+constexpr std::string_view kAdapterPrefix    = "--adapter=";
+constexpr std::string_view kNoWaitFlag       = "--no-wait";
+
+constexpr std::string_view kHostPrefix      = "--host=";
+constexpr std::string_view kHostsPrefix     = "--hosts=";
+constexpr std::string_view kTokenFilePrefix = "--token-file=";
+constexpr std::string_view kTimeoutPrefix   = "--timeout=";
+
+/** Longest --timeout= a fleet run takes, in milliseconds. */
+constexpr uint32_t kMaxFleetTimeoutMs = 600000;
+
+bool hasPrefix(std::string_view arg, std::string_view prefix) noexcept {
+    return arg.size() >= prefix.size() && arg.substr(0, prefix.size()) == prefix;
+}
 
 bool isHelpFlag(std::string_view arg) noexcept {
     return arg == "--help" || arg == "-h";
@@ -39,6 +55,10 @@ Action parseDaemonOptions(const std::vector<std::string_view>& args) {
             out.verbose = true;
             continue;
         }
+        if (arg == "--simulate") {
+            out.simulate = true;
+            continue;
+        }
         if (arg == "--log" || arg == "-l") {
             if (i + 1 >= args.size()) {
                 return ParseError{"Error: " + std::string(arg) + " requires a file path"};
@@ -78,17 +98,44 @@ Action parseDaemonOptions(const std::vector<std::string_view>& args) {
 }
 
 /**
- * Strip --socket-path=VALUE flags from @p args, populating @p socketPath. Any
- * occurrence with an empty value or a duplicate definition is a hard error;
- * remaining tokens are returned unchanged for the per-command parser.
+ * True for commands whose reply is the output: the queries, stats, a
+ * trace dump and a subscription. --no-wait would throw that reply away,
+ * so it refuses them.
+ */
+bool replyIsOutput(const Message& command) noexcept {
+    switch (command.type) {
+        case MessageType::CMD_QUERY_STATUS:
+        case MessageType::CMD_QUERY_DEVICES:
+        case MessageType::CMD_QUERY_ACTIVE_SOURCE:
+        case MessageType::CMD_STATS:
+        case MessageType::CMD_SUBSCRIBE:
+            return true;
+        case MessageType::CMD_TRACE:
+            return !command.data.empty() &&
+                   command.data[0] == static_cast<uint8_t>(TraceOp::Dump);
+        default:
+            return false;
+    }
+}
+
+/**
+ * Strip --socket-path=VALUE, --adapter=NAME and --no-wait flags from
+ * @p args, populating @p socketPath, @p adapter and @p noWait. Any
+ * occurrence with an empty or invalid value or a duplicate definition is
+ * a hard error; remaining tokens are returned unchanged for the
+ * per-command parser.
  */
 std::variant<std::vector<std::string_view>, ParseError>
 extractClientFlags(const std::vector<std::string_view>& args,
-                   std::string& socketPath) {
+                   std::string& socketPath, AdapterSelector& adapter, bool& noWait) {
     std::vector<std::string_view> positional;
     positional.reserve(args.size());
 
     for (const std::string_view arg : args) {
+        if (arg == kNoWaitFlag) {
+            noWait = true;
+            continue;
+        }
         if (arg.size() >= kSocketPathPrefix.size() &&
             arg.substr(0, kSocketPathPrefix.size()) == kSocketPathPrefix) {
             const std::string_view value = arg.substr(kSocketPathPrefix.size());
@@ -101,6 +148,18 @@ extractClientFlags(const std::vector<std::string_view>& args,
             socketPath.assign(value);
             continue;
         }
+        if (arg.size() >= kAdapterPrefix.size() &&
+            arg.substr(0, kAdapterPrefix.size()) == kAdapterPrefix) {
+            if (!adapter.empty()) {
+                return ParseError{"Error: --adapter= specified multiple times"};
+            }
+            if (!adapter.assign(arg.substr(kAdapterPrefix.size()))) {
+                return ParseError{"Error: --adapter= requires an [Adapter.NAME] name: "
+                                  "1-" + std::to_string(kMaxAdapterNameLength) +
+                                  " letters, digits, '-' or '_'"};
+            }
+            continue;
+        }
         positional.push_back(arg);
     }
     return positional;
@@ -109,7 +168,9 @@ extractClientFlags(const std::vector<std::string_view>& args,
 Action parseClientCommand(const CommandSpec& spec,
                            const std::vector<std::string_view>& argsAfterCommand) {
     std::string socketPath;
-    auto extracted = extractClientFlags(argsAfterCommand, socketPath);
+    AdapterSelector adapter;
+    bool noWait = false;
+    auto extracted = extractClientFlags(argsAfterCommand, socketPath, adapter, noWait);
     if (auto* err = std::get_if<ParseError>(&extracted)) {
         return std::move(*err);
     }
@@ -119,7 +180,124 @@ Action parseClientCommand(const CommandSpec& spec,
     if (!cmd) {
         return ParseError{"Error: " + err};
     }
-    return RunClient{std::move(*cmd), std::move(socketPath)};
+    if (noWait && replyIsOutput(*cmd)) {
+        return ParseError{"Error: --no-wait cannot be used with '" + std::string(spec.name) +
+                          "', whose reply is its output"};
+    }
+    if (!adapter.empty() && cmd->type == MessageType::CMD_SUBSCRIBE) {
+        return ParseError{"Error: --adapter= does not apply to 'subscribe'; events "
+                          "come from the default adapter"};
+    }
+    return RunClient{std::move(*cmd), std::move(socketPath), adapter, noWait};
+}
+
+/**
+ * Parse the options after `--interactive` / `--stdin`: only
+ * --socket-path= and --adapter= are meaningful, since the commands come from stdin.
+ */
+Action parseSessionOptions(const std::vector<std::string_view>& args) {
+    RunSession out;
+    bool noWait = false;
+    auto extracted = extractClientFlags(args, out.socketPathOverride, out.adapter, noWait);
+    if (auto* err = std::get_if<ParseError>(&extracted)) {
+        return std::move(*err);
+    }
+    if (noWait) {
+        return ParseError{"Error: --no-wait does not apply to a session, which "
+                          "already pipelines its commands"};
+    }
+    const auto& positional = std::get<std::vector<std::string_view>>(extracted);
+    if (!positional.empty()) {
+        return ParseError{"Error: session mode reads commands from stdin (got '" +
+                          std::string(positional.front()) + "')"};
+    }
+    return out;
+}
+
+/**
+ * Parse the argument after `flight-dump`: none for the running
+ * daemon's recording, `previous` for the one it replaced, or a path.
+ */
+Action parseFlightDumpOptions(const std::vector<std::string_view>& args) {
+    if (args.size() > 1) {
+        return ParseError{"Error: flight-dump takes at most one argument: "
+                          "previous or a recording's path"};
+    }
+    RunFlightDump out;
+    out.path = SystemPaths::getFlightRecorderPath();
+    if (args.empty()) return out;
+    if (args[0] == "previous") {
+        out.path += ".1";
+    } else {
+        out.path.assign(args[0]);
+    }
+    return out;
+}
+
+/**
+ * Parse what follows `fleet`: its own --host=, --hosts=, --token-file=
+ * and --timeout= options, then the command as on the command line.
+ * Commands whose reply is their output are refused, since the run
+ * reports only each host's outcome.
+ */
+Action parseFleetOptions(const std::vector<std::string_view>& args) {
+    std::vector<std::string> hosts;
+    std::string hostsFile;
+    std::string tokenFile;
+    uint32_t timeoutMs = 0;
+    std::size_t i = 0;
+    for (; i < args.size() && hasPrefix(args[i], "--"); ++i) {
+        const std::string_view arg = args[i];
+        if (hasPrefix(arg, kHostPrefix)) {
+            const std::string_view value = arg.substr(kHostPrefix.size());
+            if (value.empty()) return ParseError{"Error: --host= requires HOST:PORT"};
+            hosts.emplace_back(value);
+        } else if (hasPrefix(arg, kHostsPrefix)) {
+            const std::string_view value = arg.substr(kHostsPrefix.size());
+            if (value.empty() || !hostsFile.empty()) {
+                return ParseError{"Error: --hosts= requires a file, and only one"};
+            }
+            hostsFile.assign(value);
+        } else if (hasPrefix(arg, kTokenFilePrefix)) {
+            const std::string_view value = arg.substr(kTokenFilePrefix.size());
+            if (value.empty() || !tokenFile.empty()) {
+                return ParseError{"Error: --token-file= requires a file, and only one"};
+            }
+            tokenFile.assign(value);
+        } else if (hasPrefix(arg, kTimeoutPrefix)) {
+            const std::string_view value = arg.substr(kTimeoutPrefix.size());
+            uint32_t ms = 0;
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), ms);
+            if (value.empty() || ec != std::errc{} || end != value.data() + value.size() ||
+                ms == 0 || ms > kMaxFleetTimeoutMs) {
+                return ParseError{"Error: --timeout= takes milliseconds, 1 to " +
+                                  std::to_string(kMaxFleetTimeoutMs)};
+            }
+            timeoutMs = ms;
+        } else {
+            return ParseError{"Error: unknown fleet option: " + std::string(arg)};
+        }
+    }
+
+    if (tokenFile.empty()) {
+        return ParseError{"Error: fleet requires --token-file="};
+    }
+    if (hosts.empty() && hostsFile.empty()) {
+        return ParseError{"Error: fleet requires --host= or --hosts="};
+    }
+    auto parsed = ArgumentParser::parseCommand(
+        std::vector<std::string_view>(args.begin() + static_cast<std::ptrdiff_t>(i), args.end()));
+    if (auto* err = std::get_if<ParseError>(&parsed)) {
+        return std::move(*err);
+    }
+    RunFleet out{std::move(std::get<Message>(parsed)), std::move(hosts),
+                 std::move(hostsFile), std::move(tokenFile)};
+    if (timeoutMs != 0) out.timeoutMs = timeoutMs;
+    if (replyIsOutput(out.command)) {
+        return ParseError{"Error: fleet reports only each host's outcome, so it does not "
+                          "run commands whose reply is their output"};
+    }
+    return out;
 }
 
 /**
@@ -159,6 +337,21 @@ Action ArgumentParser::parse(int argc, char* const argv[]) {
             std::vector<std::string_view>(args.begin() + 1, args.end()));
     }
 
+    if (first == "flight-dump") {
+        return parseFlightDumpOptions(
+            std::vector<std::string_view>(args.begin() + 1, args.end()));
+    }
+
+    if (first == "fleet") {
+        return parseFleetOptions(
+            std::vector<std::string_view>(args.begin() + 1, args.end()));
+    }
+
+    if (first == "--interactive" || first == "--stdin") {
+        return parseSessionOptions(
+            std::vector<std::string_view>(args.begin() + 1, args.end()));
+    }
+
     if (isHelpFlag(first)) {
         if (args.size() > 1) {
             return ParseError{"Error: unexpected argument after " + std::string(first) +
@@ -176,4 +369,26 @@ Action ArgumentParser::parse(int argc, char* const argv[]) {
                       "'\nRun '" + std::string(argv[0]) + " help' for usage."};
 }
 
+Action ArgumentParser::parseDaemon(int argc, char* const argv[]) {
+    return parseDaemonOptions(sliceArgs(argc, argv));
+}
+
+std::variant<ParseError, Message>
+ArgumentParser::parseCommand(const std::vector<std::string_view>& args) {
+    if (args.empty()) {
+        return ParseError{"Error: missing command"};
+    }
+    const CommandSpec* spec = findByName(args.front());
+    if (spec == nullptr) {
+        return ParseError{"Error: unknown command: '" + std::string(args.front()) + "'"};
+    }
+
+    std::string err;
+    auto cmd = spec->parse(std::vector<std::string_view>(args.begin() + 1, args.end()), err);
+    if (!cmd) {
+        return ParseError{"Error: " + err};
+    }
+    return std::move(*cmd);
+}
+
 } // namespace cec_control
@@ -3,7 +3,9 @@
 #include "messages.h"
 
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
 namespace cec_control {
 
@@ -28,11 +30,48 @@ struct ShowHelp {
  * Run a single client command against the daemon and exit. @c command is the
  * fully-built wire message; @c socketPathOverride is empty when the caller
  * did not pass --socket-path= (the SocketClient then resolves the default
- * via SystemPaths).
+ * via SystemPaths). @c adapter is the --adapter=NAME the command is for,
+ * empty for the daemon's default adapter. With @c noWait (`--no-wait`) the
+ * client exits as soon as the request is sent, without its reply.
  */
 struct RunClient {
-    Message     command;
-    std::string socketPathOverride;
+    Message         command;
+    std::string     socketPathOverride;
+    AdapterSelector adapter;
+    bool            noWait = false;
+};
+
+/**
+ * Read client commands from stdin, one per line, and stream them to the
+ * daemon over a single connection (`--interactive` / `--stdin`).
+ * @c socketPathOverride and @c adapter as for @c RunClient.
+ */
+struct RunSession {
+    std::string     socketPathOverride;
+    AdapterSelector adapter;
+};
+
+/**
+ * Decode the daemon's flight recorder at @c path (`flight-dump`); read
+ * from the file, so no daemon need be running. The parser resolves the
+ * default path.
+ */
+struct RunFlightDump {
+    std::string path;
+};
+
+/**
+ * Send @c command to every daemon in a fleet over their network
+ * endpoints (`fleet`); see @c FleetClient. @c hosts are the --host=
+ * values, @c hostsFile the --hosts= file (empty if none), which the
+ * runner reads; @c tokenFile holds the endpoints' shared token.
+ */
+struct RunFleet {
+    Message                  command;
+    std::vector<std::string> hosts;
+    std::string              hostsFile;
+    std::string              tokenFile;
+    uint32_t                 timeoutMs = 10000;
 };
 
 /**
@@ -44,7 +83,8 @@ struct RunClient {
  * there is no option to control that here.
  */
 struct RunDaemon {
-    bool        verbose = false;
+    bool        verbose  = false;
+    bool        simulate = false;  ///< Drive a simulated bus instead of libcec.
     std::string logFile;
     std::string configFile;
 };
@@ -52,10 +92,11 @@ struct RunDaemon {
 /**
  * Result of parsing argv. Exhaustive: every successful or unsuccessful path
  * lands in exactly one of these alternatives. main() dispatches via
- * std::visit, which makes the four control-flow branches an exhaustive
- * match the compiler can check.
+ * std::visit, which makes the control-flow branches an exhaustive match
+ * the compiler can check.
  */
-using Action = std::variant<ParseError, ShowHelp, RunClient, RunDaemon>;
+using Action = std::variant<ParseError, ShowHelp, RunClient, RunSession, RunFlightDump,
+                            RunFleet, RunDaemon>;
 
 class ArgumentParser {
 public:
@@ -64,6 +105,21 @@ public:
      * ignored (the program name belongs to the caller, not the parser).
      */
     static Action parse(int argc, char* const argv[]);
+
+    /**
+     * Parse the daemon executable's argv[1..argc): the options that
+     * follow `cec-control daemon`. Yields a RunDaemon, the daemon's
+     * ShowHelp, or a ParseError.
+     */
+    static Action parseDaemon(int argc, char* const argv[]);
+
+    /**
+     * Parse one client command, name first (e.g. {"power", "on", "0"}),
+     * into its wire message. Used for the lines of a session, where
+     * client flags do not apply.
+     */
+    static std::variant<ParseError, Message>
+    parseCommand(const std::vector<std::string_view>& args);
 };
 
 } // namespace cec_control
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <time.h>
+
+#include <chrono>
+
+namespace cec_control {
+
+/**
+ * A @c std::chrono clock over @c CLOCK_BOOTTIME: monotonic like
+ * @c steady_clock, but it keeps counting while the system is
+ * suspended. For ages that must include a suspend, such as how long a
+ * command parked across one has been waiting.
+ */
+struct BootClock {
+    using duration   = std::chrono::nanoseconds;
+    using rep        = duration::rep;
+    using period     = duration::period;
+    using time_point = std::chrono::time_point<BootClock>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        timespec ts{};
+        ::clock_gettime(CLOCK_BOOTTIME, &ts);
+        return time_point(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+    }
+};
+
+} // namespace cec_control
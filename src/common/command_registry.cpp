@@ -1,9 +1,11 @@
 #include "command_registry.h"
 
 #include "key_codes.h"
+#include "static_index.h"
 
 #include <algorithm>
 #include <string>
+#include <utility>
 
 namespace cec_control {
 
@@ -66,8 +68,77 @@ bool requireNoArgs(const std::vector<std::string_view>& args,
     return false;
 }
 
+/**
+ * The key named @p name, or nullptr with the error in @p err. The
+ * table is too long to list in an error line, so it points at help.
+ */
+const KeySpec* lookupKey(std::string_view name, std::string& err) {
+    const KeySpec* spec = findKeyByName(name);
+    if (spec == nullptr) {
+        err = "Invalid key name: '" + std::string(name) +
+              "' (see 'cec-control help client' for KEY NAMES)";
+    }
+    return spec;
+}
+
+/**
+ * `NAME [DEVICE_ID]` shared by @c key and @c hold: NAME is required,
+ * DEVICE_ID defaults to 0 (TV) when omitted.
+ */
+std::optional<Message> parseKeyArgs(const std::vector<std::string_view>& args,
+                                     const char* command, MessageType type,
+                                     std::string& err) {
+    if (args.empty() || args.size() > 2) {
+        err = std::string(command) + " requires 1 or 2 arguments: NAME [DEVICE_ID]";
+        return std::nullopt;
+    }
+    const KeySpec* spec = lookupKey(args[0], err);
+    if (spec == nullptr) return std::nullopt;
+    uint8_t id = 0;
+    if (args.size() == 2 && !parseDeviceId(args[1], id, err)) {
+        return std::nullopt;
+    }
+    return Message(type, id, {spec->code});
+}
+
+/** One frame byte written in hex, with or without a leading "0x". */
+bool parseHexByte(std::string_view in, const char* what, uint8_t& out, std::string& err) {
+    std::string_view digits = in;
+    if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+        digits.remove_prefix(2);
+    }
+    const bool hex = !digits.empty() && digits.size() <= 2 &&
+                     std::all_of(digits.begin(), digits.end(), [](char c) {
+                         return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+                                (c >= 'A' && c <= 'F');
+                     });
+    if (!hex) {
+        err = std::string("Invalid ") + what + ": '" + std::string(in) +
+              "' (expected a hex byte such as 8c)";
+        return false;
+    }
+    out = static_cast<uint8_t>(std::stoi(std::string(digits), nullptr, 16));
+    return true;
+}
+
+} // namespace
+
+namespace command_parsers {
+
 std::optional<Message> parseVolume(const std::vector<std::string_view>& args,
                                     std::string& err) {
+    if (!args.empty() && args[0] == "set") {
+        if (!requireArity(args, 3, "volume set", "set LEVEL DEVICE_ID", err)) {
+            return std::nullopt;
+        }
+        uint8_t level = 0;
+        if (!parseBoundedUint8(args[1], kMaxVolumeLevel, "volume level", level, err)) {
+            return std::nullopt;
+        }
+        uint8_t id = 0;
+        if (!parseDeviceId(args[2], id, err)) return std::nullopt;
+        return Message(MessageType::CMD_VOLUME_SET, id, {level});
+    }
     if (!requireArity(args, 2, "volume", "(up|down|mute) DEVICE_ID", err)) {
         return std::nullopt;
     }
@@ -77,7 +148,7 @@ std::optional<Message> parseVolume(const std::vector<std::string_view>& args,
     else if (args[0] == "mute") type = MessageType::CMD_VOLUME_MUTE;
     else {
         err = "Invalid volume action: '" + std::string(args[0]) +
-              "' (expected up|down|mute)";
+              "' (expected up|down|mute|set)";
         return std::nullopt;
     }
     uint8_t id = 0;
@@ -85,9 +156,16 @@ std::optional<Message> parseVolume(const std::vector<std::string_view>& args,
     return Message(type, id);
 }
 
+/**
+ * `(on|off) DEVICE_ID...` or `(on|off) all`. One device is a plain
+ * deviceId; several become a device set sent as one command. `off all`
+ * is the broadcast <Standby>; CEC has no broadcast power-on, so
+ * `on all` is refused.
+ */
 std::optional<Message> parsePower(const std::vector<std::string_view>& args,
                                    std::string& err) {
-    if (!requireArity(args, 2, "power", "(on|off) DEVICE_ID", err)) {
+    if (args.size() < 2) {
+        err = "power requires at least 2 argument(s): (on|off) DEVICE_ID...|all";
         return std::nullopt;
     }
     MessageType type;
@@ -98,9 +176,33 @@ std::optional<Message> parsePower(const std::vector<std::string_view>& args,
               "' (expected on|off)";
         return std::nullopt;
     }
-    uint8_t id = 0;
-    if (!parseDeviceId(args[1], id, err)) return std::nullopt;
-    return Message(type, id);
+    if (args[1] == "all") {
+        if (args.size() != 2) {
+            err = "power " + std::string(args[0]) + " all takes no device IDs";
+            return std::nullopt;
+        }
+        if (type == MessageType::CMD_POWER_ON) {
+            err = "CEC cannot broadcast power on; list the device IDs instead";
+            return std::nullopt;
+        }
+        return Message(type, kBroadcastAddress);
+    }
+    if (args.size() == 2) {
+        uint8_t id = 0;
+        if (!parseDeviceId(args[1], id, err)) return std::nullopt;
+        return Message(type, id);
+    }
+    DeviceSet devices = 0;
+    uint8_t first = 0;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        uint8_t id = 0;
+        if (!parseBoundedUint8(args[i], kMaxLogicalAddress - 1, "device ID", id, err)) {
+            return std::nullopt;
+        }
+        if (devices == 0) first = id;
+        devices = static_cast<DeviceSet>(devices | (1u << id));
+    }
+    return Message(type, first, encodeDeviceSet(devices));
 }
 
 std::optional<Message> parseSource(const std::vector<std::string_view>& args,
@@ -119,24 +221,64 @@ std::optional<Message> parseSource(const std::vector<std::string_view>& args,
 
 std::optional<Message> parseKey(const std::vector<std::string_view>& args,
                                  std::string& err) {
-    // One-or-two arity: NAME is required, DEVICE_ID defaults to 0 (TV)
-    // when omitted. Inline check rather than a new requireArityRange
-    // helper — this is the only variable-arity command today.
-    if (args.empty() || args.size() > 2) {
-        err = "key requires 1 or 2 arguments: NAME [DEVICE_ID]";
+    return parseKeyArgs(args, "key", MessageType::CMD_KEY, err);
+}
+
+std::optional<Message> parseHold(const std::vector<std::string_view>& args,
+                                  std::string& err) {
+    return parseKeyArgs(args, "hold", MessageType::CMD_KEY_DOWN, err);
+}
+
+std::optional<Message> parseRelease(const std::vector<std::string_view>& args,
+                                     std::string& err) {
+    if (args.size() > 1) {
+        err = "release takes at most 1 argument: [DEVICE_ID]";
         return std::nullopt;
     }
-    const KeySpec* spec = findKeyByName(args[0]);
-    if (spec == nullptr) {
-        err = "Invalid key name: '" + std::string(args[0]) +
-              "' (expected " + formatKeyNamesList("|") + ")";
+    uint8_t id = 0;
+    if (args.size() == 1 && !parseDeviceId(args[0], id, err)) {
+        return std::nullopt;
+    }
+    return Message(MessageType::CMD_KEY_UP, id);
+}
+
+std::optional<Message> parseKeys(const std::vector<std::string_view>& args,
+                                  std::string& err) {
+    // The device goes first: the number keys are named "0".."9", so a
+    // trailing DEVICE_ID could not be told apart from one of them.
+    if (args.size() < 2 || args.size() > 1 + kMaxKeySequence) {
+        err = "keys requires a device and 1 to " + std::to_string(kMaxKeySequence) +
+              " key names: DEVICE_ID NAME...";
         return std::nullopt;
     }
     uint8_t id = 0;
-    if (args.size() == 2 && !parseDeviceId(args[1], id, err)) {
+    if (!parseDeviceId(args[0], id, err)) return std::nullopt;
+    Message message(MessageType::CMD_KEY_SEQUENCE, id);
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        const KeySpec* spec = lookupKey(args[i], err);
+        if (spec == nullptr) return std::nullopt;
+        message.data.push_back(spec->code);
+    }
+    return message;
+}
+
+std::optional<Message> parseRaw(const std::vector<std::string_view>& args,
+                                 std::string& err) {
+    if (args.size() < 2 || args.size() > 2 + kMaxRawParameters) {
+        err = "raw requires a destination, an opcode and at most " +
+              std::to_string(kMaxRawParameters) + " parameters: DEVICE_ID OPCODE [PARAM...]";
         return std::nullopt;
     }
-    return Message(MessageType::CMD_KEY, id, {spec->code});
+    RawFrame frame;
+    if (!parseDeviceId(args[0], frame.destination, err)) return std::nullopt;
+    if (!parseHexByte(args[1], "opcode", frame.opcode, err)) return std::nullopt;
+    for (std::size_t i = 2; i < args.size(); ++i) {
+        if (!parseHexByte(args[i], "parameter", frame.parameters[frame.parameterCount], err)) {
+            return std::nullopt;
+        }
+        ++frame.parameterCount;
+    }
+    return Message(MessageType::CMD_RAW_TRANSMIT, frame.destination, encodeRawFrame(frame));
 }
 
 std::optional<Message> parseAutoStandby(const std::vector<std::string_view>& args,
@@ -155,6 +297,131 @@ std::optional<Message> parseAutoStandby(const std::vector<std::string_view>& arg
     return Message(MessageType::CMD_AUTO_STANDBY, 0, {flag});
 }
 
+std::optional<Message> parseBatch(const std::vector<std::string_view>& args,
+                                   std::string& err) {
+    // Sub-commands are separated by standalone "," tokens, each parsed
+    // by its own registry entry:
+    //   batch power on 0 , power on 5 , source 0 3
+    std::vector<Message> steps;
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i <= args.size(); ++i) {
+        if (i < args.size() && args[i] != ",") continue;
+        if (i == begin) {
+            err = "batch requires a command before and after each ','";
+            return std::nullopt;
+        }
+        const std::string_view name = args[begin];
+        const CommandSpec* spec = findByName(name);
+        if (spec == nullptr) {
+            err = "Unknown command in batch: '" + std::string(name) + "'";
+            return std::nullopt;
+        }
+        if (spec->type == MessageType::CMD_BATCH) {
+            err = "batch cannot be nested";
+            return std::nullopt;
+        }
+        const std::vector<std::string_view> stepArgs(args.begin() + begin + 1,
+                                                     args.begin() + i);
+        auto step = spec->parse(stepArgs, err);
+        if (!step) {
+            err = "batch step " + std::to_string(steps.size() + 1) + ": " + err;
+            return std::nullopt;
+        }
+        steps.push_back(std::move(*step));
+        begin = i + 1;
+    }
+    if (steps.size() > kMaxBatchSteps) {
+        err = "batch accepts at most " + std::to_string(kMaxBatchSteps) + " commands";
+        return std::nullopt;
+    }
+    auto payload = encodeBatch(steps);
+    if (!payload) {
+        err = "batch is too large for one message";
+        return std::nullopt;
+    }
+    return Message(MessageType::CMD_BATCH, 0, std::move(*payload));
+}
+
+std::optional<Message> parseScene(const std::vector<std::string_view>& args,
+                                   std::string& err) {
+    if (!requireArity(args, 1, "scene", "NAME", err)) {
+        return std::nullopt;
+    }
+    if (!isValidSceneName(args[0])) {
+        err = "Invalid scene name: '" + std::string(args[0]) + "'";
+        return std::nullopt;
+    }
+    return Message(MessageType::CMD_SCENE, 0,
+                   std::vector<uint8_t>(args[0].begin(), args[0].end()));
+}
+
+std::optional<Message> parseStatus(const std::vector<std::string_view>& args,
+                                    std::string& err) {
+    if (!requireArity(args, 1, "status", "DEVICE_ID", err)) {
+        return std::nullopt;
+    }
+    uint8_t id = 0;
+    if (!parseDeviceId(args[0], id, err)) return std::nullopt;
+    return Message(MessageType::CMD_QUERY_STATUS, id);
+}
+
+std::optional<Message> parseDevices(const std::vector<std::string_view>& args,
+                                     std::string& err) {
+    if (!requireNoArgs(args, "devices", err)) return std::nullopt;
+    return Message(MessageType::CMD_QUERY_DEVICES);
+}
+
+std::optional<Message> parseActiveSource(const std::vector<std::string_view>& args,
+                                          std::string& err) {
+    if (!requireNoArgs(args, "active-source", err)) return std::nullopt;
+    return Message(MessageType::CMD_QUERY_ACTIVE_SOURCE);
+}
+
+std::optional<Message> parseStats(const std::vector<std::string_view>& args,
+                                   std::string& err) {
+    if (!requireNoArgs(args, "stats", err)) return std::nullopt;
+    return Message(MessageType::CMD_STATS);
+}
+
+std::optional<Message> parseTrace(const std::vector<std::string_view>& args,
+                                   std::string& err) {
+    if (!requireArity(args, 1, "trace", "(on|off|dump)", err)) {
+        return std::nullopt;
+    }
+    TraceOp op;
+    if      (args[0] == "on")   op = TraceOp::On;
+    else if (args[0] == "off")  op = TraceOp::Off;
+    else if (args[0] == "dump") op = TraceOp::Dump;
+    else {
+        err = "Invalid trace operation: '" + std::string(args[0]) +
+              "' (expected on|off|dump)";
+        return std::nullopt;
+    }
+    // A dump starts at chunk 0; the client walks the rest.
+    std::vector<uint8_t> payload{static_cast<uint8_t>(op)};
+    if (op == TraceOp::Dump) payload.insert(payload.end(), {0, 0});
+    return Message(MessageType::CMD_TRACE, 0, std::move(payload));
+}
+
+std::optional<Message> parseSubscribe(const std::vector<std::string_view>& args,
+                                       std::string& err) {
+    if (args.empty()) {
+        return Message(MessageType::CMD_SUBSCRIBE, 0, {kAllBusEvents});
+    }
+    BusEventMask mask = 0;
+    for (const std::string_view arg : args) {
+        const auto kind = findBusEventByName(arg);
+        if (!kind) {
+            err = "Unknown event: '" + std::string(arg) +
+                  "' (expected tv-standby, tv-power, active-source, "
+                  "host-activated, host-deactivated or raw)";
+            return std::nullopt;
+        }
+        mask |= busEventBit(*kind);
+    }
+    return Message(MessageType::CMD_SUBSCRIBE, 0, {mask});
+}
+
 std::optional<Message> parseRestart(const std::vector<std::string_view>& args,
                                      std::string& err) {
     if (!requireNoArgs(args, "restart", err)) return std::nullopt;
@@ -173,60 +440,60 @@ std::optional<Message> parseResume(const std::vector<std::string_view>& args,
     return Message(MessageType::CMD_RESUME);
 }
 
-} // namespace
+} // namespace command_parsers
+
+namespace {
+
+constexpr std::string_view commandName(const CommandSpec& spec) noexcept { return spec.name; }
 
-// The size of this array is reflected in command_registry.h. If you add an
-// entry, bump the std::array<CommandSpec, N> declaration there.
-const std::array<CommandSpec, 8> kCommands = {{
-    {MessageType::CMD_POWER_ON,
-     {MessageType::CMD_POWER_ON, MessageType::CMD_POWER_OFF},
-     "power", "(on|off) DEVICE_ID", "Power a device on or off",
-     parsePower},
-    {MessageType::CMD_VOLUME_UP,
-     {MessageType::CMD_VOLUME_UP, MessageType::CMD_VOLUME_DOWN,
-      MessageType::CMD_VOLUME_MUTE},
-     "volume", "(up|down|mute) DEVICE_ID",
-     "Control volume on the audio system",
-     parseVolume},
-    {MessageType::CMD_CHANGE_SOURCE,
-     {MessageType::CMD_CHANGE_SOURCE},
-     "source", "DEVICE_ID SOURCE_ID", "Change the active input source",
-     parseSource},
-    {MessageType::CMD_KEY,
-     {MessageType::CMD_KEY},
-     "key", "NAME [DEVICE_ID]", "Send a CEC remote-control key press",
-     parseKey},
-    {MessageType::CMD_AUTO_STANDBY,
-     {MessageType::CMD_AUTO_STANDBY},
-     "auto-standby", "(on|off)", "Suspend this PC when the TV powers off",
-     parseAutoStandby},
-    {MessageType::CMD_RESTART_ADAPTER,
-     {MessageType::CMD_RESTART_ADAPTER},
-     "restart", "", "Restart the CEC adapter",
-     parseRestart},
-    {MessageType::CMD_SUSPEND,
-     {MessageType::CMD_SUSPEND},
-     "suspend", "", "Prepare for system sleep (run pre-sleep CEC actions)",
-     parseSuspend},
-    {MessageType::CMD_RESUME,
-     {MessageType::CMD_RESUME},
-     "resume", "", "Restore after system wake (run post-wake CEC actions)",
-     parseResume},
-}};
+constexpr auto kByName = static_index::buildNameIndex<64>(kCommands, commandName);
+
+constexpr static_index::ByteIndex buildTypeIndex() noexcept {
+    auto index = static_index::emptyByteIndex();
+    for (std::size_t row = 0; row < kCommands.size(); ++row) {
+        for (const MessageType type : kCommands[row].types) {
+            index[static_cast<uint8_t>(type)] = static_cast<uint8_t>(row);
+        }
+    }
+    return index;
+}
+
+constexpr auto kByType = buildTypeIndex();
+
+/**
+ * Each name and each covered type belongs to exactly one row, and
+ * every row covers its own @c type. A repeat would leave the later
+ * row unreachable by that key.
+ */
+constexpr bool commandsAreDistinct() noexcept {
+    std::size_t covered = 0;
+    for (std::size_t row = 0; row < kCommands.size(); ++row) {
+        const CommandSpec& spec = kCommands[row];
+        if (kByName.find(kCommands, spec.name, commandName) != row) return false;
+        if (kByType[static_cast<uint8_t>(spec.type)] != row) return false;
+        for (const MessageType type : spec.types) {
+            if (kByType[static_cast<uint8_t>(type)] != row) return false;
+        }
+        covered += spec.types.size();
+    }
+    std::size_t mapped = 0;
+    for (const uint8_t row : kByType) mapped += row != static_index::kNone;
+    return mapped == covered;
+}
+static_assert(commandsAreDistinct(), "kCommands repeats a name or a MessageType");
+
+const CommandSpec* rowOrNull(uint8_t row) noexcept {
+    return row == static_index::kNone ? nullptr : &kCommands[row];
+}
+
+} // namespace
 
 const CommandSpec* findByName(std::string_view name) noexcept {
-    const auto it = std::find_if(kCommands.begin(), kCommands.end(),
-        [name](const CommandSpec& c) { return c.name == name; });
-    return it == kCommands.end() ? nullptr : &*it;
+    return rowOrNull(kByName.find(kCommands, name, commandName));
 }
 
 const CommandSpec* findByType(MessageType type) noexcept {
-    const auto it = std::find_if(kCommands.begin(), kCommands.end(),
-        [type](const CommandSpec& c) {
-            return std::find(c.types.begin(), c.types.end(), type)
-                   != c.types.end();
-        });
-    return it == kCommands.end() ? nullptr : &*it;
+    return rowOrNull(kByType[static_cast<uint8_t>(type)]);
 }
 
 } // namespace cec_control
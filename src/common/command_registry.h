@@ -59,16 +59,157 @@ struct CommandSpec {
     ParseFn          parse;       // nonnull
 };
 
+/**
+ * The per-command @c CommandSpec::parse functions, defined in
+ * @c command_registry.cpp. Declared here only so @c kCommands can be a
+ * constant expression; callers go through the table.
+ */
+namespace command_parsers {
+
+std::optional<Message> parsePower(const std::vector<std::string_view>& args,
+                                  std::string& err);
+std::optional<Message> parseVolume(const std::vector<std::string_view>& args,
+                                   std::string& err);
+std::optional<Message> parseSource(const std::vector<std::string_view>& args,
+                                   std::string& err);
+std::optional<Message> parseKey(const std::vector<std::string_view>& args,
+                                std::string& err);
+std::optional<Message> parseHold(const std::vector<std::string_view>& args,
+                                 std::string& err);
+std::optional<Message> parseRelease(const std::vector<std::string_view>& args,
+                                    std::string& err);
+std::optional<Message> parseKeys(const std::vector<std::string_view>& args,
+                                 std::string& err);
+std::optional<Message> parseRaw(const std::vector<std::string_view>& args,
+                                std::string& err);
+std::optional<Message> parseBatch(const std::vector<std::string_view>& args,
+                                  std::string& err);
+std::optional<Message> parseScene(const std::vector<std::string_view>& args,
+                                  std::string& err);
+std::optional<Message> parseStatus(const std::vector<std::string_view>& args,
+                                   std::string& err);
+std::optional<Message> parseDevices(const std::vector<std::string_view>& args,
+                                    std::string& err);
+std::optional<Message> parseActiveSource(const std::vector<std::string_view>& args,
+                                         std::string& err);
+std::optional<Message> parseStats(const std::vector<std::string_view>& args,
+                                  std::string& err);
+std::optional<Message> parseTrace(const std::vector<std::string_view>& args,
+                                  std::string& err);
+std::optional<Message> parseSubscribe(const std::vector<std::string_view>& args,
+                                      std::string& err);
+std::optional<Message> parseAutoStandby(const std::vector<std::string_view>& args,
+                                        std::string& err);
+std::optional<Message> parseRestart(const std::vector<std::string_view>& args,
+                                    std::string& err);
+std::optional<Message> parseSuspend(const std::vector<std::string_view>& args,
+                                    std::string& err);
+std::optional<Message> parseResume(const std::vector<std::string_view>& args,
+                                   std::string& err);
+
+} // namespace command_parsers
+
 /**
  * Authoritative command table. Order is the order help text renders in, and
  * is also the order new readers will encounter. Keep related commands grouped.
+ *
+ * Defined here, as a constant expression, so the daemon's dispatch table
+ * can be checked against it with @c static_assert. Bump the size
+ * literal when adding a row.
  */
-extern const std::array<CommandSpec, 8> kCommands;
+inline constexpr std::array<CommandSpec, 20> kCommands = {{
+    {MessageType::CMD_POWER_ON,
+     {MessageType::CMD_POWER_ON, MessageType::CMD_POWER_OFF},
+     "power", "(on|off) DEVICE_ID...|all", "Power devices on or off",
+     command_parsers::parsePower},
+    {MessageType::CMD_VOLUME_UP,
+     {MessageType::CMD_VOLUME_UP, MessageType::CMD_VOLUME_DOWN,
+      MessageType::CMD_VOLUME_MUTE, MessageType::CMD_VOLUME_SET},
+     "volume", "(up|down|mute|set N) DEVICE_ID",
+     "Control volume on the audio system",
+     command_parsers::parseVolume},
+    {MessageType::CMD_CHANGE_SOURCE,
+     {MessageType::CMD_CHANGE_SOURCE},
+     "source", "DEVICE_ID SOURCE_ID", "Change the active input source",
+     command_parsers::parseSource},
+    {MessageType::CMD_KEY,
+     {MessageType::CMD_KEY},
+     "key", "NAME [DEVICE_ID]", "Send a CEC remote-control key press",
+     command_parsers::parseKey},
+    {MessageType::CMD_KEY_DOWN,
+     {MessageType::CMD_KEY_DOWN},
+     "hold", "NAME [DEVICE_ID]", "Press a key and keep it held until release",
+     command_parsers::parseHold},
+    {MessageType::CMD_KEY_UP,
+     {MessageType::CMD_KEY_UP},
+     "release", "[DEVICE_ID]", "Release the key being held",
+     command_parsers::parseRelease},
+    {MessageType::CMD_KEY_SEQUENCE,
+     {MessageType::CMD_KEY_SEQUENCE},
+     "keys", "DEVICE_ID NAME...", "Press several keys in turn, as for menu navigation",
+     command_parsers::parseKeys},
+    {MessageType::CMD_RAW_TRANSMIT,
+     {MessageType::CMD_RAW_TRANSMIT},
+     "raw", "DEVICE_ID OPCODE [PARAM...]",
+     "Send one CEC frame; bytes in hex, opcode allowed by RawOpcodes",
+     command_parsers::parseRaw},
+    {MessageType::CMD_BATCH,
+     {MessageType::CMD_BATCH},
+     "batch", "COMMAND [, COMMAND...]",
+     "Run several commands in order as one request",
+     command_parsers::parseBatch},
+    {MessageType::CMD_SCENE,
+     {MessageType::CMD_SCENE},
+     "scene", "NAME", "Run a scene defined in the daemon's configuration",
+     command_parsers::parseScene},
+    {MessageType::CMD_QUERY_STATUS,
+     {MessageType::CMD_QUERY_STATUS},
+     "status", "DEVICE_ID", "Show a device's power status, address and name",
+     command_parsers::parseStatus},
+    {MessageType::CMD_QUERY_DEVICES,
+     {MessageType::CMD_QUERY_DEVICES},
+     "devices", "", "List the devices present on the CEC bus",
+     command_parsers::parseDevices},
+    {MessageType::CMD_QUERY_ACTIVE_SOURCE,
+     {MessageType::CMD_QUERY_ACTIVE_SOURCE},
+     "active-source", "", "Show which device is the active source",
+     command_parsers::parseActiveSource},
+    {MessageType::CMD_STATS,
+     {MessageType::CMD_STATS},
+     "stats", "", "Show daemon performance counters and latencies",
+     command_parsers::parseStats},
+    {MessageType::CMD_TRACE,
+     {MessageType::CMD_TRACE},
+     "trace", "(on|off|dump)",
+     "Record request timings; dump writes Chrome trace JSON to stdout",
+     command_parsers::parseTrace},
+    {MessageType::CMD_SUBSCRIBE,
+     {MessageType::CMD_SUBSCRIBE},
+     "subscribe", "[EVENT...]",
+     "Print bus events as they happen (default: every kind)",
+     command_parsers::parseSubscribe},
+    {MessageType::CMD_AUTO_STANDBY,
+     {MessageType::CMD_AUTO_STANDBY},
+     "auto-standby", "(on|off)", "Suspend this PC when the TV powers off",
+     command_parsers::parseAutoStandby},
+    {MessageType::CMD_RESTART_ADAPTER,
+     {MessageType::CMD_RESTART_ADAPTER},
+     "restart", "", "Restart the CEC adapter",
+     command_parsers::parseRestart},
+    {MessageType::CMD_SUSPEND,
+     {MessageType::CMD_SUSPEND},
+     "suspend", "", "Prepare for system sleep (run pre-sleep CEC actions)",
+     command_parsers::parseSuspend},
+    {MessageType::CMD_RESUME,
+     {MessageType::CMD_RESUME},
+     "resume", "", "Restore after system wake (run post-wake CEC actions)",
+     command_parsers::parseResume},
+}};
 
-/** Linear lookup by canonical name. Returns nullptr if no match. */
+/** Hashed lookup by canonical name. Returns nullptr if no match. */
 const CommandSpec* findByName(std::string_view name) noexcept;
 
-/** Linear lookup by MessageType. Returns nullptr if @p type is not a command. */
+/** Direct lookup by MessageType. Returns nullptr if @p type is not a command. */
 const CommandSpec* findByType(MessageType type) noexcept;
 
 } // namespace cec_control
@@ -37,8 +37,10 @@ bool ConfigManager::load() {
     
     std::string line;
     std::string currentSection;
+    unsigned lineNumber = 0;
     
     while (std::getline(file, line)) {
+        ++lineNumber;
         // Trim whitespace from the beginning
         trim(line);
         
@@ -62,8 +64,16 @@ bool ConfigManager::load() {
             trim(key);
             trim(value);
             
-            // Store key-value in the current section
-            m_config[currentSection][key] = value;
+            // A repeated key overrides the earlier value in place.
+            auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                [&](const Entry& e) { return e.section == currentSection && e.key == key; });
+            if (it != m_entries.end()) {
+                it->value = std::move(value);
+                it->line  = lineNumber;
+            } else {
+                m_entries.push_back(Entry{currentSection, std::move(key), std::move(value),
+                                          lineNumber});
+            }
         }
     }
     
@@ -71,26 +81,18 @@ bool ConfigManager::load() {
     return true;
 }
 
-const ConfigManager::SectionContent&
-ConfigManager::section(const std::string& name) const noexcept {
-    static const SectionContent kEmpty;
-    auto it = m_config.find(name);
-    return it != m_config.end() ? it->second : kEmpty;
+const ConfigManager::Entry* ConfigManager::find(const std::string& section,
+                                                const std::string& key) const noexcept {
+    for (const auto& entry : m_entries) {
+        if (entry.section == section && entry.key == key) return &entry;
+    }
+    return nullptr;
 }
 
 std::string ConfigManager::getString(const std::string& section, const std::string& key,
                                     const std::string& defaultValue) const {
-    auto sectionIt = m_config.find(section);
-    if (sectionIt == m_config.end()) {
-        return defaultValue;
-    }
-    
-    auto keyIt = sectionIt->second.find(key);
-    if (keyIt == sectionIt->second.end()) {
-        return defaultValue;
-    }
-    
-    return keyIt->second;
+    const Entry* entry = find(section, key);
+    return entry != nullptr ? entry->value : defaultValue;
 }
 
 bool ConfigManager::getBool(const std::string& section, const std::string& key,
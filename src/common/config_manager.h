@@ -1,23 +1,31 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 namespace cec_control {
 
 /**
  * Loads and provides read access to a section/key INI-style configuration
  * file. A regular value type: construct with a path (empty string selects the
- * default from SystemPaths), call load(), then query via getString/getBool/
- * getInt. Non-copyable, non-movable — the expected lifetime is "local to
- * DaemonBootstrap::runDaemon, used to populate the option structs."
+ * default from SystemPaths), call load(), then walk @c entries or query via
+ * getString/getBool/getInt. Non-copyable, non-movable — the expected lifetime
+ * is "local to DaemonBootstrap::runDaemon, used to populate the option
+ * structs."
  */
 class ConfigManager {
 public:
-    /** A single section's parsed key-value map. */
-    using SectionContent = std::unordered_map<std::string, std::string>;
-    /** Full parsed file: section name → section content. */
-    using SectionMap     = std::unordered_map<std::string, SectionContent>;
+    /**
+     * One @c Key = Value line. A key given twice in one section keeps
+     * its first position and takes the later value and line, so each
+     * section/key pair appears once.
+     */
+    struct Entry {
+        std::string section;
+        std::string key;
+        std::string value;
+        unsigned    line = 0;
+    };
 
     /**
      * @param configPath Path to the configuration file. Empty selects the
@@ -47,26 +55,20 @@ public:
                int defaultValue = 0) const;
 
     /**
-     * Every section observed while parsing the file, keyed by name.
-     * Values are the parsed key-value maps. Intended for callers that
-     * want to iterate the file (e.g. validating against a known
-     * schema); prefer @c getString / @c getBool / @c getInt for
-     * named-key reads.
-     */
-    [[nodiscard]] const SectionMap& sections() const noexcept { return m_config; }
-
-    /**
-     * Section content for @p name, or a static empty map if the
-     * section was not present. Lets callers write a single allocation-
-     * free iteration without nullability bookkeeping.
+     * Every key of the file in the order first seen. The typed loader
+     * (@c loadAppConfig) makes one pass over this; the named getters
+     * suit a caller after a single value.
      */
-    [[nodiscard]] const SectionContent& section(const std::string& name) const noexcept;
+    [[nodiscard]] const std::vector<Entry>& entries() const noexcept { return m_entries; }
 
     const std::string& getConfigPath() const noexcept { return m_configPath; }
 
 private:
-    std::string  m_configPath;
-    SectionMap   m_config;
+    [[nodiscard]] const Entry* find(const std::string& section,
+                                    const std::string& key) const noexcept;
+
+    std::string        m_configPath;
+    std::vector<Entry> m_entries;
 
     static void trim(std::string& s);
 };
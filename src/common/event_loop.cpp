@@ -2,40 +2,129 @@
 #include "logger.h"
 
 #include <cassert>
+#include <chrono>
 #include <utility>
 
 namespace cec_control {
 
+EventLoop::EventLoop() : m_wheel(timerNow()) {
+    if (!m_wheelTimer.valid()) {
+        return;  // TimerSource already logged the failure.
+    }
+    const auto read = static_cast<uint32_t>(EventPoller::Event::READ);
+    m_timersValid = add(m_wheelTimer.fd(), read, [this](uint32_t) { onWheelTimer(); });
+    if (!m_timersValid) {
+        LOG_ERROR("EventLoop: failed to register the timer wheel's timerfd");
+    }
+}
+
 bool EventLoop::add(int fd, uint32_t events, Handler handler) {
     if (fd < 0 || !handler) {
         return false;
     }
-    if (m_handlers.find(fd) != m_handlers.end()) {
+    if (m_registrations.find(fd) != m_registrations.end()) {
         LOG_ERROR("EventLoop::add: fd ", fd, " already registered");
         return false;
     }
-    if (!m_poller.add(fd, events)) {
+    auto registration = std::make_unique<Registration>(Registration{fd, std::move(handler)});
+    if (!m_poller.add(fd, events, registration.get())) {
         return false;
     }
-    m_handlers.emplace(fd, std::move(handler));
+    m_registrations.emplace(fd, std::move(registration));
     return true;
 }
 
 bool EventLoop::modify(int fd, uint32_t events) {
-    if (m_handlers.find(fd) == m_handlers.end()) {
+    auto it = m_registrations.find(fd);
+    if (it == m_registrations.end()) {
         LOG_ERROR("EventLoop::modify: fd ", fd, " not registered");
         return false;
     }
-    return m_poller.modify(fd, events);
+    return m_poller.modify(fd, events, it->second.get());
 }
 
 void EventLoop::remove(int fd) {
-    if (m_handlers.erase(fd) == 0) {
+    auto it = m_registrations.find(fd);
+    if (it == m_registrations.end()) {
         return;  // Not registered; nothing to do.
     }
     // Best-effort: the fd was registered at least once, so remove from
     // the poller. ENOENT (already detached) is tolerated.
     (void)m_poller.remove(fd);
+    std::unique_ptr<Registration> registration = std::move(it->second);
+    m_registrations.erase(it);
+    if (m_dispatching) {
+        // Events for it may still be queued in m_ready, and it may be
+        // the handler running right now.
+        registration->live = false;
+        m_retired.push_back(std::move(registration));
+    }
+}
+
+void EventLoop::defer(Deferred fn) {
+    if (fn) m_deferred.push_back(std::move(fn));
+}
+
+void EventLoop::runDeferred() {
+    while (!m_deferred.empty()) {
+        m_running.swap(m_deferred);
+        for (auto& fn : m_running) fn();
+        m_running.clear();
+    }
+}
+
+EventLoop::TimerTick EventLoop::timerNow() noexcept {
+    return static_cast<TimerTick>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void EventLoop::scheduleTimer(TimerWheel::Node& node, TimerTick at) noexcept {
+    // Bring an idle wheel up to date first, so the new deadline is placed
+    // relative to the present rather than whenever the wheel last moved.
+    // A wheel with work already due is left for onWheelTimer to advance.
+    const TimerTick now = timerNow();
+    if (const auto next = m_wheel.nextEvent(); !next || *next > now) {
+        m_wheel.advance(now);
+    }
+    m_wheel.schedule(node, at);
+    reprogramWheelTimer();
+}
+
+void EventLoop::cancelTimer(TimerWheel::Node& node) noexcept {
+    // The timerfd is left as it is: if it was armed for this node, the
+    // wake finds nothing due and re-arms for whatever is next.
+    m_wheel.cancel(node);
+}
+
+void EventLoop::onWheelTimer() {
+    m_wheelTimer.consume();
+    m_programmedTick.reset();
+    m_wheel.advance(timerNow());
+    m_delivering = true;
+    m_wheel.deliver();
+    m_delivering = false;
+    reprogramWheelTimer();
+}
+
+void EventLoop::reprogramWheelTimer() noexcept {
+    if (!m_timersValid || m_delivering) return;
+    const auto next = m_wheel.nextEvent();
+    if (!next) {
+        if (m_programmedTick) {
+            m_wheelTimer.disarm();
+            m_programmedTick.reset();
+        }
+        return;
+    }
+    if (m_programmedTick && *m_programmedTick <= *next) return;
+    const TimerTick now = timerNow();
+    const auto delay = std::chrono::milliseconds(*next > now ? *next - now : 0);
+    if (!m_wheelTimer.armOnce(delay)) {
+        LOG_ERROR("EventLoop: failed to arm the timer wheel's timerfd");
+        return;
+    }
+    m_programmedTick = *next;
 }
 
 void EventLoop::run() {
@@ -47,27 +136,27 @@ void EventLoop::run() {
     m_ran = true;
 
     while (!m_stopRequested) {
-        auto events = m_poller.wait(-1);
-        if (!events) {
+        const int ready = m_poller.wait(m_ready.data(), m_ready.size(), -1);
+        if (ready < 0) {
             LOG_ERROR("EventLoop: poller failed; exiting");
             break;
         }
         if (m_stopRequested) break;
 
-        for (const auto& ev : *events) {
-            // Copy the handler out — if it removes itself from the map
-            // during the call, the underlying std::function would otherwise
-            // be destroyed mid-invocation.
-            auto it = m_handlers.find(ev.fd);
-            if (it == m_handlers.end()) {
-                // Handler may have been removed by an earlier dispatch in
-                // this same batch. Silently skip the stale event.
+        m_dispatching = true;
+        for (int i = 0; i < ready; ++i) {
+            auto* registration = static_cast<Registration*>(m_ready[i].tag);
+            if (!registration->live) {
+                // Removed by an earlier dispatch in this same batch.
+                // Silently skip the stale event.
                 continue;
             }
-            Handler handler = it->second;
-            handler(ev.events);
+            registration->handler(m_ready[i].events);
             if (m_stopRequested) break;
         }
+        m_dispatching = false;
+        m_retired.clear();
+        runDeferred();
     }
 }
 
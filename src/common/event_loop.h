@@ -1,10 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 #include "event_poller.h"
+#include "timer_source.h"
+#include "timer_wheel.h"
 
 namespace cec_control {
 
@@ -17,6 +24,18 @@ namespace cec_control {
  * handler or any main-thread context ends the loop at the next safe
  * point inside the dispatch batch.
  *
+ * Dispatch costs no lookup and no allocation: each fd's poller tag is
+ * the address of its registration, and the poller fills one array the
+ * loop owns. A registration removed mid-batch is kept until the batch
+ * ends, so an event already collected for it is recognised and skipped
+ * instead of reaching a freed handler — or a later one on a reused fd.
+ *
+ * Deadlines share one timerfd: every LoopTimer on the loop is a node in
+ * a TimerWheel, and the loop keeps its own timerfd programmed for the
+ * wheel's earliest event. Arming or cancelling a timer is therefore a
+ * list splice rather than a syscall and an fd per purpose; the timerfd
+ * is only re-armed when the earliest deadline moves.
+ *
  * Thread-safety contract: all methods must be called on the main thread
  * (i.e. the thread that will call run()). Cross-thread wake-ups go
  * through a registered eventfd source — typically MainThreadWork.
@@ -30,7 +49,13 @@ public:
      */
     using Handler = std::function<void(uint32_t events)>;
 
-    EventLoop() = default;
+    /** One-shot work run at the end of a dispatch batch; see @c defer. */
+    using Deferred = std::function<void()>;
+
+    /** Milliseconds on the steady clock; the unit of timer deadlines. */
+    using TimerTick = TimerWheel::Tick;
+
+    EventLoop();
     ~EventLoop() = default;
 
     EventLoop(const EventLoop&) = delete;
@@ -39,13 +64,15 @@ public:
     /**
      * Register @p fd with the given @p events mask and @p handler. Fails if
      * @p fd is already registered, if @p handler is empty, or if the
-     * underlying EventPoller add fails.
+     * underlying EventPoller add fails. Include EventPoller::Event::EDGE
+     * only for a source whose handler always drains it to EAGAIN.
      */
     [[nodiscard]] bool add(int fd, uint32_t events, Handler handler);
 
     /**
      * Replace the event mask for an already-registered fd. Handler stays
-     * the same. Fails if @p fd was not previously add()ed.
+     * the same; an edge-triggered source passes EDGE again. Fails if
+     * @p fd was not previously add()ed.
      */
     [[nodiscard]] bool modify(int fd, uint32_t events);
 
@@ -66,6 +93,15 @@ public:
      */
     void run();
 
+    /**
+     * Run @p fn once every event of the current dispatch batch has been
+     * handled, before the loop polls again — including the batch in
+     * which @c stop() is requested. Work deferred by a deferred call
+     * runs in the same pass. Lets a source gather output produced by
+     * several handlers into one flush. Empty functions are ignored.
+     */
+    void defer(Deferred fn);
+
     /**
      * Request the loop to exit. Observed between handler invocations and
      * at the top of each poll cycle. Async-signal-safety is NOT provided;
@@ -73,9 +109,58 @@ public:
      */
     void stop() noexcept { m_stopRequested = true; }
 
+    /** @c false if the wheel's timerfd could not be created or registered. */
+    [[nodiscard]] bool timersValid() const noexcept { return m_timersValid; }
+
+    /** The current time in timer ticks. */
+    [[nodiscard]] static TimerTick timerNow() noexcept;
+
+    /**
+     * Schedule @p node to expire at tick @p at, replacing any prior
+     * deadline; a tick already passed expires on the next dispatch.
+     * Normally reached through LoopTimer.
+     */
+    void scheduleTimer(TimerWheel::Node& node, TimerTick at) noexcept;
+
+    /** Unschedule @p node. Idempotent. */
+    void cancelTimer(TimerWheel::Node& node) noexcept;
+
 private:
+    /** Events collected per poll; the rest wait for the next pass. */
+    static constexpr std::size_t kMaxEvents = 16;
+
+    /** One registered fd; its address is the fd's poller tag. */
+    struct Registration {
+        int     fd;
+        Handler handler;
+        bool    live = true;  // Cleared when removed mid-batch.
+    };
+
+    /** Wheel timerfd handler: expire every due node. */
+    void onWheelTimer();
+
+    /** Point the timerfd at the wheel's earliest event, if it moved. */
+    void reprogramWheelTimer() noexcept;
+
+    /** Run deferred work until none is left. */
+    void runDeferred();
+
     EventPoller m_poller;
-    std::unordered_map<int, Handler> m_handlers;
+    std::unordered_map<int, std::unique_ptr<Registration>> m_registrations;
+    // Removed during the current batch; freed once it has been dispatched.
+    std::vector<std::unique_ptr<Registration>> m_retired;
+    std::array<EventPoller::Ready, kMaxEvents> m_ready{};
+    TimerWheel  m_wheel;
+    TimerSource m_wheelTimer;
+    // Tick the timerfd is armed for; empty while disarmed.
+    std::optional<TimerTick> m_programmedTick;
+    // Deferred work, and the batch being run; swapped so both keep
+    // their capacity from pass to pass.
+    std::vector<Deferred> m_deferred;
+    std::vector<Deferred> m_running;
+    bool m_timersValid   = false;
+    bool m_delivering    = false;  // Inside onWheelTimer's deliver pass.
+    bool m_dispatching   = false;  // Inside run()'s dispatch batch.
     bool m_stopRequested = false;
     bool m_ran           = false;  // Guards single-entry invariant on run().
 };
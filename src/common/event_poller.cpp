@@ -3,6 +3,7 @@
 
 #include <sys/epoll.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <poll.h>
@@ -22,14 +23,14 @@ EventPoller::~EventPoller() {
     }
 }
 
-bool EventPoller::add(int fd, uint32_t events) {
+bool EventPoller::add(int fd, uint32_t events, void* tag) {
     if (m_epollFd < 0 || fd < 0) {
         return false;
     }
 
     struct epoll_event ev;
     ev.events = eventsToEpoll(events);
-    ev.data.fd = fd;
+    ev.data.ptr = tag;
 
     if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
         LOG_ERROR("Failed to add fd ", fd, " to epoll: ", strerror(errno));
@@ -38,14 +39,14 @@ bool EventPoller::add(int fd, uint32_t events) {
     return true;
 }
 
-bool EventPoller::modify(int fd, uint32_t events) {
+bool EventPoller::modify(int fd, uint32_t events, void* tag) {
     if (m_epollFd < 0 || fd < 0) {
         return false;
     }
 
     struct epoll_event ev;
     ev.events = eventsToEpoll(events);
-    ev.data.fd = fd;
+    ev.data.ptr = tag;
 
     if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &ev) < 0) {
         LOG_ERROR("Failed to modify fd ", fd, " in epoll: ", strerror(errno));
@@ -75,29 +76,30 @@ bool EventPoller::remove(int fd) {
     return true;
 }
 
-std::optional<std::vector<EventPoller::EventData>> EventPoller::wait(int timeoutMs) {
+int EventPoller::wait(Ready* out, std::size_t capacity, int timeoutMs) {
     if (m_epollFd < 0) {
-        return std::nullopt;
+        return -1;
     }
 
-    constexpr int kMaxEvents = 16;
+    // Collected here and translated into @p out; fds that do not fit
+    // stay ready for the next wait.
+    constexpr std::size_t kMaxEvents = 64;
     struct epoll_event events[kMaxEvents];
+    const int wanted = static_cast<int>(std::min(capacity, kMaxEvents));
 
-    int numEvents = epoll_wait(m_epollFd, events, kMaxEvents, timeoutMs);
+    int numEvents = epoll_wait(m_epollFd, events, wanted, timeoutMs);
     if (numEvents < 0) {
         if (errno == EINTR) {
-            return std::vector<EventData>{};  // Transient: caller continues.
+            return 0;  // Transient: caller continues.
         }
         LOG_ERROR("epoll_wait failed: ", strerror(errno));
-        return std::nullopt;
+        return -1;
     }
 
-    std::vector<EventData> result;
-    result.reserve(numEvents);
     for (int i = 0; i < numEvents; ++i) {
-        result.push_back({events[i].data.fd, epollToEvents(events[i].events)});
+        out[i] = {events[i].data.ptr, epollToEvents(events[i].events)};
     }
-    return result;
+    return numEvents;
 }
 
 uint32_t EventPoller::epollToEvents(uint32_t epollEvents) {
@@ -118,6 +120,7 @@ uint32_t EventPoller::eventsToEpoll(uint32_t events) {
     if (events & static_cast<uint32_t>(Event::HANGUP)) epollEvents |= EPOLLHUP;
     // EPOLLRDHUP is useful to detect remote end disconnection without reading
     if (events & static_cast<uint32_t>(Event::READ)) epollEvents |= EPOLLRDHUP;
+    if (events & static_cast<uint32_t>(Event::EDGE)) epollEvents |= EPOLLET;
     return epollEvents;
 }
 
@@ -1,8 +1,7 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <optional>
-#include <vector>
 
 namespace cec_control {
 
@@ -18,7 +17,8 @@ public:
         WRITE = 2,       // Ready for write
         ERROR = 4,       // Error condition
         HANGUP = 8,      // Hang up
-        INVALID = 16     // Invalid file descriptor
+        INVALID = 16,    // Invalid file descriptor
+        EDGE = 32        // Registration flag: report READ/WRITE on edges only
     };
 
     // Combined event types for common use cases
@@ -27,9 +27,12 @@ public:
         static_cast<uint32_t>(Event::HANGUP) | 
         static_cast<uint32_t>(Event::INVALID);
 
-    // Event data structure returned by wait()
-    struct EventData {
-        int fd;
+    /**
+     * One ready descriptor, as filled in by wait(): the tag it was
+     * registered with and the EventPoller events that fired.
+     */
+    struct Ready {
+        void* tag;
         uint32_t events;
     };
 
@@ -46,18 +49,25 @@ public:
     /**
      * Add a file descriptor to the poller
      * @param fd The file descriptor to add
-     * @param events The events to watch for (bitwise OR of Event values)
+     * @param events The events to watch for (bitwise OR of Event values).
+     *        With Event::EDGE the registration is edge-triggered: readiness
+     *        is reported once per change, so the owner must read or write
+     *        until EAGAIN each time or it will not hear of the fd again.
+     * @param tag Opaque pointer handed back with each of the fd's events,
+     *        kept in the kernel's own record so wait() needs no lookup.
      * @return true if successful, false otherwise
      */
-    bool add(int fd, uint32_t events);
+    bool add(int fd, uint32_t events, void* tag);
 
     /**
      * Change the events watched on an already-added file descriptor. Used by
      * sd-bus integration, where the requested event mask changes every time
      * sd_bus_process() runs (outbox-empty drops POLLOUT, arrival of a reply
-     * adds POLLIN, etc). Returns false if @p fd was not previously add()ed.
+     * adds POLLIN, etc). The mask and @p tag replace the registered ones
+     * outright, Event::EDGE included. Returns false if @p fd was not
+     * previously add()ed.
      */
-    bool modify(int fd, uint32_t events);
+    bool modify(int fd, uint32_t events, void* tag);
 
     /**
      * Remove a previously-added file descriptor from the poller. Required for
@@ -68,16 +78,18 @@ public:
     bool remove(int fd);
 
     /**
-     * Wait for events on the added file descriptors.
+     * Wait for events on the added file descriptors, writing at most
+     * @p capacity of them into the caller's @p out array. Nothing is
+     * allocated, so a loop can reuse one array for every wait.
      *
      * @param timeoutMs Timeout in milliseconds, -1 for indefinite.
-     * @return - A populated vector when at least one fd is ready.
-     *         - An empty vector on timeout or when an EINTR aborted the wait;
-     *           callers should treat this as "no events, continue".
-     *         - std::nullopt on an unrecoverable error (e.g. EBADF on the
-     *           epoll fd). Callers must stop using this poller in that case.
+     * @return - The number of entries filled when at least one fd is ready.
+     *         - 0 on timeout or when an EINTR aborted the wait; callers
+     *           should treat this as "no events, continue".
+     *         - -1 on an unrecoverable error (e.g. EBADF on the epoll fd).
+     *           Callers must stop using this poller in that case.
      */
-    std::optional<std::vector<EventData>> wait(int timeoutMs = -1);
+    int wait(Ready* out, std::size_t capacity, int timeoutMs = -1);
     
     /**
      * Convert epoll events to EventPoller events
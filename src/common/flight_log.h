@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cec_control {
+
+/**
+ * The daemon's flight recorder: a fixed-size file in its runtime
+ * directory (@c SystemPaths::getFlightRecorderPath,
+ * @c /run/cec-control/flight by default) holding the last few thousand
+ * things each of its threads did — wire requests and replies, adapter
+ * worker jobs, throttle decisions, bus observations and lifecycle
+ * milestones.
+ *
+ * The daemon keeps the file mapped shared and writes records straight
+ * into it, so they live in the page cache rather than in the process:
+ * a daemon that crashes, aborts or is killed by the watchdog leaves its
+ * final moments behind, and @c cec-control @c flight-dump decodes them
+ * afterwards. A restarted daemon renames the file to @c flight.1 before
+ * creating its own, so the run that went wrong survives the restart.
+ *
+ * Each thread claims one of @c kRingCount rings on its first record and
+ * is its only writer, so recording takes no lock and shares no cache
+ * line with another thread. A ring keeps its newest @c kRingRecords
+ * records. A thread that exits releases its ring with its records in
+ * it; once every ring has been handed out, a new thread takes over the
+ * released ring that has been idle longest, so threads recreated on
+ * every adapter reopen never run the recorder out of rings. Every
+ * record sits behind its own sequence word, written odd before the
+ * fields and even after, so a reader running against a live daemon
+ * skips the few records caught mid-write.
+ *
+ * Header-only, like status_page.h: the client decodes the file without
+ * the daemon, which by the time anyone reads it may not be running.
+ */
+namespace flight_log {
+
+/** "CECF" in the first word, so a reader can tell it mapped the right file. */
+inline constexpr uint32_t kMagic   = 0x46434543;
+/** Bumped on any layout change; a reader refuses a version it was not built for. */
+inline constexpr uint32_t kVersion = 1;
+
+/** Threads that hold a ring at once; any past these go unrecorded. */
+inline constexpr std::size_t kRingCount   = 16;
+/** Records each ring keeps. */
+inline constexpr std::size_t kRingRecords = 2048;
+
+/** What a record is about; the meaning of its fields follows from it. */
+enum class Event : uint8_t {
+    /** @c detail is the @c Milestone; @c arg is 1 if it went well, else 0. */
+    Milestone = 1,
+    /** A wire command read: @c detail its type, @c arg its request id, @c id its device, @c value the session. */
+    Request,
+    /** A reply queued: @c detail its type, @c arg the request id, @c value the session. */
+    Reply,
+    /** An adapter worker slice started: @c detail its priority, @c arg its lane. */
+    JobStart,
+    /** That slice ended: as @c JobStart, @c id the @c JobOutcome, @c value microseconds run. */
+    JobEnd,
+    /** @c detail the @c ThrottleDecision, @c arg the device, @c value the wait in microseconds. */
+    Throttle,
+    /** A bus report: @c detail the @c ObservationKind, @c arg the device, @c id what it said. */
+    Observation,
+};
+
+/** Transitions worth a record of their own. */
+enum class Milestone : uint8_t {
+    DaemonStarting,
+    DaemonReady,
+    DaemonStopping,
+    ConfigReload,
+    AdapterOpen,
+    AdapterLost,
+    AdapterReconnect,
+    AdapterIdleClose,
+    AdapterIdleReopen,
+    AdapterReconfigure,
+    Suspend,
+    Resume,
+};
+
+/** How a worker slice ended. */
+enum class JobOutcome : uint8_t {
+    Done,
+    /** The job parked itself to resume later (a throttle wait, a retry back-off). */
+    Parked,
+    /** Its deadline passed in the queue; it never ran. */
+    Expired,
+    Threw,
+};
+
+/** What the command throttler decided about one command. */
+enum class ThrottleDecision : uint8_t {
+    /** Held for its turn on the bus. */
+    Delay,
+    /** Failed and parked for a back-off before the next attempt. */
+    Retry,
+    /** Out of attempts. */
+    Exhausted,
+    /** The device's breaker is half open and this command probes it. */
+    Probe,
+    /** The device's breaker is open; failed without being sent. */
+    Rejected,
+};
+
+/**
+ * The bus reports a daemon decodes, as recorded. For @c PowerReport
+ * records @c id is the power status byte, for address reports the
+ * physical address and for a raw frame its opcode.
+ */
+enum class ObservationKind : uint8_t {
+    TvStandby,
+    TvPowerReport,
+    PowerReport,
+    ActiveSource,
+    PhysicalAddressReport,
+    HostActivated,
+    HostDeactivated,
+    RawFrame,
+};
+
+/** One record as stored. Four words, so records never straddle a cache line. */
+struct Record {
+    /** 0 = never written; odd = being written; else 2 * (ring index + 1). */
+    std::atomic<uint64_t> sequence;
+    /** Wall-clock time, microseconds since the Unix epoch. */
+    std::atomic<int64_t>  timeUs;
+    /** @c Event in bits 0-7, @c detail 8-15, @c arg 16-31, @c id 32-63. */
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> value;
+};
+
+/** @c Ring::claimed values. */
+inline constexpr uint32_t kRingUnused   = 0;
+inline constexpr uint32_t kRingOwned    = 1;
+/** Its thread has exited; the records stay until another takes it over. */
+inline constexpr uint32_t kRingReleased = 2;
+
+/** One thread's records. */
+struct Ring {
+    /**
+     * @c kRingOwned, set after @c tid and @c name, once a thread owns
+     * the ring; @c kRingUnused while it has never had, or is being
+     * handed to, an owner.
+     */
+    std::atomic<uint32_t> claimed;
+    uint32_t              tid;
+    char                  name[16];
+    /** Records written so far; the next goes at @c next % @c kRingRecords. */
+    std::atomic<uint64_t> next;
+    std::array<Record, kRingRecords> records;
+};
+
+/** The file's contents. Fixed size; grows only with @c kVersion. */
+struct Layout {
+    uint32_t magic;
+    uint32_t version;
+    /** The recording daemon. */
+    uint32_t pid;
+    uint32_t ringCount;
+    /** When the daemon created the file, microseconds since the Unix epoch. */
+    int64_t  startedUs;
+    /** Unused rings handed out so far; may run past @c kRingCount. */
+    std::atomic<uint32_t> ringsClaimed;
+    std::array<Ring, kRingCount> rings;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the flight recorder needs address-free atomics to survive the process");
+static_assert(std::is_standard_layout_v<Layout>, "the flight recorder layout must be fixed");
+static_assert(sizeof(Record) == 32, "a record is four words");
+
+[[nodiscard]] constexpr uint64_t packHead(Event event, uint8_t detail, uint16_t arg,
+                                          uint32_t id) noexcept {
+    return static_cast<uint64_t>(event) | (static_cast<uint64_t>(detail) << 8) |
+           (static_cast<uint64_t>(arg) << 16) | (static_cast<uint64_t>(id) << 32);
+}
+
+/** A record as read back, with the ring it came from. */
+struct Entry {
+    int64_t  timeUs = 0;
+    /** Position in its ring's history; orders records of one thread. */
+    uint64_t index  = 0;
+    uint8_t  ring   = 0;
+    Event    event  = Event::Milestone;
+    uint8_t  detail = 0;
+    uint16_t arg    = 0;
+    uint32_t id     = 0;
+    uint64_t value  = 0;
+};
+
+[[nodiscard]] inline std::string_view milestoneName(uint8_t milestone) noexcept {
+    constexpr std::array<std::string_view, 12> kNames = {
+        "daemon-starting", "daemon-ready", "daemon-stopping", "config-reload",
+        "adapter-open", "adapter-lost", "adapter-reconnect", "adapter-idle-close",
+        "adapter-idle-reopen", "adapter-reconfigure", "suspend", "resume",
+    };
+    return milestone < kNames.size() ? kNames[milestone] : "unknown";
+}
+
+[[nodiscard]] inline std::string_view jobOutcomeName(uint32_t outcome) noexcept {
+    constexpr std::array<std::string_view, 4> kNames = {"done", "parked", "expired", "threw"};
+    return outcome < kNames.size() ? kNames[outcome] : "unknown";
+}
+
+[[nodiscard]] inline std::string_view throttleDecisionName(uint8_t decision) noexcept {
+    constexpr std::array<std::string_view, 5> kNames = {
+        "delay", "retry", "exhausted", "probe", "rejected",
+    };
+    return decision < kNames.size() ? kNames[decision] : "unknown";
+}
+
+[[nodiscard]] inline std::string_view observationKindName(uint8_t kind) noexcept {
+    constexpr std::array<std::string_view, 8> kNames = {
+        "tv-standby", "tv-power", "power", "active-source",
+        "physical-address", "host-activated", "host-deactivated", "raw-frame",
+    };
+    return kind < kNames.size() ? kNames[kind] : "unknown";
+}
+
+/**
+ * Read-only mapping of a flight recorder file. Works on the file of a
+ * running daemon, a stopped one and a crashed one alike. Move-only;
+ * unmaps on destruction.
+ */
+class FlightLogReader {
+public:
+    FlightLogReader() noexcept = default;
+    ~FlightLogReader() { close(); }
+
+    FlightLogReader(FlightLogReader&& other) noexcept
+        : m_log(std::exchange(other.m_log, nullptr)) {}
+    FlightLogReader& operator=(FlightLogReader&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_log = std::exchange(other.m_log, nullptr);
+        }
+        return *this;
+    }
+    FlightLogReader(const FlightLogReader&)            = delete;
+    FlightLogReader& operator=(const FlightLogReader&) = delete;
+
+    /**
+     * Map the file at @p path, replacing any earlier mapping.
+     * @return @c false if it cannot be opened or is not a flight
+     *         recorder of this @c kVersion; the reader is then closed.
+     */
+    bool open(const std::string& path) noexcept {
+        close();
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st{};
+        void* mapped = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Layout))) {
+            mapped = ::mmap(nullptr, sizeof(Layout), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        m_log = static_cast<const Layout*>(mapped);
+        if (m_log->magic != kMagic || m_log->version != kVersion ||
+            m_log->ringCount != kRingCount) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() noexcept {
+        if (m_log != nullptr) {
+            ::munmap(const_cast<Layout*>(m_log), sizeof(Layout));
+            m_log = nullptr;
+        }
+    }
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_log != nullptr; }
+
+    /** Pid of the daemon that recorded the file; 0 when closed. */
+    [[nodiscard]] uint32_t recorderPid() const noexcept {
+        return m_log != nullptr ? m_log->pid : 0;
+    }
+
+    /** When the recording daemon created the file; 0 when closed. */
+    [[nodiscard]] int64_t startedUs() const noexcept {
+        return m_log != nullptr ? m_log->startedUs : 0;
+    }
+
+    /** Name and kernel thread id of the owner of @p ring; empty if unclaimed. */
+    [[nodiscard]] std::pair<std::string, uint32_t> thread(uint8_t ring) const {
+        if (m_log == nullptr || ring >= kRingCount) return {};
+        const Ring& r = m_log->rings[ring];
+        if (r.claimed.load(std::memory_order_acquire) == kRingUnused) return {};
+        const std::size_t length =
+            std::find(std::begin(r.name), std::end(r.name), '\0') - std::begin(r.name);
+        return {std::string(r.name, length), r.tid};
+    }
+
+    /**
+     * Every settled record, oldest first: by time, then by position in
+     * its ring for records of one thread stamped the same microsecond.
+     */
+    [[nodiscard]] std::vector<Entry> read() const {
+        std::vector<Entry> out;
+        if (m_log == nullptr) return out;
+        for (std::size_t ring = 0; ring < kRingCount; ++ring) {
+            const Ring& r = m_log->rings[ring];
+            if (r.claimed.load(std::memory_order_acquire) == kRingUnused) continue;
+            for (const Record& record : r.records) {
+                const uint64_t before = record.sequence.load(std::memory_order_acquire);
+                if (before == 0 || (before & 1) != 0) continue;
+                Entry entry;
+                entry.timeUs        = record.timeUs.load(std::memory_order_relaxed);
+                const uint64_t head = record.head.load(std::memory_order_relaxed);
+                entry.value         = record.value.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (record.sequence.load(std::memory_order_relaxed) != before) continue;
+                entry.index  = before / 2 - 1;
+                entry.ring   = static_cast<uint8_t>(ring);
+                entry.event  = static_cast<Event>(head & 0xFF);
+                entry.detail = static_cast<uint8_t>(head >> 8);
+                entry.arg    = static_cast<uint16_t>(head >> 16);
+                entry.id     = static_cast<uint32_t>(head >> 32);
+                out.push_back(entry);
+            }
+        }
+        std::sort(out.begin(), out.end(), [](const Entry& a, const Entry& b) {
+            if (a.timeUs != b.timeUs) return a.timeUs < b.timeUs;
+            if (a.ring != b.ring) return a.ring < b.ring;
+            return a.index < b.index;
+        });
+        return out;
+    }
+
+private:
+    const Layout* m_log = nullptr;
+};
+
+} // namespace flight_log
+
+} // namespace cec_control
@@ -4,8 +4,6 @@
 #include "key_codes.h"
 #include "system_paths.h"
 
-#include "../daemon/cec/operations.h"
-
 #include <algorithm>
 #include <iostream>
 #include <sstream>
@@ -16,9 +14,9 @@ namespace cec_control {
 // The source-ID block in printClientHelp hard-codes the HDMI range
 // [kFirstHdmiSource..kLastHdmiSource]. These asserts catch any drift
 // in the range at build time so the help text stays in sync.
-static_assert(ops::kFirstHdmiSource == 2,
+static_assert(kFirstHdmiSource == 2,
               "Source ID help text hard-codes the HDMI source range");
-static_assert(ops::kLastHdmiSource == 5,
+static_assert(kLastHdmiSource == 5,
               "Source ID help text hard-codes the HDMI source range");
 
 namespace {
@@ -80,6 +78,7 @@ void HelpPrinter::printGeneralHelp(const char* programName) {
               << "\n"
               << "USAGE:\n"
               << "  " << programName << " COMMAND [ARGS...] [OPTIONS]    # Client mode\n"
+              << "  " << programName << " --interactive [OPTIONS]        # Commands from stdin\n"
               << "  " << programName << " daemon [OPTIONS]               # Daemon mode\n"
               << "\n"
               << "CLIENT COMMANDS:\n";
@@ -89,6 +88,7 @@ void HelpPrinter::printGeneralHelp(const char* programName) {
               << "  -v, --verbose                            Enable verbose logging\n"
               << "  -l, --log FILE                           Set log file path\n"
               << "  -c, --config FILE                        Set configuration file\n"
+              << "      --simulate                           Use a simulated CEC bus\n"
               << "\n"
               << "DETAILED HELP:\n"
               << "  " << programName << " help client        Show client command reference\n"
@@ -105,6 +105,7 @@ void HelpPrinter::printClientHelp(const char* programName) {
               << "\n"
               << "USAGE:\n"
               << "  " << programName << " COMMAND [ARGS...] [OPTIONS]\n"
+              << "  " << programName << " (--interactive|--stdin) [OPTIONS]\n"
               << "\n"
               << "COMMANDS:\n";
     printRegistryCommands(std::cout);
@@ -112,6 +113,31 @@ void HelpPrinter::printClientHelp(const char* programName) {
               << "OPTIONS:\n"
               << "  --socket-path=PATH                       Set daemon socket path\n"
               << "                                           (default: " << SystemPaths::getSocketPath() << ")\n"
+              << "  --adapter=NAME                           Run the command on the [Adapter.NAME]\n"
+              << "                                           adapter (default: [Adapter])\n"
+              << "  --no-wait                                Exit once the command is sent, without\n"
+              << "                                           waiting for the daemon's reply; not for\n"
+              << "                                           status, devices, active-source, stats,\n"
+              << "                                           trace dump or subscribe\n"
+              << "\n"
+              << "SESSIONS:\n"
+              << "  --interactive, --stdin                   Read commands from stdin, one per line,\n"
+              << "                                           and pipeline them over one connection;\n"
+              << "                                           '#' starts a comment, 'quit' ends\n"
+              << "\n"
+              << "FLEETS:\n"
+              << "  fleet OPTIONS COMMAND [ARGS...]          Send COMMAND to many daemons' network\n"
+              << "                                           endpoints at once; not for commands\n"
+              << "                                           whose reply is their output\n"
+              << "    --host=HOST:PORT                       A daemon to send to; repeatable\n"
+              << "    --hosts=FILE                           Daemons to send to, one per line\n"
+              << "    --token-file=FILE                      The endpoints' NetworkTokenFile\n"
+              << "    --timeout=MS                           Limit for the whole run (default 10000)\n"
+              << "\n"
+              << "DIAGNOSTICS:\n"
+              << "  flight-dump [previous|FILE]              Print the daemon's recent activity from\n"
+              << "                                           its flight recorder, also after a crash;\n"
+              << "                                           'previous' is the run before a restart\n"
               << "\n"
               << "ENVIRONMENT:\n"
               << "  CEC_CONTROL_SOCKET                       Override socket path for system service\n"
@@ -120,8 +146,18 @@ void HelpPrinter::printClientHelp(const char* programName) {
               << "EXAMPLES:\n"
               << "  " << programName << " volume up 5        Increase volume on device 5\n"
               << "  " << programName << " power on 0         Turn on TV (device 0)\n"
+              << "  " << programName << " power off 0 4 5    Put three devices in standby at once\n"
+              << "  " << programName << " power off all      Broadcast standby to every device\n"
               << "  " << programName << " source 0 4         Switch TV to HDMI 3\n"
               << "  " << programName << " key blue           Press the blue colour key on the TV\n"
+              << "  " << programName << " keys 0 down down select\n"
+              << "                                           Move two menu rows down on the TV and pick\n"
+              << "  " << programName << " raw 0 8f           Send <Give Device Power Status> to the TV\n"
+              << "  " << programName << " batch power on 0 , source 0 2\n"
+              << "                                           Power on the TV, then switch to HDMI 1\n"
+              << "  " << programName << " status 0           Show whether the TV is on\n"
+              << "  " << programName << " subscribe tv-standby active-source\n"
+              << "                                           Print those bus events as they happen\n"
               << "  " << programName << " suspend            Prepare for system sleep\n"
               << "\n"
               << "DEVICE IDs (CEC logical addresses):\n"
@@ -133,8 +169,8 @@ void HelpPrinter::printClientHelp(const char* programName) {
               << "  1  - Audio input                         4  - HDMI 3\n"
               << "  2  - HDMI 1                              5  - HDMI 4\n"
               << "\n"
-              << "KEY NAMES (for `key`):\n"
-              << "  " << formatKeyNamesList(", ") << "\n"
+              << "KEY NAMES (for `key`, `hold` and `keys`):\n"
+              << "  " << formatKeyNamesList(", ", 79, "  ") << "\n"
               << std::endl;
 }
 
@@ -150,6 +186,8 @@ void HelpPrinter::printDaemonHelp(const char* programName) {
               << "                                           (default: " << SystemPaths::getLogPath() << ")\n"
               << "  -c, --config FILE                        Set configuration file path\n"
               << "                                           (default: " << SystemPaths::getConfigPath() << ")\n"
+              << "      --simulate                           Drive a simulated CEC bus instead of\n"
+              << "                                           libcec (see [Simulator])\n"
               << "  -h, --help                               Show this help message\n"
               << "\n"
               << "EXAMPLES:\n"
@@ -0,0 +1,38 @@
+#include "inet_address.h"
+
+#include <arpa/inet.h>
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+namespace cec_control {
+
+std::optional<sockaddr_in> parseInetAddress(const std::string& text) {
+    const auto colon = text.rfind(':');
+    if (colon == std::string::npos || colon == 0) return std::nullopt;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    const std::string host = text.substr(0, colon);
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        return std::nullopt;
+    }
+
+    const std::string_view port = std::string_view(text).substr(colon + 1);
+    uint16_t value = 0;
+    const auto [end, ec] = std::from_chars(port.data(), port.data() + port.size(), value);
+    if (ec != std::errc{} || end != port.data() + port.size() || value == 0) {
+        return std::nullopt;
+    }
+    addr.sin_port = htons(value);
+    return addr;
+}
+
+std::string formatInetAddress(const sockaddr_in& addr) {
+    char host[INET_ADDRSTRLEN] = {};
+    if (::inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host)) == nullptr) return "?";
+    return std::string(host) + ':' + std::to_string(ntohs(addr.sin_port));
+}
+
+} // namespace cec_control
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include <optional>
+#include <string>
+
+namespace cec_control {
+
+/**
+ * Parse a numeric IPv4 @c A.B.C.D:PORT. Returns nullopt for anything
+ * else, a host name included, so a listener can never resolve a typo
+ * to some other interface. Port 0 is rejected.
+ */
+[[nodiscard]] std::optional<sockaddr_in> parseInetAddress(const std::string& text);
+
+/** @p addr as @c A.B.C.D:PORT, for log lines. */
+[[nodiscard]] std::string formatInetAddress(const sockaddr_in& addr);
+
+} // namespace cec_control
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace cec_control {
+
+/**
+ * Byte string that keeps up to @c kInlineCapacity bytes inside the
+ * object and moves to the heap only beyond that.
+ *
+ * Carries @c Message payloads and the framed datagrams queued for a
+ * session. Almost every wire message — a command's one-byte argument,
+ * a status reply, a bus event — fits inline, so building, copying and
+ * queueing one costs no allocation; the occasional large payload
+ * (a stats report, a trace chunk, a long batch) spills over.
+ *
+ * The interface is the slice of @c std::vector<uint8_t> the wire code
+ * needs: contiguous @c data(), pointer iterators, indexing, appends.
+ * @c clear() keeps a heap buffer for reuse.
+ */
+class InlineBytes {
+public:
+    /** Bytes held without allocating. */
+    static constexpr std::size_t kInlineCapacity = 24;
+
+    InlineBytes() noexcept {}
+
+    InlineBytes(const uint8_t* bytes, std::size_t len) { append(bytes, len); }
+
+    InlineBytes(std::initializer_list<uint8_t> bytes)
+        : InlineBytes(bytes.begin(), bytes.size()) {}
+
+    InlineBytes(const std::vector<uint8_t>& bytes)
+        : InlineBytes(bytes.data(), bytes.size()) {}
+
+    InlineBytes(const InlineBytes& other) : InlineBytes(other.data(), other.size()) {}
+
+    InlineBytes(InlineBytes&& other) noexcept { take(other); }
+
+    InlineBytes& operator=(const InlineBytes& other) {
+        if (this != &other) assign(other.data(), other.size());
+        return *this;
+    }
+
+    InlineBytes& operator=(InlineBytes&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~InlineBytes() { release(); }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+    [[nodiscard]] uint8_t*       data() noexcept { return onHeap() ? m_heap : m_inline; }
+    [[nodiscard]] const uint8_t* data() const noexcept { return onHeap() ? m_heap : m_inline; }
+
+    uint8_t*       begin() noexcept { return data(); }
+    uint8_t*       end() noexcept { return data() + m_size; }
+    const uint8_t* begin() const noexcept { return data(); }
+    const uint8_t* end() const noexcept { return data() + m_size; }
+
+    uint8_t&       operator[](std::size_t i) noexcept { return data()[i]; }
+    const uint8_t& operator[](std::size_t i) const noexcept { return data()[i]; }
+
+    /** Replace the contents with @p len bytes from @p bytes. */
+    void assign(const uint8_t* bytes, std::size_t len) {
+        m_size = 0;
+        append(bytes, len);
+    }
+
+    void append(const uint8_t* bytes, std::size_t len) {
+        if (len == 0) return;
+        reserve(m_size + len);
+        std::memcpy(data() + m_size, bytes, len);
+        m_size += static_cast<uint32_t>(len);
+    }
+
+    void push_back(uint8_t byte) {
+        reserve(m_size + 1);
+        data()[m_size++] = byte;
+    }
+
+    void clear() noexcept { m_size = 0; }
+
+    /** Make room for @p capacity bytes; growth at least doubles. */
+    void reserve(std::size_t capacity) {
+        if (capacity <= m_capacity) return;
+        const std::size_t grown = std::max<std::size_t>(capacity, m_capacity * 2);
+        auto* heap = new uint8_t[grown];
+        std::memcpy(heap, data(), m_size);
+        const uint32_t size = m_size;
+        release();
+        m_heap     = heap;
+        m_size     = size;
+        m_capacity = static_cast<uint32_t>(grown);
+    }
+
+    friend bool operator==(const InlineBytes& a, const InlineBytes& b) noexcept {
+        return a.m_size == b.m_size && std::memcmp(a.data(), b.data(), a.m_size) == 0;
+    }
+    friend bool operator!=(const InlineBytes& a, const InlineBytes& b) noexcept {
+        return !(a == b);
+    }
+
+private:
+    [[nodiscard]] bool onHeap() const noexcept { return m_capacity > kInlineCapacity; }
+
+    /** Free a heap buffer, leaving the object empty and inline. */
+    void release() noexcept {
+        if (onHeap()) delete[] m_heap;
+        m_size     = 0;
+        m_capacity = kInlineCapacity;
+    }
+
+    /** Adopt @p other's contents and leave it empty; this must be empty and inline. */
+    void take(InlineBytes& other) noexcept {
+        m_size = other.m_size;
+        if (other.onHeap()) {
+            m_heap     = other.m_heap;
+            m_capacity = other.m_capacity;
+            other.m_capacity = kInlineCapacity;
+        } else {
+            std::memcpy(m_inline, other.m_inline, m_size);
+        }
+        other.m_size = 0;
+    }
+
+    // 32-bit sizes keep the object at 32 bytes; wire messages are
+    // bounded far below that range by MAX_MESSAGE_SIZE.
+    uint32_t m_size     = 0;
+    uint32_t m_capacity = kInlineCapacity;
+    union {
+        uint8_t  m_inline[kInlineCapacity];
+        uint8_t* m_heap;
+    };
+};
+
+} // namespace cec_control
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cec_control {
+
+/**
+ * Type-erased callable stored entirely inside the object: a
+ * @c std::function without the heap.
+ *
+ * The closure is constructed into @p Capacity bytes of inline storage,
+ * and one that does not fit is a compile error rather than a silent
+ * allocation — every queue that carries these (worker tasks, main-
+ * thread posts, response sinks) stays allocation-free by construction.
+ * When a capture list grows past its queue's capacity, raise the
+ * capacity constant next to the alias; the static_assert names it.
+ *
+ * Move-only by default, so closures may own move-only state. With
+ * @p Copyable set it also copies, and then accepts only copyable
+ * closures; that variant exists for the response sink, which is
+ * handed to both a task and its expiry hook.
+ *
+ * Like @c std::function, @c operator() is @c const and invokes the
+ * stored closure as non-const, so mutable lambdas work unchanged.
+ * Invoking an empty instance is undefined; test it first where it
+ * may be empty. Not thread-safe; one owner at a time.
+ */
+template <typename Signature, std::size_t Capacity, bool Copyable = false>
+class InlineFunction;
+
+template <typename R, typename... Args, std::size_t Capacity, bool Copyable>
+class InlineFunction<R(Args...), Capacity, Copyable> {
+    /** Stand-in parameter that makes the copy members unusable. */
+    struct Disabled;
+    using CopySource = std::conditional_t<Copyable, const InlineFunction&, const Disabled&>;
+
+public:
+    /** Bytes of closure state held inline. */
+    static constexpr std::size_t kCapacity = Capacity;
+
+    /** Closures must align no stricter than this. */
+    static constexpr std::size_t kAlignment = alignof(void*);
+
+    InlineFunction() noexcept = default;
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    /**
+     * Store @p fn. A null function pointer or empty @c std::function
+     * yields an empty instance.
+     */
+    template <typename F,
+              typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, InlineFunction> &&
+                                          std::is_invocable_r_v<R, Fn&, Args...>>>
+    InlineFunction(F&& fn) {
+        static_assert(sizeof(Fn) <= Capacity,
+                      "closure exceeds this InlineFunction's capacity");
+        static_assert(alignof(Fn) <= kAlignment,
+                      "closure is over-aligned for InlineFunction storage");
+        static_assert(std::is_nothrow_move_constructible_v<Fn>,
+                      "InlineFunction relocates closures and needs a noexcept move");
+        static_assert(!Copyable || std::is_copy_constructible_v<Fn>,
+                      "a copyable InlineFunction needs a copyable closure");
+        if constexpr (std::is_constructible_v<bool, const Fn&>) {
+            if (!static_cast<bool>(fn)) return;
+        }
+        ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(fn));
+        m_ops = &kOps<Fn>;
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept { take(other); }
+
+    InlineFunction(CopySource other) {
+        if (other.m_ops != nullptr) {
+            other.m_ops->copy(m_storage, other.m_storage);
+            m_ops = other.m_ops;
+        }
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(CopySource other) {
+        if (this != &other) {
+            InlineFunction copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    ~InlineFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    R operator()(Args... args) const {
+        return m_ops->invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+    /** Destroy the stored closure, leaving this empty. */
+    void reset() noexcept {
+        if (m_ops != nullptr) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    /** Per-closure-type operations; @c copy is null unless @p Copyable. */
+    struct Ops {
+        R    (*invoke)(void* storage, Args&&... args);
+        void (*relocate)(void* to, void* from) noexcept;
+        void (*copy)(void* to, const void* from);
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename Fn>
+    static Fn& as(void* storage) noexcept {
+        return *std::launder(static_cast<Fn*>(storage));
+    }
+
+    template <typename Fn>
+    static R invokeAs(void* storage, Args&&... args) {
+        if constexpr (std::is_void_v<R>) {
+            as<Fn>(storage)(std::forward<Args>(args)...);
+        } else {
+            return as<Fn>(storage)(std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename Fn>
+    static void relocateAs(void* to, void* from) noexcept {
+        Fn& source = as<Fn>(from);
+        ::new (to) Fn(std::move(source));
+        source.~Fn();
+    }
+
+    template <typename Fn>
+    static void copyAs(void* to, const void* from) {
+        ::new (to) Fn(*std::launder(static_cast<const Fn*>(from)));
+    }
+
+    template <typename Fn>
+    static constexpr auto copyFor() noexcept -> void (*)(void*, const void*) {
+        if constexpr (Copyable) {
+            return &copyAs<Fn>;
+        } else {
+            return nullptr;
+        }
+    }
+
+    template <typename Fn>
+    static void destroyAs(void* storage) noexcept { as<Fn>(storage).~Fn(); }
+
+    template <typename Fn>
+    static constexpr Ops kOps{&invokeAs<Fn>, &relocateAs<Fn>,
+                              copyFor<Fn>(), &destroyAs<Fn>};
+
+    /** Move @p other's closure here and leave it empty; this must be empty. */
+    void take(InlineFunction& other) noexcept {
+        if (other.m_ops != nullptr) {
+            other.m_ops->relocate(m_storage, other.m_storage);
+            m_ops = std::exchange(other.m_ops, nullptr);
+        }
+    }
+
+    const Ops* m_ops = nullptr;
+    alignas(kAlignment) mutable unsigned char m_storage[Capacity];
+};
+
+} // namespace cec_control
@@ -0,0 +1,95 @@
+#include "journal_sink.h"
+
+#include <sys/uio.h>
+#include <systemd/sd-journal.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace cec_control {
+
+namespace {
+
+/**
+ * SYSLOG_IDENTIFIER of every entry. The daemon's name from before it
+ * became cec-controld, so that `journalctl -t cec-control` and
+ * filters built on it still match.
+ */
+constexpr const char* kSyslogIdentifier = "cec-control";
+
+/** Journal value of CEC_SUBSYSTEM; null for the untagged default. */
+const char* subsystemName(LogSubsystem subsystem) noexcept {
+    switch (subsystem) {
+        case LogSubsystem::None:    return nullptr;
+        case LogSubsystem::Daemon:  return "daemon";
+        case LogSubsystem::Adapter: return "adapter";
+        case LogSubsystem::Libcec:  return "libcec";
+    }
+    return nullptr;
+}
+
+/** syslog(3) priority for @p level, as journald expects in PRIORITY=. */
+int journalPriority(LogLevel level) noexcept {
+    switch (level) {
+        case LogLevel::DEBUG:
+        case LogLevel::TRAFFIC: return 7;  // LOG_DEBUG
+        case LogLevel::INFO:    return 6;  // LOG_INFO
+        case LogLevel::WARNING: return 4;  // LOG_WARNING
+        case LogLevel::ERROR:   return 3;  // LOG_ERR
+        case LogLevel::FATAL:   return 2;  // LOG_CRIT
+    }
+    return 6;
+}
+
+} // namespace
+
+// Fields are built in stack buffers; the message is copied behind its
+// "MESSAGE=" key in a per-thread buffer, since sd_journal_sendv takes
+// each field as a single iovec.
+void sendToJournal(LogLevel level, std::string_view message,
+                   const LogContext& context) noexcept {
+    constexpr std::string_view kMessageKey = "MESSAGE=";
+    thread_local char messageField[kMessageKey.size() + Logger::kMaxLineLength];
+    const std::size_t length = std::min(message.size(), Logger::kMaxLineLength);
+    std::memcpy(messageField, kMessageKey.data(), kMessageKey.size());
+    std::memcpy(messageField + kMessageKey.size(), message.data(), length);
+
+    char priority[16];
+    char identifier[64];
+    char subsystem[64];
+    char address[32];
+    char type[32];
+    char session[48];
+
+    iovec fields[7];
+    int count = 0;
+    auto add = [&fields, &count](char* text, int length) {
+        if (length > 0) fields[count++] = iovec{text, static_cast<std::size_t>(length)};
+    };
+    fields[count++] = iovec{messageField, kMessageKey.size() + length};
+    add(priority, std::snprintf(priority, sizeof(priority), "PRIORITY=%d",
+                                journalPriority(level)));
+    add(identifier, std::snprintf(identifier, sizeof(identifier),
+                                  "SYSLOG_IDENTIFIER=%s", kSyslogIdentifier));
+    if (const char* name = subsystemName(context.subsystem)) {
+        add(subsystem, std::snprintf(subsystem, sizeof(subsystem),
+                                     "CEC_SUBSYSTEM=%s", name));
+    }
+    if (context.logicalAddress >= 0) {
+        add(address, std::snprintf(address, sizeof(address),
+                                   "CEC_LOGICAL_ADDRESS=%d", context.logicalAddress));
+    }
+    if (context.messageType >= 0) {
+        add(type, std::snprintf(type, sizeof(type),
+                                "CEC_MESSAGE_TYPE=%d", context.messageType));
+    }
+    if (context.sessionId != 0) {
+        add(session, std::snprintf(session, sizeof(session), "CEC_SESSION_ID=%llu",
+                                   static_cast<unsigned long long>(context.sessionId)));
+    }
+    (void)sd_journal_sendv(fields, count);
+}
+
+} // namespace cec_control
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "logger.h"
+
+#include <string_view>
+
+namespace cec_control {
+
+/**
+ * The journald client behind @c LogSink::Journal, kept out of
+ * logger.cpp so that only the programs that log to the journal link
+ * libsystemd: the daemon sets it as @c LogConfig::journalWriter, and the
+ * CLI, which never configures a journal sink, does without.
+ *
+ * Sends @p message as one native journal entry with @c PRIORITY for
+ * @p level, @c SYSLOG_IDENTIFIER @c cec-control, and the set fields of
+ * @p context.
+ */
+void sendToJournal(LogLevel level, std::string_view message,
+                   const LogContext& context) noexcept;
+
+} // namespace cec_control
@@ -1,38 +1,74 @@
 #include "key_codes.h"
 
-#include <algorithm>
+#include "static_index.h"
 
 namespace cec_control {
 
-// Codes mirror libcec's cec_user_control_code enumerators. Keeping the
-// raw bytes here (rather than the libcec enum values directly) keeps
-// this TU free of libcec includes, so the common/ layer stays independent
-// of the CEC backend. The corresponding static_asserts in
-// daemon/cec/operations.cpp pin each row to its libcec enumerator.
-const std::array<KeySpec, 4> kKeyCodes = {{
-    {"blue",   0x71},  // CEC_USER_CONTROL_CODE_F1_BLUE
-    {"red",    0x72},  // CEC_USER_CONTROL_CODE_F2_RED
-    {"green",  0x73},  // CEC_USER_CONTROL_CODE_F3_GREEN
-    {"yellow", 0x74},  // CEC_USER_CONTROL_CODE_F4_YELLOW
-}};
+namespace {
+
+constexpr std::string_view keyName(const KeySpec& spec) noexcept { return spec.name; }
+
+constexpr auto kByName = static_index::buildNameIndex<256>(kKeyCodes, keyName);
+
+constexpr static_index::ByteIndex buildCodeIndex() noexcept {
+    auto index = static_index::emptyByteIndex();
+    for (std::size_t row = 0; row < kKeyCodes.size(); ++row) {
+        index[kKeyCodes[row].code] = static_cast<uint8_t>(row);
+    }
+    return index;
+}
+
+constexpr auto kByCode = buildCodeIndex();
+
+/** Every name and every code must resolve back to its own row. */
+constexpr bool keysAreDistinct() noexcept {
+    for (std::size_t row = 0; row < kKeyCodes.size(); ++row) {
+        if (kByName.find(kKeyCodes, kKeyCodes[row].name, keyName) != row) return false;
+        if (kByCode[kKeyCodes[row].code] != row) return false;
+    }
+    return true;
+}
+static_assert(keysAreDistinct(), "kKeyCodes repeats a name or a code");
+
+const KeySpec* rowOrNull(uint8_t row) noexcept {
+    return row == static_index::kNone ? nullptr : &kKeyCodes[row];
+}
+
+} // namespace
 
 const KeySpec* findKeyByName(std::string_view name) noexcept {
-    const auto it = std::find_if(kKeyCodes.begin(), kKeyCodes.end(),
-        [name](const KeySpec& s) { return s.name == name; });
-    return it == kKeyCodes.end() ? nullptr : &*it;
+    return rowOrNull(kByName.find(kKeyCodes, name, keyName));
 }
 
 const KeySpec* findKeyByCode(uint8_t code) noexcept {
-    const auto it = std::find_if(kKeyCodes.begin(), kKeyCodes.end(),
-        [code](const KeySpec& s) { return s.code == code; });
-    return it == kKeyCodes.end() ? nullptr : &*it;
+    return rowOrNull(kByCode[code]);
 }
 
-std::string formatKeyNamesList(std::string_view separator) {
+std::string formatKeyNamesList(std::string_view separator, std::size_t lineWidth,
+                               std::string_view indent) {
+    // What a line keeps of the separator when it breaks after a name.
+    std::string_view lineEnd = separator;
+    while (!lineEnd.empty() && lineEnd.back() == ' ') lineEnd.remove_suffix(1);
+
     std::string out;
+    std::size_t column = indent.size();
     for (std::size_t i = 0; i < kKeyCodes.size(); ++i) {
-        if (i != 0) out.append(separator.data(), separator.size());
-        out.append(kKeyCodes[i].name.data(), kKeyCodes[i].name.size());
+        const std::string_view name = kKeyCodes[i].name;
+        const std::size_t width =
+            name.size() + (i + 1 < kKeyCodes.size() ? lineEnd.size() : 0);
+        if (i != 0) {
+            out.append(separator.data(), separator.size());
+            column += separator.size();
+            if (lineWidth != 0 && column + width > lineWidth) {
+                // The separator's trailing space has no place at a line end.
+                while (!out.empty() && out.back() == ' ') out.pop_back();
+                out.push_back('\n');
+                out.append(indent.data(), indent.size());
+                column = indent.size();
+            }
+        }
+        out.append(name.data(), name.size());
+        column += name.size();
     }
     return out;
 }
@@ -23,7 +23,9 @@ struct KeySpec {
 };
 
 /**
- * Authoritative name <-> code mapping for the client @c key command.
+ * Authoritative name <-> code mapping for the client @c key, @c hold
+ * and @c keys commands: every CEC user-control code a remote can send,
+ * by its CEC 1.4b name.
  *
  * Adding a new key is a single new row here, consumed by:
  *  - the client-side parser (name -> code), in @c command_registry.cpp,
@@ -32,25 +34,129 @@ struct KeySpec {
  *  - the @c --help output (enumerates valid names), in
  *    @c help_printer.cpp.
  *
- * The size literal in the declaration tracks the definition in
- * @c key_codes.cpp; a mismatch is a compile-time error. When extending
- * the set, add a matching @c static_assert alongside the existing ones
- * in @c operations.cpp.
+ * Bump the size literal when adding a row, and add its libcec
+ * enumerator, in the same position, to @c kLibcecKeyCodes in
+ * @c operations.cpp; the build checks the two tables agree.
+ *
+ * The play, tune, select-media and select-input functions (0x60,
+ * 0x67-0x6A) are left out: each needs an operand after the code,
+ * which a bare key press has no way to carry.
  */
-extern const std::array<KeySpec, 4> kKeyCodes;
+inline constexpr std::array<KeySpec, 82> kKeyCodes = {{
+    // Navigation and menus
+    {"select",                    0x00},  // CEC_USER_CONTROL_CODE_SELECT
+    {"up",                        0x01},  // CEC_USER_CONTROL_CODE_UP
+    {"down",                      0x02},  // CEC_USER_CONTROL_CODE_DOWN
+    {"left",                      0x03},  // CEC_USER_CONTROL_CODE_LEFT
+    {"right",                     0x04},  // CEC_USER_CONTROL_CODE_RIGHT
+    {"right-up",                  0x05},  // CEC_USER_CONTROL_CODE_RIGHT_UP
+    {"right-down",                0x06},  // CEC_USER_CONTROL_CODE_RIGHT_DOWN
+    {"left-up",                   0x07},  // CEC_USER_CONTROL_CODE_LEFT_UP
+    {"left-down",                 0x08},  // CEC_USER_CONTROL_CODE_LEFT_DOWN
+    {"root-menu",                 0x09},  // CEC_USER_CONTROL_CODE_ROOT_MENU
+    {"setup-menu",                0x0A},  // CEC_USER_CONTROL_CODE_SETUP_MENU
+    {"contents-menu",             0x0B},  // CEC_USER_CONTROL_CODE_CONTENTS_MENU
+    {"favorite-menu",             0x0C},  // CEC_USER_CONTROL_CODE_FAVORITE_MENU
+    {"exit",                      0x0D},  // CEC_USER_CONTROL_CODE_EXIT
+    {"top-menu",                  0x10},  // CEC_USER_CONTROL_CODE_TOP_MENU
+    {"dvd-menu",                  0x11},  // CEC_USER_CONTROL_CODE_DVD_MENU
+
+    // Number entry
+    {"number-entry-mode",         0x1D},  // CEC_USER_CONTROL_CODE_NUMBER_ENTRY_MODE
+    {"11",                        0x1E},  // CEC_USER_CONTROL_CODE_NUMBER11
+    {"12",                        0x1F},  // CEC_USER_CONTROL_CODE_NUMBER12
+    {"0",                         0x20},  // CEC_USER_CONTROL_CODE_NUMBER0
+    {"1",                         0x21},  // CEC_USER_CONTROL_CODE_NUMBER1
+    {"2",                         0x22},  // CEC_USER_CONTROL_CODE_NUMBER2
+    {"3",                         0x23},  // CEC_USER_CONTROL_CODE_NUMBER3
+    {"4",                         0x24},  // CEC_USER_CONTROL_CODE_NUMBER4
+    {"5",                         0x25},  // CEC_USER_CONTROL_CODE_NUMBER5
+    {"6",                         0x26},  // CEC_USER_CONTROL_CODE_NUMBER6
+    {"7",                         0x27},  // CEC_USER_CONTROL_CODE_NUMBER7
+    {"8",                         0x28},  // CEC_USER_CONTROL_CODE_NUMBER8
+    {"9",                         0x29},  // CEC_USER_CONTROL_CODE_NUMBER9
+    {"dot",                       0x2A},  // CEC_USER_CONTROL_CODE_DOT
+    {"enter",                     0x2B},  // CEC_USER_CONTROL_CODE_ENTER
+    {"clear",                     0x2C},  // CEC_USER_CONTROL_CODE_CLEAR
+
+    // Channels and information
+    {"next-favorite",             0x2F},  // CEC_USER_CONTROL_CODE_NEXT_FAVORITE
+    {"channel-up",                0x30},  // CEC_USER_CONTROL_CODE_CHANNEL_UP
+    {"channel-down",              0x31},  // CEC_USER_CONTROL_CODE_CHANNEL_DOWN
+    {"previous-channel",          0x32},  // CEC_USER_CONTROL_CODE_PREVIOUS_CHANNEL
+    {"sound-select",              0x33},  // CEC_USER_CONTROL_CODE_SOUND_SELECT
+    {"input-select",              0x34},  // CEC_USER_CONTROL_CODE_INPUT_SELECT
+    {"display-information",       0x35},  // CEC_USER_CONTROL_CODE_DISPLAY_INFORMATION
+    {"help",                      0x36},  // CEC_USER_CONTROL_CODE_HELP
+    {"page-up",                   0x37},  // CEC_USER_CONTROL_CODE_PAGE_UP
+    {"page-down",                 0x38},  // CEC_USER_CONTROL_CODE_PAGE_DOWN
+
+    // Power, volume and transport
+    {"power",                     0x40},  // CEC_USER_CONTROL_CODE_POWER
+    {"volume-up",                 0x41},  // CEC_USER_CONTROL_CODE_VOLUME_UP
+    {"volume-down",               0x42},  // CEC_USER_CONTROL_CODE_VOLUME_DOWN
+    {"mute",                      0x43},  // CEC_USER_CONTROL_CODE_MUTE
+    {"play",                      0x44},  // CEC_USER_CONTROL_CODE_PLAY
+    {"stop",                      0x45},  // CEC_USER_CONTROL_CODE_STOP
+    {"pause",                     0x46},  // CEC_USER_CONTROL_CODE_PAUSE
+    {"record",                    0x47},  // CEC_USER_CONTROL_CODE_RECORD
+    {"rewind",                    0x48},  // CEC_USER_CONTROL_CODE_REWIND
+    {"fast-forward",              0x49},  // CEC_USER_CONTROL_CODE_FAST_FORWARD
+    {"eject",                     0x4A},  // CEC_USER_CONTROL_CODE_EJECT
+    {"forward",                   0x4B},  // CEC_USER_CONTROL_CODE_FORWARD
+    {"backward",                  0x4C},  // CEC_USER_CONTROL_CODE_BACKWARD
+    {"stop-record",               0x4D},  // CEC_USER_CONTROL_CODE_STOP_RECORD
+    {"pause-record",              0x4E},  // CEC_USER_CONTROL_CODE_PAUSE_RECORD
+
+    // Programme selection and setup
+    {"angle",                     0x50},  // CEC_USER_CONTROL_CODE_ANGLE
+    {"sub-picture",               0x51},  // CEC_USER_CONTROL_CODE_SUB_PICTURE
+    {"video-on-demand",           0x52},  // CEC_USER_CONTROL_CODE_VIDEO_ON_DEMAND
+    {"guide",                     0x53},  // CEC_USER_CONTROL_CODE_ELECTRONIC_PROGRAM_GUIDE
+    {"timer-programming",         0x54},  // CEC_USER_CONTROL_CODE_TIMER_PROGRAMMING
+    {"initial-configuration",     0x55},  // CEC_USER_CONTROL_CODE_INITIAL_CONFIGURATION
+    {"select-broadcast-type",     0x56},  // CEC_USER_CONTROL_CODE_SELECT_BROADCAST_TYPE
+    {"select-sound-presentation", 0x57},  // CEC_USER_CONTROL_CODE_SELECT_SOUND_PRESENTATION
+
+    // Functions (the ones that take no operand)
+    {"pause-play-function",       0x61},  // CEC_USER_CONTROL_CODE_PAUSE_PLAY_FUNCTION
+    {"record-function",           0x62},  // CEC_USER_CONTROL_CODE_RECORD_FUNCTION
+    {"pause-record-function",     0x63},  // CEC_USER_CONTROL_CODE_PAUSE_RECORD_FUNCTION
+    {"stop-function",             0x64},  // CEC_USER_CONTROL_CODE_STOP_FUNCTION
+    {"mute-function",             0x65},  // CEC_USER_CONTROL_CODE_MUTE_FUNCTION
+    {"restore-volume-function",   0x66},  // CEC_USER_CONTROL_CODE_RESTORE_VOLUME_FUNCTION
+    {"power-toggle-function",     0x6B},  // CEC_USER_CONTROL_CODE_POWER_TOGGLE_FUNCTION
+    {"power-off-function",        0x6C},  // CEC_USER_CONTROL_CODE_POWER_OFF_FUNCTION
+    {"power-on-function",         0x6D},  // CEC_USER_CONTROL_CODE_POWER_ON_FUNCTION
+
+    // Colour and function keys
+    {"blue",                      0x71},  // CEC_USER_CONTROL_CODE_F1_BLUE
+    {"red",                       0x72},  // CEC_USER_CONTROL_CODE_F2_RED
+    {"green",                     0x73},  // CEC_USER_CONTROL_CODE_F3_GREEN
+    {"yellow",                    0x74},  // CEC_USER_CONTROL_CODE_F4_YELLOW
+    {"f5",                        0x75},  // CEC_USER_CONTROL_CODE_F5
+    {"data",                      0x76},  // CEC_USER_CONTROL_CODE_DATA
+
+    // Extensions from CEC 1.4
+    {"return",                    0x91},  // CEC_USER_CONTROL_CODE_AN_RETURN
+    {"channels-list",             0x96},  // CEC_USER_CONTROL_CODE_AN_CHANNELS_LIST
+}};
 
-/** Linear lookup by canonical name. Returns nullptr if no match. */
+/** Hashed lookup by canonical name. Returns nullptr if no match. */
 [[nodiscard]] const KeySpec* findKeyByName(std::string_view name) noexcept;
 
-/** Linear lookup by wire-level code byte. Returns nullptr if no match. */
+/** Direct lookup by wire-level code byte. Returns nullptr if no match. */
 [[nodiscard]] const KeySpec* findKeyByCode(uint8_t code) noexcept;
 
 /**
  * Render the names in @c kKeyCodes, in iteration order, joined by
- * @p separator. Used by the parser's error text and the client help
- * output; keeping the rendering in one place prevents the two call
- * sites from drifting out of sync with the table.
+ * @p separator. With a nonzero @p lineWidth, a name that would run a
+ * line past it starts a new line, prefixed with @p indent, instead;
+ * the caller writes the first line's indent itself. Used by the client
+ * help output, which lists far more names than fit on one line.
  */
-[[nodiscard]] std::string formatKeyNamesList(std::string_view separator);
+[[nodiscard]] std::string formatKeyNamesList(std::string_view separator,
+                                             std::size_t lineWidth = 0,
+                                             std::string_view indent = {});
 
 } // namespace cec_control
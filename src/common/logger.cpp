@@ -1,71 +1,342 @@
 #include "logger.h"
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
-#include <iomanip>
-#include <iostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
 
 namespace cec_control {
 
-Logger& Logger::getInstance() noexcept {
-    static Logger instance;
-    return instance;
+namespace {
+
+constexpr char kNewline = '\n';
+
+// Lines handed to one writev; well under IOV_MAX with two iovecs each.
+constexpr std::size_t kWriteBatch = 64;
+
+// How long the writer sleeps when idle before re-checking the queue.
+// Producers wake it sooner; this only bounds a missed wake-up.
+constexpr auto kWriterIdleWait = std::chrono::milliseconds(100);
+
+// Upper bound on a FATAL line's or flush()'s wait for the writer.
+constexpr auto kFlushTimeout = std::chrono::seconds(2);
+
+/**
+ * Fixed-capacity streambuf over a per-thread array. Output past the
+ * end is dropped and the line marked truncated; nothing allocates.
+ */
+class LineBuffer final : public std::streambuf {
+public:
+    LineBuffer() { reset(); }
+
+    void reset() noexcept {
+        setp(m_data, m_data + Logger::kMaxLineLength);
+        m_truncated = false;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept {
+        return static_cast<std::size_t>(pptr() - m_data);
+    }
+
+    std::string_view view() noexcept {
+        if (m_truncated) {
+            constexpr std::string_view kMarker = "...";
+            std::memcpy(epptr() - kMarker.size(), kMarker.data(), kMarker.size());
+            return {m_data, Logger::kMaxLineLength};
+        }
+        return {m_data, static_cast<std::size_t>(pptr() - m_data)};
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        m_truncated = true;
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        const std::streamsize room = epptr() - pptr();
+        const std::streamsize take = std::min(room, n);
+        std::memcpy(pptr(), s, static_cast<std::size_t>(take));
+        pbump(static_cast<int>(take));
+        if (take < n) m_truncated = true;
+        return n;
+    }
+
+private:
+    char m_data[Logger::kMaxLineLength];
+    bool m_truncated = false;
+};
+
+/** The calling thread's line buffer and the stream over it. */
+struct ThreadLine {
+    LineBuffer            buffer;
+    std::ostream          stream{&buffer};
+    std::ios_base::fmtflags defaultFlags = stream.flags();
+    std::size_t           prefixLength = 0;  ///< Timestamp and level.
+};
+
+ThreadLine& threadLine() {
+    thread_local ThreadLine line;
+    return line;
 }
 
-Logger::~Logger() {
-    if (m_fileStream.is_open()) {
-        m_fileStream.flush();
-        m_fileStream.close();
+/** writev @p count iovecs to @p fd in full, across partial writes. */
+void writeAll(int fd, iovec* iov, int count) noexcept {
+    while (count > 0) {
+        const ssize_t written = ::writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;  // Nowhere left to report a failing log sink.
+        }
+        auto remaining = static_cast<std::size_t>(written);
+        while (count > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
     }
 }
 
-void Logger::configure(const LogConfig& cfg) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+} // namespace
 
-    m_lowSink  = cfg.lowLevelSink;
-    m_highSink = cfg.highLevelSink;
-    m_minLevel.store(cfg.minLevel, std::memory_order_relaxed);
+/**
+ * Bounded multi-producer / single-consumer queue of fixed-size line
+ * slots (Vyukov's sequence-numbered ring). A producer claims a slot
+ * with one CAS on @c head and publishes it by bumping the slot's
+ * sequence; the writer consumes slots in order and hands each back by
+ * advancing its sequence one lap.
+ */
+class Logger::AsyncQueue {
+public:
+    explicit AsyncQueue(std::size_t lines) {
+        std::size_t capacity = 1;
+        while (capacity < std::max<std::size_t>(lines, 2)) capacity <<= 1;
+        m_mask  = capacity - 1;
+        m_cells = std::vector<Cell>(capacity);
+        for (std::size_t i = 0; i < capacity; ++i) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /** Copy @p line into a free slot. False if the queue is full. */
+    bool tryPush(LogLevel level, std::string_view line, std::size_t prefixLength,
+                 const LogContext& context) noexcept {
+        std::size_t pos = m_head.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        cell->level        = level;
+        cell->context      = context;
+        cell->prefixLength = prefixLength;
+        cell->length       = std::min(line.size(), kMaxLineLength);
+        std::memcpy(cell->text, line.data(), cell->length);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Producers' next slot; lines below it are queued or written. */
+    [[nodiscard]] std::size_t pushed() const noexcept {
+        return m_head.load(std::memory_order_acquire);
+    }
 
-    if (m_fileStream.is_open()) {
-        m_fileStream.flush();
-        m_fileStream.close();
+    /** Lines the writer has handed back to the sinks. */
+    [[nodiscard]] std::size_t written() const noexcept {
+        return m_written.load(std::memory_order_acquire);
     }
 
-    if (!cfg.filePath.empty()) {
-        m_fileStream.open(cfg.filePath, std::ios::out | std::ios::app);
-        if (!m_fileStream.is_open()) {
-            // Surface the misconfiguration directly. We avoid the LOG_* macros
-            // here because the logger is mid-reconfigure and the new state is
-            // not yet visible to other threads.
-            std::cerr << "logger: failed to open log file: " << cfg.filePath << '\n';
+    // Writer side. Single consumer, so m_tail is plain.
+
+    /** Published slots from the tail, up to @p max; not yet released. */
+    std::size_t peek(std::size_t max) const noexcept {
+        std::size_t n = 0;
+        while (n < max) {
+            const Cell& cell = m_cells[(m_tail + n) & m_mask];
+            if (cell.seq.load(std::memory_order_acquire) != m_tail + n + 1) break;
+            ++n;
         }
+        return n;
     }
+
+    [[nodiscard]] LogLevel levelAt(std::size_t i) const noexcept {
+        return m_cells[(m_tail + i) & m_mask].level;
+    }
+
+    [[nodiscard]] const LogContext& contextAt(std::size_t i) const noexcept {
+        return m_cells[(m_tail + i) & m_mask].context;
+    }
+
+    /** The line at @p i without its timestamp / level prefix. */
+    [[nodiscard]] std::string_view messageAt(std::size_t i) const noexcept {
+        const Cell& cell = m_cells[(m_tail + i) & m_mask];
+        const std::size_t skip = std::min(cell.prefixLength, cell.length);
+        return {cell.text + skip, cell.length - skip};
+    }
+
+    [[nodiscard]] iovec textAt(std::size_t i) noexcept {
+        Cell& cell = m_cells[(m_tail + i) & m_mask];
+        return iovec{cell.text, cell.length};
+    }
+
+    /** Hand the first @p n peeked slots back to producers. */
+    void release(std::size_t n) noexcept {
+        for (std::size_t i = 0; i < n; ++i) {
+            Cell& cell = m_cells[(m_tail + i) & m_mask];
+            cell.seq.store(m_tail + i + m_mask + 1, std::memory_order_release);
+        }
+        m_tail += n;
+        m_written.store(m_tail, std::memory_order_release);
+    }
+
+    // Writer wake-up. Producers signal only when the writer said it
+    // was going idle, so a busy writer costs them one atomic exchange.
+    std::mutex              wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool>       writerIdle{false};
+    std::atomic<bool>       stopRequested{false};
+    std::thread             writer;
+
+    void wakeWriter() {
+        if (writerIdle.exchange(false, std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            wake.notify_one();
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq{0};
+        LogLevel                 level = LogLevel::INFO;
+        LogContext               context;
+        std::size_t              prefixLength = 0;
+        std::size_t              length = 0;
+        char                     text[kMaxLineLength];
+    };
+
+    std::vector<Cell>        m_cells;
+    std::size_t              m_mask = 0;
+    std::atomic<std::size_t> m_head{0};
+    std::size_t              m_tail = 0;
+    std::atomic<std::size_t> m_written{0};
+};
+
+thread_local LogContext Logger::t_context;
+
+LogContextScope::LogContextScope(const LogContext& overlay) noexcept
+    : m_saved(Logger::t_context) {
+    LogContext& current = Logger::t_context;
+    if (overlay.subsystem != LogSubsystem::None) current.subsystem = overlay.subsystem;
+    if (overlay.logicalAddress >= 0)   current.logicalAddress = overlay.logicalAddress;
+    if (overlay.messageType >= 0)      current.messageType    = overlay.messageType;
+    if (overlay.sessionId != 0)        current.sessionId      = overlay.sessionId;
+}
+
+LogContextScope::~LogContextScope() {
+    Logger::t_context = m_saved;
 }
 
-void Logger::emit(LogLevel level, const std::string& line) {
+Logger& Logger::getInstance() noexcept {
+    static Logger instance;
+    return instance;
+}
+
+Logger::Logger() {
+    publishLevelsLocked();
+}
+
+void Logger::setLevel(LogLevel level) {
     std::lock_guard<std::mutex> lock(m_mutex);
+    m_minLevel = level;
+    publishLevelsLocked();
+}
 
-    const LogSink consoleSink = (level >= LogLevel::WARNING) ? m_highSink : m_lowSink;
-    if (std::ostream* console = sinkStream(consoleSink)) {
-        *console << line << '\n';
-        console->flush();
+void Logger::publishLevelsLocked() noexcept {
+    for (std::size_t i = 0; i < kLogSubsystemCount; ++i) {
+        m_levels[i].store(m_levelOverrides[i].value_or(m_minLevel),
+                          std::memory_order_relaxed);
     }
-    if (m_fileStream.is_open()) {
-        m_fileStream << line << '\n';
-        m_fileStream.flush();
+}
+
+Logger::~Logger() {
+    stopAsync();
+    if (m_fileFd >= 0) {
+        ::close(m_fileFd);
+        m_fileFd = -1;
     }
 }
 
-std::ostream* Logger::sinkStream(LogSink sink) noexcept {
-    switch (sink) {
-        case LogSink::Stdout: return &std::cout;
-        case LogSink::Stderr: return &std::cerr;
-        case LogSink::None:   return nullptr;
+void Logger::configure(const LogConfig& cfg) {
+    // Drain the old writer before the sinks it writes to change.
+    if (!cfg.async) stopAsync();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_lowSink  = cfg.lowLevelSink;
+        m_highSink = cfg.highLevelSink;
+        m_journal  = cfg.journalWriter;
+        m_minLevel       = cfg.minLevel;
+        m_levelOverrides = cfg.subsystemLevels;
+        publishLevelsLocked();
+
+        if (m_fileFd >= 0) {
+            ::close(m_fileFd);
+            m_fileFd = -1;
+        }
+
+        if (!cfg.filePath.empty()) {
+            m_fileFd = ::open(cfg.filePath.c_str(),
+                              O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (m_fileFd < 0) {
+                // Surface the misconfiguration directly. We avoid the LOG_*
+                // macros here because the logger is mid-reconfigure and the
+                // new state is not yet visible to other threads.
+                std::fprintf(stderr, "logger: failed to open log file: %s (%s)\n",
+                             cfg.filePath.c_str(), std::strerror(errno));
+            }
+        }
     }
-    return nullptr;
+
+    if (cfg.async) startAsync(cfg);
 }
 
-std::string Logger::currentTimeString() {
+std::ostream& Logger::beginLine(LogLevel level) {
+    ThreadLine& line = threadLine();
+    line.buffer.reset();
+    // Manipulators such as std::hex stick to a stream; a fresh
+    // ostringstream per line used to reset them implicitly.
+    line.stream.clear();
+    line.stream.flags(line.defaultFlags);
+    line.stream.fill(' ');
+    line.stream.precision(6);
+    line.stream.width(0);
+
     using namespace std::chrono;
     const auto now = system_clock::now();
     const auto t   = system_clock::to_time_t(now);
@@ -74,10 +345,195 @@ std::string Logger::currentTimeString() {
     std::tm tm{};
     localtime_r(&t, &tm);
 
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S")
-        << '.' << std::setfill('0') << std::setw(3) << ms;
-    return oss.str();
+    char stamp[32];
+    const std::size_t len = std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    std::snprintf(stamp + len, sizeof(stamp) - len, ".%03d", static_cast<int>(ms));
+    line.stream << stamp << " [" << levelString(level) << "] ";
+    line.prefixLength = line.buffer.size();
+    return line.stream;
+}
+
+std::string_view Logger::endLine() noexcept {
+    return threadLine().buffer.view();
+}
+
+void Logger::emit(LogLevel level, std::string_view line) {
+    const std::size_t prefixLength = threadLine().prefixLength;
+    const LogContext& context = t_context;
+    // Counted in before the flag is read, both sequentially consistent,
+    // so stopAsync either sees this producer or it sees the flag clear.
+    m_asyncProducers.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_asyncActive.load(std::memory_order_seq_cst)) {
+        m_asyncProducers.fetch_sub(1, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        writeLineLocked(level, line, prefixLength, context);
+        return;
+    }
+
+    AsyncQueue& queue = *m_queue;
+    while (!queue.tryPush(level, line, prefixLength, context)) {
+        if (m_overflow == LogOverflow::Drop && level != LogLevel::FATAL) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            m_asyncProducers.fetch_sub(1, std::memory_order_release);
+            queue.wakeWriter();
+            return;
+        }
+        // The writer runs until every counted producer is done, so a
+        // slot frees up even while stopAsync waits.
+        queue.wakeWriter();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    m_asyncProducers.fetch_sub(1, std::memory_order_release);
+    queue.wakeWriter();
+
+    // A FATAL line is usually the last thing logged before exit; make
+    // sure it, and everything before it, reaches the sinks.
+    if (level == LogLevel::FATAL) flush();
+}
+
+void Logger::flush() {
+    if (!m_asyncActive.load(std::memory_order_acquire)) return;
+    AsyncQueue& queue = *m_queue;
+    const std::size_t target = queue.pushed();
+    const auto deadline = std::chrono::steady_clock::now() + kFlushTimeout;
+    while (queue.written() < target && std::chrono::steady_clock::now() < deadline) {
+        queue.wakeWriter();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Logger::writeLineLocked(LogLevel level, std::string_view line,
+                             std::size_t prefixLength, const LogContext& context) {
+    iovec iov[2] = {
+        {const_cast<char*>(line.data()), line.size()},
+        {const_cast<char*>(&kNewline), 1},
+    };
+    const LogSink sink = level >= LogLevel::WARNING ? m_highSink : m_lowSink;
+    if (sink == LogSink::Journal && m_journal != nullptr) {
+        m_journal(level, line.substr(std::min(prefixLength, line.size())), context);
+    }
+    const int console = sinkFd(sink);
+    if (console >= 0) {
+        iovec copy[2] = {iov[0], iov[1]};
+        writeAll(console, copy, 2);
+    }
+    if (m_fileFd >= 0) writeAll(m_fileFd, iov, 2);
+}
+
+void Logger::startAsync(const LogConfig& cfg) {
+    if (m_asyncActive.load(std::memory_order_acquire)) return;
+    if (!m_queue) m_queue = std::make_unique<AsyncQueue>(cfg.asyncQueueLines);
+    m_overflow = cfg.overflow;
+    m_queue->stopRequested.store(false, std::memory_order_relaxed);
+    m_queue->writer = std::thread([this]() { drainLoop(); });
+    m_asyncActive.store(true, std::memory_order_release);
+}
+
+void Logger::stopAsync() {
+    if (!m_asyncActive.exchange(false, std::memory_order_seq_cst)) return;
+    // Producers that already saw the flag set may still push; once
+    // they are done, the writer drains until the queue is empty after
+    // the stop request.
+    while (m_asyncProducers.load(std::memory_order_acquire) != 0) {
+        m_queue->wakeWriter();
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queue->wakeMutex);
+        m_queue->stopRequested.store(true, std::memory_order_release);
+        m_queue->wake.notify_one();
+    }
+    if (m_queue->writer.joinable()) m_queue->writer.join();
+}
+
+void Logger::drainLoop() {
+    ::pthread_setname_np(::pthread_self(), "cec-log");
+    AsyncQueue& queue = *m_queue;
+    uint64_t reportedDrops = 0;
+
+    for (;;) {
+        const std::size_t ready = queue.peek(kWriteBatch);
+        if (ready == 0) {
+            if (queue.stopRequested.load(std::memory_order_acquire)) return;
+            std::unique_lock<std::mutex> lock(queue.wakeMutex);
+            queue.writerIdle.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // Re-check after advertising idleness: a producer that
+            // pushed before seeing the flag did not signal.
+            if (queue.peek(1) == 0 &&
+                !queue.stopRequested.load(std::memory_order_acquire)) {
+                queue.wake.wait_for(lock, kWriterIdleWait);
+            }
+            queue.writerIdle.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        // One iovec list per destination, each in queue order. When both
+        // console bands share a stream they share a list too, so their
+        // lines do not reorder against each other.
+        iovec low[kWriteBatch * 2 + 2];
+        iovec high[kWriteBatch * 2 + 2];
+        iovec file[kWriteBatch * 2 + 2];
+        int lowCount = 0, highCount = 0, fileCount = 0;
+        const iovec newline{const_cast<char*>(&kNewline), 1};
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const int  lowFd    = sinkFd(m_lowSink);
+        const int  highFd   = sinkFd(m_highSink);
+        const bool shared   = lowFd == highFd;
+        iovec*     highList = shared ? low : high;
+        int&       highN    = shared ? lowCount : highCount;
+
+        const uint64_t drops = m_dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            beginLine(LogLevel::WARNING) << "Logger queue full; dropped "
+                                         << (drops - reportedDrops) << " line(s)";
+            const std::string_view notice = endLine();
+            reportedDrops = drops;
+            if (m_highSink == LogSink::Journal && m_journal != nullptr) {
+                m_journal(LogLevel::WARNING, notice.substr(threadLine().prefixLength),
+                          LogContext{});
+            }
+            const iovec text{const_cast<char*>(notice.data()), notice.size()};
+            highList[highN++] = text;
+            highList[highN++] = newline;
+            file[fileCount++] = text;
+            file[fileCount++] = newline;
+        }
+
+        for (std::size_t i = 0; i < ready; ++i) {
+            const iovec   text  = queue.textAt(i);
+            const LogLevel level = queue.levelAt(i);
+            // Journal entries go out one call each, in queue order.
+            if ((level >= LogLevel::WARNING ? m_highSink : m_lowSink) == LogSink::Journal &&
+                m_journal != nullptr) {
+                m_journal(level, queue.messageAt(i), queue.contextAt(i));
+            }
+            if (level >= LogLevel::WARNING) {
+                highList[highN++] = text;
+                highList[highN++] = newline;
+            } else {
+                low[lowCount++] = text;
+                low[lowCount++] = newline;
+            }
+            file[fileCount++] = text;
+            file[fileCount++] = newline;
+        }
+        if (lowFd >= 0 && lowCount > 0) writeAll(lowFd, low, lowCount);
+        if (highFd >= 0 && highCount > 0) writeAll(highFd, high, highCount);
+        if (m_fileFd >= 0) writeAll(m_fileFd, file, fileCount);
+        queue.release(ready);
+    }
+}
+
+int Logger::sinkFd(LogSink sink) noexcept {
+    switch (sink) {
+        case LogSink::Stdout:  return STDOUT_FILENO;
+        case LogSink::Stderr:  return STDERR_FILENO;
+        case LogSink::Journal: return -1;  // Not a stream; see JournalWriter.
+        case LogSink::None:    return -1;
+    }
+    return -1;
 }
 
 const char* Logger::levelString(LogLevel level) noexcept {
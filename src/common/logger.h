@@ -1,11 +1,15 @@
 #pragma once
 
+#include <array>
 #include <atomic>
-#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <ostream>
-#include <sstream>
 #include <string>
+#include <string_view>
 
 namespace cec_control {
 
@@ -18,32 +22,126 @@ enum class LogLevel : int {
     FATAL
 };
 
+/**
+ * Lowest level compiled into the binary, as a @c LogLevel value; set
+ * from the @c CEC_CONTROL_MIN_LOG_LEVEL CMake option. @c LOG_* calls
+ * below it are discarded at compile time, arguments and all.
+ */
+#ifndef CEC_CONTROL_MIN_LOG_LEVEL
+#define CEC_CONTROL_MIN_LOG_LEVEL 0
+#endif
+inline constexpr LogLevel kCompiledMinLevel =
+    static_cast<LogLevel>(CEC_CONTROL_MIN_LOG_LEVEL);
+
+/**
+ * Where in the daemon a line was logged, taken from the calling
+ * thread's @c LogContext. Each has its own runtime level (see
+ * @c LogConfig::subsystemLevels); None is everything untagged.
+ */
+enum class LogSubsystem : uint8_t {
+    None,
+    Daemon,   ///< Main thread: event loop, socket server, dispatcher.
+    Adapter,  ///< The adapter worker thread.
+    Libcec,   ///< libcec's callback threads.
+};
+inline constexpr std::size_t kLogSubsystemCount = 4;
+
 /**
  * A console destination for log lines. None discards the line for that
  * severity band; the file sink (if configured) still receives it.
+ *
+ * Journal hands each line to @c LogConfig::journalWriter, which sends
+ * it to systemd-journald over its native protocol rather than as text
+ * on a stream: the entry carries @c PRIORITY and the calling thread's
+ * @c LogContext as fields, and its @c MESSAGE omits the timestamp and
+ * level prefix, which the journal records itself.
  */
 enum class LogSink {
     None,
     Stdout,
-    Stderr
+    Stderr,
+    Journal
+};
+
+/** What an asynchronous producer does when the queue is full. */
+enum class LogOverflow {
+    /** Discard the line and count it; the writer reports the count. */
+    Drop,
+    /** Wait for the writer to free a slot. */
+    Block
+};
+
+/**
+ * Structured context attached to every line a thread logs while it is
+ * in effect. Journal entries carry the set fields as @c CEC_SUBSYSTEM,
+ * @c CEC_LOGICAL_ADDRESS, @c CEC_MESSAGE_TYPE (the wire value) and
+ * @c CEC_SESSION_ID; the text sinks ignore it. Unset fields are the
+ * default values below.
+ */
+struct LogContext {
+    LogSubsystem subsystem      = LogSubsystem::None;
+    int          logicalAddress = -1;
+    int          messageType    = -1;
+    uint64_t     sessionId      = 0;
+};
+
+/**
+ * Overlays the set fields of a @c LogContext onto the calling thread's
+ * context for the lifetime of the scope, restoring the previous
+ * context on exit. Costs two small copies; nothing allocates.
+ */
+class LogContextScope {
+public:
+    explicit LogContextScope(const LogContext& overlay) noexcept;
+    ~LogContextScope();
+
+    LogContextScope(const LogContextScope&)            = delete;
+    LogContextScope& operator=(const LogContextScope&) = delete;
+
+private:
+    LogContext m_saved;
 };
 
+/**
+ * Delivers one @c LogSink::Journal line: @p message has no text prefix
+ * and @p context becomes the entry's fields. A pointer rather than a
+ * call into libsystemd so that the logger, and the client library it is
+ * part of, do not link it; the daemon passes @c sendToJournal from
+ * journal_sink.h.
+ */
+using JournalWriter = void (*)(LogLevel level, std::string_view message,
+                               const LogContext& context) noexcept;
+
 /**
  * Logger configuration. Pass to Logger::configure() to redirect output.
  *
  * Console sinks are split by severity: messages strictly below WARNING go to
  * lowLevelSink (typically stdout); WARNING and above go to highLevelSink
  * (typically stderr). systemd-journald captures both streams when running
- * under a unit, so the split surfaces severity to the journal automatically.
+ * under a unit, so the split surfaces severity to the journal automatically;
+ * routing both bands to LogSink::Journal instead hands journald structured
+ * entries directly.
  *
  * filePath, when non-empty, opens a log file in append mode that receives
  * every message at minLevel and above, regardless of console routing.
+ *
+ * async moves all sink I/O onto a dedicated writer thread: a log call
+ * formats into its thread's buffer, copies the line into a preallocated
+ * queue of asyncQueueLines slots, and returns. overflow decides what
+ * happens when that queue is full.
  */
 struct LogConfig {
-    LogSink     lowLevelSink  = LogSink::None;
-    LogSink     highLevelSink = LogSink::None;
+    LogSink     lowLevelSink    = LogSink::None;
+    LogSink     highLevelSink   = LogSink::None;
     std::string filePath;
-    LogLevel    minLevel      = LogLevel::INFO;
+    LogLevel    minLevel        = LogLevel::INFO;
+    bool        async           = false;
+    std::size_t asyncQueueLines = 1024;
+    LogOverflow overflow        = LogOverflow::Drop;
+    /** Per-subsystem replacements for minLevel; unset = minLevel. */
+    std::array<std::optional<LogLevel>, kLogSubsystemCount> subsystemLevels{};
+    /** Required by a Journal sink; without one, Journal discards as None does. */
+    JournalWriter journalWriter = nullptr;
 };
 
 /**
@@ -53,31 +151,77 @@ struct LogConfig {
  * that want output must invoke configure() explicitly. This keeps code paths
  * that should never print (help printing, client invocations) from leaking
  * diagnostics onto stdout/stderr.
+ *
+ * Every line is formatted into a per-thread buffer of @c kMaxLineLength
+ * bytes, allocated once per thread; longer lines are truncated. In the
+ * default synchronous mode the line is then written to each sink under
+ * a mutex. In asynchronous mode (@c LogConfig::async) it is pushed onto
+ * a bounded lock-free multi-producer queue instead, and a writer thread
+ * drains the queue in batches with one @c writev per sink — so a slow
+ * log disk no longer stalls libcec's callback thread. A FATAL line, and
+ * @c flush, wait for everything queued before them to be written.
  */
 class Logger {
 public:
+    /** Longest line, timestamp and level included, before truncation. */
+    static constexpr std::size_t kMaxLineLength = 1024;
+
     static Logger& getInstance() noexcept;
 
-    /** Replace the active configuration. Serialised against in-flight log() calls. */
+    /**
+     * Replace the active configuration. Serialised against in-flight
+     * synchronous writes and against the writer thread's batches;
+     * switching @c async off drains the queue first.
+     */
     void configure(const LogConfig& cfg);
 
     /**
-     * Lock-free level update. Equivalent to configure() that touches only
-     * the minLevel field. Useful for raising/lowering verbosity at runtime.
+     * Level update. Equivalent to configure() that touches only the
+     * minLevel field: subsystems with their own level keep it.
      */
-    void setLevel(LogLevel level) noexcept {
-        m_minLevel.store(level, std::memory_order_relaxed);
+    void setLevel(LogLevel level);
+
+    /**
+     * Whether a line at @p level from the calling thread would be
+     * written: one thread-local read and one relaxed load.
+     */
+    [[nodiscard]] bool enabled(LogLevel level) const noexcept {
+        return enabled(level, t_context.subsystem);
+    }
+
+    [[nodiscard]] bool enabled(LogLevel level, LogSubsystem subsystem) const noexcept {
+        return level >= m_levels[static_cast<std::size_t>(subsystem)]
+                            .load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Block until every line logged before the call has reached its
+     * sinks. No-op in synchronous mode.
+     */
+    void flush();
+
+    /**
+     * The calling thread's current @c LogContext, for handing work to
+     * another thread with its context (see @c AdapterWorker).
+     */
+    [[nodiscard]] static LogContext context() noexcept { return t_context; }
+
+    /** Lines discarded by a full asynchronous queue since startup. */
+    [[nodiscard]] uint64_t droppedCount() const noexcept {
+        return m_dropped.load(std::memory_order_relaxed);
     }
 
     template <typename... Args>
     void log(LogLevel level, const Args&... args) {
-        if (level < m_minLevel.load(std::memory_order_relaxed)) {
-            return;
-        }
-        std::ostringstream oss;
-        oss << currentTimeString() << " [" << levelString(level) << "] ";
-        ((oss << args), ...);
-        emit(level, oss.str());
+        if (enabled(level)) write(level, args...);
+    }
+
+    /** Format and emit without the level check; see @c CEC_CONTROL_LOG. */
+    template <typename... Args>
+    void write(LogLevel level, const Args&... args) {
+        std::ostream& line = beginLine(level);
+        ((line << args), ...);
+        emit(level, endLine());
     }
 
     template <typename... Args> void debug  (const Args&... a) { log(LogLevel::DEBUG,   a...); }
@@ -88,29 +232,90 @@ public:
     template <typename... Args> void fatal  (const Args&... a) { log(LogLevel::FATAL,   a...); }
 
 private:
-    Logger() = default;
+    friend class LogContextScope;
+    class AsyncQueue;
+
+    Logger();
     ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    void emit(LogLevel level, const std::string& line);
+    /**
+     * The calling thread's line stream, reset to default formatting and
+     * already holding the timestamp and level prefix.
+     */
+    static std::ostream& beginLine(LogLevel level);
+
+    /** Text formatted on the calling thread since @c beginLine. */
+    static std::string_view endLine() noexcept;
+
+    void emit(LogLevel level, std::string_view line);
+
+    /**
+     * Under @c m_mutex: write @p line to every sink for @p level. The
+     * first @p prefixLength bytes are the timestamp / level prefix,
+     * left out of journal entries; @p context is their fields.
+     */
+    void writeLineLocked(LogLevel level, std::string_view line,
+                         std::size_t prefixLength, const LogContext& context);
+
+    /** Writer-thread body for asynchronous mode. */
+    void drainLoop();
+
+    /** Start / stop (after draining) the asynchronous writer. */
+    void startAsync(const LogConfig& cfg);
+    void stopAsync();
+
+    /** Under @c m_mutex: recompute @c m_levels from the configuration. */
+    void publishLevelsLocked() noexcept;
 
-    static std::string currentTimeString();
     static const char* levelString(LogLevel level) noexcept;
-    static std::ostream* sinkStream(LogSink sink) noexcept;
+    static int sinkFd(LogSink sink) noexcept;
 
-    std::atomic<LogLevel> m_minLevel{LogLevel::INFO};
+    // The calling thread's context; see LogContextScope.
+    static thread_local LogContext t_context;
+
+    // Effective level per LogSubsystem: the override if set, else
+    // m_minLevel. Written under m_mutex, read lock-free.
+    std::array<std::atomic<LogLevel>, kLogSubsystemCount> m_levels;
+    std::array<std::optional<LogLevel>, kLogSubsystemCount> m_levelOverrides{};
+    LogLevel   m_minLevel = LogLevel::INFO;
     std::mutex m_mutex;
     LogSink m_lowSink  = LogSink::None;
     LogSink m_highSink = LogSink::None;
-    std::ofstream m_fileStream;
+    JournalWriter m_journal = nullptr;
+    int     m_fileFd   = -1;
+
+    // Asynchronous mode. Producers reach the queue only through
+    // m_asyncActive, so switching modes never frees memory a producer
+    // may still be writing into: a queue, once created, lives as long
+    // as the logger. m_asyncProducers counts producers between that
+    // check and their push; stopAsync waits for it to reach zero
+    // before the writer's last drain, so no line is pushed after it.
+    std::unique_ptr<AsyncQueue> m_queue;
+    std::atomic<bool>           m_asyncActive{false};
+    std::atomic<uint32_t>       m_asyncProducers{0};
+    LogOverflow                 m_overflow = LogOverflow::Drop;
+    std::atomic<uint64_t>       m_dropped{0};
 };
 
-#define LOG_DEBUG(...)   ::cec_control::Logger::getInstance().debug(__VA_ARGS__)
-#define LOG_TRAFFIC(...) ::cec_control::Logger::getInstance().traffic(__VA_ARGS__)
-#define LOG_INFO(...)    ::cec_control::Logger::getInstance().info(__VA_ARGS__)
-#define LOG_WARNING(...) ::cec_control::Logger::getInstance().warning(__VA_ARGS__)
-#define LOG_ERROR(...)   ::cec_control::Logger::getInstance().error(__VA_ARGS__)
-#define LOG_FATAL(...)   ::cec_control::Logger::getInstance().fatal(__VA_ARGS__)
+/**
+ * Log at @p level. Below @c kCompiledMinLevel the statement compiles
+ * to nothing; below the runtime level its arguments are not evaluated.
+ */
+#define CEC_CONTROL_LOG(level, ...)                                           \
+    do {                                                                      \
+        if constexpr ((level) >= ::cec_control::kCompiledMinLevel) {          \
+            auto& cecLogger_ = ::cec_control::Logger::getInstance();          \
+            if (cecLogger_.enabled(level)) cecLogger_.write((level), __VA_ARGS__); \
+        }                                                                     \
+    } while (false)
+
+#define LOG_DEBUG(...)   CEC_CONTROL_LOG(::cec_control::LogLevel::DEBUG,   __VA_ARGS__)
+#define LOG_TRAFFIC(...) CEC_CONTROL_LOG(::cec_control::LogLevel::TRAFFIC, __VA_ARGS__)
+#define LOG_INFO(...)    CEC_CONTROL_LOG(::cec_control::LogLevel::INFO,    __VA_ARGS__)
+#define LOG_WARNING(...) CEC_CONTROL_LOG(::cec_control::LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...)   CEC_CONTROL_LOG(::cec_control::LogLevel::ERROR,   __VA_ARGS__)
+#define LOG_FATAL(...)   CEC_CONTROL_LOG(::cec_control::LogLevel::FATAL,   __VA_ARGS__)
 
 } // namespace cec_control
@@ -0,0 +1,62 @@
+#include "loop_timer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "event_loop.h"
+
+namespace cec_control {
+
+LoopTimer::LoopTimer(EventLoop& loop) noexcept : m_loop(loop) {}
+
+bool LoopTimer::valid() const noexcept {
+    return m_loop.timersValid();
+}
+
+bool LoopTimer::armOnce(std::chrono::milliseconds d) {
+    if (d.count() < 0) {
+        disarm();
+        return false;
+    }
+    if (!valid()) return false;
+    m_period  = 0;
+    m_pending = 0;
+    m_loop.scheduleTimer(*this, EventLoop::timerNow() + static_cast<uint64_t>(d.count()));
+    return true;
+}
+
+bool LoopTimer::armPeriodic(std::chrono::milliseconds period) {
+    if (period.count() <= 0 || !valid()) return false;
+    m_period  = static_cast<uint64_t>(period.count());
+    m_pending = 0;
+    m_loop.scheduleTimer(*this, EventLoop::timerNow() + m_period);
+    return true;
+}
+
+void LoopTimer::disarm() noexcept {
+    m_loop.cancelTimer(*this);
+    m_period  = 0;
+    m_pending = 0;
+}
+
+uint64_t LoopTimer::consume() noexcept {
+    return std::exchange(m_pending, 0);
+}
+
+void LoopTimer::expire() {
+    if (m_period > 0) {
+        // Re-arm before the handler runs so it may disarm or re-arm
+        // freely; skip ahead rather than replay ticks already missed.
+        const uint64_t next = std::max(expires() + m_period, EventLoop::timerNow() + 1);
+        m_loop.scheduleTimer(*this, next);
+    }
+    ++m_pending;
+    // Run a copy: the handler may destroy this timer, and with it
+    // m_handler, before it returns.
+    if (m_handler) {
+        const Handler handler = m_handler;
+        handler();
+    }
+}
+
+} // namespace cec_control
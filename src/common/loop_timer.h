@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "timer_wheel.h"
+
+namespace cec_control {
+
+class EventLoop;
+
+/**
+ * A deadline on an EventLoop's shared timer wheel.
+ *
+ * Same surface as TimerSource — armOnce(), armPeriodic(), disarm(),
+ * consume() — but without an fd of its own: instead of registering a
+ * descriptor with the loop, the owner installs a handler with
+ * setHandler(), and the loop calls it when the timer expires. Arming
+ * and disarming cost no syscall, so a timer that is re-armed on every
+ * request is cheap.
+ *
+ * Resolution is one millisecond on the steady clock. A periodic timer
+ * is re-armed from its previous deadline, so a late dispatch does not
+ * drift the schedule; ticks missed entirely (a blocked loop, a suspend
+ * the monotonic clock does not count) coalesce into one expiry rather
+ * than a burst.
+ *
+ * Main thread only, like the loop it belongs to; the loop must outlive
+ * any call on the timer.
+ */
+class LoopTimer final : private TimerWheel::Node {
+public:
+    using Handler = std::function<void()>;
+
+    explicit LoopTimer(EventLoop& loop) noexcept;
+    ~LoopTimer() override = default;
+
+    /** @c false if the loop's timer wheel is unusable. */
+    [[nodiscard]] bool valid() const noexcept;
+
+    /**
+     * Callback run on each expiry. Replaces any previous handler; an
+     * expiry with no handler installed only counts towards consume().
+     * The handler may destroy the timer it runs from.
+     */
+    void setHandler(Handler handler) { m_handler = std::move(handler); }
+
+    /**
+     * Fire once after @p d, replacing any prior arming; zero fires on
+     * the next loop dispatch. A negative duration disarms and returns
+     * @c false, as TimerSource does.
+     */
+    [[nodiscard]] bool armOnce(std::chrono::milliseconds d);
+
+    /**
+     * Fire every @p period, first after one period. A zero or negative
+     * period returns @c false and leaves the timer untouched.
+     */
+    [[nodiscard]] bool armPeriodic(std::chrono::milliseconds period);
+
+    /** Cancel the current arming and any unconsumed expiry. Idempotent. */
+    void disarm() noexcept;
+
+    /** @c true while armed. */
+    [[nodiscard]] bool armed() const noexcept { return scheduled(); }
+
+    /**
+     * Expiries since the last consume() or arming (normally 1 inside the
+     * handler), resetting the count.
+     */
+    uint64_t consume() noexcept;
+
+private:
+    void expire() override;
+
+    EventLoop& m_loop;
+    Handler    m_handler;
+    uint64_t   m_period  = 0;  // Milliseconds; 0 for a one-shot.
+    uint64_t   m_pending = 0;
+};
+
+} // namespace cec_control
@@ -1,43 +1,132 @@
 #include "main_thread_work.h"
 #include "logger.h"
+#include "trace.h"
 
 #include <sys/eventfd.h>
 #include <unistd.h>
 #include <cerrno>
 #include <cstring>
-#include <utility>
+#include <exception>
 
 namespace cec_control {
 
-MainThreadWork::MainThreadWork() {
+namespace {
+
+constexpr uint64_t kSlotMask = 0xffffffffu;
+
+/** Free-list head with @p slot on top, one tag past @p previous. */
+constexpr uint64_t freeHead(uint64_t previous, uint32_t slot) noexcept {
+    return (((previous >> 32) + 1) << 32) | slot;
+}
+
+} // namespace
+
+MainThreadWork::MainThreadWork() : m_pool(new Node[kPoolNodes]) {
     m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
     if (m_wakeFd < 0) {
         LOG_ERROR("Failed to create MainThreadWork eventfd: ",
                   std::strerror(errno));
     }
+    // Chain every slot onto the free list; nothing else runs yet.
+    for (uint32_t slot = 1; slot <= kPoolNodes; ++slot) {
+        Node& node = m_pool[slot - 1];
+        node.poolSlot = slot;
+        node.freeNext.store(slot < kPoolNodes ? slot + 1 : 0, std::memory_order_relaxed);
+    }
+    m_free.store(1, std::memory_order_release);
 }
 
 MainThreadWork::~MainThreadWork() {
+    // Closures still queued are destroyed unrun, as at shutdown.
+    while (Node* node = unlink()) {
+        node->work.reset();
+        release(node);
+    }
     if (m_wakeFd >= 0) {
         ::close(m_wakeFd);
         m_wakeFd = -1;
     }
 }
 
-void MainThreadWork::post(std::function<void()> work) {
-    if (!work) return;
+MainThreadWork::Node* MainThreadWork::acquire() {
+    uint64_t head = m_free.load(std::memory_order_acquire);
+    while (true) {
+        const auto slot = static_cast<uint32_t>(head & kSlotMask);
+        if (slot == 0) {
+            return new Node;  // Pool exhausted; poolSlot 0 marks it.
+        }
+        Node& node = m_pool[slot - 1];
+        const uint32_t next = node.freeNext.load(std::memory_order_relaxed);
+        if (m_free.compare_exchange_weak(head, freeHead(head, next),
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire)) {
+            return &node;
+        }
+    }
+}
 
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_pending.push_back(std::move(work));
+void MainThreadWork::release(Node* node) noexcept {
+    if (node->poolSlot == 0) {
+        delete node;
+        return;
     }
+    uint64_t head = m_free.load(std::memory_order_relaxed);
+    do {
+        node->freeNext.store(static_cast<uint32_t>(head & kSlotMask),
+                             std::memory_order_relaxed);
+    } while (!m_free.compare_exchange_weak(head, freeHead(head, node->poolSlot),
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+void MainThreadWork::link(Node* node) noexcept {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = m_back.exchange(node, std::memory_order_acq_rel);
+    // Between the exchange and this store the node is unreachable from
+    // the front; unlink() treats that as an empty queue, and this
+    // post's wake() brings the main thread back for it.
+    previous->next.store(node, std::memory_order_release);
+}
 
+void MainThreadWork::wake() noexcept {
+    Tracer::getInstance().instant(TracePoint::MainThreadPost);
+
+    // Only the first post since the last drain writes the eventfd; the
+    // acq_rel exchange makes every link before it visible to the
+    // drain that clears the flag.
+    if (m_wakePending.exchange(true, std::memory_order_acq_rel)) return;
     if (m_wakeFd < 0) return;
     const uint64_t one = 1;
     ssize_t r = ::write(m_wakeFd, &one, sizeof(one));
     (void)r;  // Best-effort wake; counter saturation is harmless.
 }
 
+MainThreadWork::Node* MainThreadWork::unlink() noexcept {
+    Node* front = m_front;
+    Node* next  = front->next.load(std::memory_order_acquire);
+    if (front == &m_stub) {
+        if (next == nullptr) return nullptr;
+        m_front = front = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        m_front = next;
+        return front;
+    }
+    if (front != m_back.load(std::memory_order_acquire)) {
+        return nullptr;  // A post is between its exchange and its link.
+    }
+    // front is the last node; park the stub behind it so front can be
+    // handed out without leaving the queue without a node.
+    link(&m_stub);
+    next = front->next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        m_front = next;
+        return front;
+    }
+    return nullptr;
+}
+
 void MainThreadWork::drain() {
     if (m_wakeFd >= 0) {
         // Clear the counter so epoll won't re-fire before new work arrives.
@@ -46,23 +135,39 @@ void MainThreadWork::drain() {
             // eventfd delivers the current sum and resets to zero.
         }
     }
+    // Re-open the wake before collecting, so a post that lands after
+    // the collection below writes the eventfd again.
+    m_wakePending.exchange(false, std::memory_order_acq_rel);
 
-    std::vector<std::function<void()>> batch;
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        batch.swap(m_pending);
+    // Collect first, then run: closures that post() more work are left
+    // for the next drain. A popped node's next is ours to reuse.
+    Node* first = nullptr;
+    Node* last  = nullptr;
+    while (Node* node = unlink()) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        if (last) {
+            last->next.store(node, std::memory_order_relaxed);
+        } else {
+            first = node;
+        }
+        last = node;
     }
 
-    // Run outside the lock so closures that post() additional work don't
-    // self-deadlock; the new items wait for the next drain().
-    for (auto& work : batch) {
-        try {
-            work();
-        } catch (const std::exception& e) {
-            LOG_ERROR("MainThreadWork closure threw: ", e.what());
-        } catch (...) {
-            LOG_ERROR("MainThreadWork closure threw non-std exception");
+    for (Node* node = first; node != nullptr;) {
+        Node* next = node->next.load(std::memory_order_relaxed);
+        {
+            const TraceScope span(TracePoint::MainThreadWork);
+            try {
+                node->work();
+            } catch (const std::exception& e) {
+                LOG_ERROR("MainThreadWork closure threw: ", e.what());
+            } catch (...) {
+                LOG_ERROR("MainThreadWork closure threw non-std exception");
+            }
         }
+        node->work.reset();
+        release(node);
+        node = next;
     }
 }
 
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <functional>
-#include <mutex>
-#include <vector>
+#include <memory>
+#include <utility>
+
+#include "inline_function.h"
 
 namespace cec_control {
 
@@ -21,9 +24,31 @@ namespace cec_control {
  * and so on. Keeps the main loop the sole owner of sd-bus, signal,
  * and other non-reentrant state without scattering atomic flags
  * across the daemon.
+ *
+ * Every worker completion and bus observation passes through here, so
+ * posting takes no lock and usually no allocation. The queue is an
+ * intrusive lock-free MPSC list (Vyukov's, with a stub node): a post
+ * is one atomic exchange and one store. Each closure is held inline in
+ * its node as a @c Closure of @c kInlineBytes — a larger capture list
+ * does not compile — and nodes come from a preallocated pool of
+ * @c kPoolNodes, so only an exhausted pool reaches the heap. The eventfd is written only
+ * by the post that finds no wake already pending, so a burst of posts
+ * between two drains costs one syscall rather than one each.
  */
 class MainThreadWork {
 public:
+    /**
+     * Closure bytes stored inside a queue node. Fits a reply hop that
+     * carries a sink, the finished command and its response.
+     */
+    static constexpr std::size_t kInlineBytes = 128;
+
+    /** A posted closure as it sits in its node. */
+    using Closure = InlineFunction<void(), kInlineBytes>;
+
+    /** Nodes preallocated for posts; beyond this, posts allocate. */
+    static constexpr std::size_t kPoolNodes = 256;
+
     MainThreadWork();
     ~MainThreadWork();
 
@@ -37,11 +62,14 @@ public:
     int fd() const noexcept { return m_wakeFd; }
 
     /**
-     * Enqueue @p work and wake the main loop. Safe to call from any
-     * thread, including signal-adjacent contexts with the caveat that
-     * allocating a std::function is not async-signal-safe.
+     * Enqueue @p work (any callable taking no arguments that fits a
+     * @c Closure) and wake the main loop. Safe to call from any
+     * thread. Not async-signal-safe: the closure's own copy may
+     * allocate, and so may a post that finds the node pool empty. An
+     * empty callable is ignored.
      */
-    void post(std::function<void()> work);
+    template <typename F>
+    void post(F&& work);
 
     /**
      * Drain the queue and run every pending closure in FIFO order. Must
@@ -51,9 +79,60 @@ public:
     void drain();
 
 private:
+    struct Node {
+        std::atomic<Node*>    next{nullptr};
+        // Free-list link as a 1-based pool slot; atomic because a
+        // racing acquire may read it while the list is being changed.
+        std::atomic<uint32_t> freeNext{0};
+        uint32_t              poolSlot = 0;  // 1-based; 0 = heap node.
+        Closure               work;          // Empty while the node is free.
+    };
+
+    /** A node from the pool, or from the heap when the pool is empty. */
+    [[nodiscard]] Node* acquire();
+
+    /**
+     * Return @p node, its closure already reset, to the pool or the
+     * heap. Main thread only.
+     */
+    void release(Node* node) noexcept;
+
+    /** Append @p node to the queue. Any thread. */
+    void link(Node* node) noexcept;
+
+    /** Make a drain happen after an append. Any thread. */
+    void wake() noexcept;
+
+    /** Pop the oldest linked node, or null. Main thread only. */
+    [[nodiscard]] Node* unlink() noexcept;
+
     int m_wakeFd = -1;
-    std::mutex m_mutex;
-    std::vector<std::function<void()>> m_pending;
+
+    // Producers exchange onto the back; the main thread owns the front.
+    Node               m_stub;
+    std::atomic<Node*> m_back{&m_stub};
+    Node*              m_front = &m_stub;
+
+    // Set by the post that writes the eventfd, cleared by drain.
+    std::atomic<bool>  m_wakePending{false};
+
+    // Treiber stack of free pool slots: (tag << 32) | slot, slot
+    // 1-based and 0 when empty. The tag changes on every update so a
+    // slot popped and pushed back between another thread's read and
+    // its CAS cannot be mistaken for an unchanged head.
+    std::unique_ptr<Node[]> m_pool;
+    std::atomic<uint64_t>   m_free{0};
 };
 
+template <typename F>
+void MainThreadWork::post(F&& work) {
+    Closure closure(std::forward<F>(work));
+    if (!closure) return;
+
+    Node* node = acquire();
+    node->work = std::move(closure);
+    link(node);
+    wake();
+}
+
 } // namespace cec_control
@@ -1,5 +1,9 @@
 #include "messages.h"
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
 namespace cec_control {
 
 bool isKnownMessageType(uint8_t raw) noexcept {
@@ -15,19 +19,48 @@ bool isKnownMessageType(uint8_t raw) noexcept {
         case MessageType::CMD_RESUME:
         case MessageType::CMD_AUTO_STANDBY:
         case MessageType::CMD_KEY:
+        case MessageType::CMD_BATCH:
+        case MessageType::CMD_QUERY_STATUS:
+        case MessageType::CMD_QUERY_DEVICES:
+        case MessageType::CMD_QUERY_ACTIVE_SOURCE:
+        case MessageType::CMD_STATS:
+        case MessageType::CMD_TRACE:
+        case MessageType::CMD_SUBSCRIBE:
+        case MessageType::CMD_SCENE:
+        case MessageType::CMD_VOLUME_SET:
+        case MessageType::CMD_KEY_DOWN:
+        case MessageType::CMD_KEY_UP:
+        case MessageType::CMD_RAW_TRANSMIT:
+        case MessageType::CMD_KEY_SEQUENCE:
+        case MessageType::CMD_HELLO:
         case MessageType::RESP_SUCCESS:
         case MessageType::RESP_ERROR:
+        case MessageType::RESP_BUSY:
+        case MessageType::RESP_EVENT:
+        case MessageType::RESP_NOT_READY:
+        case MessageType::RESP_UNREACHABLE:
+        case MessageType::RESP_RATE_LIMITED:
             return true;
     }
     return false;
 }
 
+std::size_t Message::serializeTo(uint8_t* out, std::size_t capacity) const noexcept {
+    const std::size_t len = wireSize();
+    if (len > capacity) {
+        return 0;
+    }
+    out[0] = static_cast<uint8_t>(type);
+    out[1] = deviceId;
+    if (!data.empty()) {
+        std::memcpy(out + 2, data.data(), data.size());
+    }
+    return len;
+}
+
 std::vector<uint8_t> Message::serialize() const {
-    std::vector<uint8_t> out;
-    out.reserve(2 + data.size());
-    out.push_back(static_cast<uint8_t>(type));
-    out.push_back(deviceId);
-    out.insert(out.end(), data.begin(), data.end());
+    std::vector<uint8_t> out(wireSize());
+    serializeTo(out.data(), out.size());
     return out;
 }
 
@@ -42,11 +75,358 @@ std::optional<Message> Message::deserialize(const uint8_t* data, std::size_t len
     return Message(
         static_cast<MessageType>(data[0]),
         data[1],
-        std::vector<uint8_t>(data + 2, data + len));
+        InlineBytes(data + 2, len - 2));
 }
 
 std::optional<Message> Message::deserialize(const std::vector<uint8_t>& data) {
     return deserialize(data.data(), data.size());
 }
 
+std::size_t serializeFrameTo(RequestId requestId, const Message& message,
+                             uint8_t* out, std::size_t capacity) noexcept {
+    if (capacity < kFrameHeaderSize) {
+        return 0;
+    }
+    const std::size_t body = message.serializeTo(out + kFrameHeaderSize,
+                                                 capacity - kFrameHeaderSize);
+    if (body == 0) {
+        return 0;
+    }
+    out[0] = static_cast<uint8_t>(requestId & 0xFF);
+    out[1] = static_cast<uint8_t>(requestId >> 8);
+    return kFrameHeaderSize + body;
+}
+
+std::vector<uint8_t> serializeFrame(RequestId requestId, const Message& message) {
+    std::vector<uint8_t> out(kFrameHeaderSize + message.wireSize());
+    serializeFrameTo(requestId, message, out.data(), out.size());
+    return out;
+}
+
+// A deadline and the longest adapter name, each with its tag and length.
+static_assert(2 + 4 + 2 + kMaxAdapterNameLength <= kMaxFrameExtensionSize,
+              "every extension fits in one frame");
+
+std::size_t serializeFrameTo(uint8_t protocol, RequestId requestId,
+                             const RequestOptions& options, const Message& message,
+                             uint8_t* out, std::size_t capacity) noexcept {
+    if (protocol <= kProtocolLegacy) {
+        return serializeFrameTo(requestId, message, out, capacity);
+    }
+    uint8_t ext[kMaxFrameExtensionSize];
+    std::size_t extLen = 0;
+    if (options.deadlineMs != 0) {
+        ext[extLen++] = kFrameExtDeadline;
+        ext[extLen++] = 4;
+        for (int shift = 0; shift < 32; shift += 8) {
+            ext[extLen++] = static_cast<uint8_t>(options.deadlineMs >> shift);
+        }
+    }
+    if (!options.adapter.empty()) {
+        const std::string_view name = options.adapter.name();
+        ext[extLen++] = kFrameExtAdapter;
+        ext[extLen++] = static_cast<uint8_t>(name.size());
+        std::memcpy(ext + extLen, name.data(), name.size());
+        extLen += name.size();
+    }
+    const std::size_t header = 4 + extLen;
+    if (capacity < header) {
+        return 0;
+    }
+    const std::size_t body = message.serializeTo(out + header, capacity - header);
+    if (body == 0) {
+        return 0;
+    }
+    out[0] = static_cast<uint8_t>(requestId & 0xFF);
+    out[1] = static_cast<uint8_t>(requestId >> 8);
+    out[2] = static_cast<uint8_t>((options.noReply ? kFrameNoReply : 0) |
+                                  (options.background ? kFrameBackground : 0) |
+                                  (options.ackOnAccept ? kFrameAckOnAccept : 0));
+    out[3] = static_cast<uint8_t>(extLen);
+    if (extLen > 0) {
+        std::memcpy(out + 4, ext, extLen);
+    }
+    return header + body;
+}
+
+std::vector<uint8_t> serializeFrame(uint8_t protocol, RequestId requestId,
+                                    const RequestOptions& options, const Message& message) {
+    std::vector<uint8_t> out(MAX_FRAME_SIZE);
+    out.resize(serializeFrameTo(protocol, requestId, options, message, out.data(), out.size()));
+    return out;
+}
+
+std::optional<Frame> deserializeFrame(const uint8_t* data, std::size_t len) {
+    if (len < kFrameHeaderSize) {
+        return std::nullopt;
+    }
+    auto message = Message::deserialize(data + kFrameHeaderSize, len - kFrameHeaderSize);
+    if (!message) {
+        return std::nullopt;
+    }
+    const auto requestId = static_cast<RequestId>(data[0] | (data[1] << 8));
+    return Frame{requestId, std::move(*message)};
+}
+
+std::optional<Frame> deserializeFrame(uint8_t protocol, const uint8_t* data, std::size_t len) {
+    if (protocol <= kProtocolLegacy) {
+        return deserializeFrame(data, len);
+    }
+    if (len < 4) {
+        return std::nullopt;
+    }
+    const uint8_t flags  = data[2];
+    const std::size_t extLen = data[3];
+    if ((flags & ~kKnownFrameFlags) != 0 || extLen > kMaxFrameExtensionSize ||
+        4 + extLen > len) {
+        return std::nullopt;
+    }
+
+    RequestOptions options;
+    options.noReply     = (flags & kFrameNoReply) != 0;
+    options.background  = (flags & kFrameBackground) != 0;
+    options.ackOnAccept = (flags & kFrameAckOnAccept) != 0;
+    const uint8_t* ext = data + 4;
+    for (std::size_t pos = 0; pos < extLen;) {
+        if (pos + 2 > extLen) {
+            return std::nullopt;
+        }
+        const uint8_t tag       = ext[pos];
+        const std::size_t width = ext[pos + 1];
+        pos += 2;
+        if (pos + width > extLen) {
+            return std::nullopt;
+        }
+        if (tag == kFrameExtDeadline) {
+            if (width != 4) {
+                return std::nullopt;
+            }
+            options.deadlineMs = static_cast<uint32_t>(ext[pos]) |
+                                 static_cast<uint32_t>(ext[pos + 1]) << 8 |
+                                 static_cast<uint32_t>(ext[pos + 2]) << 16 |
+                                 static_cast<uint32_t>(ext[pos + 3]) << 24;
+        } else if (tag == kFrameExtAdapter) {
+            if (!options.adapter.assign(
+                    {reinterpret_cast<const char*>(ext + pos), width})) {
+                return std::nullopt;
+            }
+        }
+        pos += width;
+    }
+
+    const std::size_t header = 4 + extLen;
+    auto message = Message::deserialize(data + header, len - header);
+    if (!message) {
+        return std::nullopt;
+    }
+    const auto requestId = static_cast<RequestId>(data[0] | (data[1] << 8));
+    return Frame{requestId, std::move(*message), options};
+}
+
+std::optional<InlineBytes> encodeBatch(const std::vector<Message>& steps) {
+    if (steps.empty() || steps.size() > kMaxBatchSteps) {
+        return std::nullopt;
+    }
+    InlineBytes out;
+    uint8_t wire[UINT8_MAX];
+    for (const auto& step : steps) {
+        const std::size_t len = step.serializeTo(wire, sizeof(wire));
+        if (len == 0) {
+            return std::nullopt;
+        }
+        out.push_back(static_cast<uint8_t>(len));
+        out.append(wire, len);
+    }
+    // Two header bytes of the enclosing CMD_BATCH Message.
+    if (2 + out.size() > MAX_MESSAGE_SIZE) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+std::optional<std::vector<Message>> decodeBatch(const InlineBytes& payload) {
+    std::vector<Message> steps;
+    std::size_t pos = 0;
+    while (pos < payload.size()) {
+        const std::size_t len = payload[pos++];
+        if (len > payload.size() - pos || steps.size() == kMaxBatchSteps) {
+            return std::nullopt;
+        }
+        auto step = Message::deserialize(payload.data() + pos, len);
+        if (!step) {
+            return std::nullopt;
+        }
+        steps.push_back(std::move(*step));
+        pos += len;
+    }
+    if (steps.empty()) {
+        return std::nullopt;
+    }
+    return steps;
+}
+
+InlineBytes encodeDeviceSet(DeviceSet set) {
+    return {static_cast<uint8_t>(set >> 8), static_cast<uint8_t>(set & 0xFF)};
+}
+
+std::optional<DeviceSet> decodeDeviceSet(const InlineBytes& payload) {
+    if (payload.size() != 2) return std::nullopt;
+    return static_cast<DeviceSet>((payload[0] << 8) | payload[1]);
+}
+
+bool isValidSceneName(std::string_view name) noexcept {
+    if (name.empty() || name.size() > kMaxSceneNameLength) return false;
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '-' || c == '_';
+    });
+}
+
+bool isValidAdapterName(std::string_view name) noexcept {
+    if (name.empty() || name.size() > kMaxAdapterNameLength) return false;
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '-' || c == '_';
+    });
+}
+
+bool AdapterSelector::assign(std::string_view name) noexcept {
+    if (!isValidAdapterName(name)) return false;
+    std::copy(name.begin(), name.end(), m_name.begin());
+    m_length = static_cast<uint8_t>(name.size());
+    return true;
+}
+
+InlineBytes encodeDeviceStates(const std::vector<DeviceState>& states) {
+    InlineBytes out;
+    for (const auto& state : states) {
+        const std::size_t nameLen = std::min(state.osdName.size(), kMaxOsdNameLength);
+        out.push_back(state.logicalAddress);
+        out.push_back(state.powerStatus);
+        out.push_back(static_cast<uint8_t>(state.physicalAddress >> 8));
+        out.push_back(static_cast<uint8_t>(state.physicalAddress & 0xFF));
+        out.push_back(static_cast<uint8_t>(nameLen));
+        out.append(reinterpret_cast<const uint8_t*>(state.osdName.data()), nameLen);
+    }
+    return out;
+}
+
+std::optional<std::vector<DeviceState>> decodeDeviceStates(const InlineBytes& payload) {
+    constexpr std::size_t kEntryHeaderSize = 5;
+    std::vector<DeviceState> states;
+    std::size_t pos = 0;
+    while (pos < payload.size()) {
+        if (payload.size() - pos < kEntryHeaderSize) {
+            return std::nullopt;
+        }
+        DeviceState state;
+        state.logicalAddress  = payload[pos];
+        state.powerStatus     = payload[pos + 1];
+        state.physicalAddress = static_cast<uint16_t>((payload[pos + 2] << 8) | payload[pos + 3]);
+        const std::size_t nameLen = payload[pos + 4];
+        pos += kEntryHeaderSize;
+        if (nameLen > payload.size() - pos) {
+            return std::nullopt;
+        }
+        state.osdName.assign(payload.begin() + pos, payload.begin() + pos + nameLen);
+        pos += nameLen;
+        states.push_back(std::move(state));
+    }
+    return states;
+}
+
+InlineBytes encodeRawFrame(const RawFrame& frame) {
+    InlineBytes out{frame.initiator, frame.destination, frame.opcode};
+    out.append(frame.parameters.data(),
+               std::min<std::size_t>(frame.parameterCount, kMaxRawParameters));
+    return out;
+}
+
+std::optional<RawFrame> decodeRawFrame(const uint8_t* data, std::size_t len) {
+    constexpr std::size_t kHeaderSize = 3;
+    if (len < kHeaderSize || len - kHeaderSize > kMaxRawParameters) {
+        return std::nullopt;
+    }
+    RawFrame frame;
+    frame.initiator      = data[0];
+    frame.destination    = data[1];
+    frame.opcode         = data[2];
+    frame.parameterCount = static_cast<uint8_t>(len - kHeaderSize);
+    std::copy(data + kHeaderSize, data + len, frame.parameters.begin());
+    return frame;
+}
+
+std::string_view busEventName(BusEventKind kind) noexcept {
+    switch (kind) {
+        case BusEventKind::TvStandby:       return "tv-standby";
+        case BusEventKind::TvPowerReport:   return "tv-power";
+        case BusEventKind::ActiveSource:    return "active-source";
+        case BusEventKind::HostActivated:   return "host-activated";
+        case BusEventKind::HostDeactivated: return "host-deactivated";
+        case BusEventKind::RawFrame:        return "raw";
+        case BusEventKind::Overflow:        return "overflow";
+    }
+    return "unknown";
+}
+
+std::optional<BusEventKind> findBusEventByName(std::string_view name) noexcept {
+    for (uint8_t raw = 0; raw <= static_cast<uint8_t>(BusEventKind::RawFrame); ++raw) {
+        const auto kind = static_cast<BusEventKind>(raw);
+        if (busEventName(kind) == name) return kind;
+    }
+    return std::nullopt;
+}
+
+InlineBytes encodeBusEvent(const BusEvent& event) {
+    InlineBytes out{
+        static_cast<uint8_t>(event.kind),
+        event.logicalAddress,
+        event.powerStatus,
+        static_cast<uint8_t>(event.physicalAddress >> 8),
+        static_cast<uint8_t>(event.physicalAddress & 0xFF),
+        static_cast<uint8_t>(event.dropped >> 24),
+        static_cast<uint8_t>(event.dropped >> 16),
+        static_cast<uint8_t>(event.dropped >> 8),
+        static_cast<uint8_t>(event.dropped & 0xFF),
+    };
+    if (event.kind == BusEventKind::RawFrame) {
+        // The initiator already rides in the logical-address byte.
+        const InlineBytes frame = encodeRawFrame(event.frame);
+        out.append(frame.data() + 1, frame.size() - 1);
+    }
+    return out;
+}
+
+std::optional<BusEvent> decodeBusEvent(const InlineBytes& payload) {
+    constexpr std::size_t kEventSize = 9;
+    if (payload.size() < kEventSize) {
+        return std::nullopt;
+    }
+    const auto kind = static_cast<BusEventKind>(payload[0]);
+    if (kind != BusEventKind::Overflow &&
+        payload[0] > static_cast<uint8_t>(BusEventKind::RawFrame)) {
+        return std::nullopt;
+    }
+    BusEvent event;
+    event.kind            = kind;
+    event.logicalAddress  = payload[1];
+    event.powerStatus     = payload[2];
+    event.physicalAddress = static_cast<uint16_t>((payload[3] << 8) | payload[4]);
+    event.dropped         = (static_cast<uint32_t>(payload[5]) << 24) |
+                            (static_cast<uint32_t>(payload[6]) << 16) |
+                            (static_cast<uint32_t>(payload[7]) << 8) |
+                            static_cast<uint32_t>(payload[8]);
+    if (kind == BusEventKind::RawFrame) {
+        // Rebuild the frame's own header around the trailing bytes.
+        InlineBytes frame{event.logicalAddress};
+        frame.append(payload.data() + kEventSize, payload.size() - kEventSize);
+        const auto decoded = decodeRawFrame(frame.data(), frame.size());
+        if (!decoded) {
+            return std::nullopt;
+        }
+        event.frame = *decoded;
+    }
+    return event;
+}
+
 } // namespace cec_control
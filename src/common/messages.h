@@ -1,11 +1,16 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <cstddef>
-#include <functional>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include "inline_bytes.h"
+#include "inline_function.h"
+
 namespace cec_control {
 
 enum class MessageType : uint8_t {
@@ -21,23 +26,76 @@ enum class MessageType : uint8_t {
     CMD_RESUME,
     CMD_AUTO_STANDBY,
     CMD_KEY,
+    // Ordered list of sub-commands run as one unit; see encodeBatch.
+    CMD_BATCH,
+    // Read-only queries against the daemon's device-state cache; the
+    // response payload is encodeDeviceStates.
+    CMD_QUERY_STATUS,
+    CMD_QUERY_DEVICES,
+    CMD_QUERY_ACTIVE_SOURCE,
+    // Daemon metrics report; the response payload is plain text.
+    CMD_STATS,
+    // Pipeline tracing control and export; see TraceOp.
+    CMD_TRACE,
+    // Turn the session into a bus-event stream; data[0] is a
+    // BusEventMask (absent = every kind, 0 = stop). See RESP_EVENT.
+    CMD_SUBSCRIBE,
+    // Run a scene defined in the daemon's config; data is its name.
+    // Answered like CMD_BATCH, one result byte per command.
+    CMD_SCENE,
+    // Bring the audio system to an absolute volume; data[0] is the
+    // target level, 0..kMaxVolumeLevel.
+    CMD_VOLUME_SET,
+    // Press-and-hold: CMD_KEY_DOWN (data[0] is the key code) presses
+    // and keeps the key held on deviceId; CMD_KEY_UP releases it.
+    CMD_KEY_DOWN,
+    CMD_KEY_UP,
+    // Send one CEC frame as given; deviceId is its destination and
+    // data is encodeRawFrame. Only opcodes in [Daemon] RawOpcodes are
+    // accepted.
+    CMD_RAW_TRANSMIT,
+    // Press and release several keys in turn on deviceId as one
+    // request; data is the key codes, 1..kMaxKeySequence of them.
+    CMD_KEY_SEQUENCE,
+    // Session opener: data[0] is the newest framing version the client
+    // speaks. The reply's data[0] is the version both sides use from
+    // the next frame on; see kProtocolVersion.
+    CMD_HELLO,
 
     // Response messages (daemon -> client)
     RESP_SUCCESS = 100,
     RESP_ERROR,
+    // Refused without being attempted: the adapter worker's queue is
+    // full. Distinct from RESP_ERROR so clients can back off and retry.
+    RESP_BUSY,
+    // Unsolicited: one bus event pushed to a subscribed session, framed
+    // with the RequestId of its CMD_SUBSCRIBE. Payload is encodeBusEvent.
+    RESP_EVENT,
+    // Refused without being attempted: the daemon started with a
+    // deferred adapter open that has not finished in time. Like
+    // RESP_BUSY, worth retrying.
+    RESP_NOT_READY,
+    // Failed without being sent: the target device stopped answering
+    // and its circuit breaker is open. Not worth retrying until the
+    // device is heard from again.
+    RESP_UNREACHABLE,
+    // Refused without being dispatched: the client's user has sent
+    // more requests than the daemon's rate limit allows. Worth
+    // retrying once the client slows down.
+    RESP_RATE_LIMITED,
 };
 
 /**
- * Maximum allowed size of one wire-encoded Message. Chosen well above any
- * real payload (current payloads are under 5 bytes); anything larger is
- * treated as malformed and the connection is closed.
+ * Maximum allowed size of one wire-encoded Message. Sized for the largest
+ * response, the CMD_STATS report; commands stay far below it. Anything
+ * larger is treated as malformed and the connection is closed.
  */
-constexpr std::size_t MAX_MESSAGE_SIZE = 1024;
+constexpr std::size_t MAX_MESSAGE_SIZE = 4096;
 
 struct Message {
     MessageType type;
     uint8_t deviceId;
-    std::vector<uint8_t> data;
+    InlineBytes data;  ///< Held inline up to InlineBytes::kInlineCapacity bytes.
 
     // A Message must always have a well-defined type. A default constructor
     // that silently produced RESP_ERROR was ambiguous with real error
@@ -46,10 +104,20 @@ struct Message {
 
     Message(MessageType t, uint8_t id = 0) : type(t), deviceId(id) {}
 
-    Message(MessageType t, uint8_t id, std::vector<uint8_t> payload)
+    Message(MessageType t, uint8_t id, InlineBytes payload)
         : type(t), deviceId(id), data(std::move(payload)) {}
 
-    /** Serialize to the wire format: [type][deviceId][data...]. */
+    /** Bytes @c serializeTo writes for this message. */
+    [[nodiscard]] std::size_t wireSize() const noexcept { return 2 + data.size(); }
+
+    /**
+     * Write the wire format, [type][deviceId][data...], into the
+     * @p capacity bytes at @p out. Returns the bytes written, or 0 if
+     * they do not fit.
+     */
+    std::size_t serializeTo(uint8_t* out, std::size_t capacity) const noexcept;
+
+    /** Serialize to a fresh buffer; see @c serializeTo. */
     std::vector<uint8_t> serialize() const;
 
     /**
@@ -60,17 +128,390 @@ struct Message {
     static std::optional<Message> deserialize(const std::vector<uint8_t>& data);
 };
 
+/**
+ * Client-chosen tag echoed on the response to a request. A session may
+ * have several requests outstanding and their responses can arrive in
+ * any order; the tag is how the client matches them up.
+ */
+using RequestId = uint16_t;
+
+/**
+ * Framing versions. Every session starts at @c kProtocolLegacy, whose
+ * datagram is `[requestId lo][requestId hi][Message...]`. A client that
+ * wants more sends CMD_HELLO as its first frame, and every later frame
+ * in both directions uses the version the reply names. A client that
+ * never says hello is served exactly as before.
+ *
+ * From version 2 a datagram is
+ * `[requestId lo][requestId hi][flags][extLen][extensions...][Message...]`:
+ * @c kFrame* flag bits, then @c extLen bytes of `[tag][len][value...]`
+ * extension fields. An unknown tag is skipped, so a field can be added
+ * without a version bump; an unknown flag bit makes the frame
+ * malformed, since a flag changes what the daemon does with it.
+ */
+constexpr uint8_t kProtocolLegacy  = 1;
+constexpr uint8_t kProtocolVersion = 2;
+
+/** Frame flag: the daemon runs the request and sends no response. */
+constexpr uint8_t kFrameNoReply    = 0x01;
+/** Frame flag: the request waits behind interactive work on the adapter. */
+constexpr uint8_t kFrameBackground = 0x02;
+/**
+ * Frame flag: answer once the adapter worker has queued the request,
+ * without waiting for it to run. The reply says only that it was
+ * accepted (or RESP_BUSY that it was not); outcomes are counted in
+ * the daemon's stats.
+ */
+constexpr uint8_t kFrameAckOnAccept = 0x04;
+constexpr uint8_t kKnownFrameFlags  = kFrameNoReply | kFrameBackground | kFrameAckOnAccept;
+
+/** Extension tag: uint32 LE, milliseconds the request may wait to start. */
+constexpr uint8_t kFrameExtDeadline = 1;
+/**
+ * Extension tag: the name of the @c [Adapter.NAME] adapter the request
+ * is for, as a valid @c isValidAdapterName string. Absent means the
+ * default @c [Adapter].
+ */
+constexpr uint8_t kFrameExtAdapter  = 2;
+
+/** Most extension bytes one frame may carry. */
+constexpr std::size_t kMaxFrameExtensionSize = 32;
+
+/** Bytes of framing ahead of the Message in a legacy socket datagram. */
+constexpr std::size_t kFrameHeaderSize = 2;
+
+/** Largest frame header of any version. */
+constexpr std::size_t kMaxFrameHeaderSize = 4 + kMaxFrameExtensionSize;
+
+/** Largest socket datagram: one framed, maximum-size Message. */
+constexpr std::size_t MAX_FRAME_SIZE = kMaxFrameHeaderSize + MAX_MESSAGE_SIZE;
+
+/**
+ * Framing on the TCP endpoint, a byte stream with no datagram
+ * boundaries: each frame, in version @c kProtocolVersion framing from
+ * the first one on, follows its length as two little-endian bytes.
+ * The first frame must be CMD_HELLO with data `[version][token...]`,
+ * the endpoint's shared secret; nothing else is read until it matches.
+ */
+constexpr std::size_t kStreamPrefixSize = 2;
+
+/** Shortest and longest token a network hello may carry. */
+constexpr std::size_t kMinNetworkTokenLength = 16;
+constexpr std::size_t kMaxNetworkTokenLength = 256;
+
+/** Longest name an @c [Adapter.NAME] section, and so a selector, may have. */
+constexpr std::size_t kMaxAdapterNameLength = 16;
+
+/**
+ * True if @p name is 1..kMaxAdapterNameLength characters of letters,
+ * digits, '-' and '_' — what an @c [Adapter.NAME] section may be called.
+ */
+bool isValidAdapterName(std::string_view name) noexcept;
+
+/**
+ * The adapter a request is for, by its @c [Adapter.NAME] name. Held
+ * inline so options stay a plain value on the request path; empty
+ * selects the default @c [Adapter].
+ */
+class AdapterSelector {
+public:
+    /** Select @p name; false, leaving the selector as it was, if it is not valid. */
+    bool assign(std::string_view name) noexcept;
+
+    [[nodiscard]] bool empty() const noexcept { return m_length == 0; }
+    [[nodiscard]] std::string_view name() const noexcept { return {m_name.data(), m_length}; }
+
+private:
+    std::array<char, kMaxAdapterNameLength> m_name{};
+    uint8_t                                 m_length = 0;
+};
+
+/**
+ * What a version 2 frame's flags and extensions ask of the daemon.
+ * Legacy frames always carry the defaults.
+ */
+struct RequestOptions {
+    bool     noReply     = false;
+    bool     background  = false;
+    bool     ackOnAccept = false;
+    /** Longest the request may wait to start; 0 = the daemon's CommandTimeoutMs. */
+    uint32_t deadlineMs = 0;
+    /** The adapter to run the request on; empty for the default one. */
+    AdapterSelector adapter;
+    /**
+     * The daemon session the request came in on, set by the endpoint
+     * after parsing and never sent; 0 for none. Keeps per-session
+     * state, such as a trace dump being read, apart.
+     */
+    uint64_t session = 0;
+};
+
+/** One socket datagram, of either framing version. */
+struct Frame {
+    RequestId      requestId;
+    Message        message;
+    RequestOptions options{};
+};
+
+/**
+ * Frame @p message under @p requestId into the @p capacity bytes at
+ * @p out. Returns the datagram length, or 0 if it does not fit; a
+ * buffer of @c MAX_FRAME_SIZE holds any valid message.
+ */
+std::size_t serializeFrameTo(RequestId requestId, const Message& message,
+                             uint8_t* out, std::size_t capacity) noexcept;
+
+/** Frame @p message under @p requestId for the socket. */
+std::vector<uint8_t> serializeFrame(RequestId requestId, const Message& message);
+
+/**
+ * As above, in framing version @p protocol. @p options is ignored for
+ * @c kProtocolLegacy and encoded as flags and extensions otherwise;
+ * extensions are written only where they differ from the defaults.
+ */
+std::size_t serializeFrameTo(uint8_t protocol, RequestId requestId,
+                             const RequestOptions& options, const Message& message,
+                             uint8_t* out, std::size_t capacity) noexcept;
+std::vector<uint8_t> serializeFrame(uint8_t protocol, RequestId requestId,
+                                    const RequestOptions& options, const Message& message);
+
+/**
+ * Parse one legacy socket datagram. Returns nullopt if it is shorter
+ * than the header or the enclosed Message is rejected by
+ * Message::deserialize.
+ */
+std::optional<Frame> deserializeFrame(const uint8_t* data, std::size_t len);
+
+/**
+ * Parse one socket datagram in framing version @p protocol. Beyond the
+ * legacy checks, a version 2 frame is rejected for an unknown flag, an
+ * extension area that overruns the datagram or @c kMaxFrameExtensionSize,
+ * a known extension of the wrong length, or an adapter name that is not
+ * valid. Reads @p data in place.
+ */
+std::optional<Frame> deserializeFrame(uint8_t protocol, const uint8_t* data, std::size_t len);
+
 /** Returns true if @p raw is a known MessageType enumerator. */
 bool isKnownMessageType(uint8_t raw) noexcept;
 
+/** Most sub-commands one CMD_BATCH may carry. */
+constexpr std::size_t kMaxBatchSteps = 16;
+
+/**
+ * Encode @p steps as a CMD_BATCH payload: each step is its wire form
+ * prefixed by a one-byte length, `[len][type][deviceId][data...]`.
+ * Returns nullopt if @p steps is empty, holds more than
+ * @c kMaxBatchSteps entries or a step longer than 255 bytes, or the
+ * resulting Message would exceed @c MAX_MESSAGE_SIZE.
+ *
+ * The daemon answers a batch with one response whose type is
+ * RESP_SUCCESS iff every step succeeded and whose payload holds each
+ * step's own response type, one byte per step, in order.
+ */
+std::optional<InlineBytes> encodeBatch(const std::vector<Message>& steps);
+
+/**
+ * Decode a CMD_BATCH payload. Returns nullopt on a truncated step, an
+ * unknown step type, or a step count outside 1..kMaxBatchSteps.
+ */
+std::optional<std::vector<Message>> decodeBatch(const InlineBytes& payload);
+
+/**
+ * A set of devices: bit @c N selects logical address @c N. A
+ * CMD_POWER_ON or CMD_POWER_OFF whose data is an encoded set is sent to
+ * every device in it as one command, and its deviceId only names the
+ * first of them for the log. Separately, a CMD_POWER_OFF to deviceId
+ * @c kBroadcastAddress is one broadcast <Standby> frame, which is the
+ * one power message CEC lets a sender broadcast.
+ */
+using DeviceSet = uint16_t;
+
+/** CEC's broadcast logical address. */
+constexpr uint8_t kBroadcastAddress = 15;
+
+/** Encode @p set as a power command payload: `[set hi][set lo]`. */
+InlineBytes encodeDeviceSet(DeviceSet set);
+
+/** Decode a power command payload. Returns nullopt unless it is exactly two bytes. */
+std::optional<DeviceSet> decodeDeviceSet(const InlineBytes& payload);
+
+/**
+ * HDMI source IDs of a CMD_CHANGE_SOURCE payload. Values in
+ * [@c kFirstHdmiSource, @c kLastHdmiSource] select HDMI 1..4 via the CEC
+ * physical-address layout @c 0xN000 (where @c N is the port number).
+ */
+constexpr uint8_t kFirstHdmiSource = 2;
+constexpr uint8_t kLastHdmiSource  = 5;
+
+/** Highest level CMD_VOLUME_SET accepts; CEC reports volume as 0..100. */
+constexpr uint8_t kMaxVolumeLevel = 100;
+
+/** Longest scene name CMD_SCENE carries. */
+constexpr std::size_t kMaxSceneNameLength = 32;
+
+/**
+ * True if @p name is 1..kMaxSceneNameLength characters of letters,
+ * digits, '-' and '_' — what a @c [Scene.NAME] section may be called.
+ */
+bool isValidSceneName(std::string_view name) noexcept;
+
+/** CEC's "not known" power-status byte (libcec CEC_POWER_STATUS_UNKNOWN). */
+constexpr uint8_t kPowerStatusUnknown = 0x99;
+
+/** Physical address reported when none is known. */
+constexpr uint16_t kPhysicalAddressUnknown = 0xFFFF;
+
+/** Logical address reported when none is known. */
+constexpr uint8_t kLogicalAddressUnknown = 0xFF;
+
+/** Longest OSD name CEC carries; longer names are truncated on encode. */
+constexpr std::size_t kMaxOsdNameLength = 14;
+
+/**
+ * One device as reported by the CMD_QUERY_* commands. Power status is
+ * the raw CEC byte so this header stays libcec-free; fields the daemon
+ * has no fresh value for carry the matching @c *Unknown constant or an
+ * empty name.
+ */
+struct DeviceState {
+    uint8_t     logicalAddress  = kLogicalAddressUnknown;
+    uint8_t     powerStatus     = kPowerStatusUnknown;
+    uint16_t    physicalAddress = kPhysicalAddressUnknown;
+    std::string osdName;
+};
+
+/**
+ * Encode @p states as a query response payload: per device,
+ * `[logical][power][physical hi][physical lo][nameLen][name...]`.
+ * CMD_QUERY_STATUS answers one entry, CMD_QUERY_DEVICES one per known
+ * device, and CMD_QUERY_ACTIVE_SOURCE one entry whose physical (and,
+ * when known, logical) address names the active source.
+ */
+InlineBytes encodeDeviceStates(const std::vector<DeviceState>& states);
+
+/** Decode a query response payload. Returns nullopt on a truncated entry. */
+std::optional<std::vector<DeviceState>> decodeDeviceStates(const InlineBytes& payload);
+
+/** Most keys one CMD_KEY_SEQUENCE presses. */
+constexpr std::size_t kMaxKeySequence = 16;
+
+/** Most parameter bytes one CEC frame carries after its opcode. */
+constexpr std::size_t kMaxRawParameters = 14;
+
+/**
+ * One CEC frame as it goes on the bus: header, opcode and parameters,
+ * with no interpretation. What CMD_RAW_TRANSMIT sends and what a
+ * @c BusEventKind::RawFrame event reports. An @c initiator of
+ * @c kLogicalAddressUnknown on a transmit means the daemon's own
+ * address; any other must be one of the addresses it claimed.
+ */
+struct RawFrame {
+    uint8_t initiator      = kLogicalAddressUnknown;
+    uint8_t destination    = kBroadcastAddress;
+    uint8_t opcode         = 0;
+    uint8_t parameterCount = 0;
+    std::array<uint8_t, kMaxRawParameters> parameters{};
+};
+
+/** Encode @p frame as `[initiator][destination][opcode][parameters...]`. */
+InlineBytes encodeRawFrame(const RawFrame& frame);
+
+/**
+ * Decode a CMD_RAW_TRANSMIT payload. Returns nullopt if it is shorter
+ * than the three header bytes or carries more than
+ * @c kMaxRawParameters parameters.
+ */
+std::optional<RawFrame> decodeRawFrame(const uint8_t* data, std::size_t len);
+
+/** What a RESP_EVENT reports. The first six are filterable bus events. */
+enum class BusEventKind : uint8_t {
+    TvStandby       = 0,
+    TvPowerReport   = 1,
+    ActiveSource    = 2,
+    HostActivated   = 3,
+    HostDeactivated = 4,
+    /** A frame whose opcode is in [Daemon] RawOpcodes; see @c BusEvent::frame. */
+    RawFrame        = 5,
+    /**
+     * The subscriber fell behind and @c BusEvent::dropped events were
+     * discarded at this point in the stream. Always delivered.
+     */
+    Overflow        = 0xFF,
+};
+
+/** CMD_SUBSCRIBE filter: bit @c busEventBit(kind) selects that kind. */
+using BusEventMask = uint8_t;
+
+constexpr BusEventMask busEventBit(BusEventKind kind) noexcept {
+    return static_cast<BusEventMask>(1u << static_cast<uint8_t>(kind));
+}
+
+/** Every filterable kind. */
+constexpr BusEventMask kAllBusEvents = 0x3F;
+
+/** Name of @p kind as the CLI spells it, e.g. "active-source". */
+std::string_view busEventName(BusEventKind kind) noexcept;
+
+/** Inverse of @c busEventName over the filterable kinds. */
+std::optional<BusEventKind> findBusEventByName(std::string_view name) noexcept;
+
+/**
+ * One RESP_EVENT. As with @c DeviceState, fields the event does not
+ * carry stay at their @c *Unknown constant: @c powerStatus is set for
+ * TvPowerReport, @c physicalAddress for ActiveSource, @c logicalAddress
+ * for ActiveSource (when announced), the Host* kinds and RawFrame (its
+ * initiator), @c frame only for RawFrame, and @c dropped only for
+ * Overflow.
+ */
+struct BusEvent {
+    BusEventKind kind            = BusEventKind::Overflow;
+    uint8_t      logicalAddress  = kLogicalAddressUnknown;
+    uint8_t      powerStatus     = kPowerStatusUnknown;
+    uint16_t     physicalAddress = kPhysicalAddressUnknown;
+    uint32_t     dropped         = 0;
+    RawFrame     frame;
+};
+
+/**
+ * Encode @p event as a RESP_EVENT payload:
+ * `[kind][logical][power][physical hi][physical lo][dropped, 4 bytes big-endian]`,
+ * followed for a RawFrame event by `[destination][opcode][parameters...]`.
+ */
+InlineBytes encodeBusEvent(const BusEvent& event);
+
+/** Decode a RESP_EVENT payload. Returns nullopt on a short payload or unknown kind. */
+std::optional<BusEvent> decodeBusEvent(const InlineBytes& payload);
+
+/** CMD_TRACE operation, carried in data[0]. */
+enum class TraceOp : uint8_t {
+    Off  = 0,
+    On   = 1,
+    /**
+     * Fetch one chunk of the Chrome trace JSON. data[1..2] is the
+     * big-endian chunk index; chunk 0 snapshots the trace afresh. The
+     * response payload is `[more][json bytes...]`, with @c more set
+     * while further chunks remain.
+     */
+    Dump = 2,
+};
+
+/** JSON bytes carried by one CMD_TRACE dump response. */
+constexpr std::size_t kTraceChunkSize = MAX_MESSAGE_SIZE - 3;
+
+/**
+ * Capture bytes a response sink may carry: a session, a request id and
+ * type, its no-reply flag, and the instant the request arrived.
+ */
+constexpr std::size_t kResponseSinkCapacity = 32;
+
 /**
  * Response delivery target for a parsed wire command. A sink is
  * invoked exactly once — either synchronously on the handler's thread
  * or through a deferred continuation (typically @c MainThreadWork::post).
- * Single-slot @c std::function matches the one-shot contract at the
- * type level only loosely; the call-at-most-once discipline is
+ * It is held inline and copies without allocating, so a task and its
+ * expiry hook can each carry one; the call-at-most-once discipline is
  * enforced by convention at every call site.
  */
-using ResponseSink = std::function<void(Message)>;
+using ResponseSink = InlineFunction<void(Message), kResponseSinkCapacity, /*Copyable=*/true>;
 
 } // namespace cec_control
@@ -0,0 +1,46 @@
+#include "network_token.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "messages.h"
+
+namespace cec_control {
+
+std::optional<std::string> readNetworkToken(const std::string& path, std::string& error) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return std::nullopt;
+    }
+
+    // One byte more than the longest token, plus a trailing newline,
+    // so an over-long file is told apart from a token at the limit.
+    std::string token(kMaxNetworkTokenLength + 2, '\0');
+    ssize_t got = 0;
+    do {
+        got = ::read(fd, token.data(), token.size());
+    } while (got < 0 && errno == EINTR);
+    const int err = errno;
+    ::close(fd);
+    if (got < 0) {
+        error = "cannot read " + path + ": " + std::strerror(err);
+        return std::nullopt;
+    }
+
+    token.resize(static_cast<std::size_t>(got));
+    while (!token.empty() && std::strchr(" \t\r\n", token.back()) != nullptr) {
+        token.pop_back();
+    }
+    if (token.size() < kMinNetworkTokenLength || token.size() > kMaxNetworkTokenLength) {
+        error = "the token in " + path + " must be " + std::to_string(kMinNetworkTokenLength) +
+                " to " + std::to_string(kMaxNetworkTokenLength) + " bytes";
+        return std::nullopt;
+    }
+    return token;
+}
+
+} // namespace cec_control
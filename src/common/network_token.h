@@ -0,0 +1,21 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+namespace cec_control {
+
+/**
+ * Read the network endpoint's shared token from @p path: the file's
+ * content less trailing whitespace, which must be
+ * @c kMinNetworkTokenLength to @c kMaxNetworkTokenLength bytes. The
+ * daemon and its network clients read the file the same way, so one
+ * copy of it serves both ends.
+ *
+ * @return nullopt, with the reason in @p error, if the file cannot be
+ *         read or its token is out of bounds.
+ */
+[[nodiscard]] std::optional<std::string> readNetworkToken(const std::string& path,
+                                                          std::string& error);
+
+} // namespace cec_control
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cec_control {
+
+/**
+ * FIFO over one preallocated circular buffer: the subset of
+ * @c std::deque the daemon's work queues use, without its per-chunk
+ * allocations.
+ *
+ * A deque allocates and frees a block every few elements as a queue
+ * churns, which on a long-running daemon leaves the heap fragmented
+ * in proportion to its peak. This one allocates its buffer once, at
+ * construction or @c reserve, and only again if a push finds it full,
+ * when it doubles; a queue sized for its bound never allocates after
+ * construction.
+ *
+ * Iteration is front to back. @c erase in the middle shifts the later
+ * elements one place forward; the queues here are short and erase-
+ * mostly near the front. Iterators are invalidated by any push, pop
+ * or erase. Not thread-safe; callers hold their own lock.
+ */
+template <typename T>
+class RingQueue {
+public:
+    template <bool Const>
+    class Iterator {
+        using Owner = std::conditional_t<Const, const RingQueue, RingQueue>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+
+        Iterator() noexcept = default;
+        Iterator(Owner* owner, std::size_t index) noexcept : m_owner(owner), m_index(index) {}
+
+        reference operator*() const noexcept { return m_owner->at(m_index); }
+        pointer   operator->() const noexcept { return &m_owner->at(m_index); }
+        Iterator& operator++() noexcept { ++m_index; return *this; }
+        Iterator  operator++(int) noexcept { Iterator old = *this; ++m_index; return old; }
+
+        bool operator==(const Iterator& other) const noexcept { return m_index == other.m_index; }
+        bool operator!=(const Iterator& other) const noexcept { return m_index != other.m_index; }
+
+    private:
+        friend class RingQueue;
+        Owner*      m_owner = nullptr;
+        std::size_t m_index = 0;  ///< Position from the front.
+    };
+
+    using iterator       = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit RingQueue(std::size_t capacity = 0) { reserve(capacity); }
+    ~RingQueue() { clear(); }
+
+    RingQueue(const RingQueue&)            = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    RingQueue(RingQueue&& other) noexcept { swap(other); }
+    RingQueue& operator=(RingQueue&& other) noexcept {
+        if (this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    void swap(RingQueue& other) noexcept {
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_head, other.m_head);
+        std::swap(m_size, other.m_size);
+    }
+    friend void swap(RingQueue& a, RingQueue& b) noexcept { a.swap(b); }
+
+    [[nodiscard]] bool        empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+
+    T&       front() noexcept { return at(0); }
+    const T& front() const noexcept { return at(0); }
+    T&       back() noexcept { return at(m_size - 1); }
+    const T& back() const noexcept { return at(m_size - 1); }
+
+    iterator       begin() noexcept { return iterator(this, 0); }
+    iterator       end() noexcept { return iterator(this, m_size); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, m_size); }
+
+    /** Make room for @p capacity elements; never shrinks. */
+    void reserve(std::size_t capacity) {
+        if (capacity <= m_capacity) return;
+        std::unique_ptr<Slot[]> slots(new Slot[capacity]);
+        for (std::size_t i = 0; i < m_size; ++i) {
+            ::new (static_cast<void*>(slots[i].bytes)) T(std::move(at(i)));
+            at(i).~T();
+        }
+        m_slots    = std::move(slots);
+        m_capacity = capacity;
+        m_head     = 0;
+    }
+
+    void push_back(T&& value) {
+        if (m_size == m_capacity) reserve(m_capacity == 0 ? 8 : m_capacity * 2);
+        ::new (static_cast<void*>(slot(m_size))) T(std::move(value));
+        ++m_size;
+    }
+
+    void pop_front() noexcept {
+        front().~T();
+        m_head = (m_head + 1) % m_capacity;
+        --m_size;
+    }
+
+    /** Remove the element at @p pos; returns the iterator to the one after it. */
+    iterator erase(const_iterator pos) {
+        for (std::size_t i = pos.m_index; i + 1 < m_size; ++i) {
+            at(i) = std::move(at(i + 1));
+        }
+        back().~T();
+        --m_size;
+        return iterator(this, pos.m_index);
+    }
+    iterator erase(iterator pos) { return erase(const_iterator(this, pos.m_index)); }
+
+    /** Destroy every element; the buffer stays. */
+    void clear() noexcept {
+        while (m_size > 0) pop_front();
+        m_head = 0;
+    }
+
+private:
+    struct Slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    void* slot(std::size_t index) const noexcept {
+        return m_slots[(m_head + index) % m_capacity].bytes;
+    }
+    T& at(std::size_t index) noexcept {
+        return *std::launder(static_cast<T*>(slot(index)));
+    }
+    const T& at(std::size_t index) const noexcept {
+        return *std::launder(static_cast<const T*>(slot(index)));
+    }
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t             m_capacity = 0;
+    std::size_t             m_head     = 0;
+    std::size_t             m_size     = 0;
+};
+
+} // namespace cec_control
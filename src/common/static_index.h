@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace cec_control {
+
+/**
+ * Lookup indices over the constexpr command and key tables, built by
+ * the compiler so a lookup costs an array load (by byte) or a hash and
+ * one or two string compares (by name) instead of a scan.
+ *
+ * Each index stores row positions and the caller keeps the rows in its
+ * own table, so a table's order, and the order it renders in help
+ * text, is unaffected.
+ */
+namespace static_index {
+
+/** Slot value marking "no row". Tables are therefore capped at 255 rows. */
+inline constexpr uint8_t kNone = 0xFF;
+
+/** Row position per byte value: a @c MessageType, a key code. */
+using ByteIndex = std::array<uint8_t, 256>;
+
+/** Byte index with no rows, for builders to fill in. */
+[[nodiscard]] constexpr ByteIndex emptyByteIndex() noexcept {
+    ByteIndex index{};
+    for (auto& slot : index) slot = kNone;
+    return index;
+}
+
+/** FNV-1a; good enough spread for a few dozen short ASCII names. */
+[[nodiscard]] constexpr uint32_t hashName(std::string_view name) noexcept {
+    uint32_t hash = 2166136261u;
+    for (const char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Open-addressed name -> row table with linear probing. @p Slots is a
+ * power of two at least twice the row count, which keeps a miss to a
+ * probe or two.
+ */
+template <std::size_t Slots>
+struct NameIndex {
+    static_assert((Slots & (Slots - 1)) == 0, "NameIndex slot count must be a power of two");
+
+    std::array<uint8_t, Slots> slots{};
+
+    /**
+     * Row whose name (per @p nameOf) equals @p name, or @c kNone.
+     * @p rows is the table the index was built from.
+     */
+    template <typename Rows, typename NameOf>
+    [[nodiscard]] constexpr uint8_t find(const Rows& rows, std::string_view name,
+                                         NameOf nameOf) const noexcept {
+        for (std::size_t i = hashName(name) & (Slots - 1);; i = (i + 1) & (Slots - 1)) {
+            const uint8_t row = slots[i];
+            if (row == kNone || nameOf(rows[row]) == name) return row;
+        }
+    }
+};
+
+/**
+ * Build a @c NameIndex over @p rows. A duplicate name keeps its first
+ * row; tables check for duplicates themselves where that matters.
+ */
+template <std::size_t Slots, typename Rows, typename NameOf>
+[[nodiscard]] constexpr NameIndex<Slots> buildNameIndex(const Rows& rows, NameOf nameOf) noexcept {
+    static_assert(std::tuple_size<Rows>::value * 2 <= Slots, "NameIndex too small for its table");
+    static_assert(std::tuple_size<Rows>::value < kNone, "table too large for a uint8_t index");
+    NameIndex<Slots> index{};
+    for (auto& slot : index.slots) slot = kNone;
+    for (std::size_t row = 0; row < rows.size(); ++row) {
+        const std::string_view name = nameOf(rows[row]);
+        std::size_t i = hashName(name) & (Slots - 1);
+        while (index.slots[i] != kNone && nameOf(rows[index.slots[i]]) != name) {
+            i = (i + 1) & (Slots - 1);
+        }
+        if (index.slots[i] == kNone) index.slots[i] = static_cast<uint8_t>(row);
+    }
+    return index;
+}
+
+} // namespace static_index
+
+} // namespace cec_control
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "messages.h"
+
+namespace cec_control {
+
+/**
+ * The daemon's status page: a small file in its runtime directory
+ * (@c SystemPaths::getStatusPagePath, @c /run/cec-control/status by
+ * default) that it keeps mapped and rewrites whenever the bus state it
+ * knows changes. A reader maps the file once and from then on gets the
+ * power status and physical address of each device, the active source
+ * and the adapter's state with plain memory loads: no socket, no
+ * syscall, however often it polls.
+ *
+ * Updates are guarded by a sequence lock. The daemon makes
+ * @c Layout::sequence odd, rewrites the words, and makes it even
+ * again; a reader that sees the same even value before and after its
+ * loads holds a consistent snapshot. Everything lives in
+ * @c std::atomic words, so neither side has a data race to reason
+ * about.
+ *
+ * The daemon only writes when something changed, so the sequence is
+ * also the page's generation. After each update it issues one
+ * @c FUTEX_WAKE on the sequence word, which wakes every reader blocked
+ * in @c StatusPageReader::waitForChange at once: a widget sleeps until
+ * the bus changes, and a hundred of them cost the daemon the same
+ * single syscall as one.
+ *
+ * The values are the last ones the daemon's state cache heard of,
+ * without its freshness window: a status widget shows what the bus
+ * last said. A device is present once the daemon has heard from it and
+ * until the cache forgets it (a rescan that no longer finds it, an
+ * adapter reopen, a resume).
+ *
+ * Header-only so a widget needs nothing but this header and
+ * messages.h; nothing here links against the client library.
+ */
+namespace status_page {
+
+/** "CECS" in the first word, so a reader can tell it mapped the right file. */
+inline constexpr uint32_t kMagic   = 0x53434543;
+/** Bumped on any layout change; a reader refuses a version it was not built for. */
+inline constexpr uint32_t kVersion = 1;
+
+/** One slot per CEC logical address. */
+inline constexpr std::size_t kDeviceCount = 16;
+
+/** @c Layout::adapter bits; the active source's physical address is in bits 16-31. */
+inline constexpr uint32_t kDaemonRunning     = 1u << 0;
+inline constexpr uint32_t kAdapterConnected  = 1u << 1;
+inline constexpr uint32_t kSuspended         = 1u << 2;
+inline constexpr uint32_t kActiveSourceKnown = 1u << 3;
+
+/** @c Layout::devices bits; power status in bits 8-15, physical address in bits 16-31. */
+inline constexpr uint32_t kDevicePresent = 1u << 0;
+
+/** The file's contents. Fixed size; grows only with @c kVersion. */
+struct Layout {
+    uint32_t              magic;
+    uint32_t              version;
+    /** The publishing daemon, for a reader that wants to detect a crash. */
+    uint32_t              pid;
+    /** Odd while an update is being written; also the futex readers wait on. */
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> adapter;
+    std::array<std::atomic<uint32_t>, kDeviceCount> devices;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "the status page needs address-free atomics to be shared between processes");
+static_assert(std::is_standard_layout_v<Layout>, "the status page layout must be fixed");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "the sequence word doubles as a futex");
+
+/** The sequence word as the kernel's futex calls take it. */
+[[nodiscard]] inline uint32_t* futexWord(const std::atomic<uint32_t>& word) noexcept {
+    return reinterpret_cast<uint32_t*>(const_cast<std::atomic<uint32_t>*>(&word));
+}
+
+/** Wake every process blocked on @p word. Not private: readers are other processes. */
+inline void futexWakeAll(const std::atomic<uint32_t>& word) noexcept {
+    ::syscall(SYS_futex, futexWord(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/** One device slot. */
+struct DeviceStatus {
+    bool     present         = false;
+    /** Raw CEC power-status byte, as in @c DeviceState. */
+    uint8_t  powerStatus     = kPowerStatusUnknown;
+    uint16_t physicalAddress = kPhysicalAddressUnknown;
+
+    [[nodiscard]] bool operator==(const DeviceStatus& other) const noexcept {
+        return present == other.present && powerStatus == other.powerStatus &&
+               physicalAddress == other.physicalAddress;
+    }
+    [[nodiscard]] bool operator!=(const DeviceStatus& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+/** A consistent copy of the page. */
+struct StatusSnapshot {
+    /** @c false once the daemon has stopped; reopen the page to follow a new one. */
+    bool     daemonRunning    = false;
+    bool     adapterConnected = false;
+    bool     suspended        = false;
+    /** Physical address of the active source, or @c kPhysicalAddressUnknown. */
+    uint16_t activeSource     = kPhysicalAddressUnknown;
+    std::array<DeviceStatus, kDeviceCount> devices{};
+    /** Even sequence the copy was taken at; changes with every update. */
+    uint32_t sequence         = 0;
+};
+
+[[nodiscard]] constexpr uint32_t packAdapter(const StatusSnapshot& s) noexcept {
+    uint32_t word = (s.daemonRunning ? kDaemonRunning : 0u) |
+                    (s.adapterConnected ? kAdapterConnected : 0u) |
+                    (s.suspended ? kSuspended : 0u);
+    if (s.activeSource != kPhysicalAddressUnknown) {
+        word |= kActiveSourceKnown | (static_cast<uint32_t>(s.activeSource) << 16);
+    }
+    return word;
+}
+
+[[nodiscard]] constexpr uint32_t packDevice(const DeviceStatus& d) noexcept {
+    if (!d.present) return 0;
+    return kDevicePresent | (static_cast<uint32_t>(d.powerStatus) << 8) |
+           (static_cast<uint32_t>(d.physicalAddress) << 16);
+}
+
+constexpr void unpackAdapter(uint32_t word, StatusSnapshot& s) noexcept {
+    s.daemonRunning    = (word & kDaemonRunning) != 0;
+    s.adapterConnected = (word & kAdapterConnected) != 0;
+    s.suspended        = (word & kSuspended) != 0;
+    s.activeSource     = (word & kActiveSourceKnown) != 0
+                             ? static_cast<uint16_t>(word >> 16)
+                             : kPhysicalAddressUnknown;
+}
+
+[[nodiscard]] constexpr DeviceStatus unpackDevice(uint32_t word) noexcept {
+    DeviceStatus d;
+    if ((word & kDevicePresent) == 0) return d;
+    d.present         = true;
+    d.powerStatus     = static_cast<uint8_t>(word >> 8);
+    d.physicalAddress = static_cast<uint16_t>(word >> 16);
+    return d;
+}
+
+/**
+ * Read-only mapping of a status page. @c open costs a few syscalls;
+ * every @c read after it costs none. Move-only; unmaps on destruction.
+ *
+ * The daemon replaces the file rather than rewriting it when it
+ * restarts, so a mapping keeps showing the old daemon's final state,
+ * with @c daemonRunning cleared. A long-lived reader reopens when it
+ * sees that.
+ */
+class StatusPageReader {
+public:
+    /** Tries @c read makes before giving up on a writer that never finishes. */
+    static constexpr unsigned kReadAttempts = 1024;
+
+    /** @c waitForChange timeout that never expires. */
+    static constexpr std::chrono::milliseconds kWaitForever = std::chrono::milliseconds::max();
+
+    StatusPageReader() noexcept = default;
+    ~StatusPageReader() { close(); }
+
+    StatusPageReader(StatusPageReader&& other) noexcept
+        : m_page(std::exchange(other.m_page, nullptr)) {}
+    StatusPageReader& operator=(StatusPageReader&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_page = std::exchange(other.m_page, nullptr);
+        }
+        return *this;
+    }
+    StatusPageReader(const StatusPageReader&)            = delete;
+    StatusPageReader& operator=(const StatusPageReader&) = delete;
+
+    /**
+     * Map the page at @p path, replacing any earlier mapping.
+     * @return @c false if it cannot be opened or is not a page of
+     *         this @c kVersion; the reader is then closed.
+     */
+    bool open(const std::string& path) noexcept {
+        close();
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st{};
+        void* mapped = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Layout))) {
+            mapped = ::mmap(nullptr, sizeof(Layout), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        m_page = static_cast<const Layout*>(mapped);
+        if (m_page->magic != kMagic || m_page->version != kVersion) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() noexcept {
+        if (m_page != nullptr) {
+            ::munmap(const_cast<Layout*>(m_page), sizeof(Layout));
+            m_page = nullptr;
+        }
+    }
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_page != nullptr; }
+
+    /** Pid of the daemon that published the page; 0 when closed. */
+    [[nodiscard]] uint32_t publisherPid() const noexcept {
+        return m_page != nullptr ? m_page->pid : 0;
+    }
+
+    /**
+     * Current sequence number, for a poller that only wants to know
+     * whether anything changed since its last @c read. Odd while an
+     * update is in progress.
+     */
+    [[nodiscard]] uint32_t sequence() const noexcept {
+        return m_page != nullptr ? m_page->sequence.load(std::memory_order_acquire) : 0;
+    }
+
+    /**
+     * Copy the page into @p out.
+     * @return @c false if closed, or if every one of @c kReadAttempts
+     *         tries overlapped an update; @p out is then unspecified.
+     */
+    bool read(StatusSnapshot& out) const noexcept {
+        if (m_page == nullptr) return false;
+        for (unsigned attempt = 0; attempt < kReadAttempts; ++attempt) {
+            const uint32_t before = m_page->sequence.load(std::memory_order_acquire);
+            if ((before & 1u) != 0) continue;
+            unpackAdapter(m_page->adapter.load(std::memory_order_relaxed), out);
+            for (std::size_t i = 0; i < kDeviceCount; ++i) {
+                out.devices[i] = unpackDevice(m_page->devices[i].load(std::memory_order_relaxed));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_page->sequence.load(std::memory_order_relaxed) == before) {
+                out.sequence = before;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Block until the sequence moves off @p seen (normally the
+     * @c StatusSnapshot::sequence of the last @c read) or @p timeout
+     * passes. Returns at once if it already has. The daemon wakes
+     * waiters after every update, including the final one when it
+     * stops, so a waiter always learns that its mapping went stale.
+     * @return @c true if the sequence differs from @p seen, @c false
+     *         on timeout or when closed.
+     */
+    bool waitForChange(uint32_t seen,
+                       std::chrono::milliseconds timeout = kWaitForever) const noexcept {
+        if (m_page == nullptr) return false;
+        using Clock = std::chrono::steady_clock;
+        const bool forever = timeout == kWaitForever;
+        const Clock::time_point deadline = forever ? Clock::time_point{} : Clock::now() + timeout;
+        for (;;) {
+            if (m_page->sequence.load(std::memory_order_acquire) != seen) return true;
+            timespec rel{};
+            if (!forever) {
+                const auto left = deadline - Clock::now();
+                if (left <= Clock::duration::zero()) return false;
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+                rel.tv_sec  = static_cast<time_t>(ns / 1000000000);
+                rel.tv_nsec = static_cast<long>(ns % 1000000000);
+            }
+            // EAGAIN (the word moved before the kernel looked), EINTR
+            // and a timeout all come back round to the check above.
+            ::syscall(SYS_futex, futexWord(m_page->sequence), FUTEX_WAIT, seen,
+                      forever ? nullptr : &rel, nullptr, 0);
+        }
+    }
+
+private:
+    const Layout* m_page = nullptr;
+};
+
+} // namespace status_page
+
+} // namespace cec_control
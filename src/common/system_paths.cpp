@@ -17,11 +17,16 @@ const std::string SystemPaths::APP_NAME = "cec-control";
 const std::string SystemPaths::CONFIG_FILENAME = "config.conf";
 const std::string SystemPaths::LOG_FILENAME = "daemon.log";
 const std::string SystemPaths::SOCKET_FILENAME = "socket";
+const std::string SystemPaths::ADAPTER_CACHE_FILENAME = "adapter";
+const std::string SystemPaths::DEVICE_PROFILES_FILENAME = "device-profiles";
+const std::string SystemPaths::STATUS_PAGE_FILENAME = "status";
+const std::string SystemPaths::FLIGHT_RECORDER_FILENAME = "flight";
 
 // Standard system paths
 const std::string SystemPaths::SYSTEM_CONFIG_BASE = "/etc";
 const std::string SystemPaths::SYSTEM_LOG_BASE = "/var/log";
 const std::string SystemPaths::SYSTEM_RUN_BASE = "/run";
+const std::string SystemPaths::SYSTEM_STATE_BASE = "/var/lib";
 
 std::string SystemPaths::getParentDir(const std::string& path) {
     if (path.empty()) {
@@ -79,6 +84,17 @@ std::string SystemPaths::getSystemRuntimeDir() {
     return joinPath(SYSTEM_RUN_BASE, runtimeDir);
 }
 
+std::string SystemPaths::getSystemStateDir() {
+    // systemd sets STATE_DIRECTORY to absolute paths, colon-separated
+    // when the unit names several; ours names one.
+    const char* stateDir = getenv("STATE_DIRECTORY");
+    if (!stateDir || *stateDir != '/') {
+        return joinPath(SYSTEM_STATE_BASE, APP_NAME);
+    }
+    const std::string_view dirs(stateDir);
+    return std::string(dirs.substr(0, dirs.find(':')));
+}
+
 bool SystemPaths::createDirectories(const std::string& path, mode_t mode) {
     if (path.empty()) {
         LOG_ERROR("Empty path provided to createDirectories");
@@ -127,6 +143,27 @@ std::string SystemPaths::getLogPath() {
     return joinPath(joinPath(SYSTEM_LOG_BASE, APP_NAME), LOG_FILENAME);
 }
 
+std::string SystemPaths::getAdapterCachePath() {
+    return joinPath(getSystemRuntimeDir(), ADAPTER_CACHE_FILENAME);
+}
+
+std::string SystemPaths::getAdapterCachePath(const std::string& adapter) {
+    if (adapter.empty()) return getAdapterCachePath();
+    return joinPath(getSystemRuntimeDir(), ADAPTER_CACHE_FILENAME + "-" + adapter);
+}
+
+std::string SystemPaths::getStatusPagePath() {
+    return joinPath(getSystemRuntimeDir(), STATUS_PAGE_FILENAME);
+}
+
+std::string SystemPaths::getFlightRecorderPath() {
+    return joinPath(getSystemRuntimeDir(), FLIGHT_RECORDER_FILENAME);
+}
+
+std::string SystemPaths::getDeviceProfilesPath() {
+    return joinPath(getSystemStateDir(), DEVICE_PROFILES_FILENAME);
+}
+
 bool SystemPaths::ensureParentDirExists(const std::string& path, mode_t mode) {
     std::string parent = getParentDir(path);
     if (parent.empty()) {
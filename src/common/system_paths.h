@@ -19,15 +19,21 @@ public:
     static const std::string CONFIG_FILENAME;
     static const std::string LOG_FILENAME;
     static const std::string SOCKET_FILENAME;
+    static const std::string ADAPTER_CACHE_FILENAME;
+    static const std::string DEVICE_PROFILES_FILENAME;
+    static const std::string STATUS_PAGE_FILENAME;
+    static const std::string FLIGHT_RECORDER_FILENAME;
     
     // Standard system paths
     static const std::string SYSTEM_CONFIG_BASE;
     static const std::string SYSTEM_LOG_BASE;
     static const std::string SYSTEM_RUN_BASE;
+    static const std::string SYSTEM_STATE_BASE;
     
 private:
     // System path helpers
     static std::string getSystemRuntimeDir();
+    static std::string getSystemStateDir();
     
     /**
      * Gets the parent directory of a path
@@ -63,6 +69,40 @@ public:
      */
     static std::string getLogPath();
 
+    /**
+     * Get the path of the daemon's adapter-port cache, beside the socket
+     * in the runtime directory so it does not outlive a reboot. Pure query.
+     */
+    static std::string getAdapterCachePath();
+
+    /**
+     * The same for the @c [Adapter.NAME] adapter @p adapter, whose port
+     * is cached apart from the default one's; empty means the default.
+     */
+    static std::string getAdapterCachePath(const std::string& adapter);
+
+    /**
+     * Get the path of the daemon's shared-memory status page, in the
+     * runtime directory beside the adapter cache. Pure query; readers
+     * and the daemon resolve it the same way.
+     */
+    static std::string getStatusPagePath();
+
+    /**
+     * Get the path of the daemon's flight recorder (see flight_log.h),
+     * in the runtime directory beside the status page. The previous
+     * run's recording is the same path with ".1" appended.
+     */
+    static std::string getFlightRecorderPath();
+
+    /**
+     * Get the path of the learned device profiles, in the state
+     * directory so they survive a reboot. Honours systemd's
+     * $STATE_DIRECTORY; falls back to a path under SYSTEM_STATE_BASE.
+     * Pure query.
+     */
+    static std::string getDeviceProfilesPath();
+
     /**
      * Ensure that the parent directory of @p path exists, creating it (and any
      * intermediate parents) with @p mode if necessary. For daemon-side use:
@@ -2,11 +2,31 @@
 
 #include <systemd/sd-daemon.h>
 
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "logger.h"
 
 namespace cec_control {
 namespace SystemdNotify {
 
+namespace {
+
+// The service manager hands descriptors over blocking and inheritable;
+// the event loop needs the former cleared and hook children must not
+// see them.
+bool prepareInherited(int fd) noexcept {
+    const int flags = ::fcntl(fd, F_GETFL);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 &&
+           ::fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+} // namespace
+
 void ready() noexcept {
     sd_notify(0, "READY=1");
 }
@@ -38,5 +58,65 @@ bool watchdogEnabled(std::chrono::microseconds& interval) noexcept {
     return true;
 }
 
+InheritedFds takeInheritedFds(const std::string& path) {
+    InheritedFds inherited;
+    char** names = nullptr;
+    const int count = sd_listen_fds_with_names(/*unset_environment=*/1, &names);
+    for (int i = 0; i < count; ++i) {
+        const int fd = SD_LISTEN_FDS_START + i;
+        const std::string_view name = names != nullptr && names[i] != nullptr
+            ? std::string_view(names[i]) : std::string_view();
+        if (inherited.listener < 0 &&
+            sd_is_socket_unix(fd, SOCK_SEQPACKET, /*listening=*/1, path.c_str(), 0) > 0) {
+            if (prepareInherited(fd)) {
+                inherited.listener       = fd;
+                inherited.listenerStored = name == kListenerFdName;
+            } else {
+                LOG_ERROR("Failed to prepare passed socket ", path);
+                ::close(fd);
+            }
+            continue;
+        }
+        if (name.substr(0, kSessionFdPrefix.size()) == kSessionFdPrefix &&
+            sd_is_socket_unix(fd, SOCK_SEQPACKET, /*listening=*/0, nullptr, 0) > 0) {
+            if (prepareInherited(fd)) {
+                inherited.sessions.push_back({fd, std::string(name)});
+            } else {
+                LOG_WARNING("Failed to prepare passed session fd ", fd);
+                ::close(fd);
+            }
+            continue;
+        }
+        LOG_WARNING("Closing unexpected passed fd ", fd, " (", name, ")");
+        ::close(fd);
+    }
+    for (char** n = names; n != nullptr && *n != nullptr; ++n) std::free(*n);
+    std::free(names);
+    if (count > 0 && inherited.listener < 0) {
+        LOG_WARNING("No passed socket matches ", path, "; listening directly");
+    }
+    return inherited;
+}
+
+std::size_t fdStoreCapacity() noexcept {
+    const char* value = std::getenv("FDSTORE");
+    if (value == nullptr) return 0;
+    char* end = nullptr;
+    const unsigned long capacity = std::strtoul(value, &end, 10);
+    return end != value && *end == '\0' ? static_cast<std::size_t>(capacity) : 0;
+}
+
+bool storeFd(int fd, std::string_view name) noexcept {
+    char state[300];
+    std::snprintf(state, sizeof(state), "FDSTORE=1\nFDNAME=%.*s",
+                  static_cast<int>(name.size()), name.data());
+    return sd_pid_notify_with_fds(0, /*unset_environment=*/0, state, &fd, 1) > 0;
+}
+
+void removeStoredFds(std::string_view name) noexcept {
+    sd_notifyf(0, "FDSTOREREMOVE=1\nFDNAME=%.*s",
+               static_cast<int>(name.size()), name.data());
+}
+
 } // namespace SystemdNotify
 } // namespace cec_control
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace cec_control {
 namespace SystemdNotify {
@@ -61,5 +64,60 @@ void status(std::string_view text) noexcept;
  */
 [[nodiscard]] bool watchdogEnabled(std::chrono::microseconds& interval) noexcept;
 
+/** @c FDNAME the daemon stores its own listening socket under. */
+inline constexpr std::string_view kListenerFdName = "listener";
+
+/** @c FDNAME prefix of stored client sessions; the rest is their state. */
+inline constexpr std::string_view kSessionFdPrefix = "session.";
+
+/** A passed client session and the name it was stored under. */
+struct InheritedFd {
+    int         fd = -1;
+    std::string name;
+};
+
+/** The descriptors the service manager passed at startup, sorted out. */
+struct InheritedFds {
+    /** Listening socket for the daemon's path, or -1. */
+    int  listener = -1;
+    /**
+     * The listener came out of the fd store, where an earlier daemon
+     * put it, rather than from a socket unit.
+     */
+    bool listenerStored = false;
+    /** Connected sessions an earlier daemon stored as it stopped. */
+    std::vector<InheritedFd> sessions;
+};
+
+/**
+ * Take the descriptors the service manager passed: a listening
+ * @c SOCK_SEQPACKET socket bound to @p path, from a socket unit or the
+ * fd store, and any sessions stored under @c kSessionFdPrefix names.
+ * Every descriptor returned is non-blocking and close-on-exec, and the
+ * caller owns it. Passed descriptors that fit neither are closed with
+ * a warning. The activation environment is cleared either way, so hook
+ * children do not inherit the claim.
+ */
+[[nodiscard]] InheritedFds takeInheritedFds(const std::string& path);
+
+/**
+ * Descriptors the service manager will keep for this unit across a
+ * restart (@c $FDSTORE, from @c FileDescriptorStoreMax=), or 0 when it
+ * keeps none. systemd sets @c $FDSTORE from version 254; older ones
+ * keep descriptors too but do not say so, and read as 0 here.
+ */
+[[nodiscard]] std::size_t fdStoreCapacity() noexcept;
+
+/**
+ * Hand the service manager a duplicate of @p fd to keep under @p name
+ * (at most 255 characters, no @c ':'), to be passed to the next start
+ * of the unit. Returns @c false if the message could not be sent; a
+ * full or disabled store drops it without telling us.
+ */
+bool storeFd(int fd, std::string_view name) noexcept;
+
+/** Close every descriptor the service manager keeps under @p name. */
+void removeStoredFds(std::string_view name) noexcept;
+
 } // namespace SystemdNotify
 } // namespace cec_control
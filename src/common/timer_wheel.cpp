@@ -0,0 +1,195 @@
+#include "timer_wheel.h"
+
+namespace cec_control {
+
+namespace {
+
+constexpr std::size_t kExpiredLevel = TimerWheel::kLevels;
+
+constexpr std::size_t shiftFor(std::size_t level) noexcept {
+    return level * TimerWheel::kSlotBits;
+}
+
+/** Rotate @p bits right by @p n (0 <= n < 64). */
+constexpr uint64_t rotateRight(uint64_t bits, unsigned n) noexcept {
+    return n == 0 ? bits : (bits >> n) | (bits << (64 - n));
+}
+
+} // namespace
+
+TimerWheel::Node::~Node() {
+    if (m_wheel != nullptr) m_wheel->cancel(*this);
+}
+
+TimerWheel::TimerWheel(Tick now) noexcept : m_now(now) {
+    for (auto& level : m_slots) {
+        for (auto& head : level) {
+            head.prev = head.next = &head;
+        }
+    }
+    m_expired.prev = m_expired.next = &m_expired;
+}
+
+TimerWheel::~TimerWheel() {
+    // Owners normally outlive their scheduled state; detach any that
+    // do not so their destructors do not reach back into a dead wheel.
+    auto detach = [](Link& head) {
+        for (Link* link = head.next; link != &head;) {
+            Link* next = link->next;
+            auto& node = static_cast<Node&>(*link);
+            node.prev = node.next = nullptr;
+            node.m_wheel = nullptr;
+            link = next;
+        }
+        head.prev = head.next = &head;
+    };
+    for (auto& level : m_slots) {
+        for (auto& head : level) detach(head);
+    }
+    detach(m_expired);
+}
+
+void TimerWheel::pushBack(Link& head, Link& link) noexcept {
+    link.prev       = head.prev;
+    link.next       = &head;
+    head.prev->next = &link;
+    head.prev       = &link;
+}
+
+void TimerWheel::schedule(Node& node, Tick expires) noexcept {
+    if (node.m_wheel != nullptr) unlink(node);
+    node.m_wheel   = this;
+    node.m_expires = expires;
+    place(node);
+}
+
+void TimerWheel::cancel(Node& node) noexcept {
+    if (node.m_wheel != this) return;
+    unlink(node);
+    node.m_wheel = nullptr;
+}
+
+void TimerWheel::place(Node& node) noexcept {
+    // A deadline already reached is due at the current tick, which
+    // level 0 keeps in the slot advance() collects next.
+    const Tick expires = node.m_expires > m_now ? node.m_expires : m_now;
+
+    // Lowest level whose slot span separates the deadline from now by
+    // fewer than kSlots slots. Past the top level, park the node in the
+    // farthest top-level slot; it is placed again when that slot cascades.
+    std::size_t level = 0;
+    while (level + 1 < kLevels &&
+           (expires >> shiftFor(level)) - (m_now >> shiftFor(level)) >= kSlots) {
+        ++level;
+    }
+    Tick index = expires >> shiftFor(level);
+    const Tick current = m_now >> shiftFor(level);
+    if (index - current >= kSlots) index = current + kSlots - 1;
+
+    const auto slot = static_cast<std::size_t>(index & (kSlots - 1));
+    node.m_level = static_cast<uint8_t>(level);
+    node.m_slot  = static_cast<uint8_t>(slot);
+    pushBack(m_slots[level][slot], node);
+    m_occupied[level] |= uint64_t{1} << slot;
+}
+
+void TimerWheel::unlink(Node& node) noexcept {
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.prev = node.next = nullptr;
+    if (node.m_level == kExpiredLevel) return;
+    const Link& head = m_slots[node.m_level][node.m_slot];
+    if (head.next == &head) {
+        m_occupied[node.m_level] &= ~(uint64_t{1} << node.m_slot);
+    }
+}
+
+std::optional<TimerWheel::Tick> TimerWheel::nextEvent() const noexcept {
+    if (m_expired.next != &m_expired) return m_now;
+    return nextSlotEvent();
+}
+
+std::optional<TimerWheel::Tick> TimerWheel::nextSlotEvent() const noexcept {
+    std::optional<Tick> next;
+    for (std::size_t level = 0; level < kLevels; ++level) {
+        const uint64_t bits = m_occupied[level];
+        if (bits == 0) continue;
+        const Tick current = m_now >> shiftFor(level);
+        const auto offset  = static_cast<unsigned>(current & (kSlots - 1));
+        const auto ahead   = static_cast<Tick>(
+            __builtin_ctzll(rotateRight(bits, offset)));
+        // Level 0 slots hold single ticks; a higher slot needs
+        // attention when the wheel reaches its first tick.
+        const Tick at = (current + ahead) << shiftFor(level);
+        if (!next || at < *next) next = at;
+    }
+    return next;
+}
+
+void TimerWheel::cascade(std::size_t level, std::size_t slot) noexcept {
+    Link& head = m_slots[level][slot];
+    if (head.next == &head) return;
+    // Detach the whole list first: re-placing may put a node back into
+    // this very slot (a top-level deadline still out of range).
+    Link pending;
+    pending.next       = head.next;
+    pending.prev       = head.prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    head.prev = head.next = &head;
+    m_occupied[level] &= ~(uint64_t{1} << slot);
+
+    while (pending.next != &pending) {
+        auto& node = static_cast<Node&>(*pending.next);
+        pending.next       = node.next;
+        node.next->prev    = &pending;
+        node.prev = node.next = nullptr;
+        place(node);
+    }
+}
+
+void TimerWheel::collectDue() noexcept {
+    const auto slot = static_cast<std::size_t>(m_now & (kSlots - 1));
+    Link& head = m_slots[0][slot];
+    while (head.next != &head) {
+        auto& node = static_cast<Node&>(*head.next);
+        head.next       = node.next;
+        node.next->prev = &head;
+        node.m_level = static_cast<uint8_t>(kExpiredLevel);
+        pushBack(m_expired, node);
+    }
+    m_occupied[0] &= ~(uint64_t{1} << slot);
+}
+
+void TimerWheel::advance(Tick now) noexcept {
+    // Jump from one occupied slot to the next; each pass empties the
+    // slot it lands on, so the loop ends once nothing is due by @p now.
+    while (true) {
+        const auto next = nextSlotEvent();
+        if (!next || *next > now) break;
+        if (*next > m_now) m_now = *next;
+        // Cascade from the top so a node falling several levels lands in
+        // level 0 before level 0's slot for this tick is collected.
+        for (std::size_t level = kLevels - 1; level > 0; --level) {
+            if ((m_now & ((Tick{1} << shiftFor(level)) - 1)) == 0) {
+                cascade(level, static_cast<std::size_t>(
+                    (m_now >> shiftFor(level)) & (kSlots - 1)));
+            }
+        }
+        collectDue();
+    }
+    // Nothing else is due by @p now, so the ticks in between can be
+    // skipped without passing an occupied slot.
+    if (now > m_now) m_now = now;
+}
+
+void TimerWheel::deliver() {
+    while (m_expired.next != &m_expired) {
+        auto& node = static_cast<Node&>(*m_expired.next);
+        unlink(node);
+        node.m_wheel = nullptr;
+        node.expire();
+    }
+}
+
+} // namespace cec_control
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace cec_control {
+
+/**
+ * Hierarchical timing wheel: the bookkeeping behind every @c LoopTimer
+ * on an @c EventLoop, so any number of deadlines share one timerfd.
+ *
+ * Time is an integer tick count (the loop uses milliseconds). The
+ * wheel has @c kLevels levels of @c kSlots slots; a slot on level L
+ * spans 64^L ticks, so level 0 resolves single ticks and the top level
+ * reaches about 4.6 hours at 1 ms per tick. A deadline beyond that
+ * waits in the top level's farthest slot and is placed again when the
+ * wheel gets there.
+ *
+ * Arming and cancelling are O(1): a timer is an intrusive @c Node
+ * linked into one slot list, with a per-level occupancy bitmap kept
+ * beside the lists. Finding the next deadline is a bitmap scan of
+ * each level, and advancing jumps straight from one occupied slot to
+ * the next rather than stepping tick by tick, so a wheel that holds
+ * only far-off timers costs nothing while it waits. When the wheel
+ * reaches a higher-level slot, that slot's timers cascade down to the
+ * level that resolves them.
+ *
+ * Not thread-safe; the owning loop's thread only.
+ */
+class TimerWheel {
+public:
+    using Tick = uint64_t;
+
+    static constexpr std::size_t kLevels    = 4;
+    static constexpr std::size_t kSlotBits  = 6;
+    static constexpr std::size_t kSlots     = std::size_t{1} << kSlotBits;
+
+    /** List linkage shared by timer nodes and the slot heads. */
+    struct Link {
+        Link* prev = nullptr;
+        Link* next = nullptr;
+    };
+
+    /**
+     * One schedulable deadline. Owners derive from it and implement
+     * @c expire; a node unlinks itself when destroyed, so an owner
+     * that goes away while armed cannot leave a dangling entry.
+     */
+    class Node : private Link {
+    public:
+        Node() = default;
+        virtual ~Node();
+
+        Node(const Node&)            = delete;
+        Node& operator=(const Node&) = delete;
+
+        /** @c true while scheduled or expired but not yet delivered. */
+        [[nodiscard]] bool scheduled() const noexcept { return m_wheel != nullptr; }
+
+        /** The tick this node is due at; meaningful while @c scheduled. */
+        [[nodiscard]] Tick expires() const noexcept { return m_expires; }
+
+    protected:
+        /** Called by @c TimerWheel::deliver after the node is unlinked. */
+        virtual void expire() = 0;
+
+    private:
+        friend class TimerWheel;
+
+        TimerWheel* m_wheel   = nullptr;
+        Tick        m_expires = 0;
+        // Slot the node is linked into; kLevels marks the expired list.
+        uint8_t     m_level   = 0;
+        uint8_t     m_slot    = 0;
+    };
+
+    explicit TimerWheel(Tick now = 0) noexcept;
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&)            = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /** The wheel's current tick. */
+    [[nodiscard]] Tick now() const noexcept { return m_now; }
+
+    /**
+     * Schedule @p node for @p expires, moving it if it is already
+     * scheduled. A tick at or before @c now() is due on the next
+     * @c advance.
+     */
+    void schedule(Node& node, Tick expires) noexcept;
+
+    /** Unschedule @p node. Idempotent. */
+    void cancel(Node& node) noexcept;
+
+    /**
+     * Earliest tick at which @c advance has work to do: a timer falling
+     * due or a higher-level slot to cascade. @c std::nullopt when
+     * nothing is scheduled.
+     */
+    [[nodiscard]] std::optional<Tick> nextEvent() const noexcept;
+
+    /**
+     * Move the wheel forward to @p now and queue every timer due by
+     * then for @c deliver, in deadline order. A @p now behind the
+     * wheel's own tick is ignored.
+     */
+    void advance(Tick now) noexcept;
+
+    /**
+     * Call @c expire on each timer @c advance queued, one at a time.
+     * An expiring timer may schedule or cancel any node, itself and
+     * the ones still queued included.
+     */
+    void deliver();
+
+private:
+    /** Link @p node into the slot that resolves its deadline. */
+    void place(Node& node) noexcept;
+
+    /** Unlink @p node from whichever list holds it. */
+    void unlink(Node& node) noexcept;
+
+    /** Like @c nextEvent, ignoring timers already queued for delivery. */
+    [[nodiscard]] std::optional<Tick> nextSlotEvent() const noexcept;
+
+    /** Re-place every node in @p level's slot @p slot. */
+    void cascade(std::size_t level, std::size_t slot) noexcept;
+
+    /** Move level 0's slot for @c m_now onto the expired list. */
+    void collectDue() noexcept;
+
+    static void pushBack(Link& head, Link& link) noexcept;
+
+    Tick m_now;
+    std::array<std::array<Link, kSlots>, kLevels> m_slots{};
+    std::array<uint64_t, kLevels>                 m_occupied{};
+    Link                                          m_expired;
+};
+
+} // namespace cec_control
@@ -0,0 +1,156 @@
+#include "trace.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string_view>
+
+namespace cec_control {
+
+namespace {
+
+// Event names, indexed by TracePoint.
+constexpr std::array<std::string_view, kTracePointCount> kTracePointNames = {
+    "socket.request",
+    "dispatch",
+    "worker.enqueue",
+    "worker.queue_wait",
+    "worker.task",
+    "throttle.wait",
+    "libcec.call",
+    "main.post",
+    "main.work",
+    "socket.send",
+};
+static_assert(static_cast<std::size_t>(TracePoint::SocketSend) + 1 == kTracePointCount,
+              "kTracePointCount drift");
+
+int64_t toMicros(Tracer::TimePoint at) noexcept {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        at.time_since_epoch()).count();
+}
+
+// Thread names come from pthread_getname_np and are plain ASCII in
+// practice; escape the JSON-significant bytes anyway.
+void writeJsonString(std::ostringstream& out, std::string_view text) {
+    out << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+Tracer& Tracer::getInstance() noexcept {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Ring* Tracer::ringForThisThread() noexcept {
+    thread_local bool  claimed = false;
+    thread_local Ring* ring    = nullptr;
+    if (!claimed) {
+        claimed = true;
+        const std::size_t index = m_claimed.fetch_add(1, std::memory_order_relaxed);
+        if (index < kMaxThreads) {
+            ring = &m_rings[index];
+            ::pthread_getname_np(::pthread_self(), ring->name.data(), ring->name.size());
+            ring->named.store(true, std::memory_order_release);
+        }
+    }
+    return ring;
+}
+
+void Tracer::complete(TracePoint point, TimePoint start, TimePoint end,
+                      uint32_t arg) noexcept {
+    if (!enabled()) return;
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    record(point, start, static_cast<uint32_t>(us < 0 ? 0 : us), /*instant=*/false, arg);
+}
+
+void Tracer::instant(TracePoint point, uint32_t arg) noexcept {
+    if (!enabled()) return;
+    record(point, Clock::now(), 0, /*instant=*/true, arg);
+}
+
+void Tracer::record(TracePoint point, TimePoint start, uint32_t durationUs,
+                    bool instant, uint32_t arg) noexcept {
+    Ring* ring = ringForThisThread();
+    if (ring == nullptr) return;
+
+    // Single writer per ring: the owning thread.
+    const uint64_t index = ring->next.load(std::memory_order_relaxed);
+    ring->next.store(index + 1, std::memory_order_relaxed);
+    Slot& slot = ring->slots[index % kRingCapacity];
+
+    // Sequence lock: odd while the fields are in flux, so a concurrent
+    // reader can tell a torn slot from a settled one.
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.startUs.store(toMicros(start), std::memory_order_relaxed);
+    slot.durationUs.store(durationUs, std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    slot.point.store(static_cast<uint8_t>(point), std::memory_order_relaxed);
+    slot.instant.store(instant, std::memory_order_relaxed);
+    slot.seq.store(2 * (index + 1), std::memory_order_release);
+}
+
+std::string Tracer::renderChromeJson() const {
+    std::ostringstream out;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    const std::size_t claimed =
+        std::min(m_claimed.load(std::memory_order_relaxed), kMaxThreads);
+    for (std::size_t tid = 0; tid < claimed; ++tid) {
+        const Ring& ring = m_rings[tid];
+        // Claimed but its owner has not recorded anything yet.
+        if (!ring.named.load(std::memory_order_acquire)) continue;
+
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, std::string_view(ring.name.data()));
+        out << "}}";
+
+        for (const Slot& slot : ring.slots) {
+            const uint64_t before = slot.seq.load(std::memory_order_acquire);
+            if (before == 0 || (before & 1) != 0) continue;
+            const int64_t  startUs    = slot.startUs.load(std::memory_order_relaxed);
+            const uint32_t durationUs = slot.durationUs.load(std::memory_order_relaxed);
+            const uint32_t arg        = slot.arg.load(std::memory_order_relaxed);
+            const uint8_t  point      = slot.point.load(std::memory_order_relaxed);
+            const bool     instant    = slot.instant.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != before) continue;
+            if (point >= kTracePointCount) continue;
+
+            separator();
+            out << "{\"name\":\"" << kTracePointNames[point]
+                << "\",\"cat\":\"cec\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << startUs;
+            if (instant) {
+                out << ",\"ph\":\"i\",\"s\":\"t\"";
+            } else {
+                out << ",\"ph\":\"X\",\"dur\":" << durationUs;
+            }
+            out << ",\"args\":{\"arg\":" << arg << "}}";
+        }
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+} // namespace cec_control
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cec_control {
+
+/**
+ * Instrumented points on the request pipeline. Each is rendered as one
+ * named event in the trace; extend alongside the name table in
+ * trace.cpp.
+ */
+enum class TracePoint : uint8_t {
+    SocketRequest,    ///< SocketServer::processRequest, parse to handler return.
+    Dispatch,         ///< CommandDispatcher::dispatch.
+    WorkerEnqueue,    ///< Instant: a task admitted to the adapter worker.
+    WorkerQueueWait,  ///< A task's wait between admission and first run.
+    WorkerTask,       ///< One task slice on the adapter worker.
+    ThrottleWait,     ///< Wait for a reserved throttle slot.
+    LibcecCall,       ///< One libcec API call.
+    MainThreadPost,   ///< Instant: a closure posted to the main thread.
+    MainThreadWork,   ///< One posted closure running on the main thread.
+    SocketSend,       ///< SocketServer::sendResponse.
+};
+inline constexpr std::size_t kTracePointCount = 10;
+
+/**
+ * Process-wide span recorder for the request pipeline. Singleton, like
+ * @c Metrics, for the same reason: the points span every thread.
+ *
+ * ## Cost
+ *
+ * Disabled (the default), every record site is one relaxed atomic load
+ * and a branch. Enabled, an event is a handful of relaxed stores into
+ * a ring slot the recording thread owns — no lock, no allocation, no
+ * syscall beyond @c steady_clock::now().
+ *
+ * ## Storage
+ *
+ * A fixed pool of @c kMaxThreads rings of @c kRingCapacity events each,
+ * allocated statically with the singleton. A thread claims a ring on
+ * its first event (one atomic increment) and keeps it for life; threads
+ * past the pool size go unrecorded. Each ring keeps its newest
+ * @c kRingCapacity events, overwriting the oldest.
+ *
+ * ## Reading
+ *
+ * @c renderChromeJson copies every ring under a per-slot sequence check
+ * and discards slots caught mid-write, so it runs concurrently with
+ * recorders without stopping them. Output is the Chrome trace-event
+ * JSON format, which both @c chrome://tracing and Perfetto load.
+ */
+class Tracer {
+public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    static constexpr std::size_t kMaxThreads   = 8;
+    static constexpr std::size_t kRingCapacity = 1024;
+
+    static Tracer& getInstance() noexcept;
+
+    Tracer(const Tracer&)            = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    [[nodiscard]] bool enabled() const noexcept {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /** Start or stop recording. Recorded events are kept either way. */
+    void setEnabled(bool on) noexcept { m_enabled.store(on, std::memory_order_relaxed); }
+
+    /** Record a span on the calling thread from @p start to @p end. */
+    void complete(TracePoint point, TimePoint start, TimePoint end,
+                  uint32_t arg = 0) noexcept;
+
+    /** Record a zero-length event on the calling thread. */
+    void instant(TracePoint point, uint32_t arg = 0) noexcept;
+
+    /**
+     * Every event currently held, as a Chrome trace-event JSON
+     * document. Events carry @c arg as @c args.arg; each ring becomes
+     * one thread track named after its thread.
+     */
+    [[nodiscard]] std::string renderChromeJson() const;
+
+private:
+    Tracer() = default;
+
+    struct Slot {
+        // 0 = never written; odd = being written; else 2 * (index + 1).
+        std::atomic<uint64_t> seq{0};
+        std::atomic<int64_t>  startUs{0};
+        std::atomic<uint32_t> durationUs{0};
+        std::atomic<uint32_t> arg{0};
+        std::atomic<uint8_t>  point{0};
+        std::atomic<bool>     instant{false};
+    };
+
+    struct Ring {
+        std::atomic<uint64_t>           next{0};
+        std::array<Slot, kRingCapacity> slots;
+        std::array<char, 16>            name{};   ///< Owner's pthread name.
+        std::atomic<bool>               named{false};  ///< @c name is set.
+    };
+
+    /** The calling thread's ring, claimed on first use; null if none left. */
+    [[nodiscard]] Ring* ringForThisThread() noexcept;
+
+    void record(TracePoint point, TimePoint start, uint32_t durationUs,
+                bool instant, uint32_t arg) noexcept;
+
+    std::atomic<bool>             m_enabled{false};
+    std::atomic<std::size_t>      m_claimed{0};
+    std::array<Ring, kMaxThreads> m_rings;
+};
+
+/**
+ * Records the lifetime of the enclosing scope as one @c TracePoint
+ * span. Reads the clock only if tracing was enabled on entry.
+ */
+class TraceScope {
+public:
+    explicit TraceScope(TracePoint point, uint32_t arg = 0) noexcept
+        : m_point(point), m_arg(arg), m_active(Tracer::getInstance().enabled()) {
+        if (m_active) m_start = Tracer::Clock::now();
+    }
+
+    ~TraceScope() {
+        if (m_active) {
+            Tracer::getInstance().complete(m_point, m_start, Tracer::Clock::now(), m_arg);
+        }
+    }
+
+    TraceScope(const TraceScope&)            = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TracePoint         m_point;
+    uint32_t           m_arg;
+    bool               m_active;
+    Tracer::TimePoint  m_start{};
+};
+
+} // namespace cec_control
@@ -213,6 +213,17 @@ UnixSocket UnixSocket::connect(const std::string& path, Deadline deadline) {
     return sock;
 }
 
+std::optional<ucred> UnixSocket::peerCredentials() const {
+    if (m_fd < 0) return std::nullopt;
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (::getsockopt(m_fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        LOG_DEBUG("getsockopt(SO_PEERCRED) failed: ", std::strerror(errno));
+        return std::nullopt;
+    }
+    return cred;
+}
+
 UnixSocket UnixSocket::accept() const {
     if (m_fd < 0) return {};
     int fd = ::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <optional>
 #include <string>
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <utility>
 
@@ -71,6 +73,12 @@ public:
      */
     [[nodiscard]] UnixSocket accept() const;
 
+    /**
+     * The connected peer's process credentials (@c SO_PEERCRED), as
+     * they were when it connected. @c std::nullopt on failure.
+     */
+    [[nodiscard]] std::optional<ucred> peerCredentials() const;
+
     /** Apply the same timeout to both SO_RCVTIMEO and SO_SNDTIMEO. */
     [[nodiscard]] bool setIoTimeout(std::chrono::milliseconds timeout) const;
 
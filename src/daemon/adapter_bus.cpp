@@ -0,0 +1,150 @@
+#include "adapter_bus.h"
+
+#include <chrono>
+#include <vector>
+
+#include "../common/event_loop.h"
+#include "../common/logger.h"
+#include "../common/main_thread_work.h"
+#include "adapter_lifecycle.h"
+#include "cec/adapter_worker.h"
+#include "cec/libcec_adapter.h"
+#include "cec/simulated_adapter.h"
+#include "command_dispatcher.h"
+#include "device_state_cache.h"
+#include "standby_policy.h"
+
+namespace cec_control {
+
+AdapterBus::AdapterBus(const AppConfig& config, AdapterConfig adapter, MainThreadWork& work,
+                       EventLoop& loop, StandbyPolicy& standbyPolicy,
+                       const FrameFilter& frames, ConnectionLostCallback onConnectionLost)
+    : m_adapter(std::move(adapter)),
+      m_work(work),
+      m_loop(loop),
+      m_onConnectionLost(std::move(onConnectionLost)),
+      m_observations(work),
+      m_adapterReadyTimer(loop),
+      m_adapterIdleTimer(loop),
+      m_keyRepeatTimer(loop),
+      m_reconnectRetryTimer(loop) {
+    // Raw frames and the capture are the default adapter's.
+    ICecAdapter::Callbacks callbacks{
+        /*onObservation*/    [this](ICecAdapter::Observation obs) {
+            m_observations.publish(obs);
+        },
+        /*onConnectionLost*/ [this]() {
+            m_work.post([this]() { m_onConnectionLost(); });
+        },
+        /*frames*/           &frames,
+        /*rawFrames*/        nullptr,
+        /*capture*/          nullptr,
+    };
+    std::unique_ptr<ICecAdapter> cec;
+    if (config.simulator.enabled) {
+        cec = std::make_unique<SimulatedCecAdapter>(m_adapter, config.simulator,
+                                                    std::move(callbacks));
+    } else {
+        cec = std::make_unique<LibCecAdapter>(m_adapter, std::move(callbacks));
+    }
+    m_worker = std::make_unique<AdapterWorker>(std::move(cec),
+                                               config.dispatcher.maxQueuedCommands);
+
+    PowerFanoutConfig fanout;
+    fanout.wakeDevices     = m_adapter.wakeDevices;
+    fanout.powerOffDevices = m_adapter.powerOffDevices;
+    m_lifecycle = std::make_unique<AdapterLifecycle>(
+        *m_worker, m_work, fanout, m_adapterIdleTimer,
+        std::chrono::milliseconds(config.daemon.adapterIdleCloseMs));
+    m_stateCache = std::make_unique<DeviceStateCache>(
+        config.stateCache, *m_worker, m_work, config.daemon.lowMemory);
+    m_dispatcher = std::make_unique<CommandDispatcher>(
+        config, *m_worker, m_work, *m_lifecycle, standbyPolicy, *m_stateCache,
+        m_keyRepeatTimer);
+
+    // The cache first, as on the default bus, so the throttler sees the
+    // state the observation left.
+    using Kind = ICecAdapter::Observation::Kind;
+    using Obs  = ICecAdapter::Observation;
+    const auto bit = ObservationBus::kindBit;
+    m_observations.subscribe(ObservationBus::kAllKinds & ~bit(Kind::RawFrame),
+                             [this](const Obs& obs) { m_stateCache->observe(obs); });
+    m_observations.subscribe(ObservationBus::kAllKinds & ~bit(Kind::HostActivated) &
+                                 ~bit(Kind::HostDeactivated),
+                             [this](const Obs& obs) {
+                                 if (const auto device = ObservationBus::heardFrom(obs)) {
+                                     m_dispatcher->throttler().noteHeardFrom(*device);
+                                 }
+                             });
+}
+
+AdapterBus::~AdapterBus() {
+    stop();
+    if (m_registered) m_loop.remove(m_observations.fd());
+}
+
+bool AdapterBus::start(const AppConfig& config, std::function<void(bool)> onOpened) {
+    const auto READ = static_cast<uint32_t>(EventPoller::Event::READ);
+    if (!m_observations.valid() ||
+        !m_loop.add(m_observations.fd(), READ,
+                    [this](uint32_t) { m_observations.drain(); })) {
+        LOG_ERROR("Failed to register the observation bus of adapter ", name());
+        return false;
+    }
+    m_registered = true;
+
+    m_adapterReadyTimer.setHandler([this] {
+        m_adapterReadyTimer.consume();
+        m_lifecycle->expireHeld();
+    });
+    m_adapterIdleTimer.setHandler([this] { m_lifecycle->onIdleTimerFired(); });
+    m_keyRepeatTimer.setHandler([this] { m_dispatcher->onKeyRepeatTimerFired(); });
+
+    m_worker->start(config.scheduling.adapter);
+    m_lifecycle->openAsync(
+        [this, onOpened = std::move(onOpened)](
+            bool adapterValid, std::vector<AdapterLifecycle::HeldCommand> held) {
+            m_adapterReadyTimer.disarm();
+            for (auto& entry : held) {
+                if (adapterValid) {
+                    m_dispatcher->dispatch(std::move(entry.command), std::move(entry.reply));
+                } else {
+                    entry.reply(Message(MessageType::RESP_NOT_READY));
+                }
+            }
+            if (onOpened) onOpened(adapterValid);
+        });
+    const auto readyTimeout = std::chrono::milliseconds(config.daemon.adapterReadyTimeoutMs);
+    if (readyTimeout.count() > 0 && !m_adapterReadyTimer.armOnce(readyTimeout)) {
+        LOG_WARNING("Failed to arm the ready timer of adapter ", name(),
+                    "; commands wait for the open");
+    }
+    if (config.daemon.scanDevicesAtStartup) {
+        m_stateCache->scanTopology([](bool) {});
+    }
+    return true;
+}
+
+void AdapterBus::stop() {
+    if (m_dispatcher) m_dispatcher->shutdown();
+    if (m_lifecycle) m_lifecycle->shutdown();
+    if (m_worker) m_worker->stop();
+}
+
+void AdapterBus::reconfigure(const AppConfig& config) {
+    m_dispatcher->reconfigure(config);
+}
+
+void AdapterBus::reconfigureAdapter(const AdapterConfig& adapter) {
+    m_adapter = adapter;
+    PowerFanoutConfig fanout;
+    fanout.wakeDevices     = adapter.wakeDevices;
+    fanout.powerOffDevices = adapter.powerOffDevices;
+    m_lifecycle->reconfigureAsync(adapter, fanout, /*reopen=*/true, [this](bool ok) {
+        if (ok) return;
+        LOG_WARNING("Adapter ", name(), " left closed after reload; starting the reconnect cycle");
+        m_onConnectionLost();
+    });
+}
+
+} // namespace cec_control
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../common/loop_timer.h"
+#include "app_config.h"
+#include "cec/adapter_config.h"
+#include "observation_bus.h"
+
+namespace cec_control {
+
+class AdapterLifecycle;
+class AdapterWorker;
+class CommandDispatcher;
+class DeviceStateCache;
+class EventLoop;
+class FrameFilter;
+class MainThreadWork;
+class StandbyPolicy;
+
+/**
+ * @class AdapterBus
+ * @brief One further CEC adapter, from an @c [Adapter.NAME] section,
+ *        with everything that drives it.
+ *
+ * Owns the adapter's @c AdapterWorker thread, its @c AdapterLifecycle,
+ * its @c DeviceStateCache and its @c CommandDispatcher (and with it
+ * the dispatcher's own @c CommandThrottler), plus the loop timers those
+ * arm and an @c ObservationBus fed by the adapter's libcec threads.
+ * Each bus runs on its own worker, so commands on two buses never wait
+ * on each other. @c CECDaemon builds the default @c [Adapter] bus
+ * itself; this class holds the rest, one instance each.
+ *
+ * Only the bus's own state cache and throttler consume its
+ * observations. The daemon-wide consumers — hooks, the standby policy,
+ * event subscribers, the status page, device profiles and the traffic
+ * capture — follow the default adapter. The @c StandbyPolicy is shared
+ * so @c CMD_AUTO_STANDBY means the same on every bus.
+ *
+ * The adapter always opens on the worker (as with @c DeferAdapterOpen),
+ * so a slow libcec open on one bus delays neither the daemon's start
+ * nor the other buses. Main thread only, except for the adapter
+ * callbacks, which only publish to the bus or post to @c MainThreadWork.
+ */
+class AdapterBus {
+public:
+    /** Fires on the main thread when the adapter reports a lost connection. */
+    using ConnectionLostCallback = std::function<void()>;
+
+    /**
+     * Build the bus for @p adapter. @p config supplies the daemon-wide
+     * settings (dispatcher, throttler, simulator, idle close); it is
+     * read here and by @c reconfigure, not retained. The references
+     * must outlive @c this.
+     */
+    AdapterBus(const AppConfig& config, AdapterConfig adapter, MainThreadWork& work,
+               EventLoop& loop, StandbyPolicy& standbyPolicy, const FrameFilter& frames,
+               ConnectionLostCallback onConnectionLost);
+    ~AdapterBus();
+
+    AdapterBus(const AdapterBus&)            = delete;
+    AdapterBus& operator=(const AdapterBus&) = delete;
+
+    /**
+     * Register the observation fd with the loop, start the worker and
+     * submit the open. @p onOpened fires on the main thread once the
+     * open has finished, after any commands held meanwhile have been
+     * dispatched or answered @c RESP_NOT_READY. Returns @c false when
+     * the bus cannot be registered; nothing has been started then.
+     */
+    [[nodiscard]] bool start(const AppConfig& config, std::function<void(bool)> onOpened);
+
+    /**
+     * Flip the dispatcher and lifecycle shutdown gates and join the
+     * worker, closing the adapter on its exit path. Idempotent.
+     */
+    void stop();
+
+    /** Adopt the hot-swappable dispatcher and throttler settings of @p config. */
+    void reconfigure(const AppConfig& config);
+
+    /**
+     * Hand reloaded @c [Adapter.NAME] values to the lifecycle, which
+     * reopens the adapter with them. A reopen that fails is reported
+     * like a lost connection, so the reconnect cycle takes over.
+     */
+    void reconfigureAdapter(const AdapterConfig& adapter);
+
+    /** The @c [Adapter.NAME] section's NAME. */
+    [[nodiscard]] const std::string& name() const noexcept { return m_adapter.name; }
+
+    /** The port the adapter opens; empty on the simulated bus. */
+    [[nodiscard]] const std::string& port() const noexcept { return m_adapter.port; }
+
+    [[nodiscard]] AdapterWorker&     worker() noexcept { return *m_worker; }
+    [[nodiscard]] AdapterLifecycle&  lifecycle() noexcept { return *m_lifecycle; }
+    [[nodiscard]] CommandDispatcher& dispatcher() noexcept { return *m_dispatcher; }
+    [[nodiscard]] DeviceStateCache&  stateCache() noexcept { return *m_stateCache; }
+
+    /** Timer the supervisor's reconnect cycle for this bus retries on. */
+    [[nodiscard]] LoopTimer& reconnectRetryTimer() noexcept { return m_reconnectRetryTimer; }
+
+private:
+    AdapterConfig          m_adapter;
+    MainThreadWork&        m_work;
+    EventLoop&             m_loop;
+    ConnectionLostCallback m_onConnectionLost;
+
+    // Carries the adapter's observations to the main thread; overflows
+    // into m_work.
+    ObservationBus m_observations;
+    bool           m_registered = false;
+    LoopTimer      m_adapterReadyTimer;
+    LoopTimer      m_adapterIdleTimer;
+    LoopTimer      m_keyRepeatTimer;
+    LoopTimer      m_reconnectRetryTimer;
+
+    // The same order as in CECDaemon: the dispatcher holds the
+    // lifecycle and cache, and all three hold the worker, so reverse
+    // declaration order tears them down dispatcher first.
+    std::unique_ptr<AdapterWorker>     m_worker;
+    std::unique_ptr<AdapterLifecycle>  m_lifecycle;
+    std::unique_ptr<DeviceStateCache>  m_stateCache;
+    std::unique_ptr<CommandDispatcher> m_dispatcher;
+};
+
+} // namespace cec_control
@@ -1,25 +1,42 @@
 #include "adapter_lifecycle.h"
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
 #include <utility>
 
 #include "../common/logger.h"
 #include "../common/main_thread_work.h"
+#include "../common/loop_timer.h"
 #include "cec/adapter_interface.h"
 #include "cec/adapter_worker.h"
+#include "flight_recorder.h"
 
 namespace cec_control {
 
-AdapterLifecycle::AdapterLifecycle(AdapterWorker&  worker,
-                                   MainThreadWork& work) noexcept
+using flight_log::Milestone;
+
+AdapterLifecycle::AdapterLifecycle(AdapterWorker&            worker,
+                                   MainThreadWork&           work,
+                                   PowerFanoutConfig         fanout,
+                                   LoopTimer&                idleTimer,
+                                   std::chrono::milliseconds idleClose) noexcept
     : m_worker(worker),
-      m_work(work) {}
+      m_work(work),
+      m_idleTimer(idleTimer),
+      m_fanout(fanout),
+      m_idleClose(idleClose) {
+    noteActivity();
+}
 
 void AdapterLifecycle::shutdown() {
     if (m_shutdownComplete) return;
     m_shutdownComplete = true;
 
     auto toDiscard = m_suspendQueue.drain();
+    // The socket server is already gone, so these sinks go nowhere;
+    // dropping them is all that is left.
+    m_held.clear();
 
     LOG_INFO("Shutting down adapter lifecycle");
     if (!toDiscard.empty()) {
@@ -36,84 +53,225 @@ bool AdapterLifecycle::isSuspended() const noexcept {
     return m_suspendQueue.isSuspended();
 }
 
-void AdapterLifecycle::enqueue(const Message& cmd) {
-    m_suspendQueue.push(cmd);
+bool AdapterLifecycle::enqueue(const Message& cmd) {
+    return m_suspendQueue.push(cmd);
+}
+
+void AdapterLifecycle::setSuspendQueueLimits(const SuspendQueue::Limits& limits) noexcept {
+    m_suspendQueue.setLimits(limits);
+}
+
+bool AdapterLifecycle::isOpening() const noexcept {
+    return m_opening;
+}
+
+void AdapterLifecycle::openAsync(OpenCallback onDone) {
+    if (m_shutdownComplete) {
+        if (onDone) onDone(false, {});
+        return;
+    }
+    m_opening = true;
+
+    LOG_INFO("Opening CEC adapter in the background");
+    const auto submittedAt = std::chrono::steady_clock::now();
+    m_worker.submit([this, onDone = std::move(onDone), submittedAt]
+                    (ICecAdapter& adapter) mutable {
+        const bool ok = adapter.initialize() && adapter.openConnection();
+        FlightRecorder::getInstance().milestone(Milestone::AdapterOpen, ok);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - submittedAt);
+        if (ok) {
+            LOG_INFO("CEC adapter opened after ", elapsed.count(), "ms");
+        } else {
+            LOG_ERROR("Failed to open CEC adapter after ", elapsed.count(), "ms");
+        }
+        const bool adapterValid = ok && adapter.isConnected();
+        m_work.post([this, onDone = std::move(onDone), adapterValid]() mutable {
+            m_opening     = false;
+            m_heldExpired = false;
+            auto held = std::exchange(m_held, {});
+            if (onDone) onDone(adapterValid, std::move(held));
+        });
+    }, WorkPriority::Lifecycle);
+}
+
+void AdapterLifecycle::noteActivity() {
+    if (m_idleClose.count() <= 0) return;
+    m_lastActivity = std::chrono::steady_clock::now();
+    // The timer runs one idle period at a time and re-arms itself for
+    // whatever is left, so a busy stream of commands costs no syscalls.
+    if (!m_idleTimerArmed) {
+        m_idleTimerArmed = m_idleTimer.armOnce(m_idleClose);
+    }
+}
+
+void AdapterLifecycle::onIdleTimerFired() {
+    if (m_idleTimer.consume() == 0) return;
+    m_idleTimerArmed = false;
+    if (m_shutdownComplete || m_idleClosed) return;
+    if (m_suspendQueue.isSuspended() || m_opening) {
+        // The resume or open brings the adapter back and notes it.
+        return;
+    }
+
+    const auto idle = std::chrono::steady_clock::now() - m_lastActivity;
+    if (idle < m_idleClose) {
+        const auto rest = std::chrono::duration_cast<std::chrono::milliseconds>(
+            m_idleClose - idle);
+        m_idleTimerArmed = m_idleTimer.armOnce(std::max(rest, std::chrono::milliseconds(1)));
+        return;
+    }
+
+    LOG_INFO("No adapter command for ", m_idleClose.count(),
+             "ms; closing CEC adapter until the next one");
+    m_idleClosed = true;
+    m_worker.submit([](ICecAdapter& adapter) {
+        adapter.closeConnection();
+        FlightRecorder::getInstance().milestone(Milestone::AdapterIdleClose);
+    }, WorkPriority::Lifecycle);
+}
+
+void AdapterLifecycle::reopenIdleAsync(OpenCallback onDone) {
+    if (m_shutdownComplete || !m_idleClosed) return;
+    m_idleClosed = false;
+    m_opening    = true;
+
+    LOG_INFO("Reopening idle CEC adapter");
+    const auto submittedAt = std::chrono::steady_clock::now();
+    m_worker.submit([this, onDone = std::move(onDone), submittedAt]
+                    (ICecAdapter& adapter) mutable {
+        const bool ok = adapter.reopenConnection();
+        FlightRecorder::getInstance().milestone(Milestone::AdapterIdleReopen, ok);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - submittedAt);
+        if (ok) {
+            LOG_INFO("CEC adapter reopened after ", elapsed.count(), "ms");
+        } else {
+            LOG_ERROR("Failed to reopen idle CEC adapter after ", elapsed.count(), "ms");
+        }
+        const bool adapterValid = ok && adapter.isConnected();
+        m_work.post([this, onDone = std::move(onDone), adapterValid]() mutable {
+            m_opening     = false;
+            m_heldExpired = false;
+            // Still closed after a failure: let the next command retry.
+            m_idleClosed  = !adapterValid;
+            noteActivity();
+            auto held = std::exchange(m_held, {});
+            if (onDone) onDone(adapterValid, std::move(held));
+        });
+    }, WorkPriority::Lifecycle);
+}
+
+void AdapterLifecycle::hold(Message command, ResponseSink reply) {
+    if (m_heldExpired) {
+        reply(Message(MessageType::RESP_NOT_READY));
+        return;
+    }
+    m_held.push_back({std::move(command), std::move(reply)});
+}
+
+void AdapterLifecycle::expireHeld() {
+    if (!m_opening || m_heldExpired) return;
+    m_heldExpired = true;
+    auto held = std::exchange(m_held, {});
+    LOG_WARNING("CEC adapter still opening; answering ", held.size(),
+                " held command(s) not ready");
+    for (auto& entry : held) {
+        entry.reply(Message(MessageType::RESP_NOT_READY));
+    }
 }
 
-void AdapterLifecycle::suspendAsync(
-        std::function<void(std::chrono::milliseconds)> onDone) {
+void AdapterLifecycle::suspendAsync(std::chrono::milliseconds budget,
+                                    SuspendCallback onDone) {
     // Main-thread phase-1: flip the flag so dispatches arriving during
     // the worker-side close enter the dispatcher's suspended-inline path.
     if (m_shutdownComplete) {
         LOG_DEBUG("suspend() called after shutdown; ignoring");
-        if (onDone) onDone(std::chrono::milliseconds(0));
+        if (onDone) onDone(std::chrono::milliseconds(0), {});
         return;
     }
     if (m_suspendQueue.isSuspended()) {
         LOG_DEBUG("suspend() called while already suspended");
-        if (onDone) onDone(std::chrono::milliseconds(0));
+        if (onDone) onDone(std::chrono::milliseconds(0), {});
         return;
     }
     m_suspendQueue.enterSuspended();
+    // Closing twice is harmless, and the resume reopens either way.
+    m_idleClosed = false;
+    m_sleepReady = false;
+    m_prewarmed  = false;
 
     LOG_INFO("Preparing CEC adapter for system sleep");
     const auto submittedAt = std::chrono::steady_clock::now();
-    m_worker.submit([this, onDone = std::move(onDone),
-                     submittedAt](ICecAdapter& adapter) mutable {
+    // Anchored here, not on the worker: time spent behind an in-flight
+    // command comes out of the same budget.
+    const Deadline deadline = Deadline::in(budget);
+    m_worker.submit([this, onDone = std::move(onDone), submittedAt,
+                     deadline](ICecAdapter& adapter) mutable {
+        PowerFanoutReport report;
         if (adapter.isConnected()) {
-            try {
-                (void)adapter.standbyDevices(CEC::CECDEVICE_BROADCAST);
-            } catch (const std::exception& e) {
-                LOG_ERROR("Exception sending standby commands: ", e.what());
-            }
+            report = standbyFanout(adapter, m_fanout.powerOffDevices, deadline);
         }
         adapter.closeConnection();
         LOG_INFO("CEC adapter closed for suspend");
+        FlightRecorder::getInstance().milestone(Milestone::Suspend);
 
         const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::steady_clock::now() - submittedAt);
-        m_work.post([onDone = std::move(onDone), elapsed]() mutable {
-            if (onDone) onDone(elapsed);
+        m_work.post([this, onDone = std::move(onDone), elapsed,
+                     report = std::move(report)]() mutable {
+            m_sleepReady = true;
+            if (onDone) onDone(elapsed, std::move(report));
         });
-    });
+    }, WorkPriority::Lifecycle);
 }
 
 void AdapterLifecycle::resumeAsync(ResumeCallback onDone) {
     if (m_shutdownComplete) {
         LOG_DEBUG("resume() called after shutdown; ignoring");
-        if (onDone) onDone(false, {});
+        if (onDone) onDone(false, {}, {});
+        return;
+    }
+    if (m_prewarmed) {
+        // prewarmAsync already reopened the adapter, woke the devices
+        // and replayed the queue; only the caller's FSM is left.
+        m_prewarmed  = false;
+        m_sleepReady = false;
+        LOG_INFO("CEC adapter already reopened on wake");
+        if (onDone) onDone(m_worker.isAdapterConnected(), {}, {});
         return;
     }
     if (!m_suspendQueue.isSuspended()) {
         LOG_DEBUG("resume() called while not suspended");
-        if (onDone) onDone(false, {});
+        if (onDone) onDone(false, {}, {});
         return;
     }
 
     LOG_INFO("Reinitializing CEC adapter after resume");
     m_worker.submit([this, onDone = std::move(onDone)]
                     (ICecAdapter& adapter) mutable {
-        const bool reconnected = adapter.reopenConnection();
-        if (reconnected) {
+        PowerFanoutReport report;
+        if (adapter.isConnected()) {
+            // An early reopen queued ahead of this job got there first.
+            LOG_INFO("CEC adapter already reopened on wake");
+        } else if (adapter.reopenConnection()) {
             LOG_INFO("CEC adapter reconnected successfully on resume");
-            try {
-                (void)adapter.powerOnDevices(CEC::CECDEVICE_BROADCAST);
-            } catch (const std::exception& e) {
-                LOG_ERROR("Exception sending power-on commands: ", e.what());
-            }
+            report = powerOnFanout(adapter, m_fanout.wakeDevices,
+                                   Deadline::in(kResumeFanoutBudget));
         } else {
             LOG_ERROR("Failed to reconnect CEC adapter on resume");
         }
-        // Re-read the connection hint after powerOnDevices; the
+        // Re-read the connection hint after the wake pass; the
         // lifecycle FSM uses this to decide whether to arm the
         // post-resume retry timer, so prefer the adapter's own
-        // up-to-date view over @c reconnected.
+        // up-to-date view over the reopen result.
         const bool adapterValid = adapter.isConnected();
-        m_work.post([this, onDone = std::move(onDone),
-                     adapterValid]() mutable {
-            onResumeWorkerComplete(adapterValid, std::move(onDone));
+        FlightRecorder::getInstance().milestone(Milestone::Resume, adapterValid);
+        m_work.post([this, onDone = std::move(onDone), adapterValid,
+                     report = std::move(report)]() mutable {
+            onResumeWorkerComplete(adapterValid, std::move(report), std::move(onDone));
         });
-    });
+    }, WorkPriority::Lifecycle);
 }
 
 void AdapterLifecycle::reconnectAsync(std::function<void(bool)> onDone) {
@@ -130,6 +288,12 @@ void AdapterLifecycle::reconnectAsync(std::function<void(bool)> onDone) {
         if (onDone) onDone(false);
         return;
     }
+    if (m_idleClosed) {
+        // Closed on purpose too; the next command reopens it.
+        LOG_DEBUG("reconnect() called while idle-closed; ignoring");
+        if (onDone) onDone(true);
+        return;
+    }
     if (m_worker.isAdapterConnected()) {
         LOG_DEBUG("reconnect(): adapter already connected");
         if (onDone) onDone(true);
@@ -140,6 +304,7 @@ void AdapterLifecycle::reconnectAsync(std::function<void(bool)> onDone) {
     m_worker.submit([this, onDone = std::move(onDone)]
                     (ICecAdapter& adapter) mutable {
         const bool ok = adapter.reopenConnection();
+        FlightRecorder::getInstance().milestone(Milestone::AdapterReconnect, ok);
         if (ok) {
             LOG_INFO("CEC adapter reconnected successfully");
         } else {
@@ -148,17 +313,91 @@ void AdapterLifecycle::reconnectAsync(std::function<void(bool)> onDone) {
         m_work.post([onDone = std::move(onDone), ok]() mutable {
             if (onDone) onDone(ok);
         });
-    });
+    }, WorkPriority::Lifecycle);
+}
+
+void AdapterLifecycle::reconfigureAsync(AdapterConfig adapter, PowerFanoutConfig fanout,
+                                        bool reopen, std::function<void(bool)> onDone) {
+    if (m_shutdownComplete) {
+        if (onDone) onDone(false);
+        return;
+    }
+    // Suspended or idle-closed, the adapter is closed on purpose and
+    // its next reopen uses whatever configuration it then holds.
+    reopen = reopen && !m_suspendQueue.isSuspended() && !m_idleClosed;
+    // The configuration is boxed to keep the job within the worker's
+    // inline capacity; a reload is rare enough that one allocation is
+    // of no consequence.
+    struct Reload {
+        AdapterConfig     adapter;
+        PowerFanoutConfig fanout;
+    };
+    m_worker.submit([this, reload = std::make_unique<Reload>(Reload{std::move(adapter), fanout}),
+                     reopen, onDone = std::move(onDone)](ICecAdapter& cec) mutable {
+        m_fanout = reload->fanout;
+        cec.reconfigure(std::move(reload->adapter));
+        bool ok = true;
+        if (reopen) {
+            LOG_INFO("Adapter configuration changed; reopening CEC adapter");
+            ok = cec.reopenConnection();
+            FlightRecorder::getInstance().milestone(Milestone::AdapterReconfigure, ok);
+            if (!ok) {
+                LOG_ERROR("Failed to reopen CEC adapter with the reloaded configuration");
+            }
+        }
+        m_work.post([onDone = std::move(onDone), ok]() mutable {
+            if (onDone) onDone(ok);
+        });
+    }, WorkPriority::Lifecycle);
+}
+
+void AdapterLifecycle::prewarmAsync(ResumeCallback onDone) {
+    if (m_shutdownComplete || !m_suspendQueue.isSuspended() || !m_sleepReady ||
+        m_prewarmPending || m_prewarmed) {
+        return;
+    }
+    m_prewarmPending = true;
+
+    m_worker.submit([this, onDone = std::move(onDone)]
+                    (ICecAdapter& adapter) mutable {
+        PowerFanoutReport report;
+        const bool reconnected = adapter.reopenConnection();
+        if (reconnected) {
+            report = powerOnFanout(adapter, m_fanout.wakeDevices,
+                                   Deadline::in(kResumeFanoutBudget));
+        }
+        const bool adapterValid = adapter.isConnected();
+        FlightRecorder::getInstance().milestone(Milestone::Resume, adapterValid);
+        m_work.post([this, onDone = std::move(onDone), adapterValid,
+                     report = std::move(report)]() mutable {
+            m_prewarmPending = false;
+            if (!adapterValid || !m_suspendQueue.isSuspended()) {
+                if (onDone) onDone(false, {}, {});
+                return;
+            }
+            std::vector<Message> drained = m_suspendQueue.drain();
+            m_suspendQueue.exitSuspended();
+            m_prewarmed = true;
+            noteActivity();
+            LOG_INFO("CEC adapter reopened on wake");
+            if (onDone) onDone(true, std::move(drained), std::move(report));
+        });
+    }, WorkPriority::Lifecycle);
 }
 
 void AdapterLifecycle::onResumeWorkerComplete(bool adapterValid,
+                                              PowerFanoutReport report,
                                               ResumeCallback onDone) {
+    m_prewarmed  = false;
+    m_sleepReady = false;
+
     // Drain before flipping: any dispatch arriving on a later loop
     // iteration (after exitSuspended) is free to fall through to the
     // worker queue, racing the eventual replays only at adapter-call
     // granularity — the exact property the pre-refactor code had.
     std::vector<Message> drained = m_suspendQueue.drain();
     m_suspendQueue.exitSuspended();
+    noteActivity();
 
     if (!adapterValid) {
         // Queued commands were accepted with RESP_SUCCESS ("accepted
@@ -169,11 +408,11 @@ void AdapterLifecycle::onResumeWorkerComplete(bool adapterValid,
             LOG_WARNING("Discarding ", drained.size(),
                         " queued commands: reconnect failed");
         }
-        if (onDone) onDone(false, {});
+        if (onDone) onDone(false, {}, std::move(report));
         return;
     }
 
-    if (onDone) onDone(true, std::move(drained));
+    if (onDone) onDone(true, std::move(drained), std::move(report));
 }
 
 } // namespace cec_control
@@ -5,12 +5,15 @@
 #include <vector>
 
 #include "../common/messages.h"
+#include "cec/adapter_config.h"
+#include "power/power_fanout.h"
 #include "power/suspend_queue.h"
 
 namespace cec_control {
 
 class AdapterWorker;
 class MainThreadWork;
+class LoopTimer;
 
 /**
  * @class AdapterLifecycle
@@ -38,6 +41,15 @@ class MainThreadWork;
  * outbound reference from the lifecycle to the dispatcher; the
  * orchestrator is the bridge.
  *
+ * ## Idle close
+ *
+ * With an idle period configured, the adapter is closed once no
+ * adapter command has been dispatched for that long (@c noteActivity
+ * records each one) and reopened for the next one through
+ * @c reopenIdleAsync, which holds commands like a deferred open.
+ * Suspend takes over a closed adapter as it is, and the resume
+ * reopens it; a reconnect attempt leaves it closed.
+ *
  * ## Shutdown
  *
  * The shutdown gate is purely defensive: by the time
@@ -49,18 +61,51 @@ class MainThreadWork;
  */
 class AdapterLifecycle {
 public:
+    /**
+     * Suspend completion callback. Fires on the main thread with the
+     * elapsed worker-side duration and the per-device standby outcome.
+     */
+    using SuspendCallback =
+        std::function<void(std::chrono::milliseconds elapsed, PowerFanoutReport report)>;
+
     /**
      * Resume completion callback. Fires on the main thread with
-     * @p adapterValid (the post-reopen connection hint) and the
-     * commands drained from the suspend queue. On adapter failure the
-     * lifecycle discards the drained vector internally (logging the
-     * count) and passes back an empty vector — callers never see
-     * commands the adapter cannot deliver on.
+     * @p adapterValid (the post-reopen connection hint), the commands
+     * drained from the suspend queue and the per-device wake outcome.
+     * On adapter failure the lifecycle discards the drained vector
+     * internally (logging the count) and passes back an empty vector —
+     * callers never see commands the adapter cannot deliver on.
      */
     using ResumeCallback =
-        std::function<void(bool adapterValid, std::vector<Message> queued)>;
+        std::function<void(bool adapterValid, std::vector<Message> queued,
+                           PowerFanoutReport report)>;
 
-    AdapterLifecycle(AdapterWorker& worker, MainThreadWork& work) noexcept;
+    /** A command held while the deferred open runs, with its reply. */
+    struct HeldCommand {
+        Message      command;
+        ResponseSink reply;
+    };
+
+    /**
+     * Deferred-open completion callback. Fires on the main thread with
+     * whether the adapter opened and the commands held meanwhile, in
+     * arrival order, still unanswered.
+     */
+    using OpenCallback =
+        std::function<void(bool adapterValid, std::vector<HeldCommand> held)>;
+
+    /** Budget for the wake pass after the adapter has reopened. */
+    static constexpr auto kResumeFanoutBudget = std::chrono::seconds(5);
+
+    /**
+     * @param idleTimer  Non-owning; the daemon installs its handler,
+     *                   which calls @c onIdleTimerFired when it fires.
+     * @param idleClose  Idle period before the adapter is closed;
+     *                   zero keeps it open.
+     */
+    AdapterLifecycle(AdapterWorker& worker, MainThreadWork& work,
+                     PowerFanoutConfig fanout, LoopTimer& idleTimer,
+                     std::chrono::milliseconds idleClose) noexcept;
 
     ~AdapterLifecycle() = default;
 
@@ -81,26 +126,83 @@ public:
     /** @c true iff currently between @c suspendAsync and the matching resume. */
     [[nodiscard]] bool isSuspended() const noexcept;
 
+    /** @c true between @c openAsync or @c reopenIdleAsync and its completion. */
+    [[nodiscard]] bool isOpening() const noexcept;
+
+    /** @c true while the adapter is closed for being idle. */
+    [[nodiscard]] bool isIdleClosed() const noexcept { return m_idleClosed; }
+
+    /**
+     * An adapter command was dispatched: restart the idle period, and
+     * arm the idle timer if it is not running. No-op with idle close
+     * off. Main thread only.
+     */
+    void noteActivity();
+
+    /** Idle timer handler: close the adapter if the idle period has passed. */
+    void onIdleTimerFired();
+
+    /**
+     * Reopen an idle-closed adapter on the worker. Until @p onDone
+     * fires, @c isOpening is true and the dispatcher parks adapter
+     * commands through @c hold; @p onDone receives them like an
+     * @c openAsync completion. No-op unless @c isIdleClosed. Main
+     * thread only.
+     */
+    void reopenIdleAsync(OpenCallback onDone);
+
+    /**
+     * Initialise and open the adapter on the worker, for a daemon that
+     * starts serving before its adapter is up. Main thread only; call
+     * once, before any other adapter work is submitted so the open runs
+     * first. Until @p onDone fires, the dispatcher parks adapter
+     * commands here through @c hold.
+     */
+    void openAsync(OpenCallback onDone);
+
+    /**
+     * Park @p command until the deferred open completes, or answer it
+     * @c RESP_NOT_READY at once if @c expireHeld has already run.
+     * Main thread only; only meaningful while @c isOpening.
+     */
+    void hold(Message command, ResponseSink reply);
+
+    /**
+     * The deferred open has outlasted its deadline: answer every held
+     * command @c RESP_NOT_READY, and every later @c hold likewise until
+     * the open completes. Main thread only.
+     */
+    void expireHeld();
+
     /**
      * Append @p cmd to the suspend queue iff currently suspended;
      * otherwise no-op. Mirrors @c SuspendQueue::push semantics — safe
      * to call without a prior @c isSuspended check, and the dispatcher
      * relies on this for the suspended-inline path. Main thread only.
+     *
+     * @return @c false when the queue is at its capacity and @p cmd
+     *         was not kept.
      */
-    void enqueue(const Message& cmd);
+    [[nodiscard]] bool enqueue(const Message& cmd);
+
+    /** Bound the suspend queue; see @c SuspendQueue::Limits. Main thread only. */
+    void setSuspendQueueLimits(const SuspendQueue::Limits& limits) noexcept;
 
     /**
      * Enter the suspended state and run pre-sleep CEC actions on the
-     * worker. Main thread only. @p onDone fires on the main thread
-     * with the elapsed worker-side duration; on a shutdown or
+     * worker: standby to @c PowerOffDevices, cut off after @p budget
+     * from this call, then close the adapter. Main thread only.
+     * @p onDone fires on the main thread; on a shutdown or
      * already-suspended state the callback still fires (with a zero
-     * duration) so the caller's lifecycle FSM keeps progressing.
+     * duration and an empty report) so the caller's lifecycle FSM
+     * keeps progressing.
      */
-    void suspendAsync(std::function<void(std::chrono::milliseconds)> onDone);
+    void suspendAsync(std::chrono::milliseconds budget, SuspendCallback onDone);
 
     /**
-     * Reopen the adapter on the worker. After the reopen completes,
-     * drain the suspend queue, exit the suspended state, and invoke
+     * Reopen the adapter on the worker and wake @c WakeDevices within
+     * @c kResumeFanoutBudget. After that completes, drain the suspend
+     * queue, exit the suspended state, and invoke
      * @p onDone on the main thread with @c (adapterValid, queued).
      * On adapter failure the drained commands are discarded internally
      * with a warning log; @p onDone still fires (with an empty
@@ -108,6 +210,21 @@ public:
      */
     void resumeAsync(ResumeCallback onDone);
 
+    /**
+     * Do the resume's adapter work ahead of the resume request: reopen
+     * the adapter and wake @c WakeDevices as soon as the system is
+     * known to be awake. Main thread only; a no-op unless suspended
+     * with the pre-sleep work finished and no early reopen yet.
+     *
+     * On success the suspend queue is drained and handed to @p onDone,
+     * the suspended state ends so new commands go straight to the
+     * worker, and the following @c resumeAsync completes at once. On
+     * failure nothing changes and @c resumeAsync reopens as usual. A
+     * @c resumeAsync issued while the early reopen is in flight runs
+     * after it on the worker and finds the adapter already open.
+     */
+    void prewarmAsync(ResumeCallback onDone);
+
     /**
      * Reopen the adapter on the worker iff not shutdown and not
      * suspended. Main thread only. @p onDone fires on the main thread
@@ -116,23 +233,57 @@ public:
      */
     void reconnectAsync(std::function<void(bool)> onDone);
 
+    /**
+     * Hand a reloaded @p adapter config and @p fanout to the worker.
+     * The fanout applies from the next suspend or resume. With
+     * @p reopen set and the adapter not suspended, the connection is
+     * then reopened so libcec picks up the new values; while suspended
+     * the resume's reopen does that instead. Main thread only.
+     * @p onDone fires on the main thread with the reopen outcome, or
+     * @c true when no reopen ran.
+     */
+    void reconfigureAsync(AdapterConfig adapter, PowerFanoutConfig fanout,
+                          bool reopen, std::function<void(bool)> onDone);
+
 private:
     /**
      * Main-thread continuation fired after the resume worker finishes
-     * @c reopenConnection + @c powerOnDevices. Drains the suspend
+     * @c reopenConnection + @c powerOnFanout. Drains the suspend
      * queue, exits the suspended state, and either discards the drain
      * (adapter invalid) or hands it back to the caller via @p onDone.
      */
-    void onResumeWorkerComplete(bool adapterValid, ResumeCallback onDone);
+    void onResumeWorkerComplete(bool adapterValid, PowerFanoutReport report,
+                                ResumeCallback onDone);
 
     AdapterWorker&  m_worker;
     MainThreadWork& m_work;
+    LoopTimer&      m_idleTimer;
+
+    // Read on the worker by the suspend / resume jobs; replaced only
+    // by a reconfigureAsync job, also on the worker.
+    PowerFanoutConfig m_fanout;
 
     // Suspend flag + queued commands. Main-thread only.
     SuspendQueue m_suspendQueue;
 
     // Shutdown gate. Main-thread only — see the class-level doc comment.
     bool m_shutdownComplete = false;
+
+    // Early-reopen state for prewarmAsync. Main-thread only.
+    bool m_sleepReady      = false;  ///< Pre-sleep work done; adapter closed.
+    bool m_prewarmPending  = false;  ///< Early reopen submitted, not completed.
+    bool m_prewarmed       = false;  ///< Early reopen done; resume is a formality.
+
+    // Deferred-open state. Main-thread only.
+    bool                     m_opening     = false;
+    bool                     m_heldExpired = false;
+    std::vector<HeldCommand> m_held;
+
+    // Idle-close state. Main-thread only.
+    const std::chrono::milliseconds       m_idleClose;
+    std::chrono::steady_clock::time_point m_lastActivity;
+    bool m_idleTimerArmed = false;
+    bool m_idleClosed     = false;
 };
 
 } // namespace cec_control
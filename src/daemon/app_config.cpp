@@ -1,76 +1,672 @@
 #include "app_config.h"
 
+#include "config_schema.h"
 #include "../common/config_manager.h"
 #include "../common/logger.h"
+#include "../common/messages.h"
+#include "../common/static_index.h"
 
 #include <libcec/cec.h>
 
 #include <unistd.h>
 #include <algorithm>
 #include <array>
+#include <bitset>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
-#include <sstream>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace cec_control {
 
 namespace {
 
+using config_schema::Key;
+using config_schema::Reload;
+
+/** Call @p each with every comma-separated item of @p list, trimmed; blank items are skipped. */
+template <typename Each>
+void forEachItem(std::string_view list, Each each) {
+    while (!list.empty()) {
+        const std::size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+        const std::size_t first = item.find_first_not_of(" \t");
+        if (first == std::string_view::npos) continue;
+        item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+        each(item);
+    }
+}
+
+/** @p token as a whole integer in @p base (0 = C prefixes), or nullopt. */
+std::optional<long> toInteger(std::string_view token, int base) noexcept {
+    char buffer[24];
+    if (token.empty() || token.size() >= sizeof(buffer)) return std::nullopt;
+    std::copy(token.begin(), token.end(), buffer);
+    buffer[token.size()] = '\0';
+    char* end = nullptr;
+    errno = 0;
+    const long value = std::strtol(buffer, &end, base);
+    if (end != buffer + token.size() || errno == ERANGE) return std::nullopt;
+    return value;
+}
+
 /**
  * Validate a single hook-path string: non-empty, absolute, executable.
- * Returns the path unchanged if accepted; returns empty if the path
+ * Stores the path unchanged if accepted; stores empty if the path
  * was non-empty but failed a hard gate (relative). A non-executable
  * absolute path is tolerated with a warning — the user may @c chmod+x
  * without restarting, and @c posix_spawn will surface any residual
  * failure at fire time.
  */
-std::string validateHookPath(std::string path, std::string_view eventName) {
-    if (path.empty()) return path;
-    if (path.front() != '/') {
-        LOG_WARNING("Hook path for ", eventName,
-                    " must be absolute; disabling: ", path);
-        return std::string{};
-    }
-    if (::access(path.c_str(), X_OK) != 0) {
-        LOG_WARNING("Hook path for ", eventName,
+void parseHookPath(std::string_view value, std::string& out, const Key& key) {
+    out.assign(value.data(), value.size());
+    if (out.empty()) return;
+    if (out.front() != '/') {
+        LOG_WARNING("Hook path for ", key.name, " must be absolute; disabling: ", out);
+        out.clear();
+        return;
+    }
+    if (::access(out.c_str(), X_OK) != 0) {
+        LOG_WARNING("Hook path for ", key.name,
                     " not executable at startup; will retry at spawn time: ",
-                    std::strerror(errno), " (path=", path, ")");
+                    std::strerror(errno), " (path=", out, ")");
+    }
+}
+
+/**
+ * A comma-separated list of CEC logical addresses (e.g. "0,1,5") as a
+ * @c cec_logical_addresses bitmask. Out-of-range or non-numeric
+ * entries are logged and skipped; an empty value clears the mask.
+ */
+void parseAddresses(std::string_view value, CEC::cec_logical_addresses& out, const Key& key) {
+    out.Clear();
+    forEachItem(value, [&](std::string_view item) {
+        const auto id = toInteger(item, 10);
+        if (!id) {
+            LOG_WARNING("Invalid logical address in config field ", key.name, ": ", item);
+        } else if (*id < 0 || *id > 15) {
+            LOG_WARNING("Logical address out of range in config field ", key.name, ": ", *id);
+        } else {
+            out.Set(static_cast<CEC::cec_logical_address>(*id));
+        }
+    });
+}
+
+/** cec_logical_addresses has no equality in every libcec release. */
+bool sameAddresses(const CEC::cec_logical_addresses& a,
+                   const CEC::cec_logical_addresses& b) noexcept {
+    for (uint8_t address = 0; address < 16; ++address) {
+        const auto logical = static_cast<CEC::cec_logical_address>(address);
+        if (a.IsSet(logical) != b.IsSet(logical)) return false;
+    }
+    return true;
+}
+
+bool sameAddressFields(const void* a, const void* b) noexcept {
+    return sameAddresses(*static_cast<const CEC::cec_logical_addresses*>(a),
+                         *static_cast<const CEC::cec_logical_addresses*>(b));
+}
+
+/**
+ * A comma-separated opcode list such as "0x8C, 0x89"; decimal, hex and
+ * octal are all accepted. Out-of-range or malformed entries are logged
+ * and skipped.
+ */
+void parseOpcodes(std::string_view value, std::bitset<256>& out, const Key& key) {
+    out.reset();
+    forEachItem(value, [&](std::string_view item) {
+        const auto opcode = toInteger(item, 0);
+        if (!opcode) {
+            LOG_WARNING("Invalid opcode in config field ", key.name, ": ", item);
+        } else if (*opcode < 0 || *opcode > 0xFF) {
+            LOG_WARNING("Opcode out of range in config field ", key.name, ": ", *opcode);
+        } else {
+            out.set(static_cast<std::size_t>(*opcode));
+        }
+    });
+}
+
+/**
+ * A CPU list as written in the config file: comma-separated CPU
+ * numbers or inclusive ranges, e.g. "2,3" or "4-7". Bad entries are
+ * logged and skipped; the result is sorted without duplicates.
+ */
+void parseCpus(std::string_view value, std::vector<int>& out, const Key& key) {
+    std::bitset<CPU_SETSIZE> cpus;
+    forEachItem(value, [&](std::string_view item) {
+        const std::size_t dash = item.find('-', 1);
+        auto first = toInteger(item.substr(0, dash), 10);
+        auto last  = dash == std::string_view::npos ? first
+                                                    : toInteger(item.substr(dash + 1), 10);
+        if (!first || !last) {
+            LOG_WARNING("Invalid CPU in config field ", key.name, ": ", item);
+            return;
+        }
+        if (*first < 0 || *last < *first || *last >= CPU_SETSIZE) {
+            LOG_WARNING("CPU out of range in config field ", key.name, ": ", item);
+            return;
+        }
+        for (long cpu = *first; cpu <= *last; ++cpu) cpus.set(static_cast<std::size_t>(cpu));
+    });
+    out.clear();
+    for (std::size_t cpu = 0; cpu < cpus.size(); ++cpu) {
+        if (cpus.test(cpu)) out.push_back(static_cast<int>(cpu));
+    }
+}
+
+/** Config-file spellings of the scheduling policies. */
+constexpr std::array<std::pair<std::string_view, ThreadSchedule::Policy>, 4> kPolicies{{
+    {"inherit", ThreadSchedule::Policy::Inherit},
+    {"normal",  ThreadSchedule::Policy::Normal},
+    {"fifo",    ThreadSchedule::Policy::Fifo},
+    {"rr",      ThreadSchedule::Policy::RoundRobin},
+}};
+
+std::string_view policyName(ThreadSchedule::Policy policy) noexcept {
+    for (const auto& [name, value] : kPolicies) {
+        if (value == policy) return name;
+    }
+    return "inherit";
+}
+
+void parsePolicy(std::string_view value, ThreadSchedule::Policy& out, const Key& key) {
+    for (const auto& [name, policy] : kPolicies) {
+        if (value == name) {
+            out = policy;
+            return;
+        }
+    }
+    LOG_WARNING("Unknown scheduling policy in config field ", key.name, ": ", value,
+                " (using inherit)");
+    out = ThreadSchedule::Policy::Inherit;
+}
+
+/** "Configuration: Scheduling.<prefix>* = ..." lines for a non-default schedule. */
+void logThreadSchedule(const ThreadSchedule& schedule, std::string_view prefix) {
+    if (schedule.stackKiB != 0) {
+        LOG_INFO("Configuration: Scheduling.", prefix, "StackKiB = ", schedule.stackKiB);
+    }
+    if (schedule.isDefault()) return;
+    std::string cpus;
+    for (const int cpu : schedule.cpus) {
+        if (!cpus.empty()) cpus += ',';
+        cpus += std::to_string(cpu);
+    }
+    LOG_INFO("Configuration: Scheduling.", prefix, "Cpus = ", cpus.empty() ? "(all)" : cpus,
+             ", ", prefix, "Nice = ", schedule.nice,
+             ", ", prefix, "Policy = ", policyName(schedule.policy),
+             ", ", prefix, "Priority = ", schedule.priority);
+}
+
+/** Priority only means something under a realtime policy, where it is at least 1. */
+void settlePriority(ThreadSchedule& schedule) noexcept {
+    const bool realtime = schedule.policy == ThreadSchedule::Policy::Fifo ||
+                          schedule.policy == ThreadSchedule::Policy::RoundRobin;
+    if (!realtime) {
+        schedule.priority = 0;
+    } else if (schedule.priority == 0) {
+        schedule.priority = 1;
+    }
+}
+
+/**
+ * Fill in the low-memory stack where none is set, and raise one set
+ * below @c kMinThreadStackKiB to it.
+ */
+void settleStack(ThreadSchedule& schedule, bool lowMemory) noexcept {
+    if (schedule.stackKiB == 0) {
+        if (lowMemory) schedule.stackKiB = kLowMemoryStackKiB;
+    } else if (schedule.stackKiB < kMinThreadStackKiB) {
+        schedule.stackKiB = kMinThreadStackKiB;
+    }
+}
+
+/** A debounce edge; empty leaves the default. */
+void parseEdge(std::string_view value, HookDebounce::Edge& out, const Key& key) {
+    if (value == "leading") {
+        out = HookDebounce::Edge::Leading;
+    } else if (value == "trailing") {
+        out = HookDebounce::Edge::Trailing;
+    } else if (!value.empty()) {
+        LOG_WARNING("Unknown debounce edge in config field ", key.name, ": ", value,
+                    " (using trailing)");
+        out = HookDebounce::Edge::Trailing;
+    }
+}
+
+/** "Configuration: Hooks.<prefix>* = ..." line for one hook's debounce. */
+void logHookDebounce(const HookDebounce& debounce, std::string_view prefix) {
+    LOG_INFO("Configuration: Hooks.", prefix, "DebounceMs = ", debounce.windowMs,
+             ", ", prefix, "DebounceEdge = ",
+             (debounce.edge == HookDebounce::Edge::Leading ? "leading" : "trailing"),
+             ", ", prefix, "MaxWaitMs = ", debounce.maxWaitMs);
+}
+
+/**
+ * A level name as written in the config file ("debug", "info", ...).
+ * Empty means "not set"; an unknown name is logged and likewise
+ * treated as unset.
+ */
+void parseLevel(std::string_view value, std::optional<LogLevel>& out, const Key& key) {
+    static constexpr std::array<std::pair<std::string_view, LogLevel>, 6> kLevels{{
+        {"debug",   LogLevel::DEBUG},
+        {"traffic", LogLevel::TRAFFIC},
+        {"info",    LogLevel::INFO},
+        {"warning", LogLevel::WARNING},
+        {"error",   LogLevel::ERROR},
+        {"fatal",   LogLevel::FATAL},
+    }};
+    out.reset();
+    if (value.empty()) return;
+    for (const auto& [name, level] : kLevels) {
+        if (value == name) {
+            out = level;
+            return;
+        }
+    }
+    LOG_WARNING("Unknown log level for [Logging] ", key.name, ": ", value, " (ignored)");
+}
+
+/** Config-file spelling of a log level, for logAppConfig. */
+std::string_view logLevelName(LogLevel level) noexcept {
+    switch (level) {
+        case LogLevel::DEBUG:   return "debug";
+        case LogLevel::TRAFFIC: return "traffic";
+        case LogLevel::INFO:    return "info";
+        case LogLevel::WARNING: return "warning";
+        case LogLevel::ERROR:   return "error";
+        case LogLevel::FATAL:   return "fatal";
+    }
+    return "info";
+}
+
+// [Logging] keys for the per-subsystem levels, indexed by LogSubsystem.
+// None has no key: untagged lines always follow the command line.
+constexpr std::array<std::string_view, kLogSubsystemCount> kSubsystemLevelKeys{
+    "", "DaemonLevel", "AdapterLevel", "LibcecLevel",
+};
+
+template <LogSubsystem Subsystem>
+void* subsystemLevel(AppConfig& config) noexcept {
+    return &config.logging.subsystemLevels[static_cast<std::size_t>(Subsystem)];
+}
+
+template <LogSubsystem Subsystem>
+const void* constSubsystemLevel(const AppConfig& config) noexcept {
+    return &config.logging.subsystemLevels[static_cast<std::size_t>(Subsystem)];
+}
+
+void parseOverflow(std::string_view value, LogOverflow& out, const Key&) {
+    if (value == "block") {
+        out = LogOverflow::Block;
+    } else if (value == "drop") {
+        out = LogOverflow::Drop;
+    } else {
+        LOG_WARNING("Unknown value for [Logging] Overflow: ", value, " (using drop)");
+        out = LogOverflow::Drop;
+    }
+}
+
+void parseLatency(std::string_view value, SimulatorConfig::Latency& out, const Key&) {
+    if (value == "fixed") {
+        out = SimulatorConfig::Latency::Fixed;
+    } else if (value == "exponential") {
+        out = SimulatorConfig::Latency::Exponential;
+    } else {
+        if (value != "uniform") {
+            LOG_WARNING("Unknown value for [Simulator] LatencyDistribution: ", value,
+                        " (using uniform)");
+        }
+        out = SimulatorConfig::Latency::Uniform;
+    }
+}
+
+/** Config-file spelling of a latency shape, for logAppConfig. */
+std::string_view latencyName(SimulatorConfig::Latency latency) noexcept {
+    switch (latency) {
+        case SimulatorConfig::Latency::Fixed:       return "fixed";
+        case SimulatorConfig::Latency::Uniform:     return "uniform";
+        case SimulatorConfig::Latency::Exponential: return "exponential";
+    }
+    return "uniform";
+}
+
+/** Zero, or at least kMinAdapterIdleCloseMs. */
+void parseIdleClose(std::string_view value, uint32_t& out, const Key& key) {
+    // A custom row carries no range of its own.
+    Key bounded = key;
+    bounded.max = config_schema::kUnbounded;
+    const auto ms = config_schema::parseNumber(value, bounded);
+    if (!ms) return;
+    if (*ms > 0 && *ms < kMinAdapterIdleCloseMs) {
+        LOG_WARNING("AdapterIdleCloseMs ", *ms, " is below the minimum; using ",
+                    kMinAdapterIdleCloseMs);
+        out = kMinAdapterIdleCloseMs;
+    } else {
+        out = static_cast<uint32_t>(*ms);
+    }
+}
+
+bool sameScenes(const SceneTable& a, const SceneTable& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].name != b[i].name || a[i].steps.size() != b[i].steps.size()) return false;
+        for (std::size_t j = 0; j < a[i].steps.size(); ++j) {
+            const auto& x = a[i].steps[j];
+            const auto& y = b[i].steps[j];
+            if (x.pauseBefore != y.pauseBefore ||
+                x.command.serialize() != y.command.serialize()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+using config_schema::custom;
+using config_schema::customAt;
+using config_schema::flag;
+using config_schema::kUnbounded;
+using config_schema::number;
+using config_schema::text;
+
+using A  = AppConfig;
+using HD = HookDebounce;
+using TS = ThreadSchedule;
+
+// Every key the file may set. Order is the reload report's order and
+// keeps keys that share a report label together. Some keys sit in a
+// section other than their consumer's for compatibility with deployed
+// files: QueueCommandsDuringSuspend and the rest of the dispatcher
+// policy under [Daemon]; PowerOffOnStandby, which StandbyPolicy
+// enforces rather than libcec (see the LibCecAdapter constructor),
+// under [Adapter].
+constexpr std::array kSchema{
+    text  <&A::adapter, &AdapterConfig::deviceName>("Adapter", "DeviceName", Reload::Adapter),
+    text  <&A::adapter, &AdapterConfig::port>("Adapter", "Port", Reload::Adapter),
+    flag  <&A::adapter, &AdapterConfig::autoPowerOn>("Adapter", "AutoPowerOn", Reload::Adapter),
+    flag  <&A::adapter, &AdapterConfig::autoWakeAVR>("Adapter", "AutoWakeAVR", Reload::Adapter),
+    flag  <&A::adapter, &AdapterConfig::activateSource>("Adapter", "ActivateSource",
+                                                        Reload::Adapter),
+    flag  <&A::adapter, &AdapterConfig::systemAudioMode>("Adapter", "SystemAudioMode",
+                                                         Reload::Adapter),
+    custom<parseAddresses, &A::adapter, &AdapterConfig::wakeDevices>(
+        "Adapter", "WakeDevices", Reload::Adapter, {}, sameAddressFields),
+    custom<parseAddresses, &A::adapter, &AdapterConfig::powerOffDevices>(
+        "Adapter", "PowerOffDevices", Reload::Adapter, {}, sameAddressFields),
+    number<&A::adapter, &AdapterConfig::callBudgetMs>(
+        "Adapter", "CallBudgetMs", 0, kUnbounded, Reload::Adapter),
+    flag  <&A::standby, &StandbyConfig::enabled>("Adapter", "PowerOffOnStandby", Reload::Standby),
+
+    // Compared after CECDaemon::reloadConfig carries a --simulate over.
+    flag  <&A::simulator, &SimulatorConfig::enabled>("Simulator", "Enabled", Reload::Restart,
+                                                     "[Simulator]"),
+    custom<parseAddresses, &A::simulator, &SimulatorConfig::devices>(
+        "Simulator", "Devices", Reload::Restart, "[Simulator]", sameAddressFields),
+    number<&A::simulator, &SimulatorConfig::commandLatencyMs>(
+        "Simulator", "CommandLatencyMs", 0, kUnbounded, Reload::Restart, "[Simulator]"),
+    number<&A::simulator, &SimulatorConfig::queryLatencyMs>(
+        "Simulator", "QueryLatencyMs", 0, kUnbounded, Reload::Restart, "[Simulator]"),
+    custom<parseLatency, &A::simulator, &SimulatorConfig::latency>(
+        "Simulator", "LatencyDistribution", Reload::Restart, "[Simulator]"),
+    number<&A::simulator, &SimulatorConfig::nackPercent>(
+        "Simulator", "NackPercent", 0, 100, Reload::Restart, "[Simulator]"),
+    number<&A::simulator, &SimulatorConfig::observationIntervalMs>(
+        "Simulator", "ObservationIntervalMs", 0, kUnbounded, Reload::Restart, "[Simulator]"),
+    number<&A::simulator, &SimulatorConfig::connectionLossIntervalMs>(
+        "Simulator", "ConnectionLossIntervalMs", 0, kUnbounded, Reload::Restart, "[Simulator]"),
+    number<&A::simulator, &SimulatorConfig::seed>(
+        "Simulator", "Seed", 0, kUnbounded, Reload::Restart, "[Simulator]"),
+    text  <&A::simulator, &SimulatorConfig::replayFile>(
+        "Simulator", "ReplayFile", Reload::Restart, "[Simulator]"),
+
+    number<&A::throttler, &ThrottlerConfig::baseIntervalMs>(
+        "Throttler", "BaseIntervalMs", 0, kUnbounded, Reload::Throttler),
+    number<&A::throttler, &ThrottlerConfig::maxIntervalMs>(
+        "Throttler", "MaxIntervalMs", 0, kUnbounded, Reload::Throttler),
+    number<&A::throttler, &ThrottlerConfig::maxRetryAttempts>(
+        "Throttler", "MaxRetryAttempts", 0, kUnbounded, Reload::Throttler),
+    number<&A::throttler, &ThrottlerConfig::busIntervalMs>(
+        "Throttler", "BusIntervalMs", 0, kUnbounded, Reload::Throttler),
+    flag  <&A::throttler, &ThrottlerConfig::adaptive>("Throttler", "Adaptive", Reload::Throttler),
+    number<&A::throttler, &ThrottlerConfig::minIntervalMs>(
+        "Throttler", "MinIntervalMs", 0, kUnbounded, Reload::Throttler),
+    number<&A::throttler, &ThrottlerConfig::breakerThreshold>(
+        "Throttler", "BreakerThreshold", 0, kUnbounded, Reload::Throttler),
+    number<&A::throttler, &ThrottlerConfig::breakerCooldownMs>(
+        "Throttler", "BreakerCooldownMs", 0, kUnbounded, Reload::Throttler),
+
+    flag  <&A::dispatcher, &DispatcherConfig::queueCommandsDuringSuspend>(
+        "Daemon", "QueueCommandsDuringSuspend", Reload::Dispatcher),
+    number<&A::dispatcher, &DispatcherConfig::suspendQueueCapacity>(
+        "Daemon", "SuspendQueueCapacity", 0, kUnbounded, Reload::Dispatcher),
+    number<&A::dispatcher, &DispatcherConfig::suspendQueueTtlMs>(
+        "Daemon", "SuspendQueueTtlMs", 0, kUnbounded, Reload::Dispatcher),
+    number<&A::dispatcher, &DispatcherConfig::commandTimeoutMs>(
+        "Daemon", "CommandTimeoutMs", 0, kUnbounded, Reload::Dispatcher),
+    flag  <&A::dispatcher, &DispatcherConfig::skipRedundantPowerOn>(
+        "Daemon", "SkipRedundantPowerOn", Reload::Dispatcher),
+    flag  <&A::dispatcher, &DispatcherConfig::skipRedundantPowerOff>(
+        "Daemon", "SkipRedundantPowerOff", Reload::Dispatcher),
+    flag  <&A::dispatcher, &DispatcherConfig::skipRedundantSource>(
+        "Daemon", "SkipRedundantSource", Reload::Dispatcher),
+    custom<parseOpcodes, &A::dispatcher, &DispatcherConfig::rawOpcodes>(
+        "Daemon", "RawOpcodes", Reload::Dispatcher),
+
+    // Read once by the subsystem that owns them, at construction or
+    // in CECDaemon::start.
+    number<&A::dispatcher, &DispatcherConfig::maxQueuedCommands>(
+        "Daemon", "MaxQueuedCommands", 0, kUnbounded, Reload::Restart),
+    number<&A::stateCache, &StateCacheConfig::ttlMs>(
+        "Daemon", "StateCacheTtlMs", 0, kUnbounded, Reload::Restart),
+    flag  <&A::daemon, &DaemonConfig::enablePowerMonitor>("Daemon", "EnablePowerMonitor",
+                                                          Reload::Restart),
+    flag  <&A::daemon, &DaemonConfig::scanDevicesAtStartup>("Daemon", "ScanDevicesAtStartup",
+                                                            Reload::Restart),
+    flag  <&A::daemon, &DaemonConfig::traceEnabled>("Daemon", "TraceEnabled", Reload::Restart),
+    flag  <&A::daemon, &DaemonConfig::deferAdapterOpen>("Daemon", "DeferAdapterOpen",
+                                                        Reload::Restart),
+    number<&A::daemon, &DaemonConfig::adapterReadyTimeoutMs>(
+        "Daemon", "AdapterReadyTimeoutMs", 0, kUnbounded, Reload::Restart),
+    custom<parseIdleClose, &A::daemon, &DaemonConfig::adapterIdleCloseMs>(
+        "Daemon", "AdapterIdleCloseMs", Reload::Restart),
+    number<&A::daemon, &DaemonConfig::maxConnections>(
+        "Daemon", "MaxConnections", 1, kMaxClientConnections, Reload::Restart),
+    number<&A::daemon, &DaemonConfig::rateLimitPerSecond>(
+        "Daemon", "RateLimitPerSecond", 0, 1000, Reload::Restart),
+    number<&A::daemon, &DaemonConfig::rateLimitBurst>(
+        "Daemon", "RateLimitBurst", 1, 1000, Reload::Restart),
+    flag  <&A::daemon, &DaemonConfig::statusPage>("Daemon", "StatusPage", Reload::Restart),
+    flag  <&A::daemon, &DaemonConfig::flightRecorder>("Daemon", "FlightRecorder",
+                                                      Reload::Restart),
+    flag  <&A::daemon, &DaemonConfig::lowMemory>("Daemon", "LowMemory", Reload::Restart),
+    number<&A::daemon, &DaemonConfig::watchdogMaxCallMs>(
+        "Daemon", "WatchdogMaxCallMs", 0, kUnbounded, Reload::Restart),
+    number<&A::daemon, &DaemonConfig::watchdogMaxWaitMs>(
+        "Daemon", "WatchdogMaxWaitMs", 0, kUnbounded, Reload::Restart),
+    text  <&A::daemon, &DaemonConfig::captureFile>("Daemon", "CaptureFile", Reload::Restart),
+    // Bounded so a typo cannot map gigabytes.
+    number<&A::daemon, &DaemonConfig::captureRecords>(
+        "Daemon", "CaptureRecords", 1024, 16777216, Reload::Restart),
+    // Validated when the exporter binds.
+    text  <&A::metrics, &MetricsConfig::listen>("Daemon", "MetricsListen", Reload::Restart),
+    text  <&A::network, &NetworkConfig::listen>("Daemon", "NetworkListen", Reload::Restart),
+    text  <&A::network, &NetworkConfig::tokenFile>("Daemon", "NetworkTokenFile",
+                                                   Reload::Restart),
+
+    flag  <&A::logging, &LoggingConfig::async>("Logging", "Async", Reload::Restart, "[Logging]"),
+    // Each slot is a full Logger::kMaxLineLength line; bound the
+    // preallocation so a typo cannot reserve gigabytes.
+    number<&A::logging, &LoggingConfig::queueLines>(
+        "Logging", "QueueLines", 16, 65536, Reload::Restart, "[Logging]"),
+    custom<parseOverflow, &A::logging, &LoggingConfig::overflow>(
+        "Logging", "Overflow", Reload::Restart, "[Logging]"),
+    customAt<std::optional<LogLevel>, parseLevel>(
+        "Logging", kSubsystemLevelKeys[1], subsystemLevel<LogSubsystem::Daemon>,
+        constSubsystemLevel<LogSubsystem::Daemon>, Reload::Restart, "[Logging]"),
+    customAt<std::optional<LogLevel>, parseLevel>(
+        "Logging", kSubsystemLevelKeys[2], subsystemLevel<LogSubsystem::Adapter>,
+        constSubsystemLevel<LogSubsystem::Adapter>, Reload::Restart, "[Logging]"),
+    customAt<std::optional<LogLevel>, parseLevel>(
+        "Logging", kSubsystemLevelKeys[3], subsystemLevel<LogSubsystem::Libcec>,
+        constSubsystemLevel<LogSubsystem::Libcec>, Reload::Restart, "[Logging]"),
+
+    // One absolute path per event: relative paths are rejected at load,
+    // a missing X_OK only warned about so permissions can be fixed
+    // without a restart.
+    custom<parseHookPath, &A::hooks, &HooksConfig::inputSwitch>(
+        "Hooks", "InputSwitch", Reload::HookScripts),
+    custom<parseHookPath, &A::hooks, &HooksConfig::tvStandby>(
+        "Hooks", "TVStandby", Reload::HookScripts),
+    custom<parseHookPath, &A::hooks, &HooksConfig::tvWake>(
+        "Hooks", "TVWake", Reload::HookScripts),
+    custom<parseHookPath, &A::hooks, &HooksConfig::hostActivated>(
+        "Hooks", "HostActivated", Reload::HookScripts),
+    custom<parseHookPath, &A::hooks, &HooksConfig::hostDeactivated>(
+        "Hooks", "HostDeactivated", Reload::HookScripts),
+    number<&A::hooks, &HooksConfig::inputSwitchDebounce, &HD::windowMs>(
+        "Hooks", "InputSwitchDebounceMs", 0, 60000, Reload::HookScripts),
+    custom<parseEdge, &A::hooks, &HooksConfig::inputSwitchDebounce, &HD::edge>(
+        "Hooks", "InputSwitchDebounceEdge", Reload::HookScripts),
+    number<&A::hooks, &HooksConfig::inputSwitchDebounce, &HD::maxWaitMs>(
+        "Hooks", "InputSwitchMaxWaitMs", 0, 600000, Reload::HookScripts),
+    number<&A::hooks, &HooksConfig::tvPowerDebounce, &HD::windowMs>(
+        "Hooks", "TVPowerDebounceMs", 0, 60000, Reload::HookScripts),
+    custom<parseEdge, &A::hooks, &HooksConfig::tvPowerDebounce, &HD::edge>(
+        "Hooks", "TVPowerDebounceEdge", Reload::HookScripts),
+    number<&A::hooks, &HooksConfig::tvPowerDebounce, &HD::maxWaitMs>(
+        "Hooks", "TVPowerMaxWaitMs", 0, 600000, Reload::HookScripts),
+    custom<parseHookPath, &A::hooks, &HooksConfig::helper>(
+        "Hooks", "Helper", Reload::Restart, "Hooks.Helper"),
+    number<&A::hooks, &HooksConfig::maxConcurrent>(
+        "Hooks", "MaxConcurrent", 0, kUnbounded, Reload::Restart, "Hooks.MaxConcurrent"),
+    flag  <&A::hooks, &HooksConfig::coalesce>("Hooks", "Coalesce", Reload::Restart,
+                                              "Hooks.Coalesce"),
+    number<&A::hooks, &HooksConfig::timeoutMs>(
+        "Hooks", "TimeoutMs", 0, kUnbounded, Reload::Restart, "Hooks.TimeoutMs"),
+
+    custom<parseCpus, &A::scheduling, &SchedulingConfig::adapter, &TS::cpus>(
+        "Scheduling", "AdapterCpus", Reload::Restart, "[Scheduling]"),
+    number<&A::scheduling, &SchedulingConfig::adapter, &TS::nice>(
+        "Scheduling", "AdapterNice", -20, 19, Reload::Restart, "[Scheduling]"),
+    custom<parsePolicy, &A::scheduling, &SchedulingConfig::adapter, &TS::policy>(
+        "Scheduling", "AdapterPolicy", Reload::Restart, "[Scheduling]"),
+    number<&A::scheduling, &SchedulingConfig::adapter, &TS::priority>(
+        "Scheduling", "AdapterPriority", 1, 99, Reload::Restart, "[Scheduling]"),
+    number<&A::scheduling, &SchedulingConfig::adapter, &TS::stackKiB>(
+        "Scheduling", "AdapterStackKiB", 0, 16384, Reload::Restart, "[Scheduling]"),
+    custom<parseCpus, &A::scheduling, &SchedulingConfig::hooks, &TS::cpus>(
+        "Scheduling", "HookCpus", Reload::Restart, "[Scheduling]"),
+    number<&A::scheduling, &SchedulingConfig::hooks, &TS::nice>(
+        "Scheduling", "HookNice", -20, 19, Reload::Restart, "[Scheduling]"),
+    custom<parsePolicy, &A::scheduling, &SchedulingConfig::hooks, &TS::policy>(
+        "Scheduling", "HookPolicy", Reload::Restart, "[Scheduling]"),
+    number<&A::scheduling, &SchedulingConfig::hooks, &TS::priority>(
+        "Scheduling", "HookPriority", 1, 99, Reload::Restart, "[Scheduling]"),
+    number<&A::scheduling, &SchedulingConfig::hooks, &TS::stackKiB>(
+        "Scheduling", "HookStackKiB", 0, 16384, Reload::Restart, "[Scheduling]"),
+};
+static_assert(config_schema::namesUnique(kSchema), "a config key name is used twice");
+
+constexpr auto kSchemaIndex = static_index::buildNameIndex<256>(
+    kSchema, [](const Key& key) { return key.name; });
+
+/** The row for @p section / @p name, or nullptr. */
+const Key* findKey(std::string_view section, std::string_view name) noexcept {
+    const uint8_t row =
+        kSchemaIndex.find(kSchema, name, [](const Key& key) { return key.name; });
+    if (row == static_index::kNone || kSchema[row].section != section) return nullptr;
+    return &kSchema[row];
+}
+
+bool knownSection(std::string_view section) noexcept {
+    return std::any_of(kSchema.begin(), kSchema.end(),
+                       [&](const Key& key) { return key.section == section; });
+}
+
+/** [Scene.NAME] sections hold scenes, compiled by loadAppConfig. */
+constexpr std::string_view kScenePrefix = "Scene.";
+
+/** [Adapter.NAME] sections add adapters, read by loadNamedAdapters. */
+constexpr std::string_view kAdapterPrefix = "Adapter.";
+
+/**
+ * The [Adapter] row an [Adapter.NAME] section may set as @p name, or
+ * nullptr. PowerOffOnStandby is not one: StandbyPolicy is daemon-wide.
+ */
+const Key* findAdapterKey(std::string_view name) noexcept {
+    const Key* key = findKey("Adapter", name);
+    return key != nullptr && key->reload == Reload::Adapter ? key : nullptr;
+}
+
+/** True when every [Adapter] row reads the same on @p a and @p b. */
+bool sameAdapter(const AdapterConfig& a, const AdapterConfig& b) {
+    // The rows reach their fields through an AppConfig.
+    AppConfig left;
+    AppConfig right;
+    left.adapter = a;
+    right.adapter = b;
+    return std::all_of(kSchema.begin(), kSchema.end(), [&](const Key& key) {
+        return key.reload != Reload::Adapter ||
+               key.equal(key.constField(left), key.constField(right));
+    });
+}
+
+const AdapterConfig* findNamedAdapter(const AppConfig& config, std::string_view name) {
+    for (const auto& adapter : config.namedAdapters) {
+        if (adapter.name == name) return &adapter;
     }
-    return path;
+    return nullptr;
 }
 
 /**
- * Parse a comma-separated list of CEC logical addresses (e.g. "0,1,5")
- * into a @c cec_logical_addresses bitmask. Out-of-range or non-numeric
- * entries are logged and skipped; an empty input yields a cleared
- * mask. No whitespace handling — matches the legacy behaviour and
- * keeps the config format predictable.
+ * Build config.namedAdapters from the [Adapter.NAME] @p entries. Each
+ * adapter starts from the finished [Adapter] values, so a key its
+ * section leaves out reads the same on every adapter.
  */
-CEC::cec_logical_addresses parseLogicalAddressList(const std::string& input,
-                                                    std::string_view fieldLabel) {
-    CEC::cec_logical_addresses addrs;
-    addrs.Clear();
-    if (input.empty()) return addrs;
-
-    std::stringstream ss(input);
-    std::string token;
-    while (std::getline(ss, token, ',')) {
-        try {
-            int id = std::stoi(token);
-            if (id >= 0 && id <= 15) {
-                addrs.Set(static_cast<CEC::cec_logical_address>(id));
-            } else {
-                LOG_WARNING("Logical address out of range in config field ",
-                            fieldLabel, ": ", id);
+void loadNamedAdapters(AppConfig& config,
+                       const std::vector<const ConfigManager::Entry*>& entries) {
+    AppConfig scratch;
+    std::string_view warnedSection;
+    for (const auto* entry : entries) {
+        const std::string_view section = entry->section;
+        const std::string_view name = section.substr(kAdapterPrefix.size());
+        if (!isValidAdapterName(name)) {
+            if (section != warnedSection) {
+                LOG_WARNING("Adapter section [", section, "] at line ", entry->line,
+                            ": name must be 1-", kMaxAdapterNameLength,
+                            " characters of A-Z, a-z, 0-9, '-' or '_' (ignored)");
+                warnedSection = section;
             }
-        } catch (const std::exception&) {
-            LOG_WARNING("Invalid logical address in config field ",
-                        fieldLabel, ": ", token);
+            continue;
+        }
+        const Key* key = findAdapterKey(entry->key);
+        if (key == nullptr) {
+            // PowerOffOnStandby is read from [Adapter] alone: the
+            // standby policy it sets covers every adapter.
+            LOG_WARNING("Unknown key in [", section, "] at line ", entry->line, ": ",
+                        entry->key,
+                        (entry->key == "PowerOffOnStandby" ? " (set it in [Adapter])"
+                                                           : " (ignored)"));
+            continue;
+        }
+        auto it = std::find_if(config.namedAdapters.begin(), config.namedAdapters.end(),
+                               [&](const AdapterConfig& a) { return a.name == name; });
+        if (it == config.namedAdapters.end()) {
+            it = config.namedAdapters.insert(config.namedAdapters.end(), config.adapter);
+            it->name = std::string(name);
         }
+        scratch.adapter = std::move(*it);
+        key->parse(entry->value, key->field(scratch), *key);
+        *it = std::move(scratch.adapter);
     }
-    return addrs;
+    std::sort(config.namedAdapters.begin(), config.namedAdapters.end(),
+              [](const AdapterConfig& a, const AdapterConfig& b) { return a.name < b.name; });
 }
 
 } // namespace
@@ -78,94 +674,187 @@ CEC::cec_logical_addresses parseLogicalAddressList(const std::string& input,
 AppConfig loadAppConfig(const ConfigManager& cfg) {
     AppConfig config;
 
-    // Adapter section — libcec-owned knobs the daemon hands into
-    // LibCecAdapter at construction.
-    auto& adapter = config.adapter;
-    adapter.deviceName      = cfg.getString("Adapter", "DeviceName", "CEC Controller");
-    adapter.autoPowerOn     = cfg.getBool  ("Adapter", "AutoPowerOn", false);
-    adapter.autoWakeAVR     = cfg.getBool  ("Adapter", "AutoWakeAVR", false);
-    adapter.activateSource  = cfg.getBool  ("Adapter", "ActivateSource", false);
-    adapter.systemAudioMode = cfg.getBool  ("Adapter", "SystemAudioMode", false);
-    adapter.wakeDevices     = parseLogicalAddressList(
-        cfg.getString("Adapter", "WakeDevices", ""), "WakeDevices");
-    adapter.powerOffDevices = parseLogicalAddressList(
-        cfg.getString("Adapter", "PowerOffDevices", ""), "PowerOffDevices");
-
-    // Throttler section — tuning for CommandThrottler. Keep in sync
-    // with the defaults on ThrottlerConfig.
-    auto& throttler = config.throttler;
-    throttler.baseIntervalMs   = cfg.getInt("Throttler", "BaseIntervalMs", 200);
-    throttler.maxIntervalMs    = cfg.getInt("Throttler", "MaxIntervalMs", 1000);
-    throttler.maxRetryAttempts = cfg.getInt("Throttler", "MaxRetryAttempts", 3);
-
-    // Dispatcher policy. QueueCommandsDuringSuspend lives under
-    // [Daemon] in the file for backwards compatibility with deployed
-    // configs, but is a dispatcher-scoped flag.
-    auto& dispatcher = config.dispatcher;
-    dispatcher.queueCommandsDuringSuspend =
-        cfg.getBool("Daemon", "QueueCommandsDuringSuspend", true);
-
-    // Standby policy. PowerOffOnStandby lives under [Adapter]
-    // historically — it names the CEC standby opcode the policy
-    // responds to — but the policy itself is enforced by
-    // StandbyPolicy, not libcec. See the LibCecAdapter constructor
-    // for why bPowerOffOnStandby is deliberately not mirrored into
-    // libcec's own config.
-    auto& standby = config.standby;
-    standby.enabled =
-        cfg.getBool("Adapter", "PowerOffOnStandby", false);
-
-    // Daemon-level toggles.
-    auto& daemon = config.daemon;
-    daemon.enablePowerMonitor =
-        cfg.getBool("Daemon", "EnablePowerMonitor",   true);
-    daemon.scanDevicesAtStartup =
-        cfg.getBool("Daemon", "ScanDevicesAtStartup", false);
-
-    // Hooks section — one absolute-path entry per event. Validate at
-    // parse time: reject relative paths outright, warn (but keep) on
-    // missing X_OK so operators can fix permissions without a restart.
-    auto& hooks = config.hooks;
-    hooks.inputSwitch = validateHookPath(
-        cfg.getString("Hooks", "InputSwitch", ""), "InputSwitch");
-    hooks.tvStandby = validateHookPath(
-        cfg.getString("Hooks", "TVStandby", ""), "TVStandby");
-    hooks.tvWake = validateHookPath(
-        cfg.getString("Hooks", "TVWake", ""), "TVWake");
-    hooks.hostActivated = validateHookPath(
-        cfg.getString("Hooks", "HostActivated", ""), "HostActivated");
-    hooks.hostDeactivated = validateHookPath(
-        cfg.getString("Hooks", "HostDeactivated", ""), "HostDeactivated");
-
-    // Warn on typos. The known-key set is the events above; any other
-    // key in [Hooks] is silently ignored by the parser, which is a
-    // usability footgun — a stray "TV-Wake" (hyphen) would look
-    // correct and do nothing. One warning per unknown key.
-    static constexpr std::array<std::string_view, 5> kKnownHookKeys{
-        "InputSwitch", "TVStandby", "TVWake", "HostActivated", "HostDeactivated",
-    };
-    for (const auto& [key, value] : cfg.section("Hooks")) {
-        const bool known =
-            std::find(kKnownHookKeys.begin(), kKnownHookKeys.end(), key) !=
-            kKnownHookKeys.end();
-        if (!known) {
-            LOG_WARNING("Unknown key in [Hooks]: ", key, " (ignored)");
-        }
-        (void)value;
+    // One pass over the file: each key goes to its row's parser, which
+    // writes the field in place. Nothing is looked up by string and no
+    // key is visited twice; the strings a snapshot holds (paths, the
+    // device name) are its only allocations.
+    std::string_view warnedSection;
+    std::vector<const ConfigManager::Entry*> adapterEntries;
+    for (const auto& entry : cfg.entries()) {
+        const std::string_view section = entry.section;
+        if (section.compare(0, kAdapterPrefix.size(), kAdapterPrefix) == 0) {
+            // Read after the pass, once every [Adapter] key has landed.
+            adapterEntries.push_back(&entry);
+            continue;
+        }
+        if (section.compare(0, kScenePrefix.size(), kScenePrefix) == 0) {
+            // Scenes are compiled here so a typo is reported at startup
+            // rather than at first use. A scene that does not compile is
+            // left out; the rest still load.
+            if (entry.key != "Steps") {
+                LOG_WARNING("Unknown key in [", section, "] at line ", entry.line, ": ",
+                            entry.key, " (ignored)");
+                continue;
+            }
+            const std::string_view name = section.substr(kScenePrefix.size());
+            std::string err;
+            auto scene = compileScene(std::string(name), entry.value, err);
+            if (!scene) {
+                LOG_WARNING("Scene ", name, ": ", err, " (scene disabled)");
+                continue;
+            }
+            config.scenes.push_back(std::move(*scene));
+            continue;
+        }
+
+        if (const Key* key = findKey(section, entry.key)) {
+            key->parse(entry.value, key->field(config), *key);
+            continue;
+        }
+        // A typo would otherwise do nothing and look correct: a stray
+        // "TV-Wake" (hyphen) in [Hooks], say.
+        if (knownSection(section)) {
+            LOG_WARNING("Unknown key in [", section, "] at line ", entry.line, ": ",
+                        entry.key, " (ignored)");
+        } else if (section != warnedSection) {
+            LOG_WARNING("Unknown section [", section, "] at line ", entry.line, " (ignored)");
+            warnedSection = section;
+        }
     }
 
+    loadNamedAdapters(config, adapterEntries);
+    settlePriority(config.scheduling.adapter);
+    settlePriority(config.scheduling.hooks);
+    settleStack(config.scheduling.adapter, config.daemon.lowMemory);
+    settleStack(config.scheduling.hooks, config.daemon.lowMemory);
+    std::sort(config.scenes.begin(), config.scenes.end(),
+              [](const Scene& a, const Scene& b) { return a.name < b.name; });
     return config;
 }
 
+AppConfigChanges diffAppConfig(const AppConfig& current, const AppConfig& next) {
+    AppConfigChanges changes;
+    for (const Key& key : kSchema) {
+        if (key.equal(key.constField(current), key.constField(next))) continue;
+        switch (key.reload) {
+            case Reload::Adapter:     changes.adapter     = true; break;
+            case Reload::Throttler:   changes.throttler   = true; break;
+            case Reload::Dispatcher:  changes.dispatcher  = true; break;
+            case Reload::Standby:     changes.standby     = true; break;
+            case Reload::HookScripts: changes.hookScripts = true; break;
+            case Reload::Restart:
+                if (changes.restartOnly.empty() ||
+                    changes.restartOnly.back() != key.reportName()) {
+                    changes.restartOnly.emplace_back(key.reportName());
+                }
+                break;
+        }
+    }
+    changes.scenes = !sameScenes(current.scenes, next.scenes);
+    // Each adapter owns a worker thread and a bus, built at startup.
+    for (const auto& adapter : next.namedAdapters) {
+        const AdapterConfig* running = findNamedAdapter(current, adapter.name);
+        if (running == nullptr) {
+            changes.restartOnly.push_back("[Adapter." + adapter.name + "]");
+        } else if (!sameAdapter(*running, adapter)) {
+            changes.namedAdapters.push_back(adapter.name);
+        }
+    }
+    for (const auto& adapter : current.namedAdapters) {
+        if (findNamedAdapter(next, adapter.name) == nullptr) {
+            changes.restartOnly.push_back("[Adapter." + adapter.name + "]");
+        }
+    }
+    return changes;
+}
+
 void logAppConfig(const AppConfig& config) {
     LOG_INFO("Configuration: ScanDevicesAtStartup = ",
              (config.daemon.scanDevicesAtStartup ? "true" : "false"));
     LOG_INFO("Configuration: QueueCommandsDuringSuspend = ",
              (config.dispatcher.queueCommandsDuringSuspend ? "true" : "false"));
+    LOG_INFO("Configuration: SuspendQueueCapacity = ",
+             config.dispatcher.suspendQueueCapacity);
+    LOG_INFO("Configuration: SuspendQueueTtlMs = ",
+             config.dispatcher.suspendQueueTtlMs);
+    LOG_INFO("Configuration: MaxQueuedCommands = ",
+             config.dispatcher.maxQueuedCommands);
+    LOG_INFO("Configuration: CommandTimeoutMs = ",
+             config.dispatcher.commandTimeoutMs);
+    LOG_INFO("Configuration: SkipRedundantPowerOn = ",
+             (config.dispatcher.skipRedundantPowerOn ? "true" : "false"));
+    LOG_INFO("Configuration: SkipRedundantPowerOff = ",
+             (config.dispatcher.skipRedundantPowerOff ? "true" : "false"));
+    LOG_INFO("Configuration: SkipRedundantSource = ",
+             (config.dispatcher.skipRedundantSource ? "true" : "false"));
+    LOG_INFO("Configuration: RawOpcodes = ", config.dispatcher.rawOpcodes.count(),
+             " opcode(s)");
+    LOG_INFO("Configuration: StateCacheTtlMs = ",
+             config.stateCache.ttlMs);
     LOG_INFO("Configuration: EnablePowerMonitor = ",
              (config.daemon.enablePowerMonitor ? "true" : "false"));
+    LOG_INFO("Configuration: TraceEnabled = ",
+             (config.daemon.traceEnabled ? "true" : "false"));
+    LOG_INFO("Configuration: DeferAdapterOpen = ",
+             (config.daemon.deferAdapterOpen ? "true" : "false"));
+    if (config.daemon.deferAdapterOpen) {
+        LOG_INFO("Configuration: AdapterReadyTimeoutMs = ",
+                 config.daemon.adapterReadyTimeoutMs);
+    }
+    LOG_INFO("Configuration: AdapterIdleCloseMs = ",
+             config.daemon.adapterIdleCloseMs);
+    LOG_INFO("Configuration: CallBudgetMs = ", config.adapter.callBudgetMs);
+    LOG_INFO("Configuration: MaxConnections = ",
+             config.daemon.maxConnections);
+    LOG_INFO("Configuration: RateLimitPerSecond = ",
+             config.daemon.rateLimitPerSecond);
+    LOG_INFO("Configuration: RateLimitBurst = ", config.daemon.rateLimitBurst);
+    LOG_INFO("Configuration: StatusPage = ",
+             (config.daemon.statusPage ? "true" : "false"));
+    LOG_INFO("Configuration: FlightRecorder = ",
+             (config.daemon.flightRecorder ? "true" : "false"));
+    LOG_INFO("Configuration: LowMemory = ",
+             (config.daemon.lowMemory ? "true" : "false"));
+    LOG_INFO("Configuration: WatchdogMaxCallMs = ", config.daemon.watchdogMaxCallMs,
+             ", WatchdogMaxWaitMs = ", config.daemon.watchdogMaxWaitMs);
+    if (!config.daemon.captureFile.empty()) {
+        LOG_INFO("Configuration: CaptureFile = ", config.daemon.captureFile,
+                 ", CaptureRecords = ", config.daemon.captureRecords);
+    }
+    LOG_INFO("Configuration: MetricsListen = ",
+             (config.metrics.listen.empty() ? "(disabled)" : config.metrics.listen));
+    LOG_INFO("Configuration: NetworkListen = ",
+             (config.network.listen.empty() ? "(disabled)" : config.network.listen));
+    if (!config.network.listen.empty()) {
+        LOG_INFO("Configuration: NetworkTokenFile = ", config.network.tokenFile);
+    }
+    LOG_INFO("Configuration: Logging.Async = ",
+             (config.logging.async ? "true" : "false"));
+    if (config.logging.async) {
+        LOG_INFO("Configuration: Logging.QueueLines = ", config.logging.queueLines);
+        LOG_INFO("Configuration: Logging.Overflow = ",
+                 (config.logging.overflow == LogOverflow::Block ? "block" : "drop"));
+    }
+    for (std::size_t i = 0; i < kLogSubsystemCount; ++i) {
+        if (const auto& level = config.logging.subsystemLevels[i]) {
+            LOG_INFO("Configuration: Logging.", kSubsystemLevelKeys[i], " = ",
+                     logLevelName(*level));
+        }
+    }
     LOG_INFO("Configuration: PowerOffOnStandby = ",
              (config.standby.enabled ? "true" : "false"));
+    if (const auto& sim = config.simulator; sim.enabled) {
+        LOG_INFO("Configuration: Simulator.CommandLatencyMs = ", sim.commandLatencyMs,
+                 ", QueryLatencyMs = ", sim.queryLatencyMs,
+                 ", LatencyDistribution = ", latencyName(sim.latency));
+        LOG_INFO("Configuration: Simulator.NackPercent = ", sim.nackPercent,
+                 ", ObservationIntervalMs = ", sim.observationIntervalMs,
+                 ", ConnectionLossIntervalMs = ", sim.connectionLossIntervalMs,
+                 ", Seed = ", sim.seed);
+        if (!sim.replayFile.empty()) {
+            LOG_INFO("Configuration: Simulator.ReplayFile = ", sim.replayFile);
+        }
+    }
 
     // Only surface configured hooks; a silent [Hooks] section should
     // not spam "= (empty)" lines into the operator's view.
@@ -184,6 +873,26 @@ void logAppConfig(const AppConfig& config) {
     if (!config.hooks.hostDeactivated.empty()) {
         LOG_INFO("Configuration: Hooks.HostDeactivated = ", config.hooks.hostDeactivated);
     }
+    if (!config.hooks.helper.empty()) {
+        LOG_INFO("Configuration: Hooks.Helper = ", config.hooks.helper);
+    }
+    LOG_INFO("Configuration: Hooks.MaxConcurrent = ", config.hooks.maxConcurrent);
+    LOG_INFO("Configuration: Hooks.Coalesce = ",
+             (config.hooks.coalesce ? "true" : "false"));
+    LOG_INFO("Configuration: Hooks.TimeoutMs = ", config.hooks.timeoutMs);
+    logHookDebounce(config.hooks.inputSwitchDebounce, "InputSwitch");
+    logHookDebounce(config.hooks.tvPowerDebounce, "TVPower");
+    logThreadSchedule(config.scheduling.adapter, "Adapter");
+    logThreadSchedule(config.scheduling.hooks, "Hook");
+    for (const auto& scene : config.scenes) {
+        LOG_INFO("Configuration: Scene.", scene.name, " = ",
+                 scene.steps.size(), " command(s)");
+    }
+    for (const auto& adapter : config.namedAdapters) {
+        LOG_INFO("Configuration: Adapter.", adapter.name, " Port = ",
+                 (adapter.port.empty() ? "(none)" : adapter.port),
+                 ", DeviceName = ", adapter.deviceName);
+    }
 }
 
 } // namespace cec_control
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
+#include "../common/logger.h"
 #include "cec/adapter_config.h"
 #include "command_throttler.h"
+#include "scene.h"
+#include "thread_schedule.h"
 
 namespace cec_control {
 
@@ -15,6 +23,41 @@ class ConfigManager;
  */
 struct DispatcherConfig {
     bool queueCommandsDuringSuspend = true;
+    /**
+     * Commands kept while suspended; a further one is refused with
+     * @c RESP_BUSY. 0 = unbounded.
+     */
+    uint32_t suspendQueueCapacity = 64;
+    /**
+     * Longest a command queued during suspend stays worth replaying;
+     * older ones are dropped at resume. 0 = no expiry.
+     */
+    uint32_t suspendQueueTtlMs = 600000;
+    /**
+     * Cap on commands waiting in the adapter worker's queue; further
+     * commands are refused with @c RESP_BUSY. Lifecycle work (suspend,
+     * resume, reconnect) is exempt. 0 = unbounded.
+     */
+    uint32_t maxQueuedCommands = 32;
+    /**
+     * Longest a command may wait in that queue before it is answered
+     * @c RESP_ERROR without being sent. 0 = no deadline.
+     */
+    uint32_t commandTimeoutMs  = 5000;
+    /**
+     * Acknowledge a command without sending it when the device-state
+     * cache freshly shows it would change nothing: a power-on to a
+     * device already on, a standby to one already in standby, a source
+     * change to the HDMI input already active.
+     */
+    bool skipRedundantPowerOn  = false;
+    bool skipRedundantPowerOff = false;
+    bool skipRedundantSource   = false;
+    /**
+     * Opcodes CMD_RAW_TRANSMIT may send and that are delivered whole to
+     * @c raw event subscribers when received. Empty disables both.
+     */
+    std::bitset<256> rawOpcodes;
 };
 
 /**
@@ -28,14 +71,148 @@ struct StandbyConfig {
     bool enabled = false;
 };
 
+/**
+ * Seed for @c DeviceStateCache: how long a cached bus fact (power
+ * status, physical address, OSD name, active source) is trusted
+ * before a reader must go back to the bus.
+ */
+struct StateCacheConfig {
+    uint32_t ttlMs = 30000;
+};
+
 /**
  * Daemon-level toggles. Read once at startup by @c CECDaemon::start
- * to decide whether to scan devices and whether to bring up the
- * D-Bus power monitor.
+ * to decide whether to scan devices, whether to bring up the D-Bus
+ * power monitor, whether pipeline tracing starts recording
+ * (afterwards toggled at runtime by @c CMD_TRACE), and whether the
+ * adapter is opened before or after the socket starts serving.
  */
 struct DaemonConfig {
-    bool enablePowerMonitor   = true;
-    bool scanDevicesAtStartup = false;
+    bool     enablePowerMonitor    = true;
+    bool     scanDevicesAtStartup  = false;
+    bool     traceEnabled          = false;
+    /** Serve and report ready first; open the adapter on the worker. */
+    bool     deferAdapterOpen      = false;
+    /** Hold adapter commands this long for a deferred open; 0 = until it completes. */
+    uint32_t adapterReadyTimeoutMs = 8000;
+    /**
+     * Close the adapter after this long without an adapter command and
+     * reopen it for the next one; 0 = keep it open. Raised to
+     * @c kMinAdapterIdleCloseMs when lower.
+     */
+    uint32_t adapterIdleCloseMs    = 0;
+    /** Client sessions served at once; clamped to 1..@c kMaxClientConnections. */
+    uint32_t maxConnections        = 10;
+    /** Requests each client user may send per second; 0 = no limit. */
+    uint32_t rateLimitPerSecond    = 0;
+    /** Requests a client user may send at once before the rate limit applies. */
+    uint32_t rateLimitBurst        = 20;
+    /** Publish bus state as a memory-mapped page; see @c StatusPageWriter. */
+    bool     statusPage            = true;
+    /** Keep recent activity in a crash-surviving file; see @c FlightRecorder. */
+    bool     flightRecorder        = true;
+    /**
+     * Trade allocation speed for footprint: one malloc arena, the heap
+     * trimmed after startup and after each full bus scan, and
+     * @c kLowMemoryStackKiB stacks for threads whose size is not set.
+     */
+    bool     lowMemory             = false;
+    /**
+     * Stop pinging the systemd watchdog while one adapter-worker slice
+     * has run this long, so a daemon wedged in libcec is restarted;
+     * 0 = no limit.
+     */
+    uint32_t watchdogMaxCallMs     = 30000;
+    /** The same for the oldest job still queued for the worker; 0 = no limit. */
+    uint32_t watchdogMaxWaitMs     = 60000;
+    /** Record bus frames and adapter calls here; see @c TrafficCapture. Empty = off. */
+    std::string captureFile;
+    /** Records the capture keeps before overwriting the oldest; 40 bytes each. */
+    uint32_t captureRecords        = 65536;
+};
+
+/**
+ * Floor for @c DaemonConfig::adapterIdleCloseMs. Longer than any
+ * command can stay queued or held (a scene, a held key), so an idle
+ * close never lands under work that is still running.
+ */
+inline constexpr uint32_t kMinAdapterIdleCloseMs = 30000;
+
+/** Thread stack under @c DaemonConfig::lowMemory where none is configured. */
+inline constexpr uint32_t kLowMemoryStackKiB = 256;
+
+/**
+ * Floor for a configured @c ThreadSchedule::stackKiB: below it a
+ * libcec call or a log line could run off the end of the stack.
+ */
+inline constexpr uint32_t kMinThreadStackKiB = 64;
+
+/**
+ * Ceiling for @c DaemonConfig::maxConnections: each session holds an
+ * fd, and this leaves room under the default 1024-descriptor limit
+ * for everything else the daemon opens.
+ */
+inline constexpr uint32_t kMaxClientConnections = 512;
+
+/**
+ * Optional OpenMetrics scrape endpoint. @c listen is an
+ * @c ADDRESS:PORT (IPv4, numeric) for @c MetricsExporter to bind;
+ * empty leaves the exporter off.
+ */
+struct MetricsConfig {
+    std::string listen;
+};
+
+/**
+ * Optional TCP control endpoint. @c listen is an @c ADDRESS:PORT
+ * (IPv4, numeric) for @c NetworkServer to bind, empty for none;
+ * @c tokenFile holds the secret its clients must present.
+ */
+struct NetworkConfig {
+    std::string listen;
+    std::string tokenFile;
+};
+
+/**
+ * Logger backend. The sinks and level come from the command line and
+ * are set before the file is read; this decides whether log calls hand
+ * their lines to a writer thread (@c async), how many lines that
+ * thread's queue holds, what a caller does when it is full, and which
+ * subsystems log at a level other than the command line's, indexed by
+ * @c LogSubsystem.
+ */
+struct LoggingConfig {
+    bool        async      = false;
+    uint32_t    queueLines = 1024;
+    LogOverflow overflow   = LogOverflow::Drop;
+    std::array<std::optional<LogLevel>, kLogSubsystemCount> subsystemLevels{};
+};
+
+/**
+ * How a hook collapses a burst of observations into one firing. A
+ * burst lasts while observations keep arriving less than @c windowMs
+ * apart; @c maxWaitMs, when set, closes it that long after its first
+ * observation however busy the bus stays.
+ */
+struct HookDebounce {
+    enum class Edge {
+        Trailing,  ///< Fire once the burst is over, on its final state.
+        Leading,   ///< Fire on the burst's first observation, and again at its end if the state moved on.
+    };
+
+    /** Quiet time that ends a burst; 0 fires on every observation. */
+    uint32_t windowMs  = 0;
+    Edge     edge      = Edge::Trailing;
+    /** Longest a burst may hold a firing back; 0 = no cap. */
+    uint32_t maxWaitMs = 0;
+
+    [[nodiscard]] bool operator==(const HookDebounce& other) const noexcept {
+        return windowMs == other.windowMs && edge == other.edge &&
+               maxWaitMs == other.maxWaitMs;
+    }
+    [[nodiscard]] bool operator!=(const HookDebounce& other) const noexcept {
+        return !(*this == other);
+    }
 };
 
 /**
@@ -47,7 +224,7 @@ struct DaemonConfig {
  *
  * The absolute-path requirement exists because the child is launched
  * with a sanitised environment that does not mirror the daemon's
- * @c PATH layout (see @c CecHookSubsystem::baseEnv); resolving via
+ * @c PATH layout (see @c CecHookSubsystem::sanitisedParentEnv); resolving via
  * @c $PATH could silently pick up the wrong binary.
  */
 struct HooksConfig {
@@ -56,47 +233,129 @@ struct HooksConfig {
     std::string tvWake;
     std::string hostActivated;
     std::string hostDeactivated;
+    /**
+     * Long-running co-process fed one line per event on its stdin
+     * (see @c HookHelper). Same path rules as the per-event hooks.
+     */
+    std::string helper;
+
+    /**
+     * Children of one hook running at once; 0 = unlimited. The three
+     * limits default off, so hooks run as they did before them: every
+     * event at once, none waiting, none cut short.
+     */
+    uint32_t maxConcurrent = 0;
+    /** Collapse a hook's waiting runs into the newest one. */
+    bool     coalesce      = false;
+    /** Run time before a hook child is terminated; 0 = unlimited. */
+    uint32_t timeoutMs     = 0;
+
+    /** Active-source bursts (@c ROUTING_CHANGE, @c SET_STREAM_PATH, ...). */
+    HookDebounce inputSwitchDebounce{200, HookDebounce::Edge::Trailing, 0};
+    /** TV power flaps; one window covers @c TVStandby and @c TVWake together. */
+    HookDebounce tvPowerDebounce;
+};
+
+/**
+ * @c [Scheduling]: how the latency-critical threads are placed and
+ * prioritised. Applied once, when each thread starts.
+ */
+struct SchedulingConfig {
+    /** The adapter worker, and through it libcec's own threads. */
+    ThreadSchedule adapter;
+    /** The hook exec thread; the scripts it runs drop back to normal. */
+    ThreadSchedule hooks;
 };
 
 /**
  * Typed, read-only snapshot of the configuration file.
  *
- * Loaded once at startup via @c loadAppConfig, handed to consumers
- * at construction, and never mutated thereafter. Runtime-mutable
- * policy (e.g. the wire-toggleable auto-standby flag) lives on the
- * consuming subsystem, seeded from this snapshot at construction —
+ * Loaded at startup via @c loadAppConfig, handed to consumers at
+ * construction, and never mutated in place. Runtime-mutable policy
+ * (e.g. the wire-toggleable auto-standby flag) lives on the consuming
+ * subsystem, seeded from this snapshot at construction —
  * @c AppConfig is the file's mirror, not the live policy store.
  *
  * Every field is itself a typed sub-struct scoped to one consumer
  * (adapter / throttler / dispatcher / daemon). File-layout-to-struct-
- * layout is mapped by @c loadAppConfig; a reader who wants to know
- * which INI section populates a given field should read that.
+ * layout is the key table beside @c loadAppConfig (see
+ * config_schema.h); a reader who wants to know which INI section
+ * populates a given field, its range, or what a reload does with it
+ * should read that. Defaults are the sub-structs' initialisers.
  *
- * A future SIGHUP reload would re-run @c loadAppConfig to produce a
- * fresh @c AppConfig, diff against the stored snapshot, and call the
- * appropriate setter on the owning subsystem; the snapshot itself is
- * replaced wholesale, never patched in place.
+ * A SIGHUP reload re-runs @c loadAppConfig, compares the result with
+ * the stored snapshot through @c diffAppConfig, and calls the owning
+ * subsystem's setter for each section that changed. The daemon keeps
+ * the new snapshot for the sections it applied and the old values for
+ * those that only take effect on restart.
  */
 struct AppConfig {
     AdapterConfig    adapter;
+    SimulatorConfig  simulator;
     ThrottlerConfig  throttler;
     DispatcherConfig dispatcher;
     StandbyConfig    standby;
+    StateCacheConfig stateCache;
     DaemonConfig     daemon;
+    MetricsConfig    metrics;
+    NetworkConfig    network;
+    LoggingConfig    logging;
     HooksConfig      hooks;
+    SchedulingConfig scheduling;
+    /** Compiled @c [Scene.NAME] sections, sorted by name. */
+    SceneTable       scenes;
+    /**
+     * @c [Adapter.NAME] sections: further adapters the daemon drives
+     * beside @c adapter, sorted by name. Each starts from the
+     * @c [Adapter] values and overrides the keys its section sets.
+     */
+    std::vector<AdapterConfig> namedAdapters;
 };
 
 /**
  * Parse @p cfg into a typed @c AppConfig.
  *
+ * One pass over the file's entries, each handed to its key's parser.
  * Pure with respect to value echoing: the only diagnostics emitted
- * here are parse-level warnings (malformed logical-address entries).
+ * here are parse-level warnings (unknown keys and sections, malformed
+ * or out-of-range values, each naming the key).
  * Per-field "Configuration: X = Y" summaries go through
  * @c logAppConfig so a future reload path can parse silently and only
  * log a diff.
  */
 [[nodiscard]] AppConfig loadAppConfig(const ConfigManager& cfg);
 
+/**
+ * Which parts of a reloaded configuration differ from the running
+ * one, grouped by the subsystem that applies them. The flags cover
+ * what a reload can swap in; @c restartOnly names each changed key
+ * that is read once at startup and keeps its old value until the
+ * daemon restarts.
+ */
+struct AppConfigChanges {
+    bool adapter     = false;  ///< Any @c [Adapter] field except PowerOffOnStandby.
+    bool throttler   = false;
+    bool dispatcher  = false;  ///< Queueing, deadline and redundant-command policy.
+    bool standby     = false;
+    bool hookScripts = false;  ///< A per-event script path or debounce setting.
+    bool scenes      = false;
+    /**
+     * Names of the @c [Adapter.NAME] adapters whose values changed. One
+     * added or removed is a restart-only change instead.
+     */
+    std::vector<std::string> namedAdapters;
+    std::vector<std::string> restartOnly;
+
+    [[nodiscard]] bool any() const noexcept {
+        return adapter || throttler || dispatcher || standby || hookScripts ||
+               scenes || !namedAdapters.empty() || !restartOnly.empty();
+    }
+};
+
+/** Compare @p next, freshly loaded, against the running @p current. */
+[[nodiscard]] AppConfigChanges diffAppConfig(const AppConfig& current,
+                                             const AppConfig& next);
+
 /**
  * Emit an INFO-level summary of the values in @p config. Deliberately
  * split from @c loadAppConfig — see that function's doc-comment for
@@ -1,14 +1,16 @@
 #pragma once
 
 #include <libcec/cec.h>
+#include <cstdint>
 #include <string>
 
 namespace cec_control {
 
 /**
- * Startup configuration for the libcec-backed adapter. Consumed once
- * at construction and immutable thereafter; runtime-mutable policy
- * (auto-standby) lives on @c CommandDispatcher.
+ * Configuration for the libcec-backed adapter. Consumed at
+ * construction; a config reload that changes it hands the new value
+ * to @c ICecAdapter::reconfigure and reopens the connection.
+ * Runtime-mutable policy (auto-standby) lives on @c StandbyPolicy.
  *
  * Lives in @c daemon/cec/ rather than @c common/ because the
  * @c CEC::cec_logical_addresses members transitively pull in
@@ -16,13 +18,31 @@ namespace cec_control {
  * take on.
  */
 struct AdapterConfig {
+    /**
+     * NAME of the @c [Adapter.NAME] section this adapter comes from;
+     * empty for the default @c [Adapter]. A request's adapter selector
+     * matches it, and its port is cached under it.
+     */
+    std::string name;
     std::string deviceName      = "CEC Controller";
+    /**
+     * Device node (e.g. @c /dev/ttyACM1) or sysfs path of the dongle
+     * to drive, for hosts with more than one. Empty takes the first
+     * adapter libcec detects.
+     */
+    std::string port;
     bool        autoPowerOn     = false;
     bool        autoWakeAVR     = false;
     bool        activateSource  = false;
     bool        systemAudioMode = false;
     CEC::cec_logical_addresses wakeDevices;
     CEC::cec_logical_addresses powerOffDevices;
+    /**
+     * Longest one adapter call may take before the adapter is treated
+     * as wedged: it reports itself disconnected, so queued work fails
+     * at once, and the connection-lost path reconnects it. 0 = no limit.
+     */
+    uint32_t    callBudgetMs    = 8000;
 
     AdapterConfig() noexcept {
         // libcec's cec_logical_addresses is not self-clearing on
@@ -33,4 +53,55 @@ struct AdapterConfig {
     }
 };
 
+/**
+ * Shape of the bus @c SimulatedCecAdapter pretends to drive, from
+ * @c [Simulator] or forced on by @c --simulate. Read once at startup:
+ * the backend is chosen when the daemon builds its adapter.
+ *
+ * Latencies are the mean time one adapter call blocks the worker, as
+ * a libcec call waits on the bus; @c latency picks how individual
+ * calls scatter around it. Rates and intervals default to a quiet,
+ * perfect bus, so a simulator run only misbehaves when asked to.
+ */
+struct SimulatorConfig {
+    /** How per-call latency is drawn around its mean. */
+    enum class Latency {
+        Fixed,        ///< Exactly the mean, every call.
+        Uniform,      ///< Evenly between zero and twice the mean.
+        Exponential,  ///< Memoryless, with a long tail.
+    };
+
+    bool     enabled          = false;
+    /**
+     * Set by the daemon's @c --simulate: @c enabled stays on whatever a
+     * reload of the file says.
+     */
+    bool     forced           = false;
+    /** Devices answering on the simulated bus; default TV and audio system. */
+    CEC::cec_logical_addresses devices;
+    uint32_t commandLatencyMs = 30;
+    uint32_t queryLatencyMs   = 10;
+    Latency  latency          = Latency::Uniform;
+    /** Share of commands that go unacknowledged, 0-100. */
+    uint32_t nackPercent      = 0;
+    /** Mean gap between unsolicited bus reports; 0 = none. */
+    uint32_t observationIntervalMs    = 0;
+    /** Mean time between simulated lost connections; 0 = never. */
+    uint32_t connectionLossIntervalMs = 0;
+    /** Seed for every random draw; 0 = a different run each start. */
+    uint32_t seed             = 0;
+    /**
+     * Traffic capture (@c [Daemon] @c CaptureFile) to play back: its
+     * frames arrive at their recorded times and its calls take their
+     * recorded durations. Empty = none.
+     */
+    std::string replayFile;
+
+    SimulatorConfig() noexcept {
+        devices.Clear();
+        devices.Set(CEC::CECDEVICE_TV);
+        devices.Set(CEC::CECDEVICE_AUDIOSYSTEM);
+    }
+};
+
 } // namespace cec_control
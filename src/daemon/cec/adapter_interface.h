@@ -6,8 +6,14 @@
 
 #include <libcec/cec.h>
 
+#include "../../common/messages.h"
+#include "adapter_config.h"
+#include "frame_filter.h"
+
 namespace cec_control {
 
+class TrafficCapture;
+
 /**
  * @class ICecAdapter
  * @brief Abstract interface over the CEC adapter stack.
@@ -48,8 +54,11 @@ public:
      *
      * Produced by the backend after it matches either a filtered
      * opcode on the command-receive path (@c TvStandby /
-     * @c TvPowerReport / @c ActiveSource) or a client-local
+     * @c TvPowerReport / @c PowerReport / @c ActiveSource /
+     * @c PhysicalAddressReport) or a client-local
      * source-activation edge (@c HostActivated / @c HostDeactivated),
+     * or, for a frame @ref Callbacks::rawFrames accepts, the frame
+     * itself (@c RawFrame, ahead of any typed observation of it),
      * and delivered via @ref Callbacks::onObservation on a backend-
      * internal thread. The @c kind tag selects the payload field that
      * is meaningful for the event; other payload fields stay at their
@@ -64,25 +73,41 @@ public:
         enum class Kind {
             TvStandby,
             TvPowerReport,
+            /** Power report from any device other than the TV. */
+            PowerReport,
             ActiveSource,
+            PhysicalAddressReport,
             HostActivated,
             HostDeactivated,
+            RawFrame,
         };
         Kind kind{};
 
-        /** Meaningful only when @c kind == @c Kind::ActiveSource. */
+        /**
+         * Meaningful only when @c kind is @c Kind::ActiveSource or
+         * @c Kind::PhysicalAddressReport.
+         */
         uint16_t physicalAddress{0};
 
-        /** Meaningful only when @c kind == @c Kind::TvPowerReport. */
+        /**
+         * Meaningful only when @c kind is @c Kind::TvPowerReport or
+         * @c Kind::PowerReport.
+         */
         CEC::cec_power_status power{CEC::CEC_POWER_STATUS_UNKNOWN};
 
         /**
-         * Meaningful only when @c kind is @c Kind::HostActivated or
-         * @c Kind::HostDeactivated — the logical address of the
-         * backend's own client whose active-source state just
-         * changed. @c CECDEVICE_UNKNOWN on every other kind.
+         * The device the observation is about. For @c Kind::HostActivated
+         * / @c Kind::HostDeactivated, the backend's own client whose
+         * active-source state just changed; for @c Kind::PowerReport and
+         * @c Kind::PhysicalAddressReport, the reporting initiator; for
+         * @c Kind::ActiveSource, the announcing initiator when the frame
+         * was an ACTIVE_SOURCE (a routing change names only the path).
+         * @c CECDEVICE_UNKNOWN otherwise.
          */
         CEC::cec_logical_address logical{CEC::CECDEVICE_UNKNOWN};
+
+        /** Meaningful only when @c kind is @c Kind::RawFrame. */
+        RawFrame frame{};
     };
 
     /**
@@ -99,8 +124,44 @@ public:
         std::function<void(Observation)> onObservation;
         /** Backend lost contact with the adapter hardware. */
         std::function<void()> onConnectionLost;
+        /**
+         * Received frames anything in the daemon wants, typed or raw;
+         * the rest are dropped on arrival. Null lets every frame through
+         * to the typed decoding. Owned by the caller and outliving the
+         * adapter; see @c FrameFilter for its threading.
+         */
+        const FrameFilter* frames = nullptr;
+        /**
+         * Of those, the frames also delivered whole as a
+         * @c Kind::RawFrame observation. Null means none.
+         */
+        const FrameFilter* rawFrames = nullptr;
+        /**
+         * Where every received frame is recorded as it arrives, ahead of
+         * @c frames; null records nothing. Owned by the caller and
+         * outliving the adapter.
+         */
+        TrafficCapture* capture = nullptr;
     };
 
+    /**
+     * The frames the typed @ref Observation kinds are decoded from:
+     * <Standby> from the TV, and <Report Power Status>,
+     * <Report Physical Address>, <Active Source>, <Routing Change> and
+     * <Set Stream Path> from anyone. A starting point for
+     * @ref Callbacks::frames.
+     */
+    [[nodiscard]] static constexpr FrameFilter::Table typedObservationFrames() noexcept {
+        FrameFilter::Table table{};
+        table[CEC::CEC_OPCODE_STANDBY]                 = 1u << CEC::CECDEVICE_TV;
+        table[CEC::CEC_OPCODE_REPORT_POWER_STATUS]     = FrameFilter::kAnyInitiator;
+        table[CEC::CEC_OPCODE_REPORT_PHYSICAL_ADDRESS] = FrameFilter::kAnyInitiator;
+        table[CEC::CEC_OPCODE_ACTIVE_SOURCE]           = FrameFilter::kAnyInitiator;
+        table[CEC::CEC_OPCODE_ROUTING_CHANGE]          = FrameFilter::kAnyInitiator;
+        table[CEC::CEC_OPCODE_SET_STREAM_PATH]         = FrameFilter::kAnyInitiator;
+        return table;
+    }
+
     virtual ~ICecAdapter() = default;
 
     ICecAdapter() = default;
@@ -134,6 +195,13 @@ public:
     /** Connection hint — see @em connection-hint at class scope. */
     [[nodiscard]] virtual bool isConnected() const = 0;
 
+    /**
+     * Replace the backend configuration. The open connection keeps
+     * the values it was opened with; the next @c reopenConnection
+     * applies @p config. Worker thread only.
+     */
+    virtual void reconfigure(AdapterConfig config) = 0;
+
     // Commands ----------------------------------------------------------
     //
     // libcec's enum types remain in the signature for this phase.
@@ -142,6 +210,13 @@ public:
 
     [[nodiscard]] virtual bool powerOnDevice(CEC::cec_logical_address address) = 0;
     [[nodiscard]] virtual bool standbyDevice(CEC::cec_logical_address address) = 0;
+    /**
+     * One @c <Standby> frame to the broadcast address, which every
+     * device on the bus honours. Unlike @c standbyDevice(BROADCAST),
+     * which libcec expands into its @c powerOffDevices list, this is
+     * exactly one frame. True iff it was transmitted.
+     */
+    [[nodiscard]] virtual bool broadcastStandby() = 0;
     [[nodiscard]] virtual bool volumeUp() = 0;
     [[nodiscard]] virtual bool volumeDown() = 0;
     [[nodiscard]] virtual bool toggleMute() = 0;
@@ -149,6 +224,14 @@ public:
                                             CEC::cec_user_control_code key,
                                             bool release) = 0;
     [[nodiscard]] virtual bool setStreamPath(uint16_t physicalAddress) = 0;
+    /**
+     * Transmit @p frame exactly as given, from the adapter's own
+     * address when its initiator is @c kLogicalAddressUnknown. An
+     * initiator that is not one of the adapter's own addresses is
+     * refused without sending. True iff it was transmitted, and for a
+     * directed frame acknowledged.
+     */
+    [[nodiscard]] virtual bool transmitRaw(const RawFrame& frame) = 0;
 
     // Queries -----------------------------------------------------------
 
@@ -160,19 +243,20 @@ public:
         CEC::cec_logical_address address) const = 0;
     [[nodiscard]] virtual std::string getDeviceOSDName(
         CEC::cec_logical_address address) const = 0;
+    /** IEEE OUI the device reported, or @c CEC::CEC_VENDOR_UNKNOWN. */
+    [[nodiscard]] virtual uint32_t getDeviceVendorId(
+        CEC::cec_logical_address address) const = 0;
+    [[nodiscard]] virtual CEC::cec_version getDeviceCecVersion(
+        CEC::cec_logical_address address) const = 0;
     [[nodiscard]] virtual CEC::cec_logical_addresses getActiveDevices() const = 0;
     [[nodiscard]] virtual CEC::cec_logical_address getActiveSource() const = 0;
-
-    // Broadcast-style helpers ------------------------------------------
-    //
-    // Default argument is resolved statically, but every daemon-side
-    // call site goes through an @c ICecAdapter reference or pointer,
-    // so the interface's default is the one that applies.
-
-    [[nodiscard]] virtual bool standbyDevices(
-        CEC::cec_logical_address address = CEC::CECDEVICE_BROADCAST) = 0;
-    [[nodiscard]] virtual bool powerOnDevices(
-        CEC::cec_logical_address address = CEC::CECDEVICE_BROADCAST) = 0;
+    /**
+     * The audio system's GIVE_AUDIO_STATUS answer: volume in the low
+     * seven bits (@c CEC::CEC_AUDIO_VOLUME_STATUS_MASK), mute flag in
+     * the top bit. @c CEC::CEC_AUDIO_VOLUME_STATUS_UNKNOWN when there
+     * is no answer.
+     */
+    [[nodiscard]] virtual uint8_t getAudioStatus() const = 0;
 };
 
 } // namespace cec_control
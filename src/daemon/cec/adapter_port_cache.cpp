@@ -0,0 +1,101 @@
+#include "adapter_port_cache.h"
+
+#include "../../common/logger.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace cec_control {
+
+namespace {
+
+/** Parse a four-digit hex ID as sysfs and the cache file write it. */
+std::optional<std::uint16_t> parseHexId(const std::string& text) {
+    unsigned value = 0;
+    char extra = 0;
+    if (std::sscanf(text.c_str(), "%4x%c", &value, &extra) != 1) return std::nullopt;
+    return static_cast<std::uint16_t>(value);
+}
+
+/** First line of a sysfs attribute, or empty. */
+std::string readAttribute(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+std::string hexId(std::uint16_t id) {
+    char buf[8];
+    std::snprintf(buf, sizeof(buf), "%04x", static_cast<unsigned>(id));
+    return buf;
+}
+
+} // namespace
+
+std::optional<AdapterPort> loadAdapterPort(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return std::nullopt;
+
+    AdapterPort port;
+    std::string line;
+    while (std::getline(in, line)) {
+        const auto eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        const std::string key   = line.substr(0, eq);
+        const std::string value = line.substr(eq + 1);
+        if (key == "port") {
+            port.comName = value;
+        } else if (key == "path") {
+            port.comPath = value;
+        } else if (key == "vendor" || key == "product") {
+            const auto id = parseHexId(value);
+            if (!id) return std::nullopt;
+            (key == "vendor" ? port.vendorId : port.productId) = *id;
+        }
+    }
+    if (port.comName.empty()) return std::nullopt;
+    return port;
+}
+
+bool saveAdapterPort(const std::string& path, const AdapterPort& port) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << "port="    << port.comName << '\n'
+            << "path="    << port.comPath << '\n'
+            << "vendor="  << hexId(port.vendorId) << '\n'
+            << "product=" << hexId(port.productId) << '\n';
+        if (!out.flush()) {
+            LOG_WARNING("Cannot write adapter port cache ", tmp);
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOG_WARNING("Cannot replace adapter port cache ", path, ": ", std::strerror(errno));
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void forgetAdapterPort(const std::string& path) {
+    if (std::remove(path.c_str()) != 0 && errno != ENOENT) {
+        LOG_WARNING("Cannot remove adapter port cache ", path, ": ", std::strerror(errno));
+    }
+}
+
+bool adapterPortPresent(const AdapterPort& port) {
+    struct stat st;
+    if (::stat(port.comName.c_str(), &st) != 0 || !S_ISCHR(st.st_mode)) return false;
+    if (port.comPath.empty()) return true;
+    return parseHexId(readAttribute(port.comPath + "/idVendor"))  == port.vendorId &&
+           parseHexId(readAttribute(port.comPath + "/idProduct")) == port.productId;
+}
+
+} // namespace cec_control
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace cec_control {
+
+/**
+ * The adapter port the daemon last opened successfully, as libcec's
+ * @c DetectAdapters described it. Kept so a restart, resume or
+ * reconnect can @c Open it directly instead of enumerating every
+ * serial and USB device again.
+ */
+struct AdapterPort {
+    std::string   comName;        ///< Device node passed to @c Open, e.g. @c /dev/ttyACM0.
+    std::string   comPath;        ///< sysfs directory of the USB device; may be empty.
+    std::uint16_t vendorId  = 0;
+    std::uint16_t productId = 0;
+};
+
+/**
+ * Read a port saved by @c saveAdapterPort. @c std::nullopt when the
+ * file is missing or unparseable — the caller just detects instead.
+ */
+[[nodiscard]] std::optional<AdapterPort> loadAdapterPort(const std::string& path);
+
+/**
+ * Save @p port to @p path, replacing it atomically. Failure is logged
+ * and otherwise harmless: the next start detects as before.
+ */
+bool saveAdapterPort(const std::string& path, const AdapterPort& port);
+
+/** Remove a saved port, e.g. once it has failed to open. */
+void forgetAdapterPort(const std::string& path);
+
+/**
+ * @c true when @p port still looks like the same adapter: its device
+ * node exists and, if the sysfs path is known, the USB device there
+ * still reports the saved vendor and product. Two @c stat / small
+ * reads — cheap next to a failed @c Open on a node that has moved on.
+ */
+[[nodiscard]] bool adapterPortPresent(const AdapterPort& port);
+
+} // namespace cec_control
@@ -1,28 +1,41 @@
 #include "adapter_worker.h"
 
 #include "../../common/logger.h"
+#include "../../common/trace.h"
+#include "../flight_recorder.h"
+#include "../metrics.h"
 
 #include <pthread.h>
 
+#include <algorithm>
 #include <utility>
 
 namespace cec_control {
 
-AdapterWorker::AdapterWorker(std::unique_ptr<ICecAdapter> adapter) noexcept
-    : m_adapter(std::move(adapter)) {}
+AdapterWorker::AdapterWorker(std::unique_ptr<ICecAdapter> adapter,
+                             std::size_t maxQueueDepth)
+    : m_adapter(std::move(adapter)),
+      m_maxQueueDepth(maxQueueDepth) {
+    for (std::size_t p = 0; p < kWorkPriorityCount; ++p) {
+        m_queues[p].reserve(kQueueReserve);
+        m_parked[p].reserve(kQueueReserve);
+    }
+}
 
 AdapterWorker::~AdapterWorker() {
     stop();
 }
 
-void AdapterWorker::start() {
+void AdapterWorker::start(ThreadSchedule schedule) {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_started) return;
     // Spawn before latching m_started: if std::thread's constructor
     // throws (resource exhaustion), the object stays in its unstarted
     // state and a later retry / destructor walks a consistent path.
-    m_thread  = std::thread(&AdapterWorker::run, this);
-    m_started = true;
+    m_schedule = std::move(schedule);
+    const ScopedThreadStack stack(m_schedule.stackKiB, "cec-adapter");
+    m_thread   = std::thread(&AdapterWorker::run, this);
+    m_started  = true;
 }
 
 void AdapterWorker::stop() {
@@ -42,52 +55,308 @@ void AdapterWorker::stop() {
     m_adapter.reset();
 }
 
-void AdapterWorker::submit(Job job) {
+void AdapterWorker::submit(Job job, WorkPriority priority) {
     if (!job) return;
+    TaskOptions options;
+    options.priority = priority;
+    const Admission admission = submitTask(
+        [job = std::move(job)](ICecAdapter& adapter) -> std::optional<TimePoint> {
+            job(adapter);
+            return std::nullopt;
+        },
+        std::move(options));
+    if (admission == Admission::QueueFull) {
+        LOG_WARNING("AdapterWorker queue full; dropping job");
+    }
+}
+
+AdapterWorker::Admission AdapterWorker::submitTask(Task task, TaskOptions options) {
+    if (!task) return Admission::Accepted;
+    OrderingLane lane  = options.lane;
+    LaneSet      lanes = options.alsoOn;
+    if (lane != kNoLane) {
+        lane = static_cast<OrderingLane>(lane % kLaneCount);
+        lanes |= static_cast<LaneSet>(1u << lane);
+    }
+    // The request's fields travel with the task; the subsystem is
+    // where the line is logged, so the worker keeps its own.
+    LogContext logContext = Logger::context();
+    logContext.subsystem = LogSubsystem::None;
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_stopRequested) return;
-        m_jobs.push(std::move(job));
+        if (m_stopRequested) return Admission::Stopped;
+        if (options.priority != WorkPriority::Lifecycle && m_maxQueueDepth > 0) {
+            std::size_t depth = 0;
+            for (std::size_t p = 0; p < kWorkPriorityCount; ++p) {
+                if (p != static_cast<std::size_t>(WorkPriority::Lifecycle)) {
+                    depth += m_queues[p].size();
+                }
+            }
+            if (depth >= m_maxQueueDepth) {
+                Metrics::getInstance().increment(Metrics::Counter::WorkerRejected);
+                return Admission::QueueFull;
+            }
+        }
+        m_queues[static_cast<std::size_t>(options.priority)].push_back(
+            Entry{std::move(task), lane, lanes, options.key,
+                  options.deadline, std::move(options.onExpired), Clock::now(),
+                  logContext, options.priority});
+        publishDepthLocked();
     }
+    Tracer::getInstance().instant(TracePoint::WorkerEnqueue,
+                                  static_cast<uint32_t>(options.priority));
     m_cv.notify_one();
+    return Admission::Accepted;
+}
+
+bool AdapterWorker::mergeIntoTail(WorkPriority priority,
+                                  CoalesceKey key,
+                                  const Merge& merge) {
+    if (key == kNoCoalesce || !merge) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Queue& queue = m_queues[static_cast<std::size_t>(priority)];
+    // A stopped worker drops its queue; merging into a job that will
+    // never run would swallow the caller's reply.
+    if (m_stopRequested || queue.empty() || queue.back().key != key) {
+        return false;
+    }
+    // Merging into a job about to be shed would only hand the new
+    // request the same RESP_ERROR later; let it start a fresh one.
+    const auto& deadline = queue.back().deadline;
+    if (deadline && *deadline < Clock::now()) return false;
+    merge();
+    return true;
 }
 
 bool AdapterWorker::isAdapterConnected() const noexcept {
     return m_adapter && m_adapter->isConnected();
 }
 
+AdapterWorker::Queue::iterator AdapterWorker::firstRunnable(Queue& queue) {
+    // Entries on a busy lane are skipped in place, so they keep their
+    // relative order for when the lane frees up. A skipped entry keeps
+    // its lanes from later entries too: one spanning several lanes
+    // must not be overtaken on a free one while it waits for the rest.
+    LaneSet held = m_busyLanes;
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if ((it->lanes & held) == 0) return it;
+        held |= it->lanes;
+    }
+    return queue.end();
+}
+
+void AdapterWorker::notePassedOver(std::size_t priority,
+                                   const Runnable& runnable) noexcept {
+    // Every lower class that could have run here was passed over.
+    for (std::size_t lower = priority + 1; lower < kWorkPriorityCount; ++lower) {
+        if (runnable[lower]) ++m_passedOver[lower];
+    }
+    m_passedOver[priority] = 0;
+}
+
+bool AdapterWorker::parkedDue(std::size_t priority, TimePoint now) const noexcept {
+    const auto& heap = m_parked[priority];
+    return !heap.empty() && heap.front().resumeAt <= now;
+}
+
+std::optional<AdapterWorker::TimePoint> AdapterWorker::nextResumeAt() const noexcept {
+    std::optional<TimePoint> next;
+    for (const auto& heap : m_parked) {
+        if (!heap.empty() && (!next || heap.front().resumeAt < *next)) {
+            next = heap.front().resumeAt;
+        }
+    }
+    return next;
+}
+
+void AdapterWorker::takeParked(std::size_t priority, const Runnable& runnable, Entry& out) {
+    notePassedOver(priority, runnable);
+    auto& heap = m_parked[priority];
+    std::pop_heap(heap.begin(), heap.end(), &AdapterWorker::laterThan);
+    Parked parked = std::move(heap.back());
+    heap.pop_back();
+    out = Entry{std::move(parked.task), parked.lane, parked.lanes, kNoCoalesce, {}, {}, {},
+                parked.logContext, static_cast<WorkPriority>(priority)};
+}
+
+void AdapterWorker::takeFrom(std::size_t priority, Queue::iterator it,
+                             const Runnable& runnable, Entry& out) {
+    notePassedOver(priority, runnable);
+
+    out = std::move(*it);
+    m_queues[priority].erase(it);
+    m_busyLanes |= out.lanes;
+    const TimePoint now = Clock::now();
+    Metrics::getInstance().record(Metrics::Latency::WorkerQueueWait, now - out.enqueuedAt);
+    Tracer::getInstance().complete(TracePoint::WorkerQueueWait, out.enqueuedAt, now,
+                                   static_cast<uint32_t>(priority));
+}
+
+void AdapterWorker::publishDepthLocked() const noexcept {
+    std::size_t depth = 0;
+    for (const Queue& queue : m_queues) depth += queue.size();
+    std::size_t parked = 0;
+    for (const auto& heap : m_parked) parked += heap.size();
+    auto& metrics = Metrics::getInstance();
+    metrics.set(Metrics::Gauge::WorkerQueueDepth, static_cast<int64_t>(depth));
+    metrics.set(Metrics::Gauge::WorkerParked, static_cast<int64_t>(parked));
+}
+
+AdapterWorker::Health AdapterWorker::health(TimePoint now) const {
+    Health health;
+    if (const Clock::rep started = m_sliceStartedAt.load(std::memory_order_relaxed)) {
+        health.callDuration =
+            std::max(now - TimePoint(Clock::duration(started)), Clock::duration::zero());
+    }
+    health.lastHeartbeat =
+        TimePoint(Clock::duration(m_heartbeat.load(std::memory_order_relaxed)));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const Queue& queue : m_queues) {
+        health.queued += queue.size();
+        // FIFO per class, so the front is the class's oldest entry.
+        if (!queue.empty()) {
+            health.oldestWait = std::max(health.oldestWait, now - queue.front().enqueuedAt);
+        }
+    }
+    for (const auto& heap : m_parked) health.parked += heap.size();
+    return health;
+}
+
+bool AdapterWorker::takeRunnable(Entry& out) {
+    constexpr auto kLifecycle = static_cast<std::size_t>(WorkPriority::Lifecycle);
+    const TimePoint now = Clock::now();
+
+    std::array<Queue::iterator, kWorkPriorityCount> ready;
+    Runnable runnable{};
+    for (std::size_t p = 0; p < kWorkPriorityCount; ++p) {
+        ready[p]    = firstRunnable(m_queues[p]);
+        runnable[p] = ready[p] != m_queues[p].end() || parkedDue(p, now);
+    }
+
+    // Within a class, started work goes first: a due parked task is
+    // mid-command (between press and release, past its retry back-off,
+    // or between the steps of a long job) and holds its lane until it
+    // finishes.
+    auto takeClass = [&](std::size_t p) {
+        if (parkedDue(p, now)) {
+            takeParked(p, runnable, out);
+        } else {
+            takeFrom(p, ready[p], runnable, out);
+        }
+    };
+
+    // A class passed over too often runs next, lowest class first so a
+    // starved Background scan is not starved again by Interactive.
+    for (std::size_t p = kWorkPriorityCount; p-- > 0;) {
+        if (runnable[p] && m_passedOver[p] >= kStarvationLimit) {
+            takeClass(p);
+            return true;
+        }
+    }
+
+    // Lifecycle entries jump even started work: suspend prep is bounded
+    // by logind's inhibitor delay, and a parked command merely sits a
+    // little past its slot.
+    if (ready[kLifecycle] != m_queues[kLifecycle].end()) {
+        takeFrom(kLifecycle, ready[kLifecycle], runnable, out);
+        return true;
+    }
+
+    // Otherwise the highest class with anything to run. A parked task
+    // of a lower class waits here, which is what lets a yielding scan
+    // step aside for a fresh command.
+    for (std::size_t p = 0; p < kWorkPriorityCount; ++p) {
+        if (runnable[p]) {
+            takeClass(p);
+            return true;
+        }
+    }
+    return false;
+}
+
 void AdapterWorker::run() {
     // Make the thread identifiable in `top -H`, `gdb thread apply all`,
     // etc. The name is silently truncated to 15 bytes by the kernel.
     ::pthread_setname_np(::pthread_self(), "cec-adapter");
+    const LogContextScope logContext(LogContext{LogSubsystem::Adapter});
+    if (!m_schedule.isDefault()) applyThreadSchedule(m_schedule, "cec-adapter");
 
     while (true) {
-        Job job;
+        Entry current;
         {
             std::unique_lock<std::mutex> lock(m_mutex);
-            m_cv.wait(lock, [this] {
-                return m_stopRequested || !m_jobs.empty();
-            });
-            if (m_stopRequested) {
-                // Drop pending jobs on stop. Their completions (if any)
-                // would land on a main-thread work queue no one is
-                // draining — executing them would burn libcec time to
-                // produce closures that are immediately destructed.
-                std::queue<Job> dropped;
-                dropped.swap(m_jobs);
+            bool runnable = false;
+            while (!m_stopRequested && !(runnable = takeRunnable(current))) {
+                if (const auto resumeAt = nextResumeAt()) {
+                    m_cv.wait_until(lock, *resumeAt);
+                } else {
+                    m_cv.wait(lock);
+                }
+            }
+            publishDepthLocked();
+            if (!runnable) {
+                // Drop pending and parked jobs on stop. Their
+                // completions (if any) would land on a main-thread work
+                // queue no one is draining — executing them would burn
+                // libcec time to produce closures that are immediately
+                // destructed.
+                std::array<Queue, kWorkPriorityCount> dropped;
+                dropped.swap(m_queues);
+                std::array<std::vector<Parked>, kWorkPriorityCount> droppedParked;
+                droppedParked.swap(m_parked);
                 break;
             }
-            job = std::move(m_jobs.front());
-            m_jobs.pop();
         }
 
+        // Only fresh entries carry a deadline; parked slices were
+        // reconstructed without one.
+        const bool expired = current.deadline && *current.deadline < Clock::now();
+
+        std::optional<TimePoint> resumeAt;
+        const LogContextScope logContext(current.logContext);
+        const auto sliceStart = Clock::now();
+        m_sliceStartedAt.store(sliceStart.time_since_epoch().count(),
+                               std::memory_order_relaxed);
+        FlightRecorder& flight = FlightRecorder::getInstance();
+        const auto priority = static_cast<uint8_t>(current.priority);
+        flight.jobStart(priority, current.lane);
+        flight_log::JobOutcome outcome = flight_log::JobOutcome::Done;
         try {
-            job(*m_adapter);
+            if (expired) {
+                outcome = flight_log::JobOutcome::Expired;
+                Metrics::getInstance().increment(Metrics::Counter::WorkerExpired);
+                if (current.onExpired) current.onExpired();
+            } else {
+                const TraceScope span(TracePoint::WorkerTask, current.lane);
+                resumeAt = current.task(*m_adapter);
+                if (resumeAt) outcome = flight_log::JobOutcome::Parked;
+            }
         } catch (const std::exception& e) {
+            outcome = flight_log::JobOutcome::Threw;
             LOG_ERROR("AdapterWorker job threw: ", e.what());
         } catch (...) {
+            outcome = flight_log::JobOutcome::Threw;
             LOG_ERROR("AdapterWorker job threw non-std exception");
         }
+        const auto sliceEnd = Clock::now();
+        flight.jobEnd(priority, current.lane, outcome,
+                      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                          sliceEnd - sliceStart).count()));
+        m_heartbeat.store(sliceEnd.time_since_epoch().count(), std::memory_order_relaxed);
+        m_sliceStartedAt.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (resumeAt) {
+            auto& heap = m_parked[static_cast<std::size_t>(current.priority)];
+            heap.push_back(Parked{*resumeAt, m_parkSeq++,
+                                  std::move(current.task), current.lane,
+                                  current.lanes, current.logContext});
+            std::push_heap(heap.begin(), heap.end(), &AdapterWorker::laterThan);
+            publishDepthLocked();
+        } else {
+            m_busyLanes &= static_cast<LaneSet>(~current.lanes);
+        }
     }
 
     // Final action on the worker thread: close the adapter so libcec's
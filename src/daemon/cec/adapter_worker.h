@@ -1,13 +1,23 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
 #include <thread>
+#include <vector>
 
+#include "../../common/inline_function.h"
+#include "../../common/logger.h"
+#include "../../common/ring_queue.h"
+#include "../thread_schedule.h"
 #include "adapter_interface.h"
+#include "work_priority.h"
 
 namespace cec_control {
 
@@ -16,8 +26,43 @@ namespace cec_control {
  * @brief Actor that owns an @c ICecAdapter and is the sole thread
  *        authorised to talk to it.
  *
- * Every libcec call travels through @c submit(). The worker thread
- * dequeues jobs FIFO and runs each with exclusive adapter access.
+ * Every libcec call travels through @c submit() / @c submitTask(). The
+ * worker thread dequeues jobs FIFO and runs each with exclusive adapter
+ * access.
+ *
+ * ## Scheduling
+ *
+ * A @c Task is a resumable job: each invocation runs one slice and
+ * either finishes or returns the instant it wants to run again (a
+ * throttle slot, a retry back-off, a key-release gap). The worker parks
+ * such a task on a deadline heap and keeps serving ready work; the
+ * thread never sleeps on behalf of one command while another is
+ * runnable. A long job that returns @c Clock::now() between steps
+ * yields the same way: it is preempted by anything of a higher class
+ * and resumed afterwards, so an urgent command waits for at most one
+ * step of it, not the whole job.
+ *
+ * Queued entries are split by @c WorkPriority, and a parked task keeps
+ * the class it was submitted with. Lifecycle entries run first, ahead
+ * even of due parked tasks, so suspend prep never waits behind queued
+ * volume spam. After that, classes are served in order, and within a
+ * class the due parked tasks run before fresh entries, so a pending key
+ * release is not held up by a queue of new requests. A parked
+ * Background scan therefore still yields to a fresh Interactive
+ * command. To keep a sustained stream of higher-class work from
+ * starving the rest, each class counts how many times it had runnable
+ * work but was passed over; at @c kStarvationLimit it runs next
+ * regardless of class, started work first.
+ *
+ * Ordering is preserved per @c OrderingLane (one per CEC logical
+ * address): while a task on lane N is parked, later lane-N entries stay
+ * queued in submission order and are skipped over, not reordered;
+ * entries on other lanes proceed. @c kNoLane entries (lifecycle work,
+ * plain @c Job submissions) are never held back by a parked task. A
+ * task spanning destinations (a batch or scene) is ordered on each lane
+ * it touches: it waits until all of them are free, later entries on any
+ * of them wait behind it while it is queued, and it holds them all
+ * until it finishes, parked pauses included.
  *
  * Ownership of the adapter is co-terminous with the worker: the adapter
  * is closed on the worker thread as its exit step, and the
@@ -36,8 +81,9 @@ namespace cec_control {
  *
  * ## Thread-safety contract
  *
- *  - @c submit() is safe to call from any thread. After @c stop() it
- *    silently drops; there is no back-pressure signal.
+ *  - @c submit() and @c mergeIntoTail() are safe to call from any
+ *    thread. After @c stop() a submit silently drops and a merge
+ *    reports @c false; there is no back-pressure signal.
  *  - @c start() / @c stop() must be called on the main thread (the
  *    thread that constructed and will destruct this object).
  *  - @c isAdapterConnected() is main-thread only. The underlying
@@ -46,6 +92,38 @@ namespace cec_control {
  *    because it is only reset from @c stop() after the worker thread
  *    has been joined.
  *
+ * ## Tail coalescing
+ *
+ * A job may be submitted with a non-zero @c CoalesceKey. A later
+ * @c mergeIntoTail with the same key folds new work into that job
+ * instead of queueing another one, provided the keyed job is still
+ * the last entry in its priority class's FIFO and has not been
+ * dequeued. "Adjacent" is therefore exact: anything submitted to that
+ * class in between breaks the run, so merging never reorders work
+ * across an unrelated job. The worker knows nothing
+ * about what a key means; the submitter owns the merge semantics.
+ *
+ * ## Admission and shedding
+ *
+ * Interactive and Background entries share a queue-depth cap; a task
+ * submitted past it is refused (@c Admission::QueueFull) so the
+ * submitter can answer the client "busy" instead of queueing work
+ * that would be stale by the time it ran. Lifecycle entries are never
+ * refused. A task may also carry a deadline: if it is still queued
+ * when the deadline passes, it is dropped at dequeue and its
+ * @c onExpired hook runs in its place, on the worker thread and
+ * without touching the adapter. Parked tasks have already started and
+ * are never shed.
+ *
+ * ## Health
+ *
+ * The worker stamps the start of every slice and, when the slice
+ * returns, the time it finished (its heartbeat). @c health reads those
+ * stamps together with the age of the oldest queued entry, so the
+ * main thread can tell a worker that is idle or making progress from
+ * one wedged inside a libcec call: the systemd watchdog only pings
+ * while both are under their limits (see @c CECDaemon::onWatchdogTimerFired).
+ *
  * ## Non-goals
  *
  * This class does @b not own a main-thread work queue. Jobs that need
@@ -56,12 +134,112 @@ namespace cec_control {
  */
 class AdapterWorker {
 public:
+    /**
+     * Capture bytes a queued closure may carry, sized to today's
+     * largest submitters: a command task holding its request, sink and
+     * in-flight throttled command; a lifecycle job; an expiry hook
+     * holding a sink and the state change it settles; a coalescing
+     * merge holding references to its batch and sink. A closure over
+     * its limit fails to compile.
+     */
+    static constexpr std::size_t kJobCapacity    = 96;
+    static constexpr std::size_t kTaskCapacity   = 192;
+    static constexpr std::size_t kExpiryCapacity = 56;
+    static constexpr std::size_t kMergeCapacity  = 32;
+
     /**
      * Unit of blocking adapter work. The reference is valid for the
      * duration of the call only; do not store it or pass it to another
      * thread.
      */
-    using Job = std::function<void(ICecAdapter&)>;
+    using Job = InlineFunction<void(ICecAdapter&), kJobCapacity>;
+
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    /**
+     * Resumable unit of adapter work. Returns the instant at which it
+     * must be invoked again, or @c std::nullopt once finished. The
+     * same adapter-reference rule as @c Job applies to each slice.
+     */
+    using Task = InlineFunction<std::optional<TimePoint>(ICecAdapter&), kTaskCapacity>;
+
+    /** Stand-in for an expired task; see @c TaskOptions::onExpired. */
+    using ExpiryHook = InlineFunction<void(), kExpiryCapacity>;
+
+    /** Fold-in for a still-queued job; see @c mergeIntoTail. */
+    using Merge = InlineFunction<void(), kMergeCapacity>;
+
+    /**
+     * Per-destination ordering domain for @c submitTask. Values
+     * 0..kLaneCount-1 are CEC logical addresses; @c kNoLane opts out.
+     */
+    using OrderingLane = uint8_t;
+    static constexpr std::size_t  kLaneCount = 16;
+    static constexpr OrderingLane kNoLane    = 0xFF;
+
+    /** Set of ordering lanes, bit N for lane N. */
+    using LaneSet = uint16_t;
+    static_assert(kLaneCount <= 16, "LaneSet holds one bit per lane");
+
+    /**
+     * Entries each class's queue and parked heap are allocated for at
+     * construction; they allocate again only past it.
+     */
+    static constexpr std::size_t kQueueReserve = 32;
+
+    /**
+     * Times a class with a runnable entry may be passed over in favour
+     * of a higher class before it is served out of turn.
+     */
+    static constexpr uint32_t kStarvationLimit = 8;
+
+    /**
+     * Opaque tag identifying jobs that may absorb later work. Zero
+     * (@c kNoCoalesce) marks an ordinary job that never merges.
+     */
+    using CoalesceKey = uint32_t;
+    static constexpr CoalesceKey kNoCoalesce = 0;
+
+    /** Scheduling attributes of a @c submitTask entry. */
+    struct TaskOptions {
+        OrderingLane lane     = kNoLane;
+        /**
+         * Further lanes the task is ordered on, for work that spans
+         * destinations; each is treated as @c lane is.
+         */
+        LaneSet      alsoOn   = 0;
+        WorkPriority priority = WorkPriority::Interactive;
+        CoalesceKey  key      = kNoCoalesce;
+        /** Latest instant at which the task may still start. */
+        std::optional<TimePoint> deadline;
+        /**
+         * Runs instead of the task if @c deadline passes while it is
+         * queued. Worker thread; must not touch the adapter.
+         */
+        ExpiryHook onExpired;
+    };
+
+    /** Progress of the worker at one instant; see @c health. */
+    struct Health {
+        /** Time the running slice has spent inside the adapter; zero when idle. */
+        Clock::duration callDuration{};
+        /** Age of the oldest queued entry; zero when nothing is queued. */
+        Clock::duration oldestWait{};
+        /** Queued entries, every class. */
+        std::size_t     queued = 0;
+        /** Started tasks waiting to resume. */
+        std::size_t     parked = 0;
+        /** When the last slice finished; @c TimePoint{} before the first. */
+        TimePoint       lastHeartbeat{};
+    };
+
+    /** Outcome of @c submitTask. */
+    enum class Admission {
+        Accepted,
+        QueueFull,  ///< Depth cap reached; the task was not queued.
+        Stopped,    ///< @c stop() has run; the task was not queued.
+    };
 
     /**
      * Take ownership of an adapter. Typical pattern: the caller runs
@@ -69,8 +247,12 @@ public:
      * (libcec's Open is thread-identity-agnostic) and hands the opened
      * adapter in. The worker is the sole thread that invokes any other
      * adapter method; it closes the connection as its exit step.
+     *
+     * @param maxQueueDepth Cap on queued Interactive + Background
+     *                      entries; 0 means unbounded.
      */
-    explicit AdapterWorker(std::unique_ptr<ICecAdapter> adapter) noexcept;
+    explicit AdapterWorker(std::unique_ptr<ICecAdapter> adapter,
+                           std::size_t maxQueueDepth = 0);
 
     /** Blocks on @c stop() if the worker is still running. */
     ~AdapterWorker();
@@ -80,12 +262,18 @@ public:
     AdapterWorker(AdapterWorker&&)                 = delete;
     AdapterWorker& operator=(AdapterWorker&&)      = delete;
 
-    /** Spawn the worker thread. Idempotent. */
-    void start();
+    /**
+     * Spawn the worker thread, with a stack of @p schedule's
+     * @c stackKiB, which applies @p schedule to itself before taking
+     * its first job. libcec threads a reopen starts from the worker
+     * inherit the scheduling, not the stack size. Idempotent.
+     */
+    void start(ThreadSchedule schedule = {});
 
     /**
-     * Signal stop; the worker finishes the in-flight job, drops any
-     * queued jobs, closes the adapter on the worker thread, and exits.
+     * Signal stop; the worker finishes the in-flight slice, drops any
+     * queued and parked jobs, closes the adapter on the worker
+     * thread, and exits.
      * Blocks on join. Subsequent @c submit() calls are silently dropped.
      * Idempotent; safe to call from the destructor.
      */
@@ -93,11 +281,36 @@ public:
 
     /**
      * Enqueue a job. Main-thread callers dominate but any thread is
-     * safe. Silently drops after @c stop() — the caller must treat this
-     * as fire-and-forget unless the job itself arranges a completion
-     * hop.
+     * safe. Silently drops after @c stop(), and (with a warning) when a
+     * non-Lifecycle job meets a full queue — the caller must treat
+     * this as fire-and-forget unless the job itself arranges a
+     * completion hop.
+     */
+    void submit(Job job, WorkPriority priority = WorkPriority::Interactive);
+
+    /**
+     * Enqueue a resumable task with @p options. Same thread-safety as
+     * @c submit; unlike it, reports refusal instead of dropping
+     * silently. Lanes above @c kLaneCount other than @c kNoLane fold
+     * onto their low nibble.
+     */
+    [[nodiscard]] Admission submitTask(Task task, TaskOptions options);
+
+    /**
+     * If the last queued job of class @p priority carries @p key
+     * (non-zero), has not yet been dequeued, and is not past its
+     * deadline, invoke @p merge under the queue lock and return
+     * @c true; otherwise return @c false and leave the queue untouched.
+     *
+     * Because @p merge runs while the job is provably still queued, any
+     * state it mutates is published to the worker thread by the same
+     * lock that later dequeues the job — the submitter needs no extra
+     * synchronisation for state shared with that job. @p merge must be
+     * short and must not call back into the worker.
      */
-    void submit(Job job);
+    [[nodiscard]] bool mergeIntoTail(WorkPriority priority,
+                                     CoalesceKey key,
+                                     const Merge& merge);
 
     /**
      * Main-thread cheap read of the adapter's connection hint. Returns
@@ -105,14 +318,102 @@ public:
      */
     [[nodiscard]] bool isAdapterConnected() const noexcept;
 
+    /**
+     * Snapshot of the worker's progress as of @p now. Any thread; takes
+     * the queue lock briefly, never waits for the running slice.
+     */
+    [[nodiscard]] Health health(TimePoint now = Clock::now()) const;
+
 private:
+    struct Entry {
+        Task                     task;
+        OrderingLane             lane  = kNoLane;  ///< Reported in traces and the flight log.
+        LaneSet                  lanes = 0;        ///< Every lane the entry is ordered on.
+        CoalesceKey              key   = kNoCoalesce;
+        std::optional<TimePoint> deadline;
+        ExpiryHook               onExpired;
+        TimePoint                enqueuedAt{};  ///< For the queue-wait histogram.
+        LogContext               logContext{};  ///< The submitter's, for the task's lines.
+        WorkPriority             priority = WorkPriority::Interactive;
+    };
+
+    /** A started task waiting for its deadline. */
+    struct Parked {
+        TimePoint    resumeAt;
+        uint64_t     seq;   ///< FIFO tie-break for equal deadlines.
+        Task         task;
+        OrderingLane lane;
+        LaneSet      lanes;
+        LogContext   logContext;
+    };
+
+    /** Per-class runnable flags for one scheduling decision. */
+    using Runnable = std::array<bool, kWorkPriorityCount>;
+
+    /** Min-heap order on (resumeAt, seq) for std::push_heap / pop_heap. */
+    static bool laterThan(const Parked& a, const Parked& b) noexcept {
+        if (a.resumeAt != b.resumeAt) return a.resumeAt > b.resumeAt;
+        return a.seq > b.seq;
+    }
+
+    using Queue = RingQueue<Entry>;
+
+    /**
+     * Under @c m_mutex: take the next runnable unit per the class
+     * order and anti-starvation rule in the class doc. Returns
+     * @c false if nothing is runnable yet.
+     */
+    bool takeRunnable(Entry& out);
+
+    /**
+     * Under @c m_mutex: oldest entry of @p queue whose lanes are free
+     * and not wanted by an older entry still waiting in it.
+     */
+    Queue::iterator firstRunnable(Queue& queue);
+
+    /**
+     * Under @c m_mutex: move @p it out of class @p priority's queue
+     * into @p out, claim its lane, and update the starvation counters
+     * against the other classes' @p runnable work.
+     */
+    void takeFrom(std::size_t priority, Queue::iterator it,
+                  const Runnable& runnable, Entry& out);
+
+    /** Under @c m_mutex: as @c takeFrom, for class @p priority's earliest parked task. */
+    void takeParked(std::size_t priority, const Runnable& runnable, Entry& out);
+
+    /** Under @c m_mutex: count a pass-over for every lower runnable class. */
+    void notePassedOver(std::size_t priority, const Runnable& runnable) noexcept;
+
+    /** Under @c m_mutex: whether class @p priority has a parked task due by @p now. */
+    [[nodiscard]] bool parkedDue(std::size_t priority, TimePoint now) const noexcept;
+
+    /** Under @c m_mutex: earliest resume instant across the parked heaps. */
+    [[nodiscard]] std::optional<TimePoint> nextResumeAt() const noexcept;
+
+    /** Under @c m_mutex: publish queue and parked depth to @c Metrics. */
+    void publishDepthLocked() const noexcept;
+
     void run();
 
     std::unique_ptr<ICecAdapter> m_adapter;
+    const std::size_t            m_maxQueueDepth;
+    // Written by start() before the thread exists; read by it once.
+    ThreadSchedule               m_schedule;
 
     mutable std::mutex      m_mutex;
     std::condition_variable m_cv;
-    std::queue<Job>         m_jobs;
+    std::array<Queue, kWorkPriorityCount>    m_queues;
+    std::array<uint32_t, kWorkPriorityCount> m_passedOver{};
+    // One heap per class, each ordered by laterThan.
+    std::array<std::vector<Parked>, kWorkPriorityCount> m_parked;
+    LaneSet                 m_busyLanes = 0;
+    uint64_t                m_parkSeq = 0;
+    // Steady-clock ticks, written by the worker thread around each
+    // slice and read lock-free by health(). Zero in m_sliceStartedAt
+    // means no slice is running.
+    std::atomic<Clock::rep> m_sliceStartedAt{0};
+    std::atomic<Clock::rep> m_heartbeat{0};
     bool                    m_stopRequested = false;
     bool                    m_started       = false;
 
@@ -0,0 +1,171 @@
+#include "frame_decoder.h"
+
+#include "../../common/logger.h"
+
+namespace cec_control {
+
+namespace {
+
+using Observation = ICecAdapter::Observation;
+
+// Physical addresses are 16 bits, big-endian on the wire.
+uint16_t physicalAt(const RawFrame& frame, std::size_t offset) noexcept {
+    return static_cast<uint16_t>((static_cast<uint16_t>(frame.parameters[offset]) << 8) |
+                                  static_cast<uint16_t>(frame.parameters[offset + 1]));
+}
+
+void putPhysical(RawFrame& frame, std::size_t offset, uint16_t address) noexcept {
+    frame.parameters[offset]     = static_cast<uint8_t>(address >> 8);
+    frame.parameters[offset + 1] = static_cast<uint8_t>(address & 0xFF);
+}
+
+} // namespace
+
+void decodeFrame(const RawFrame& frame, const FrameFilter* frames,
+                 const FrameFilter* rawFrames,
+                 const std::function<void(Observation)>& deliver) {
+    // Most of the bus is polls and chatter no consumer wants: drop it
+    // here, ahead of every other cost on this thread. libcec's own
+    // TRAFFIC log line still records the frame.
+    if (frames && !frames->accepts(frame.initiator, frame.opcode)) return;
+
+    const auto initiator = static_cast<CEC::cec_logical_address>(frame.initiator);
+    const LogContextScope logContext(LogContext{LogSubsystem::Libcec, static_cast<int>(initiator)});
+    LOG_DEBUG("CEC command received: initiator=", static_cast<int>(frame.initiator),
+              ", destination=", static_cast<int>(frame.destination),
+              ", opcode=", static_cast<int>(frame.opcode));
+
+    if (!deliver) return;
+
+    // Raw subscribers see the frame whole, before and regardless of
+    // the typed filter below.
+    if (rawFrames && rawFrames->accepts(frame.initiator, frame.opcode)) {
+        Observation obs;
+        obs.kind    = Observation::Kind::RawFrame;
+        obs.logical = initiator;
+        obs.frame   = frame;
+        deliver(obs);
+    }
+
+    // A small set of opcodes is surfaced to the daemon as typed
+    // Observations; every other bus command is ignored here. Keeping
+    // the filter narrow is the whole point of doing it on this thread:
+    // daemon-side subscribers run single-threaded on the main loop and
+    // should not need to re-filter the stream.
+    //
+    // ACTIVE_SOURCE, ROUTING_CHANGE and SET_STREAM_PATH all collapse
+    // to Observation::Kind::ActiveSource — each announces the new
+    // active source in a different way, and the hook subsystem's
+    // dedup collapses any redundant back-to-back emissions. We have
+    // to watch all three: when a routing change makes *this* host the
+    // active source, libcec sends ACTIVE_SOURCE on our behalf, but
+    // that outgoing frame never reaches commandReceived — only the
+    // upstream ROUTING_CHANGE / SET_STREAM_PATH does.
+    const std::size_t params = frame.parameterCount;
+
+    auto emitActiveSource = [&](std::size_t offset, CEC::cec_logical_address announcer) {
+        Observation obs;
+        obs.kind            = Observation::Kind::ActiveSource;
+        obs.logical         = announcer;
+        obs.physicalAddress = physicalAt(frame, offset);
+        deliver(obs);
+    };
+
+    if (initiator == CEC::CECDEVICE_TV && frame.opcode == CEC::CEC_OPCODE_STANDBY) {
+        LOG_INFO("TV standby opcode observed");
+        Observation obs;
+        obs.kind = Observation::Kind::TvStandby;
+        deliver(obs);
+        return;
+    }
+
+    if (initiator == CEC::CECDEVICE_TV &&
+        frame.opcode == CEC::CEC_OPCODE_REPORT_POWER_STATUS && params >= 1) {
+        Observation obs;
+        obs.kind  = Observation::Kind::TvPowerReport;
+        obs.power = static_cast<CEC::cec_power_status>(frame.parameters[0]);
+        deliver(obs);
+        return;
+    }
+
+    if (frame.opcode == CEC::CEC_OPCODE_REPORT_POWER_STATUS && params >= 1) {
+        Observation obs;
+        obs.kind    = Observation::Kind::PowerReport;
+        obs.power   = static_cast<CEC::cec_power_status>(frame.parameters[0]);
+        obs.logical = initiator;
+        deliver(obs);
+        return;
+    }
+
+    // REPORT_PHYSICAL_ADDRESS payload: address in [0..1], device type in
+    // [2]; only the address is surfaced.
+    if (frame.opcode == CEC::CEC_OPCODE_REPORT_PHYSICAL_ADDRESS && params >= 2) {
+        Observation obs;
+        obs.kind            = Observation::Kind::PhysicalAddressReport;
+        obs.physicalAddress = physicalAt(frame, 0);
+        obs.logical         = initiator;
+        deliver(obs);
+        return;
+    }
+
+    if (frame.opcode == CEC::CEC_OPCODE_ACTIVE_SOURCE && params >= 2) {
+        emitActiveSource(0, initiator);
+        return;
+    }
+
+    // ROUTING_CHANGE payload: old address in [0..1], new address in
+    // [2..3]; we only care about the new path.
+    if (frame.opcode == CEC::CEC_OPCODE_ROUTING_CHANGE && params >= 4) {
+        emitActiveSource(2, CEC::CECDEVICE_UNKNOWN);
+        return;
+    }
+
+    // SET_STREAM_PATH payload: new active address in [0..1].
+    if (frame.opcode == CEC::CEC_OPCODE_SET_STREAM_PATH && params >= 2) {
+        emitActiveSource(0, CEC::CECDEVICE_UNKNOWN);
+        return;
+    }
+}
+
+std::optional<RawFrame> frameFor(const Observation& obs) noexcept {
+    RawFrame frame;
+    frame.initiator = static_cast<uint8_t>(obs.logical);
+    switch (obs.kind) {
+    case Observation::Kind::TvStandby:
+        frame.initiator = CEC::CECDEVICE_TV;
+        frame.opcode    = CEC::CEC_OPCODE_STANDBY;
+        return frame;
+    case Observation::Kind::TvPowerReport:
+        frame.initiator = CEC::CECDEVICE_TV;
+        [[fallthrough]];
+    case Observation::Kind::PowerReport:
+        frame.destination    = CEC::CECDEVICE_PLAYBACKDEVICE1;
+        frame.opcode         = CEC::CEC_OPCODE_REPORT_POWER_STATUS;
+        frame.parameterCount = 1;
+        frame.parameters[0]  = static_cast<uint8_t>(obs.power);
+        return frame;
+    case Observation::Kind::PhysicalAddressReport:
+        frame.opcode         = CEC::CEC_OPCODE_REPORT_PHYSICAL_ADDRESS;
+        frame.parameterCount = 3;
+        putPhysical(frame, 0, obs.physicalAddress);
+        return frame;
+    case Observation::Kind::ActiveSource:
+        // Without a named announcer the path came in a <Set Stream Path>.
+        if (obs.logical == CEC::CECDEVICE_UNKNOWN) {
+            frame.initiator = CEC::CECDEVICE_TV;
+            frame.opcode    = CEC::CEC_OPCODE_SET_STREAM_PATH;
+        } else {
+            frame.opcode = CEC::CEC_OPCODE_ACTIVE_SOURCE;
+        }
+        frame.parameterCount = 2;
+        putPhysical(frame, 0, obs.physicalAddress);
+        return frame;
+    case Observation::Kind::HostActivated:
+    case Observation::Kind::HostDeactivated:
+    case Observation::Kind::RawFrame:
+        break;
+    }
+    return std::nullopt;
+}
+
+} // namespace cec_control
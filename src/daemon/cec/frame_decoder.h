@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+
+#include "../../common/messages.h"
+#include "adapter_interface.h"
+#include "frame_filter.h"
+
+namespace cec_control {
+
+/**
+ * Turn one received frame into the observations the daemon takes from
+ * it, as every backend's receive path does: drop it unless @p frames
+ * accepts it (null accepts all), deliver it whole as a
+ * @c Kind::RawFrame if @p rawFrames accepts it, then deliver the typed
+ * observation it decodes to, if any. Runs on the caller's thread and
+ * calls @p deliver there; @p deliver may be empty.
+ */
+void decodeFrame(const RawFrame& frame, const FrameFilter* frames,
+                 const FrameFilter* rawFrames,
+                 const std::function<void(ICecAdapter::Observation)>& deliver);
+
+/**
+ * The frame a device sends to announce @p obs, as @c decodeFrame would
+ * read it back; nullopt for the host's own activation edges and raw
+ * frames, which no single received frame carries. Lets a backend that
+ * models the bus as observations record the traffic it implies.
+ */
+[[nodiscard]] std::optional<RawFrame> frameFor(const ICecAdapter::Observation& obs) noexcept;
+
+} // namespace cec_control
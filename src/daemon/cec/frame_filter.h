@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace cec_control {
+
+/**
+ * @brief Which received CEC frames anyone in the daemon wants, as one
+ *        bit per (opcode, initiator) pair.
+ *
+ * The adapter's receive callback runs on libcec's bus thread for every
+ * frame on the wire, most of them polls and vendor chatter nothing
+ * consumes. The daemon publishes the frames its consumers need here
+ * and the callback drops the rest with one relaxed load and a shift,
+ * before it sets up logging or decodes anything.
+ *
+ * Written on the main thread with @c assign whenever what the
+ * consumers need changes, read from the backend's thread with
+ * @c accepts. Each 64-bit word (four opcodes) is stored atomically;
+ * a frame that races a rebuild sees either the old or the new bits of
+ * its own opcode, which is as good as arriving a moment earlier or
+ * later.
+ */
+class FrameFilter {
+public:
+    /** Per opcode, bit @c N set lets frames from initiator @c N through. */
+    using Table = std::array<uint16_t, 256>;
+
+    /** Every initiator, the broadcast address included. */
+    static constexpr uint16_t kAnyInitiator = 0xFFFF;
+
+    [[nodiscard]] bool accepts(uint8_t initiator, uint8_t opcode) const noexcept {
+        const uint64_t word = m_words[opcode >> 2].load(std::memory_order_relaxed);
+        return ((word >> ((opcode & 3u) * 16 + (initiator & 0x0Fu))) & 1u) != 0;
+    }
+
+    /** Replace every bit with @p table's. */
+    void assign(const Table& table) noexcept {
+        for (std::size_t w = 0; w < m_words.size(); ++w) {
+            uint64_t word = 0;
+            for (std::size_t i = 0; i < 4; ++i) {
+                word |= static_cast<uint64_t>(table[w * 4 + i]) << (i * 16);
+            }
+            m_words[w].store(word, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, 64> m_words{};
+};
+
+} // namespace cec_control
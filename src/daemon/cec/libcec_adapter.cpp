@@ -1,7 +1,12 @@
 #include "libcec_adapter.h"
 
 #include "../../common/logger.h"
+#include "../../common/system_paths.h"
+#include "../startup_report.h"
+#include "frame_decoder.h"
+#include "traffic_capture.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
@@ -33,12 +38,30 @@ LibCecAdapter::LibCecAdapter(AdapterConfig config, Callbacks callbacks)
     : m_config(std::move(config)),
       m_connected(false),
       m_observationCallback(std::move(callbacks.onObservation)),
-      m_connectionLostCallback(std::move(callbacks.onConnectionLost)) {
+      m_connectionLostCallback(std::move(callbacks.onConnectionLost)),
+      m_frameFilter(callbacks.frames),
+      m_rawFrameFilter(callbacks.rawFrames),
+      m_capture(callbacks.capture) {
 
     m_libcecConfig.Clear();
     m_libcecConfig.clientVersion = CEC::LIBCEC_VERSION_CURRENT;
     m_libcecConfig.deviceTypes.Add(CEC::CEC_DEVICE_TYPE_PLAYBACK_DEVICE);
+    applyConfig();
 
+    // m_callbacks is value-initialised so every slot starts nullptr;
+    // point libcec's config at it and install the handlers we care
+    // about. libcec reads these from its internal threads without a
+    // lock, which is safe because they are never reassigned after
+    // construction.
+    m_libcecConfig.callbacks    = &m_callbacks;
+    m_libcecConfig.callbackParam = this;
+    m_callbacks.logMessage      = &LibCecAdapter::cecLogCallback;
+    m_callbacks.commandReceived = &LibCecAdapter::cecCommandCallback;
+    m_callbacks.alert           = &LibCecAdapter::cecAlertCallback;
+    m_callbacks.sourceActivated = &LibCecAdapter::cecSourceActivatedCallback;
+}
+
+void LibCecAdapter::applyConfig() {
     std::snprintf(m_libcecConfig.strDeviceName,
                   sizeof(m_libcecConfig.strDeviceName),
                   "%s", m_config.deviceName.c_str());
@@ -52,18 +75,6 @@ LibCecAdapter::LibCecAdapter(AdapterConfig config, Callbacks callbacks)
     m_libcecConfig.bActivateSource = m_config.activateSource ? 1 : 0;
     m_libcecConfig.wakeDevices     = m_config.wakeDevices;
     m_libcecConfig.powerOffDevices = m_config.powerOffDevices;
-
-    // m_callbacks is value-initialised so every slot starts nullptr;
-    // point libcec's config at it and install the handlers we care
-    // about. libcec reads these from its internal threads without a
-    // lock, which is safe because they are never reassigned after
-    // construction.
-    m_libcecConfig.callbacks    = &m_callbacks;
-    m_libcecConfig.callbackParam = this;
-    m_callbacks.logMessage      = &LibCecAdapter::cecLogCallback;
-    m_callbacks.commandReceived = &LibCecAdapter::cecCommandCallback;
-    m_callbacks.alert           = &LibCecAdapter::cecAlertCallback;
-    m_callbacks.sourceActivated = &LibCecAdapter::cecSourceActivatedCallback;
 }
 
 LibCecAdapter::~LibCecAdapter() {
@@ -79,6 +90,7 @@ LibCecAdapter::~LibCecAdapter() {
 
 bool LibCecAdapter::detectAdapter() {
     LOG_INFO("Detecting CEC adapters...");
+    const ScopedStartupPhase phase(StartupPhase::DetectAdapter);
     CEC::cec_adapter_descriptor devices[10];
     const int8_t numDevices = m_adapter->DetectAdapters(devices, 10, nullptr, true);
 
@@ -88,11 +100,46 @@ bool LibCecAdapter::detectAdapter() {
     }
 
     LOG_INFO("Found ", static_cast<int>(numDevices), " CEC adapter(s)");
-    m_portName = devices[0].strComName;
-    LOG_INFO("Will use adapter: ", m_portName);
+    for (int8_t i = 0; i < numDevices; ++i) {
+        const AdapterPort found{devices[i].strComName, devices[i].strComPath,
+                                devices[i].iVendorId, devices[i].iProductId};
+        if (!isConfiguredPort(found)) {
+            LOG_DEBUG("Skipping adapter ", found.comName, ": not the configured port");
+            continue;
+        }
+        m_portName      = found.comName;
+        m_detectedPort  = found;
+        m_portFromCache = false;
+        LOG_INFO("Will use adapter: ", m_portName);
+        return true;
+    }
+    LOG_ERROR("No CEC adapter found at the configured port ", m_config.port);
+    return false;
+}
+
+bool LibCecAdapter::isConfiguredPort(const AdapterPort& port) const {
+    return m_config.port.empty() || port.comName == m_config.port ||
+           port.comPath == m_config.port;
+}
+
+bool LibCecAdapter::useKnownPort() {
+    if (!m_knownPort) m_knownPort = loadAdapterPort(SystemPaths::getAdapterCachePath(m_config.name));
+    // A cached port from before Port was changed names another dongle.
+    if (!m_knownPort || !isConfiguredPort(*m_knownPort) ||
+        !adapterPortPresent(*m_knownPort)) {
+        return false;
+    }
+
+    m_portName = m_knownPort->comName;
+    m_portFromCache = true;
+    LOG_INFO("Using known CEC adapter port ", m_portName, "; skipping detection");
     return true;
 }
 
+bool LibCecAdapter::locateAdapter() {
+    return useKnownPort() || detectAdapter();
+}
+
 bool LibCecAdapter::initialize() {
     LOG_INFO("Initializing libCEC");
     if (m_adapter) {
@@ -100,7 +147,10 @@ bool LibCecAdapter::initialize() {
         return true;
     }
 
-    m_adapter = AdapterPtr(::CECInitialise(&m_libcecConfig));
+    {
+        const ScopedStartupPhase phase(StartupPhase::LibcecInit);
+        m_adapter = AdapterPtr(::CECInitialise(&m_libcecConfig));
+    }
     if (!m_adapter) {
         LOG_ERROR("Failed to initialize libCEC - CECInitialise returned null");
         return false;
@@ -109,7 +159,7 @@ bool LibCecAdapter::initialize() {
     LOG_INFO("libCEC initialized, version ",
              m_adapter->VersionToString(m_libcecConfig.clientVersion));
 
-    if (!detectAdapter()) {
+    if (!locateAdapter()) {
         m_adapter.reset();
         return false;
     }
@@ -135,6 +185,39 @@ bool LibCecAdapter::openConnection() {
         return false;
     }
 
+    if (openPort()) {
+        if (!m_portFromCache) {
+            m_knownPort = m_detectedPort;
+            saveAdapterPort(SystemPaths::getAdapterCachePath(m_config.name), *m_knownPort);
+        }
+        return true;
+    }
+    if (!m_portFromCache) return false;
+
+    // The known port did not open: the adapter moved to another node
+    // or something else took this one. Forget it and detect. A failed
+    // Open leaves the instance as unusable as a Close does (see
+    // reopenConnection), so start from a fresh one.
+    LOG_WARNING("Known CEC adapter port failed to open; detecting adapters");
+    m_knownPort.reset();
+    forgetAdapterPort(SystemPaths::getAdapterCachePath(m_config.name));
+    m_adapter.reset();
+    m_adapter = AdapterPtr(::CECInitialise(&m_libcecConfig));
+    if (!m_adapter) {
+        LOG_ERROR("Failed to re-initialise libCEC for detection");
+        return false;
+    }
+    if (!detectAdapter()) {
+        m_adapter.reset();
+        return false;
+    }
+    if (!openPort()) return false;
+    m_knownPort = m_detectedPort;
+    saveAdapterPort(SystemPaths::getAdapterCachePath(m_config.name), *m_knownPort);
+    return true;
+}
+
+bool LibCecAdapter::openPort() {
     try {
         // Apply configuration to the adapter before opening.
         if (!m_adapter->SetConfiguration(&m_libcecConfig)) {
@@ -142,7 +225,12 @@ bool LibCecAdapter::openConnection() {
         }
 
         LOG_INFO("Opening CEC adapter: ", m_portName);
-        if (!m_adapter->Open(m_portName.c_str(), kConnectTimeoutMs)) {
+        bool opened = false;
+        {
+            const ScopedStartupPhase phase(StartupPhase::AdapterOpen);
+            opened = m_adapter->Open(m_portName.c_str(), kConnectTimeoutMs);
+        }
+        if (!opened) {
             LOG_ERROR("Failed to open CEC adapter");
             return false;
         }
@@ -240,13 +328,16 @@ bool LibCecAdapter::reopenConnection() {
         std::this_thread::sleep_for(kUsbSettleDelay);
     }
 
+    // No libcec instance exists here, so a configuration replaced by
+    // reconfigure can be handed over without racing libcec's threads.
+    applyConfig();
     m_adapter = AdapterPtr(::CECInitialise(&m_libcecConfig));
     if (!m_adapter) {
         LOG_ERROR("Failed to re-initialise libCEC on reopen");
         return false;
     }
 
-    if (!detectAdapter()) {
+    if (!locateAdapter()) {
         LOG_ERROR("Failed to detect adapter during reopen");
         m_adapter.reset();
         return false;
@@ -255,10 +346,27 @@ bool LibCecAdapter::reopenConnection() {
     return openConnection();
 }
 
+void LibCecAdapter::enforceCallBudget(std::chrono::steady_clock::duration elapsed) const {
+    const uint32_t budgetMs = m_config.callBudgetMs;
+    if (budgetMs == 0 || elapsed <= std::chrono::milliseconds(budgetMs)) return;
+    // Only the first overrun of a connection reports it; the calls
+    // already past the pre-flight finish and find the hint cleared.
+    if (!m_connected.exchange(false, std::memory_order_acq_rel)) return;
+    LOG_ERROR("libcec call took ",
+              std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(),
+              " ms, over the ", budgetMs, " ms budget; treating the adapter as wedged");
+    Metrics::getInstance().increment(Metrics::Counter::CallBudgetExceeded);
+    if (m_connectionLostCallback) m_connectionLostCallback();
+}
+
 bool LibCecAdapter::isConnected() const {
     return m_connected.load(std::memory_order_acquire);
 }
 
+void LibCecAdapter::reconfigure(AdapterConfig config) {
+    m_config = std::move(config);
+}
+
 bool LibCecAdapter::powerOnDevice(CEC::cec_logical_address address) {
     return callIfConnected(false, [&] { return m_adapter->PowerOnDevices(address); });
 }
@@ -267,6 +375,15 @@ bool LibCecAdapter::standbyDevice(CEC::cec_logical_address address) {
     return callIfConnected(false, [&] { return m_adapter->StandbyDevices(address); });
 }
 
+bool LibCecAdapter::broadcastStandby() {
+    return callIfConnected(false, [&] {
+        CEC::cec_command command;
+        CEC::cec_command::Format(command, m_adapter->GetLogicalAddresses().primary,
+                                 CEC::CECDEVICE_BROADCAST, CEC::CEC_OPCODE_STANDBY);
+        return m_adapter->Transmit(command);
+    });
+}
+
 bool LibCecAdapter::volumeUp() {
     return callIfConnected(false, [&] { return m_adapter->VolumeUp(); });
 }
@@ -292,6 +409,29 @@ bool LibCecAdapter::setStreamPath(uint16_t physicalAddress) {
     return callIfConnected(false, [&] { return m_adapter->SetStreamPath(physicalAddress); });
 }
 
+bool LibCecAdapter::transmitRaw(const RawFrame& frame) {
+    return callIfConnected(false, [&] {
+        const CEC::cec_logical_addresses own = m_adapter->GetLogicalAddresses();
+        const auto initiator = frame.initiator == kLogicalAddressUnknown
+            ? own.primary
+            : static_cast<CEC::cec_logical_address>(frame.initiator & 0x0F);
+        // A client may not speak for another device on the bus.
+        if (!own.IsSet(initiator)) {
+            LOG_WARNING("Refusing raw frame from address ", static_cast<int>(initiator),
+                        ": not one the adapter claimed");
+            return false;
+        }
+        CEC::cec_command command;
+        CEC::cec_command::Format(command, initiator,
+                                 static_cast<CEC::cec_logical_address>(frame.destination & 0x0F),
+                                 static_cast<CEC::cec_opcode>(frame.opcode));
+        for (uint8_t i = 0; i < frame.parameterCount && i < kMaxRawParameters; ++i) {
+            command.parameters.PushBack(frame.parameters[i]);
+        }
+        return m_adapter->Transmit(command);
+    });
+}
+
 uint16_t LibCecAdapter::getDevicePhysicalAddress(CEC::cec_logical_address address) const {
     return callIfConnected(uint16_t{0},
         [&] { return m_adapter->GetDevicePhysicalAddress(address); });
@@ -311,6 +451,16 @@ std::string LibCecAdapter::getDeviceOSDName(CEC::cec_logical_address address) co
         [&] { return m_adapter->GetDeviceOSDName(address); });
 }
 
+uint32_t LibCecAdapter::getDeviceVendorId(CEC::cec_logical_address address) const {
+    return callIfConnected(uint32_t{CEC::CEC_VENDOR_UNKNOWN},
+        [&] { return m_adapter->GetDeviceVendorId(address); });
+}
+
+CEC::cec_version LibCecAdapter::getDeviceCecVersion(CEC::cec_logical_address address) const {
+    return callIfConnected(CEC::CEC_VERSION_UNKNOWN,
+        [&] { return m_adapter->GetDeviceCecVersion(address); });
+}
+
 CEC::cec_logical_addresses LibCecAdapter::getActiveDevices() const {
     CEC::cec_logical_addresses empty;
     empty.Clear();
@@ -322,16 +472,9 @@ CEC::cec_logical_address LibCecAdapter::getActiveSource() const {
         [&] { return m_adapter->GetActiveSource(); });
 }
 
-bool LibCecAdapter::standbyDevices(CEC::cec_logical_address address) {
-    // libcec automatically uses powerOffDevices list when
-    // CECDEVICE_BROADCAST is used.
-    return callIfConnected(false, [&] { return m_adapter->StandbyDevices(address); });
-}
-
-bool LibCecAdapter::powerOnDevices(CEC::cec_logical_address address) {
-    // libcec automatically uses wakeDevices list when
-    // CECDEVICE_BROADCAST is used.
-    return callIfConnected(false, [&] { return m_adapter->PowerOnDevices(address); });
+uint8_t LibCecAdapter::getAudioStatus() const {
+    return callIfConnected(uint8_t{CEC::CEC_AUDIO_VOLUME_STATUS_UNKNOWN},
+        [&] { return m_adapter->AudioStatus(); });
 }
 
 // libcec callback trampolines ----------------------------------------
@@ -351,7 +494,14 @@ void LibCecAdapter::cecLogCallback(void* cbParam,
         default:                   level = LogLevel::INFO;    break;
     }
 
-    Logger::getInstance().log(level, "CEC: ", message->message);
+    // libcec reports every message it generates, TRAFFIC for each bus
+    // frame; drop the ones nobody will write before any formatting.
+    if (level < kCompiledMinLevel ||
+        !Logger::getInstance().enabled(level, LogSubsystem::Libcec)) {
+        return;
+    }
+    const LogContextScope logContext(LogContext{LogSubsystem::Libcec});
+    Logger::getInstance().write(level, "CEC: ", message->message);
 }
 
 void LibCecAdapter::cecCommandCallback(void* cbParam,
@@ -359,78 +509,18 @@ void LibCecAdapter::cecCommandCallback(void* cbParam,
     auto* adapter = static_cast<LibCecAdapter*>(cbParam);
     if (!adapter || !command) return;
 
-    LOG_DEBUG("CEC command received: initiator=",
-              static_cast<int>(command->initiator),
-              ", destination=", static_cast<int>(command->destination),
-              ", opcode=", static_cast<int>(command->opcode));
-
-    if (!adapter->m_observationCallback) return;
-
-    // A small set of opcodes is surfaced to the daemon as typed
-    // Observations; every other bus command is ignored here. Keeping
-    // the filter narrow is the whole point of doing it on this thread:
-    // daemon-side subscribers run single-threaded on the main loop and
-    // should not need to re-filter the stream.
-    //
-    // ACTIVE_SOURCE, ROUTING_CHANGE and SET_STREAM_PATH all collapse
-    // to Observation::Kind::ActiveSource — each announces the new
-    // active source in a different way, and the hook subsystem's
-    // dedup collapses any redundant back-to-back emissions. We have
-    // to watch all three: when a routing change makes *this* host the
-    // active source, libcec sends ACTIVE_SOURCE on our behalf, but
-    // that outgoing frame never reaches commandReceived — only the
-    // upstream ROUTING_CHANGE / SET_STREAM_PATH does.
-    const auto& params = command->parameters;
-
-    auto emitActiveSource = [&](std::size_t offset) {
-        Observation obs;
-        obs.kind = Observation::Kind::ActiveSource;
-        // Physical address is 16 bits, big-endian on the wire.
-        obs.physicalAddress = static_cast<uint16_t>(
-            (static_cast<uint16_t>(params.data[offset])     << 8) |
-             static_cast<uint16_t>(params.data[offset + 1]));
-        adapter->m_observationCallback(obs);
-    };
-
-    if (command->initiator == CEC::CECDEVICE_TV &&
-        command->opcode == CEC::CEC_OPCODE_STANDBY) {
-        LOG_INFO("TV standby opcode observed");
-        Observation obs;
-        obs.kind = Observation::Kind::TvStandby;
-        adapter->m_observationCallback(obs);
-        return;
-    }
-
-    if (command->initiator == CEC::CECDEVICE_TV &&
-        command->opcode == CEC::CEC_OPCODE_REPORT_POWER_STATUS &&
-        params.size >= 1) {
-        Observation obs;
-        obs.kind  = Observation::Kind::TvPowerReport;
-        obs.power = static_cast<CEC::cec_power_status>(params.data[0]);
-        adapter->m_observationCallback(obs);
-        return;
-    }
-
-    if (command->opcode == CEC::CEC_OPCODE_ACTIVE_SOURCE &&
-        params.size >= 2) {
-        emitActiveSource(0);
-        return;
-    }
-
-    // ROUTING_CHANGE payload: old address in [0..1], new address in
-    // [2..3]; we only care about the new path.
-    if (command->opcode == CEC::CEC_OPCODE_ROUTING_CHANGE &&
-        params.size >= 4) {
-        emitActiveSource(2);
-        return;
-    }
-
-    // SET_STREAM_PATH payload: new active address in [0..1].
-    if (command->opcode == CEC::CEC_OPCODE_SET_STREAM_PATH &&
-        params.size >= 2) {
-        emitActiveSource(0);
-        return;
-    }
+    RawFrame frame;
+    frame.initiator      = static_cast<uint8_t>(command->initiator);
+    frame.destination    = static_cast<uint8_t>(command->destination);
+    frame.opcode         = static_cast<uint8_t>(command->opcode);
+    frame.parameterCount = static_cast<uint8_t>(
+        std::min<std::size_t>(command->parameters.size, kMaxRawParameters));
+    std::copy(command->parameters.data, command->parameters.data + frame.parameterCount,
+              frame.parameters.begin());
+
+    if (adapter->m_capture) adapter->m_capture->recordFrame(frame);
+    decodeFrame(frame, adapter->m_frameFilter, adapter->m_rawFrameFilter,
+                adapter->m_observationCallback);
 }
 
 void LibCecAdapter::cecSourceActivatedCallback(void* cbParam,
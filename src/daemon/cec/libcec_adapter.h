@@ -1,15 +1,20 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include <libcec/cec.h>
 
 #include "../../common/logger.h"
+#include "../../common/trace.h"
+#include "../metrics.h"
 #include "adapter_config.h"
 #include "adapter_interface.h"
+#include "adapter_port_cache.h"
 
 namespace cec_control {
 
@@ -59,10 +64,12 @@ public:
     void closeConnection() override;
     [[nodiscard]] bool reopenConnection() override;
     [[nodiscard]] bool isConnected() const override;
+    void reconfigure(AdapterConfig config) override;
 
     // Commands ----------------------------------------------------------
     [[nodiscard]] bool powerOnDevice(CEC::cec_logical_address address) override;
     [[nodiscard]] bool standbyDevice(CEC::cec_logical_address address) override;
+    [[nodiscard]] bool broadcastStandby() override;
     [[nodiscard]] bool volumeUp() override;
     [[nodiscard]] bool volumeDown() override;
     [[nodiscard]] bool toggleMute() override;
@@ -70,6 +77,7 @@ public:
                                     CEC::cec_user_control_code key,
                                     bool release) override;
     [[nodiscard]] bool setStreamPath(uint16_t physicalAddress) override;
+    [[nodiscard]] bool transmitRaw(const RawFrame& frame) override;
 
     // Queries -----------------------------------------------------------
     [[nodiscard]] uint16_t getDevicePhysicalAddress(
@@ -80,14 +88,13 @@ public:
         CEC::cec_logical_address address) const override;
     [[nodiscard]] std::string getDeviceOSDName(
         CEC::cec_logical_address address) const override;
+    [[nodiscard]] uint32_t getDeviceVendorId(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] CEC::cec_version getDeviceCecVersion(
+        CEC::cec_logical_address address) const override;
     [[nodiscard]] CEC::cec_logical_addresses getActiveDevices() const override;
     [[nodiscard]] CEC::cec_logical_address getActiveSource() const override;
-
-    // Broadcast-style helpers ------------------------------------------
-    [[nodiscard]] bool standbyDevices(
-        CEC::cec_logical_address address = CEC::CECDEVICE_BROADCAST) override;
-    [[nodiscard]] bool powerOnDevices(
-        CEC::cec_logical_address address = CEC::CECDEVICE_BROADCAST) override;
+    [[nodiscard]] uint8_t getAudioStatus() const override;
 
 private:
     // libcec owns the ICECAdapter instance; ownership is released back
@@ -101,6 +108,13 @@ private:
     };
     using AdapterPtr = std::unique_ptr<CEC::ICECAdapter, AdapterDeleter>;
 
+    /**
+     * Copy the @c m_config fields libcec reads into @c m_libcecConfig.
+     * Only while no libcec instance exists: libcec's threads read the
+     * configuration without a lock.
+     */
+    void applyConfig();
+
     // ---------------------------------------------------------------
     // Member declaration order is a correctness invariant.
     //
@@ -112,6 +126,8 @@ private:
     //   - m_connected                 (via cbParam → this → &field)
     //   - m_observationCallback       (ditto)
     //   - m_connectionLostCallback    (ditto)
+    //   - m_frameFilter, m_rawFrameFilter, m_capture (ditto; the
+    //                       objects themselves belong to the caller)
     //
     // Those threads are joined by ICECAdapter::Close(), which runs as
     // part of the AdapterDeleter — i.e. inside m_adapter's destructor.
@@ -123,10 +139,20 @@ private:
     // body.
     // ---------------------------------------------------------------
 
-    // Configuration, read-only after construction.
+    // Configuration. Replaced by reconfigure on the worker thread and
+    // copied into m_libcecConfig on the next reopen.
     AdapterConfig m_config;
     std::string   m_portName;
 
+    // The last port that opened, mirrored to SystemPaths::
+    // getAdapterCachePath(), one file per adapter name, so a restart
+    // can skip detection too; the
+    // latest detection result, promoted to it once it opens; and
+    // whether m_portName came from the former. Worker thread only.
+    std::optional<AdapterPort> m_knownPort;
+    AdapterPort                m_detectedPort;
+    bool                       m_portFromCache = false;
+
     // libcec's non-owning view of our callback struct. m_callbacks is
     // value-initialised so every function slot starts out nullptr; the
     // constructor fills in the ones we use and hands the address to
@@ -138,15 +164,19 @@ private:
 
     // Cross-thread connection hint. Written by libcec's alert thread
     // in the CEC_ALERT_CONNECTION_LOST path and by the owning worker
-    // in openConnection/closeConnection/reopenConnection. Read without
+    // in openConnection/closeConnection/reopenConnection, and cleared
+    // by enforceCallBudget, which const queries reach. Read without
     // synchronisation by callers that want a cheap pre-flight; those
     // callers treat the value as advisory.
-    std::atomic<bool> m_connected;
+    mutable std::atomic<bool> m_connected;
 
     // Install-once at construction; libcec reads them from its internal
     // threads without a lock. Never reassigned.
     const std::function<void(Observation)> m_observationCallback;
     const std::function<void()>            m_connectionLostCallback;
+    const FrameFilter* const               m_frameFilter;
+    const FrameFilter* const               m_rawFrameFilter;
+    TrafficCapture* const                  m_capture;
 
     // libcec adapter handle. MUST stay last — see the block comment
     // above. The deleter calls CECDestroy(), which joins libcec's
@@ -154,17 +184,37 @@ private:
     AdapterPtr m_adapter;
 
     /**
-     * Detect available CEC adapter hardware. Caches the first-found
-     * port in @c m_portName.
+     * Detect available CEC adapter hardware. Caches in @c m_portName
+     * the first port found that matches @c AdapterConfig::port.
      */
     bool detectAdapter();
 
+    /** Whether @p port is the one @c AdapterConfig::port asks for. */
+    [[nodiscard]] bool isConfiguredPort(const AdapterPort& port) const;
+
+    /**
+     * Point @c m_portName at the known port if it is still present,
+     * without enumerating devices. Loads the cache file on first use.
+     */
+    bool useKnownPort();
+
+    /** @c useKnownPort, falling back to @c detectAdapter. */
+    bool locateAdapter();
+
+    /**
+     * Configure and @c Open the adapter at @c m_portName. The part of
+     * @c openConnection that runs again after a known port fails.
+     */
+    bool openPort();
+
     /**
      * Invoke @p fn iff the adapter is initialised and the
      * connection hint reports connected; otherwise return
      * @p fallback unchanged. Centralises the identical two-line
      * pre-flight that otherwise fronts every public command and
-     * query in this class.
+     * query in this class. The call itself is timed into
+     * @c Metrics::Latency::LibcecCall and checked against
+     * @c AdapterConfig::callBudgetMs by @c enforceCallBudget.
      *
      * Const-qualified so both const and non-const members can
      * invoke it. @c std::unique_ptr 's non-propagating const on the
@@ -176,9 +226,23 @@ private:
     R callIfConnected(R fallback, Fn&& fn) const {
         if (!m_adapter || !m_connected.load(std::memory_order_acquire))
             return fallback;
-        return fn();
+        ScopedLatency timer(Metrics::Latency::LibcecCall);
+        const TraceScope span(TracePoint::LibcecCall);
+        const auto started = std::chrono::steady_clock::now();
+        R result = fn();
+        enforceCallBudget(std::chrono::steady_clock::now() - started);
+        return result;
     }
 
+    /**
+     * A blocked bus can stall one libcec call for seconds while every
+     * queued job waits behind it. If @p elapsed overran the budget,
+     * drop the connection hint, so the queue drains with fast
+     * failures, and fire the connection-lost callback, which starts a
+     * reconnect cycle. Worker thread.
+     */
+    void enforceCallBudget(std::chrono::steady_clock::duration elapsed) const;
+
     // libcec callback trampolines
     static void cecLogCallback(void* cbParam, const CEC::cec_log_message* message);
     static void cecCommandCallback(void* cbParam, const CEC::cec_command* command);
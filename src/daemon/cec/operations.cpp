@@ -5,11 +5,12 @@
 #include "../command_throttler.h"
 #include "adapter_interface.h"
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <ios>
+#include <string>
 #include <string_view>
-#include <thread>
 
 #include <libcec/cec.h>
 
@@ -30,36 +31,137 @@ constexpr std::array<CEC::cec_user_control_code,
         CEC::CEC_USER_CONTROL_CODE_NUMBER4,
 };
 
-// Delay between a SendKeypress and its matching SendKeyRelease. Long
+// Pause between a SendKeypress and its matching SendKeyRelease. Long
 // enough for the receiver to register the press; far below the CEC
 // 1.4b §13.13 auto-release window (~500 ms), so a dropped release
 // self-heals.
 constexpr auto kPressToReleaseDelay = std::chrono::milliseconds(50);
 
-// Delay between two consecutive SendKeypress calls in a multi-press
-// sequence (the HDMI fallback path when SetStreamPath is refused).
+// Pause between two consecutive SendKeypress calls in a multi-press
+// sequence (the HDMI fallback path when SetStreamPath is refused, or
+// the steps of a coalesced burst).
 // Longer than kPressToReleaseDelay because a second press inside the
 // first press's window is interpreted by receivers as a repeat of the
 // same key rather than a distinct new press.
 constexpr auto kInterPressDelay = std::chrono::milliseconds(100);
 
-// kKeyCodes (in common/key_codes.cpp) carries raw wire bytes so the
-// common/ layer can stay libcec-free. These asserts pin each row to
-// its libcec enumerator: a divergence here surfaces at compile time
-// rather than as a wrong CEC message on the bus. Extend the block
-// when kKeyCodes grows.
-static_assert(0x71 == CEC::CEC_USER_CONTROL_CODE_F1_BLUE,
-              "kKeyCodes 'blue' value drift");
-static_assert(0x72 == CEC::CEC_USER_CONTROL_CODE_F2_RED,
-              "kKeyCodes 'red' value drift");
-static_assert(0x73 == CEC::CEC_USER_CONTROL_CODE_F3_GREEN,
-              "kKeyCodes 'green' value drift");
-static_assert(0x74 == CEC::CEC_USER_CONTROL_CODE_F4_YELLOW,
-              "kKeyCodes 'yellow' value drift");
-
-uint16_t hdmiPhysicalAddress(uint8_t source) noexcept {
-    return static_cast<uint16_t>((source - kFirstHdmiSource + 1) << 12);
+// kKeyCodes (in common/key_codes.h) carries raw wire bytes so the
+// common/ layer can stay libcec-free. This list names the libcec
+// enumerator of each of its rows, in the same order, and the assert
+// below pins one to the other: a divergence surfaces at compile time
+// rather than as a wrong CEC message on the bus. Extend the list when
+// kKeyCodes grows.
+constexpr std::array<CEC::cec_user_control_code, kKeyCodes.size()> kLibcecKeyCodes = {
+    CEC::CEC_USER_CONTROL_CODE_SELECT,
+    CEC::CEC_USER_CONTROL_CODE_UP,
+    CEC::CEC_USER_CONTROL_CODE_DOWN,
+    CEC::CEC_USER_CONTROL_CODE_LEFT,
+    CEC::CEC_USER_CONTROL_CODE_RIGHT,
+    CEC::CEC_USER_CONTROL_CODE_RIGHT_UP,
+    CEC::CEC_USER_CONTROL_CODE_RIGHT_DOWN,
+    CEC::CEC_USER_CONTROL_CODE_LEFT_UP,
+    CEC::CEC_USER_CONTROL_CODE_LEFT_DOWN,
+    CEC::CEC_USER_CONTROL_CODE_ROOT_MENU,
+    CEC::CEC_USER_CONTROL_CODE_SETUP_MENU,
+    CEC::CEC_USER_CONTROL_CODE_CONTENTS_MENU,
+    CEC::CEC_USER_CONTROL_CODE_FAVORITE_MENU,
+    CEC::CEC_USER_CONTROL_CODE_EXIT,
+    CEC::CEC_USER_CONTROL_CODE_TOP_MENU,
+    CEC::CEC_USER_CONTROL_CODE_DVD_MENU,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER_ENTRY_MODE,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER11,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER12,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER0,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER1,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER2,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER3,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER4,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER5,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER6,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER7,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER8,
+    CEC::CEC_USER_CONTROL_CODE_NUMBER9,
+    CEC::CEC_USER_CONTROL_CODE_DOT,
+    CEC::CEC_USER_CONTROL_CODE_ENTER,
+    CEC::CEC_USER_CONTROL_CODE_CLEAR,
+    CEC::CEC_USER_CONTROL_CODE_NEXT_FAVORITE,
+    CEC::CEC_USER_CONTROL_CODE_CHANNEL_UP,
+    CEC::CEC_USER_CONTROL_CODE_CHANNEL_DOWN,
+    CEC::CEC_USER_CONTROL_CODE_PREVIOUS_CHANNEL,
+    CEC::CEC_USER_CONTROL_CODE_SOUND_SELECT,
+    CEC::CEC_USER_CONTROL_CODE_INPUT_SELECT,
+    CEC::CEC_USER_CONTROL_CODE_DISPLAY_INFORMATION,
+    CEC::CEC_USER_CONTROL_CODE_HELP,
+    CEC::CEC_USER_CONTROL_CODE_PAGE_UP,
+    CEC::CEC_USER_CONTROL_CODE_PAGE_DOWN,
+    CEC::CEC_USER_CONTROL_CODE_POWER,
+    CEC::CEC_USER_CONTROL_CODE_VOLUME_UP,
+    CEC::CEC_USER_CONTROL_CODE_VOLUME_DOWN,
+    CEC::CEC_USER_CONTROL_CODE_MUTE,
+    CEC::CEC_USER_CONTROL_CODE_PLAY,
+    CEC::CEC_USER_CONTROL_CODE_STOP,
+    CEC::CEC_USER_CONTROL_CODE_PAUSE,
+    CEC::CEC_USER_CONTROL_CODE_RECORD,
+    CEC::CEC_USER_CONTROL_CODE_REWIND,
+    CEC::CEC_USER_CONTROL_CODE_FAST_FORWARD,
+    CEC::CEC_USER_CONTROL_CODE_EJECT,
+    CEC::CEC_USER_CONTROL_CODE_FORWARD,
+    CEC::CEC_USER_CONTROL_CODE_BACKWARD,
+    CEC::CEC_USER_CONTROL_CODE_STOP_RECORD,
+    CEC::CEC_USER_CONTROL_CODE_PAUSE_RECORD,
+    CEC::CEC_USER_CONTROL_CODE_ANGLE,
+    CEC::CEC_USER_CONTROL_CODE_SUB_PICTURE,
+    CEC::CEC_USER_CONTROL_CODE_VIDEO_ON_DEMAND,
+    CEC::CEC_USER_CONTROL_CODE_ELECTRONIC_PROGRAM_GUIDE,
+    CEC::CEC_USER_CONTROL_CODE_TIMER_PROGRAMMING,
+    CEC::CEC_USER_CONTROL_CODE_INITIAL_CONFIGURATION,
+    CEC::CEC_USER_CONTROL_CODE_SELECT_BROADCAST_TYPE,
+    CEC::CEC_USER_CONTROL_CODE_SELECT_SOUND_PRESENTATION,
+    CEC::CEC_USER_CONTROL_CODE_PAUSE_PLAY_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_RECORD_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_PAUSE_RECORD_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_STOP_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_MUTE_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_RESTORE_VOLUME_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_POWER_TOGGLE_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_POWER_OFF_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_POWER_ON_FUNCTION,
+    CEC::CEC_USER_CONTROL_CODE_F1_BLUE,
+    CEC::CEC_USER_CONTROL_CODE_F2_RED,
+    CEC::CEC_USER_CONTROL_CODE_F3_GREEN,
+    CEC::CEC_USER_CONTROL_CODE_F4_YELLOW,
+    CEC::CEC_USER_CONTROL_CODE_F5,
+    CEC::CEC_USER_CONTROL_CODE_DATA,
+    CEC::CEC_USER_CONTROL_CODE_AN_RETURN,
+    CEC::CEC_USER_CONTROL_CODE_AN_CHANNELS_LIST,
+};
+
+constexpr bool keyCodesMatchLibcec() noexcept {
+    for (std::size_t i = 0; i < kKeyCodes.size(); ++i) {
+        if (kKeyCodes[i].code != kLibcecKeyCodes[i]) return false;
+    }
+    return true;
 }
+static_assert(keyCodesMatchLibcec(), "kKeyCodes value drift from libcec");
+
+// Phases of the setSource attempt body. Select covers both the
+// TV-internal keypress and the HDMI SetStreamPath try (plus the start
+// of its keypress fallback); the rest are the pauses in between.
+enum class SourcePhase : uint32_t { Select, NumberKey, Release };
+
+// Phases of the setVolumeLevel attempt body: read the status and plan
+// a burst, then one volume key per slice.
+enum class VolumeLevelPhase : uint32_t { Read, Press };
+
+// Keys one setVolumeLevel burst may send: a full 0..100 sweep at one
+// level per key.
+constexpr uint32_t kMaxVolumeBurst = 100;
+
+// Pause between the keys of a setVolumeLevel burst. VolumeUp/Down send
+// their own release, so back-to-back keys cannot be mistaken for one
+// held press and the kInterPressDelay margin is not needed; the
+// tighter pace keeps a full sweep well inside the client's timeout.
+constexpr auto kVolumeBurstDelay = kPressToReleaseDelay;
 
 CEC::cec_user_control_code hdmiNumberKey(uint8_t source) noexcept {
     if (source < kFirstHdmiSource || source > kLastHdmiSource) {
@@ -70,102 +172,294 @@ CEC::cec_user_control_code hdmiNumberKey(uint8_t source) noexcept {
 
 } // namespace
 
-bool powerOnDevice(ICecAdapter& adapter, CommandThrottler& throttler, uint8_t logicalAddress) {
-    if (!adapter.isConnected()) return false;
+ThrottledCommand powerOnDevice(ICecAdapter& adapter, CommandThrottler& throttler,
+                               uint8_t logicalAddress) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
     LOG_INFO("Powering on device ", static_cast<int>(logicalAddress));
-    return throttler.executeWithThrottle([&adapter, logicalAddress]() {
+    return ThrottledCommand(throttler, logicalAddress,
+                            [&adapter, logicalAddress](uint32_t) {
         const auto addr = static_cast<CEC::cec_logical_address>(logicalAddress);
         if (!adapter.isDeviceActive(addr)) {
             LOG_WARNING("Device ", static_cast<int>(logicalAddress), " is not active");
         }
-        return adapter.powerOnDevice(addr);
+        return AttemptStep::of(adapter.powerOnDevice(addr));
     });
 }
 
-bool powerOffDevice(ICecAdapter& adapter, CommandThrottler& throttler, uint8_t logicalAddress) {
-    if (!adapter.isConnected()) return false;
+ThrottledCommand powerOffDevice(ICecAdapter& adapter, CommandThrottler& throttler,
+                                uint8_t logicalAddress) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
+    if (logicalAddress == CEC::CECDEVICE_BROADCAST) {
+        LOG_INFO("Broadcasting standby to every device");
+        return ThrottledCommand(throttler, logicalAddress, [&adapter](uint32_t) {
+            return AttemptStep::of(adapter.broadcastStandby());
+        });
+    }
     LOG_INFO("Powering off device ", static_cast<int>(logicalAddress));
-    return throttler.executeWithThrottle([&adapter, logicalAddress]() {
+    return ThrottledCommand(throttler, logicalAddress,
+                            [&adapter, logicalAddress](uint32_t) {
         const auto addr = static_cast<CEC::cec_logical_address>(logicalAddress);
         if (!adapter.isDeviceActive(addr)) {
             LOG_WARNING("Device ", static_cast<int>(logicalAddress), " is not active");
         }
-        return adapter.standbyDevice(addr);
+        return AttemptStep::of(adapter.standbyDevice(addr));
     });
 }
 
-bool setVolume(ICecAdapter& adapter, CommandThrottler& throttler, uint8_t logicalAddress, bool up) {
-    if (!adapter.isConnected()) return false;
-    LOG_INFO("Setting volume ", up ? "up" : "down",
+ThrottledCommand powerDevices(ICecAdapter& adapter, CommandThrottler& throttler,
+                             uint16_t devices, bool on) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
+    constexpr uint16_t kBroadcastBit = 1u << CEC::CECDEVICE_BROADCAST;
+    if (devices & kBroadcastBit) {
+        if (!on) return powerOffDevice(adapter, throttler, CEC::CECDEVICE_BROADCAST);
+        devices &= static_cast<uint16_t>(~kBroadcastBit);
+    }
+    if (devices == 0) {
+        LOG_WARNING("Power ", on ? "on" : "off", " sent to an empty device set");
+        return ThrottledCommand::finished(false);
+    }
+
+    std::string names;
+    for (uint32_t a = 0; a < CEC::CECDEVICE_BROADCAST; ++a) {
+        if (devices & (1u << a)) names += (names.empty() ? "" : ",") + std::to_string(a);
+    }
+    LOG_INFO(on ? "Powering on" : "Powering off", " devices ", names);
+
+    // Each device is paced on its own lane: the command moves to the
+    // next device's lane between sends, and an attempt that leaves any
+    // of them unacknowledged is retried on the lane of one that did
+    // not. Phase 0 starts an attempt on the lane held, `at`; phase
+    // 1 + N sends to device N. `pending` lives in the closure, so a
+    // retry's pass covers only the devices that have not acknowledged,
+    // starting from `at` and wrapping round to `start`.
+    constexpr uint32_t kDevices = CEC::CECDEVICE_BROADCAST;
+    uint8_t first = 0;
+    while (!(devices & (1u << first))) ++first;
+    return ThrottledCommand(throttler, first,
+                            [&adapter, on, pending = devices, at = first,
+                             start = first](uint32_t phase) mutable {
+        if (phase == 0) start = at;
+        const uint8_t a = phase == 0 ? at : static_cast<uint8_t>(phase - 1);
+        const auto addr = static_cast<CEC::cec_logical_address>(a);
+        const bool ok = on ? adapter.powerOnDevice(addr) : adapter.standbyDevice(addr);
+        if (ok) {
+            pending &= static_cast<uint16_t>(~(1u << a));
+        } else {
+            LOG_WARNING("Device ", static_cast<int>(a), " did not acknowledge power ",
+                        on ? "on" : "off");
+        }
+        for (uint32_t i = 1; i < kDevices; ++i) {
+            const auto n = static_cast<uint8_t>((a + i) % kDevices);
+            if (n == start) break;
+            if (pending & (1u << n)) {
+                at = n;
+                return AttemptStep::next(ok, n, 1u + n);
+            }
+        }
+        if (pending == 0 || !ok) return AttemptStep::of(ok);
+        // This pass ends on a device that acknowledged: retry from the
+        // first one that did not.
+        for (uint32_t i = 0; i < kDevices; ++i) {
+            const auto n = static_cast<uint8_t>((start + i) % kDevices);
+            if (pending & (1u << n)) {
+                at = n;
+                break;
+            }
+        }
+        return AttemptStep::failedOn(at);
+    });
+}
+
+ThrottledCommand setVolume(ICecAdapter& adapter, CommandThrottler& throttler,
+                           uint8_t logicalAddress, bool up, uint32_t steps) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
+    if (steps <= 1) {
+        LOG_INFO("Setting volume ", up ? "up" : "down",
+                 " on device ", static_cast<int>(logicalAddress));
+    } else {
+        LOG_INFO("Setting volume ", up ? "up" : "down",
+                 " on device ", static_cast<int>(logicalAddress),
+                 " (", steps, " coalesced steps)");
+    }
+    // `done` lives in the closure so a throttler retry picks up at the
+    // step that failed instead of re-sending steps already applied.
+    return ThrottledCommand(throttler, logicalAddress,
+                            [&adapter, up, steps,
+                             done = uint32_t{0}](uint32_t) mutable {
+        if (!(up ? adapter.volumeUp() : adapter.volumeDown())) {
+            return AttemptStep::failed();
+        }
+        if (++done < steps) {
+            return AttemptStep::pauseThen(kInterPressDelay, 0);
+        }
+        return AttemptStep::succeeded();
+    });
+}
+
+ThrottledCommand setVolumeLevel(ICecAdapter& adapter, CommandThrottler& throttler,
+                                uint8_t logicalAddress, uint8_t level) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
+    LOG_INFO("Setting volume to ", static_cast<int>(level),
              " on device ", static_cast<int>(logicalAddress));
-    return throttler.executeWithThrottle([&adapter, up]() {
-        return up ? adapter.volumeUp() : adapter.volumeDown();
+
+    // Round state lives in the closure; a throttler retry re-enters at
+    // Read, which re-plans from the level the receiver now reports.
+    struct Progress {
+        uint32_t rounds  = 0;
+        uint32_t step    = 1;   ///< Levels per key, as last observed.
+        uint32_t pending = 0;   ///< Keys left in the current burst.
+        uint32_t pressed = 0;   ///< Keys sent in the current burst.
+        int      from    = -1;  ///< Level when the burst started.
+        bool     up      = true;
+    };
+    return ThrottledCommand(throttler, logicalAddress,
+                            [&adapter, logicalAddress, level,
+                             p = Progress{}](uint32_t phase) mutable {
+        if (static_cast<VolumeLevelPhase>(phase) == VolumeLevelPhase::Read) {
+            const uint8_t status  = adapter.getAudioStatus();
+            const int     current = status & CEC::CEC_AUDIO_VOLUME_STATUS_MASK;
+            if (current == CEC::CEC_AUDIO_VOLUME_STATUS_UNKNOWN ||
+                current > CEC::CEC_AUDIO_VOLUME_MAX) {
+                LOG_WARNING("Device ", static_cast<int>(logicalAddress),
+                            " did not report its volume");
+                return AttemptStep::failed();
+            }
+            if (p.pressed > 0) {
+                const int moved = current - p.from;
+                if (moved == 0) {
+                    LOG_WARNING("Volume on device ", static_cast<int>(logicalAddress),
+                                " did not move after ", p.pressed, " steps");
+                    // A retry probes with one key again rather than
+                    // repeating a burst that had no effect.
+                    p.pressed = 0;
+                    p.rounds  = 0;
+                    return AttemptStep::failed();
+                }
+                const auto distance = static_cast<uint32_t>(moved < 0 ? -moved : moved);
+                p.step = std::max<uint32_t>(1, (distance + p.pressed / 2) / p.pressed);
+                p.pressed = 0;
+            }
+
+            const int  delta = level - current;
+            const auto gap   = static_cast<uint32_t>(delta < 0 ? -delta : delta);
+            // Within half a step is the nearest the receiver can land.
+            if (gap * 2 <= p.step) {
+                LOG_DEBUG("Volume on device ", static_cast<int>(logicalAddress),
+                          " at ", current, " (target ", static_cast<int>(level), ")");
+                return AttemptStep::succeeded();
+            }
+            if (p.rounds == kMaxVolumeRounds) {
+                LOG_WARNING("Volume on device ", static_cast<int>(logicalAddress),
+                            " stopped at ", current, " (target ",
+                            static_cast<int>(level), ")");
+                return AttemptStep::succeeded();
+            }
+
+            // The first round is a single key: receivers step by 1 to 5
+            // levels, and a burst sized on a guess can overshoot badly.
+            p.up      = delta > 0;
+            p.from    = current;
+            p.pending = p.rounds == 0
+                ? 1
+                : std::clamp<uint32_t>((gap + p.step / 2) / p.step, 1, kMaxVolumeBurst);
+            ++p.rounds;
+        }
+
+        if (!(p.up ? adapter.volumeUp() : adapter.volumeDown())) {
+            return AttemptStep::failed();
+        }
+        ++p.pressed;
+        return AttemptStep::pauseThen(
+            kVolumeBurstDelay,
+            static_cast<uint32_t>(--p.pending > 0 ? VolumeLevelPhase::Press
+                                                  : VolumeLevelPhase::Read));
     });
 }
 
-bool setMute(ICecAdapter& adapter, CommandThrottler& throttler, uint8_t logicalAddress, bool mute) {
-    if (!adapter.isConnected()) return false;
+ThrottledCommand setMute(ICecAdapter& adapter, CommandThrottler& throttler,
+                         uint8_t logicalAddress, bool mute) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
     LOG_INFO(mute ? "Muting" : "Unmuting", " device ", static_cast<int>(logicalAddress));
-    return throttler.executeWithThrottle([&adapter]() {
-        return adapter.toggleMute();
+    return ThrottledCommand(throttler, logicalAddress, [&adapter](uint32_t) {
+        return AttemptStep::of(adapter.toggleMute());
     });
 }
 
-bool setSource(ICecAdapter& adapter, CommandThrottler& throttler, uint8_t source) {
-    if (!adapter.isConnected()) return false;
+ThrottledCommand setSource(ICecAdapter& adapter, CommandThrottler& throttler,
+                           uint8_t source) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
     LOG_INFO("Selecting input source ", static_cast<int>(source), " on TV");
 
-    return throttler.executeWithThrottle([&adapter, source]() {
-        // Sources 0 and 1 are TV-internal inputs without a CEC physical
-        // address; SetStreamPath cannot reach them, so go straight to a
-        // function-key keypress.
-        auto pressAndReleaseTv = [&adapter](CEC::cec_user_control_code key) {
-            if (!adapter.sendKeypress(CEC::CECDEVICE_TV, key, false)) {
-                return false;
-            }
-            std::this_thread::sleep_for(kPressToReleaseDelay);
-            (void)adapter.sendKeypress(CEC::CECDEVICE_TV,
-                                       CEC::CEC_USER_CONTROL_CODE_UNKNOWN, true);
-            return true;
-        };
-
-        if (source == 0) return pressAndReleaseTv(CEC::CEC_USER_CONTROL_CODE_SELECT_AV_INPUT_FUNCTION);
-        if (source == 1) return pressAndReleaseTv(CEC::CEC_USER_CONTROL_CODE_SELECT_AUDIO_INPUT_FUNCTION);
-        if (source < kFirstHdmiSource || source > kLastHdmiSource) {
-            LOG_WARNING("Invalid source value: ", source);
-            return false;
-        }
+    if (source > 1 && (source < kFirstHdmiSource || source > kLastHdmiSource)) {
+        LOG_WARNING("Invalid source value: ", static_cast<int>(source));
+        return ThrottledCommand::finished(false);
+    }
 
-        // HDMI input: SetStreamPath is the canonical mechanism; fall back to
-        // INPUT_SELECT + number keypress sequence if the TV refuses.
-        const uint16_t physicalAddress = hdmiPhysicalAddress(source);
-        LOG_INFO("Setting stream path to physical address: 0x",
-                 std::hex, physicalAddress);
+    return ThrottledCommand(throttler, CEC::CECDEVICE_TV,
+                            [&adapter, &throttler, source](uint32_t phase) {
+        switch (static_cast<SourcePhase>(phase)) {
+        case SourcePhase::Select: {
+            // Sources 0 and 1 are TV-internal inputs without a CEC
+            // physical address; SetStreamPath cannot reach them, so go
+            // straight to a function-key keypress.
+            if (source == 0 || source == 1) {
+                const auto key = (source == 0)
+                    ? CEC::CEC_USER_CONTROL_CODE_SELECT_AV_INPUT_FUNCTION
+                    : CEC::CEC_USER_CONTROL_CODE_SELECT_AUDIO_INPUT_FUNCTION;
+                if (!adapter.sendKeypress(CEC::CECDEVICE_TV, key, false)) {
+                    return AttemptStep::failed();
+                }
+                return AttemptStep::pauseThen(
+                    kPressToReleaseDelay, static_cast<uint32_t>(SourcePhase::Release));
+            }
 
-        if (adapter.setStreamPath(physicalAddress)) {
-            return true;
+            // HDMI input: SetStreamPath is the canonical mechanism; fall
+            // back to INPUT_SELECT + number keypress sequence if the TV
+            // refuses. A TV that has refused before goes straight to the
+            // keypresses, with an occasional probe in case it changed.
+            if (!throttler.shouldTryStreamPath(CEC::CECDEVICE_TV)) {
+                LOG_DEBUG("TV refuses SetStreamPath, using key presses");
+            } else {
+                const uint16_t physicalAddress = hdmiPhysicalAddress(source);
+                LOG_INFO("Setting stream path to physical address: 0x",
+                         std::hex, physicalAddress);
+                if (adapter.setStreamPath(physicalAddress)) {
+                    throttler.noteStreamPath(CEC::CECDEVICE_TV, true);
+                    return AttemptStep::succeeded();
+                }
+                LOG_INFO("SetStreamPath failed, trying with key presses");
+            }
+            if (!adapter.sendKeypress(CEC::CECDEVICE_TV,
+                                      CEC::CEC_USER_CONTROL_CODE_INPUT_SELECT, false)) {
+                return AttemptStep::failed();
+            }
+            return AttemptStep::pauseThen(
+                kInterPressDelay, static_cast<uint32_t>(SourcePhase::NumberKey));
         }
 
-        LOG_INFO("SetStreamPath failed, trying with key presses");
-        if (!adapter.sendKeypress(CEC::CECDEVICE_TV,
-                                  CEC::CEC_USER_CONTROL_CODE_INPUT_SELECT, false)) {
-            return false;
-        }
-        std::this_thread::sleep_for(kInterPressDelay);
+        case SourcePhase::NumberKey:
+            if (!adapter.sendKeypress(CEC::CECDEVICE_TV, hdmiNumberKey(source), false)) {
+                return AttemptStep::failed();
+            }
+            return AttemptStep::pauseThen(
+                kPressToReleaseDelay, static_cast<uint32_t>(SourcePhase::Release));
 
-        if (!adapter.sendKeypress(CEC::CECDEVICE_TV, hdmiNumberKey(source), false)) {
-            return false;
+        case SourcePhase::Release:
+            (void)adapter.sendKeypress(CEC::CECDEVICE_TV,
+                                       CEC::CEC_USER_CONTROL_CODE_UNKNOWN, true);
+            // An HDMI source only gets here through the fallback, and
+            // the TV has now taken it: record that SetStreamPath is not
+            // the way to reach this one.
+            if (source > 1) throttler.noteStreamPath(CEC::CECDEVICE_TV, false);
+            return AttemptStep::succeeded();
         }
-        std::this_thread::sleep_for(kPressToReleaseDelay);
-        (void)adapter.sendKeypress(CEC::CECDEVICE_TV,
-                                   CEC::CEC_USER_CONTROL_CODE_UNKNOWN, true);
-        return true;
+        return AttemptStep::failed();
     });
 }
 
-bool sendKey(ICecAdapter& adapter, CommandThrottler& throttler,
-             uint8_t logicalAddress, uint8_t code) {
-    if (!adapter.isConnected()) return false;
+ThrottledCommand sendKey(ICecAdapter& adapter, CommandThrottler& throttler,
+                         uint8_t logicalAddress, uint8_t code, uint32_t steps) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
 
     const KeySpec* spec = findKeyByCode(code);
     const std::string_view name =
@@ -173,60 +467,73 @@ bool sendKey(ICecAdapter& adapter, CommandThrottler& throttler,
     LOG_INFO("Sending key '", name, "' (code 0x",
              std::hex, static_cast<int>(code),
              std::dec, ") to device ", static_cast<int>(logicalAddress));
+    if (steps > 1) {
+        LOG_DEBUG("Key '", name, "' carries ", steps, " coalesced presses");
+    }
 
-    return throttler.executeWithThrottle([&adapter, logicalAddress, code]() {
+    return ThrottledCommand(throttler, logicalAddress,
+                            [&adapter, logicalAddress, code, steps,
+                             done = uint32_t{0}](uint32_t phase) mutable {
         const auto addr = static_cast<CEC::cec_logical_address>(logicalAddress);
-        const auto key  = static_cast<CEC::cec_user_control_code>(code);
-        if (!adapter.sendKeypress(addr, key, /*release=*/false)) {
-            return false;
+        if (phase == 0) {
+            const auto key = static_cast<CEC::cec_user_control_code>(code);
+            if (!adapter.sendKeypress(addr, key, /*release=*/false)) {
+                return AttemptStep::failed();
+            }
+            return AttemptStep::pauseThen(kPressToReleaseDelay, 1);
         }
-        std::this_thread::sleep_for(kPressToReleaseDelay);
         (void)adapter.sendKeypress(addr, CEC::CEC_USER_CONTROL_CODE_UNKNOWN,
                                    /*release=*/true);
-        return true;
+        if (++done < steps) {
+            return AttemptStep::pauseThen(kInterPressDelay, 0);
+        }
+        return AttemptStep::succeeded();
     });
 }
 
-void logDeviceSnapshot(ICecAdapter& adapter) {
-    try {
-        const CEC::cec_logical_addresses addresses = adapter.getActiveDevices();
-
-        int activeCount = 0;
-        for (int i = 0; i < 16; ++i) {
-            if (addresses[i]) ++activeCount;
-        }
-        LOG_INFO("Found ", activeCount, " active CEC device(s)");
-
-        LOG_INFO("Scanning for CEC devices power status...");
-        for (int i = 0; i < 15; ++i) {
-            const auto cecAddress = static_cast<CEC::cec_logical_address>(i);
-            const char* status = "unknown";
-            switch (adapter.getDevicePowerStatus(cecAddress)) {
-                case CEC::CEC_POWER_STATUS_ON:                          status = "ON"; break;
-                case CEC::CEC_POWER_STATUS_STANDBY:                     status = "STANDBY"; break;
-                case CEC::CEC_POWER_STATUS_IN_TRANSITION_STANDBY_TO_ON: status = "TURNING ON"; break;
-                case CEC::CEC_POWER_STATUS_IN_TRANSITION_ON_TO_STANDBY: status = "TURNING OFF"; break;
-                default: break;
+ThrottledCommand sendKeySequence(ICecAdapter& adapter, CommandThrottler& throttler,
+                                 uint8_t logicalAddress, const uint8_t* codes,
+                                 std::size_t count) {
+    if (!adapter.isConnected() || count == 0 || count > kMaxKeySequence) {
+        return ThrottledCommand::finished(false);
+    }
+    std::array<uint8_t, kMaxKeySequence> keys{};
+    std::copy(codes, codes + count, keys.begin());
+    LOG_INFO("Sending ", count, " keys to device ", static_cast<int>(logicalAddress));
+
+    return ThrottledCommand(throttler, logicalAddress,
+                            [&adapter, logicalAddress, keys,
+                             total = static_cast<uint8_t>(count),
+                             done = uint8_t{0}](uint32_t phase) mutable {
+        const auto addr = static_cast<CEC::cec_logical_address>(logicalAddress);
+        if (phase == 0) {
+            const auto key = static_cast<CEC::cec_user_control_code>(keys[done]);
+            if (!adapter.sendKeypress(addr, key, /*release=*/false)) {
+                return AttemptStep::failed();
             }
-            LOG_INFO("Device ", i, ": Power status = ", status);
-        }
-
-        const CEC::cec_logical_address active = adapter.getActiveSource();
-        if (active != CEC::CECDEVICE_UNKNOWN) {
-            LOG_INFO("Active source: Device ", static_cast<int>(active));
-        } else {
-            LOG_INFO("No active source detected");
+            return AttemptStep::pauseThen(kPressToReleaseDelay, 1);
         }
+        (void)adapter.sendKeypress(addr, CEC::CEC_USER_CONTROL_CODE_UNKNOWN,
+                                   /*release=*/true);
+        if (++done == total) return AttemptStep::succeeded();
+        // The release ends the press, so a different key cannot be
+        // taken for a repeat of it; only the same key needs the gap.
+        return AttemptStep::pauseThen(keys[done] == keys[done - 1]
+                                          ? kInterPressDelay
+                                          : std::chrono::milliseconds(0),
+                                      0);
+    });
+}
 
-        for (int i = 0; i < 16; ++i) {
-            if (!addresses[i]) continue;
-            const auto addr = static_cast<CEC::cec_logical_address>(i);
-            LOG_INFO("Device ", i, ": ", adapter.getDeviceOSDName(addr),
-                     " (", adapter.isDeviceActive(addr) ? "active" : "inactive", ")");
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception during device scanning: ", e.what());
-    }
+ThrottledCommand transmitRaw(ICecAdapter& adapter, CommandThrottler& throttler,
+                             const RawFrame& frame) {
+    if (!adapter.isConnected()) return ThrottledCommand::finished(false);
+    LOG_INFO("Sending raw frame opcode 0x", std::hex, static_cast<int>(frame.opcode),
+             std::dec, " to device ", static_cast<int>(frame.destination));
+    return ThrottledCommand(throttler, frame.destination & 0x0F,
+                            [&adapter, frame](uint32_t) {
+        return AttemptStep::of(adapter.transmitRaw(frame));
+    });
 }
 
 } // namespace cec_control::ops
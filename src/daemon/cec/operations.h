@@ -2,10 +2,12 @@
 
 #include <cstdint>
 
+#include "../../common/messages.h"
+#include "../command_throttler.h"
+
 namespace cec_control {
 
 class ICecAdapter;
-class CommandThrottler;
 
 /**
  * @namespace cec_control::ops
@@ -13,11 +15,13 @@ class CommandThrottler;
  *        ultimately drives.
  *
  * Every operation is pure in the sense that it holds no state of its own;
- * it reads the adapter's current connected hint, runs its action through
- * the @c CommandThrottler, and returns whether the throttled attempt
- * succeeded. No caller-side locking is required around a call — the
- * adapter serialises libcec access internally and the throttler is
- * thread-safe via atomics.
+ * it reads the adapter's current connected hint and returns a
+ * @c ThrottledCommand wrapping its action. Nothing touches the bus
+ * until the caller drives that command with @c resume() — the worker
+ * does so slice by slice, parking it across throttle slots, retry
+ * back-offs and the short press / release gaps instead of sleeping.
+ * The returned command captures @p adapter by reference and must not
+ * outlive it.
  *
  * These helpers deliberately duplicate the adapter's own
  * @c isConnected() guard: the dispatch path already gated the command,
@@ -26,38 +30,84 @@ class CommandThrottler;
  */
 namespace ops {
 
+/** Read-and-press rounds setVolumeLevel runs, probe included, before settling. */
+inline constexpr uint32_t kMaxVolumeRounds = 4;
+
+/** Physical address of HDMI source @p source (@c 0xN000). */
+[[nodiscard]] constexpr uint16_t hdmiPhysicalAddress(uint8_t source) noexcept {
+    return static_cast<uint16_t>((source - kFirstHdmiSource + 1) << 12);
+}
+
+/** Wake @p logicalAddress via @c ICecAdapter::powerOnDevice, throttled. */
+[[nodiscard]] ThrottledCommand powerOnDevice(ICecAdapter& adapter,
+                                             CommandThrottler& throttler,
+                                             uint8_t logicalAddress);
+
 /**
- * HDMI source IDs accepted on the wire. Source values in
- * [@c kFirstHdmiSource, @c kLastHdmiSource] map to HDMI 1..4 via the CEC
- * physical-address layout @c 0xN000 (where @c N is the port number).
- * Kept public so help rendering can guard against drift without
- * redeclaring the range.
+ * Send standby to @p logicalAddress via @c ICecAdapter::standbyDevice,
+ * throttled. The broadcast address sends one broadcast <Standby>
+ * through @c ICecAdapter::broadcastStandby instead.
  */
-inline constexpr uint8_t kFirstHdmiSource = 2;
-inline constexpr uint8_t kLastHdmiSource  = 5;
+[[nodiscard]] ThrottledCommand powerOffDevice(ICecAdapter& adapter,
+                                              CommandThrottler& throttler,
+                                              uint8_t logicalAddress);
 
-/** Wake @p logicalAddress via @c ICecAdapter::powerOnDevice, throttled. */
-[[nodiscard]] bool powerOnDevice(ICecAdapter& adapter,
-                                 CommandThrottler& throttler,
-                                 uint8_t logicalAddress);
+/**
+ * Wake (@p on) or put in standby every device in @p devices as one
+ * throttled command. It takes a single slot on the broadcast lane and
+ * sends the frames back to back, one device per worker slice, so other
+ * ready work can run between them. A retry resends only to devices
+ * that have not acknowledged yet. The command succeeds once every
+ * device has.
+ *
+ * A standby set that includes the broadcast address is one broadcast
+ * <Standby>, as @c powerOffDevice does. CEC has no broadcast wake, so
+ * that bit is ignored for @p on.
+ */
+[[nodiscard]] ThrottledCommand powerDevices(ICecAdapter& adapter,
+                                            CommandThrottler& throttler,
+                                            uint16_t devices,
+                                            bool on);
 
-/** Send standby to @p logicalAddress via @c ICecAdapter::standbyDevice, throttled. */
-[[nodiscard]] bool powerOffDevice(ICecAdapter& adapter,
-                                  CommandThrottler& throttler,
-                                  uint8_t logicalAddress);
+/**
+ * Throttled volume step(s). @p up selects VolumeUp vs. VolumeDown.
+ *
+ * @p steps > 1 is the coalesced form produced by the dispatcher when
+ * a burst of identical requests merged ahead of the worker: all steps
+ * share one throttle slot and are separated by inter-press pauses. A
+ * retry resumes from the step that failed rather than replaying steps
+ * the target already acknowledged.
+ */
+[[nodiscard]] ThrottledCommand setVolume(ICecAdapter& adapter,
+                                         CommandThrottler& throttler,
+                                         uint8_t logicalAddress,
+                                         bool up,
+                                         uint32_t steps = 1);
 
-/** Throttled volume step. @p up selects VolumeUp vs. VolumeDown. */
-[[nodiscard]] bool setVolume(ICecAdapter& adapter,
-                             CommandThrottler& throttler,
-                             uint8_t logicalAddress,
-                             bool up);
+/**
+ * Throttled absolute volume: bring the audio system at
+ * @p logicalAddress to @p level (0..kMaxVolumeLevel) with relative
+ * steps, since CEC has no set-volume message.
+ *
+ * Each round reads the audio status, sends volume keys toward the
+ * target, and reads again. The first round sends one key to learn how
+ * far the receiver moves per key; later rounds send a burst sized from
+ * that step and the distance left. The command succeeds once the level is
+ * as close as one step allows, or after @c kMaxVolumeRounds rounds
+ * with a warning naming where it stopped. It fails when the status
+ * cannot be read or a burst moves nothing. Mute is left as it is.
+ */
+[[nodiscard]] ThrottledCommand setVolumeLevel(ICecAdapter& adapter,
+                                              CommandThrottler& throttler,
+                                              uint8_t logicalAddress,
+                                              uint8_t level);
 
 /** Throttled mute toggle. The @p mute argument is informational (CEC
  *  exposes only a toggle) and drives the log line. */
-[[nodiscard]] bool setMute(ICecAdapter& adapter,
-                           CommandThrottler& throttler,
-                           uint8_t logicalAddress,
-                           bool mute);
+[[nodiscard]] ThrottledCommand setMute(ICecAdapter& adapter,
+                                       CommandThrottler& throttler,
+                                       uint8_t logicalAddress,
+                                       bool mute);
 
 /**
  * Drive the TV's input selector. Source IDs:
@@ -66,17 +116,23 @@ inline constexpr uint8_t kLastHdmiSource  = 5;
  *  - @c 2..5 map to HDMI 1..4 via SetStreamPath, with an INPUT_SELECT +
  *    number-key keypress fallback if SetStreamPath is refused.
  *
+ * How the TV answered is noted on its throttler lane. Once the
+ * fallback has been what worked, later HDMI selections go straight to
+ * the keypresses instead of waiting out a refused SetStreamPath first;
+ * every @c CommandThrottler::kStreamPathReprobeInterval-th one tries
+ * SetStreamPath again (see @c CommandThrottler::shouldTryStreamPath).
+ *
  * The action always targets @c CEC::CECDEVICE_TV; a logical-address
  * parameter would be misleading and is deliberately absent.
  */
-[[nodiscard]] bool setSource(ICecAdapter& adapter,
-                             CommandThrottler& throttler,
-                             uint8_t source);
+[[nodiscard]] ThrottledCommand setSource(ICecAdapter& adapter,
+                                         CommandThrottler& throttler,
+                                         uint8_t source);
 
 /**
  * Throttled CEC user-control press-and-release targeting
  * @p logicalAddress. Emits one @c SendKeypress followed by
- * @c SendKeyRelease after a short inter-step delay; release is
+ * @c SendKeyRelease after a short pause; release is
  * best-effort (CEC 1.4b §13.13 guarantees receivers auto-release
  * within ~500 ms, so a failed release does not leave the target
  * stuck — matching the @c setSource precedent).
@@ -84,19 +140,41 @@ inline constexpr uint8_t kLastHdmiSource  = 5;
  * @p code is the raw CEC user-control byte; callers are expected to
  * validate against @ref kKeyCodes at the wire gate (see
  * @c handleKey in @c command_dispatch.cpp).
+ *
+ * @p steps repeats the press-and-release pair under one throttle slot,
+ * with the same resume-on-retry behaviour as @c setVolume.
+ */
+[[nodiscard]] ThrottledCommand sendKey(ICecAdapter& adapter,
+                                       CommandThrottler& throttler,
+                                       uint8_t logicalAddress,
+                                       uint8_t code,
+                                       uint32_t steps = 1);
+
+/**
+ * Throttled sequence of distinct key presses — a menu navigation — to
+ * @p logicalAddress as one command: each code in @p codes (at most
+ * @c kMaxKeySequence, validated like @c sendKey's) is pressed and
+ * released in turn under one throttle slot.
+ *
+ * The next key follows a release straight away unless it repeats the
+ * key just released, which waits out the same gap as a coalesced
+ * @c sendKey burst so the receiver does not read it as auto-repeat.
+ * A retry resumes at the key that failed.
  */
-[[nodiscard]] bool sendKey(ICecAdapter& adapter,
-                           CommandThrottler& throttler,
-                           uint8_t logicalAddress,
-                           uint8_t code);
+[[nodiscard]] ThrottledCommand sendKeySequence(ICecAdapter& adapter,
+                                               CommandThrottler& throttler,
+                                               uint8_t logicalAddress,
+                                               const uint8_t* codes,
+                                               std::size_t count);
 
 /**
- * Log a one-shot snapshot of active CEC devices and their power status.
- * Used during daemon start-up to capture the bus at boot. Not a wire
- * command — kept alongside the command bodies because it also operates
- * solely through @c ICecAdapter.
+ * Throttled raw frame, sent as given on the lane of its destination.
+ * Nothing about the frame is checked here: the dispatcher has already
+ * held its opcode against [Daemon] RawOpcodes.
  */
-void logDeviceSnapshot(ICecAdapter& adapter);
+[[nodiscard]] ThrottledCommand transmitRaw(ICecAdapter& adapter,
+                                           CommandThrottler& throttler,
+                                           const RawFrame& frame);
 
 } // namespace ops
 } // namespace cec_control
@@ -0,0 +1,626 @@
+#include "simulated_adapter.h"
+
+#include "../../common/logger.h"
+#include "../../common/messages.h"
+#include "../../common/trace.h"
+#include "../metrics.h"
+#include "../startup_report.h"
+#include "frame_decoder.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace cec_control {
+
+namespace {
+
+// This host's place on the simulated bus: the address libcec claims
+// for a playback device, behind the TV's first HDMI input.
+constexpr CEC::cec_logical_address kHost = CEC::CECDEVICE_PLAYBACKDEVICE1;
+constexpr uint16_t kHostPhysical = 0x1000;
+
+// TV inputs `source` can select, HDMI 1 to 4. Devices past the last
+// one sit behind it, as they would behind an AV receiver there.
+constexpr uint16_t kTvInputs = kLastHdmiSource - kFirstHdmiSource + 1;
+
+// What an absent device's physical address reads as, as in libcec.
+constexpr uint16_t kInvalidPhysical = 0xFFFF;
+
+// Pulse-Eight's OUI; every simulated device reports it.
+constexpr uint32_t kSimulatedVendorId = 0x001582;
+
+constexpr uint8_t kMaxVolume = 100;
+
+// Reports the backend hands off per wake before its queues grow; a
+// command makes one or two, so a steady run never reallocates them.
+constexpr std::size_t kReportBatch = 16;
+
+} // namespace
+
+SimulatedCecAdapter::SimulatedCecAdapter(AdapterConfig config, SimulatorConfig simulator,
+                                         Callbacks callbacks)
+    : m_config(std::move(config)),
+      m_sim(std::move(simulator)),
+      m_observationCallback(std::move(callbacks.onObservation)),
+      m_connectionLostCallback(std::move(callbacks.onConnectionLost)),
+      m_frameFilter(callbacks.frames),
+      m_rawFrameFilter(callbacks.rawFrames),
+      m_capture(callbacks.capture) {}
+
+SimulatedCecAdapter::~SimulatedCecAdapter() {
+    closeConnection();
+}
+
+bool SimulatedCecAdapter::initialize() {
+    LOG_INFO("Initializing simulated CEC bus");
+    // Timed as libcec's load, which it stands in for.
+    const ScopedStartupPhase phase(StartupPhase::LibcecInit);
+    if (m_initialized) {
+        LOG_WARNING("Simulated CEC bus already initialized");
+        return true;
+    }
+
+    if (!m_sim.replayFile.empty() && !loadReplay()) return false;
+
+    // Logged, so a run with surprising results can be replayed.
+    const uint32_t seed = m_sim.seed != 0 ? m_sim.seed : std::random_device{}();
+    m_workerRng.seed(seed);
+    m_backendRng.seed(seed + 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // The TV is the root; everything else sits behind its own input,
+    // HDMI 1 being this host, until the inputs run out.
+    uint16_t port   = 2;
+    uint16_t branch = 1;
+    std::size_t count = 0;
+    for (uint8_t a = 0; a < CEC::CECDEVICE_BROADCAST; ++a) {
+        const auto logical = static_cast<CEC::cec_logical_address>(a);
+        if (logical != kHost && !m_sim.devices.IsSet(logical)) continue;
+        Device& device = m_devices[a];
+        device.present = true;
+        if (logical == kHost) {
+            device.power    = CEC::CEC_POWER_STATUS_ON;
+            device.physical = kHostPhysical;
+            device.name     = m_config.deviceName;
+            continue;
+        }
+        ++count;
+        if (logical == CEC::CECDEVICE_TV) {
+            device.physical = 0x0000;
+            device.name     = "TV";
+        } else {
+            device.physical = port <= kTvInputs
+                ? static_cast<uint16_t>(port++ << 12)
+                : static_cast<uint16_t>(kTvInputs << 12 | branch++ << 8);
+            device.name     = "Device " + std::to_string(a);
+        }
+    }
+
+    LOG_INFO("Simulated CEC bus ready: ", count, " device(s), seed ", seed);
+    m_initialized = true;
+    return true;
+}
+
+bool SimulatedCecAdapter::openConnection() {
+    LOG_INFO("Opening simulated CEC adapter connection");
+    if (!m_initialized) {
+        LOG_ERROR("Cannot open connection, simulated bus not initialized");
+        return false;
+    }
+    if (m_connected.load(std::memory_order_acquire)) {
+        LOG_INFO("Connection already open");
+        return true;
+    }
+
+    const ScopedStartupPhase phase(StartupPhase::AdapterOpen);
+    // A simulated loss leaves the backend idling; start a fresh one.
+    stopBackend();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+        m_reports.clear();
+        m_devices[kHost].name = m_config.deviceName;
+        // Recorded frames keep their place on the timeline; the ones
+        // that arrived while the link was down are lost, as they were.
+        const auto now = Clock::now();
+        if (!m_replayStart) m_replayStart = now;
+        while (m_replayNext < m_replayFrames.size() &&
+               *m_replayStart + m_replayFrames[m_replayNext].offset < now) {
+            ++m_replayNext;
+        }
+    }
+    m_connected.store(true, std::memory_order_release);
+    m_backend = std::thread(&SimulatedCecAdapter::backendLoop, this);
+    LOG_INFO("Simulated CEC adapter connection opened");
+    return true;
+}
+
+void SimulatedCecAdapter::closeConnection() {
+    const bool wasConnected = m_connected.exchange(false, std::memory_order_acq_rel);
+    stopBackend();
+    if (wasConnected) LOG_INFO("Simulated CEC adapter connection closed");
+}
+
+bool SimulatedCecAdapter::reopenConnection() {
+    LOG_INFO("Reopening simulated CEC adapter connection");
+    closeConnection();
+    return openConnection();
+}
+
+bool SimulatedCecAdapter::isConnected() const {
+    return m_connected.load(std::memory_order_acquire);
+}
+
+void SimulatedCecAdapter::reconfigure(AdapterConfig config) {
+    m_config = std::move(config);
+}
+
+template <typename R, typename Fn>
+R SimulatedCecAdapter::call(AdapterCall kind, R fallback, Fn&& fn) const {
+    if (!m_initialized || !m_connected.load(std::memory_order_acquire)) return fallback;
+    ScopedLatency timer(Metrics::Latency::LibcecCall);
+    const TraceScope span(TracePoint::LibcecCall);
+    const bool command = isCommand(kind);
+    const Clock::time_point started = Clock::now();
+    bool acknowledged = true;
+    if (!replayCall(kind, acknowledged)) {
+        blockFor(command ? m_sim.commandLatencyMs : m_sim.queryLatencyMs);
+        acknowledged = !command || m_sim.nackPercent == 0 ||
+                       std::uniform_int_distribution<uint32_t>(1, 100)(m_workerRng) >
+                           m_sim.nackPercent;
+    }
+    enforceCallBudget(Clock::now() - started);
+    if (command && !acknowledged) {
+        LOG_DEBUG("Simulated bus: command not acknowledged");
+        return fallback;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // The link may have dropped while the call was on the bus.
+    if (!m_connected.load(std::memory_order_acquire)) return fallback;
+    return fn();
+}
+
+bool SimulatedCecAdapter::replayCall(AdapterCall kind, bool& acknowledged) const {
+    auto& recorded = m_replayCalls[static_cast<std::size_t>(kind)];
+    if (recorded.empty()) return false;
+    const ReplayCall next = recorded.front();
+    recorded.pop_front();
+    if (next.duration > std::chrono::microseconds::zero()) {
+        std::this_thread::sleep_for(next.duration);
+    }
+    acknowledged = next.acknowledged;
+    return true;
+}
+
+bool SimulatedCecAdapter::loadReplay() {
+    const auto records = TrafficCapture::load(m_sim.replayFile);
+    if (!records) return false;
+
+    // Frame times count from the recorded adapter open, which is what
+    // openConnection stands in for here; a capture without one (the
+    // ring wrapped past it) counts from its first record.
+    uint64_t originUs = records->empty() ? 0 : records->front().timeUs;
+    for (const CaptureRecord& record : *records) {
+        if (record.kind == CaptureKind::Call && record.call == AdapterCall::Open) {
+            originUs = record.timeUs;
+            break;
+        }
+    }
+
+    std::size_t calls = 0;
+    for (const CaptureRecord& record : *records) {
+        if (record.kind == CaptureKind::Frame) {
+            ReplayFrame replay;
+            replay.offset = std::chrono::microseconds(
+                record.timeUs > originUs ? record.timeUs - originUs : 0);
+            replay.frame.initiator      = record.initiator;
+            replay.frame.destination    = record.destination;
+            replay.frame.opcode         = record.opcode;
+            replay.frame.parameterCount =
+                std::min<uint8_t>(record.parameterCount, kMaxRawParameters);
+            replay.frame.parameters     = record.parameters;
+            m_replayFrames.push_back(replay);
+        } else if (record.kind == CaptureKind::Call &&
+                   static_cast<std::size_t>(record.call) < kAdapterCallCount) {
+            m_replayCalls[static_cast<std::size_t>(record.call)].push_back(
+                ReplayCall{std::chrono::microseconds(record.durationUs), record.result != 0});
+            ++calls;
+        }
+    }
+    LOG_INFO("Replaying ", m_replayFrames.size(), " frame(s) and ", calls, " call(s) from ",
+             m_sim.replayFile);
+    return true;
+}
+
+void SimulatedCecAdapter::receive(const RawFrame& frame) {
+    if (m_capture) m_capture->recordFrame(frame);
+    decodeFrame(frame, m_frameFilter, m_rawFrameFilter, m_observationCallback);
+}
+
+void SimulatedCecAdapter::enforceCallBudget(Clock::duration elapsed) const {
+    const uint32_t budgetMs = m_config.callBudgetMs;
+    if (budgetMs == 0 || elapsed <= std::chrono::milliseconds(budgetMs)) return;
+    if (!m_connected.exchange(false, std::memory_order_acq_rel)) return;
+    LOG_ERROR("Simulated call took ",
+              std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(),
+              " ms, over the ", budgetMs, " ms budget; treating the adapter as wedged");
+    Metrics::getInstance().increment(Metrics::Counter::CallBudgetExceeded);
+    if (m_connectionLostCallback) m_connectionLostCallback();
+}
+
+void SimulatedCecAdapter::blockFor(uint32_t meanMs) const {
+    const auto delay = draw(m_workerRng, meanMs, m_sim.latency);
+    if (delay > Clock::duration::zero()) std::this_thread::sleep_for(delay);
+}
+
+bool SimulatedCecAdapter::powerOnDevice(CEC::cec_logical_address address) {
+    return call(AdapterCall::PowerOn, false,
+                [&] { return setPower(address, CEC::CEC_POWER_STATUS_ON); });
+}
+
+bool SimulatedCecAdapter::standbyDevice(CEC::cec_logical_address address) {
+    return call(AdapterCall::Standby, false,
+                [&] { return setPower(address, CEC::CEC_POWER_STATUS_STANDBY); });
+}
+
+bool SimulatedCecAdapter::broadcastStandby() {
+    return call(AdapterCall::BroadcastStandby, false, [&] {
+        return setPower(CEC::CECDEVICE_BROADCAST, CEC::CEC_POWER_STATUS_STANDBY);
+    });
+}
+
+bool SimulatedCecAdapter::volumeUp() {
+    return call(AdapterCall::VolumeUp, false, [&] {
+        if (!find(CEC::CECDEVICE_AUDIOSYSTEM)) return false;
+        m_volume = static_cast<uint8_t>(std::min<int>(m_volume + 1, kMaxVolume));
+        m_muted  = false;
+        return true;
+    });
+}
+
+bool SimulatedCecAdapter::volumeDown() {
+    return call(AdapterCall::VolumeDown, false, [&] {
+        if (!find(CEC::CECDEVICE_AUDIOSYSTEM)) return false;
+        m_volume = static_cast<uint8_t>(std::max<int>(m_volume - 1, 0));
+        m_muted  = false;
+        return true;
+    });
+}
+
+bool SimulatedCecAdapter::toggleMute() {
+    return call(AdapterCall::ToggleMute, false, [&] {
+        if (!find(CEC::CECDEVICE_AUDIOSYSTEM)) return false;
+        m_muted = !m_muted;
+        return true;
+    });
+}
+
+bool SimulatedCecAdapter::sendKeypress(CEC::cec_logical_address address,
+                                       CEC::cec_user_control_code /*key*/,
+                                       bool /*release*/) {
+    return call(AdapterCall::Keypress, false, [&] { return find(address) != nullptr; });
+}
+
+bool SimulatedCecAdapter::setStreamPath(uint16_t physicalAddress) {
+    // A broadcast: acknowledged whether or not anything sits there.
+    return call(AdapterCall::StreamPath, false, [&] {
+        for (uint8_t a = 0; a < CEC::CECDEVICE_BROADCAST; ++a) {
+            const Device& device = m_devices[a];
+            if (device.present && device.physical == physicalAddress) {
+                setActiveSource(static_cast<CEC::cec_logical_address>(a));
+                break;
+            }
+        }
+        return true;
+    });
+}
+
+bool SimulatedCecAdapter::transmitRaw(const RawFrame& frame) {
+    // Nothing interprets the frame; a directed one is acknowledged by
+    // any device present at its destination. Only the host's own
+    // address may send, as with libcec.
+    return call(AdapterCall::TransmitRaw, false, [&] {
+        if (frame.initiator != kLogicalAddressUnknown && (frame.initiator & 0x0F) != kHost) {
+            LOG_WARNING("Refusing raw frame from address ", static_cast<int>(frame.initiator),
+                        ": not one the adapter claimed");
+            return false;
+        }
+        return frame.destination == CEC::CECDEVICE_BROADCAST ||
+               find(static_cast<CEC::cec_logical_address>(frame.destination & 0x0F)) != nullptr;
+    });
+}
+
+uint16_t SimulatedCecAdapter::getDevicePhysicalAddress(CEC::cec_logical_address address) const {
+    return call(AdapterCall::PhysicalAddress, uint16_t{0}, [&] {
+        const Device* device = find(address);
+        return device ? device->physical : kInvalidPhysical;
+    });
+}
+
+bool SimulatedCecAdapter::isDeviceActive(CEC::cec_logical_address address) const {
+    return call(AdapterCall::IsActive, false, [&] { return find(address) != nullptr; });
+}
+
+CEC::cec_power_status SimulatedCecAdapter::getDevicePowerStatus(
+    CEC::cec_logical_address address) const {
+    return call(AdapterCall::PowerStatus, CEC::CEC_POWER_STATUS_UNKNOWN, [&] {
+        const Device* device = find(address);
+        return device ? device->power : CEC::CEC_POWER_STATUS_UNKNOWN;
+    });
+}
+
+std::string SimulatedCecAdapter::getDeviceOSDName(CEC::cec_logical_address address) const {
+    return call(AdapterCall::OsdName, std::string{}, [&] {
+        const Device* device = find(address);
+        return device ? device->name : std::string{};
+    });
+}
+
+uint32_t SimulatedCecAdapter::getDeviceVendorId(CEC::cec_logical_address address) const {
+    return call(AdapterCall::VendorId, uint32_t{CEC::CEC_VENDOR_UNKNOWN}, [&] {
+        return find(address) ? kSimulatedVendorId : uint32_t{CEC::CEC_VENDOR_UNKNOWN};
+    });
+}
+
+CEC::cec_version SimulatedCecAdapter::getDeviceCecVersion(CEC::cec_logical_address address) const {
+    return call(AdapterCall::CecVersion, CEC::CEC_VERSION_UNKNOWN, [&] {
+        return find(address) ? CEC::CEC_VERSION_1_4 : CEC::CEC_VERSION_UNKNOWN;
+    });
+}
+
+CEC::cec_logical_addresses SimulatedCecAdapter::getActiveDevices() const {
+    CEC::cec_logical_addresses empty;
+    empty.Clear();
+    return call(AdapterCall::ActiveDevices, empty, [&] {
+        CEC::cec_logical_addresses active;
+        active.Clear();
+        for (uint8_t a = 0; a < CEC::CECDEVICE_BROADCAST; ++a) {
+            if (m_devices[a].present) active.Set(static_cast<CEC::cec_logical_address>(a));
+        }
+        return active;
+    });
+}
+
+CEC::cec_logical_address SimulatedCecAdapter::getActiveSource() const {
+    return call(AdapterCall::ActiveSource, CEC::CECDEVICE_UNKNOWN,
+                [&] { return m_activeSource; });
+}
+
+uint8_t SimulatedCecAdapter::getAudioStatus() const {
+    return call(AdapterCall::AudioStatus, uint8_t{CEC::CEC_AUDIO_VOLUME_STATUS_UNKNOWN}, [&] {
+        if (!find(CEC::CECDEVICE_AUDIOSYSTEM)) {
+            return uint8_t{CEC::CEC_AUDIO_VOLUME_STATUS_UNKNOWN};
+        }
+        return static_cast<uint8_t>(m_volume | (m_muted ? CEC::CEC_AUDIO_MUTE_STATUS_MASK : 0));
+    });
+}
+
+// Bus model ------------------------------------------------------------
+
+bool SimulatedCecAdapter::setPower(CEC::cec_logical_address address,
+                                   CEC::cec_power_status power) {
+    if (address == CEC::CECDEVICE_BROADCAST) {
+        for (uint8_t a = 0; a < CEC::CECDEVICE_BROADCAST; ++a) {
+            const auto logical = static_cast<CEC::cec_logical_address>(a);
+            if (logical == kHost || !m_devices[a].present) continue;
+            m_devices[a].power = power;
+            reportPower(logical);
+        }
+        return true;
+    }
+    Device* device = find(address);
+    if (!device) return false;  // nothing acknowledges the frame
+    if (address == kHost) return true;
+    device->power = power;
+    reportPower(address);
+    return true;
+}
+
+void SimulatedCecAdapter::setActiveSource(CEC::cec_logical_address address) {
+    const CEC::cec_logical_address previous = m_activeSource;
+    m_activeSource = address;
+
+    Observation obs;
+    if (previous == kHost && address != kHost) {
+        obs.kind    = Observation::Kind::HostDeactivated;
+        obs.logical = kHost;
+        report(obs);
+    }
+    if (address == kHost) {
+        // libcec announces this host itself; only the edge is seen.
+        if (previous == kHost) return;
+        obs.kind    = Observation::Kind::HostActivated;
+        obs.logical = kHost;
+        report(obs);
+        return;
+    }
+    obs.kind            = Observation::Kind::ActiveSource;
+    obs.logical         = address;
+    obs.physicalAddress = m_devices[address].physical;
+    report(obs);
+}
+
+void SimulatedCecAdapter::reportPower(CEC::cec_logical_address address) {
+    Observation obs;
+    obs.power = m_devices[address].power;
+    if (address == CEC::CECDEVICE_TV) {
+        obs.kind = Observation::Kind::TvPowerReport;
+    } else {
+        obs.kind    = Observation::Kind::PowerReport;
+        obs.logical = address;
+    }
+    report(obs);
+}
+
+void SimulatedCecAdapter::report(const Observation& obs) {
+    m_reports.push_back(obs);
+    m_cv.notify_one();
+}
+
+void SimulatedCecAdapter::injectObservation() {
+    std::vector<CEC::cec_logical_address> others;
+    for (uint8_t a = 0; a < CEC::CECDEVICE_BROADCAST; ++a) {
+        if (a != kHost && m_devices[a].present) {
+            others.push_back(static_cast<CEC::cec_logical_address>(a));
+        }
+    }
+    if (others.empty()) return;
+
+    const auto address = others[std::uniform_int_distribution<std::size_t>(
+        0, others.size() - 1)(m_backendRng)];
+    Device& device = m_devices[address];
+    switch (std::uniform_int_distribution<int>(0, 2)(m_backendRng)) {
+    case 0:
+        // Someone reached for the device's own remote.
+        if (device.power == CEC::CEC_POWER_STATUS_ON) {
+            device.power = CEC::CEC_POWER_STATUS_STANDBY;
+            if (address == CEC::CECDEVICE_TV) {
+                Observation obs;
+                obs.kind = Observation::Kind::TvStandby;  // a broadcast <Standby>
+                report(obs);
+                return;
+            }
+        } else {
+            device.power = CEC::CEC_POWER_STATUS_ON;
+        }
+        reportPower(address);
+        return;
+    case 1:
+        setActiveSource(address);
+        return;
+    default: {
+        Observation obs;
+        obs.kind            = Observation::Kind::PhysicalAddressReport;
+        obs.logical         = address;
+        obs.physicalAddress = device.physical;
+        report(obs);
+        return;
+    }
+    }
+}
+
+void SimulatedCecAdapter::backendLoop() {
+    ::pthread_setname_np(::pthread_self(), "cec-sim-bus");
+    const LogContextScope logContext(LogContext{LogSubsystem::Libcec});
+
+    const auto schedule = [this](uint32_t meanMs) -> std::optional<Clock::time_point> {
+        if (meanMs == 0) return std::nullopt;
+        return Clock::now() + draw(m_backendRng, meanMs, SimulatorConfig::Latency::Exponential);
+    };
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto nextObservation = schedule(m_sim.observationIntervalMs);
+    auto nextLoss        = schedule(m_sim.connectionLossIntervalMs);
+    std::vector<Observation> batch;
+    std::vector<RawFrame>    replayed;
+    // The two swap each pass, so both keep the room.
+    m_reports.reserve(kReportBatch);
+    batch.reserve(kReportBatch);
+
+    const auto nextReplay = [this]() -> std::optional<Clock::time_point> {
+        if (m_replayNext >= m_replayFrames.size() ||
+            !m_connected.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        return *m_replayStart + m_replayFrames[m_replayNext].offset;
+    };
+
+    while (!m_stopping) {
+        if (!m_reports.empty()) {
+            batch.swap(m_reports);
+            lock.unlock();
+            for (const Observation& obs : batch) {
+                if (m_capture) {
+                    if (const auto frame = frameFor(obs)) m_capture->recordFrame(*frame);
+                }
+                if (m_observationCallback) m_observationCallback(obs);
+            }
+            batch.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (const auto due = nextReplay(); due && *due <= Clock::now()) {
+            const auto now = Clock::now();
+            while (m_replayNext < m_replayFrames.size() &&
+                   *m_replayStart + m_replayFrames[m_replayNext].offset <= now) {
+                replayed.push_back(m_replayFrames[m_replayNext++].frame);
+            }
+            lock.unlock();
+            for (const RawFrame& frame : replayed) receive(frame);
+            replayed.clear();
+            lock.lock();
+            continue;
+        }
+
+        std::optional<Clock::time_point> wake = nextObservation;
+        if (nextLoss && (!wake || *nextLoss < *wake)) wake = nextLoss;
+        if (const auto due = nextReplay(); due && (!wake || *due < *wake)) wake = due;
+        if (wake) {
+            m_cv.wait_until(lock, *wake);
+        } else {
+            m_cv.wait(lock);
+        }
+        if (m_stopping) break;
+
+        const auto now = Clock::now();
+        if (nextObservation && now >= *nextObservation) {
+            injectObservation();
+            nextObservation = schedule(m_sim.observationIntervalMs);
+        }
+        if (nextLoss && now >= *nextLoss) {
+            LOG_ERROR("CEC connection lost (simulated)");
+            m_connected.store(false, std::memory_order_release);
+            // A dead link reports nothing more until it is reopened.
+            m_reports.clear();
+            nextObservation.reset();
+            nextLoss.reset();
+            lock.unlock();
+            if (m_connectionLostCallback) m_connectionLostCallback();
+            lock.lock();
+        }
+    }
+}
+
+void SimulatedCecAdapter::stopBackend() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    if (m_backend.joinable()) m_backend.join();
+}
+
+SimulatedCecAdapter::Clock::duration SimulatedCecAdapter::draw(
+    std::mt19937& rng, uint32_t meanMs, SimulatorConfig::Latency shape) {
+    if (meanMs == 0) return Clock::duration::zero();
+    double ms = meanMs;
+    switch (shape) {
+    case SimulatorConfig::Latency::Fixed:
+        break;
+    case SimulatorConfig::Latency::Uniform:
+        ms = std::uniform_real_distribution<double>(0.0, 2.0 * meanMs)(rng);
+        break;
+    case SimulatorConfig::Latency::Exponential:
+        ms = std::exponential_distribution<double>(1.0 / meanMs)(rng);
+        break;
+    }
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(ms));
+}
+
+SimulatedCecAdapter::Device* SimulatedCecAdapter::find(
+    CEC::cec_logical_address address) noexcept {
+    if (address < CEC::CECDEVICE_TV || address >= CEC::CECDEVICE_BROADCAST) return nullptr;
+    Device& device = m_devices[address];
+    return device.present ? &device : nullptr;
+}
+
+const SimulatedCecAdapter::Device* SimulatedCecAdapter::find(
+    CEC::cec_logical_address address) const noexcept {
+    return const_cast<SimulatedCecAdapter*>(this)->find(address);
+}
+
+} // namespace cec_control
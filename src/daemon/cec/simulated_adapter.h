@@ -0,0 +1,237 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libcec/cec.h>
+
+#include "adapter_config.h"
+#include "adapter_interface.h"
+#include "traffic_capture.h"
+
+namespace cec_control {
+
+/**
+ * @class SimulatedCecAdapter
+ * @brief @c ICecAdapter over an in-process model of a CEC bus, for
+ *        measuring the daemon without HDMI hardware.
+ *
+ * The bus holds the devices named in @c SimulatorConfig::devices plus
+ * this host as playback device 1. Commands change their state the way
+ * the real devices would — a power-on turns the TV on, a stream path
+ * moves the active source — and each call blocks the calling worker
+ * for a drawn latency first, so the worker, throttler and socket paths
+ * see the same timing shape they see over libcec. A configured share
+ * of commands is left unacknowledged and returns false.
+ *
+ * ## Threading contract
+ *
+ * As for @c LibCecAdapter: the owning @c AdapterWorker thread is the
+ * only caller of the public members. The bus model is additionally
+ * read by a backend thread, started by @c openConnection and joined
+ * by @c closeConnection, so it sits behind @c m_mutex.
+ *
+ * ## Callback threads
+ *
+ * Like libcec's command-receive and alert threads, the backend thread
+ * is where every callback fires: the reports devices send in answer to
+ * a command, unsolicited ones injected at
+ * @c SimulatorConfig::observationIntervalMs, and simulated connection
+ * losses. Callbacks run with no lock held.
+ *
+ * ## Replay
+ *
+ * Given a traffic capture (@c SimulatorConfig::replayFile), the bus
+ * plays it back on top of the model: each recorded frame is received
+ * at its original offset from the recorded adapter open, counted from
+ * the first @c openConnection here, and decoded as @c LibCecAdapter
+ * decodes it; each call takes the duration the next recorded call of
+ * its kind took, and a command recorded as unacknowledged fails
+ * again. What the model answers is unchanged. Once the recording of a
+ * kind runs out, calls of that kind go back to drawn latencies.
+ *
+ * With @c Callbacks::capture set, the reports the bus sends are
+ * recorded as the frames that would carry them, so a simulator run
+ * can itself be captured and replayed.
+ */
+class SimulatedCecAdapter final : public ICecAdapter {
+public:
+    SimulatedCecAdapter(AdapterConfig config, SimulatorConfig simulator,
+                        Callbacks callbacks);
+    ~SimulatedCecAdapter() override;
+
+    // Lifecycle ---------------------------------------------------------
+    [[nodiscard]] bool initialize() override;
+    [[nodiscard]] bool openConnection() override;
+    void closeConnection() override;
+    [[nodiscard]] bool reopenConnection() override;
+    [[nodiscard]] bool isConnected() const override;
+    void reconfigure(AdapterConfig config) override;
+
+    // Commands ----------------------------------------------------------
+    [[nodiscard]] bool powerOnDevice(CEC::cec_logical_address address) override;
+    [[nodiscard]] bool standbyDevice(CEC::cec_logical_address address) override;
+    [[nodiscard]] bool broadcastStandby() override;
+    [[nodiscard]] bool volumeUp() override;
+    [[nodiscard]] bool volumeDown() override;
+    [[nodiscard]] bool toggleMute() override;
+    [[nodiscard]] bool sendKeypress(CEC::cec_logical_address address,
+                                    CEC::cec_user_control_code key,
+                                    bool release) override;
+    [[nodiscard]] bool setStreamPath(uint16_t physicalAddress) override;
+    [[nodiscard]] bool transmitRaw(const RawFrame& frame) override;
+
+    // Queries -----------------------------------------------------------
+    [[nodiscard]] uint16_t getDevicePhysicalAddress(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] bool isDeviceActive(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] CEC::cec_power_status getDevicePowerStatus(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] std::string getDeviceOSDName(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] uint32_t getDeviceVendorId(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] CEC::cec_version getDeviceCecVersion(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] CEC::cec_logical_addresses getActiveDevices() const override;
+    [[nodiscard]] CEC::cec_logical_address getActiveSource() const override;
+    [[nodiscard]] uint8_t getAudioStatus() const override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /** One logical address on the simulated bus. */
+    struct Device {
+        bool                  present  = false;
+        CEC::cec_power_status power    = CEC::CEC_POWER_STATUS_STANDBY;
+        uint16_t              physical = 0;
+        std::string           name;
+    };
+
+    /**
+     * Block for one drawn latency, or the replayed one of @p kind, then
+     * run @p fn under the bus lock — unless the connection is down, or
+     * @p kind is a command the draw or the recording leaves
+     * unacknowledged, in which case @p fallback. Timed like a libcec
+     * call so the adapter metrics read the same on either backend, and
+     * held to the same @c AdapterConfig::callBudgetMs: a draw over it
+     * fails the call and drops the link as @c LibCecAdapter would.
+     */
+    template <typename R, typename Fn>
+    R call(AdapterCall kind, R fallback, Fn&& fn) const;
+
+    /**
+     * Block for the next recorded duration of @p kind and set
+     * @p acknowledged to how that call went; false, having done
+     * neither, once the recording of it is used up. Worker thread.
+     */
+    bool replayCall(AdapterCall kind, bool& acknowledged) const;
+
+    /** Load @c SimulatorConfig::replayFile into the replay queues. */
+    [[nodiscard]] bool loadReplay();
+
+    /** Deliver @p frame as received from the bus. Backend thread, no lock held. */
+    void receive(const RawFrame& frame);
+
+    /** As @c LibCecAdapter::enforceCallBudget. Worker thread. */
+    void enforceCallBudget(Clock::duration elapsed) const;
+
+    /** Sleep for a latency drawn around @p meanMs. Worker thread only. */
+    void blockFor(uint32_t meanMs) const;
+
+    /**
+     * Set @p address — every device but this host, for broadcast — to
+     * @p power and queue the report it answers with. Bus lock held.
+     */
+    bool setPower(CEC::cec_logical_address address, CEC::cec_power_status power);
+
+    /** Make @p address the active source and queue its announcement. Bus lock held. */
+    void setActiveSource(CEC::cec_logical_address address);
+
+    /** Queue @p obs for the backend thread and wake it. Bus lock held. */
+    void report(const Observation& obs);
+
+    /** Report the power state of @p address; bus lock held. */
+    void reportPower(CEC::cec_logical_address address);
+
+    /** Change something on the bus unprompted. Backend thread, bus lock held. */
+    void injectObservation();
+
+    /** Backend thread body: deliver reports and replayed frames, inject noise, lose the link. */
+    void backendLoop();
+
+    /** Stop and join the backend thread, if it runs. */
+    void stopBackend();
+
+    /** A gap drawn around @p meanMs from @p rng, scattered as @p shape. */
+    [[nodiscard]] static Clock::duration draw(std::mt19937& rng, uint32_t meanMs,
+                                              SimulatorConfig::Latency shape);
+
+    /** The device at @p address, or null if nothing answers there. */
+    [[nodiscard]] Device*       find(CEC::cec_logical_address address) noexcept;
+    [[nodiscard]] const Device* find(CEC::cec_logical_address address) const noexcept;
+
+    AdapterConfig   m_config;
+    SimulatorConfig m_sim;
+    const std::function<void(Observation)> m_observationCallback;
+    const std::function<void()>            m_connectionLostCallback;
+    const FrameFilter* const               m_frameFilter;
+    const FrameFilter* const               m_rawFrameFilter;
+    TrafficCapture* const                  m_capture;
+    bool m_initialized = false;
+
+    /** A recorded frame and when, after the recorded open, it arrived. */
+    struct ReplayFrame {
+        Clock::duration offset;
+        RawFrame        frame;
+    };
+    /** How one recorded call went. */
+    struct ReplayCall {
+        std::chrono::microseconds duration;
+        bool                      acknowledged;
+    };
+
+    // Loaded by initialize and not resized after. The frames are read
+    // by the backend thread under m_mutex; the calls are the worker's.
+    std::vector<ReplayFrame>                             m_replayFrames;
+    std::size_t                                          m_replayNext = 0;
+    std::optional<Clock::time_point>                     m_replayStart;
+    mutable std::array<std::deque<ReplayCall>, kAdapterCallCount> m_replayCalls;
+
+    // Cross-thread connection hint, as on LibCecAdapter: cleared by
+    // the backend thread on a simulated loss and by an overrun call.
+    mutable std::atomic<bool> m_connected{false};
+
+    // The bus model and the backend's hand-off queue.
+    mutable std::mutex        m_mutex;
+    std::condition_variable   m_cv;
+    std::array<Device, 16>    m_devices{};
+    CEC::cec_logical_address  m_activeSource = CEC::CECDEVICE_UNKNOWN;
+    uint8_t                   m_volume       = 20;
+    bool                      m_muted        = false;
+    std::vector<Observation>  m_reports;
+    bool                      m_stopping     = false;
+
+    // Each thread draws from its own generator, so a fixed seed replays
+    // the same latencies and the same bus noise.
+    mutable std::mt19937 m_workerRng;
+    std::mt19937         m_backendRng;
+
+    // Joined by closeConnection, which the destructor runs before any
+    // member above goes away.
+    std::thread m_backend;
+};
+
+} // namespace cec_control
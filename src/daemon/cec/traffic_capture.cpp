@@ -0,0 +1,360 @@
+#include "traffic_capture.h"
+
+#include "../../common/logger.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace cec_control {
+
+/**
+ * First bytes of the file. @c written counts every record ever
+ * claimed, so a reader can tell how far the ring has wrapped.
+ */
+struct TrafficCapture::Header {
+    uint32_t              magic;
+    uint32_t              version;
+    uint32_t              recordSize;
+    uint32_t              capacity;
+    std::atomic<uint64_t> written;
+    /** Wall time the capture was opened at, in microseconds since the epoch. */
+    int64_t               startedUnixUs;
+};
+
+namespace {
+
+constexpr std::size_t kHeaderSize = 32;
+
+uint64_t microsecondsBetween(TrafficCapture::Clock::time_point from,
+                             TrafficCapture::Clock::time_point to) noexcept {
+    if (to <= from) return 0;
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+} // namespace
+
+TrafficCapture::~TrafficCapture() {
+    if (m_header != nullptr) ::munmap(m_header, m_mapped);
+}
+
+bool TrafficCapture::open(const std::string& path, uint32_t capacity) {
+    static_assert(sizeof(Header) == kHeaderSize, "the capture header layout is part of the file format");
+    if (m_header != nullptr || capacity == 0) return false;
+
+    // Keep the previous run's recording, which is most often the one
+    // wanted: the daemon was restarted because something went wrong.
+    const std::string previous = path + ".1";
+    if (::rename(path.c_str(), previous.c_str()) != 0 && errno != ENOENT) {
+        LOG_WARNING("Cannot keep the previous traffic capture as ", previous, ": ",
+                    std::strerror(errno));
+    }
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        LOG_ERROR("Cannot create traffic capture ", path, ": ", std::strerror(errno));
+        return false;
+    }
+    const std::size_t size = kHeaderSize + std::size_t{capacity} * sizeof(CaptureRecord);
+    // Reserve every block now: a sparse file whose filesystem fills up
+    // later would fault the recording thread with SIGBUS mid-store.
+    const int reserved = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+    if (reserved != 0) {
+        ::close(fd);
+        LOG_ERROR("Cannot reserve ", size, " bytes for traffic capture ", path, ": ",
+                  std::strerror(reserved), "; running without a capture");
+        ::unlink(path.c_str());
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int err = errno;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_ERROR("Cannot map traffic capture ", path, ": ", std::strerror(err));
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    auto* header          = new (mapped) Header{};
+    header->magic         = kMagic;
+    header->version       = kVersion;
+    header->recordSize    = sizeof(CaptureRecord);
+    header->capacity      = capacity;
+    header->startedUnixUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header->written.store(0, std::memory_order_release);
+
+    m_header   = header;
+    m_records  = reinterpret_cast<CaptureRecord*>(static_cast<char*>(mapped) + kHeaderSize);
+    m_mapped   = size;
+    m_capacity = capacity;
+    m_epoch    = Clock::now();
+    LOG_INFO("Capturing CEC traffic to ", path, " (last ", capacity, " records)");
+    return true;
+}
+
+CaptureRecord* TrafficCapture::claim(Clock::time_point at) noexcept {
+    const uint64_t n = m_header->written.fetch_add(1, std::memory_order_relaxed);
+    CaptureRecord* record = &m_records[n % m_capacity];
+    // Cleared first, so a reader racing the wrap sees an empty slot
+    // rather than one record's header with another's parameters.
+    record->kind   = CaptureKind::Empty;
+    record->timeUs = microsecondsBetween(m_epoch, at);
+    return record;
+}
+
+void TrafficCapture::recordFrame(const RawFrame& frame) noexcept {
+    if (m_header == nullptr) return;
+    CaptureRecord* record  = claim(Clock::now());
+    record->durationUs     = 0;
+    record->result         = 0;
+    record->call           = AdapterCall::Open;
+    record->initiator      = frame.initiator;
+    record->destination    = frame.destination;
+    record->opcode         = frame.opcode;
+    record->parameterCount = frame.parameterCount;
+    record->parameters     = frame.parameters;
+    record->kind           = CaptureKind::Frame;
+}
+
+void TrafficCapture::recordCall(AdapterCall call, Clock::time_point started, uint32_t result,
+                                const RawFrame& args) noexcept {
+    if (m_header == nullptr) return;
+    const uint64_t duration = microsecondsBetween(started, Clock::now());
+    CaptureRecord* record  = claim(started);
+    record->durationUs     = static_cast<uint32_t>(std::min<uint64_t>(duration, UINT32_MAX));
+    record->result         = result;
+    record->call           = call;
+    record->initiator      = args.initiator;
+    record->destination    = args.destination;
+    record->opcode         = args.opcode;
+    record->parameterCount = args.parameterCount;
+    record->parameters     = args.parameters;
+    record->kind           = CaptureKind::Call;
+}
+
+std::optional<std::vector<CaptureRecord>> TrafficCapture::load(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("Cannot open traffic capture ", path, ": ", std::strerror(errno));
+        return std::nullopt;
+    }
+    struct stat st{};
+    void* mapped = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(kHeaderSize)) {
+        mapped = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE,
+                        fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_ERROR("Cannot read traffic capture ", path);
+        return std::nullopt;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+
+    const auto* header = static_cast<const Header*>(mapped);
+    std::optional<std::vector<CaptureRecord>> records;
+    if (header->magic != kMagic || header->version != kVersion ||
+        header->recordSize != sizeof(CaptureRecord) || header->capacity == 0 ||
+        size < kHeaderSize + std::size_t{header->capacity} * sizeof(CaptureRecord)) {
+        LOG_ERROR(path, " is not a version ", kVersion, " traffic capture");
+    } else {
+        const auto* ring = reinterpret_cast<const CaptureRecord*>(
+            static_cast<const char*>(mapped) + kHeaderSize);
+        const uint64_t written  = header->written.load(std::memory_order_acquire);
+        const uint64_t capacity = header->capacity;
+        const uint64_t held     = std::min(written, capacity);
+        records.emplace();
+        records->reserve(static_cast<std::size_t>(held));
+        for (uint64_t n = written - held; n < written; ++n) {
+            const CaptureRecord& record = ring[n % capacity];
+            if (record.kind != CaptureKind::Empty) records->push_back(record);
+        }
+        std::stable_sort(records->begin(), records->end(),
+                         [](const CaptureRecord& a, const CaptureRecord& b) {
+                             return a.timeUs < b.timeUs;
+                         });
+        if (written > capacity) {
+            LOG_INFO("Traffic capture ", path, " wrapped; the first ", written - capacity,
+                     " records were overwritten");
+        }
+    }
+    ::munmap(mapped, size);
+    return records;
+}
+
+// CapturingCecAdapter -------------------------------------------------
+
+namespace {
+
+RawFrame addressed(CEC::cec_logical_address address) noexcept {
+    RawFrame args;
+    args.destination = static_cast<uint8_t>(address);
+    return args;
+}
+
+uint32_t fromBool(bool value) noexcept { return value ? 1 : 0; }
+
+} // namespace
+
+CapturingCecAdapter::CapturingCecAdapter(std::unique_ptr<ICecAdapter> inner,
+                                         TrafficCapture& capture)
+    : m_inner(std::move(inner)), m_capture(capture) {}
+
+template <typename Fn, typename Encode>
+auto CapturingCecAdapter::timed(AdapterCall call, const RawFrame& args, Fn&& fn,
+                                Encode encode) const {
+    const auto started = TrafficCapture::Clock::now();
+    auto result = fn();
+    m_capture.recordCall(call, started, encode(result), args);
+    return result;
+}
+
+bool CapturingCecAdapter::initialize() {
+    return m_inner->initialize();
+}
+
+bool CapturingCecAdapter::openConnection() {
+    return timed(AdapterCall::Open, {}, [&] { return m_inner->openConnection(); }, fromBool);
+}
+
+void CapturingCecAdapter::closeConnection() {
+    const auto started = TrafficCapture::Clock::now();
+    m_inner->closeConnection();
+    m_capture.recordCall(AdapterCall::Close, started, 0);
+}
+
+bool CapturingCecAdapter::reopenConnection() {
+    return timed(AdapterCall::Reopen, {}, [&] { return m_inner->reopenConnection(); }, fromBool);
+}
+
+bool CapturingCecAdapter::isConnected() const {
+    return m_inner->isConnected();
+}
+
+void CapturingCecAdapter::reconfigure(AdapterConfig config) {
+    m_inner->reconfigure(std::move(config));
+}
+
+bool CapturingCecAdapter::powerOnDevice(CEC::cec_logical_address address) {
+    return timed(AdapterCall::PowerOn, addressed(address),
+                 [&] { return m_inner->powerOnDevice(address); }, fromBool);
+}
+
+bool CapturingCecAdapter::standbyDevice(CEC::cec_logical_address address) {
+    return timed(AdapterCall::Standby, addressed(address),
+                 [&] { return m_inner->standbyDevice(address); }, fromBool);
+}
+
+bool CapturingCecAdapter::broadcastStandby() {
+    return timed(AdapterCall::BroadcastStandby, {},
+                 [&] { return m_inner->broadcastStandby(); }, fromBool);
+}
+
+bool CapturingCecAdapter::volumeUp() {
+    return timed(AdapterCall::VolumeUp, {}, [&] { return m_inner->volumeUp(); }, fromBool);
+}
+
+bool CapturingCecAdapter::volumeDown() {
+    return timed(AdapterCall::VolumeDown, {}, [&] { return m_inner->volumeDown(); }, fromBool);
+}
+
+bool CapturingCecAdapter::toggleMute() {
+    return timed(AdapterCall::ToggleMute, {}, [&] { return m_inner->toggleMute(); }, fromBool);
+}
+
+bool CapturingCecAdapter::sendKeypress(CEC::cec_logical_address address,
+                                       CEC::cec_user_control_code key, bool release) {
+    RawFrame args = addressed(address);
+    args.opcode         = static_cast<uint8_t>(key);
+    args.parameterCount = 1;
+    args.parameters[0]  = release ? 1 : 0;
+    return timed(AdapterCall::Keypress, args,
+                 [&] { return m_inner->sendKeypress(address, key, release); }, fromBool);
+}
+
+bool CapturingCecAdapter::setStreamPath(uint16_t physicalAddress) {
+    RawFrame args;
+    args.parameterCount = 2;
+    args.parameters[0]  = static_cast<uint8_t>(physicalAddress >> 8);
+    args.parameters[1]  = static_cast<uint8_t>(physicalAddress & 0xFF);
+    return timed(AdapterCall::StreamPath, args,
+                 [&] { return m_inner->setStreamPath(physicalAddress); }, fromBool);
+}
+
+bool CapturingCecAdapter::transmitRaw(const RawFrame& frame) {
+    return timed(AdapterCall::TransmitRaw, frame, [&] { return m_inner->transmitRaw(frame); },
+                 fromBool);
+}
+
+uint16_t CapturingCecAdapter::getDevicePhysicalAddress(CEC::cec_logical_address address) const {
+    return timed(AdapterCall::PhysicalAddress, addressed(address),
+                 [&] { return m_inner->getDevicePhysicalAddress(address); },
+                 [](uint16_t value) { return uint32_t{value}; });
+}
+
+bool CapturingCecAdapter::isDeviceActive(CEC::cec_logical_address address) const {
+    return timed(AdapterCall::IsActive, addressed(address),
+                 [&] { return m_inner->isDeviceActive(address); }, fromBool);
+}
+
+CEC::cec_power_status CapturingCecAdapter::getDevicePowerStatus(
+    CEC::cec_logical_address address) const {
+    return timed(AdapterCall::PowerStatus, addressed(address),
+                 [&] { return m_inner->getDevicePowerStatus(address); },
+                 [](CEC::cec_power_status value) { return static_cast<uint32_t>(value); });
+}
+
+std::string CapturingCecAdapter::getDeviceOSDName(CEC::cec_logical_address address) const {
+    // The name itself is not kept; its length tells an answer from none.
+    return timed(AdapterCall::OsdName, addressed(address),
+                 [&] { return m_inner->getDeviceOSDName(address); },
+                 [](const std::string& value) { return static_cast<uint32_t>(value.size()); });
+}
+
+uint32_t CapturingCecAdapter::getDeviceVendorId(CEC::cec_logical_address address) const {
+    return timed(AdapterCall::VendorId, addressed(address),
+                 [&] { return m_inner->getDeviceVendorId(address); },
+                 [](uint32_t value) { return value; });
+}
+
+CEC::cec_version CapturingCecAdapter::getDeviceCecVersion(CEC::cec_logical_address address) const {
+    return timed(AdapterCall::CecVersion, addressed(address),
+                 [&] { return m_inner->getDeviceCecVersion(address); },
+                 [](CEC::cec_version value) { return static_cast<uint32_t>(value); });
+}
+
+CEC::cec_logical_addresses CapturingCecAdapter::getActiveDevices() const {
+    return timed(AdapterCall::ActiveDevices, {}, [&] { return m_inner->getActiveDevices(); },
+                 [](const CEC::cec_logical_addresses& value) {
+                     uint32_t mask = 0;
+                     for (uint8_t a = 0; a < 16; ++a) {
+                         if (value.IsSet(static_cast<CEC::cec_logical_address>(a))) {
+                             mask |= 1u << a;
+                         }
+                     }
+                     return mask;
+                 });
+}
+
+CEC::cec_logical_address CapturingCecAdapter::getActiveSource() const {
+    return timed(AdapterCall::ActiveSource, {}, [&] { return m_inner->getActiveSource(); },
+                 [](CEC::cec_logical_address value) { return static_cast<uint32_t>(value); });
+}
+
+uint8_t CapturingCecAdapter::getAudioStatus() const {
+    return timed(AdapterCall::AudioStatus, {}, [&] { return m_inner->getAudioStatus(); },
+                 [](uint8_t value) { return uint32_t{value}; });
+}
+
+} // namespace cec_control
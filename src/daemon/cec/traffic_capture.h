@@ -0,0 +1,221 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../../common/messages.h"
+#include "adapter_interface.h"
+
+namespace cec_control {
+
+/** Which @c ICecAdapter member a @c CaptureRecord of kind @c Call timed. */
+enum class AdapterCall : uint8_t {
+    Open,
+    Close,
+    Reopen,
+    PowerOn,
+    Standby,
+    BroadcastStandby,
+    VolumeUp,
+    VolumeDown,
+    ToggleMute,
+    Keypress,
+    StreamPath,
+    TransmitRaw,
+    PhysicalAddress,
+    IsActive,
+    PowerStatus,
+    OsdName,
+    VendorId,
+    CecVersion,
+    ActiveDevices,
+    ActiveSource,
+    AudioStatus,
+};
+
+inline constexpr std::size_t kAdapterCallCount =
+    static_cast<std::size_t>(AdapterCall::AudioStatus) + 1;
+
+/** Whether @p call puts a frame on the bus, as against asking libcec's view of it. */
+[[nodiscard]] constexpr bool isCommand(AdapterCall call) noexcept {
+    return call >= AdapterCall::PowerOn && call <= AdapterCall::TransmitRaw;
+}
+
+/** What a @c CaptureRecord holds; 0 marks a slot never written. */
+enum class CaptureKind : uint8_t {
+    Empty = 0,
+    Frame = 1,  ///< A frame received from the bus, before any filtering.
+    Call  = 2,  ///< One adapter call, its arguments and how long it took.
+};
+
+/**
+ * One entry of a traffic capture. Fixed size, so the file is a plain
+ * array and appending is a store into mapped memory.
+ *
+ * A frame record carries the frame as received. A call record carries
+ * the call's arguments in the same fields: the device addressed in
+ * @c destination, a key code or raw frame's opcode in @c opcode, a
+ * physical address big-endian in @c parameters; @c result is the
+ * call's return value, a bool as 0 or 1.
+ */
+struct CaptureRecord {
+    /** Microseconds since the capture was opened. */
+    uint64_t timeUs         = 0;
+    /** How long the adapter call blocked; 0 for a frame. */
+    uint32_t durationUs     = 0;
+    uint32_t result         = 0;
+    CaptureKind kind        = CaptureKind::Empty;
+    AdapterCall call        = AdapterCall::Open;
+    uint8_t  initiator      = kLogicalAddressUnknown;
+    uint8_t  destination    = kBroadcastAddress;
+    uint8_t  opcode         = 0;
+    uint8_t  parameterCount = 0;
+    std::array<uint8_t, kMaxRawParameters> parameters{};
+    uint8_t  reserved[4]    = {};
+};
+
+static_assert(sizeof(CaptureRecord) == 40, "the capture record layout is part of the file format");
+static_assert(std::is_trivially_copyable_v<CaptureRecord>, "records are copied as bytes");
+
+/**
+ * Append-only recording of what crosses the adapter boundary, for
+ * reproducing field traffic on the simulated bus (@c [Simulator]
+ * @c ReplayFile).
+ *
+ * The file is a header and a ring of @c CaptureRecord slots, created at
+ * its full size and mapped once: recording a frame or a call claims a
+ * slot with one atomic add and fills it in, with no syscall and no
+ * lock, so the backend's receive thread and the adapter worker record
+ * side by side at the cost of a few stores. Once the ring is full the
+ * oldest records are overwritten, which keeps the last
+ * @c DaemonConfig::captureRecords of them. Opening a capture moves any
+ * file already at the path to @c PATH.1 first, so a restart after an
+ * incident keeps the recording of it.
+ *
+ * Nothing is flushed explicitly: the kernel writes the shared mapping
+ * back in its own time and at unmap, and a reader mapping the file
+ * meanwhile sees the records as they are written.
+ */
+class TrafficCapture {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /** "CECR" in the first word. */
+    static constexpr uint32_t kMagic   = 0x52434543;
+    /** Bumped with any change to the header or record layout. */
+    static constexpr uint32_t kVersion = 1;
+
+    TrafficCapture() = default;
+    ~TrafficCapture();
+
+    TrafficCapture(const TrafficCapture&)            = delete;
+    TrafficCapture& operator=(const TrafficCapture&) = delete;
+
+    /**
+     * Create @p path with room for @p capacity records and map it.
+     * Returns false, with the reason logged, if it cannot; the capture
+     * then records nothing.
+     */
+    [[nodiscard]] bool open(const std::string& path, uint32_t capacity);
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_header != nullptr; }
+
+    /** Record a frame received from the bus. Any thread. */
+    void recordFrame(const RawFrame& frame) noexcept;
+
+    /**
+     * Record one adapter call that started at @p started and returned
+     * @p result. @p args carries its arguments as described at
+     * @c CaptureRecord. Any thread.
+     */
+    void recordCall(AdapterCall call, Clock::time_point started, uint32_t result,
+                    const RawFrame& args = {}) noexcept;
+
+    /**
+     * The records still held by the capture at @p path, earliest
+     * @c timeUs first, or nullopt with the reason logged if it is not
+     * a capture this build can read. A call is recorded when it
+     * returns but stamped when it started, so this is not quite the
+     * order the slots were filled in.
+     */
+    [[nodiscard]] static std::optional<std::vector<CaptureRecord>> load(const std::string& path);
+
+private:
+    struct Header;
+
+    /** Claim the next slot and stamp it with @p at. */
+    CaptureRecord* claim(Clock::time_point at) noexcept;
+
+    Header*           m_header   = nullptr;
+    CaptureRecord*    m_records  = nullptr;
+    std::size_t       m_mapped   = 0;
+    uint32_t          m_capacity = 0;
+    Clock::time_point m_epoch;
+};
+
+/**
+ * @c ICecAdapter decorator that times every call into @p inner and
+ * records it in a @c TrafficCapture. Received frames are recorded by
+ * the backend itself (@c ICecAdapter::Callbacks::capture), since only
+ * it sees them before they are filtered. Same threading as the
+ * adapter it wraps.
+ */
+class CapturingCecAdapter final : public ICecAdapter {
+public:
+    CapturingCecAdapter(std::unique_ptr<ICecAdapter> inner, TrafficCapture& capture);
+
+    [[nodiscard]] bool initialize() override;
+    [[nodiscard]] bool openConnection() override;
+    void closeConnection() override;
+    [[nodiscard]] bool reopenConnection() override;
+    [[nodiscard]] bool isConnected() const override;
+    void reconfigure(AdapterConfig config) override;
+
+    [[nodiscard]] bool powerOnDevice(CEC::cec_logical_address address) override;
+    [[nodiscard]] bool standbyDevice(CEC::cec_logical_address address) override;
+    [[nodiscard]] bool broadcastStandby() override;
+    [[nodiscard]] bool volumeUp() override;
+    [[nodiscard]] bool volumeDown() override;
+    [[nodiscard]] bool toggleMute() override;
+    [[nodiscard]] bool sendKeypress(CEC::cec_logical_address address,
+                                    CEC::cec_user_control_code key,
+                                    bool release) override;
+    [[nodiscard]] bool setStreamPath(uint16_t physicalAddress) override;
+    [[nodiscard]] bool transmitRaw(const RawFrame& frame) override;
+
+    [[nodiscard]] uint16_t getDevicePhysicalAddress(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] bool isDeviceActive(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] CEC::cec_power_status getDevicePowerStatus(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] std::string getDeviceOSDName(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] uint32_t getDeviceVendorId(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] CEC::cec_version getDeviceCecVersion(
+        CEC::cec_logical_address address) const override;
+    [[nodiscard]] CEC::cec_logical_addresses getActiveDevices() const override;
+    [[nodiscard]] CEC::cec_logical_address getActiveSource() const override;
+    [[nodiscard]] uint8_t getAudioStatus() const override;
+
+private:
+    /**
+     * Run @p fn, record it as @p call with @p args, and return its
+     * result; @p encode turns that result into the record's word.
+     */
+    template <typename Fn, typename Encode>
+    auto timed(AdapterCall call, const RawFrame& args, Fn&& fn, Encode encode) const;
+
+    std::unique_ptr<ICecAdapter> m_inner;
+    TrafficCapture&              m_capture;
+};
+
+} // namespace cec_control
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cec_control {
+
+/**
+ * @brief Scheduling class of a job on the @c AdapterWorker.
+ *
+ * The worker serves classes in declaration order, subject to its
+ * anti-starvation rule (see @c AdapterWorker). Kept in its own header
+ * so the dispatch table can name a row's class without pulling the
+ * worker — and through it libcec — into every includer.
+ *
+ *  - @c Lifecycle    suspend prep, resume / reconnect reopens, the
+ *                    operator-triggered adapter restart. Bounded by
+ *                    external deadlines (logind's inhibitor delay), so
+ *                    it must never wait behind a command backlog.
+ *  - @c Interactive  wire commands a user is waiting on.
+ *  - @c Background   best-effort bus scans nobody is blocked on.
+ */
+enum class WorkPriority : uint8_t {
+    Lifecycle,
+    Interactive,
+    Background,
+};
+
+inline constexpr std::size_t kWorkPriorityCount = 3;
+
+} // namespace cec_control
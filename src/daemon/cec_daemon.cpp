@@ -1,34 +1,133 @@
 #include "cec_daemon.h"
 
+#include <algorithm>
 #include <chrono>
 #include <csignal>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
+#include "../common/config_manager.h"
 #include "../common/logger.h"
 #include "../common/system_paths.h"
 #include "../common/systemd_notify.h"
+#include "../common/trace.h"
 // Full definitions of the subsystems cec_daemon.h forward-declares.
 // Placed here so this TU can construct, call into, and destroy each
 // one; cec_daemon.h stays thin and does not transitively pull libcec
 // or sd-bus through these headers.
+#include "adapter_bus.h"
 #include "adapter_lifecycle.h"
 #include "cec/adapter_worker.h"
 #include "cec/libcec_adapter.h"
-#include "cec/operations.h"
+#include "cec/simulated_adapter.h"
+#include "cec/traffic_capture.h"
 #include "command_dispatch.h"
 #include "command_dispatcher.h"
 #include "dbus_monitor.h"
+#include "device_profiles.h"
+#include "device_state_cache.h"
+#include "flight_recorder.h"
 #include "hook/cec_hook_subsystem.h"
 #include "hook/hook_executor.h"
+#include "hook/hook_helper.h"
+#include "metrics_exporter.h"
+#include "network_server.h"
 #include "power/power_supervisor.h"
 #include "socket_server.h"
 #include "standby_policy.h"
+#include "startup_report.h"
+#include "status_page_writer.h"
+#include "thread_schedule.h"
+#include "udev_monitor.h"
 
 namespace cec_control {
 
-CECDaemon::CECDaemon(AppConfig config)
+namespace {
+
+/**
+ * Wire form of @p obs for event subscribers, or nullopt for the kinds
+ * that only feed internal state (non-TV power reports, physical
+ * address reports).
+ */
+std::optional<BusEvent> toBusEvent(const ICecAdapter::Observation& obs) {
+    using Kind = ICecAdapter::Observation::Kind;
+    BusEvent event;
+    const uint8_t logical = obs.logical == CEC::CECDEVICE_UNKNOWN
+        ? kLogicalAddressUnknown
+        : static_cast<uint8_t>(obs.logical);
+    switch (obs.kind) {
+    case Kind::TvStandby:
+        event.kind = BusEventKind::TvStandby;
+        return event;
+    case Kind::TvPowerReport:
+        event.kind        = BusEventKind::TvPowerReport;
+        event.powerStatus = static_cast<uint8_t>(obs.power);
+        return event;
+    case Kind::ActiveSource:
+        event.kind            = BusEventKind::ActiveSource;
+        event.physicalAddress = obs.physicalAddress;
+        event.logicalAddress  = logical;
+        return event;
+    case Kind::HostActivated:
+    case Kind::HostDeactivated:
+        event.kind = obs.kind == Kind::HostActivated ? BusEventKind::HostActivated
+                                                     : BusEventKind::HostDeactivated;
+        event.logicalAddress = logical;
+        return event;
+    case Kind::RawFrame:
+        event.kind           = BusEventKind::RawFrame;
+        event.logicalAddress = obs.frame.initiator;
+        event.frame          = obs.frame;
+        return event;
+    case Kind::PowerReport:
+    case Kind::PhysicalAddressReport:
+        break;
+    }
+    return std::nullopt;
+}
+
+/** Put @p obs in the flight recorder, with the one value it carries. */
+void recordObservation(const ICecAdapter::Observation& obs) noexcept {
+    using Kind = ICecAdapter::Observation::Kind;
+    static_assert(static_cast<int>(Kind::RawFrame) ==
+                      static_cast<int>(flight_log::ObservationKind::RawFrame),
+                  "flight_log::ObservationKind mirrors Observation::Kind");
+    uint32_t what = 0;
+    switch (obs.kind) {
+    case Kind::TvPowerReport:
+    case Kind::PowerReport:
+        what = static_cast<uint32_t>(obs.power);
+        break;
+    case Kind::ActiveSource:
+    case Kind::PhysicalAddressReport:
+        what = obs.physicalAddress;
+        break;
+    case Kind::RawFrame:
+        what = obs.frame.opcode;
+        break;
+    case Kind::TvStandby:
+    case Kind::HostActivated:
+    case Kind::HostDeactivated:
+        break;
+    }
+    const uint8_t device = obs.kind == Kind::RawFrame ? obs.frame.initiator
+                         : obs.logical == CEC::CECDEVICE_UNKNOWN
+                             ? kLogicalAddressUnknown
+                             : static_cast<uint8_t>(obs.logical);
+    FlightRecorder::getInstance().observation(
+        static_cast<flight_log::ObservationKind>(obs.kind), device, what);
+}
+
+} // namespace
+
+CECDaemon::CECDaemon(AppConfig config, std::string configPath)
     : m_signals{SIGINT, SIGTERM, SIGHUP, SIGCHLD},
-      m_config(std::move(config)) {}
+      m_config(std::move(config)),
+      m_configPath(std::move(configPath)) {}
 
 CECDaemon::~CECDaemon() {
     stop();
@@ -37,14 +136,6 @@ CECDaemon::~CECDaemon() {
 bool CECDaemon::start() {
     LOG_INFO("Starting CEC daemon");
 
-    // Fail fast on a structurally broken dispatch table before any
-    // subsystem that would consume it is constructed. The validator
-    // logs one error per violation.
-    if (!validateDispatchTable()) {
-        LOG_ERROR("Dispatch table validation failed; aborting start");
-        return false;
-    }
-
     if (!m_signals.valid()) {
         LOG_ERROR("Signal source not initialised; aborting start");
         return false;
@@ -53,15 +144,35 @@ bool CECDaemon::start() {
         LOG_ERROR("Main-thread work queue not initialised; aborting start");
         return false;
     }
-    if (!m_suspendSafetyTimer.valid() ||
-        !m_reconnectRetryTimer.valid() ||
-        !m_watchdogTimer.valid() ||
-        !m_hookDebounceTimer.valid()) {
-        LOG_ERROR("Timer source(s) not initialised; aborting start");
+    if (!m_observations.valid()) {
+        LOG_ERROR("Observation bus not initialised; aborting start");
+        return false;
+    }
+    if (!m_loop.timersValid()) {
+        LOG_ERROR("Event loop timers not initialised; aborting start");
         return false;
     }
 
     try {
+        using flight_log::Milestone;
+        // First, so the rest of the start is on the record; optional
+        // like the capture below.
+        if (m_config.daemon.flightRecorder &&
+            FlightRecorder::getInstance().open(SystemPaths::getFlightRecorderPath())) {
+            FlightRecorder::getInstance().milestone(Milestone::DaemonStarting);
+        }
+
+        subscribeObservers();
+
+        // A capture that cannot be opened is logged and run without:
+        // it is a diagnostic, not a reason to refuse to start.
+        if (!m_config.daemon.captureFile.empty()) {
+            auto capture = std::make_unique<TrafficCapture>();
+            if (capture->open(m_config.daemon.captureFile, m_config.daemon.captureRecords)) {
+                m_capture = std::move(capture);
+            }
+        }
+
         // Build the adapter on the main thread. Callbacks target
         // daemon forwarders so the wiring does not depend on the
         // dispatcher's construction order, and so libcec-thread entry
@@ -71,52 +182,102 @@ bool CECDaemon::start() {
                 this->onAdapterObservation(obs);
             },
             /*onConnectionLost*/ [this]() { this->onAdapterConnectionLost(); },
+            /*frames*/           &m_frameFilter,
+            /*rawFrames*/        &m_rawFrameFilter,
+            /*capture*/          m_capture.get(),
         };
+        rebuildFrameFilters();
         // Copy (not move) the adapter config: the daemon keeps
         // m_config intact for a future SIGHUP reload diff, and the
         // sub-struct is small enough that the copy is noise.
-        auto adapter = std::make_unique<LibCecAdapter>(
-            m_config.adapter, std::move(adapterCallbacks));
-
-        // initialize() loads libcec and detects adapter hardware. It
-        // does NOT spawn libcec's command or alert threads — those
-        // start inside openConnection() below.
-        if (!adapter->initialize()) {
-            LOG_ERROR("Failed to initialize CEC adapter library");
-            return false;
+        std::unique_ptr<ICecAdapter> adapter;
+        if (m_config.simulator.enabled) {
+            LOG_WARNING("Using the simulated CEC bus; no HDMI devices will be controlled");
+            adapter = std::make_unique<SimulatedCecAdapter>(
+                m_config.adapter, m_config.simulator, std::move(adapterCallbacks));
+        } else {
+            adapter = std::make_unique<LibCecAdapter>(
+                m_config.adapter, std::move(adapterCallbacks));
+        }
+        if (m_capture) {
+            adapter = std::make_unique<CapturingCecAdapter>(std::move(adapter), *m_capture);
         }
 
-        // Open the adapter on the main thread. libcec's Open is
-        // thread-identity-agnostic: the internal command and alert
-        // threads it spawns reference only the stable address of the
-        // callback struct embedded in the adapter, not the calling
-        // thread's identity. Doing it here keeps the startup path
-        // linear — no promise/future round trip, no worker submit
-        // before the worker is even spawned. From m_worker->start()
-        // onwards the worker is the sole thread that invokes any
-        // other libcec method, and its close-on-exit handles teardown.
-        if (!adapter->openConnection()) {
-            LOG_ERROR("Failed to open CEC adapter connection");
-            return false;
+        // With DeferAdapterOpen both steps below instead run as the
+        // worker's first job (see openAsync further down), so the
+        // socket serves and readiness is reported without waiting on
+        // libcec's multi-second detection and Open.
+        if (!m_config.daemon.deferAdapterOpen) {
+            // initialize() loads libcec and detects adapter hardware.
+            // It does NOT spawn libcec's command or alert threads —
+            // those start inside openConnection() below.
+            if (!adapter->initialize()) {
+                LOG_ERROR("Failed to initialize CEC adapter library");
+                FlightRecorder::getInstance().milestone(Milestone::AdapterOpen, false);
+                return false;
+            }
+
+            // Open the adapter on the main thread. libcec's Open is
+            // thread-identity-agnostic: the internal command and alert
+            // threads it spawns reference only the stable address of
+            // the callback struct embedded in the adapter, not the
+            // calling thread's identity. Doing it here keeps the
+            // startup path linear — no promise/future round trip, no
+            // worker submit before the worker is even spawned. From
+            // m_worker->start() onwards the worker is the sole thread
+            // that invokes any other libcec method, and its
+            // close-on-exit handles teardown.
+            //
+            // The threads Open spawns inherit the calling thread's
+            // scheduling, so the adapter's [Scheduling] settings are in
+            // force around the call, as they are on the worker for a
+            // deferred open or a reopen.
+            bool opened = false;
+            {
+                const ScopedThreadSchedule schedule(m_config.scheduling.adapter, "main");
+                opened = adapter->openConnection();
+            }
+            FlightRecorder::getInstance().milestone(Milestone::AdapterOpen, opened);
+            if (!opened) {
+                LOG_ERROR("Failed to open CEC adapter connection");
+                return false;
+            }
         }
 
-        m_worker = std::make_unique<AdapterWorker>(std::move(adapter));
+        m_worker = std::make_unique<AdapterWorker>(
+            std::move(adapter), m_config.dispatcher.maxQueuedCommands);
 
         // Lifecycle goes first: it owns the suspend queue and exposes
         // isSuspended/enqueue, both of which the dispatcher needs.
-        m_lifecycle = std::make_unique<AdapterLifecycle>(*m_worker, m_work);
+        PowerFanoutConfig fanout;
+        fanout.wakeDevices     = m_config.adapter.wakeDevices;
+        fanout.powerOffDevices = m_config.adapter.powerOffDevices;
+        m_lifecycle = std::make_unique<AdapterLifecycle>(
+            *m_worker, m_work, fanout, m_adapterIdleTimer,
+            std::chrono::milliseconds(m_config.daemon.adapterIdleCloseMs));
+
+        // Device-state cache: fed by the observation forwarder and by
+        // the dispatcher's command outcomes, so it is built before the
+        // dispatcher.
+        m_stateCache = std::make_unique<DeviceStateCache>(
+            m_config.stateCache, *m_worker, m_work, m_config.daemon.lowMemory);
+
+        if (!m_config.simulator.enabled) {
+            m_profiles = std::make_unique<DeviceProfileStore>(
+                SystemPaths::getDeviceProfilesPath());
+            m_profiles->load();
+        }
 
         // Standby policy: plain flag plus an install-once suspend
         // trigger fired from the main thread when a TvStandby
         // observation arrives and auto-standby is enabled. The
-        // adapter forwarder has already hopped the observation through
-        // @c m_work before @c observe runs, so the trigger itself is
-        // main-thread; the extra @c m_work.post inside it defers the
-        // sd-bus call to the next drain iteration rather than running
-        // it inline under the current observation closure. Built
-        // before the dispatcher (which holds a reference to the
-        // policy); the forwarder null-guards callbacks fired during
-        // the narrow window between @c Open() and this assignment.
+        // observation bus delivers on the main thread before
+        // @c observe runs, so the trigger itself is main-thread; the
+        // @c m_work.post inside it defers the sd-bus call to the next
+        // drain rather than running it inline under the bus's
+        // delivery. Built before the dispatcher (which holds a
+        // reference to the policy); the bus consumer null-guards
+        // observations delivered before this assignment.
         //
         // The policy starts unarmed — it only begins processing
         // observations after the @c arm() post scheduled at the end
@@ -147,13 +308,31 @@ bool CECDaemon::start() {
         // the executor inherits the SIG_BLOCK mask set by m_signals
         // (which also now covers SIGCHLD) because m_signals is
         // constructed before start() runs.
-        m_hookExecutor = std::make_unique<HookExecutor>();
-        m_hookExecutor->start();
+        HookExecutor::Limits hookLimits;
+        hookLimits.maxConcurrent = m_config.hooks.maxConcurrent;
+        hookLimits.coalesce      = m_config.hooks.coalesce;
+        hookLimits.timeout       = std::chrono::milliseconds(m_config.hooks.timeoutMs);
+        m_hookExecutor = std::make_unique<HookExecutor>(hookLimits);
+        if (!m_hookExecutor->start(m_config.scheduling.hooks)) {
+            LOG_WARNING("Hook executor unavailable; hook scripts will not run");
+        }
+        if (!m_config.hooks.helper.empty()) {
+            // Spawned from here for the same inherited mask; a failed
+            // first spawn is retried by the first event.
+            m_hookHelper = std::make_unique<HookHelper>(
+                m_loop, m_config.hooks.helper,
+                CecHookSubsystem::sanitisedParentEnv());
+            m_hookHelper->start();
+        }
         m_hooks = std::make_unique<CecHookSubsystem>(
-            m_config.hooks, *m_hookExecutor, m_hookDebounceTimer);
+            m_config.hooks, *m_hookExecutor, m_hookDebounceTimer,
+            m_hookTvPowerTimer, m_hookHelper.get());
 
         m_dispatcher = std::make_unique<CommandDispatcher>(
-            m_config, *m_worker, m_work, *m_lifecycle, *m_standbyPolicy);
+            m_config, *m_worker, m_work, *m_lifecycle, *m_standbyPolicy,
+            *m_stateCache, m_keyRepeatTimer);
+
+        buildAdapterBuses();
 
         // Build the supervisor over the dispatcher (for replay) and
         // the lifecycle (for suspend/resume/reconnect), plus the
@@ -169,33 +348,139 @@ bool CECDaemon::start() {
         // down. Capturing @c this by value is safe: the supervisor
         // lives inside @c this, so the pointer is valid for every
         // invocation of the callback.
+        //
+        // Every [Adapter.NAME] bus joins the default one, so a system
+        // suspend or resume drives all of them at once.
+        std::vector<PowerSupervisor::Bus> supervised;
+        supervised.push_back(
+            PowerSupervisor::Bus{{}, *m_dispatcher, *m_lifecycle, m_reconnectRetryTimer});
+        for (const auto& bus : m_buses) {
+            supervised.push_back(PowerSupervisor::Bus{bus->name(), bus->dispatcher(),
+                                                      bus->lifecycle(),
+                                                      bus->reconnectRetryTimer()});
+        }
         m_supervisor = std::make_unique<PowerSupervisor>(
-            *m_dispatcher, *m_lifecycle, *m_worker,
-            m_suspendSafetyTimer, m_reconnectRetryTimer,
+            std::move(supervised), m_suspendSafetyTimer, m_wakeProbeTimer,
             [this]() { this->requestUnrecoverableShutdown(); });
 
-        m_worker->start();
+        Tracer::getInstance().setEnabled(m_config.daemon.traceEnabled);
+        m_worker->start(m_config.scheduling.adapter);
+
+        if (m_config.daemon.deferAdapterOpen) {
+            // Submitted before any other adapter work, so the open runs
+            // first and the startup scan below waits behind it. Held
+            // commands replay through the dispatcher in arrival order.
+            m_lifecycle->openAsync(
+                [this](bool adapterValid,
+                       std::vector<AdapterLifecycle::HeldCommand> held) {
+                    m_adapterReadyTimer.disarm();
+                    for (auto& entry : held) {
+                        if (adapterValid) {
+                            m_dispatcher->dispatch(std::move(entry.command),
+                                                   std::move(entry.reply));
+                        } else {
+                            entry.reply(Message(MessageType::RESP_NOT_READY));
+                        }
+                    }
+                    m_supervisor->onDeferredOpenCompleted(PowerSupervisor::kDefaultBus,
+                                                          adapterValid);
+                });
+            const auto readyTimeout =
+                std::chrono::milliseconds(m_config.daemon.adapterReadyTimeoutMs);
+            if (readyTimeout.count() > 0 && !m_adapterReadyTimer.armOnce(readyTimeout)) {
+                LOG_WARNING("Failed to arm adapter-ready timer; commands wait for the open");
+            }
+        }
+
+        // The further buses open on their own workers, alongside the
+        // default one and each other.
+        for (std::size_t i = 0; i < m_buses.size(); ++i) {
+            AdapterBus& bus = *m_buses[i];
+            const std::size_t index = i + 1;
+            bus.reconnectRetryTimer().setHandler([this, index] {
+                m_supervisor->onReconnectRetryTimerFired(index);
+            });
+            if (!bus.start(m_config, [this, index](bool adapterValid) {
+                    m_supervisor->onDeferredOpenCompleted(index, adapterValid);
+                })) {
+                return false;
+            }
+        }
 
         if (m_config.daemon.scanDevicesAtStartup) {
-            LOG_INFO("Scanning for CEC devices...");
-            m_worker->submit([](ICecAdapter& adapter) {
-                ops::logDeviceSnapshot(adapter);
+            // Profiles are keyed on what the scan learns, so they can
+            // only be matched to lanes once it has finished.
+            StartupReport::getInstance().start(StartupPhase::DeviceScan);
+            m_stateCache->scanTopology([this](bool ok) {
+                StartupReport::getInstance().finish(StartupPhase::DeviceScan);
+                if (ok) attachDeviceProfiles();
             });
         } else {
             LOG_INFO("Skipping device scanning");
         }
 
         m_socketServer = std::make_unique<SocketServer>(
-            m_loop, SystemPaths::getSocketPath());
+            m_loop, SystemPaths::getSocketPath(), m_config.daemon.maxConnections,
+            ClientRateLimit{m_config.daemon.rateLimitPerSecond,
+                            m_config.daemon.rateLimitBurst});
         m_socketServer->setCommandHandler(
-            [this](Message command, ResponseSink reply) {
-                this->handleCommand(std::move(command), std::move(reply));
+            [this](Message command, ResponseSink reply, const RequestOptions& options) {
+                this->handleCommand(std::move(command), std::move(reply), options);
             });
-        if (!m_socketServer->start()) {
+        m_socketServer->setSubscriptionHandler([this](BusEventMask subscribed) {
+            m_subscribedEvents = subscribed;
+            rebuildFrameFilters();
+        });
+        bool listening = false;
+        {
+            const ScopedStartupPhase phase(StartupPhase::SocketListen);
+            listening = m_socketServer->start();
+        }
+        if (!listening) {
             LOG_ERROR("Failed to start socket server");
             return false;
         }
 
+        // Observability only: a scrape endpoint that cannot bind is
+        // reported and skipped, never fatal to the daemon.
+        if (!m_config.metrics.listen.empty()) {
+            m_metricsExporter = std::make_unique<MetricsExporter>(
+                m_loop, m_config.metrics.listen);
+            if (!m_metricsExporter->start()) {
+                LOG_WARNING("Metrics exporter disabled");
+                m_metricsExporter.reset();
+            }
+        }
+
+        // Also optional: local clients keep the Unix socket whatever
+        // becomes of the remote endpoint.
+        if (!m_config.network.listen.empty()) {
+            m_networkServer = std::make_unique<NetworkServer>(
+                m_loop, m_config.network.listen, m_config.network.tokenFile,
+                ClientRateLimit{m_config.daemon.rateLimitPerSecond,
+                                m_config.daemon.rateLimitBurst});
+            m_networkServer->setCommandHandler(
+                [this](Message command, ResponseSink reply, const RequestOptions& options) {
+                    this->handleCommand(std::move(command), std::move(reply), options);
+                });
+            if (!m_networkServer->start()) {
+                LOG_WARNING("Network control endpoint disabled");
+                m_networkServer.reset();
+            }
+        }
+
+        // Likewise optional: widgets fall back to socket queries.
+        if (m_config.daemon.statusPage) {
+            m_statusPage = std::make_unique<StatusPageWriter>(
+                SystemPaths::getStatusPagePath());
+            if (m_statusPage->start()) {
+                publishStatus();
+            } else {
+                LOG_WARNING("Status page disabled");
+                m_statusPage.reset();
+            }
+        }
+
         if (m_config.daemon.enablePowerMonitor) {
             if (!setupPowerMonitor()) {
                 LOG_WARNING("Failed to set up power monitoring. "
@@ -217,29 +502,57 @@ bool CECDaemon::start() {
             return false;
         }
         if (!m_loop.add(m_work.fd(), READ,
-                        [this](uint32_t) { m_work.drain(); })) {
+                        [this](uint32_t) {
+                            m_work.drain();
+                            scheduleStatusPublish();
+                        })) {
             LOG_ERROR("Failed to register work-queue fd with event loop");
             return false;
         }
-        if (!m_loop.add(m_suspendSafetyTimer.fd(), READ,
-                        [this](uint32_t) { m_supervisor->onSafetyTimerFired(); })) {
-            LOG_ERROR("Failed to register suspend-safety timer with event loop");
+        if (!m_loop.add(m_observations.fd(), READ,
+                        [this](uint32_t) {
+                            m_observations.drain();
+                            scheduleStatusPublish();
+                        })) {
+            LOG_ERROR("Failed to register observation-bus fd with event loop");
             return false;
         }
-        if (!m_loop.add(m_reconnectRetryTimer.fd(), READ,
-                        [this](uint32_t) { m_supervisor->onReconnectRetryTimerFired(); })) {
-            LOG_ERROR("Failed to register reconnect-retry timer with event loop");
-            return false;
-        }
-        // The hook subsystem arms this timer from observe() and never
-        // reads the fd directly; m_hooks is constructed before we get
-        // here and only reset in stop() after the loop exits, so no
-        // null check is needed — matches the other supervisor-owned
-        // timer handlers above.
-        if (!m_loop.add(m_hookDebounceTimer.fd(), READ,
-                        [this](uint32_t) { m_hooks->onDebounceTimerFired(); })) {
-            LOG_ERROR("Failed to register hook debounce timer with event loop");
-            return false;
+
+        // Timers ride the loop's shared timer wheel; each needs only
+        // its handler. The subsystems they call into are constructed
+        // above and only reset in stop() after the loop exits, so no
+        // null checks are needed. The hook subsystem arms its debounce
+        // timers from observe() and leaves expiry to this handler.
+        m_suspendSafetyTimer.setHandler([this] {
+            m_supervisor->onSafetyTimerFired();
+            scheduleStatusPublish();
+        });
+        m_reconnectRetryTimer.setHandler([this] {
+            m_supervisor->onReconnectRetryTimerFired(PowerSupervisor::kDefaultBus);
+            scheduleStatusPublish();
+        });
+        m_wakeProbeTimer.setHandler([this] {
+            m_supervisor->onWakeProbeTimerFired();
+            scheduleStatusPublish();
+        });
+        m_adapterReadyTimer.setHandler([this] {
+            m_adapterReadyTimer.consume();
+            m_lifecycle->expireHeld();
+        });
+        m_adapterIdleTimer.setHandler([this] { m_lifecycle->onIdleTimerFired(); });
+        m_hookDebounceTimer.setHandler([this] { m_hooks->onDebounceTimerFired(); });
+        m_hookTvPowerTimer.setHandler([this] { m_hooks->onTvPowerTimerFired(); });
+        m_keyRepeatTimer.setHandler([this] { m_dispatcher->onKeyRepeatTimerFired(); });
+
+        // Hotplug is an accelerator over the retry schedule, never a
+        // requirement: without it reconnects back off as before.
+        m_udevMonitor = std::make_unique<UdevMonitor>(
+            m_loop, [this](UdevMonitor::Action action, const std::string&) {
+                m_supervisor->onAdapterHotplug(action == UdevMonitor::Action::Added);
+            });
+        if (!m_udevMonitor->start()) {
+            LOG_WARNING("Adapter hotplug detection unavailable");
+            m_udevMonitor.reset();
         }
 
         if (m_dbusMonitor) {
@@ -253,20 +566,15 @@ bool CECDaemon::start() {
             }
         }
 
-        // Register the watchdog only when the unit configured one —
-        // otherwise the timer stays disarmed, its fd never fires, and
-        // we avoid registering a handler that would only ever no-op.
-        // The service manager grants us WatchdogSec; ping at half that
-        // interval so a single missed tick is not fatal.
+        // Arm the watchdog only when the unit configured one —
+        // otherwise the timer stays disarmed and its handler never
+        // runs. The service manager grants us WatchdogSec; ping at
+        // half that interval so a single missed tick is not fatal.
         std::chrono::microseconds watchdogPeriod{};
         if (SystemdNotify::watchdogEnabled(watchdogPeriod)) {
             const auto pingInterval =
                 std::chrono::duration_cast<std::chrono::milliseconds>(watchdogPeriod / 2);
-            if (!m_loop.add(m_watchdogTimer.fd(), READ,
-                            [this](uint32_t) { this->onWatchdogTimerFired(); })) {
-                LOG_ERROR("Failed to register watchdog timer with event loop");
-                return false;
-            }
+            m_watchdogTimer.setHandler([this] { this->onWatchdogTimerFired(); });
             if (!m_watchdogTimer.armPeriodic(pingInterval)) {
                 LOG_ERROR("Failed to arm watchdog timer (period=",
                           pingInterval.count(), "ms); aborting start");
@@ -280,15 +588,16 @@ bool CECDaemon::start() {
 
         // Arm the standby policy from inside the event loop's first
         // drain. Any @c TvStandby observation libcec queued during the
-        // pre-drain window (between @c Open() above and the first
-        // @c MainThreadWork::drain) precedes this post in FIFO order
-        // and is absorbed by @c StandbyPolicy::observe 's pre-arm
-        // guard; from this post onwards observations are processed
-        // normally. No equivalent gate is applied to the hook
-        // subsystem — its contract is "fire on first observation"
-        // (so startup-time scripts can re-assert state), and the
-        // @c ActiveSource debounce already collapses bursts.
+        // pre-drain window (between @c Open() above and this post) is
+        // flushed from the observation bus first and absorbed by
+        // @c StandbyPolicy::observe 's pre-arm guard; from this post
+        // onwards observations are processed normally. No equivalent
+        // gate is applied to the hook subsystem — its contract is
+        // "fire on first observation" (so startup-time scripts can
+        // re-assert state), and the @c ActiveSource debounce already
+        // collapses bursts.
         m_work.post([this]() {
+            m_observations.drain();
             if (m_standbyPolicy) m_standbyPolicy->arm();
         });
 
@@ -312,6 +621,7 @@ void CECDaemon::stop() {
     m_started = false;
 
     LOG_INFO("Stopping CEC daemon");
+    FlightRecorder::getInstance().milestone(flight_log::Milestone::DaemonStopping);
 
     // Announce a clean shutdown to the service manager before any
     // subsystem teardown can begin. A no-op outside a notify-capable
@@ -325,7 +635,8 @@ void CECDaemon::stop() {
     // Ordered teardown. The invariant is that no thread ever observes
     // a destroyed subsystem:
     //
-    //   1. detach DBusMonitor so no further bus events reach us
+    //   1. detach DBusMonitor and stop UdevMonitor so no further bus
+    //      or hotplug events reach us
     //   2. stop the socket server: close the listener and every
     //      session fd, so no new requests enter handleCommand
     //   3. flip the dispatcher's shutdown gate so any straggler call
@@ -346,17 +657,36 @@ void CECDaemon::stop() {
     //      @c m_hooks and @c m_hookExecutor after @c m_worker has
     //      joined so no observation closure posted by libcec's
     //      command thread can still run against a destroyed hook
-    //      subsystem; @c m_hookExecutor is destroyed after @c m_hooks
-    //      because the subsystem holds a reference to it. Destroy
-    //      @c m_standbyPolicy last by the same rule (the forwarder's
-    //      in-closure null checks on both are belt-and-braces).
+    //      subsystem; @c m_hookExecutor and @c m_hookHelper are
+    //      destroyed after @c m_hooks because the subsystem holds a
+    //      reference to each. Destroy
+    //      @c m_stateCache and @c m_standbyPolicy last by the same
+    //      rule (the forwarder's in-closure null checks on all three
+    //      are belt-and-braces).
     try {
         if (m_dbusMonitor) {
             m_dbusMonitor->detach();
         }
 
+        if (m_udevMonitor) {
+            m_udevMonitor->stop();
+        }
+
+        if (m_metricsExporter) {
+            m_metricsExporter->stop();
+        }
+
+        if (m_networkServer) {
+            m_networkServer->stop();
+        }
+
+        if (m_statusPage) {
+            m_statusPage->stop();
+        }
+
         if (m_socketServer) {
             const auto t0 = std::chrono::steady_clock::now();
+            m_socketServer->handOver();
             m_socketServer->stop();
             const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - t0).count();
@@ -371,6 +701,11 @@ void CECDaemon::stop() {
             m_lifecycle->shutdown();
         }
 
+        // Each further bus gates and joins its own worker.
+        for (const auto& bus : m_buses) {
+            bus->stop();
+        }
+
         if (m_worker) {
             const auto t0 = std::chrono::steady_clock::now();
             m_worker->stop();
@@ -382,17 +717,27 @@ void CECDaemon::stop() {
         if (m_dbusMonitor) {
             m_dbusMonitor->stop();
         }
+
+        if (m_hookHelper) {
+            m_hookHelper->stop();
+        }
     } catch (const std::exception& e) {
         LOG_ERROR("Exception during daemon shutdown: ", e.what());
     }
 
+    // The worker has joined, so every lane holds its final values.
+    if (m_profiles && m_dispatcher) {
+        m_profiles->capture(m_dispatcher->throttler());
+        (void)m_profiles->save();
+    }
+
     // Reset in an order that prevents dangling references / pointer
     // dereferences. m_supervisor holds non-owning refs to m_dispatcher,
     // m_lifecycle, m_worker, m_work, the timers, plus a raw pointer to
     // m_dbusMonitor; destroying it first means none of those can be
     // touched again from supervisor code paths. m_dispatcher holds a
-    // ref to m_lifecycle and to m_standbyPolicy; m_lifecycle and
-    // m_dispatcher both hold refs to m_worker.
+    // ref to m_lifecycle, m_standbyPolicy and m_stateCache; m_lifecycle,
+    // m_dispatcher and m_stateCache all hold refs to m_worker.
     //
     // m_standbyPolicy and m_hooks are observed on the main thread via
     // @c m_work-posted closures the adapter forwarder emits from
@@ -410,19 +755,29 @@ void CECDaemon::stop() {
     // holds a reference to the executor; destroying the executor
     // first would leave that reference dangling if anything later
     // called through @c m_hooks in @c stop(). The executor itself
-    // only owns its own thread and queue.
+    // only owns its own thread and queue; the helper only its socket
+    // and child.
     //
     // Chain:
-    // supervisor → dispatcher → lifecycle → worker → hooks →
-    //   hookExecutor → standbyPolicy.
+    // supervisor → further buses → dispatcher → lifecycle → worker → hooks →
+    //   hookHelper → hookExecutor → stateCache → profiles →
+    //   standbyPolicy.
     m_supervisor.reset();
     m_dbusMonitor.reset();
+    m_udevMonitor.reset();
+    m_metricsExporter.reset();
+    m_networkServer.reset();
+    m_statusPage.reset();
     m_socketServer.reset();
+    m_buses.clear();
     m_dispatcher.reset();
     m_lifecycle.reset();
     m_worker.reset();
     m_hooks.reset();
+    m_hookHelper.reset();
     m_hookExecutor.reset();
+    m_stateCache.reset();
+    m_profiles.reset();
     m_standbyPolicy.reset();
 
     LOG_INFO("Shutdown sequence complete");
@@ -442,6 +797,11 @@ void CECDaemon::onSignalReadable() {
             continue;
         }
 
+        if (signum == SIGHUP) {
+            reloadConfig();
+            continue;
+        }
+
         LOG_INFO("Received signal ", signum);
 
         // First shutdown signal requests a clean stop. Further signals
@@ -452,24 +812,151 @@ void CECDaemon::onSignalReadable() {
     }
 }
 
+void CECDaemon::reloadConfig() {
+    LOG_INFO("Reloading configuration from ", m_configPath);
+    ConfigManager configManager(m_configPath);
+    const bool loaded = configManager.load();
+    FlightRecorder::getInstance().milestone(flight_log::Milestone::ConfigReload, loaded);
+    if (!loaded) {
+        LOG_WARNING("Failed to load configuration file; keeping the running configuration");
+        return;
+    }
+    AppConfig next = loadAppConfig(configManager);
+    // --simulate outlives the file it overrode.
+    if (m_config.simulator.forced) next.simulator.enabled = next.simulator.forced = true;
+    const AppConfigChanges changes = diffAppConfig(m_config, next);
+    if (!changes.any()) {
+        LOG_INFO("Configuration unchanged");
+        return;
+    }
+
+    if (changes.throttler || changes.dispatcher || changes.scenes) {
+        m_dispatcher->reconfigure(next);
+        for (const auto& bus : m_buses) bus->reconfigure(next);
+        m_config.throttler = next.throttler;
+        // MaxQueuedCommands sizes the worker queue and stays as started.
+        next.dispatcher.maxQueuedCommands = m_config.dispatcher.maxQueuedCommands;
+        m_config.dispatcher = next.dispatcher;
+        m_config.scenes     = std::move(next.scenes);
+        rebuildFrameFilters();
+        LOG_INFO("Configuration: applied throttler and dispatcher settings");
+    }
+    if (changes.standby) {
+        // Only a changed file value overrides a CMD_AUTO_STANDBY toggle.
+        m_standbyPolicy->setEnabled(next.standby.enabled);
+        m_config.standby = next.standby;
+        LOG_INFO("Configuration: PowerOffOnStandby = ",
+                 (next.standby.enabled ? "true" : "false"));
+    }
+    if (changes.hookScripts) {
+        m_hooks->setScripts(next.hooks);
+        m_config.hooks.inputSwitch     = next.hooks.inputSwitch;
+        m_config.hooks.tvStandby       = next.hooks.tvStandby;
+        m_config.hooks.tvWake          = next.hooks.tvWake;
+        m_config.hooks.hostActivated   = next.hooks.hostActivated;
+        m_config.hooks.hostDeactivated = next.hooks.hostDeactivated;
+        m_config.hooks.inputSwitchDebounce = next.hooks.inputSwitchDebounce;
+        m_config.hooks.tvPowerDebounce     = next.hooks.tvPowerDebounce;
+        LOG_INFO("Configuration: applied hook script paths and debounce settings");
+    }
+    if (changes.adapter) {
+        PowerFanoutConfig fanout;
+        fanout.wakeDevices     = next.adapter.wakeDevices;
+        fanout.powerOffDevices = next.adapter.powerOffDevices;
+        m_config.adapter = next.adapter;
+        // Lands on the main thread. A reopen that failed leaves the
+        // adapter closed, which the reconnect cycle treats like a loss.
+        m_lifecycle->reconfigureAsync(next.adapter, fanout, /*reopen=*/true,
+                                      [this](bool ok) {
+            if (!ok && m_supervisor) {
+                LOG_WARNING("Adapter left closed after reload; starting the reconnect cycle");
+                m_supervisor->onConnectionLost(PowerSupervisor::kDefaultBus);
+            }
+        });
+    }
+    for (const auto& name : changes.namedAdapters) {
+        reconfigureAdapterBus(next, name);
+    }
+    for (const auto& key : changes.restartOnly) {
+        LOG_WARNING("Configuration: ", key, " changed; takes effect after a restart");
+    }
+}
+
 void CECDaemon::onWatchdogTimerFired() {
-    // Drain the expiration counter so the level-triggered fd quiets
-    // until the next period. We ping once per handler invocation
+    // Drain the expiry count. We ping once per handler invocation
     // regardless of how many expirations accumulated — the service
     // manager cares about recency, not count.
     m_watchdogTimer.consume();
-    SystemdNotify::watchdog();
+
+    // A live main loop proves nothing about the adapter: the worker can
+    // sit in one libcec call for minutes while this timer keeps firing.
+    // Ping only while the worker is making progress, so systemd
+    // restarts a daemon whose commands can no longer reach the bus.
+    using std::chrono::milliseconds;
+    const auto now     = AdapterWorker::Clock::now();
+    const auto& limits = m_config.daemon;
+    const auto stuck   = [&limits](const AdapterWorker::Health& health) {
+        return (limits.watchdogMaxCallMs > 0 &&
+                health.callDuration > milliseconds(limits.watchdogMaxCallMs)) ||
+               (limits.watchdogMaxWaitMs > 0 &&
+                health.oldestWait > milliseconds(limits.watchdogMaxWaitMs));
+    };
+    // Every bus has its own worker; the first stalled one is reported.
+    auto health = m_worker ? m_worker->health(now) : AdapterWorker::Health{};
+    std::string stalledBus;
+    bool stalled = stuck(health);
+    for (const auto& bus : m_buses) {
+        if (stalled) break;
+        health     = bus->worker().health(now);
+        stalled    = stuck(health);
+        stalledBus = " of adapter " + bus->name();
+    }
+    if (!stalled) {
+        if (m_workerStalled) {
+            m_workerStalled = false;
+            LOG_INFO("Adapter workers are making progress again; resuming watchdog pings");
+            SystemdNotify::status("Running");
+        }
+        SystemdNotify::watchdog();
+        return;
+    }
+
+    const auto ms = [](AdapterWorker::Clock::duration d) {
+        return static_cast<long long>(std::chrono::duration_cast<milliseconds>(d).count());
+    };
+    char text[192];
+    const int length = std::snprintf(text, sizeof(text),
+                                     "Adapter worker%s stalled: call running %lld ms, "
+                                     "%zu queued (oldest %lld ms), %zu parked",
+                                     stalledBus.c_str(), ms(health.callDuration), health.queued,
+                                     ms(health.oldestWait), health.parked);
+    if (length > 0 && static_cast<std::size_t>(length) < sizeof(text) &&
+        health.lastHeartbeat != AdapterWorker::TimePoint{}) {
+        std::snprintf(text + length, sizeof(text) - length, ", last job finished %lld ms ago",
+                      ms(now - health.lastHeartbeat));
+    }
+    SystemdNotify::status(text);
+    if (!m_workerStalled) {
+        m_workerStalled = true;
+        LOG_ERROR(text, "; withholding watchdog pings");
+    }
 }
 
 bool CECDaemon::setupPowerMonitor() {
     LOG_INFO("Setting up D-Bus power monitoring");
     try {
+        StartupReport& startup = StartupReport::getInstance();
         m_dbusMonitor = std::make_unique<DBusMonitor>();
-        if (!m_dbusMonitor->initialize()) {
+        startup.start(StartupPhase::DbusConnect);
+        const bool connected = m_dbusMonitor->initialize();
+        startup.finish(StartupPhase::DbusConnect);
+        if (!connected) {
             LOG_ERROR("Failed to initialize D-Bus monitor");
             m_dbusMonitor.reset();
             return false;
         }
+        // initialize() sent the Inhibit call; logind's reply ends the phase.
+        startup.start(StartupPhase::InhibitorLock);
         m_dbusMonitor->setCallback([this](DBusMonitor::PowerState state) {
             // Runs inline inside sd_bus_process; hop through m_work so
             // the supervisor never executes nested in the bus dispatch
@@ -482,6 +969,17 @@ bool CECDaemon::setupPowerMonitor() {
                 }
             });
         });
+        // Call outcomes come from the same dispatch and take the same hop.
+        m_dbusMonitor->setReplyCallback([this](DBusMonitor::Call call, bool ok) {
+            m_work.post([this, call, ok]() {
+                if (call == DBusMonitor::Call::Inhibit) {
+                    StartupReport::getInstance().finish(StartupPhase::InhibitorLock);
+                    m_supervisor->onInhibitLockReply(ok);
+                } else {
+                    m_supervisor->onSuspendCallReply(ok);
+                }
+            });
+        });
         // Hand the live monitor to the supervisor so the lifecycle
         // FSM's lock-take / lock-release effects can fire against it.
         m_supervisor->setDBusMonitor(m_dbusMonitor.get());
@@ -508,10 +1006,61 @@ void CECDaemon::requestUnrecoverableShutdown() {
     m_loop.stop();
 }
 
-void CECDaemon::handleCommand(Message command, ResponseSink reply) {
+void CECDaemon::scheduleStatusPublish() {
+    if (!m_statusPage || m_statusPublishPending) return;
+    m_statusPublishPending = true;
+    m_loop.defer([this] {
+        m_statusPublishPending = false;
+        publishStatus();
+    });
+}
+
+void CECDaemon::publishStatus() {
+    if (!m_statusPage || !m_stateCache) return;
+
+    status_page::StatusSnapshot snapshot;
+    snapshot.daemonRunning    = true;
+    snapshot.adapterConnected = m_worker && m_worker->isAdapterConnected();
+    snapshot.suspended        = m_lifecycle && m_lifecycle->isSuspended();
+    snapshot.activeSource =
+        m_stateCache->lastKnownActiveSource().value_or(kPhysicalAddressUnknown);
+    for (uint8_t logical = 0; logical < status_page::kDeviceCount; ++logical) {
+        auto& device = snapshot.devices[logical];
+        device.present = m_stateCache->lastSeen(logical).has_value();
+        if (!device.present) continue;
+        const DeviceState state = m_stateCache->lastKnownState(logical);
+        device.powerStatus     = state.powerStatus;
+        device.physicalAddress = state.physicalAddress;
+    }
+    m_statusPage->publish(snapshot);
+}
+
+void CECDaemon::attachDeviceProfiles() {
+    if (!m_profiles || !m_dispatcher || !m_stateCache) return;
+    std::size_t seeded = 0;
+    for (uint8_t address = 0; address < DeviceStateCache::kDeviceCount; ++address) {
+        const auto vendorId        = m_stateCache->freshVendorId(address);
+        const auto physicalAddress = m_stateCache->freshPhysicalAddress(address);
+        if (!vendorId || !physicalAddress) continue;
+        if (m_profiles->attach(address, DeviceIdentity{*vendorId, *physicalAddress},
+                               m_dispatcher->throttler())) {
+            ++seeded;
+        }
+    }
+    if (seeded > 0) {
+        LOG_INFO("Applied ", seeded, " learned device profile(s)");
+    }
+}
+
+void CECDaemon::handleCommand(Message command, ResponseSink reply,
+                              const RequestOptions& options) {
     LOG_DEBUG("Received command: type=", static_cast<int>(command.type),
               ", deviceId=", static_cast<int>(command.deviceId));
 
+    // Suspend and resume requests change the lifecycle inline, with
+    // no worker completion behind them to trigger a publish.
+    scheduleStatusPublish();
+
     // Consult the dispatch table to decide whether this command is a
     // supervisor-intercepted lifecycle message (short-circuited here
     // into PowerSupervisor) or an ordinary wire command (forwarded to
@@ -533,8 +1082,8 @@ void CECDaemon::handleCommand(Message command, ResponseSink reply) {
             m_supervisor->onResumeRequested(PowerLifecycle::Source::Wire);
             break;
         default:
-            // validateDispatchTable at startup forbids a table row
-            // classified SupervisorIntercepted without a case here.
+            // Only CMD_SUSPEND and CMD_RESUME are classified
+            // SupervisorIntercepted in kDispatchTable.
             LOG_ERROR("SupervisorIntercepted command without mapping: type=",
                       static_cast<int>(command.type));
             reply(Message(MessageType::RESP_ERROR));
@@ -550,45 +1099,150 @@ void CECDaemon::handleCommand(Message command, ResponseSink reply) {
         return;
     }
 
+    CommandDispatcher* dispatcher = m_dispatcher.get();
+    if (!options.adapter.empty()) {
+        AdapterBus* bus = findAdapterBus(options.adapter.name());
+        if (bus == nullptr) {
+            LOG_WARNING("Command for unknown adapter ", options.adapter.name(), " rejected");
+            reply(Message(MessageType::RESP_ERROR));
+            return;
+        }
+        dispatcher = &bus->dispatcher();
+    }
+
     // The dispatcher internally chooses between an inline main-thread
     // reply (gate / state-only paths) and a worker hop with the reply
     // posted back via m_work (AdapterCall path).
-    m_dispatcher->dispatch(std::move(command), std::move(reply));
+    dispatcher->dispatch(std::move(command), std::move(reply), options);
+}
+
+void CECDaemon::buildAdapterBuses() {
+    const bool simulated = m_config.simulator.enabled;
+    if (!m_config.namedAdapters.empty() && !simulated && m_config.adapter.port.empty()) {
+        LOG_WARNING("[Adapter] has no Port; it takes the first adapter libcec finds, "
+                    "which may be one an [Adapter.NAME] section names");
+    }
+    for (const auto& adapter : m_config.namedAdapters) {
+        // Two libcec handles on one port fight over it, and a second
+        // auto-detected adapter would only find the first one again.
+        const bool portTaken =
+            adapter.port == m_config.adapter.port ||
+            std::any_of(m_buses.begin(), m_buses.end(), [&](const auto& bus) {
+                return bus->port() == adapter.port;
+            });
+        if (!simulated && (adapter.port.empty() || portTaken)) {
+            LOG_WARNING("[Adapter.", adapter.name, "] needs a Port of its own; adapter skipped");
+            continue;
+        }
+        const std::size_t index = m_buses.size() + 1;
+        LOG_INFO("Adding CEC adapter ", adapter.name, " on port ",
+                 (adapter.port.empty() ? "(simulated)" : adapter.port));
+        m_buses.push_back(std::make_unique<AdapterBus>(
+            m_config, adapter, m_work, m_loop, *m_standbyPolicy, m_frameFilter,
+            [this, index]() {
+                if (m_supervisor) m_supervisor->onConnectionLost(index);
+            }));
+    }
+}
+
+AdapterBus* CECDaemon::findAdapterBus(std::string_view name) noexcept {
+    for (const auto& bus : m_buses) {
+        if (bus->name() == name) return bus.get();
+    }
+    return nullptr;
+}
+
+void CECDaemon::reconfigureAdapterBus(const AppConfig& next, const std::string& name) {
+    const auto byName = [&name](const AdapterConfig& adapter) { return adapter.name == name; };
+    const auto named  = std::find_if(next.namedAdapters.begin(), next.namedAdapters.end(),
+                                     byName);
+    const auto running = std::find_if(m_config.namedAdapters.begin(),
+                                      m_config.namedAdapters.end(), byName);
+    AdapterBus* bus = findAdapterBus(name);
+    if (bus == nullptr || named == next.namedAdapters.end() ||
+        running == m_config.namedAdapters.end()) {
+        // Skipped at startup for want of a usable port.
+        LOG_WARNING("Configuration: [Adapter.", name, "] changed; takes effect after a restart");
+        return;
+    }
+    *running = *named;
+    bus->reconfigureAdapter(*named);
+    LOG_INFO("Configuration: applied [Adapter.", name, "] settings");
 }
 
 void CECDaemon::onAdapterObservation(ICecAdapter::Observation obs) {
-    // Fires on libcec's command thread. Hop to main so subscribers
-    // run single-threaded and never execute inline under a libcec
-    // call. The closure captures the Observation by value — the type
-    // is trivially copyable and fits in a small buffer, so there is
-    // no heap allocation on the hot path beyond the usual
-    // std::function machinery.
-    //
+    // Fires on a libcec thread. The bus carries it to the consumers
+    // subscribed in subscribeObservers, on the main thread.
+    recordObservation(obs);
+    m_observations.publish(obs);
+}
+
+void CECDaemon::subscribeObservers() {
+    using Kind = ICecAdapter::Observation::Kind;
+    using Obs  = ICecAdapter::Observation;
+    const auto bit = ObservationBus::kindBit;
+
     // Libcec's internal threads spawn inside openConnection() on the
-    // main thread before subsystems are built; an observation
-    // arriving in the narrow window between Open() returning and
-    // subsystem assignment is absorbed by the in-closure null checks.
-    // The window is microseconds and in practice no bus event fires
-    // before construction completes.
-    //
-    // Adding a subscriber is a local edit here: this closure is the
-    // single dispatch point and every observer runs on the main
-    // thread with single-threaded semantics.
-    m_work.post([this, obs]() {
-        if (auto* policy = m_standbyPolicy.get()) {
-            policy->observe(obs);
-        }
-        if (auto* hooks = m_hooks.get()) {
-            hooks->observe(obs);
-        }
+    // main thread before the subsystems are built; an observation
+    // that arrives before its consumer exists is absorbed by the null
+    // checks below. Consumers run in the order subscribed: the cache
+    // first, so the rest see the state the observation left.
+    m_observations.subscribe(ObservationBus::kAllKinds & ~bit(Kind::RawFrame),
+                             [this](const Obs& obs) {
+                                 if (auto* cache = m_stateCache.get()) cache->observe(obs);
+                             });
+    m_observations.subscribe(bit(Kind::TvStandby), [this](const Obs& obs) {
+        if (auto* policy = m_standbyPolicy.get()) policy->observe(obs);
     });
+    m_observations.subscribe(bit(Kind::TvStandby) | bit(Kind::TvPowerReport) |
+                                 bit(Kind::ActiveSource) | bit(Kind::HostActivated) |
+                                 bit(Kind::HostDeactivated),
+                             [this](const Obs& obs) {
+                                 if (auto* hooks = m_hooks.get()) hooks->observe(obs);
+                             });
+    // A device that speaks up is back: let commands through to it again.
+    m_observations.subscribe(ObservationBus::kAllKinds & ~bit(Kind::HostActivated) &
+                                 ~bit(Kind::HostDeactivated),
+                             [this](const Obs& obs) {
+                                 auto* dispatcher = m_dispatcher.get();
+                                 if (!dispatcher) return;
+                                 if (const auto device = ObservationBus::heardFrom(obs)) {
+                                     dispatcher->throttler().noteHeardFrom(*device);
+                                 }
+                             });
+    m_observations.subscribe(bit(Kind::TvStandby) | bit(Kind::TvPowerReport) |
+                                 bit(Kind::ActiveSource) | bit(Kind::HostActivated) |
+                                 bit(Kind::HostDeactivated) | bit(Kind::RawFrame),
+                             [this](const Obs& obs) {
+                                 auto* server = m_socketServer.get();
+                                 if (!server) return;
+                                 if (const auto event = toBusEvent(obs)) {
+                                     server->publishEvent(*event);
+                                 }
+                             });
+}
+
+void CECDaemon::rebuildFrameFilters() {
+    FrameFilter::Table frames = ICecAdapter::typedObservationFrames();
+    FrameFilter::Table raw{};
+    if (m_subscribedEvents & busEventBit(BusEventKind::RawFrame)) {
+        const auto& opcodes = m_config.dispatcher.rawOpcodes;
+        for (std::size_t opcode = 0; opcode < raw.size(); ++opcode) {
+            if (!opcodes.test(opcode)) continue;
+            raw[opcode]    = FrameFilter::kAnyInitiator;
+            frames[opcode] = FrameFilter::kAnyInitiator;
+        }
+    }
+    m_rawFrameFilter.assign(raw);
+    m_frameFilter.assign(frames);
 }
 
 void CECDaemon::onAdapterConnectionLost() {
     // Fires on libcec's alert thread. Hop to main so the supervisor's
     // reconnect FSM transition runs single-threaded.
+    FlightRecorder::getInstance().milestone(flight_log::Milestone::AdapterLost, false);
     m_work.post([this]() {
-        if (m_supervisor) m_supervisor->onConnectionLost();
+        if (m_supervisor) m_supervisor->onConnectionLost(PowerSupervisor::kDefaultBus);
     });
 }
 
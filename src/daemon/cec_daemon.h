@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "../common/event_loop.h"
 #include "../common/main_thread_work.h"
 #include "../common/messages.h"
 #include "../common/signal_source.h"
-#include "../common/timer_source.h"
+#include "../common/loop_timer.h"
 #include "app_config.h"
 #include "cec/adapter_interface.h"
+#include "cec/frame_filter.h"
+#include "observation_bus.h"
 
 namespace cec_control {
 
@@ -20,22 +26,30 @@ namespace cec_control {
 // into them directly. Keeping those headers out of cec_daemon.h
 // breaks the transitive libcec / sd-bus leak through every TU that
 // just needs to name the CECDaemon type.
+class AdapterBus;
 class AdapterLifecycle;
 class AdapterWorker;
 class CecHookSubsystem;
 class CommandDispatcher;
 class DBusMonitor;
+class DeviceProfileStore;
+class DeviceStateCache;
 class HookExecutor;
+class HookHelper;
+class MetricsExporter;
+class NetworkServer;
 class PowerSupervisor;
 class SocketServer;
 class StandbyPolicy;
+class StatusPageWriter;
+class UdevMonitor;
 
 /**
  * @class CECDaemon
  * @brief Top-level wiring + bootstrap shell.
  *
  * Owns the unified event loop and the fd sources that feed it
- * (signals, main-thread work queue, three timerfds, the socket
+ * (signals, main-thread work queue, the loop timers, the socket
  * listener, the sd-bus fd). Spins up every subsystem on @c start():
  * the @c AdapterWorker actor that owns the libcec handle, the
  * @c AdapterLifecycle that runs suspend / resume / reconnect over the
@@ -62,7 +76,17 @@ class StandbyPolicy;
  * onwards the worker is the sole thread that invokes any other libcec
  * method; callbacks arriving between @c Open() returning and the
  * supervisor being assigned are absorbed by null checks in the
- * daemon's forwarders.
+ * daemon's forwarders. With @c DeferAdapterOpen the initialise and
+ * open instead run as the worker's first job, and the lifecycle holds
+ * adapter commands until it completes.
+ *
+ * Further adapters: each @c [Adapter.NAME] section gets an
+ * @c AdapterBus with its own worker, lifecycle, state cache and
+ * dispatcher, opened on its worker so the buses come up and run in
+ * parallel. A request's adapter selector picks the bus; the supervisor
+ * suspends and resumes every bus together. Hooks, event subscribers,
+ * the status page and the other daemon-wide consumers follow the
+ * default adapter.
  *
  * Shutdown drives a strict ordering so no thread observes a
  * destroyed subsystem: the socket server stops before the dispatcher
@@ -76,10 +100,11 @@ class CECDaemon {
 public:
     /**
      * Take ownership of a parsed @c AppConfig snapshot. The daemon
-     * retains it for the process lifetime so that a future SIGHUP
-     * reload can diff against the initial values.
+     * retains it for the process lifetime so that a SIGHUP reload can
+     * diff against the running values; @p configPath is the file that
+     * reload re-reads.
      */
-    explicit CECDaemon(AppConfig config);
+    CECDaemon(AppConfig config, std::string configPath);
     ~CECDaemon();
 
     CECDaemon(const CECDaemon&)            = delete;
@@ -118,34 +143,68 @@ private:
     void onSignalReadable();
 
     /**
-     * Handler for the systemd watchdog timer. Drains the timerfd and
-     * sends @c WATCHDOG=1 to the service manager. Only registered with
-     * the event loop when the unit actually configured @c WatchdogSec;
-     * otherwise the timer stays disarmed and this method is never called.
+     * SIGHUP: re-read @c m_configPath and hot-apply what changed to
+     * the subsystems that own it; the adapter is reopened only when an
+     * @c [Adapter] field changed. Keys read once at startup are logged
+     * as needing a restart and keep their running value. A file that
+     * fails to load leaves everything as it was. Main thread only.
+     */
+    void reloadConfig();
+
+    /**
+     * Handler for the systemd watchdog timer. Drains the expiry count
+     * and sends @c WATCHDOG=1 to the service manager, but only while
+     * the adapter worker is healthy: a slice running longer than
+     * @c WatchdogMaxCallMs, or a job queued longer than
+     * @c WatchdogMaxWaitMs, withholds the ping and reports the stall
+     * (with queue depth) through @c STATUS=, so the unit's watchdog
+     * restarts a wedged daemon. The timer is only armed when the unit
+     * actually configured @c WatchdogSec; otherwise it stays disarmed
+     * and this method is never called.
      */
     void onWatchdogTimerFired();
 
     /**
      * Route an incoming wire command. Runs on the main thread.
-     * Suspend and resume delegate directly to @c PowerSupervisor and
-     * reply inline; everything else is forwarded to the dispatcher
-     * whose @c dispatch chooses between an inline reply and a worker
-     * hop.
+     * Suspend and resume delegate directly to @c PowerSupervisor, for
+     * every adapter, and reply inline; everything else is forwarded to
+     * the dispatcher of the adapter @p options selects (the default one
+     * when it names none; @c RESP_ERROR for an unknown name), whose
+     * @c dispatch chooses between an inline reply and a worker hop.
      */
-    void handleCommand(Message command, ResponseSink reply);
+    void handleCommand(Message command, ResponseSink reply, const RequestOptions& options);
 
     /**
-     * Adapter callback forwarder: CEC bus observation. Fires on
-     * libcec's command thread; hops the observation through @c m_work
-     * so every subscriber (@c StandbyPolicy today, plus future
-     * consumers such as the hook subsystem) runs on the main thread
-     * with single-threaded semantics. The daemon owns the forwarder
-     * rather than wiring libcec directly to each subscriber so the
-     * callback target is stable across subsystem construction order
-     * and adding a subscriber stays a local change.
+     * Build an @c AdapterBus for each @c [Adapter.NAME] section. One
+     * without a Port of its own is skipped with a warning, except on
+     * the simulated bus. Called once, from @c start, before the
+     * supervisor that coordinates them.
+     */
+    void buildAdapterBuses();
+
+    /** The @c [Adapter.NAME] bus called @p name, or nullptr. */
+    [[nodiscard]] AdapterBus* findAdapterBus(std::string_view name) noexcept;
+
+    /** Apply the reloaded @c [Adapter.NAME] section @p name from @p next. */
+    void reconfigureAdapterBus(const AppConfig& next, const std::string& name);
+
+    /**
+     * Adapter callback forwarder: CEC bus observation. Fires on a
+     * libcec thread and publishes to @c m_observations, which delivers
+     * on the main thread. The daemon owns the forwarder rather than
+     * wiring libcec to the bus directly so the callback target is
+     * stable across subsystem construction order.
      */
     void onAdapterObservation(ICecAdapter::Observation obs);
 
+    /**
+     * Register the state cache, standby policy, hook subsystem and
+     * event subscribers with @c m_observations, each for the kinds it
+     * consumes. Adding a consumer is a local edit here. Called once,
+     * from @c start.
+     */
+    void subscribeObservers();
+
     /**
      * Adapter callback forwarder: connection lost. Fires on libcec's
      * alert thread; hops the observation through @c m_work so the
@@ -153,9 +212,25 @@ private:
      */
     void onAdapterConnectionLost();
 
+    /**
+     * Recompute @c m_frameFilter and @c m_rawFrameFilter from what the
+     * observers need: the typed observation frames, which the state
+     * cache always consumes, plus the [Daemon] RawOpcodes frames while
+     * a session subscribes to raw events. Run at start, on reload and
+     * when the subscriptions change; main thread only.
+     */
+    void rebuildFrameFilters();
+
     /** Ensure a DBus monitor is up; returns @c true on success. */
     [[nodiscard]] bool setupPowerMonitor();
 
+    /**
+     * Seed the throttler lane of every device the state cache has a
+     * vendor and physical address for from @c m_profiles. Run once a
+     * topology scan has finished; main thread only.
+     */
+    void attachDeviceProfiles();
+
     /**
      * Signal a daemon-level shutdown driven by an unrecoverable
      * subsystem condition. Latches @c m_exitStatus to @c EXIT_FAILURE
@@ -168,6 +243,16 @@ private:
      */
     void requestUnrecoverableShutdown();
 
+    /**
+     * Refresh the status page once the current dispatch batch is done,
+     * so a burst of observations costs one publish. No-op without a
+     * page.
+     */
+    void scheduleStatusPublish();
+
+    /** Copy the cache and adapter state into the status page. */
+    void publishStatus();
+
     // Event loop and single-threaded primitives. Declared first so
     // they outlive every subsystem that might register handlers
     // against them. SignalSource must be constructed on the main
@@ -176,52 +261,97 @@ private:
     // mask via thread creation.
     SignalSource m_signals;
     MainThreadWork m_work;
+    // Adapter observations on their way to the main thread; overflows
+    // into m_work, so declared after it.
+    ObservationBus m_observations{m_work};
     EventLoop      m_loop;
-    TimerSource    m_suspendSafetyTimer;
-    TimerSource    m_reconnectRetryTimer;
+    LoopTimer      m_suspendSafetyTimer{m_loop};
+    LoopTimer      m_reconnectRetryTimer{m_loop};
+    // Ticks while suspended so the supervisor notices the wake the
+    // moment the process is thawed; see PowerSupervisor::onWakeProbeTimerFired.
+    LoopTimer      m_wakeProbeTimer{m_loop};
+    // Deadline for commands held while a deferred adapter open runs
+    // (DeferAdapterOpen); disarmed once the open completes.
+    LoopTimer      m_adapterReadyTimer{m_loop};
+    // Closes the adapter after AdapterIdleCloseMs without an adapter
+    // command; armed by AdapterLifecycle, inert when idle close is off.
+    LoopTimer      m_adapterIdleTimer{m_loop};
     // Fires the systemd watchdog ping at half the configured WatchdogSec.
-    // Registered with the loop only when a watchdog is actually configured
-    // (see CECDaemon::start); otherwise the timerfd stays inert.
-    TimerSource    m_watchdogTimer;
+    // Pings are withheld while the adapter worker is stalled.
+    // Armed only when a watchdog is actually configured (see
+    // CECDaemon::start); otherwise the timer stays inert.
+    LoopTimer      m_watchdogTimer{m_loop};
     // Collapses back-to-back CEC @c ActiveSource observations into a
     // single @c InputSwitch fire. Owned here (not inside
-    // @c CecHookSubsystem) so its fd registration follows the same
-    // shape as the other timer sources; the subsystem receives a
-    // reference at construction.
-    TimerSource    m_hookDebounceTimer;
+    // @c CecHookSubsystem) so its handler is installed the same way
+    // as the other timers'; the subsystem receives a reference at
+    // construction.
+    LoopTimer      m_hookDebounceTimer{m_loop};
+    // The same for TV power flaps, when @c TVPowerDebounceMs is set.
+    LoopTimer      m_hookTvPowerTimer{m_loop};
+    // Paces the repeated presses of a key held through CMD_KEY_DOWN;
+    // armed and disarmed by the dispatcher's KeyRepeater.
+    LoopTimer      m_keyRepeatTimer{m_loop};
+
+    // Received frames the observers want, read by libcec's command
+    // thread through the adapter's Callbacks. Declared ahead of every
+    // owner of the adapter so they outlive the thread that reads them.
+    FrameFilter m_frameFilter;
+    FrameFilter m_rawFrameFilter;
+    // [Daemon] CaptureFile, when set and writable: recorded into by the
+    // adapter's threads, so it too outlives every owner of the adapter.
+    std::unique_ptr<TrafficCapture> m_capture;
+    // Union of every session's subscription; raw frames are decoded
+    // only while it includes BusEventKind::RawFrame.
+    BusEventMask m_subscribedEvents = 0;
 
     // Auto-suspend-on-TV-standby policy. Declared before m_worker so
     // reverse-of-declaration destruction joins libcec's command
-    // thread first: no observation closure the libcec thread queued
-    // on @c m_work can still be drained by the time the policy is
-    // destroyed, because the event loop has already stopped. The
-    // null check inside the forwarder's posted closure is belt-and-
-    // braces for the in-construction window between libcec's Open()
-    // and this assignment.
+    // thread first: no observation the libcec thread queued on
+    // @c m_observations can still be delivered by the time the policy
+    // is destroyed, because the event loop has already stopped. The
+    // null check inside the bus consumer is belt-and-braces for the
+    // in-construction window between libcec's Open() and this
+    // assignment.
     std::unique_ptr<StandbyPolicy> m_standbyPolicy;
 
-    // Hook executor and the CEC hook subsystem that feeds it.
+    // Last-known bus state. Declared before m_worker for the same
+    // reason as the policy, and additionally because its refresh jobs
+    // capture it on the worker thread.
+    std::unique_ptr<DeviceStateCache> m_stateCache;
+
+    // Learned per-device throttling, loaded at start and saved at stop.
+    // Plain data touched only on the main thread; null on the
+    // simulated bus, whose devices should not overwrite real ones.
+    std::unique_ptr<DeviceProfileStore> m_profiles;
+
+    // Hook executor, the optional helper co-process, and the CEC hook
+    // subsystem that feeds both.
     //
     // Destruction ordering — @c stop() below mirrors this explicitly
     // and the field order here is its fallback:
     //
     //   * @c m_hooks holds references to @c m_hookExecutor (submits
-    //     jobs through it) and to @c m_hookDebounceTimer (arms it
-    //     from @c observe). Both referents are declared earlier in
-    //     this block, so reverse-of-declaration destruction drops
-    //     @c m_hooks first; neither reference can dangle. Keep this
-    //     ordering if new collaborators are added.
+    //     jobs through it) and to @c m_hookDebounceTimer and
+    //     @c m_hookTvPowerTimer (arms them from @c observe), and a pointer to @c m_hookHelper. All
+    //     referents are declared earlier, so reverse-of-declaration
+    //     destruction drops @c m_hooks first; nothing can dangle.
+    //     Keep this ordering if new collaborators are added.
+    //   * @c m_hookHelper registers its socket with @c m_loop, which
+    //     outlives it; stop() closes that socket while the loop is
+    //     still intact.
     //   * @c m_hookExecutor owns a worker thread that only consumes
     //     its own queue and never calls back into the daemon — stop()
     //     joins it independently of libcec and signalfd.
     //
-    // Also declared before @c m_worker: observation closures that the
-    // worker / libcec path posts through @c m_work land on the main
-    // thread and can touch @c m_hooks, so the hooks must outlive any
-    // such in-flight closure. The @c stop() sequence guarantees this
+    // Also declared before @c m_worker: observations the libcec path
+    // publishes on @c m_observations are delivered on the main thread
+    // and can touch @c m_hooks, so the hooks must outlive any still
+    // queued. The @c stop() sequence guarantees this
     // by resetting @c m_worker (which drains libcec) before @c m_hooks
     // / @c m_hookExecutor.
     std::unique_ptr<HookExecutor>     m_hookExecutor;
+    std::unique_ptr<HookHelper>       m_hookHelper;
     std::unique_ptr<CecHookSubsystem> m_hooks;
 
     // CEC adapter actor. Owns the libcec handle and the single thread
@@ -240,8 +370,24 @@ private:
     // explicitly.
     std::unique_ptr<AdapterLifecycle>  m_lifecycle;
     std::unique_ptr<CommandDispatcher> m_dispatcher;
+    // The [Adapter.NAME] buses, in name order; bus i is the
+    // supervisor's bus i + 1. Each holds m_standbyPolicy,
+    // m_frameFilter, m_work and m_loop, all declared earlier.
+    std::vector<std::unique_ptr<AdapterBus>> m_buses;
     std::unique_ptr<SocketServer>      m_socketServer;
+    // Optional scrape endpoint; null unless MetricsListen is set. Reads
+    // only the process-wide Metrics registry, so it holds no refs.
+    std::unique_ptr<MetricsExporter>   m_metricsExporter;
+    std::unique_ptr<NetworkServer>     m_networkServer;
+    // Shared-memory bus status; null when StatusPage is off or the
+    // file could not be created. Reads the cache, lifecycle and
+    // worker only from publishStatus on the main thread.
+    std::unique_ptr<StatusPageWriter>  m_statusPage;
+    bool                               m_statusPublishPending = false;
     std::unique_ptr<DBusMonitor>       m_dbusMonitor;
+    // Adapter hotplug events for the supervisor's reconnect FSM; null
+    // when the netlink socket could not be opened.
+    std::unique_ptr<UdevMonitor>       m_udevMonitor;
 
     // Power lifecycle / reconnect orchestrator. Holds non-owning refs
     // to the dispatcher, the adapter lifecycle, the worker, the work
@@ -254,13 +400,19 @@ private:
 
     // Parsed configuration snapshot. Stored by value so consumers can
     // receive copies (AdapterConfig) or a const-ref (CommandDispatcher)
-    // without any of them invalidating the daemon's view. A future
-    // SIGHUP reload diffs a freshly-loaded AppConfig against this.
-    AppConfig m_config;
+    // without any of them invalidating the daemon's view. A SIGHUP
+    // reload diffs a freshly-loaded AppConfig against this and stores
+    // the sections it applied.
+    AppConfig   m_config;
+    std::string m_configPath;
 
     // True between start() returning success and stop() completing.
     bool m_started = false;
 
+    // Whether the last watchdog tick found an adapter worker stalled,
+    // so each transition is logged once.
+    bool m_workerStalled = false;
+
     // Process exit status surfaced via exitStatus(). Latched one-way
     // from EXIT_SUCCESS to EXIT_FAILURE by requestUnrecoverableShutdown
     // the first time an unrecoverable subsystem condition is raised;
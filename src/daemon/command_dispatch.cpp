@@ -3,10 +3,12 @@
 #include <array>
 #include <cstddef>
 #include <ios>
+#include <optional>
 
 #include "../common/command_registry.h"
 #include "../common/key_codes.h"
 #include "../common/logger.h"
+#include "../common/static_index.h"
 #include "cec/adapter_interface.h"
 #include "cec/operations.h"
 #include "command_throttler.h"
@@ -25,33 +27,71 @@ namespace {
 // outer try/catch and the RESP_ERROR fallback, so propagating through
 // these handlers is intentional.
 
-bool handlePowerOn(ICecAdapter& adapter, CommandThrottler& throttler,
-                   const Message& command) {
-    return ops::powerOnDevice(adapter, throttler, command.deviceId);
+// Shared by the power handlers: a payload, if any, must be a device set.
+ThrottledCommand handlePower(ICecAdapter& adapter, CommandThrottler& throttler,
+                             const Message& command, bool on) {
+    if (command.data.empty()) {
+        return on ? ops::powerOnDevice(adapter, throttler, command.deviceId)
+                  : ops::powerOffDevice(adapter, throttler, command.deviceId);
+    }
+    const std::optional<DeviceSet> devices = decodeDeviceSet(command.data);
+    if (!devices) {
+        LOG_WARNING("Power command received with a ", command.data.size(),
+                    "-byte payload; expected a 2-byte device set (malformed client)");
+        return ThrottledCommand::finished(false);
+    }
+    return ops::powerDevices(adapter, throttler, *devices, on);
+}
+
+ThrottledCommand handlePowerOn(ICecAdapter& adapter, CommandThrottler& throttler,
+                               const Message& command) {
+    return handlePower(adapter, throttler, command, /*on=*/true);
 }
 
-bool handlePowerOff(ICecAdapter& adapter, CommandThrottler& throttler,
-                    const Message& command) {
-    return ops::powerOffDevice(adapter, throttler, command.deviceId);
+ThrottledCommand handlePowerOff(ICecAdapter& adapter, CommandThrottler& throttler,
+                                const Message& command) {
+    return handlePower(adapter, throttler, command, /*on=*/false);
 }
 
-bool handleVolumeUp(ICecAdapter& adapter, CommandThrottler& throttler,
-                    const Message& command) {
+ThrottledCommand handleVolumeUp(ICecAdapter& adapter, CommandThrottler& throttler,
+                                const Message& command) {
     return ops::setVolume(adapter, throttler, command.deviceId, /*up=*/true);
 }
 
-bool handleVolumeDown(ICecAdapter& adapter, CommandThrottler& throttler,
-                      const Message& command) {
+ThrottledCommand handleVolumeDown(ICecAdapter& adapter, CommandThrottler& throttler,
+                                  const Message& command) {
     return ops::setVolume(adapter, throttler, command.deviceId, /*up=*/false);
 }
 
-bool handleVolumeMute(ICecAdapter& adapter, CommandThrottler& throttler,
-                      const Message& command) {
+ThrottledCommand handleVolumeUpSteps(ICecAdapter& adapter, CommandThrottler& throttler,
+                                     const Message& command, uint32_t steps) {
+    return ops::setVolume(adapter, throttler, command.deviceId, /*up=*/true, steps);
+}
+
+ThrottledCommand handleVolumeDownSteps(ICecAdapter& adapter, CommandThrottler& throttler,
+                                       const Message& command, uint32_t steps) {
+    return ops::setVolume(adapter, throttler, command.deviceId, /*up=*/false, steps);
+}
+
+ThrottledCommand handleVolumeMute(ICecAdapter& adapter, CommandThrottler& throttler,
+                                  const Message& command) {
     return ops::setMute(adapter, throttler, command.deviceId, /*mute=*/true);
 }
 
-bool handleChangeSource(ICecAdapter& adapter, CommandThrottler& throttler,
-                        const Message& command) {
+ThrottledCommand handleVolumeSet(ICecAdapter& adapter, CommandThrottler& throttler,
+                                 const Message& command) {
+    if (command.data.empty() || command.data[0] > kMaxVolumeLevel) {
+        // The registry's parser bounds the level; anything else here
+        // came from a hand-rolled wire message.
+        LOG_WARNING("CMD_VOLUME_SET received without a level in 0..",
+                    static_cast<int>(kMaxVolumeLevel), " (malformed client)");
+        return ThrottledCommand::finished(false);
+    }
+    return ops::setVolumeLevel(adapter, throttler, command.deviceId, command.data[0]);
+}
+
+ThrottledCommand handleChangeSource(ICecAdapter& adapter, CommandThrottler& throttler,
+                                    const Message& command) {
     if (command.data.empty()) {
         // The registry's parser guarantees a single-byte payload; an
         // empty data vector here means a hand-rolled wire message
@@ -59,20 +99,22 @@ bool handleChangeSource(ICecAdapter& adapter, CommandThrottler& throttler,
         // CEC-layer failure, then surface the failure via the wrapper.
         LOG_WARNING("CMD_CHANGE_SOURCE received with empty payload; "
                     "expected source byte in data[0] (malformed client)");
-        return false;
+        return ThrottledCommand::finished(false);
     }
     return ops::setSource(adapter, throttler, command.data[0]);
 }
 
-bool handleKey(ICecAdapter& adapter, CommandThrottler& throttler,
-                const Message& command) {
+// Shared payload gate for the single and coalesced CMD_KEY handlers.
+// Returns the validated key code, or nullopt after logging why the
+// message was rejected.
+std::optional<uint8_t> validatedKeyCode(const Message& command) {
     if (command.data.empty()) {
         // The registry's parser guarantees a single-byte payload; an
         // empty data vector here means a hand-rolled wire message
         // bypassed the parser.
         LOG_WARNING("CMD_KEY received with empty payload; expected key "
                     "code byte in data[0] (malformed client)");
-        return false;
+        return std::nullopt;
     }
     const uint8_t code = command.data[0];
     if (findKeyByCode(code) == nullptr) {
@@ -82,30 +124,75 @@ bool handleKey(ICecAdapter& adapter, CommandThrottler& throttler,
         LOG_WARNING("CMD_KEY received with unknown key code 0x",
                     std::hex, static_cast<int>(code),
                     " (malformed client)");
-        return false;
+        return std::nullopt;
     }
-    return ops::sendKey(adapter, throttler, command.deviceId, code);
+    return code;
 }
 
-bool handleRestartAdapter(ICecAdapter& adapter, CommandThrottler& /*throttler*/,
-                          const Message& /*command*/) {
+ThrottledCommand handleKey(ICecAdapter& adapter, CommandThrottler& throttler,
+                           const Message& command) {
+    const auto code = validatedKeyCode(command);
+    if (!code) return ThrottledCommand::finished(false);
+    return ops::sendKey(adapter, throttler, command.deviceId, *code);
+}
+
+ThrottledCommand handleKeySteps(ICecAdapter& adapter, CommandThrottler& throttler,
+                                const Message& command, uint32_t steps) {
+    const auto code = validatedKeyCode(command);
+    if (!code) return ThrottledCommand::finished(false);
+    return ops::sendKey(adapter, throttler, command.deviceId, *code, steps);
+}
+
+ThrottledCommand handleKeySequence(ICecAdapter& adapter, CommandThrottler& throttler,
+                                   const Message& command) {
+    // The same allowlist as CMD_KEY, applied to every key of the
+    // sequence before any of them is sent.
+    if (command.data.empty() || command.data.size() > kMaxKeySequence) {
+        LOG_WARNING("CMD_KEY_SEQUENCE received with ", command.data.size(),
+                    " keys; expected 1 to ", kMaxKeySequence, " (malformed client)");
+        return ThrottledCommand::finished(false);
+    }
+    for (const uint8_t code : command.data) {
+        if (findKeyByCode(code) == nullptr) {
+            LOG_WARNING("CMD_KEY_SEQUENCE received with unknown key code 0x",
+                        std::hex, static_cast<int>(code), " (malformed client)");
+            return ThrottledCommand::finished(false);
+        }
+    }
+    return ops::sendKeySequence(adapter, throttler, command.deviceId,
+                                command.data.data(), command.data.size());
+}
+
+ThrottledCommand handleRawTransmit(ICecAdapter& adapter, CommandThrottler& throttler,
+                                   const Message& command) {
+    // CommandDispatcher::rawTransmitAllowed has decoded the frame and
+    // checked its opcode before the command was queued.
+    const auto frame = decodeRawFrame(command.data.data(), command.data.size());
+    if (!frame) return ThrottledCommand::finished(false);
+    return ops::transmitRaw(adapter, throttler, *frame);
+}
+
+ThrottledCommand handleRestartAdapter(ICecAdapter& adapter, CommandThrottler& /*throttler*/,
+                                      const Message& /*command*/) {
     // CMD_RESTART_ADAPTER bypasses the isConnected() gate (see the
     // corresponding kDispatchTable row) because reopening a
     // disconnected adapter is the explicit intent. Throttling does not
     // apply — this is an operator-triggered recovery path, not a
-    // throttled CEC command.
-    return adapter.reopenConnection();
+    // throttled CEC command — so the reopen runs inline on the first
+    // worker slice and the result is handed back already finished.
+    return ThrottledCommand::finished(adapter.reopenConnection());
 }
 
 // Source of truth for daemon-side command handling. C++17 aggregate
 // deduction for std::array avoids a manual size literal: adding an
 // entry does not require updating a size constant anywhere.
 //
-// INVARIANTS enforced by validateDispatchTable() at startup:
+// INVARIANTS, each a static_assert below the table:
 //   - No two rows share the same MessageType.
 //   - Every MessageType reachable via kCommands.types has a row here.
 //   - Every row in this table has a matching kCommands entry.
 //   - adapterHandler is non-null iff dispatch == AdapterCall.
+//   - coalescedHandler is non-null only on AdapterCall rows.
 constexpr std::array kDispatchTable = {
     DispatchSpec{MessageType::CMD_POWER_ON,
                  DispatchClass::AdapterCall,
@@ -117,13 +204,18 @@ constexpr std::array kDispatchTable = {
                  true, true, handlePowerOff},
     DispatchSpec{MessageType::CMD_VOLUME_UP,
                  DispatchClass::AdapterCall,
-                 true, true, handleVolumeUp},
+                 true, true, handleVolumeUp,
+                 /*coalescedHandler=*/handleVolumeUpSteps},
     DispatchSpec{MessageType::CMD_VOLUME_DOWN,
                  DispatchClass::AdapterCall,
-                 true, true, handleVolumeDown},
+                 true, true, handleVolumeDown,
+                 handleVolumeDownSteps},
     DispatchSpec{MessageType::CMD_VOLUME_MUTE,
                  DispatchClass::AdapterCall,
                  true, true, handleVolumeMute},
+    DispatchSpec{MessageType::CMD_VOLUME_SET,
+                 DispatchClass::AdapterCall,
+                 true, true, handleVolumeSet},
     DispatchSpec{MessageType::CMD_CHANGE_SOURCE,
                  DispatchClass::AdapterCall,
                  /*queueableWhileSuspended=*/false,
@@ -133,15 +225,61 @@ constexpr std::array kDispatchTable = {
                  DispatchClass::AdapterCall,
                  /*queueableWhileSuspended=*/false,
                  /*requiresAdapterConnection=*/true,
-                 handleKey},
+                 handleKey,
+                 handleKeySteps},
+    // Hold frames go to the bus through the dispatcher's KeyRepeater,
+    // not a handler; a held key makes no sense across a suspend.
+    DispatchSpec{MessageType::CMD_KEY_DOWN,
+                 DispatchClass::KeyHold,
+                 false, true, nullptr},
+    DispatchSpec{MessageType::CMD_KEY_UP,
+                 DispatchClass::KeyHold,
+                 false, true, nullptr},
+    DispatchSpec{MessageType::CMD_KEY_SEQUENCE,
+                 DispatchClass::AdapterCall,
+                 false, true, handleKeySequence},
+    // An arbitrary frame is no more welcome after a resume than a key.
+    DispatchSpec{MessageType::CMD_RAW_TRANSMIT,
+                 DispatchClass::AdapterCall,
+                 false, true, handleRawTransmit},
     DispatchSpec{MessageType::CMD_RESTART_ADAPTER,
                  DispatchClass::AdapterCall,
                  /*queueableWhileSuspended=*/false,
                  /*requiresAdapterConnection=*/false,
-                 handleRestartAdapter},
+                 handleRestartAdapter,
+                 /*coalescedHandler=*/nullptr,
+                 WorkPriority::Lifecycle},
+    // Per-step gating happens against each sub-command's own row, so
+    // the batch row itself neither queues nor requires a connection.
+    DispatchSpec{MessageType::CMD_BATCH,
+                 DispatchClass::Batch,
+                 false, false, nullptr},
+    DispatchSpec{MessageType::CMD_SCENE,
+                 DispatchClass::Batch,
+                 false, false, nullptr},
     DispatchSpec{MessageType::CMD_AUTO_STANDBY,
                  DispatchClass::StateOnly,
                  false, false, nullptr},
+    // Queries answer from the device-state cache; a stale entry is
+    // refreshed through the cache's own worker job, not a handler.
+    DispatchSpec{MessageType::CMD_QUERY_STATUS,
+                 DispatchClass::StateOnly,
+                 false, false, nullptr},
+    DispatchSpec{MessageType::CMD_QUERY_DEVICES,
+                 DispatchClass::StateOnly,
+                 false, false, nullptr},
+    DispatchSpec{MessageType::CMD_QUERY_ACTIVE_SOURCE,
+                 DispatchClass::StateOnly,
+                 false, false, nullptr},
+    DispatchSpec{MessageType::CMD_STATS,
+                 DispatchClass::StateOnly,
+                 false, false, nullptr},
+    DispatchSpec{MessageType::CMD_TRACE,
+                 DispatchClass::StateOnly,
+                 false, false, nullptr},
+    DispatchSpec{MessageType::CMD_SUBSCRIBE,
+                 DispatchClass::SessionIntercepted,
+                 false, false, nullptr},
     DispatchSpec{MessageType::CMD_SUSPEND,
                  DispatchClass::SupervisorIntercepted,
                  false, false, nullptr},
@@ -150,80 +288,69 @@ constexpr std::array kDispatchTable = {
                  false, false, nullptr},
 };
 
-} // namespace
-
-const DispatchSpec* findDispatchByType(MessageType type) noexcept {
-    for (const auto& spec : kDispatchTable) {
-        if (spec.type == type) return &spec;
+constexpr static_index::ByteIndex buildDispatchIndex() noexcept {
+    auto index = static_index::emptyByteIndex();
+    for (std::size_t row = 0; row < kDispatchTable.size(); ++row) {
+        index[static_cast<uint8_t>(kDispatchTable[row].type)] = static_cast<uint8_t>(row);
     }
-    return nullptr;
+    return index;
 }
 
-bool validateDispatchTable() {
-    bool ok = true;
+constexpr auto kDispatchIndex = buildDispatchIndex();
 
-    // Check 1: every MessageType reachable through kCommands.types has
-    // a kDispatchTable row. Catches the "added a new command to the
-    // client registry but forgot the daemon-side entry" failure mode.
-    for (const auto& cmd : kCommands) {
-        for (MessageType type : cmd.types) {
-            if (findDispatchByType(type) == nullptr) {
-                LOG_ERROR("Dispatch table missing entry for type=",
-                          static_cast<int>(type),
-                          " (kCommands: '", cmd.name, "')");
-                ok = false;
-            }
-        }
+// A second row for a type would be dead: the index keeps only one.
+constexpr bool dispatchTypesUnique() noexcept {
+    for (std::size_t row = 0; row < kDispatchTable.size(); ++row) {
+        if (kDispatchIndex[static_cast<uint8_t>(kDispatchTable[row].type)] != row) return false;
     }
+    return true;
+}
+static_assert(dispatchTypesUnique(), "kDispatchTable has two rows for one MessageType");
 
-    // Check 2: every kDispatchTable row has a matching kCommands
-    // entry. Catches "added a daemon-side entry for a MessageType that
-    // nobody can parse from the wire".
-    for (const auto& spec : kDispatchTable) {
-        if (findByType(spec.type) == nullptr) {
-            LOG_ERROR("kDispatchTable entry for type=",
-                      static_cast<int>(spec.type),
-                      " has no matching kCommands entry");
-            ok = false;
+// Catches a command added to the client registry without its
+// daemon-side row.
+constexpr bool everyCommandDispatched() noexcept {
+    for (const auto& cmd : kCommands) {
+        for (const MessageType type : cmd.types) {
+            if (kDispatchIndex[static_cast<uint8_t>(type)] == static_index::kNone) return false;
         }
     }
+    return true;
+}
+static_assert(everyCommandDispatched(), "a kCommands type has no kDispatchTable row");
 
-    // Check 3: no duplicate MessageType in kDispatchTable. Without
-    // this, findDispatchByType silently returns the first match and
-    // the second entry is dead; the programmer error goes unnoticed.
-    for (std::size_t i = 0; i < kDispatchTable.size(); ++i) {
-        for (std::size_t j = i + 1; j < kDispatchTable.size(); ++j) {
-            if (kDispatchTable[i].type == kDispatchTable[j].type) {
-                LOG_ERROR("kDispatchTable has duplicate entries for type=",
-                          static_cast<int>(kDispatchTable[i].type));
-                ok = false;
-            }
+// Catches a daemon-side row for a type nobody can parse from the wire.
+constexpr bool everyRowHasCommand() noexcept {
+    for (const auto& spec : kDispatchTable) {
+        bool found = false;
+        for (const auto& cmd : kCommands) {
+            for (const MessageType type : cmd.types) found = found || type == spec.type;
         }
+        if (!found) return false;
     }
+    return true;
+}
+static_assert(everyRowHasCommand(), "a kDispatchTable row has no kCommands entry");
 
-    // Check 4: adapterHandler is non-null iff dispatch == AdapterCall.
-    // The dispatcher's worker path assumes it can call the handler
-    // unconditionally on an AdapterCall row; a null handler there
-    // would crash the worker thread.
+// The worker path calls adapterHandler unconditionally on an
+// AdapterCall row, and consults coalescedHandler nowhere else; a
+// coalescible StateOnly row would be silently ignored.
+constexpr bool handlersMatchClass() noexcept {
     for (const auto& spec : kDispatchTable) {
-        const bool isAdapterCall =
-            spec.dispatch == DispatchClass::AdapterCall;
-        const bool hasHandler = spec.adapterHandler != nullptr;
-        if (isAdapterCall != hasHandler) {
-            LOG_ERROR("kDispatchTable entry type=",
-                      static_cast<int>(spec.type),
-                      " violates handler/class invariant (AdapterCall=",
-                      isAdapterCall, ", handler=",
-                      hasHandler, ")");
-            ok = false;
-        }
+        const bool isAdapterCall = spec.dispatch == DispatchClass::AdapterCall;
+        if (isAdapterCall != (spec.adapterHandler != nullptr)) return false;
+        if (!isAdapterCall && spec.coalescedHandler != nullptr) return false;
     }
+    return true;
+}
+static_assert(handlersMatchClass(),
+              "kDispatchTable handler set does not match its DispatchClass");
 
-    if (ok) {
-        LOG_DEBUG("Dispatch table validated: ", kDispatchTable.size(),
-                  " entries cross-checked against kCommands");
-    }
-    return ok;
+} // namespace
+
+const DispatchSpec* findDispatchByType(MessageType type) noexcept {
+    const uint8_t row = kDispatchIndex[static_cast<uint8_t>(type)];
+    return row == static_index::kNone ? nullptr : &kDispatchTable[row];
 }
 
 } // namespace cec_control
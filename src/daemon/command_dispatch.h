@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstdint>
+
 #include "../common/messages.h"
+#include "cec/work_priority.h"
+#include "command_throttler.h"
 
 namespace cec_control {
 
-class CommandThrottler;
 class ICecAdapter;
 
 /**
@@ -20,19 +23,37 @@ class ICecAdapter;
  *  - @c SupervisorIntercepted: the daemon short-circuits before the
  *    dispatcher is ever invoked and feeds @c PowerSupervisor directly.
  *    Applies to @c CMD_SUSPEND and @c CMD_RESUME.
- *  - @c StateOnly: the dispatcher mutates its own main-thread state
- *    (no adapter touch, no worker hop) and replies inline. Applies to
- *    @c CMD_AUTO_STANDBY.
+ *  - @c StateOnly: the dispatcher reads or mutates main-thread state
+ *    (no adapter touch) and replies inline. Applies to
+ *    @c CMD_AUTO_STANDBY, @c CMD_STATS, @c CMD_TRACE and the @c CMD_QUERY_*
+ *    commands; a query
+ *    whose cached answer is stale is the one exception that waits on a
+ *    worker-side @c DeviceStateCache::refresh before replying.
  *  - @c AdapterCall: the dispatcher submits a worker job that invokes
  *    the spec's @c adapterHandler and posts the reply back via
  *    @c MainThreadWork. Includes every command that ultimately drives
  *    libcec, plus @c CMD_RESTART_ADAPTER (which runs a reopen without
  *    the normal @c isConnected() gate — see @c requiresAdapterConnection).
+ *  - @c Batch: the dispatcher decodes the payload into sub-commands,
+ *    each of which must be an @c AdapterCall, and runs them in order
+ *    as one worker task against their own rows. Applies to
+ *    @c CMD_BATCH, and to @c CMD_SCENE, whose sub-commands come from
+ *    the scene table compiled at config load rather than the wire.
+ *  - @c SessionIntercepted: @c SocketServer acts on the session itself
+ *    and replies without invoking the command handler at all. Applies
+ *    to @c CMD_SUBSCRIBE.
+ *  - @c KeyHold: the dispatcher hands the key to its @c KeyRepeater,
+ *    which keeps it pressed on the bus across requests and replies
+ *    once the frame is sent. Applies to @c CMD_KEY_DOWN and
+ *    @c CMD_KEY_UP.
  */
 enum class DispatchClass {
     SupervisorIntercepted,
+    SessionIntercepted,
     StateOnly,
     AdapterCall,
+    Batch,
+    KeyHold,
 };
 
 /**
@@ -42,20 +63,36 @@ enum class DispatchClass {
  * @c submitAdapterWork wrapper: the wrapper owns the per-call
  * @c isConnected() gate (controlled by @c requiresAdapterConnection)
  * and the enclosing try/catch, so handlers are free to propagate
- * exceptions from @c ops or libcec. The handler returns whether the
- * underlying throttled attempt ultimately succeeded.
+ * exceptions from @c ops or libcec. The handler returns the
+ * @c ThrottledCommand for the request without running it; the wrapper
+ * drives it across worker slices and reports its final outcome.
  */
 using AdapterCallHandler =
-    bool (*)(ICecAdapter& adapter,
-             CommandThrottler& throttler,
-             const Message& command);
+    ThrottledCommand (*)(ICecAdapter& adapter,
+                         CommandThrottler& throttler,
+                         const Message& command);
+
+/**
+ * Handler signature for the coalesced form of an @c AdapterCall entry.
+ *
+ * Same contract as @c AdapterCallHandler, plus @p steps: the number of
+ * identical requests the dispatcher folded into this one worker job
+ * (always >= 1). Only rows whose repetition is additive — a volume
+ * step, a key press — carry one; a toggle such as mute would cancel
+ * itself out when merged and must not.
+ */
+using CoalescedCallHandler =
+    ThrottledCommand (*)(ICecAdapter& adapter,
+                         CommandThrottler& throttler,
+                         const Message& command,
+                         uint32_t steps);
 
 /**
  * @brief Table row describing the daemon-side handling of one wire
  *        command.
  *
- * Runtime-validated against @c kCommands at startup (see
- * @c validateDispatchTable). The table is deliberately kept on the
+ * Checked against @c kCommands at compile time by the
+ * @c static_asserts in @c command_dispatch.cpp. The table is deliberately kept on the
  * daemon side so the client-shared @c kCommands registry can stay
  * free of libcec-adjacent concerns.
  */
@@ -84,29 +121,60 @@ struct DispatchSpec {
     /**
      * Function pointer invoked from the worker for @c AdapterCall
      * entries. INVARIANT: non-null iff @c dispatch ==
-     * @c DispatchClass::AdapterCall; @c validateDispatchTable enforces
-     * the equivalence at startup.
+     * @c DispatchClass::AdapterCall; a @c static_assert enforces the
+     * equivalence.
      */
     AdapterCallHandler adapterHandler;
+
+    /**
+     * Optional multi-step handler. Non-null marks the row as
+     * coalescible: @c CommandDispatcher may merge a run of adjacent
+     * identical requests into a single worker job that calls this
+     * with the merged step count. INVARIANT: non-null only for
+     * @c DispatchClass::AdapterCall rows (checked at compile time).
+     */
+    CoalescedCallHandler coalescedHandler = nullptr;
+
+    /**
+     * @c AdapterWorker class the row's job is queued in. Interactive
+     * for everything a client drives; Lifecycle for the adapter
+     * restart, which is recovery work and must not queue behind a
+     * command backlog. Moot for non-@c AdapterCall classes.
+     */
+    WorkPriority       priority = WorkPriority::Interactive;
 };
 
 /**
- * Linear lookup by @c MessageType. Returns @c nullptr if the type has
- * no entry (which means either the type is a response code, or the
- * dispatch table is structurally broken — the validator catches the
- * latter at startup).
+ * Direct lookup by @c MessageType through an index built at compile
+ * time. Returns @c nullptr for a type with no entry, which can only be
+ * a response code: every command type has a row, or the build fails.
  */
 [[nodiscard]] const DispatchSpec* findDispatchByType(MessageType type) noexcept;
 
 /**
- * Cross-check the daemon-side dispatch table against the client-shared
- * @c kCommands registry plus internal invariants. Called from
- * @c CECDaemon::start before any subsystem that would consult the
- * table is constructed; returns @c false if any check fails, having
- * logged one @c LOG_ERROR per violation. A @c false return causes the
- * daemon to abort startup rather than run with silently-incorrect
- * dispatch.
+ * Whether a @p type request's @c deviceId names the device it acts on.
+ * The others (batches, scenes, listings, daemon controls) leave it 0,
+ * which is a real address, so logs must not tag them with it.
  */
-[[nodiscard]] bool validateDispatchTable();
+[[nodiscard]] constexpr bool targetsDevice(MessageType type) noexcept {
+    switch (type) {
+    case MessageType::CMD_POWER_ON:
+    case MessageType::CMD_POWER_OFF:
+    case MessageType::CMD_VOLUME_UP:
+    case MessageType::CMD_VOLUME_DOWN:
+    case MessageType::CMD_VOLUME_MUTE:
+    case MessageType::CMD_VOLUME_SET:
+    case MessageType::CMD_CHANGE_SOURCE:
+    case MessageType::CMD_KEY:
+    case MessageType::CMD_KEY_DOWN:
+    case MessageType::CMD_KEY_UP:
+    case MessageType::CMD_KEY_SEQUENCE:
+    case MessageType::CMD_RAW_TRANSMIT:
+    case MessageType::CMD_QUERY_STATUS:
+        return true;
+    default:
+        return false;
+    }
+}
 
 } // namespace cec_control
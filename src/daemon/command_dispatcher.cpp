@@ -1,48 +1,253 @@
 #include "command_dispatcher.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <string>
 #include <string_view>
 #include <utility>
 
 #include "../common/command_registry.h"
 #include "../common/logger.h"
 #include "../common/main_thread_work.h"
+#include "../common/trace.h"
 #include "adapter_lifecycle.h"
 #include "app_config.h"
 #include "cec/adapter_interface.h"
 #include "cec/adapter_worker.h"
+#include "cec/operations.h"
 #include "command_dispatch.h"
+#include "device_state_cache.h"
+#include "memory_profile.h"
+#include "metrics.h"
 #include "standby_policy.h"
+#include "startup_report.h"
 
 namespace cec_control {
 
+namespace {
+
+// Trace dumps served at once; see handleTrace.
+constexpr std::size_t kMaxTraceDumps = 4;
+
+// Finished coalescing batches kept for reuse; see recycleBatch.
+constexpr std::size_t kMaxSpareBatches = 8;
+
+SuspendQueue::Limits suspendQueueLimits(const DispatcherConfig& config) noexcept {
+    return SuspendQueue::Limits{config.suspendQueueCapacity,
+                                std::chrono::milliseconds(config.suspendQueueTtlMs)};
+}
+
+// Coalesce key for a coalescible command: type, target and first
+// payload byte (the key code for CMD_KEY; zero for volume). The high
+// marker bit keeps every key distinct from AdapterWorker::kNoCoalesce.
+AdapterWorker::CoalesceKey coalesceKeyFor(const Message& command) noexcept {
+    const uint32_t payload = command.data.empty() ? 0u : command.data[0];
+    return (1u << 24)
+         | (static_cast<uint32_t>(command.type) << 16)
+         | (static_cast<uint32_t>(command.deviceId) << 8)
+         | payload;
+}
+
+// Worker ordering lane for @p command: its destination, so a parked
+// retry to one device holds back later commands to that device only.
+// CMD_CHANGE_SOURCE always drives the TV. The adapter-level restart is
+// not destination-bound and opts out of lane ordering.
+AdapterWorker::OrderingLane orderingLaneFor(const Message& command,
+                                            const DispatchSpec& spec) noexcept {
+    if (!spec.requiresAdapterConnection) return AdapterWorker::kNoLane;
+    if (command.type == MessageType::CMD_CHANGE_SOURCE) return 0;
+    return command.deviceId;
+}
+
+// Class a request runs in: its row's, except that a frame flagged
+// background moves interactive work behind the rest. Lifecycle rows
+// keep their class whatever the client asks.
+WorkPriority priorityFor(const DispatchSpec& spec, const RequestOptions& request) {
+    if (request.background && spec.priority == WorkPriority::Interactive) {
+        return WorkPriority::Background;
+    }
+    return spec.priority;
+}
+
+// Scheduling attributes shared by every submission path: ordering
+// lane and class from the command and its row, and a start deadline
+// of `timeout` from now (none when the timeout is zero). A deadline
+// the client sent can only shorten that wait.
+AdapterWorker::TaskOptions taskOptionsFor(const Message& command,
+                                          const DispatchSpec& spec,
+                                          std::chrono::milliseconds timeout,
+                                          const RequestOptions& request = {}) {
+    AdapterWorker::TaskOptions options;
+    options.lane     = orderingLaneFor(command, spec);
+    options.priority = priorityFor(spec, request);
+    if (request.deadlineMs != 0) {
+        const std::chrono::milliseconds asked(request.deadlineMs);
+        timeout = timeout.count() > 0 ? std::min(timeout, asked) : asked;
+    }
+    if (timeout.count() > 0) {
+        options.deadline = AdapterWorker::Clock::now() + timeout;
+    }
+    return options;
+}
+
+// CMD_STATS reply: the metrics report, with the memory gauges read
+// fresh, the throttler's per-device intervals and the startup timings,
+// cut at a line boundary if it would not fit in one Message.
+Message statsReport(const CommandThrottler& throttler) {
+    publishMemoryUsage();
+    std::string report = Metrics::getInstance().render() + throttler.renderLanes() +
+                         StartupReport::getInstance().render();
+    constexpr std::size_t kMaxPayload = MAX_MESSAGE_SIZE - 2;
+    if (report.size() > kMaxPayload) {
+        const std::size_t cut = report.rfind('\n', kMaxPayload - 1);
+        report.resize(cut == std::string::npos ? 0 : cut + 1);
+    }
+    return Message(MessageType::RESP_SUCCESS, 0,
+                   InlineBytes(reinterpret_cast<const uint8_t*>(report.data()),
+                               report.size()));
+}
+
+Message responseFor(const ThrottledCommand& op) {
+    if (op.succeeded()) return Message(MessageType::RESP_SUCCESS);
+    return Message(op.unreachable() ? MessageType::RESP_UNREACHABLE
+                                    : MessageType::RESP_ERROR);
+}
+
+// One command of a batch or scene, resolved against its own row. A
+// scene step may ask for a pause after the previous step finished.
+struct BatchStep {
+    Message                   command;
+    const DispatchSpec*       spec = nullptr;
+    std::chrono::milliseconds pauseBefore{0};
+};
+
+// Answer a command the worker would not queue. A full queue gets the
+// distinct busy response so the client can back off and retry.
+void replyIfRefused(AdapterWorker::Admission admission, const ResponseSink& reply) {
+    switch (admission) {
+    case AdapterWorker::Admission::Accepted:
+        return;
+    case AdapterWorker::Admission::QueueFull:
+        LOG_WARNING("Adapter worker queue full; answering busy");
+        reply(Message(MessageType::RESP_BUSY));
+        return;
+    case AdapterWorker::Admission::Stopped:
+        // Teardown in progress; the socket server is already gone.
+        return;
+    }
+}
+
+// Ack-on-accept: hand the task a sink that only counts how the command
+// went, and return the client's, which answers the admission instead.
+// Empty, leaving @p reply alone, for a request that waits as usual.
+ResponseSink detachOutcome(ResponseSink& reply, const RequestOptions& request) {
+    if (!request.ackOnAccept) return {};
+    ResponseSink client = std::move(reply);
+    reply = [](Message response) {
+        Metrics::getInstance().increment(response.type == MessageType::RESP_SUCCESS
+                                             ? Metrics::Counter::DetachedSucceeded
+                                             : Metrics::Counter::DetachedFailed);
+    };
+    return client;
+}
+
+// Answer a submission's admission: a refusal through @p reply, or
+// through @p ack, which an acceptance also answers, when the outcome
+// was detached.
+void answerAdmission(AdapterWorker::Admission admission, const ResponseSink& reply,
+                     const ResponseSink& ack) {
+    if (!ack) {
+        replyIfRefused(admission, reply);
+    } else if (admission == AdapterWorker::Admission::Accepted) {
+        ack(Message(MessageType::RESP_SUCCESS));
+    } else {
+        replyIfRefused(admission, ack);
+    }
+}
+
+} // namespace
+
+/**
+ * One worker job's worth of merged requests. Written on the main
+ * thread while the job is still queued (inside
+ * AdapterWorker::mergeIntoTail, under the worker lock) and read on
+ * the worker thread after the job is dequeued under that same lock,
+ * so no further synchronisation is needed.
+ */
+struct CommandDispatcher::CoalescedBatch {
+    AdapterWorker::CoalesceKey key;
+    Message                    command;
+    const DispatchSpec*        spec;
+    std::vector<ResponseSink>  replies;
+    uint32_t                   steps = 1;
+};
+
 CommandDispatcher::CommandDispatcher(const AppConfig&  config,
                                      AdapterWorker&    worker,
                                      MainThreadWork&   work,
                                      AdapterLifecycle& lifecycle,
-                                     StandbyPolicy&    standbyPolicy)
+                                     StandbyPolicy&    standbyPolicy,
+                                     DeviceStateCache& stateCache,
+                                     LoopTimer&        keyRepeatTimer)
     : m_worker(worker),
       m_work(work),
       m_lifecycle(lifecycle),
       m_standbyPolicy(standbyPolicy),
+      m_stateCache(stateCache),
       m_throttler(config.throttler),
-      m_queueCommandsDuringSuspend(config.dispatcher.queueCommandsDuringSuspend) {}
+      m_queueCommandsDuringSuspend(config.dispatcher.queueCommandsDuringSuspend),
+      m_commandTimeout(config.dispatcher.commandTimeoutMs),
+      m_skipRedundantPowerOn(config.dispatcher.skipRedundantPowerOn),
+      m_skipRedundantPowerOff(config.dispatcher.skipRedundantPowerOff),
+      m_skipRedundantSource(config.dispatcher.skipRedundantSource),
+      m_rawOpcodes(config.dispatcher.rawOpcodes),
+      m_scenes(config.scenes),
+      m_keyRepeater(worker, work, keyRepeatTimer) {
+    m_lifecycle.setSuspendQueueLimits(suspendQueueLimits(config.dispatcher));
+}
+
+void CommandDispatcher::reconfigure(const AppConfig& config) {
+    m_throttler.reconfigure(config.throttler);
+    m_queueCommandsDuringSuspend = config.dispatcher.queueCommandsDuringSuspend;
+    m_commandTimeout             = std::chrono::milliseconds(config.dispatcher.commandTimeoutMs);
+    m_skipRedundantPowerOn       = config.dispatcher.skipRedundantPowerOn;
+    m_skipRedundantPowerOff      = config.dispatcher.skipRedundantPowerOff;
+    m_skipRedundantSource        = config.dispatcher.skipRedundantSource;
+    m_rawOpcodes                 = config.dispatcher.rawOpcodes;
+    m_lifecycle.setSuspendQueueLimits(suspendQueueLimits(config.dispatcher));
+    // Steps are copied into the worker task when a scene starts, so
+    // swapping the table cannot pull one out from under a running scene.
+    m_scenes = config.scenes;
+}
 
 void CommandDispatcher::shutdown() {
     if (m_shutdownComplete) return;
     m_shutdownComplete = true;
     LOG_INFO("Shutting down command dispatcher");
+    if (m_coalescingStats.merged > 0 || m_coalescingStats.dropped > 0) {
+        LOG_INFO("Command coalescing: ", m_coalescingStats.merged,
+                 " request(s) merged, ", m_coalescingStats.dropped,
+                 " dropped over the step cap");
+    }
+    const auto& skipped = m_idempotenceStats;
+    if (skipped.powerOn > 0 || skipped.powerOff > 0 || skipped.source > 0) {
+        LOG_INFO("Redundant commands skipped: ", skipped.powerOn, " power on, ",
+                 skipped.powerOff, " power off, ", skipped.source, " source");
+    }
 }
 
 bool CommandDispatcher::isShutdown() const noexcept {
     return m_shutdownComplete;
 }
 
-void CommandDispatcher::dispatch(Message command, ResponseSink reply) {
+void CommandDispatcher::dispatch(Message command, ResponseSink reply,
+                                 const RequestOptions& options) {
     // Every branch below is responsible for invoking @p reply exactly
     // once. DispatchClass::AdapterCall commands hand the sink to a
     // worker job that posts the invocation back through MainThreadWork;
     // every other branch replies synchronously on the main thread.
     if (!reply) return;  // defensive: a caller without a sink is malformed
+    const TraceScope span(TracePoint::Dispatch, static_cast<uint32_t>(command.type));
 
     if (m_shutdownComplete) {
         reply(Message(MessageType::RESP_ERROR));
@@ -51,8 +256,8 @@ void CommandDispatcher::dispatch(Message command, ResponseSink reply) {
 
     const DispatchSpec* spec = findDispatchByType(command.type);
     if (spec == nullptr) {
-        // validateDispatchTable at startup ensures every kCommands
-        // type has a row here, so the only way in is a response code
+        // The static_asserts beside kDispatchTable ensure every
+        // kCommands type has a row here, so the only way in is a response code
         // on the wire (client protocol violation) or an unregistered
         // new CMD_*. Either way, reject.
         LOG_ERROR("Unknown command type at dispatcher: ",
@@ -61,37 +266,83 @@ void CommandDispatcher::dispatch(Message command, ResponseSink reply) {
         return;
     }
 
-    if (spec->dispatch == DispatchClass::SupervisorIntercepted) {
-        // CECDaemon::handleCommand short-circuits these before the
-        // dispatcher sees them; reaching this branch means that
-        // intercept is broken. Fail loudly rather than silently
-        // routing to the adapter path.
-        LOG_ERROR("SupervisorIntercepted command reached dispatcher: type=",
+    if (spec->dispatch == DispatchClass::SupervisorIntercepted ||
+        spec->dispatch == DispatchClass::SessionIntercepted) {
+        // CECDaemon::handleCommand (supervisor) or SocketServer
+        // (session) short-circuits these before the dispatcher sees
+        // them; reaching this branch means that intercept is broken.
+        // Fail loudly rather than silently routing to the adapter path.
+        LOG_ERROR("Intercepted command reached dispatcher: type=",
                   static_cast<int>(command.type));
         reply(Message(MessageType::RESP_ERROR));
         return;
     }
 
+    if (!rawTransmitAllowed(command)) {
+        reply(Message(MessageType::RESP_ERROR));
+        return;
+    }
+
     if (m_lifecycle.isSuspended()) {
         reply(handleSuspendedInline(command, *spec));
         return;
     }
 
+    const bool needsAdapter = spec->dispatch == DispatchClass::AdapterCall ||
+                              spec->dispatch == DispatchClass::Batch ||
+                              spec->dispatch == DispatchClass::KeyHold;
+    if (needsAdapter) {
+        m_lifecycle.noteActivity();
+        reopenIdleAdapter();
+    }
+
+    if (m_lifecycle.isOpening() && needsAdapter) {
+        // Deferred or idle reopen still running: held commands are
+        // re-dispatched once it completes. State-only commands fall
+        // through and answer from what is known now.
+        m_lifecycle.hold(std::move(command), std::move(reply));
+        return;
+    }
+
     switch (spec->dispatch) {
     case DispatchClass::StateOnly:
-        // CMD_AUTO_STANDBY is the only StateOnly row today.
-        reply(m_standbyPolicy.apply(command));
+        if (command.type == MessageType::CMD_AUTO_STANDBY) {
+            reply(m_standbyPolicy.apply(command));
+        } else if (command.type == MessageType::CMD_STATS) {
+            reply(statsReport(m_throttler));
+        } else if (command.type == MessageType::CMD_TRACE) {
+            reply(handleTrace(command, options.session));
+        } else {
+            answerQuery(std::move(command), std::move(reply));
+        }
         return;
     case DispatchClass::AdapterCall:
-        submitAdapterWork(*spec, std::move(command), std::move(reply));
+        if (skipIfRedundant(command)) {
+            reply(Message(MessageType::RESP_SUCCESS));
+        } else if (spec->coalescedHandler != nullptr) {
+            submitCoalescedWork(*spec, std::move(command), std::move(reply), options);
+        } else {
+            submitAdapterWork(*spec, std::move(command), std::move(reply), options);
+        }
+        return;
+    case DispatchClass::Batch:
+        submitBatchWork(*spec, std::move(command), std::move(reply), options);
+        return;
+    case DispatchClass::KeyHold:
+        if (command.type == MessageType::CMD_KEY_DOWN) {
+            m_keyRepeater.press(command, std::move(reply));
+        } else {
+            m_keyRepeater.release(command, std::move(reply));
+        }
         return;
     case DispatchClass::SupervisorIntercepted:
+    case DispatchClass::SessionIntercepted:
         // Handled above; listed here so -Wswitch stays honest over
         // the enumerator.
         break;
     }
 
-    // Unreachable if validateDispatchTable passed at startup.
+    // Unreachable: every row's class has a case above.
     LOG_ERROR("Unhandled DispatchClass for type=",
               static_cast<int>(command.type));
     reply(Message(MessageType::RESP_ERROR));
@@ -100,7 +351,8 @@ void CommandDispatcher::dispatch(Message command, ResponseSink reply) {
 void CommandDispatcher::replay(std::vector<Message> commands) {
     if (commands.empty()) return;
     LOG_INFO("Processing ", commands.size(), " queued commands");
-    for (auto& command : commands) {
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        Message& command = commands[i];
         const DispatchSpec* spec = findDispatchByType(command.type);
         if (spec == nullptr || spec->dispatch != DispatchClass::AdapterCall) {
             // Only AdapterCall rows carry queueableWhileSuspended=true
@@ -110,20 +362,234 @@ void CommandDispatcher::replay(std::vector<Message> commands) {
                       static_cast<int>(command.type));
             continue;
         }
-        m_worker.submit([this, command = std::move(command), spec]
-                        (ICecAdapter& adapter) mutable {
-            (void)executeOnAdapter(adapter, command, *spec);
+        // The compacted queue holds a net volume change as a run of
+        // identical steps; send it as one coalesced command, as if the
+        // steps had merged in the worker queue.
+        uint32_t steps = 1;
+        if (spec->coalescedHandler != nullptr) {
+            while (steps < kMaxCoalescedSteps && i + 1 < commands.size() &&
+                   commands[i + 1].type == command.type &&
+                   commands[i + 1].deviceId == command.deviceId &&
+                   commands[i + 1].data.empty() && command.data.empty()) {
+                ++steps;
+                ++i;
+            }
+        }
+        const auto change = DeviceStateCache::changeOf(command);
+        m_stateCache.noteChangeQueued(change);
+        auto options = taskOptionsFor(command, *spec, m_commandTimeout);
+        options.onExpired = [this, type = command.type, change] {
+            LOG_WARNING("Replay: dropping type=", static_cast<int>(type),
+                        " queued past its deadline");
+            m_work.post([this, change] { m_stateCache.noteChangeSettled(change); });
+        };
+        const auto admission = m_worker.submitTask(
+            [this, command = std::move(command), spec, steps,
+             op = std::optional<ThrottledCommand>{}]
+            (ICecAdapter& adapter) mutable
+                -> std::optional<CommandThrottler::TimePoint> {
+                if (auto resumeAt = driveOnAdapter(adapter, command, *spec, steps, op)) {
+                    return resumeAt;
+                }
+                m_work.post([this, command = std::move(command),
+                             succeeded = op->succeeded()] {
+                    if (succeeded) m_stateCache.noteCommandSucceeded(command);
+                    m_stateCache.noteChangeSettled(DeviceStateCache::changeOf(command));
+                });
+                return std::nullopt;
+            },
+            std::move(options));
+        if (admission != AdapterWorker::Admission::Accepted) {
+            m_stateCache.noteChangeSettled(change);
+        }
+        if (admission == AdapterWorker::Admission::QueueFull) {
+            LOG_WARNING("Replay: worker queue full; dropping remaining commands");
+            break;
+        }
+    }
+}
+
+bool CommandDispatcher::rawTransmitAllowed(const Message& command) const {
+    if (command.type != MessageType::CMD_RAW_TRANSMIT) return true;
+    const auto frame = decodeRawFrame(command.data.data(), command.data.size());
+    if (!frame) {
+        LOG_WARNING("CMD_RAW_TRANSMIT received with a ", command.data.size(),
+                    "-byte payload (malformed client)");
+        return false;
+    }
+    if (!m_rawOpcodes.test(frame->opcode)) {
+        LOG_WARNING("Refusing raw frame with opcode 0x", std::hex,
+                    static_cast<int>(frame->opcode), std::dec,
+                    ": not in [Daemon] RawOpcodes");
+        return false;
+    }
+    return true;
+}
+
+bool CommandDispatcher::skipIfRedundant(const Message& command) {
+    // The cache holds acknowledged state only; with a change to the
+    // same state still queued, what the device ends up in is not
+    // known yet.
+    if (m_stateCache.changeQueued(command)) return false;
+
+    // A power command to a device set is redundant only when every
+    // device in it is already in the target state.
+    const auto alreadyIn = [&](CEC::cec_power_status power) {
+        const std::optional<DeviceSet> devices = decodeDeviceSet(command.data);
+        if (!devices) return m_stateCache.freshPower(command.deviceId) == power;
+        for (uint8_t address = 0; address < kBroadcastAddress; ++address) {
+            if ((*devices & (1u << address)) && m_stateCache.freshPower(address) != power) {
+                return false;
+            }
+        }
+        return *devices != 0;
+    };
+
+    switch (command.type) {
+    case MessageType::CMD_POWER_ON:
+        if (m_skipRedundantPowerOn && alreadyIn(CEC::CEC_POWER_STATUS_ON)) {
+            LOG_DEBUG("Device ", static_cast<int>(command.deviceId),
+                      " already on; skipping power on");
+            ++m_idempotenceStats.powerOn;
+            Metrics::getInstance().increment(Metrics::Counter::RedundantSkipped);
+            return true;
+        }
+        return false;
+
+    case MessageType::CMD_POWER_OFF:
+        if (m_skipRedundantPowerOff && alreadyIn(CEC::CEC_POWER_STATUS_STANDBY)) {
+            LOG_DEBUG("Device ", static_cast<int>(command.deviceId),
+                      " already in standby; skipping power off");
+            ++m_idempotenceStats.powerOff;
+            Metrics::getInstance().increment(Metrics::Counter::RedundantSkipped);
+            return true;
+        }
+        return false;
+
+    case MessageType::CMD_CHANGE_SOURCE: {
+        // Only HDMI sources have a physical address to compare; the
+        // TV-internal inputs are always sent.
+        if (!m_skipRedundantSource || command.data.empty()) return false;
+        const uint8_t source = command.data[0];
+        if (source < kFirstHdmiSource || source > kLastHdmiSource) {
+            return false;
+        }
+        if (m_stateCache.freshActiveSource() == ops::hdmiPhysicalAddress(source)) {
+            LOG_DEBUG("Source ", static_cast<int>(source),
+                      " already active; skipping source change");
+            ++m_idempotenceStats.source;
+            Metrics::getInstance().increment(Metrics::Counter::RedundantSkipped);
+            return true;
+        }
+        return false;
+    }
+
+    default:
+        return false;
+    }
+}
+
+void CommandDispatcher::answerQuery(Message command, ResponseSink reply) {
+    if (auto answer = m_stateCache.answer(command)) {
+        reply(std::move(*answer));
+        return;
+    }
+
+    // Stale with the adapter closed for idleness, or reopening: the
+    // probe needs the bus, so reopen it as a command would and answer
+    // once it is back.
+    if (m_lifecycle.isIdleClosed() || m_lifecycle.isOpening()) {
+        m_lifecycle.noteActivity();
+        reopenIdleAdapter();
+        m_lifecycle.hold(std::move(command), std::move(reply));
+        return;
+    }
+
+    // Stale: probe the bus, then answer from whatever it reported. A
+    // status query needs only its own device; the others need a scan.
+    std::optional<uint8_t> target;
+    if (command.type == MessageType::CMD_QUERY_STATUS) target = command.deviceId;
+    m_stateCache.refresh(target, WorkPriority::Interactive,
+        [this, command = std::move(command), reply = std::move(reply)](bool ok) {
+            reply(ok ? m_stateCache.snapshot(command)
+                     : Message(MessageType::RESP_ERROR));
         });
+}
+
+void CommandDispatcher::reopenIdleAdapter() {
+    if (!m_lifecycle.isIdleClosed()) return;
+    m_lifecycle.reopenIdleAsync(
+        [this](bool adapterValid, std::vector<AdapterLifecycle::HeldCommand> held) {
+            for (auto& entry : held) {
+                if (adapterValid) {
+                    dispatch(std::move(entry.command), std::move(entry.reply));
+                } else {
+                    entry.reply(Message(MessageType::RESP_NOT_READY));
+                }
+            }
+        });
+}
+
+Message CommandDispatcher::handleTrace(const Message& command, uint64_t session) {
+    if (command.data.empty()) return Message(MessageType::RESP_ERROR);
+
+    Tracer& tracer = Tracer::getInstance();
+    switch (static_cast<TraceOp>(command.data[0])) {
+    case TraceOp::Off:
+        tracer.setEnabled(false);
+        LOG_INFO("Pipeline tracing disabled");
+        return Message(MessageType::RESP_SUCCESS);
+
+    case TraceOp::On:
+        tracer.setEnabled(true);
+        LOG_INFO("Pipeline tracing enabled");
+        return Message(MessageType::RESP_SUCCESS);
+
+    case TraceOp::Dump: {
+        if (command.data.size() < 3) return Message(MessageType::RESP_ERROR);
+        const std::size_t chunk =
+            (static_cast<std::size_t>(command.data[1]) << 8) | command.data[2];
+        // One dump is rendered once and served from the copy, so the
+        // chunks stitch together even while recording continues.
+        auto dump = std::find_if(m_traceDumps.begin(), m_traceDumps.end(),
+                                 [session](const TraceDump& d) { return d.session == session; });
+        if (chunk == 0) {
+            if (dump == m_traceDumps.end()) {
+                // A client that went away mid-dump never asks for its
+                // last chunk; the oldest such copy makes way.
+                if (m_traceDumps.size() >= kMaxTraceDumps) m_traceDumps.erase(m_traceDumps.begin());
+                dump = m_traceDumps.insert(m_traceDumps.end(), TraceDump{session, {}});
+            }
+            dump->json = tracer.renderChromeJson();
+        }
+        if (dump == m_traceDumps.end()) return Message(MessageType::RESP_ERROR);
+
+        const std::string& json = dump->json;
+        const std::size_t offset = chunk * kTraceChunkSize;
+        if (offset >= json.size()) {
+            m_traceDumps.erase(dump);
+            return Message(MessageType::RESP_ERROR);
+        }
+        const std::size_t length = std::min(kTraceChunkSize, json.size() - offset);
+        const bool more = offset + length < json.size();
+
+        InlineBytes payload;
+        payload.reserve(1 + length);
+        payload.push_back(more ? 1 : 0);
+        payload.append(reinterpret_cast<const uint8_t*>(json.data()) + offset, length);
+        if (!more) m_traceDumps.erase(dump);
+        return Message(MessageType::RESP_SUCCESS, 0, std::move(payload));
     }
+    }
+    return Message(MessageType::RESP_ERROR);
 }
 
 Message CommandDispatcher::handleSuspendedInline(const Message& command,
                                                   const DispatchSpec& spec) {
     // Resolve the command's human-readable name from the client-side
-    // registry for the log lines below. Two linear scans (one here
-    // via findByType, one earlier via findDispatchByType) cost ~20 ns
-    // over the registry's dozen entries — worth paying for operator-
-    // legible diagnostics over a bare type integer.
+    // registry for the log lines below. Like findDispatchByType
+    // earlier, findByType is one indexed load, so operator-legible
+    // diagnostics cost nothing over a bare type integer.
     const CommandSpec* nameSpec = findByType(command.type);
     const std::string_view name =
         nameSpec != nullptr ? nameSpec->name
@@ -131,10 +597,14 @@ Message CommandDispatcher::handleSuspendedInline(const Message& command,
 
     if (m_queueCommandsDuringSuspend && spec.queueableWhileSuspended) {
         // We observed isSuspended() true a moment ago on the same
-        // (main) thread, so the append is guaranteed; enqueue repeats
-        // the check internally as a belt-and-braces safety net for
-        // future callers.
-        m_lifecycle.enqueue(command);
+        // (main) thread, so only a full queue refuses the append;
+        // enqueue repeats the suspended check internally as a
+        // belt-and-braces safety net for future callers.
+        if (!m_lifecycle.enqueue(command)) {
+            LOG_WARNING("Command '", name,
+                        "' refused: the suspend queue is full");
+            return Message(MessageType::RESP_BUSY);
+        }
         LOG_INFO("Queued command '", name,
                  "' for execution after resume");
         return Message(MessageType::RESP_SUCCESS);
@@ -146,40 +616,303 @@ Message CommandDispatcher::handleSuspendedInline(const Message& command,
 
 void CommandDispatcher::submitAdapterWork(const DispatchSpec& spec,
                                            Message command,
-                                           ResponseSink reply) {
+                                           ResponseSink reply,
+                                           const RequestOptions& request) {
     // DispatchSpec rows live in kDispatchTable's static storage, so
     // capturing a raw pointer to @p spec is safe across the worker-
-    // then-main hop below.
-    m_worker.submit([this, command = std::move(command),
-                     reply = std::move(reply),
-                     specPtr = &spec](ICecAdapter& adapter) mutable {
-        Message response = executeOnAdapter(adapter, command, *specPtr);
-        m_work.post([reply = std::move(reply),
-                     response = std::move(response)]() mutable {
-            reply(std::move(response));
+    // then-main hop below. The task and its expiry hook each carry a
+    // copy of the sink, and the worker runs exactly one of them; a
+    // refused submission answers through the original.
+    const ResponseSink ack = detachOutcome(reply, request);
+    const auto change = DeviceStateCache::changeOf(command);
+    m_stateCache.noteChangeQueued(change);
+    auto options = taskOptionsFor(command, spec, m_commandTimeout, request);
+    options.onExpired = [this, reply, change]() mutable {
+        LOG_WARNING("Dropping command queued past its deadline");
+        m_work.post([this, reply = std::move(reply), change] {
+            m_stateCache.noteChangeSettled(change);
+            reply(Message(MessageType::RESP_ERROR));
         });
+    };
+    const auto admission = m_worker.submitTask(
+        [this, command = std::move(command), reply, specPtr = &spec,
+         op = std::optional<ThrottledCommand>{}]
+        (ICecAdapter& adapter) mutable
+            -> std::optional<CommandThrottler::TimePoint> {
+            if (auto resumeAt = driveOnAdapter(adapter, command, *specPtr, 1, op)) {
+                return resumeAt;
+            }
+            // The task is finished, so its command can move into the
+            // reply post.
+            m_work.post([this, reply = std::move(reply), command = std::move(command),
+                         response = responseFor(*op)]() mutable {
+                if (response.type == MessageType::RESP_SUCCESS) {
+                    m_stateCache.noteCommandSucceeded(command);
+                }
+                m_stateCache.noteChangeSettled(DeviceStateCache::changeOf(command));
+                reply(std::move(response));
+            });
+            return std::nullopt;
+        },
+        std::move(options));
+    if (admission != AdapterWorker::Admission::Accepted) {
+        m_stateCache.noteChangeSettled(change);
+    }
+    answerAdmission(admission, reply, ack);
+}
+
+void CommandDispatcher::submitCoalescedWork(const DispatchSpec& spec,
+                                            Message command,
+                                            ResponseSink reply,
+                                            const RequestOptions& request) {
+    const AdapterWorker::CoalesceKey key = coalesceKeyFor(command);
+    const ResponseSink ack = detachOutcome(reply, request);
+    const WorkPriority priority = priorityFor(spec, request);
+    std::shared_ptr<CoalescedBatch>& tail =
+        m_tailBatches[static_cast<std::size_t>(priority)];
+
+    // The merge closure runs synchronously under the worker lock, and
+    // only if the tail job of `priority`'s queue carries `key`. Keyed
+    // jobs are submitted solely from here on the main thread, so a
+    // matching tail is necessarily that class's m_tailBatches entry.
+    const bool merged = m_worker.mergeIntoTail(priority, key, [this, &tail, &reply] {
+        CoalescedBatch& batch = *tail;
+        batch.replies.push_back(std::move(reply));
+        if (batch.steps < kMaxCoalescedSteps) {
+            ++batch.steps;
+            ++m_coalescingStats.merged;
+            Metrics::getInstance().increment(Metrics::Counter::CoalescedMerged);
+        } else {
+            ++m_coalescingStats.dropped;
+            Metrics::getInstance().increment(Metrics::Counter::CoalescedDropped);
+        }
     });
+    if (merged) {
+        if (ack) ack(Message(MessageType::RESP_SUCCESS));
+        return;
+    }
+
+    std::shared_ptr<CoalescedBatch> batch;
+    if (m_spareBatches.empty()) {
+        batch = std::make_shared<CoalescedBatch>(
+            CoalescedBatch{key, std::move(command), &spec, {}, 1});
+    } else {
+        batch = std::move(m_spareBatches.back());
+        m_spareBatches.pop_back();
+        *batch = CoalescedBatch{key, std::move(command), &spec, std::move(batch->replies), 1};
+    }
+    batch->replies.push_back(std::move(reply));
+    tail = batch;
+
+    auto options = taskOptionsFor(batch->command, spec, m_commandTimeout, request);
+    options.key       = key;
+    options.onExpired = [this, batch] {
+        LOG_WARNING("Dropping ", batch->replies.size(),
+                    " request(s) queued past their deadline");
+        m_work.post([batch] {
+            for (auto& reply : batch->replies) {
+                reply(Message(MessageType::RESP_ERROR));
+            }
+        });
+    };
+    const auto admission = m_worker.submitTask(
+        [this, batch, op = std::optional<ThrottledCommand>{}]
+        (ICecAdapter& adapter) mutable
+            -> std::optional<CommandThrottler::TimePoint> {
+        // The first slice runs after the dequeue, so the batch is
+        // closed to further merges from here on.
+        if (!op && batch->replies.size() > 1) {
+            LOG_DEBUG("Executing coalesced batch: ", batch->replies.size(),
+                      " request(s) as ", batch->steps, " step(s)");
+        }
+        if (auto resumeAt = driveOnAdapter(adapter, batch->command,
+                                           *batch->spec, batch->steps, op)) {
+            return resumeAt;
+        }
+        m_work.post([this, batch, response = responseFor(*op)]() mutable {
+            if (response.type == MessageType::RESP_SUCCESS) {
+                m_stateCache.noteCommandSucceeded(batch->command);
+            }
+            for (auto& reply : batch->replies) {
+                reply(response);
+            }
+            recycleBatch(std::move(batch));
+        });
+        return std::nullopt;
+    }, std::move(options));
+    // A refused batch was never queued, so nothing merged into it.
+    answerAdmission(admission, batch->replies.front(), ack);
 }
 
-Message CommandDispatcher::executeOnAdapter(ICecAdapter& adapter,
-                                             const Message& command,
-                                             const DispatchSpec& spec) {
-    // Runs on the worker thread. The outer try/catch owns the
-    // RESP_ERROR fallback; handlers are free to propagate exceptions
-    // from ops::* or libcec.
-    try {
-        if (spec.requiresAdapterConnection && !adapter.isConnected()) {
-            LOG_ERROR("Cannot process command: CEC adapter not connected");
-            return Message(MessageType::RESP_ERROR);
+void CommandDispatcher::recycleBatch(std::shared_ptr<CoalescedBatch> batch) {
+    // A tail entry naming it could only ever be refused by
+    // mergeIntoTail, but drop it so a reopened batch has one owner.
+    for (auto& tail : m_tailBatches) {
+        if (tail == batch) tail.reset();
+    }
+    if (m_spareBatches.size() >= kMaxSpareBatches) return;
+    // Clearing keeps the sink vector's capacity for the next batch.
+    batch->replies.clear();
+    m_spareBatches.push_back(std::move(batch));
+}
+
+void CommandDispatcher::submitBatchWork(const DispatchSpec& spec,
+                                        Message command,
+                                        ResponseSink reply,
+                                        const RequestOptions& request) {
+    std::vector<BatchStep> steps;
+    if (command.type == MessageType::CMD_SCENE) {
+        // Scene steps were parsed and gated when the config loaded.
+        const std::string name(command.data.begin(), command.data.end());
+        const Scene* scene = findScene(m_scenes, name);
+        if (scene == nullptr) {
+            LOG_WARNING("Unknown scene: ", name);
+            reply(Message(MessageType::RESP_ERROR));
+            return;
+        }
+        steps.reserve(scene->steps.size());
+        for (const auto& step : scene->steps) {
+            if (!rawTransmitAllowed(step.command)) {
+                reply(Message(MessageType::RESP_ERROR));
+                return;
+            }
+            steps.push_back(BatchStep{step.command, findDispatchByType(step.command.type),
+                                      step.pauseBefore});
+        }
+        LOG_INFO("Running scene ", name, " (", steps.size(), " command(s))");
+    } else {
+        // Validate every step before any of them runs: a batch naming a
+        // lifecycle or state-only command is rejected whole rather than
+        // half-executed.
+        auto decoded = decodeBatch(command.data);
+        if (!decoded) {
+            LOG_ERROR("Malformed batch payload (", command.data.size(), " bytes)");
+            reply(Message(MessageType::RESP_ERROR));
+            return;
+        }
+        steps.reserve(decoded->size());
+        for (auto& step : *decoded) {
+            const DispatchSpec* stepSpec = findDispatchByType(step.type);
+            if (stepSpec == nullptr || stepSpec->dispatch != DispatchClass::AdapterCall) {
+                LOG_ERROR("Batch step type=", static_cast<int>(step.type),
+                          " is not an adapter command");
+                reply(Message(MessageType::RESP_ERROR));
+                return;
+            }
+            if (!rawTransmitAllowed(step)) {
+                reply(Message(MessageType::RESP_ERROR));
+                return;
+            }
+            steps.push_back(BatchStep{std::move(step), stepSpec, {}});
+        }
+        LOG_DEBUG("Executing batch of ", steps.size(), " command(s)");
+    }
+
+    // One task runs the steps back to back, with no client round trip
+    // between them. It is ordered on the lane of every destination it
+    // touches, so it neither overtakes work already queued for one of
+    // them nor lets later work to them in between its steps; each step
+    // is still paced on its own throttle lane. A scene's pause parks
+    // the task, timed from the end of the previous step, and work for
+    // other devices may run meanwhile.
+    const ResponseSink ack = detachOutcome(reply, request);
+    DeviceStateCache::PendingChange change;
+    for (const BatchStep& step : steps) change |= DeviceStateCache::changeOf(step.command);
+    m_stateCache.noteChangeQueued(change);
+    auto options = taskOptionsFor(command, spec, m_commandTimeout, request);
+    options.lane = AdapterWorker::kNoLane;
+    for (const BatchStep& step : steps) {
+        const auto lane = orderingLaneFor(step.command, *step.spec);
+        if (lane == AdapterWorker::kNoLane) continue;
+        if (options.lane == AdapterWorker::kNoLane) {
+            options.lane = lane;
+        } else if (lane != options.lane) {
+            options.alsoOn |= static_cast<AdapterWorker::LaneSet>(
+                1u << (lane % AdapterWorker::kLaneCount));
         }
-        if (spec.adapterHandler != nullptr &&
-            spec.adapterHandler(adapter, m_throttler, command)) {
-            return Message(MessageType::RESP_SUCCESS);
+    }
+    options.onExpired = [this, reply, change]() mutable {
+        LOG_WARNING("Dropping batch queued past its deadline");
+        m_work.post([this, reply = std::move(reply), change] {
+            m_stateCache.noteChangeSettled(change);
+            reply(Message(MessageType::RESP_ERROR));
+        });
+    };
+    const auto admission = m_worker.submitTask(
+        [this, steps = std::move(steps), reply,
+         results = std::vector<uint8_t>{},
+         op = std::optional<ThrottledCommand>{}, paused = false]
+        (ICecAdapter& adapter) mutable
+            -> std::optional<CommandThrottler::TimePoint> {
+            while (results.size() < steps.size()) {
+                const BatchStep& step = steps[results.size()];
+                if (!op && !paused && step.pauseBefore.count() > 0) {
+                    paused = true;
+                    return CommandThrottler::Clock::now() + step.pauseBefore;
+                }
+                if (auto resumeAt = driveOnAdapter(adapter, step.command,
+                                                   *step.spec, 1, op)) {
+                    return resumeAt;
+                }
+                results.push_back(static_cast<uint8_t>(responseFor(*op).type));
+                op.reset();
+                paused = false;
+            }
+            const bool allOk = std::all_of(results.begin(), results.end(),
+                [](uint8_t r) {
+                    return r == static_cast<uint8_t>(MessageType::RESP_SUCCESS);
+                });
+            m_work.post([this, reply = std::move(reply), allOk, steps = std::move(steps),
+                         results = std::move(results)]() mutable {
+                DeviceStateCache::PendingChange change;
+                for (std::size_t i = 0; i < steps.size(); ++i) {
+                    change |= DeviceStateCache::changeOf(steps[i].command);
+                    if (results[i] == static_cast<uint8_t>(MessageType::RESP_SUCCESS)) {
+                        m_stateCache.noteCommandSucceeded(steps[i].command);
+                    }
+                }
+                m_stateCache.noteChangeSettled(change);
+                reply(Message(allOk ? MessageType::RESP_SUCCESS
+                                    : MessageType::RESP_ERROR,
+                              0, std::move(results)));
+            });
+            return std::nullopt;
+        },
+        std::move(options));
+    if (admission != AdapterWorker::Admission::Accepted) {
+        m_stateCache.noteChangeSettled(change);
+    }
+    answerAdmission(admission, reply, ack);
+}
+
+std::optional<CommandThrottler::TimePoint>
+CommandDispatcher::driveOnAdapter(ICecAdapter& adapter,
+                                  const Message& command,
+                                  const DispatchSpec& spec,
+                                  uint32_t steps,
+                                  std::optional<ThrottledCommand>& op) {
+    // Runs on the worker thread. The try/catch owns the RESP_ERROR
+    // fallback; handlers and the bodies they return are free to
+    // propagate exceptions from ops::* or libcec.
+    try {
+        if (!op) {
+            if (spec.requiresAdapterConnection && !adapter.isConnected()) {
+                LOG_ERROR("Cannot process command: CEC adapter not connected");
+                op = ThrottledCommand::finished(false);
+            } else if (steps > 1 && spec.coalescedHandler != nullptr) {
+                op = spec.coalescedHandler(adapter, m_throttler, command, steps);
+            } else if (spec.adapterHandler != nullptr) {
+                op = spec.adapterHandler(adapter, m_throttler, command);
+            } else {
+                op = ThrottledCommand::finished(false);
+            }
         }
+        return op->resume();
     } catch (const std::exception& e) {
         LOG_ERROR("Exception during dispatch: ", e.what());
     }
-    return Message(MessageType::RESP_ERROR);
+    op = ThrottledCommand::finished(false);
+    return std::nullopt;
 }
 
 } // namespace cec_control
@@ -1,18 +1,30 @@
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "../common/messages.h"
 #include "app_config.h"
+#include "cec/work_priority.h"
 #include "command_throttler.h"
+#include "key_repeater.h"
+#include "scene.h"
 
 namespace cec_control {
 
 class AdapterLifecycle;
 class AdapterWorker;
+class DeviceStateCache;
 class ICecAdapter;
 class MainThreadWork;
 class StandbyPolicy;
+class LoopTimer;
 struct DispatchSpec;
 
 /**
@@ -29,26 +41,66 @@ struct DispatchSpec;
  * ## Dispatch paths
  *
  * Every incoming command is classified via @c findDispatchByType in
- * @c command_dispatch.h. The dispatcher observes three outcomes:
+ * @c command_dispatch.h. The dispatcher observes four outcomes:
  *
  *  - @b Gated reject (shutdown gate tripped, unknown type, suspended
  *    + non-queueable) — replies @c RESP_ERROR synchronously on the
  *    main thread.
- *  - @b DispatchClass::StateOnly — delegated to @c StandbyPolicy::apply
- *    and replied synchronously. @c CMD_AUTO_STANDBY is the only
- *    @c StateOnly row in @c kDispatchTable today.
+ *  - @b DispatchClass::StateOnly — @c CMD_AUTO_STANDBY is delegated
+ *    to @c StandbyPolicy::apply and replied synchronously. The
+ *    @c CMD_QUERY_* commands are answered synchronously from
+ *    @c DeviceStateCache when it holds a fresh answer; otherwise
+ *    @c answerQuery has the cache refresh itself on the worker, first
+ *    reopening an idle-closed adapter, and replies once the result is
+ *    back on the main thread.
  *  - @b DispatchClass::AdapterCall (volume, power, source, mute,
  *    @c CMD_RESTART_ADAPTER) — @c submitAdapterWork submits a worker
  *    job; the job invokes the sink via @c MainThreadWork::post on
  *    completion, so the client sees the genuine outcome rather than a
- *    fire-and-forget ack.
+ *    fire-and-forget ack. An acknowledged command is also reported
+ *    to @c DeviceStateCache::noteCommandSucceeded from that same
+ *    main-thread post.
+ *  - @b DispatchClass::Batch (@c CMD_BATCH, @c CMD_SCENE) —
+ *    @c submitBatchWork runs the decoded sub-commands, or the named
+ *    scene's compiled steps, as one worker task and replies once,
+ *    with one result byte per command.
+ *  - @b DispatchClass::KeyHold (@c CMD_KEY_DOWN, @c CMD_KEY_UP) —
+ *    forwarded to @c m_keyRepeater, which keeps the key pressed on
+ *    the bus between the two and replies once each frame is sent.
+ *
+ * ## Coalescing
+ *
+ * Rows with a @c coalescedHandler (volume up / down, key) are
+ * submitted with a coalesce key derived from type, target and
+ * payload. A matching request that arrives while that job is still
+ * the last one queued on the worker joins it instead of taking a new
+ * throttle slot: its sink is appended to the batch and the batch's
+ * step count grows, up to @c kMaxCoalescedSteps. Requests beyond the
+ * cap still join — and receive the batch's outcome — but add no
+ * further step; they are counted as dropped. This is what stops a
+ * held remote key from building seconds of backlog that keeps moving
+ * the volume after release. Every merged sink is invoked exactly once
+ * with the batch's single @c RESP_SUCCESS / @c RESP_ERROR.
+ *
+ * ## Redundant-command filter
+ *
+ * With the matching @c DispatcherConfig::skipRedundant* flag set, a
+ * power-on, standby or HDMI source change that the fresh
+ * @c DeviceStateCache shows is already in effect is answered
+ * @c RESP_SUCCESS on the main thread and never reaches the worker.
+ * Skips are counted per command in @c IdempotenceStats. Batch steps and
+ * replayed commands are not filtered: earlier steps may change the
+ * state a later one is judged against, and a resumed bus may differ
+ * from what the cache saw before suspend.
  *
  * @c DispatchClass::SupervisorIntercepted rows never reach this class:
  * @c CECDaemon::handleCommand short-circuits @c CMD_SUSPEND and
- * @c CMD_RESUME straight into @c PowerSupervisor. The dispatcher's
- * own switch rejects any stray one defensively; the startup-time
- * @c validateDispatchTable invariant makes the stray case unreachable
- * in practice.
+ * @c CMD_RESUME straight into @c PowerSupervisor; likewise
+ * @c DispatchClass::SessionIntercepted ones, which @c SocketServer
+ * answers on the session (@c CMD_SUBSCRIBE). The dispatcher's
+ * own switch rejects any stray one defensively; the compile-time
+ * checks on @c kDispatchTable make the stray case unreachable in
+ * practice.
  *
  * ## Shutdown
  *
@@ -60,11 +112,38 @@ struct DispatchSpec;
  */
 class CommandDispatcher {
 public:
+    /**
+     * Ceiling on the steps one coalesced batch executes. Sized so a
+     * batch finishes in well under a second at the default throttle
+     * cadence; a held key therefore stops moving the volume within
+     * roughly one batch of being released.
+     */
+    static constexpr uint32_t kMaxCoalescedSteps = 5;
+
+    /**
+     * Lifetime counters for the coalescing stage. @c merged counts
+     * requests that joined an already-queued batch (each adding one
+     * step); @c dropped counts requests that joined a batch already at
+     * @c kMaxCoalescedSteps and were answered without adding a step.
+     */
+    struct CoalescingStats {
+        uint64_t merged  = 0;
+        uint64_t dropped = 0;
+    };
+
+    /** Lifetime counts of commands the redundant-command filter answered. */
+    struct IdempotenceStats {
+        uint64_t powerOn  = 0;
+        uint64_t powerOff = 0;
+        uint64_t source   = 0;
+    };
+
     /**
      * @param config        Read-only snapshot; the dispatcher extracts
      *                      its seed values (throttler tuning, queue-
-     *                      during-suspend flag) at construction and
-     *                      does not retain a reference.
+     *                      during-suspend flag, command timeout) at
+     *                      construction and does not retain a
+     *                      reference.
      * @param worker        Non-owning; must outlive @c this. Every
      *                      adapter call is submitted here.
      * @param work          Non-owning; must outlive @c this. Used to
@@ -76,12 +155,20 @@ public:
      *                      inline path.
      * @param standbyPolicy Non-owning; must outlive @c this. Handles
      *                      @c DispatchClass::StateOnly commands.
+     * @param stateCache    Non-owning; must outlive @c this. Answers
+     *                      the @c CMD_QUERY_* commands and is told
+     *                      the outcome of every acknowledged command.
+     * @param keyRepeatTimer Non-owning; paces the repeats of a held
+     *                      key. The daemon installs its handler,
+     *                      which calls @c onKeyRepeatTimerFired.
      */
     CommandDispatcher(const AppConfig&  config,
                       AdapterWorker&    worker,
                       MainThreadWork&   work,
                       AdapterLifecycle& lifecycle,
-                      StandbyPolicy&    standbyPolicy);
+                      StandbyPolicy&    standbyPolicy,
+                      DeviceStateCache& stateCache,
+                      LoopTimer&        keyRepeatTimer);
 
     ~CommandDispatcher() = default;
 
@@ -98,19 +185,57 @@ public:
      * Route an incoming wire command. See the class-level doc-comment
      * for the three dispatch classes and where the sink fires. Main
      * thread only.
+     *
+     * @p options carries what a version 2 frame asked for. A background
+     * flag and a deadline apply to the worker submission. Under
+     * ack-on-accept an adapter or batch command is answered as soon as
+     * the worker queues it, and its outcome only counted in metrics. A
+     * command held across an adapter reopen or queued while suspended
+     * runs with the daemon's defaults, as does a state-only or key-hold
+     * one, which answers without a worker queue.
      */
-    void dispatch(Message command, ResponseSink reply);
+    void dispatch(Message command, ResponseSink reply, const RequestOptions& options = {});
 
     /**
      * Re-issue @p commands as fresh worker jobs through the same
-     * @c executeOnAdapter + throttler path used by live dispatch. Main
+     * @c driveOnAdapter + throttler path used by live dispatch. Main
      * thread only. Called by @c PowerSupervisor with the vector
      * drained by @c AdapterLifecycle::resumeAsync after a successful
      * reopen. No-op for an empty input.
      */
     void replay(std::vector<Message> commands);
 
+    /**
+     * Adopt the hot-swappable parts of a reloaded @p config: throttler
+     * tuning, the queue-during-suspend and redundant-command policies,
+     * the queue deadline and the scene table. Commands already
+     * submitted keep the values they were submitted with; a scene
+     * already running keeps its old steps. Main thread only.
+     */
+    void reconfigure(const AppConfig& config);
+
+    /** Key-repeat timer handler; see @c KeyRepeater. Main thread only. */
+    void onKeyRepeatTimerFired() { m_keyRepeater.onTimerFired(); }
+
+    /** Snapshot of the coalescing counters. Main thread only. */
+    [[nodiscard]] CoalescingStats coalescingStats() const noexcept {
+        return m_coalescingStats;
+    }
+
+    /** Snapshot of the redundant-command counters. Main thread only. */
+    [[nodiscard]] IdempotenceStats idempotenceStats() const noexcept {
+        return m_idempotenceStats;
+    }
+
+    /**
+     * The throttler pacing every adapter command, for the daemon to
+     * seed and capture learned device profiles through.
+     */
+    [[nodiscard]] CommandThrottler& throttler() noexcept { return m_throttler; }
+
 private:
+    struct CoalescedBatch;
+
     /**
      * Policy for a command arriving while suspended: queue it for
      * post-resume replay or reject. Main thread only. The caller has
@@ -120,6 +245,42 @@ private:
     Message handleSuspendedInline(const Message& command,
                                    const DispatchSpec& spec);
 
+    /**
+     * Redundant-command filter: @c true, with the skip counted, if
+     * @p command is enabled for filtering and the fresh cached state
+     * shows it would change nothing. Main thread only.
+     */
+    [[nodiscard]] bool skipIfRedundant(const Message& command);
+
+    /**
+     * Allowlist gate: @c false, after logging why, if @p command is a
+     * CMD_RAW_TRANSMIT that is malformed or whose opcode is not in
+     * [Daemon] RawOpcodes. Every other command passes.
+     */
+    [[nodiscard]] bool rawTransmitAllowed(const Message& command) const;
+
+    /**
+     * Answer a @c CMD_QUERY_* command from @c m_stateCache, refreshing
+     * the cache first if its answer is stale. A stale query that finds
+     * the adapter idle-closed reopens it and is held until the reopen
+     * completes, like an adapter command. Main thread only.
+     */
+    void answerQuery(Message command, ResponseSink reply);
+
+    /**
+     * Start reopening an idle-closed adapter; the commands held
+     * meanwhile are re-dispatched once it is open. No-op unless
+     * @c AdapterLifecycle::isIdleClosed. Main thread only.
+     */
+    void reopenIdleAdapter();
+
+    /**
+     * Apply a @c CMD_TRACE operation: toggle recording, or serve one
+     * chunk of the trace JSON from @p session's entry in
+     * @c m_traceDumps. Main thread only.
+     */
+    [[nodiscard]] Message handleTrace(const Message& command, uint64_t session);
+
     /**
      * Submit @p command to the worker for @c DispatchClass::AdapterCall
      * dispatch; post the resulting @c Message back to the main thread
@@ -127,33 +288,112 @@ private:
      */
     void submitAdapterWork(const DispatchSpec& spec,
                            Message command,
-                           ResponseSink reply);
+                           ResponseSink reply,
+                           const RequestOptions& request);
+
+    /**
+     * Coalescible variant of @c submitAdapterWork: fold @p command into
+     * the worker's tail batch when it matches, otherwise open a new
+     * batch and submit it. Main thread only.
+     */
+    void submitCoalescedWork(const DispatchSpec& spec,
+                             Message command,
+                             ResponseSink reply,
+                             const RequestOptions& request);
 
     /**
-     * Worker-thread body: invokes @c spec.adapterHandler under the
-     * @c isConnected gate dictated by @c spec.requiresAdapterConnection,
-     * catches exceptions, and returns @c RESP_SUCCESS / @c RESP_ERROR.
-     * Shared between live dispatch (@c submitAdapterWork) and
-     * @c replay.
+     * Take back @p batch once its replies are sent, to be reopened by a
+     * later @c submitCoalescedWork instead of allocating a new one.
+     * The worker may still hold its task's reference but no longer
+     * reads the batch. Main thread only.
      */
-    Message executeOnAdapter(ICecAdapter& adapter,
-                             const Message& command,
-                             const DispatchSpec& spec);
+    void recycleBatch(std::shared_ptr<CoalescedBatch> batch);
+
+    /**
+     * @c DispatchClass::Batch path: decode @p command's sub-commands,
+     * reject the whole batch unless each is an @c AdapterCall, then
+     * run them in order as one worker task and answer with the
+     * per-step results described at @c encodeBatch. A @c CMD_SCENE
+     * takes its steps, and the pauses between them, from
+     * @c m_scenes instead. Main thread only.
+     */
+    void submitBatchWork(const DispatchSpec& spec,
+                         Message command,
+                         ResponseSink reply,
+                         const RequestOptions& request);
+
+    /**
+     * Worker-thread body shared by every submission path. On the
+     * first slice (@p op empty) applies the @c isConnected gate
+     * dictated by @c spec.requiresAdapterConnection and builds the
+     * command via @c spec.adapterHandler — or, for a merged batch with
+     * @p steps > 1, @c spec.coalescedHandler. Every slice then resumes
+     * it. Returns the instant the worker should call again, or
+     * @c std::nullopt once @p op has finished; exceptions finish it as
+     * failed.
+     */
+    std::optional<CommandThrottler::TimePoint>
+    driveOnAdapter(ICecAdapter& adapter,
+                   const Message& command,
+                   const DispatchSpec& spec,
+                   uint32_t steps,
+                   std::optional<ThrottledCommand>& op);
 
     AdapterWorker&    m_worker;
     MainThreadWork&   m_work;
     AdapterLifecycle& m_lifecycle;
     StandbyPolicy&    m_standbyPolicy;
+    DeviceStateCache& m_stateCache;
     CommandThrottler  m_throttler;
 
     // Shutdown gate. Main-thread only — see the class-level doc comment.
     bool m_shutdownComplete = false;
 
     // Queue-during-suspend policy. Main-thread-only reader (dispatch
-    // is main-thread), main-thread-only writer (only a future SIGHUP
-    // handler would flip it, also main-thread). A plain bool is
-    // enough; promote to atomic only if a cross-thread reader appears.
+    // is main-thread), main-thread-only writer (reconfigure, on a
+    // SIGHUP reload). A plain bool is enough; promote to atomic only
+    // if a cross-thread reader appears.
     bool m_queueCommandsDuringSuspend;
+
+    // How long a submitted command may wait in the worker queue before
+    // it is answered RESP_ERROR unattempted. Zero disables the
+    // deadline.
+    std::chrono::milliseconds m_commandTimeout;
+
+    // Per-command switches for the redundant-command filter.
+    bool m_skipRedundantPowerOn;
+    bool m_skipRedundantPowerOff;
+    bool m_skipRedundantSource;
+    IdempotenceStats m_idempotenceStats;
+
+    // Opcodes CMD_RAW_TRANSMIT may put on the bus.
+    std::bitset<256> m_rawOpcodes;
+
+    // Scenes compiled from the config; CMD_SCENE looks its name up here.
+    SceneTable m_scenes;
+
+    // The key held between CMD_KEY_DOWN and CMD_KEY_UP, if any.
+    KeyRepeater m_keyRepeater;
+
+    // Trace JSON being served chunk by chunk to `trace dump` clients,
+    // one per session, so concurrent dumps never splice; rendered on
+    // each chunk-0 request and released after the last chunk.
+    struct TraceDump {
+        uint64_t    session = 0;
+        std::string json;
+    };
+    std::vector<TraceDump> m_traceDumps;
+
+    // Most recently opened coalescing batch of each WorkPriority, since
+    // the Background flag can put the same key in two queues at once.
+    // Main-thread only; the worker reaches a batch through its own job
+    // capture. May refer to a batch that already ran —
+    // AdapterWorker::mergeIntoTail is the authority on whether it is
+    // still mergeable.
+    std::array<std::shared_ptr<CoalescedBatch>, kWorkPriorityCount> m_tailBatches;
+    // Finished batches awaiting reuse; see recycleBatch.
+    std::vector<std::shared_ptr<CoalescedBatch>>                    m_spareBatches;
+    CoalescingStats                                                 m_coalescingStats;
 };
 
 } // namespace cec_control
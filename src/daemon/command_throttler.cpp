@@ -1,105 +1,459 @@
 #include "command_throttler.h"
 #include "../common/logger.h"
+#include "../common/trace.h"
+#include "flight_recorder.h"
+#include "metrics.h"
 
 #include <algorithm>
-#include <thread>
+#include <sstream>
+#include <utility>
 
 namespace cec_control {
 
 namespace {
 
 // Unit step for the failure-driven exponential schedules in both
-// executeWithThrottle's post-attempt retry delay and currentInterval's
+// recordFailure's post-attempt retry delay and currentInterval's
 // extra term. Keeping them shared names the coupling: changing this
 // value bumps both schedules in lockstep. Operator-tunable knobs for
 // the adaptive interval live in ThrottlerConfig; this step is a
 // source-level tuning parameter, not a config field.
 constexpr uint32_t kFailureStepMs = 100;
 
+// Advance @p slot to at least @p candidate. Used to push a lane's
+// next-allowed instant past a bus slot that landed later than the
+// lane reservation itself.
+template <typename TimePoint>
+void advanceTo(std::atomic<TimePoint>& slot, TimePoint candidate) noexcept {
+    TimePoint current = slot.load(std::memory_order_acquire);
+    while (current < candidate &&
+           !slot.compare_exchange_weak(current, candidate,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        // current refreshed by failed CAS; loop and re-compare.
+    }
+}
+
 } // namespace
 
 CommandThrottler::CommandThrottler(ThrottlerConfig config)
-    : m_config(config),
-      m_nextAllowed(Clock::now()),
-      m_consecutiveFailures(0) {}
+    : m_baseIntervalMs(config.baseIntervalMs),
+      m_maxIntervalMs(config.maxIntervalMs),
+      m_maxRetryAttempts(config.maxRetryAttempts),
+      m_busIntervalMs(config.busIntervalMs),
+      m_adaptive(config.adaptive),
+      m_minIntervalMs(config.minIntervalMs),
+      m_breakerThreshold(config.breakerThreshold),
+      m_breakerCooldownMs(config.breakerCooldownMs),
+      m_busNextAllowed(Clock::now()) {}
 
-bool CommandThrottler::executeWithThrottle(std::function<bool()> command) {
-    for (uint32_t attempt = 0; attempt < m_config.maxRetryAttempts; ++attempt) {
-        reserveSlotAndSleep();
+void CommandThrottler::reconfigure(const ThrottlerConfig& config) noexcept {
+    m_baseIntervalMs.store(config.baseIntervalMs, std::memory_order_relaxed);
+    m_maxIntervalMs.store(config.maxIntervalMs, std::memory_order_relaxed);
+    m_maxRetryAttempts.store(config.maxRetryAttempts, std::memory_order_relaxed);
+    m_busIntervalMs.store(config.busIntervalMs, std::memory_order_relaxed);
+    m_minIntervalMs.store(config.minIntervalMs, std::memory_order_relaxed);
+    // Turned off and back on, a lane starts over from BaseIntervalMs
+    // rather than from what it learned before. A worker adapting at
+    // the same moment may store one more step; the next success or
+    // failure moves it on from there either way.
+    if (m_adaptive.exchange(config.adaptive, std::memory_order_relaxed) != config.adaptive) {
+        for (Lane& lane : m_lanes) lane.learnedIntervalMs.store(0, std::memory_order_relaxed);
+    }
+    m_breakerThreshold.store(config.breakerThreshold, std::memory_order_relaxed);
+    m_breakerCooldownMs.store(config.breakerCooldownMs, std::memory_order_relaxed);
+}
 
-        if (command()) {
-            m_consecutiveFailures.store(0, std::memory_order_release);
-            return true;
-        }
+void CommandThrottler::recordSuccess(uint8_t logicalAddress,
+                                     Clock::duration busTime) noexcept {
+    Lane& lane = laneFor(logicalAddress);
+    lane.consecutiveFailures.store(0, std::memory_order_release);
+    lane.commands.fetch_add(1, std::memory_order_relaxed);
+    closeBreaker(logicalAddress, "acknowledged a command");
 
-        m_consecutiveFailures.fetch_add(1, std::memory_order_acq_rel);
+    // Smoothed like TCP's SRTT, gain 1/8; the first sample is taken as is.
+    const auto sample = static_cast<uint32_t>(std::min<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(busTime).count(),
+        UINT32_MAX));
+    const uint32_t previous = lane.ackTimeUs.load(std::memory_order_relaxed);
+    const uint32_t smoothed = previous == 0
+        ? sample
+        : static_cast<uint32_t>((static_cast<uint64_t>(previous) * 7 + sample) / 8);
+    lane.ackTimeUs.store(std::max(smoothed, 1u), std::memory_order_relaxed);
 
-        LOG_WARNING("CEC command failed, retry attempt ", attempt + 1,
-                    " of ", m_config.maxRetryAttempts);
+    if (m_adaptive.load(std::memory_order_relaxed)) adapt(lane, true);
+}
 
-        // Exponential retry back-off, outside every lock so unrelated
-        // callers progress freely.
-        const uint32_t delayMs = (attempt == 0)
-            ? kFailureStepMs
-            : (kFailureStepMs * (1u << attempt));
-        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
-    }
+std::chrono::milliseconds
+CommandThrottler::recordFailure(uint8_t logicalAddress, uint32_t attempt) noexcept {
+    Lane& lane = laneFor(logicalAddress);
+    lane.consecutiveFailures.fetch_add(1, std::memory_order_acq_rel);
+    lane.commands.fetch_add(1, std::memory_order_relaxed);
+    if (m_adaptive.load(std::memory_order_relaxed)) adapt(lane, false);
 
-    LOG_INFO("Command sent but no successful acknowledgment received");
+    // Exponential retry back-off: 100, 200, 400, ... ms.
+    const uint32_t delayMs = (attempt == 0)
+        ? kFailureStepMs
+        : (kFailureStepMs * (1u << std::min(attempt, 10u)));
+    return std::chrono::milliseconds(delayMs);
+}
+
+void CommandThrottler::recordExhausted(uint8_t logicalAddress) noexcept {
+    Lane& lane = laneFor(logicalAddress);
+    const uint32_t threshold = m_breakerThreshold.load(std::memory_order_relaxed);
+    const uint32_t streak = lane.exhaustedStreak.fetch_add(1, std::memory_order_acq_rel) + 1;
+    if (threshold > 0 && streak >= threshold && logicalAddress != kBroadcastAddress) {
+        const auto cooldown = std::chrono::milliseconds(
+            m_breakerCooldownMs.load(std::memory_order_relaxed));
+        // A failed probe lands here too; admit already pushed its
+        // retry time out by a cooldown, so only a fresh trip sets it.
+        if (!lane.breakerOpen.load(std::memory_order_acquire)) {
+            lane.breakerRetryAt.store(Clock::now() + cooldown, std::memory_order_release);
+            if (!lane.breakerOpen.exchange(true, std::memory_order_acq_rel)) {
+                LOG_WARNING("Device ", static_cast<int>(logicalAddress), " did not answer ",
+                            streak, " commands in a row; failing commands to it for ",
+                            cooldown.count(), "ms");
+                Metrics::getInstance().increment(Metrics::Counter::BreakerOpened);
+            }
+        }
+    }
 
-    // Soften the failure count by one: a retry-exhausted command is
-    // treated as a single adaptive-throttle hit rather than N, matching
-    // the pre-atomic semantics.
-    uint32_t expected = m_consecutiveFailures.load(std::memory_order_relaxed);
+    // Soften the failure count by one, matching the pre-atomic
+    // semantics of a retry-exhausted command counting as one hit.
+    auto& failures = lane.consecutiveFailures;
+    uint32_t expected = failures.load(std::memory_order_relaxed);
     while (expected > 0 &&
-           !m_consecutiveFailures.compare_exchange_weak(
+           !failures.compare_exchange_weak(
                expected, expected - 1,
                std::memory_order_acq_rel, std::memory_order_relaxed)) {
         // expected refreshed by failed CAS; loop and retry.
     }
+}
+
+CommandThrottler::Gate CommandThrottler::admit(uint8_t logicalAddress, TimePoint now) noexcept {
+    Lane& lane = laneFor(logicalAddress);
+    if (!lane.breakerOpen.load(std::memory_order_acquire)) return Gate::Closed;
+    TimePoint retryAt = lane.breakerRetryAt.load(std::memory_order_acquire);
+    const auto cooldown = std::chrono::milliseconds(
+        m_breakerCooldownMs.load(std::memory_order_relaxed));
+    while (now >= retryAt) {
+        // Whoever moves the retry time on owns the probe.
+        if (lane.breakerRetryAt.compare_exchange_weak(retryAt, now + cooldown,
+                                                      std::memory_order_acq_rel,
+                                                      std::memory_order_acquire)) {
+            return Gate::Probe;
+        }
+    }
+    return Gate::Open;
+}
+
+void CommandThrottler::noteHeardFrom(uint8_t logicalAddress) noexcept {
+    closeBreaker(logicalAddress, "was heard from on the bus");
+}
+
+void CommandThrottler::closeBreaker(uint8_t logicalAddress, const char* reason) noexcept {
+    Lane& lane = laneFor(logicalAddress);
+    lane.exhaustedStreak.store(0, std::memory_order_release);
+    if (lane.breakerOpen.load(std::memory_order_relaxed) &&
+        lane.breakerOpen.exchange(false, std::memory_order_acq_rel)) {
+        LOG_INFO("Device ", static_cast<int>(logicalAddress), " ", reason,
+                 "; sending commands to it again");
+    }
+}
+
+uint32_t CommandThrottler::learnedInterval(const Lane& lane) const noexcept {
+    const uint32_t minMs = m_minIntervalMs.load(std::memory_order_relaxed);
+    const uint32_t maxMs = std::max(m_maxIntervalMs.load(std::memory_order_relaxed), minMs);
+    uint32_t learned = lane.learnedIntervalMs.load(std::memory_order_relaxed);
+    if (learned == 0) learned = m_baseIntervalMs.load(std::memory_order_relaxed);
+    return std::clamp(learned, minMs, maxMs);
+}
+
+void CommandThrottler::adapt(Lane& lane, bool succeeded) noexcept {
+    const uint32_t current = learnedInterval(lane);
+    uint32_t next;
+    if (succeeded) {
+        // Additive decrease of the gap, never below the time the
+        // device takes to acknowledge a frame.
+        const uint32_t ackMs = (lane.ackTimeUs.load(std::memory_order_relaxed) + 999) / 1000;
+        const uint32_t floor = std::max(m_minIntervalMs.load(std::memory_order_relaxed), ackMs);
+        next = current > floor + kAdaptiveStepMs ? current - kAdaptiveStepMs : floor;
+    } else {
+        // Multiplicative increase; learnedInterval applies the ceiling.
+        next = current >= UINT32_MAX / 2 ? UINT32_MAX : current * 2;
+    }
+    lane.learnedIntervalMs.store(std::max(next, 1u), std::memory_order_relaxed);
+}
+
+std::string CommandThrottler::renderLanes() const {
+    std::ostringstream out;
+    for (std::size_t i = 0; i < kLaneCount; ++i) {
+        const Lane& lane = m_lanes[i];
+        if (lane.commands.load(std::memory_order_relaxed) == 0) continue;
+        out << "throttle_lane{" << i << "} interval_ms=" << currentInterval(lane).count()
+            << " ack_us=" << lane.ackTimeUs.load(std::memory_order_relaxed)
+            << " failures=" << lane.consecutiveFailures.load(std::memory_order_relaxed);
+        switch (lane.streamPath.load(std::memory_order_relaxed)) {
+            case StreamPathSupport::Works:   out << " stream_path=works";   break;
+            case StreamPathSupport::Refused: out << " stream_path=refused"; break;
+            case StreamPathSupport::Unknown: break;
+        }
+        if (lane.breakerOpen.load(std::memory_order_relaxed)) out << " breaker=open";
+        out << '\n';
+    }
+    return out.str();
+}
+
+bool CommandThrottler::shouldTryStreamPath(uint8_t logicalAddress) noexcept {
+    Lane& lane = laneFor(logicalAddress);
+    if (lane.streamPath.load(std::memory_order_relaxed) != StreamPathSupport::Refused) {
+        return true;
+    }
+    // Worker-only, like every source change, so no CAS is needed.
+    const uint32_t skips = lane.streamPathSkips.load(std::memory_order_relaxed) + 1;
+    if (skips < kStreamPathReprobeInterval) {
+        lane.streamPathSkips.store(skips, std::memory_order_relaxed);
+        return false;
+    }
+    lane.streamPathSkips.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+LaneProfile CommandThrottler::laneProfile(uint8_t logicalAddress) const noexcept {
+    const Lane& lane = laneFor(logicalAddress);
+    LaneProfile profile;
+    profile.intervalMs = lane.learnedIntervalMs.load(std::memory_order_relaxed);
+    profile.ackUs      = lane.ackTimeUs.load(std::memory_order_relaxed);
+    profile.streamPath = lane.streamPath.load(std::memory_order_relaxed);
+    return profile;
+}
 
-    return false;
+void CommandThrottler::seedLane(uint8_t logicalAddress, const LaneProfile& profile) noexcept {
+    Lane& lane = laneFor(logicalAddress);
+    if (lane.commands.load(std::memory_order_relaxed) != 0) return;
+    // learnedInterval clamps on every read, so a value saved under
+    // other bounds needs no correction here.
+    lane.learnedIntervalMs.store(profile.intervalMs, std::memory_order_relaxed);
+    lane.ackTimeUs.store(profile.ackUs, std::memory_order_relaxed);
+    if (profile.streamPath != StreamPathSupport::Unknown) {
+        lane.streamPath.store(profile.streamPath, std::memory_order_relaxed);
+    }
 }
 
-std::chrono::milliseconds CommandThrottler::currentInterval() const noexcept {
-    const uint32_t failures = m_consecutiveFailures.load(std::memory_order_acquire);
+std::chrono::milliseconds
+CommandThrottler::currentInterval(const Lane& lane) const noexcept {
+    if (m_adaptive.load(std::memory_order_relaxed)) {
+        // The failure streak is already folded into the learned value.
+        return std::chrono::milliseconds(learnedInterval(lane));
+    }
+    const uint32_t failures = lane.consecutiveFailures.load(std::memory_order_acquire);
+    const uint32_t baseMs   = m_baseIntervalMs.load(std::memory_order_relaxed);
+    const uint32_t maxMs    = m_maxIntervalMs.load(std::memory_order_relaxed);
     if (failures == 0) {
-        return std::chrono::milliseconds(m_config.baseIntervalMs);
+        return std::chrono::milliseconds(baseMs);
     }
 
     // Exponential back-off, capped at the span between base and max.
     const uint32_t capped = std::min(failures, 5u);
-    const uint32_t span   = (m_config.maxIntervalMs > m_config.baseIntervalMs)
-                            ? m_config.maxIntervalMs - m_config.baseIntervalMs
-                            : 0u;
+    const uint32_t span   = (maxMs > baseMs) ? maxMs - baseMs : 0u;
     const uint32_t extra  = std::min(kFailureStepMs * (1u << capped), span);
-    return std::chrono::milliseconds(m_config.baseIntervalMs + extra);
+    return std::chrono::milliseconds(baseMs + extra);
 }
 
-void CommandThrottler::reserveSlotAndSleep() {
-    const auto interval = currentInterval();
-    const auto now      = Clock::now();
+CommandThrottler::TimePoint CommandThrottler::reserveSlot(uint8_t logicalAddress) {
+    Lane& lane = laneFor(logicalAddress);
+    const auto interval    = currentInterval(lane);
+    const auto busInterval = std::chrono::milliseconds(
+        m_busIntervalMs.load(std::memory_order_relaxed));
+    const auto now         = Clock::now();
+
+    // Lane first: my slot on this destination is whichever is later,
+    // the lane's next-reserved instant or now.
+    TimePoint expected = lane.nextAllowed.load(std::memory_order_acquire);
+    TimePoint laneSlot;
+    for (;;) {
+        laneSlot = (expected > now) ? expected : now;
+        if (lane.nextAllowed.compare_exchange_weak(
+                expected, laneSlot + interval,
+                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            break;
+        }
+        // expected refreshed by failed CAS; loop and re-evaluate laneSlot.
+    }
 
-    TimePoint expected = m_nextAllowed.load(std::memory_order_acquire);
+    // Then the bus: never earlier than the lane slot, and never within
+    // busInterval of another destination's reserved slot.
+    expected = m_busNextAllowed.load(std::memory_order_acquire);
     TimePoint mySlot;
     for (;;) {
-        // My slot is whichever is later: the next-reserved instant or now.
-        mySlot = (expected > now) ? expected : now;
-        const TimePoint nextReservation = mySlot + interval;
-        if (m_nextAllowed.compare_exchange_weak(
-                expected, nextReservation,
+        mySlot = (expected > laneSlot) ? expected : laneSlot;
+        if (m_busNextAllowed.compare_exchange_weak(
+                expected, mySlot + busInterval,
                 std::memory_order_acq_rel, std::memory_order_acquire)) {
             break;
         }
         // expected refreshed by failed CAS; loop and re-evaluate mySlot.
     }
 
-    if (mySlot > now) {
-        const auto sleepFor = std::chrono::duration_cast<std::chrono::milliseconds>(
-            mySlot - now);
-        LOG_DEBUG("Throttling CEC command for ", sleepFor.count(),
-                  "ms (adaptive delay)");
-        std::this_thread::sleep_until(mySlot);
+    // A busy bus may have pushed the send past the lane slot; keep the
+    // lane's spacing measured from when the command actually goes out.
+    if (mySlot > laneSlot) {
+        advanceTo(lane.nextAllowed, mySlot + interval);
+    }
+    return mySlot;
+}
+
+ThrottledCommand::ThrottledCommand(CommandThrottler& throttler,
+                                   uint8_t logicalAddress,
+                                   Body body)
+    : m_throttler(&throttler),
+      m_body(std::move(body)),
+      m_address(logicalAddress),
+      // Zero configured attempts means the command is never sent,
+      // matching the historical loop that simply did not iterate.
+      m_state(throttler.maxRetryAttempts() > 0 && m_body
+              ? State::NeedSlot : State::Finished) {}
+
+ThrottledCommand ThrottledCommand::finished(bool result) {
+    ThrottledCommand command;
+    command.m_result = result;
+    return command;
+}
+
+std::optional<CommandThrottler::TimePoint> ThrottledCommand::resume() {
+    using Clock = CommandThrottler::Clock;
+
+    for (;;) {
+        switch (m_state) {
+        case State::Finished:
+            return std::nullopt;
+
+        case State::NeedSlot: {
+            // A move to another device's lane keeps its attempt and
+            // phase; that device's breaker was not consulted, since
+            // the command is already under way.
+            if (m_attempt == 0 && !m_probe && !m_moving) {
+                switch (m_throttler->admit(m_address)) {
+                case CommandThrottler::Gate::Closed:
+                    break;
+                case CommandThrottler::Gate::Probe:
+                    LOG_DEBUG("Probing unresponsive device ", static_cast<int>(m_address));
+                    FlightRecorder::getInstance().throttle(flight_log::ThrottleDecision::Probe,
+                                                           m_address);
+                    m_probe = true;
+                    break;
+                case CommandThrottler::Gate::Open:
+                    LOG_DEBUG("Not sending to unresponsive device ",
+                              static_cast<int>(m_address));
+                    Metrics::getInstance().increment(Metrics::Counter::BreakerRejected);
+                    FlightRecorder::getInstance().throttle(
+                        flight_log::ThrottleDecision::Rejected, m_address);
+                    m_state       = State::Finished;
+                    m_result      = false;
+                    m_unreachable = true;
+                    return std::nullopt;
+                }
+            }
+            const auto slot = m_throttler->reserveSlot(m_address);
+            m_state   = State::Running;
+            if (!m_moving) m_phase = 0;
+            m_moving  = false;
+            m_busTime = {};
+            const auto now = Clock::now();
+            Metrics::getInstance().record(Metrics::Latency::ThrottleDelay,
+                                          slot > now ? slot - now : Clock::duration{});
+            // Logged ahead of time: the wait is the park until @c slot.
+            Tracer::getInstance().complete(TracePoint::ThrottleWait, now,
+                                           slot > now ? slot : now, m_address);
+            if (slot > now) {
+                FlightRecorder::getInstance().throttle(
+                    flight_log::ThrottleDecision::Delay, m_address,
+                    static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(slot - now)
+                            .count()));
+                LOG_DEBUG("Throttling CEC command for ",
+                          std::chrono::duration_cast<std::chrono::milliseconds>(
+                              slot - now).count(),
+                          "ms (adaptive delay)");
+                return slot;
+            }
+            break;
+        }
+
+        case State::Running: {
+            AttemptStep step;
+            const auto started = Clock::now();
+            try {
+                step = m_body(m_phase);
+            } catch (...) {
+                m_state  = State::Finished;
+                m_result = false;
+                throw;
+            }
+            m_busTime += Clock::now() - started;
+
+            switch (step.kind) {
+            case AttemptStep::Kind::Pause:
+                m_phase = step.nextPhase;
+                return Clock::now() + step.delay;
+
+            case AttemptStep::Kind::Succeeded:
+                m_throttler->recordSuccess(m_address, m_busTime);
+                m_state  = State::Finished;
+                m_result = true;
+                return std::nullopt;
+
+            case AttemptStep::Kind::Next:
+                // The current device's part is over; its lane learns
+                // from it as from a command of its own.
+                if (step.partOk) {
+                    m_throttler->recordSuccess(m_address, m_busTime);
+                } else {
+                    (void)m_throttler->recordFailure(m_address, m_attempt);
+                }
+                m_address = step.address;
+                m_phase   = step.nextPhase;
+                m_moving  = true;
+                m_state   = State::NeedSlot;
+                break;
+
+            case AttemptStep::Kind::Failed: {
+                if (step.address != AttemptStep::kCurrentLane && step.address != m_address) {
+                    // The current lane acknowledged; the retry belongs
+                    // to the device that did not.
+                    m_throttler->recordSuccess(m_address, m_busTime);
+                    m_address = step.address;
+                }
+                const auto backoff = m_throttler->recordFailure(m_address, m_attempt);
+                const uint32_t maxAttempts = m_probe ? 1 : m_throttler->maxRetryAttempts();
+                LOG_WARNING("CEC command to device ", static_cast<int>(m_address),
+                            " failed, retry attempt ", m_attempt + 1,
+                            " of ", maxAttempts);
+                if (++m_attempt < maxAttempts) {
+                    Metrics::getInstance().increment(Metrics::Counter::ThrottleRetries);
+                    FlightRecorder::getInstance().throttle(
+                        flight_log::ThrottleDecision::Retry, m_address,
+                        static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::microseconds>(backoff)
+                                .count()));
+                    // Park for the back-off; the next resume reserves
+                    // a fresh slot before re-running the body.
+                    m_state = State::NeedSlot;
+                    return Clock::now() + backoff;
+                }
+                LOG_INFO("Command sent but no successful acknowledgment received");
+                m_throttler->recordExhausted(m_address);
+                Metrics::getInstance().increment(Metrics::Counter::ThrottleExhausted);
+                FlightRecorder::getInstance().throttle(flight_log::ThrottleDecision::Exhausted,
+                                                       m_address);
+                m_state  = State::Finished;
+                m_result = false;
+                return std::nullopt;
+            }
+            }
+            break;
+        }
+        }
     }
 }
 
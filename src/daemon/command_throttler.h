@@ -1,15 +1,21 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
-#include <functional>
+#include <optional>
+#include <string>
+
+#include "../common/inline_function.h"
 
 namespace cec_control {
 
 /**
- * Tuning parameters for @c CommandThrottler. Consumed once at
- * construction and immutable thereafter. Defaults match the values
+ * Tuning parameters for @c CommandThrottler. Seeded at construction
+ * and replaceable at runtime through @c CommandThrottler::reconfigure
+ * (a SIGHUP reload). Defaults match the values
  * emitted by @c loadAppConfig when the operator omits every throttler
  * key, so a struct default-constructed in code behaves the same as
  * one loaded from a config-less install.
@@ -18,55 +24,430 @@ struct ThrottlerConfig {
     uint32_t baseIntervalMs   = 200;
     uint32_t maxIntervalMs    = 1000;
     uint32_t maxRetryAttempts = 3;
+    /**
+     * Minimum spacing between any two commands regardless of target.
+     * Per-destination lanes pace each device individually; this floor
+     * keeps the shared bus from being saturated when several healthy
+     * lanes are ready at once.
+     */
+    uint32_t busIntervalMs    = 50;
+    /**
+     * Learn each device's interval from its acknowledgements instead
+     * of using @c baseIntervalMs plus the failure schedule; see
+     * @c CommandThrottler.
+     */
+    bool     adaptive         = false;
+    /** Floor for a learned interval; adaptive mode only. */
+    uint32_t minIntervalMs    = 50;
+    /**
+     * Commands in a row that must exhaust their retries before a
+     * lane's circuit breaker opens; 0 = never.
+     */
+    uint32_t breakerThreshold = 3;
+    /** How long an open breaker refuses commands before letting a probe through. */
+    uint32_t breakerCooldownMs = 30000;
+};
+
+/** What a device has shown about @c SetStreamPath; see @c ops::setSource. */
+enum class StreamPathSupport : uint8_t {
+    Unknown,
+    Works,    ///< Acknowledged a stream-path change.
+    Refused,  ///< Needed the INPUT_SELECT keypress fallback instead.
+};
+
+/**
+ * What one lane has learned about its device, in the form
+ * @c DeviceProfileStore keeps across restarts.
+ */
+struct LaneProfile {
+    uint32_t          intervalMs = 0;  ///< Learned interval; 0 = none yet.
+    uint32_t          ackUs      = 0;  ///< Smoothed acknowledgement time.
+    StreamPathSupport streamPath = StreamPathSupport::Unknown;
 };
 
 /**
  * Adaptive inter-command back-off with exponential retry for the CEC
  * adapter.
  *
- * Thread-safe. Internal state (the next-allowed slot and the
- * consecutive-failure counter) lives in lock-free atomics, and every
- * sleep happens outside any lock — callers may invoke
- * @c executeWithThrottle from any thread without external
- * serialisation. Rate limiting is enforced via a CAS-based slot
- * reservation: concurrent callers queue on distinct slots rather than
- * racing for the same instant.
+ * State is split into one lane per CEC logical address (0..15), each
+ * with its own next-allowed slot and consecutive-failure counter, so a
+ * device that keeps NACKing widens only its own interval: commands to
+ * a healthy TV keep the base cadence while a flaky AVR backs off
+ * alone. A single bus slot on top of the lanes enforces
+ * @c ThrottlerConfig::busIntervalMs between any two commands.
+ *
+ * ## Adaptive mode
+ *
+ * With @c ThrottlerConfig::adaptive each lane learns its own interval
+ * in the manner of TCP congestion control, with the gap between
+ * commands standing in for the window. A lane starts at
+ * @c baseIntervalMs. Each acknowledged command narrows it by
+ * @c kAdaptiveStepMs and each failed attempt doubles it, within
+ * @c maxIntervalMs. The floor is @c minIntervalMs or the lane's
+ * smoothed acknowledgement time, whichever is longer. The
+ * acknowledgement time is how long the attempt spent in libcec calls,
+ * which is as long as the device took to ack the frame. A device that
+ * acks quickly ends up close to the floor. One that drops frames sent
+ * too close together settles just above the gap where it starts to
+ * fail. @c renderLanes reports what each lane has learned.
+ *
+ * ## Circuit breaker
+ *
+ * A device that is switched off at the wall still has commands sent to
+ * it, and each one spends every retry and back-off before it fails.
+ * Once @c breakerThreshold commands in a row to a lane have exhausted
+ * their retries, the lane's breaker opens. Until @c breakerCooldownMs
+ * passes, @c ThrottledCommand fails commands to it without touching
+ * the bus, reporting them as unreachable. After that one command is
+ * let through as a probe with a single attempt. An acknowledgement
+ * closes the breaker, and a failure keeps it open for another
+ * cooldown. Hearing from the device on the bus also closes it
+ * (@c noteHeardFrom). The broadcast address has no breaker.
+ *
+ * A lane's learning can be exported with @c laneProfile and handed
+ * back to a later process with @c seedLane, so a restarted daemon
+ * starts from the interval it had settled on rather than from
+ * @c baseIntervalMs.
+ *
+ * The throttler never sleeps. It hands out slot instants and retry
+ * delays; @c ThrottledCommand turns those into resume deadlines that
+ * the @c AdapterWorker scheduler honours while it keeps serving other
+ * ready work.
+ *
+ * Thread-safe. Internal state (the lane and bus slots, the failure
+ * counters) lives in lock-free atomics. Rate limiting is enforced via
+ * CAS-based slot reservation: concurrent callers queue on distinct
+ * slots rather than racing for the same instant.
  *
  * This class fences only @e when each command may begin. Serialisation
  * of the underlying libcec call is the caller's responsibility, which
- * in practice happens inside @c LibCecAdapter via its adapter mutex.
+ * in practice is the @c AdapterWorker's single thread.
  */
 class CommandThrottler {
 public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
     explicit CommandThrottler(ThrottlerConfig config);
 
     /**
-     * Execute @p command under the throttle + retry policy. Returns
-     * @c true on first success, @c false once every retry attempt has
-     * been consumed. Thread-safe.
+     * Swap in new tuning values. Takes effect from the next slot
+     * reservation or retry; slots already handed out, failure streaks
+     * and commands mid-retry are left alone. Switching @c adaptive
+     * either way forgets every lane's learned interval. Each value is
+     * stored on its own, so a concurrent reservation may briefly pair
+     * one old value with one new one, which is harmless for pacing.
+     */
+    void reconfigure(const ThrottlerConfig& config) noexcept;
+
+    /** Number of per-destination lanes: one per CEC logical address. */
+    static constexpr std::size_t kLaneCount = 16;
+
+    /** Attempts a @c ThrottledCommand makes before giving up. */
+    [[nodiscard]] uint32_t maxRetryAttempts() const noexcept {
+        return m_maxRetryAttempts.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Reserve the next slot on @p logicalAddress's lane and on the bus
+     * (CAS each) and return the instant at which the command may
+     * begin. Never blocks; a returned instant in the past means "now".
+     * Addresses above 15 fold onto their low nibble.
+     */
+    [[nodiscard]] TimePoint reserveSlot(uint8_t logicalAddress);
+
+    /**
+     * Clear @p logicalAddress's failure streak after a success.
+     * @p busTime is how long the successful attempt spent in adapter
+     * calls; it feeds the lane's acknowledgement time.
+     */
+    void recordSuccess(uint8_t logicalAddress,
+                       Clock::duration busTime = Clock::duration::zero()) noexcept;
+
+    /**
+     * Count a failed attempt (0-based @p attempt) against
+     * @p logicalAddress's lane and return the back-off to wait before
+     * the next one.
+     */
+    [[nodiscard]] std::chrono::milliseconds
+    recordFailure(uint8_t logicalAddress, uint32_t attempt) noexcept;
+
+    /**
+     * Soften the lane's failure count by one once every attempt of a
+     * command is spent: a retry-exhausted command is treated as a
+     * single adaptive-throttle hit rather than N. Also counts the
+     * command towards the lane's breaker, opening it at
+     * @c breakerThreshold.
+     */
+    void recordExhausted(uint8_t logicalAddress) noexcept;
+
+    /** What @c admit decided for a command about to be sent. */
+    enum class Gate : uint8_t {
+        Closed,  ///< Send as usual.
+        Probe,   ///< Breaker open, cooldown over: send once, no retries.
+        Open,    ///< Breaker open: fail without sending.
+    };
+
+    /**
+     * Consult @p logicalAddress's breaker for a new command. Grants at
+     * most one probe per cooldown: granting one restarts the cooldown,
+     * so a probe that never reports back cannot hold the breaker open
+     * for longer than one more cooldown.
      */
-    [[nodiscard]] bool executeWithThrottle(std::function<bool()> command);
+    [[nodiscard]] Gate admit(uint8_t logicalAddress, TimePoint now = Clock::now()) noexcept;
+
+    /**
+     * The bus carried a frame from @p logicalAddress: reset its
+     * exhausted-command streak and close its breaker. Any thread.
+     */
+    void noteHeardFrom(uint8_t logicalAddress) noexcept;
+
+    /**
+     * One line per lane that has carried a command:
+     * `throttle_lane{N} interval_ms=... ack_us=... failures=...`,
+     * appended to the @c CMD_STATS report. Safe from any thread.
+     */
+    [[nodiscard]] std::string renderLanes() const;
+
+    /** Snapshot of what @p logicalAddress's lane has learned. */
+    [[nodiscard]] LaneProfile laneProfile(uint8_t logicalAddress) const noexcept;
+
+    /**
+     * Start @p logicalAddress's lane from @p profile, e.g. one saved
+     * by a previous run. Ignored once the lane has carried a command:
+     * what it learned this run is the fresher measurement.
+     */
+    void seedLane(uint8_t logicalAddress, const LaneProfile& profile) noexcept;
+
+    /** Whether @p logicalAddress has been seen to honour SetStreamPath. */
+    [[nodiscard]] StreamPathSupport streamPath(uint8_t logicalAddress) const noexcept {
+        return laneFor(logicalAddress).streamPath.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Whether the next source change to @p logicalAddress should try
+     * SetStreamPath first: always, unless the device has refused it,
+     * and then only on every @c kStreamPathReprobeInterval-th call, so
+     * a firmware update or a different TV behind the same identity is
+     * noticed without paying for the refusal every time.
+     */
+    [[nodiscard]] bool shouldTryStreamPath(uint8_t logicalAddress) noexcept;
+
+    /** Record how @p logicalAddress answered a SetStreamPath. */
+    void noteStreamPath(uint8_t logicalAddress, bool worked) noexcept {
+        laneFor(logicalAddress).streamPath.store(
+            worked ? StreamPathSupport::Works : StreamPathSupport::Refused,
+            std::memory_order_relaxed);
+    }
+
+    /** Interval an adaptive lane narrows by on each success. */
+    static constexpr uint32_t kAdaptiveStepMs = 10;
+
+    /** Source changes between two SetStreamPath probes of a refusing device. */
+    static constexpr uint32_t kStreamPathReprobeInterval = 16;
 
 private:
-    using Clock     = std::chrono::steady_clock;
-    using TimePoint = Clock::time_point;
+    /** Pacing and failure state for one destination. */
+    struct Lane {
+        // Earliest time at which the next command to this destination
+        // may begin. Advanced by CAS, so two callers cannot collapse
+        // onto the same instant.
+        std::atomic<TimePoint> nextAllowed{Clock::now()};
+
+        // Consecutive-failure counter driving this lane's adaptive
+        // interval; see @c currentInterval.
+        std::atomic<uint32_t> consecutiveFailures{0};
+
+        // Adaptive mode: the learned interval (0 until the lane's
+        // first command) and the smoothed acknowledgement time, in µs.
+        // Written by the worker only; atomic so renderLanes can read.
+        std::atomic<uint32_t> learnedIntervalMs{0};
+        std::atomic<uint32_t> ackTimeUs{0};
+        std::atomic<uint64_t> commands{0};
+
+        // Circuit breaker: commands in a row that exhausted their
+        // retries, whether the breaker is open, and when it next
+        // grants a probe.
+        std::atomic<uint32_t>  exhaustedStreak{0};
+        std::atomic<bool>      breakerOpen{false};
+        std::atomic<TimePoint> breakerRetryAt{TimePoint{}};
+
+        std::atomic<StreamPathSupport> streamPath{StreamPathSupport::Unknown};
+        // Source changes sent straight to the fallback since the last
+        // SetStreamPath probe.
+        std::atomic<uint32_t> streamPathSkips{0};
+    };
+
+    [[nodiscard]] Lane& laneFor(uint8_t logicalAddress) noexcept {
+        return m_lanes[logicalAddress % kLaneCount];
+    }
+    [[nodiscard]] const Lane& laneFor(uint8_t logicalAddress) const noexcept {
+        return m_lanes[logicalAddress % kLaneCount];
+    }
 
-    const ThrottlerConfig m_config;
+    /** Compute @p lane's current inter-command interval from its failure count. */
+    [[nodiscard]] std::chrono::milliseconds currentInterval(const Lane& lane) const noexcept;
+
+    /**
+     * @p lane's learned interval, seeded from @c baseIntervalMs on
+     * first use and kept inside the configured bounds.
+     */
+    [[nodiscard]] uint32_t learnedInterval(const Lane& lane) const noexcept;
+
+    /** Adaptive mode: move @p lane's interval after an attempt. */
+    void adapt(Lane& lane, bool succeeded) noexcept;
+
+    /** Reset the lane's streak and close its breaker, logging @p reason if it was open. */
+    void closeBreaker(uint8_t logicalAddress, const char* reason) noexcept;
+
+    // ThrottlerConfig's fields, held individually so reconfigure can
+    // replace them while the worker thread is reading.
+    std::atomic<uint32_t> m_baseIntervalMs;
+    std::atomic<uint32_t> m_maxIntervalMs;
+    std::atomic<uint32_t> m_maxRetryAttempts;
+    std::atomic<uint32_t> m_busIntervalMs;
+    std::atomic<bool>     m_adaptive;
+    std::atomic<uint32_t> m_minIntervalMs;
+    std::atomic<uint32_t> m_breakerThreshold;
+    std::atomic<uint32_t> m_breakerCooldownMs;
+
+    std::array<Lane, kLaneCount> m_lanes;
+
+    // Earliest time at which any command may begin, irrespective of
+    // destination. Enforces the bus-occupancy floor.
+    std::atomic<TimePoint> m_busNextAllowed;
+};
+
+/**
+ * One slice of a @c ThrottledCommand attempt body: the attempt
+ * finished (either way), or it wants to continue at @c nextPhase after
+ * @c delay — the press-to-release gap of a keypress, the spacing
+ * between two steps of a coalesced volume burst.
+ *
+ * A command to several devices moves between their lanes: @c next
+ * closes the current device's part (acknowledged or not) and continues
+ * at @c nextPhase once @c address's lane has a slot, and @c failedOn
+ * fails the attempt against @c address's lane after the current one
+ * acknowledged, so the retry is paced by the device that did not.
+ */
+struct AttemptStep {
+    enum class Kind { Succeeded, Failed, Pause, Next };
 
-    // Earliest time at which the next command may begin. Each caller
-    // CAS-reserves its slot by advancing this forward before sleeping,
-    // so two concurrent callers cannot collapse onto the same instant.
-    std::atomic<TimePoint> m_nextAllowed;
+    /** @c address value for "the lane the command is on". */
+    static constexpr uint8_t kCurrentLane = 0xFF;
 
-    // Consecutive-failure counter driving the adaptive inter-command
-    // interval; see @c currentInterval.
-    std::atomic<uint32_t> m_consecutiveFailures;
+    Kind                      kind = Kind::Failed;
+    std::chrono::milliseconds delay{};
+    uint32_t                  nextPhase = 0;
+    uint8_t                   address   = kCurrentLane;
+    /** @c Next: whether the current lane's part was acknowledged. */
+    bool                      partOk    = false;
+
+    [[nodiscard]] static AttemptStep succeeded() noexcept {
+        return {Kind::Succeeded, {}, 0};
+    }
+    [[nodiscard]] static AttemptStep failed() noexcept {
+        return {Kind::Failed, {}, 0};
+    }
+    [[nodiscard]] static AttemptStep of(bool ok) noexcept {
+        return ok ? succeeded() : failed();
+    }
+    [[nodiscard]] static AttemptStep pauseThen(std::chrono::milliseconds delay,
+                                               uint32_t nextPhase) noexcept {
+        return {Kind::Pause, delay, nextPhase};
+    }
+    [[nodiscard]] static AttemptStep next(bool partOk, uint8_t address,
+                                          uint32_t nextPhase) noexcept {
+        return {Kind::Next, {}, nextPhase, address, partOk};
+    }
+    [[nodiscard]] static AttemptStep failedOn(uint8_t address) noexcept {
+        return {Kind::Failed, {}, 0, address};
+    }
+};
+
+/**
+ * @class ThrottledCommand
+ * @brief Resumable throttle + retry state machine around one CEC
+ *        command.
+ *
+ * Replaces the old blocking @c executeWithThrottle loop. Each
+ * @c resume() call advances as far as it can without waiting and
+ * reports the instant it next needs to run — the reserved throttle
+ * slot, the end of a retry back-off, or a pause the body asked for —
+ * so the @c AdapterWorker can park the command on its deadline heap
+ * and serve other ready work meanwhile.
+ *
+ * The body is invoked with a phase index that starts at 0 on every
+ * attempt and follows @c AttemptStep::nextPhase across pauses. A
+ * body may also carry its own state across attempts (a coalesced
+ * volume burst resumes at the step that failed rather than replaying
+ * acknowledged ones).
+ *
+ * Worker-thread only; not thread-safe. Any adapter reference the body
+ * captures must stay valid until the command finishes — true for the
+ * worker-owned adapter, which outlives every task the worker runs.
+ */
+class ThrottledCommand {
+public:
+    /** Capture bytes an attempt body may carry. */
+    static constexpr std::size_t kBodyCapacity = 40;
+
+    using Body = InlineFunction<AttemptStep(uint32_t phase), kBodyCapacity>;
+
+    /**
+     * @param throttler      Non-owning; must outlive @c this.
+     * @param logicalAddress Destination lane the command is paced on.
+     * @param body           Attempt body; see the class doc.
+     */
+    ThrottledCommand(CommandThrottler& throttler,
+                     uint8_t logicalAddress,
+                     Body body);
+
+    /**
+     * An already-finished command carrying @p result. For outcomes
+     * decided before the bus is touched (payload validation, the
+     * disconnected-adapter short-circuit) or by an unthrottled call.
+     */
+    [[nodiscard]] static ThrottledCommand finished(bool result);
+
+    /**
+     * Advance without blocking. Returns the instant at which to call
+     * again, or @c std::nullopt once the command has finished (see
+     * @c succeeded). Exceptions from the body propagate; the command
+     * is then finished and failed.
+     */
+    [[nodiscard]] std::optional<CommandThrottler::TimePoint> resume();
+
+    /** Meaningful once @c resume has returned @c std::nullopt. */
+    [[nodiscard]] bool succeeded() const noexcept { return m_result; }
+
+    /**
+     * Whether the command failed without being sent because its
+     * destination's circuit breaker is open.
+     */
+    [[nodiscard]] bool unreachable() const noexcept { return m_unreachable; }
+
+private:
+    enum class State : uint8_t { NeedSlot, Running, Finished };
 
-    /** Compute the current inter-command interval from the failure count. */
-    [[nodiscard]] std::chrono::milliseconds currentInterval() const noexcept;
+    ThrottledCommand() = default;
 
-    /** Reserve the next throttle slot (CAS) and sleep until it lands. */
-    void reserveSlotAndSleep();
+    // Ordered to pack: a command rides inside an AdapterWorker task,
+    // whose inline capacity is tight.
+    CommandThrottler* m_throttler = nullptr;
+    Body              m_body;
+    /** Time the current attempt has spent in the body, pauses excluded. */
+    CommandThrottler::Clock::duration m_busTime{};
+    uint32_t          m_attempt   = 0;
+    uint32_t          m_phase     = 0;
+    uint8_t           m_address   = 0;
+    State             m_state     = State::Finished;
+    bool              m_result    = false;
+    /** A breaker probe: one attempt, no retries. */
+    bool              m_probe       = false;
+    bool              m_unreachable = false;
+    /** The slot wanted is for an @c AttemptStep::next move, mid-attempt. */
+    bool              m_moving      = false;
 };
 
 } // namespace cec_control
@@ -0,0 +1,83 @@
+#include "config_schema.h"
+
+#include "../common/logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+namespace cec_control {
+
+namespace config_schema {
+
+namespace {
+
+bool equalsIgnoringCase(std::string_view a, std::string_view b) noexcept {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) ==
+                      std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+} // namespace
+
+std::optional<int64_t> parseNumber(std::string_view value, const Key& key) {
+    // strtoll needs a terminator; a config value that does not fit
+    // the buffer is not a number anyway.
+    char buffer[32];
+    const bool fits = !value.empty() && value.size() < sizeof(buffer);
+    char* end = nullptr;
+    long long parsed = 0;
+    errno = 0;
+    if (fits) {
+        std::copy(value.begin(), value.end(), buffer);
+        buffer[value.size()] = '\0';
+        parsed = std::strtoll(buffer, &end, 10);
+    }
+    if (!fits || end != buffer + value.size() || errno == ERANGE) {
+        LOG_WARNING("Invalid number for [", key.section, "] ", key.name, ": ", value,
+                    " (using default)");
+        return std::nullopt;
+    }
+    const int64_t clamped = std::clamp<int64_t>(parsed, key.min, key.max);
+    if (clamped != parsed) {
+        LOG_WARNING("[", key.section, "] ", key.name, " ", parsed, " is out of range ",
+                    key.min, "-", key.max, "; using ", clamped);
+    }
+    return clamped;
+}
+
+void parseBool(std::string_view value, bool& out, const Key& key) {
+    for (const std::string_view yes : {"true", "yes", "on", "1"}) {
+        if (equalsIgnoringCase(value, yes)) {
+            out = true;
+            return;
+        }
+    }
+    for (const std::string_view no : {"false", "no", "off", "0"}) {
+        if (equalsIgnoringCase(value, no)) {
+            out = false;
+            return;
+        }
+    }
+    LOG_WARNING("Invalid value for [", key.section, "] ", key.name, ": ", value,
+                " (expected true or false; using default)");
+}
+
+void parseUInt(std::string_view value, uint32_t& out, const Key& key) {
+    if (const auto number = parseNumber(value, key)) out = static_cast<uint32_t>(*number);
+}
+
+void parseInt(std::string_view value, int& out, const Key& key) {
+    if (const auto number = parseNumber(value, key)) out = static_cast<int>(*number);
+}
+
+void parseString(std::string_view value, std::string& out, const Key&) {
+    out.assign(value.data(), value.size());
+}
+
+} // namespace config_schema
+
+} // namespace cec_control
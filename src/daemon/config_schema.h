@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "app_config.h"
+
+namespace cec_control {
+
+/**
+ * Declarative description of the configuration file. Each key is one
+ * constexpr @c config_schema::Key row: its section and name, the
+ * @c AppConfig field it fills, how its text becomes that field's value
+ * (and, for numbers, the range it is clamped to), and which part of a
+ * reload a change to it concerns. The table itself lives beside
+ * @c loadAppConfig, which applies a parsed file to it in one pass, and
+ * @c diffAppConfig walks the same rows to compare two snapshots.
+ *
+ * A key's default is its field's initialiser on the @c AppConfig
+ * sub-structs: loading starts from a default-constructed snapshot and
+ * a key absent from the file leaves its field alone, so there is one
+ * place to change a default.
+ *
+ * Rows are built with @c flag, @c number, @c text and @c custom, which
+ * check at compile time that the member path names a field of the type
+ * the parser writes.
+ */
+namespace config_schema {
+
+/** What a reload does about a changed key: the @c AppConfigChanges flag it raises. */
+enum class Reload : uint8_t {
+    Adapter,
+    Throttler,
+    Dispatcher,
+    Standby,
+    HookScripts,
+    Restart,  ///< Named in @c AppConfigChanges::restartOnly.
+};
+
+struct Key;
+
+using FieldFn      = void* (*)(AppConfig&) noexcept;
+using ConstFieldFn = const void* (*)(const AppConfig&) noexcept;
+/** Store @p value in @p field, warning and leaving it alone if unusable. */
+using ParseFn      = void (*)(std::string_view value, void* field, const Key& key);
+using EqualFn      = bool (*)(const void* a, const void* b) noexcept;
+
+/** Upper bound of a @c uint32_t key that takes any value. */
+inline constexpr int64_t kUnbounded = UINT32_MAX;
+
+struct Key {
+    std::string_view section;
+    std::string_view name;
+    Reload           reload = Reload::Restart;
+    /** Clamp range of a numeric key; a value outside it is warned about. */
+    int64_t          min    = 0;
+    int64_t          max    = 0;
+    FieldFn          field      = nullptr;
+    ConstFieldFn     constField = nullptr;
+    ParseFn          parse      = nullptr;
+    EqualFn          equal      = nullptr;
+    /**
+     * Name a restart-only change is reported under; empty means
+     * @c name. Neighbouring rows that share one are reported once, which
+     * is how a whole section (`[Logging]`) is named.
+     */
+    std::string_view label;
+
+    /** Report name for @c AppConfigChanges::restartOnly. */
+    [[nodiscard]] constexpr std::string_view reportName() const noexcept {
+        return label.empty() ? name : label;
+    }
+};
+
+template <auto... Path>
+void* fieldAt(AppConfig& config) noexcept {
+    return &(config .* ... .* Path);
+}
+
+template <auto... Path>
+const void* constFieldAt(const AppConfig& config) noexcept {
+    return &(config .* ... .* Path);
+}
+
+/** Type of the field @p Path leads to from an @c AppConfig. */
+template <auto... Path>
+using FieldType =
+    std::remove_reference_t<decltype((std::declval<AppConfig&>() .* ... .* Path))>;
+
+template <typename T>
+bool sameValue(const void* a, const void* b) noexcept {
+    return *static_cast<const T*>(a) == *static_cast<const T*>(b);
+}
+
+/** @p Parse, written for a @c T field, as a @c ParseFn. */
+template <typename T, void (*Parse)(std::string_view, T&, const Key&)>
+void parseAs(std::string_view value, void* field, const Key& key) {
+    Parse(value, *static_cast<T*>(field), key);
+}
+
+// Parsers of the plain value types. Each warns, naming the key, about
+// text it cannot use.
+void parseBool(std::string_view value, bool& out, const Key& key);
+void parseUInt(std::string_view value, uint32_t& out, const Key& key);
+void parseInt(std::string_view value, int& out, const Key& key);
+void parseString(std::string_view value, std::string& out, const Key& key);
+
+/**
+ * @p value as a base-10 integer clamped into @p key's range, with a
+ * warning when it had to be clamped. nullopt, also warned about, if it
+ * is not a number; for custom parsers with numeric values.
+ */
+[[nodiscard]] std::optional<int64_t> parseNumber(std::string_view value, const Key& key);
+
+/** A true/false key: @c true, @c yes, @c on, @c 1 and their opposites. */
+template <auto... Path>
+constexpr Key flag(std::string_view section, std::string_view name, Reload reload,
+                   std::string_view label = {}) {
+    using T = FieldType<Path...>;
+    static_assert(std::is_same_v<T, bool>, "flag() needs a bool field");
+    return Key{section, name, reload, 0, 1, &fieldAt<Path...>, &constFieldAt<Path...>,
+               &parseAs<T, parseBool>, &sameValue<T>, label};
+}
+
+/** An integer key, clamped to [@p min, @p max]. */
+template <auto... Path>
+constexpr Key number(std::string_view section, std::string_view name, int64_t min,
+                     int64_t max, Reload reload, std::string_view label = {}) {
+    using T = FieldType<Path...>;
+    static_assert(std::is_same_v<T, uint32_t> || std::is_same_v<T, int>,
+                  "number() needs a uint32_t or int field");
+    ParseFn parse = nullptr;
+    if constexpr (std::is_same_v<T, uint32_t>) {
+        parse = &parseAs<T, parseUInt>;
+    } else {
+        parse = &parseAs<T, parseInt>;
+    }
+    return Key{section, name, reload, min, max, &fieldAt<Path...>, &constFieldAt<Path...>,
+               parse, &sameValue<T>, label};
+}
+
+/** A key whose value is kept as written. */
+template <auto... Path>
+constexpr Key text(std::string_view section, std::string_view name, Reload reload,
+                   std::string_view label = {}) {
+    using T = FieldType<Path...>;
+    static_assert(std::is_same_v<T, std::string>, "text() needs a std::string field");
+    return Key{section, name, reload, 0, 0, &fieldAt<Path...>, &constFieldAt<Path...>,
+               &parseAs<T, parseString>, &sameValue<T>, label};
+}
+
+/**
+ * A key with its own parser, @p Parse, taking the field by reference.
+ * @p equal replaces @c operator== for types that lack a usable one.
+ */
+template <auto Parse, auto... Path>
+constexpr Key custom(std::string_view section, std::string_view name, Reload reload,
+                     std::string_view label = {},
+                     EqualFn equal = &sameValue<FieldType<Path...>>) {
+    using T = FieldType<Path...>;
+    static_assert(std::is_same_v<decltype(Parse), void (*)(std::string_view, T&, const Key&)>,
+                  "custom() parser does not match its field");
+    return Key{section, name, reload, 0, 0, &fieldAt<Path...>, &constFieldAt<Path...>,
+               &parseAs<T, Parse>, equal, label};
+}
+
+/** As @c custom, for a field no member path reaches (an array element). */
+template <typename T, void (*Parse)(std::string_view, T&, const Key&)>
+constexpr Key customAt(std::string_view section, std::string_view name, FieldFn field,
+                       ConstFieldFn constField, Reload reload, std::string_view label = {}) {
+    return Key{section, name, reload, 0, 0, field, constField,
+               &parseAs<T, Parse>, &sameValue<T>, label};
+}
+
+/**
+ * Whether every key name in @p keys is used once. The loader indexes
+ * rows by name alone and checks the section after, so a name may not
+ * repeat even across sections.
+ */
+template <std::size_t N>
+constexpr bool namesUnique(const std::array<Key, N>& keys) noexcept {
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = i + 1; j < N; ++j) {
+            if (keys[i].name == keys[j].name) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace config_schema
+
+} // namespace cec_control
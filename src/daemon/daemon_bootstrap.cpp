@@ -1,24 +1,56 @@
 #include "daemon_bootstrap.h"
 
 #include "../common/config_manager.h"
+#include "../common/journal_sink.h"
 #include "../common/logger.h"
 #include "../common/system_paths.h"
 #include "../common/systemd_notify.h"
 #include "app_config.h"
 #include "cec_daemon.h"
+#include "flight_recorder.h"
+#include "memory_profile.h"
+#include "startup_report.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
 #include <string>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <utility>
 
 namespace cec_control {
 
+namespace {
+
+/**
+ * True if stderr is the journal stream systemd connected for this
+ * unit. systemd exports @c JOURNAL_STREAM=<device>:<inode> for that
+ * stream; comparing it against stderr, rather than trusting its mere
+ * presence, ignores a variable inherited across a redirect.
+ */
+bool stderrIsJournal() {
+    const char* stream = std::getenv("JOURNAL_STREAM");
+    if (stream == nullptr) return false;
+    unsigned long long device = 0;
+    unsigned long long inode  = 0;
+    if (std::sscanf(stream, "%llu:%llu", &device, &inode) != 2) return false;
+    struct stat st{};
+    if (::fstat(STDERR_FILENO, &st) != 0) return false;
+    return static_cast<unsigned long long>(st.st_dev) == device &&
+           static_cast<unsigned long long>(st.st_ino) == inode;
+}
+
+} // namespace
+
 int DaemonBootstrap::runDaemon(const RunDaemon& action) {
+    StartupReport& startup = StartupReport::getInstance();
+    startup.begin();
+
     // Resolve any unset path knobs to their system defaults exactly once,
     // here at the top, so the rest of the bootstrap doesn't need to carry
     // around "empty means default" branching.
@@ -33,17 +65,37 @@ int DaemonBootstrap::runDaemon(const RunDaemon& action) {
     SystemPaths::ensureParentDirExists(logFile);
     SystemPaths::ensureParentDirExists(socketPath);
 
-    setupLogging(action, logFile);
+    {
+        const ScopedStartupPhase phase(StartupPhase::Logging);
+        setupLogging(action, logFile);
+    }
+
+    // Lines from the main thread — bootstrap, event loop, dispatcher —
+    // carry this subsystem unless a narrower scope overrides it.
+    const LogContextScope logContext(LogContext{LogSubsystem::Daemon});
 
     // Configuration is a local value; once we've extracted the AppConfig
     // snapshot it falls out of scope. No ambient/singleton access after
     // this point.
+    startup.start(StartupPhase::ConfigLoad);
     ConfigManager configManager(action.configFile);
     if (!configManager.load()) {
         LOG_WARNING("Failed to load configuration file, using defaults");
     }
 
     AppConfig config = loadAppConfig(configManager);
+    startup.finish(StartupPhase::ConfigLoad);
+    if (action.simulate) config.simulator.enabled = config.simulator.forced = true;
+    // Before the async logger's writer or any other thread can claim
+    // an arena of its own.
+    const bool lowMemory = config.daemon.lowMemory;
+    if (lowMemory) limitMallocArenas();
+    const auto& subsystemLevels = config.logging.subsystemLevels;
+    if (config.logging.async ||
+        std::any_of(subsystemLevels.begin(), subsystemLevels.end(),
+                    [](const auto& level) { return level.has_value(); })) {
+        setupLogging(action, logFile, config.logging);
+    }
     logAppConfig(config);
 
     setupProcess();
@@ -51,7 +103,7 @@ int DaemonBootstrap::runDaemon(const RunDaemon& action) {
     LOG_INFO("Running with PID: ", getpid());
 
     try {
-        CECDaemon daemon(std::move(config));
+        CECDaemon daemon(std::move(config), configManager.getConfigPath());
 
         if (!daemon.start()) {
             LOG_FATAL("Failed to start CEC daemon");
@@ -63,6 +115,11 @@ int DaemonBootstrap::runDaemon(const RunDaemon& action) {
         // units this is what transitions the unit from activating to
         // active and releases After= dependents; a no-op otherwise.
         SystemdNotify::ready();
+        startup.markReady();
+        FlightRecorder::getInstance().milestone(flight_log::Milestone::DaemonReady);
+        // Startup's transient allocations (config parsing, libcec's
+        // detection, the first scan's buffers) are free by now.
+        if (lowMemory) trimHeap("startup");
 
         LOG_INFO("CEC daemon initialized successfully, starting main loop");
         daemon.run();
@@ -110,23 +167,39 @@ void DaemonBootstrap::setupProcess() {
 }
 
 void DaemonBootstrap::setupLogging(const RunDaemon& action,
-                                    const std::string& logFile) {
+                                    const std::string& logFile,
+                                    const LoggingConfig& logging) {
     // Daemon logging routes by severity:
     //   - INFO/DEBUG/TRAFFIC -> stdout (journald captures as PRIORITY=info)
     //   - WARNING/ERROR/FATAL -> stderr (journald captures as PRIORITY=err)
+    // Under a unit whose output already goes to the journal, both bands
+    // are sent natively instead: one structured entry per line, with the
+    // exact priority and the request context as fields, and no text
+    // prefix for journald to store a second timestamp beside.
     // The file sink mirrors everything at the configured threshold so an
     // operator (or a deployment without journald) still has a durable
     // log of the daemon's activity.
+    const bool journal = stderrIsJournal();
     LogConfig cfg;
-    cfg.lowLevelSink  = LogSink::Stdout;
-    cfg.highLevelSink = LogSink::Stderr;
+    cfg.lowLevelSink  = journal ? LogSink::Journal : LogSink::Stdout;
+    cfg.highLevelSink = journal ? LogSink::Journal : LogSink::Stderr;
     cfg.filePath      = logFile;
     cfg.minLevel      = action.verbose ? LogLevel::DEBUG : LogLevel::INFO;
+    // Off the hot path: a writer thread owns the sinks, so a slow disk
+    // or a stalled journald stream no longer blocks libcec's callback
+    // thread mid-log. The Logger's destructor drains it at exit.
+    cfg.async           = logging.async;
+    cfg.asyncQueueLines = logging.queueLines;
+    cfg.overflow        = logging.overflow;
+    cfg.subsystemLevels = logging.subsystemLevels;
+    cfg.journalWriter   = sendToJournal;
 
     Logger::getInstance().configure(cfg);
 
     LOG_INFO("Logging initialised; file=", logFile,
-             ", level=", action.verbose ? "DEBUG" : "INFO");
+             ", level=", action.verbose ? "DEBUG" : "INFO",
+             ", async=", logging.async ? "true" : "false",
+             ", journal=", journal ? "native" : "stream");
 }
 
 } // namespace cec_control
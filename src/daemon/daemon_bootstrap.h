@@ -3,6 +3,7 @@
 #include <string>
 
 #include "../common/argument_parser.h"
+#include "app_config.h"
 
 namespace cec_control {
 
@@ -37,8 +38,14 @@ private:
      * resolved log path (already defaulted by the caller if @c action.logFile
      * was empty) and is used as-is without re-running the default-path
      * resolution.
+     *
+     * Called twice: once before the config file is read, synchronously,
+     * so parse warnings are not lost; and again with the file's
+     * @p logging section if it asks for the asynchronous backend or
+     * sets a subsystem's level.
      */
-    static void setupLogging(const RunDaemon& action, const std::string& logFile);
+    static void setupLogging(const RunDaemon& action, const std::string& logFile,
+                             const LoggingConfig& logging = {});
 };
 
 } // namespace cec_control
@@ -2,35 +2,59 @@
 #include "../common/logger.h"
 
 #include <poll.h>
+#include <sys/inotify.h>
 #include <time.h>
 #include <unistd.h>
 #include <algorithm>
 #include <cerrno>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
-#include <memory>
+#include <string>
+#include <string_view>
 #include <utility>
 
 namespace cec_control {
 
 namespace {
 
-/** RAII owner for sd_bus_message*. Used on error paths so we never
- *  leak a partially-built call message before it reaches sd_bus_send. */
-struct BusMessageDeleter {
-    void operator()(sd_bus_message* m) const noexcept {
-        if (m) sd_bus_message_unref(m);
-    }
-};
-using BusMessagePtr = std::unique_ptr<sd_bus_message, BusMessageDeleter>;
+constexpr const char* kSleepMatch =
+    "type='signal',"
+    "interface='org.freedesktop.login1.Manager',"
+    "member='PrepareForSleep',"
+    "path='/org/freedesktop/login1'";
+
+// arg0 narrows the bus daemon's broadcast to logind's own name, so
+// the match costs nothing while other services come and go.
+constexpr const char* kLogindOwnerMatch =
+    "type='signal',"
+    "sender='org.freedesktop.DBus',"
+    "path='/org/freedesktop/DBus',"
+    "interface='org.freedesktop.DBus',"
+    "member='NameOwnerChanged',"
+    "arg0='org.freedesktop.login1'";
 
+/**
+ * Filesystem path of the system bus socket: the @c unix:path= of
+ * @c $DBUS_SYSTEM_BUS_ADDRESS when set, else the well-known default.
+ * Empty for an address that names no path (abstract sockets, TCP).
+ */
+std::string systemBusSocketPath() {
+    constexpr std::string_view kPathPrefix = "unix:path=";
+    const char* address = std::getenv("DBUS_SYSTEM_BUS_ADDRESS");
+    if (!address || !*address) return "/run/dbus/system_bus_socket";
+    const std::string_view text(address);
+    if (text.substr(0, kPathPrefix.size()) != kPathPrefix) return {};
+    const std::string_view path = text.substr(kPathPrefix.size());
+    return std::string(path.substr(0, path.find(',')));
+}
 
 /**
  * Convert an absolute CLOCK_MONOTONIC µs timestamp (the shape
  * sd_bus_get_timeout returns) into a relative millisecond duration.
  * UINT64_MAX → -1 sentinel for "no deadline"; values already in the
- * past map to 0; oversized deltas are clamped to INT32_MAX to stay
- * well inside timerfd's itimerspec range.
+ * past map to 0, which fires on the next loop dispatch; oversized
+ * deltas are clamped to INT32_MAX.
  */
 std::chrono::milliseconds relativeFromAbsoluteUs(uint64_t absUs) {
     if (absUs == UINT64_MAX) {
@@ -80,11 +104,7 @@ bool DBusMonitor::initialize() {
         return false;
     }
 
-    r = sd_bus_add_match(m_bus, &m_signalSlot,
-        "type='signal',"
-        "interface='org.freedesktop.login1.Manager',"
-        "member='PrepareForSleep',"
-        "path='/org/freedesktop/login1'",
+    r = sd_bus_add_match(m_bus, &m_signalSlot, kSleepMatch,
         &DBusMonitor::onPrepareForSleep, this);
 
     if (r < 0) {
@@ -93,10 +113,14 @@ bool DBusMonitor::initialize() {
         m_bus = nullptr;
         return false;
     }
+    watchLogindOwner();
 
+    // Both requests wait in the outbox until attach() registers the
+    // bus fd; their replies are dispatched by the loop like any other.
     if (!takeInhibitLock()) {
         LOG_WARNING("Failed to take initial inhibitor lock");
     }
+    requestInhibitDelayMax();
 
     LOG_INFO("sd-bus D-Bus monitor initialized successfully");
     return true;
@@ -106,6 +130,10 @@ void DBusMonitor::setCallback(PowerStateCallback cb) {
     m_callback = std::move(cb);
 }
 
+void DBusMonitor::setReplyCallback(CallReplyCallback cb) {
+    m_replyCallback = std::move(cb);
+}
+
 bool DBusMonitor::attach(EventLoop& loop) {
     if (!m_bus) {
         LOG_ERROR("DBusMonitor::attach: not initialized");
@@ -115,8 +143,8 @@ bool DBusMonitor::attach(EventLoop& loop) {
         LOG_ERROR("DBusMonitor::attach: already attached");
         return false;
     }
-    if (!m_timer.valid() || !m_reconnectTimer.valid()) {
-        LOG_ERROR("DBusMonitor::attach: timer fd invalid");
+    if (!loop.timersValid()) {
+        LOG_ERROR("DBusMonitor::attach: event loop timers not initialised");
         return false;
     }
 
@@ -130,8 +158,6 @@ bool DBusMonitor::attach(EventLoop& loop) {
     m_registeredBusFd = busFd;
     m_registeredMask = pollToEventMask(sd_bus_get_events(m_bus));
 
-    const auto READ = static_cast<uint32_t>(EventPoller::Event::READ);
-
     if (!loop.add(busFd, m_registeredMask,
                   [this](uint32_t) { this->onBusReadable(); })) {
         m_loop = nullptr;
@@ -139,23 +165,10 @@ bool DBusMonitor::attach(EventLoop& loop) {
         m_registeredMask = 0;
         return false;
     }
-    if (!loop.add(m_timer.fd(), READ,
-                  [this](uint32_t) { this->onTimerFire(); })) {
-        loop.remove(busFd);
-        m_loop = nullptr;
-        m_registeredBusFd = -1;
-        m_registeredMask = 0;
-        return false;
-    }
-    if (!loop.add(m_reconnectTimer.fd(), READ,
-                  [this](uint32_t) { this->onReconnectTimer(); })) {
-        loop.remove(busFd);
-        loop.remove(m_timer.fd());
-        m_loop = nullptr;
-        m_registeredBusFd = -1;
-        m_registeredMask = 0;
-        return false;
-    }
+    m_timer.emplace(loop);
+    m_timer->setHandler([this] { this->onTimerFire(); });
+    m_reconnectTimer.emplace(loop);
+    m_reconnectTimer->setHandler([this] { this->onReconnectTimer(); });
 
     // Drain and arm the timer to reflect sd-bus's initial state.
     processBus();
@@ -169,12 +182,9 @@ void DBusMonitor::detach() {
         m_loop->remove(m_registeredBusFd);
         m_registeredBusFd = -1;
     }
-    if (m_timer.valid()) {
-        m_loop->remove(m_timer.fd());
-    }
-    if (m_reconnectTimer.valid()) {
-        m_loop->remove(m_reconnectTimer.fd());
-    }
+    m_timer.reset();
+    m_reconnectTimer.reset();
+    stopSocketWatch();
     m_loop = nullptr;
 }
 
@@ -190,8 +200,9 @@ void DBusMonitor::stop() {
     LOG_INFO("Stopping sd-bus D-Bus monitor");
 
     releaseInhibitLock();
-    m_timer.disarm();
-    m_reconnectTimer.disarm();
+    if (m_timer) m_timer->disarm();
+    if (m_reconnectTimer) m_reconnectTimer->disarm();
+    stopSocketWatch();
     tearDownBusState();
     m_state = BusState::Operational;
     m_reconnectSchedule.reset();
@@ -214,76 +225,77 @@ bool DBusMonitor::takeInhibitLock() {
         return true;
     }
 
-    // Runtime path (post-attach): asynchronous so the main loop never
-    // blocks on the bus. See the class-level doc for why a sync call
-    // here would strand any PrepareForSleep that arrives during the
-    // wait inside sd-bus's internal queue.
-    if (m_loop) {
-        LOG_INFO("Scheduling asynchronous Inhibit request");
-        const int r = sd_bus_call_method_async(m_bus, &m_inhibitSlot,
-            "org.freedesktop.login1",
-            "/org/freedesktop/login1",
-            "org.freedesktop.login1.Manager",
-            "Inhibit",
-            &DBusMonitor::onInhibitReply, this,
-            "ssss",
-            "sleep",
-            "cec-control",
-            "Preparing CEC adapter for sleep",
-            "delay");
-        if (r < 0) {
-            LOG_ERROR("Failed to schedule Inhibit method call: ", busErrorToString(r));
-            m_inhibitSlot = nullptr;
-            return false;
-        }
-        // The outbox now holds the request; update the loop so POLLOUT
-        // is armed on the bus fd and the next processBus() will flush.
-        updateLoopRegistration();
-        return true;
-    }
-
-    // Pre-attach path (initialize() only). A synchronous call is safe
-    // because the signal match was just installed and no PrepareForSleep
-    // could yet have been queued against it.
-    LOG_INFO("Taking systemd inhibitor lock (synchronous, pre-attach)");
-
-    sd_bus_message* rawReply = nullptr;
-    sd_bus_error error = SD_BUS_ERROR_NULL;
-    const int r = sd_bus_call_method(m_bus,
+    // Asynchronous so the main loop never blocks on the bus. See the
+    // class-level doc for why a sync call here would strand any
+    // PrepareForSleep that arrives during the wait inside sd-bus's
+    // internal queue.
+    LOG_INFO("Scheduling asynchronous Inhibit request");
+    const int r = sd_bus_call_method_async(m_bus, &m_inhibitSlot,
         "org.freedesktop.login1",
         "/org/freedesktop/login1",
         "org.freedesktop.login1.Manager",
         "Inhibit",
-        &error,
-        &rawReply,
+        &DBusMonitor::onInhibitReply, this,
         "ssss",
         "sleep",
         "cec-control",
         "Preparing CEC adapter for sleep",
         "delay");
     if (r < 0) {
-        LOG_ERROR("Failed to call Inhibit method: ",
-                  error.message ? error.message : busErrorToString(r));
-        sd_bus_error_free(&error);
+        LOG_ERROR("Failed to schedule Inhibit method call: ", busErrorToString(r));
+        m_inhibitSlot = nullptr;
         return false;
     }
-    BusMessagePtr reply(rawReply);
+    // The outbox now holds the request; update the loop so POLLOUT
+    // is armed on the bus fd and the next processBus() will flush.
+    // Before attach() this is a no-op and attach() picks up the mask.
+    updateLoopRegistration();
+    return true;
+}
 
-    int tempFd = -1;
-    const int readR = sd_bus_message_read(reply.get(), "h", &tempFd);
-    if (readR < 0) {
-        LOG_ERROR("Failed to read inhibitor file descriptor: ", busErrorToString(readR));
-        return false;
+void DBusMonitor::requestInhibitDelayMax() {
+    // The value only changes when logind's configuration is reloaded,
+    // so one read per connection is enough for a best-effort budget.
+    if (m_delayMaxSlot) return;
+    const int r = sd_bus_call_method_async(m_bus, &m_delayMaxSlot,
+        "org.freedesktop.login1",
+        "/org/freedesktop/login1",
+        "org.freedesktop.DBus.Properties",
+        "Get",
+        &DBusMonitor::onInhibitDelayMaxReply, this,
+        "ss",
+        "org.freedesktop.login1.Manager",
+        "InhibitDelayMaxUSec");
+    if (r < 0) {
+        LOG_WARNING("Failed to schedule InhibitDelayMaxUSec read: ", busErrorToString(r));
+        m_delayMaxSlot = nullptr;
+        return;
     }
+    updateLoopRegistration();
+}
 
-    m_inhibitFd = ::dup(tempFd);
-    if (m_inhibitFd < 0) {
-        LOG_ERROR("Failed to duplicate inhibitor file descriptor: ", std::strerror(errno));
-        return false;
+int DBusMonitor::onInhibitDelayMaxReply(sd_bus_message* msg, void* userdata,
+                                        sd_bus_error* /*ret_error*/) {
+    auto* monitor = static_cast<DBusMonitor*>(userdata);
+    if (!monitor) return 0;
+    monitor->m_delayMaxSlot = nullptr;
+
+    if (sd_bus_message_is_method_error(msg, nullptr)) {
+        const sd_bus_error* e = sd_bus_message_get_error(msg);
+        LOG_WARNING("Failed to read InhibitDelayMaxUSec: ",
+                    (e && e->message) ? e->message : "unknown");
+        return 0;
     }
 
-    LOG_INFO("Successfully took inhibitor lock (fd=", m_inhibitFd, ")");
-    return true;
+    uint64_t usec = 0;
+    const int r = sd_bus_message_read(msg, "v", "t", &usec);
+    if (r < 0) {
+        LOG_WARNING("Failed to parse InhibitDelayMaxUSec: ", busErrorToString(r));
+        return 0;
+    }
+    monitor->m_inhibitDelayMax = std::chrono::microseconds(usec);
+    LOG_INFO("logind inhibitor delay limit: ", usec / 1000, "ms");
+    return 0;
 }
 
 int DBusMonitor::onInhibitReply(sd_bus_message* msg, void* userdata,
@@ -300,6 +312,7 @@ int DBusMonitor::onInhibitReply(sd_bus_message* msg, void* userdata,
         const sd_bus_error* e = sd_bus_message_get_error(msg);
         LOG_WARNING("Inhibit reply returned error: ",
                     (e && e->message) ? e->message : "unknown");
+        monitor->notifyReply(Call::Inhibit, false);
         return 0;
     }
 
@@ -308,6 +321,7 @@ int DBusMonitor::onInhibitReply(sd_bus_message* msg, void* userdata,
     if (r < 0) {
         LOG_ERROR("Failed to read inhibitor fd from async reply: ",
                   busErrorToString(r));
+        monitor->notifyReply(Call::Inhibit, false);
         return 0;
     }
 
@@ -324,13 +338,19 @@ int DBusMonitor::onInhibitReply(sd_bus_message* msg, void* userdata,
     if (monitor->m_inhibitFd < 0) {
         LOG_ERROR("Failed to duplicate inhibitor file descriptor: ",
                   std::strerror(errno));
+        monitor->notifyReply(Call::Inhibit, false);
         return 0;
     }
 
     LOG_INFO("Successfully took inhibitor lock (fd=", monitor->m_inhibitFd, ")");
+    monitor->notifyReply(Call::Inhibit, true);
     return 0;
 }
 
+void DBusMonitor::notifyReply(Call call, bool ok) {
+    if (m_replyCallback) m_replyCallback(call, ok);
+}
+
 bool DBusMonitor::releaseInhibitLock() noexcept {
     if (m_inhibitFd < 0) {
         LOG_DEBUG("No inhibitor lock to release");
@@ -348,13 +368,18 @@ bool DBusMonitor::suspendSystem() {
         return false;
     }
 
+    if (m_suspendSlot) {
+        LOG_DEBUG("Suspend request already in flight; not re-sending");
+        return true;
+    }
+
     LOG_INFO("Initiating system suspend via D-Bus");
 
-    // Floating slot (nullptr): sd-bus manages the lifetime and frees
-    // it after onSuspendReply fires. The reply carries no payload we
-    // need; it exists so authorization/bus errors are logged instead
-    // of silently dropped.
-    const int r = sd_bus_call_method_async(m_bus, nullptr,
+    // Tracked slot, like m_inhibitSlot, so teardown cancels the call
+    // instead of leaving a reply aimed at a dead monitor. The reply
+    // carries no payload we need; it exists so authorization/bus
+    // errors reach the log and the owner instead of being dropped.
+    const int r = sd_bus_call_method_async(m_bus, &m_suspendSlot,
         "org.freedesktop.login1",
         "/org/freedesktop/login1",
         "org.freedesktop.login1.Manager",
@@ -364,6 +389,7 @@ bool DBusMonitor::suspendSystem() {
         1);  // interactive=true
     if (r < 0) {
         LOG_ERROR("Failed to schedule Suspend method call: ", busErrorToString(r));
+        m_suspendSlot = nullptr;
         return false;
     }
 
@@ -373,15 +399,35 @@ bool DBusMonitor::suspendSystem() {
     return true;
 }
 
-int DBusMonitor::onSuspendReply(sd_bus_message* msg, void* /*userdata*/,
+int DBusMonitor::onSuspendReply(sd_bus_message* msg, void* userdata,
                                 sd_bus_error* /*ret_error*/) {
-    if (sd_bus_message_is_method_error(msg, nullptr)) {
+    auto* monitor = static_cast<DBusMonitor*>(userdata);
+    if (!monitor) return 0;
+    monitor->m_suspendSlot = nullptr;
+
+    const bool ok = !sd_bus_message_is_method_error(msg, nullptr);
+    if (!ok) {
         const sd_bus_error* e = sd_bus_message_get_error(msg);
         LOG_WARNING("Suspend reply returned error: ",
                     (e && e->message) ? e->message : "unknown");
     } else {
         LOG_DEBUG("Suspend method call acknowledged by logind");
     }
+    monitor->notifyReply(Call::Suspend, ok);
+    return 0;
+}
+
+int DBusMonitor::onMatchInstalled(sd_bus_message* msg, void* userdata,
+                                  sd_bus_error* /*ret_error*/) {
+    auto* monitor = static_cast<DBusMonitor*>(userdata);
+    if (!monitor || !sd_bus_message_is_method_error(msg, nullptr)) return 0;
+
+    const sd_bus_error* e = sd_bus_message_get_error(msg);
+    LOG_WARNING("PrepareForSleep match rejected after reconnect: ",
+                (e && e->message) ? e->message : "unknown");
+    // Tearing the bus down from inside its own dispatch is not safe;
+    // processBus() acts on the flag once sd_bus_process returns.
+    monitor->m_matchFailed = true;
     return 0;
 }
 
@@ -390,6 +436,13 @@ void DBusMonitor::processBus() {
 
     while (true) {
         int r = sd_bus_process(m_bus, nullptr);
+        if (m_matchFailed) {
+            // Without the match no PrepareForSleep arrives; go round
+            // the reconnect schedule again rather than run deaf.
+            m_matchFailed = false;
+            handleBusDisconnect();
+            return;
+        }
         if (r < 0) {
             LOG_ERROR("sd_bus_process failed: ", busErrorToString(r));
             // Disambiguate transient vs fatal: sd_bus_is_open returns
@@ -441,15 +494,15 @@ void DBusMonitor::updateLoopRegistration() {
     const int r = sd_bus_get_timeout(m_bus, &absUs);
     if (r < 0) {
         LOG_WARNING("sd_bus_get_timeout failed: ", busErrorToString(r));
-        m_timer.disarm();
+        m_timer->disarm();
         return;
     }
 
     const auto relMs = relativeFromAbsoluteUs(absUs);
     if (relMs.count() < 0) {
-        m_timer.disarm();
-    } else if (!m_timer.armOnce(relMs)) {
-        // A timerfd failure here means the next purely-timeout-driven
+        m_timer->disarm();
+    } else if (!m_timer->armOnce(relMs)) {
+        // An arm failure here means the next purely-timeout-driven
         // bus wake-up will not fire; incoming I/O still kicks
         // processBus() via onBusReadable(). Log and carry on.
         LOG_WARNING("sd-bus timeout timer arm failed; relying on bus I/O to drive next process pass");
@@ -462,13 +515,13 @@ void DBusMonitor::onBusReadable() {
 }
 
 void DBusMonitor::onTimerFire() {
-    m_timer.consume();
+    m_timer->consume();
     processBus();
     updateLoopRegistration();
 }
 
 void DBusMonitor::onReconnectTimer() {
-    m_reconnectTimer.consume();
+    m_reconnectTimer->consume();
 
     if (m_state == BusState::Reconnecting) {
         // m_currentAttemptNumber was captured from the Attempt returned
@@ -490,8 +543,8 @@ void DBusMonitor::onReconnectTimer() {
                         " scheduled attempts; entering heartbeat mode "
                         "(retrying every ",
                         std::chrono::duration_cast<std::chrono::minutes>(
-                            kHeartbeatInterval).count(),
-                        " minutes)");
+                            heartbeatInterval()).count(),
+                        " minutes, or as soon as the bus socket reappears)");
             m_state = BusState::Disabled;
             armHeartbeat();
             return;
@@ -499,10 +552,10 @@ void DBusMonitor::onReconnectTimer() {
 
         LOG_WARNING("D-Bus reconnect attempt failed; next try in ",
                     attempt->delay.count(), "ms");
-        if (!m_reconnectTimer.armOnce(attempt->delay)) {
-            // A timerfd arm failure mid-schedule implies the fd is in
-            // a broken state; we cannot recover. No heartbeat either
-            // — both would use the same fd.
+        if (!m_reconnectTimer->armOnce(attempt->delay)) {
+            // An arm failure mid-schedule means the loop's timer wheel
+            // is unusable; we cannot recover. No heartbeat either
+            // — both would use the same timer.
             LOG_ERROR("Failed to arm reconnect timer; "
                       "power monitoring disabled for this session");
             m_state = BusState::Disabled;
@@ -531,6 +584,7 @@ void DBusMonitor::onReconnectTimer() {
 
 bool DBusMonitor::attemptReconnect() {
     if (reconnectBus() && registerBusWithLoop()) {
+        stopSocketWatch();
         m_state = BusState::Operational;
         m_reconnectSchedule.reset();
         m_currentAttemptNumber = 0;
@@ -548,9 +602,13 @@ bool DBusMonitor::attemptReconnect() {
     return false;
 }
 
+std::chrono::minutes DBusMonitor::heartbeatInterval() const noexcept {
+    return m_socketWatchFd >= 0 ? kWatchedHeartbeatInterval : kHeartbeatInterval;
+}
+
 void DBusMonitor::armHeartbeat() {
-    if (!m_reconnectTimer.armOnce(kHeartbeatInterval)) {
-        // Same pathology as a mid-schedule armOnce failure: timerfd is
+    if (!m_reconnectTimer->armOnce(heartbeatInterval())) {
+        // Same pathology as a mid-schedule armOnce failure: the timer is
         // broken, no further retries are possible this session.
         LOG_ERROR("Failed to arm D-Bus heartbeat timer; "
                   "power monitoring disabled for this session");
@@ -574,7 +632,7 @@ void DBusMonitor::handleBusDisconnect() {
         m_registeredBusFd = -1;
     }
     m_registeredMask = 0;
-    m_timer.disarm();
+    if (m_timer) m_timer->disarm();
 
     tearDownBusState();
 
@@ -582,7 +640,8 @@ void DBusMonitor::handleBusDisconnect() {
     m_reconnectSchedule.reset();
     m_currentAttemptNumber = 0;
     const auto attempt = m_reconnectSchedule.nextDelay();
-    if (!attempt || !m_reconnectTimer.armOnce(attempt->delay)) {
+    startSocketWatch();
+    if (!attempt || !m_reconnectTimer || !m_reconnectTimer->armOnce(attempt->delay)) {
         LOG_ERROR("Failed to arm reconnect timer; "
                   "power monitoring disabled for this session");
         m_state = BusState::Disabled;
@@ -591,26 +650,151 @@ void DBusMonitor::handleBusDisconnect() {
     m_currentAttemptNumber = attempt->index;
 }
 
+void DBusMonitor::startSocketWatch() {
+    if (m_socketWatchFd >= 0 || !m_loop) return;
+    const std::string path = systemBusSocketPath();
+    const auto slash = path.rfind('/');
+    if (path.empty() || slash == std::string::npos) {
+        LOG_DEBUG("System bus address has no socket file to watch; "
+                  "reconnects follow the retry schedule only");
+        return;
+    }
+    const std::string dir = slash == 0 ? "/" : path.substr(0, slash);
+
+    const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        LOG_WARNING("Cannot watch the system bus socket: ", std::strerror(errno));
+        return;
+    }
+    // IN_ATTRIB as well as the creation events: dbus-daemon chmods
+    // the socket once it is listening.
+    if (::inotify_add_watch(fd, dir.c_str(), IN_CREATE | IN_MOVED_TO | IN_ATTRIB) < 0) {
+        LOG_WARNING("Cannot watch ", dir, " for the system bus socket: ",
+                    std::strerror(errno));
+        ::close(fd);
+        return;
+    }
+    if (!m_loop->add(fd, static_cast<uint32_t>(EventPoller::Event::READ),
+                     [this](uint32_t) { this->onSocketWatchReadable(); })) {
+        ::close(fd);
+        return;
+    }
+    m_socketWatchFd = fd;
+    m_socketName    = path.substr(slash + 1);
+    LOG_DEBUG("Watching ", path, " for the system bus to return");
+}
+
+void DBusMonitor::stopSocketWatch() noexcept {
+    if (m_socketWatchFd < 0) return;
+    if (m_loop) m_loop->remove(m_socketWatchFd);
+    ::close(m_socketWatchFd);
+    m_socketWatchFd = -1;
+}
+
+void DBusMonitor::onSocketWatchReadable() {
+    alignas(inotify_event) char buffer[4096];
+    bool appeared = false;
+    while (true) {
+        const ssize_t n = ::read(m_socketWatchFd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        for (ssize_t offset = 0; offset < n;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && m_socketName == event->name) appeared = true;
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+    if (!appeared || m_state == BusState::Operational) return;
+
+    LOG_INFO("System bus socket is back; reconnecting to D-Bus");
+    if (attemptReconnect()) {
+        m_reconnectTimer->disarm();
+        LOG_INFO("D-Bus reconnected; power monitoring resumed");
+        return;
+    }
+    // The socket file exists a moment before its daemon listens on
+    // it, so the first try can be refused. Retry shortly rather than
+    // wait for the schedule or the heartbeat; that retry counts as a
+    // normal timer firing, failure handling included.
+    if (!m_reconnectTimer->armOnce(kSocketSettleDelay)) {
+        LOG_WARNING("Failed to arm D-Bus reconnect timer after the bus socket returned");
+    }
+}
+
+void DBusMonitor::watchLogindOwner() {
+    const int r = sd_bus_add_match_async(m_bus, &m_ownerSlot, kLogindOwnerMatch,
+        &DBusMonitor::onLogindOwnerChanged, &DBusMonitor::onOwnerMatchInstalled, this);
+    if (r < 0) {
+        // Only the restart detection is lost; PrepareForSleep still
+        // arrives, since its match does not name logind's connection.
+        LOG_WARNING("Cannot watch logind restarts: ", busErrorToString(r));
+        m_ownerSlot = nullptr;
+    }
+}
+
+int DBusMonitor::onOwnerMatchInstalled(sd_bus_message* msg, void* /*userdata*/,
+                                       sd_bus_error* /*ret_error*/) {
+    if (sd_bus_message_is_method_error(msg, nullptr)) {
+        const sd_bus_error* e = sd_bus_message_get_error(msg);
+        LOG_WARNING("logind restart match rejected: ",
+                    (e && e->message) ? e->message : "unknown");
+    }
+    return 0;
+}
+
+int DBusMonitor::onLogindOwnerChanged(sd_bus_message* msg, void* userdata,
+                                      sd_bus_error* /*ret_error*/) {
+    auto* monitor = static_cast<DBusMonitor*>(userdata);
+    if (!monitor) return 0;
+
+    const char* name = nullptr;
+    const char* oldOwner = nullptr;
+    const char* newOwner = nullptr;
+    const int r = sd_bus_message_read(msg, "sss", &name, &oldOwner, &newOwner);
+    if (r < 0) {
+        LOG_WARNING("Failed to read NameOwnerChanged: ", busErrorToString(r));
+        return 0;
+    }
+
+    // A delay lock lives in logind's memory, so whichever way the name
+    // moved, the fd we hold no longer holds anything back.
+    monitor->releaseInhibitLock();
+    if (!newOwner || !*newOwner) {
+        LOG_WARNING("logind left the bus; suspend handling waits for it to return");
+        return 0;
+    }
+    LOG_INFO("logind ", (oldOwner && *oldOwner) ? "restarted" : "is on the bus",
+             "; retaking the inhibitor lock");
+    monitor->takeInhibitLock();
+    monitor->requestInhibitDelayMax();
+    return 0;
+}
+
 bool DBusMonitor::reconnectBus() {
-    int r = sd_bus_default_system(&m_bus);
+    // A connection of our own rather than the thread's default bus:
+    // sd-bus hands the cached default back for as long as anything
+    // still references it, and after a disconnect that is the dead
+    // connection, on which every call fails with ENOTCONN.
+    int r = sd_bus_open_system(&m_bus);
     if (r < 0) {
-        LOG_WARNING("sd_bus_default_system failed during reconnect: ",
+        LOG_WARNING("sd_bus_open_system failed during reconnect: ",
                     busErrorToString(r));
         m_bus = nullptr;
         return false;
     }
 
-    r = sd_bus_add_match(m_bus, &m_signalSlot,
-        "type='signal',"
-        "interface='org.freedesktop.login1.Manager',"
-        "member='PrepareForSleep',"
-        "path='/org/freedesktop/login1'",
-        &DBusMonitor::onPrepareForSleep, this);
+    // Unlike initialize(), this runs on the loop, so the AddMatch
+    // round trip to the bus daemon is asynchronous too: the signal
+    // handler is live at once, and onMatchInstalled only has to
+    // report a rejection.
+    m_matchFailed = false;
+    r = sd_bus_add_match_async(m_bus, &m_signalSlot, kSleepMatch,
+        &DBusMonitor::onPrepareForSleep, &DBusMonitor::onMatchInstalled, this);
     if (r < 0) {
-        LOG_WARNING("sd_bus_add_match failed during reconnect: ",
+        LOG_WARNING("sd_bus_add_match_async failed during reconnect: ",
                     busErrorToString(r));
         return false;
     }
+    watchLogindOwner();
 
     // The inhibit lock is best-effort on reconnect: PrepareForSleep
     // delivery is what the daemon actually depends on, and it works
@@ -619,6 +803,8 @@ bool DBusMonitor::reconnectBus() {
         LOG_WARNING("Reconnected to D-Bus but could not reacquire inhibit lock; "
                     "PrepareForSleep handling continues without delay guard");
     }
+    // A logind restart may come with a changed InhibitDelayMaxSec.
+    requestInhibitDelayMax();
     return true;
 }
 
@@ -645,18 +831,24 @@ bool DBusMonitor::registerBusWithLoop() {
 }
 
 void DBusMonitor::tearDownBusState() noexcept {
-    // Cancel any in-flight Inhibit request before dropping the bus so
-    // the reply callback can't fire against a dead connection. sd-bus
+    // Cancel every in-flight call before dropping the bus so no reply
+    // callback can fire against a dead connection. sd-bus
     // does not invoke callbacks on slot unref; the call is simply
     // cancelled.
-    if (m_inhibitSlot) {
-        sd_bus_slot_unref(m_inhibitSlot);
-        m_inhibitSlot = nullptr;
+    for (sd_bus_slot** slot : {&m_inhibitSlot, &m_suspendSlot, &m_delayMaxSlot}) {
+        if (*slot) {
+            sd_bus_slot_unref(*slot);
+            *slot = nullptr;
+        }
     }
     if (m_signalSlot) {
         sd_bus_slot_unref(m_signalSlot);
         m_signalSlot = nullptr;
     }
+    if (m_ownerSlot) {
+        sd_bus_slot_unref(m_ownerSlot);
+        m_ownerSlot = nullptr;
+    }
     if (m_bus) {
         sd_bus_unref(m_bus);
         m_bus = nullptr;
@@ -2,11 +2,13 @@
 
 #include <chrono>
 #include <functional>
+#include <optional>
+#include <string>
 #include <systemd/sd-bus.h>
 
 #include "../common/backoff_schedule.h"
 #include "../common/event_loop.h"
-#include "../common/timer_source.h"
+#include "../common/loop_timer.h"
 
 namespace cec_control {
 
@@ -14,9 +16,9 @@ namespace cec_control {
  * Monitors logind PrepareForSleep signals over sd-bus.
  *
  * Integrates with the unified EventLoop: attach() registers the bus fd
- * and a local timerfd (for sd_bus_get_timeout()) with the loop; every
- * loop callback processes pending bus activity and refreshes the fd
- * mask plus the timer. No dedicated thread, no shutdown pipe.
+ * with the loop and puts a timer (for sd_bus_get_timeout()) on its
+ * timer wheel; every loop callback processes pending bus activity and
+ * refreshes the fd mask plus the timer. No dedicated thread, no shutdown pipe.
  *
  * On a runtime bus failure (logind or dbus-daemon restart, explicit
  * hang-up) the monitor transitions into a Reconnecting state: loop
@@ -29,6 +31,15 @@ namespace cec_control {
  * outages longer than the scheduled retry window without requiring
  * operator intervention.
  *
+ * Recovery does not wait for those timers when it can help it. While
+ * the bus is down, an inotify watch on the directory of the system
+ * bus socket reconnects the moment dbus-daemon creates it again; the
+ * heartbeat then only backs up a missed event, at the slower
+ * kWatchedHeartbeatInterval. On a live bus, a NameOwnerChanged match
+ * on org.freedesktop.login1 sees logind restart — which forgets
+ * every inhibitor — and retakes the delay lock at once instead of
+ * leaving the next suspend unguarded.
+ *
  * ---------------------------------------------------------------
  * sd-bus integration invariant — never sd_bus_call* on the loop.
  * ---------------------------------------------------------------
@@ -46,18 +57,27 @@ namespace cec_control {
  * That's exactly the regression that keeps coming back every time
  * someone reaches for sd_bus_call_method because it's convenient.
  *
- * Async paths in this class:
- *   - suspendSystem(): sd_bus_call_method_async with a floating slot.
- *     The reply carries no payload we care about, but routing it
- *     through onSuspendReply surfaces any authorization/bus errors.
- *   - takeInhibitLock() at runtime: sd_bus_call_method_async with
- *     m_inhibitSlot tracked so we can cancel on shutdown; the reply
- *     (onInhibitReply) dups the inhibitor fd into m_inhibitFd.
+ * Async paths in this class, each with a tracked slot so teardown
+ * cancels the call rather than leave a reply aimed at a dead bus:
+ *   - suspendSystem(): m_suspendSlot. The reply carries no payload
+ *     we care about, but routing it through onSuspendReply surfaces
+ *     any authorization/bus errors.
+ *   - takeInhibitLock(): m_inhibitSlot; the reply (onInhibitReply)
+ *     dups the inhibitor fd into m_inhibitFd.
+ *   - InhibitDelayMaxUSec: m_delayMaxSlot, re-read on every connect.
+ *   - The PrepareForSleep match after a reconnect:
+ *     sd_bus_add_match_async, with onMatchInstalled reporting a
+ *     rejection.
+ * Calls made from initialize() sit in the outbox until attach()
+ * registers the bus fd; their replies are dispatched like any other.
+ * The Inhibit and Suspend replies are also handed to the callback
+ * installed with setReplyCallback, so the power supervisor learns the
+ * outcome without polling.
  *
- * The single exception is the initial inhibit-lock acquisition inside
- * initialize(): it runs before attach(), so there is no event loop to
- * carry the reply. A synchronous call is safe there because no signals
- * could yet be queued against the newly-installed match.
+ * The single exception is the AddMatch inside initialize(): it runs
+ * before the loop does, and its failure has to be known there, since
+ * it decides whether power monitoring is usable at all. No signal can
+ * be stranded by it, because no match is installed yet.
  *
  * Single-threaded ownership: every sd-bus operation runs on the thread
  * that calls run() on the EventLoop. Other threads that need to emit
@@ -73,6 +93,20 @@ public:
 
     using PowerStateCallback = std::function<void(PowerState)>;
 
+    /** A logind call whose outcome is reported through @c CallReplyCallback. */
+    enum class Call {
+        Inhibit,  ///< @c ok: the delay inhibitor is now held.
+        Suspend,  ///< @c ok: logind accepted the request.
+    };
+
+    /**
+     * Invoked from inside the bus dispatch when a reply arrives, like
+     * @c PowerStateCallback; the owner should hop off the dispatch
+     * stack before acting on it. A call cancelled by teardown reports
+     * nothing.
+     */
+    using CallReplyCallback = std::function<void(Call, bool ok)>;
+
     DBusMonitor();
     ~DBusMonitor();
 
@@ -89,6 +123,9 @@ public:
     /** Replace the callback invoked on Suspending / Resuming transitions. */
     void setCallback(PowerStateCallback cb);
 
+    /** Replace the callback invoked when an Inhibit or Suspend reply arrives. */
+    void setReplyCallback(CallReplyCallback cb);
+
     /**
      * Register the bus fd and internal timer with @p loop. The loop
      * must outlive this object (or be detach()ed first). Fails if
@@ -109,13 +146,12 @@ public:
      * (Re)take a delay inhibitor from logind. Must run on the main
      * thread (sd-bus calls are not thread-safe with us).
      *
-     * Before attach() — the one-shot path used only from initialize() —
-     * the request is issued synchronously and the fd is stored before
-     * return. At runtime (post-attach) the request is scheduled via
-     * sd_bus_call_method_async and the reply dups the fd into
-     * m_inhibitFd asynchronously; the return value indicates only that
-     * the call was queued. Harmless if we already hold a lock or a
-     * prior request is still pending.
+     * The request is scheduled via sd_bus_call_method_async and the
+     * reply dups the fd into m_inhibitFd; the return value indicates
+     * only that the call was queued, and the outcome reaches the
+     * @c CallReplyCallback as @c Call::Inhibit. Called before attach()
+     * the request waits in the outbox until the loop runs. Harmless if
+     * we already hold a lock or a prior request is still pending.
      */
     bool takeInhibitLock();
 
@@ -129,11 +165,21 @@ public:
      * Ask logind to suspend the system. Must run on the main thread.
      * Fires sd_bus_call_method_async and returns immediately; the
      * PrepareForSleep signals arrive later through the normal
-     * processBus() dispatch path. Returns true if the call was queued
-     * successfully.
+     * processBus() dispatch path, and the reply reaches the
+     * @c CallReplyCallback as @c Call::Suspend. Returns true if the
+     * call was queued successfully or one is already in flight.
      */
     bool suspendSystem();
 
+    /**
+     * logind's @c InhibitDelayMaxUSec — how long a delay inhibitor may
+     * hold off sleep — as last read on connecting. Empty until the
+     * first reply arrives, or if it could not be read.
+     */
+    [[nodiscard]] std::optional<std::chrono::microseconds> inhibitDelayMax() const noexcept {
+        return m_inhibitDelayMax;
+    }
+
 private:
     /**
      * Lifecycle of the sd-bus connection from this monitor's point of
@@ -199,9 +245,42 @@ private:
      */
     void armHeartbeat();
 
-    /** Unref the signal slot and bus; clear both pointers. */
+    /** Unref the signal slots, in-flight calls and bus; clear the pointers. */
     void tearDownBusState() noexcept;
 
+    /** Heartbeat period: longer while the socket watch stands in for it. */
+    [[nodiscard]] std::chrono::minutes heartbeatInterval() const noexcept;
+
+    /**
+     * Watch the system bus socket's directory so the bus returning
+     * triggers a reconnect. Best effort: without the watch (no path in
+     * the bus address, inotify unavailable) the timers still retry.
+     */
+    void startSocketWatch();
+
+    /** Drop the socket watch. Idempotent. */
+    void stopSocketWatch() noexcept;
+
+    /** Loop handler of the socket watch. */
+    void onSocketWatchReadable();
+
+    /** Subscribe to logind's NameOwnerChanged. Failure is logged, not fatal. */
+    void watchLogindOwner();
+
+    /** logind appeared, restarted or left; retake or drop the inhibit lock. */
+    static int onLogindOwnerChanged(
+        sd_bus_message* msg,
+        void* userdata,
+        sd_bus_error* ret_error
+    );
+
+    /** Install-callback of the NameOwnerChanged match; logs a rejection. */
+    static int onOwnerMatchInstalled(
+        sd_bus_message* msg,
+        void* userdata,
+        sd_bus_error* ret_error
+    );
+
     /** Static signal handler registered with sd-bus; forwards to m_callback. */
     static int onPrepareForSleep(
         sd_bus_message* msg,
@@ -231,21 +310,53 @@ private:
         sd_bus_error* ret_error
     );
 
+    /**
+     * Install-callback of the reconnect-time AddMatch. Flags a
+     * rejection for processBus(), which treats it as a disconnect.
+     */
+    static int onMatchInstalled(
+        sd_bus_message* msg,
+        void* userdata,
+        sd_bus_error* ret_error
+    );
+
+    /** Reply handler for the @c InhibitDelayMaxUSec property read. */
+    static int onInhibitDelayMaxReply(
+        sd_bus_message* msg,
+        void* userdata,
+        sd_bus_error* ret_error
+    );
+
+    /** Schedule an asynchronous read of @c InhibitDelayMaxUSec into @c m_inhibitDelayMax. */
+    void requestInhibitDelayMax();
+
+    /** Forward a reply outcome to @c m_replyCallback, if set. */
+    void notifyReply(Call call, bool ok);
+
     /** Short textual conversion for negative sd-bus return values. */
     static const char* busErrorToString(int error) noexcept;
 
     sd_bus* m_bus = nullptr;
     sd_bus_slot* m_signalSlot = nullptr;
+    sd_bus_slot* m_ownerSlot = nullptr;    // logind NameOwnerChanged match.
     sd_bus_slot* m_inhibitSlot = nullptr;  // In-flight async Inhibit request.
+    sd_bus_slot* m_suspendSlot = nullptr;  // In-flight async Suspend request.
+    sd_bus_slot* m_delayMaxSlot = nullptr; // In-flight InhibitDelayMaxUSec read.
+    bool m_matchFailed = false;            // Set by onMatchInstalled on a rejection.
     int m_inhibitFd = -1;
+    std::optional<std::chrono::microseconds> m_inhibitDelayMax;
 
     EventLoop* m_loop = nullptr;
     int m_registeredBusFd = -1;     // The fd we have currently added to m_loop.
     uint32_t m_registeredMask = 0;  // Last mask passed to loop->modify.
-    TimerSource m_timer;            // Carries sd-bus's internal deadline.
-    TimerSource m_reconnectTimer;   // Drives the disconnect-backoff schedule.
+    // On m_loop's timer wheel, so they exist only while attached.
+    std::optional<LoopTimer> m_timer;           // Carries sd-bus's internal deadline.
+    std::optional<LoopTimer> m_reconnectTimer;  // Drives the disconnect-backoff schedule.
+    int m_socketWatchFd = -1;       // inotify on the bus socket's directory while down.
+    std::string m_socketName;       // Socket file name the watch waits for.
 
     PowerStateCallback m_callback;
+    CallReplyCallback  m_replyCallback;
 
     BusState m_state = BusState::Operational;
     // Delays between reconnect attempts after a bus disconnect. Tuned so
@@ -267,6 +378,15 @@ private:
     // Silent at default log levels; an INFO line fires on recovery.
     static constexpr auto kHeartbeatInterval = std::chrono::minutes(30);
 
+    // Heartbeat cadence while the socket watch is active. The watch
+    // catches the bus coming back; this only covers a daemon that
+    // reused an existing socket file without touching it.
+    static constexpr auto kWatchedHeartbeatInterval = std::chrono::minutes(240);
+
+    // Retry delay after the socket reappeared but the connect failed,
+    // which happens while dbus-daemon is between bind and listen.
+    static constexpr auto kSocketSettleDelay = std::chrono::milliseconds(500);
+
     // 1-based position of the pending reconnect attempt. Captured on
     // the BackoffSchedule::Attempt returned from nextDelay() when the
     // reconnect timer is armed, used by onReconnectTimer() at fire
@@ -0,0 +1,140 @@
+#include "device_profiles.h"
+
+#include "../common/logger.h"
+#include "../common/system_paths.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace cec_control {
+
+namespace {
+
+constexpr const char* kHeader =
+    "# cec-control device profiles: vendor physical interval_ms ack_us stream_path";
+
+const char* streamPathName(StreamPathSupport support) {
+    switch (support) {
+        case StreamPathSupport::Works:   return "works";
+        case StreamPathSupport::Refused: return "refused";
+        case StreamPathSupport::Unknown: break;
+    }
+    return "unknown";
+}
+
+StreamPathSupport parseStreamPath(const std::string& text) {
+    if (text == "works")   return StreamPathSupport::Works;
+    if (text == "refused") return StreamPathSupport::Refused;
+    return StreamPathSupport::Unknown;
+}
+
+/** One profile line, or @c std::nullopt if it is malformed. */
+std::optional<std::pair<DeviceIdentity, LaneProfile>> parseLine(const std::string& line) {
+    std::istringstream in(line);
+    std::string vendor, physical, streamPath;
+    LaneProfile profile;
+    if (!(in >> vendor >> physical >> profile.intervalMs >> profile.ackUs >> streamPath)) {
+        return std::nullopt;
+    }
+    unsigned vendorId = 0, physicalAddress = 0;
+    char extra = 0;
+    if (std::sscanf(vendor.c_str(), "%6x%c", &vendorId, &extra) != 1 ||
+        std::sscanf(physical.c_str(), "%4x%c", &physicalAddress, &extra) != 1) {
+        return std::nullopt;
+    }
+    profile.streamPath = parseStreamPath(streamPath);
+    return std::make_pair(
+        DeviceIdentity{vendorId, static_cast<uint16_t>(physicalAddress)}, profile);
+}
+
+} // namespace
+
+DeviceProfileStore::DeviceProfileStore(std::string path) : m_path(std::move(path)) {}
+
+void DeviceProfileStore::load() {
+    m_profiles.clear();
+    std::ifstream in(m_path);
+    if (!in) return;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line.front() == '#') continue;
+        const auto entry = parseLine(line);
+        if (!entry) {
+            LOG_WARNING("Ignoring malformed device profile line: ", line);
+            continue;
+        }
+        if (m_profiles.size() >= kMaxProfiles) break;
+        m_profiles[entry->first] = entry->second;
+    }
+    LOG_INFO("Loaded ", m_profiles.size(), " device profile(s) from ", m_path);
+}
+
+bool DeviceProfileStore::save() const {
+    if (m_profiles.empty()) return true;
+    if (!SystemPaths::ensureParentDirExists(m_path)) {
+        LOG_WARNING("Cannot create the directory for device profiles ", m_path);
+        return false;
+    }
+    const std::string tmp = m_path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << kHeader << '\n';
+        char ids[16];
+        for (const auto& [identity, profile] : m_profiles) {
+            std::snprintf(ids, sizeof(ids), "%06x %04x",
+                          static_cast<unsigned>(identity.vendorId),
+                          static_cast<unsigned>(identity.physicalAddress));
+            out << ids << ' ' << profile.intervalMs << ' ' << profile.ackUs << ' '
+                << streamPathName(profile.streamPath) << '\n';
+        }
+        if (!out.flush()) {
+            LOG_WARNING("Cannot write device profiles ", tmp);
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), m_path.c_str()) != 0) {
+        LOG_WARNING("Cannot replace device profiles ", m_path, ": ", std::strerror(errno));
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool DeviceProfileStore::attach(uint8_t logicalAddress, const DeviceIdentity& identity,
+                                CommandThrottler& throttler) {
+    m_attached[logicalAddress % CommandThrottler::kLaneCount] = identity;
+    const auto it = m_profiles.find(identity);
+    if (it == m_profiles.end()) return false;
+    throttler.seedLane(logicalAddress, it->second);
+    return true;
+}
+
+void DeviceProfileStore::capture(const CommandThrottler& throttler) {
+    for (std::size_t address = 0; address < m_attached.size(); ++address) {
+        if (!m_attached[address]) continue;
+        const LaneProfile learned = throttler.laneProfile(static_cast<uint8_t>(address));
+        const auto it = m_profiles.find(*m_attached[address]);
+        if (it == m_profiles.end()) {
+            const bool measured = learned.intervalMs != 0 || learned.ackUs != 0 ||
+                                  learned.streamPath != StreamPathSupport::Unknown;
+            if (measured && m_profiles.size() < kMaxProfiles) {
+                m_profiles.emplace(*m_attached[address], learned);
+            }
+            continue;
+        }
+        LaneProfile& saved = it->second;
+        if (learned.intervalMs != 0) saved.intervalMs = learned.intervalMs;
+        if (learned.ackUs != 0)      saved.ackUs      = learned.ackUs;
+        if (learned.streamPath != StreamPathSupport::Unknown) {
+            saved.streamPath = learned.streamPath;
+        }
+    }
+}
+
+} // namespace cec_control
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+#include "command_throttler.h"
+
+namespace cec_control {
+
+/**
+ * What identifies one device across restarts. Logical addresses are
+ * handed out again on every boot, so a profile is keyed on the
+ * device's vendor ID and its physical address (the HDMI port it sits
+ * behind) instead.
+ */
+struct DeviceIdentity {
+    uint32_t vendorId        = 0;
+    uint16_t physicalAddress = 0;
+
+    [[nodiscard]] bool operator<(const DeviceIdentity& other) const noexcept {
+        return vendorId != other.vendorId ? vendorId < other.vendorId
+                                          : physicalAddress < other.physicalAddress;
+    }
+};
+
+/**
+ * @class DeviceProfileStore
+ * @brief What the throttler has learned about each device, kept in a
+ *        file under the state directory.
+ *
+ * One line per device: vendor ID and physical address, the learned
+ * interval, the smoothed acknowledgement time, and whether the device
+ * honours SetStreamPath. @c load reads the file at startup. Once a
+ * topology scan has put a vendor and physical address to a logical
+ * address, @c attach seeds that lane with the saved profile, so the
+ * first commands after a restart are paced at the learned interval
+ * and a TV known to refuse SetStreamPath goes straight to keypresses.
+ * @c capture copies each attached lane back before @c save.
+ *
+ * Main thread only. Everything here is best effort: a missing or
+ * unreadable file is an empty store, and a failed save is logged.
+ */
+class DeviceProfileStore {
+public:
+    /** Devices the file keeps; the ones learned first win. */
+    static constexpr std::size_t kMaxProfiles = 64;
+
+    /** @param path File the profiles are read from and saved to. */
+    explicit DeviceProfileStore(std::string path);
+
+    /** Replace the store's contents with the file's. */
+    void load();
+
+    /**
+     * Write every profile to the file, replacing it atomically.
+     * @return @c false, after logging why, if it could not be written.
+     */
+    bool save() const;
+
+    /**
+     * Note that @p logicalAddress is the device @p identity for the
+     * rest of this run and seed its lane from the saved profile, if
+     * any. Returns @c true when a profile was applied.
+     */
+    bool attach(uint8_t logicalAddress, const DeviceIdentity& identity,
+                CommandThrottler& throttler);
+
+    /**
+     * Fold what every attached lane has learned into the store. Fields
+     * the lane has not measured this run keep their saved values.
+     */
+    void capture(const CommandThrottler& throttler);
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_profiles.size(); }
+
+private:
+    std::string                                m_path;
+    std::map<DeviceIdentity, LaneProfile>      m_profiles;
+    std::array<std::optional<DeviceIdentity>,
+               CommandThrottler::kLaneCount>   m_attached{};
+};
+
+} // namespace cec_control
@@ -0,0 +1,649 @@
+#include "device_state_cache.h"
+
+#include <cstdio>
+#include <memory>
+#include <utility>
+
+#include "../common/logger.h"
+#include "../common/main_thread_work.h"
+#include "cec/adapter_worker.h"
+#include "cec/operations.h"
+#include "memory_profile.h"
+
+namespace cec_control {
+
+namespace {
+
+// The wire's DeviceState carries libcec's raw power byte.
+static_assert(kPowerStatusUnknown == CEC::CEC_POWER_STATUS_UNKNOWN,
+              "kPowerStatusUnknown value drift");
+
+// Logical address 15 is broadcast (and "unregistered" as a source);
+// no device state is ever cached against it.
+static_assert(kBroadcastAddress == CEC::CECDEVICE_BROADCAST,
+              "kBroadcastAddress value drift");
+
+/**
+ * Every device a power command reaches; a standby to the broadcast
+ * address reaches them all. Zero for any other command.
+ */
+DeviceSet powerTargets(const Message& command) noexcept {
+    if (command.type != MessageType::CMD_POWER_ON &&
+        command.type != MessageType::CMD_POWER_OFF) {
+        return 0;
+    }
+    constexpr DeviceSet kBroadcastBit = 1u << kBroadcastAddress;
+    const DeviceSet devices = decodeDeviceSet(command.data)
+        .value_or(static_cast<DeviceSet>(1u << (command.deviceId % DeviceStateCache::kDeviceCount)));
+    if (!(devices & kBroadcastBit)) return devices;
+    return command.type == MessageType::CMD_POWER_OFF ? static_cast<DeviceSet>(~kBroadcastBit)
+                                                      : static_cast<DeviceSet>(devices & ~kBroadcastBit);
+}
+
+const char* cecVersionName(CEC::cec_version version) noexcept {
+    switch (version) {
+        case CEC::CEC_VERSION_1_2:  return "1.2";
+        case CEC::CEC_VERSION_1_2A: return "1.2a";
+        case CEC::CEC_VERSION_1_3:  return "1.3";
+        case CEC::CEC_VERSION_1_3A: return "1.3a";
+        case CEC::CEC_VERSION_1_4:  return "1.4";
+        case CEC::CEC_VERSION_2_0:  return "2.0";
+        default:                    return "unknown";
+    }
+}
+
+const char* powerName(CEC::cec_power_status power) noexcept {
+    switch (power) {
+        case CEC::CEC_POWER_STATUS_ON:                          return "on";
+        case CEC::CEC_POWER_STATUS_STANDBY:                     return "standby";
+        case CEC::CEC_POWER_STATUS_IN_TRANSITION_STANDBY_TO_ON: return "turning on";
+        case CEC::CEC_POWER_STATUS_IN_TRANSITION_ON_TO_STANDBY: return "turning off";
+        default:                                                return "unknown";
+    }
+}
+
+/** Physical address in dotted form, e.g. "1.0.0.0". */
+std::string dottedPhysicalAddress(uint16_t address) {
+    if (address == kPhysicalAddressUnknown) return "unknown";
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%x.%x.%x.%x",
+                  static_cast<unsigned>((address >> 12) & 0xFu),
+                  static_cast<unsigned>((address >>  8) & 0xFu),
+                  static_cast<unsigned>((address >>  4) & 0xFu),
+                  static_cast<unsigned>((address      ) & 0xFu));
+    return std::string{buf};
+}
+
+std::string vendorIdText(uint32_t vendorId) {
+    if (vendorId == CEC::CEC_VENDOR_UNKNOWN) return "unknown";
+    char buf[12];
+    std::snprintf(buf, sizeof(buf), "0x%06x", static_cast<unsigned>(vendorId));
+    return std::string{buf};
+}
+
+} // namespace
+
+DeviceStateCache::DeviceStateCache(StateCacheConfig config,
+                                   AdapterWorker&   worker,
+                                   MainThreadWork&  work,
+                                   bool             trimHeapAfterScans)
+    : m_ttl(config.ttlMs),
+      m_worker(worker),
+      m_work(work),
+      m_trimHeapAfterScans(trimHeapAfterScans) {}
+
+void DeviceStateCache::observe(const ICecAdapter::Observation& obs) {
+    using Kind = ICecAdapter::Observation::Kind;
+    const TimePoint now = Clock::now();
+
+    switch (obs.kind) {
+    case Kind::TvStandby:
+        recordPower(CEC::CECDEVICE_TV, CEC::CEC_POWER_STATUS_STANDBY, now);
+        return;
+
+    case Kind::TvPowerReport:
+        recordPower(CEC::CECDEVICE_TV, obs.power, now);
+        return;
+
+    case Kind::PowerReport:
+        if (obs.logical != CEC::CECDEVICE_UNKNOWN) {
+            recordPower(static_cast<uint8_t>(obs.logical), obs.power, now);
+        }
+        return;
+
+    case Kind::PhysicalAddressReport:
+        if (obs.logical != CEC::CECDEVICE_UNKNOWN) {
+            recordPhysicalAddress(static_cast<uint8_t>(obs.logical),
+                                  obs.physicalAddress, now);
+        }
+        return;
+
+    case Kind::ActiveSource:
+        recordActiveSource(obs.physicalAddress, now);
+        // An ACTIVE_SOURCE announcer names its own address and is, by
+        // announcing, powered on.
+        if (obs.logical != CEC::CECDEVICE_UNKNOWN) {
+            const auto address = static_cast<uint8_t>(obs.logical);
+            recordPhysicalAddress(address, obs.physicalAddress, now);
+            recordPower(address, CEC::CEC_POWER_STATUS_ON, now);
+        }
+        return;
+
+    case Kind::HostActivated:
+        // Our own client became the active source; its address is
+        // known only if it was cached.
+        if (obs.logical != CEC::CECDEVICE_UNKNOWN) {
+            if (auto physical = freshPhysicalAddress(
+                    static_cast<uint8_t>(obs.logical))) {
+                recordActiveSource(*physical, now);
+            }
+        }
+        return;
+
+    case Kind::HostDeactivated:
+        // The new active source announces itself separately.
+        return;
+
+    case Kind::RawFrame:
+        // Delivered for subscribers; any typed observation of the same
+        // frame follows on its own.
+        return;
+    }
+}
+
+void DeviceStateCache::noteCommandSucceeded(const Message& command) {
+    const TimePoint now = Clock::now();
+
+    switch (command.type) {
+    case MessageType::CMD_POWER_ON:
+    case MessageType::CMD_POWER_OFF: {
+        const auto power = command.type == MessageType::CMD_POWER_ON
+            ? CEC::CEC_POWER_STATUS_ON : CEC::CEC_POWER_STATUS_STANDBY;
+        // A device set was acknowledged by every device in it, and a
+        // broadcast standby puts every device in standby.
+        const DeviceSet devices = powerTargets(command);
+        for (uint8_t address = 0; address < kBroadcastAddress; ++address) {
+            if (devices & (1u << address)) recordPower(address, power, now);
+        }
+        return;
+    }
+
+    case MessageType::CMD_CHANGE_SOURCE: {
+        if (command.data.empty()) return;
+        const uint8_t source = command.data[0];
+        if (source >= kFirstHdmiSource && source <= kLastHdmiSource) {
+            recordActiveSource(ops::hdmiPhysicalAddress(source), now);
+        } else {
+            // TV-internal inputs: the TV itself is the source.
+            recordActiveSource(0x0000, now);
+        }
+        return;
+    }
+
+    default:
+        return;
+    }
+}
+
+DeviceStateCache::PendingChange DeviceStateCache::changeOf(const Message& command) noexcept {
+    return PendingChange{powerTargets(command), command.type == MessageType::CMD_CHANGE_SOURCE};
+}
+
+void DeviceStateCache::noteChangeQueued(const PendingChange& change) {
+    for (uint8_t address = 0; address < kDeviceCount; ++address) {
+        if (change.power & (1u << address)) ++m_powerQueued[address];
+    }
+    if (change.activeSource) ++m_sourceQueued;
+}
+
+void DeviceStateCache::noteChangeSettled(const PendingChange& change) {
+    for (uint8_t address = 0; address < kDeviceCount; ++address) {
+        if ((change.power & (1u << address)) && m_powerQueued[address] > 0) {
+            --m_powerQueued[address];
+        }
+    }
+    if (change.activeSource && m_sourceQueued > 0) --m_sourceQueued;
+}
+
+bool DeviceStateCache::changeQueued(const Message& command) const {
+    if (command.type == MessageType::CMD_CHANGE_SOURCE) return m_sourceQueued > 0;
+    const DeviceSet devices = powerTargets(command);
+    for (uint8_t address = 0; address < kDeviceCount; ++address) {
+        if ((devices & (1u << address)) && m_powerQueued[address] > 0) return true;
+    }
+    return false;
+}
+
+template <typename T>
+std::optional<T>
+DeviceStateCache::freshValue(const std::optional<Sample<T>>& sample) const {
+    if (!sample || !isFresh(sample->at)) return std::nullopt;
+    return sample->value;
+}
+
+std::optional<CEC::cec_power_status>
+DeviceStateCache::freshPower(uint8_t address) const {
+    return freshValue(deviceFor(address).power);
+}
+
+std::optional<uint16_t>
+DeviceStateCache::freshPhysicalAddress(uint8_t address) const {
+    return freshValue(deviceFor(address).physicalAddress);
+}
+
+std::optional<std::string>
+DeviceStateCache::freshOsdName(uint8_t address) const {
+    return freshValue(deviceFor(address).osdName);
+}
+
+std::optional<uint32_t>
+DeviceStateCache::freshVendorId(uint8_t address) const {
+    return freshValue(deviceFor(address).vendorId);
+}
+
+std::optional<CEC::cec_version>
+DeviceStateCache::freshCecVersion(uint8_t address) const {
+    return freshValue(deviceFor(address).cecVersion);
+}
+
+std::optional<uint16_t> DeviceStateCache::freshActiveSource() const {
+    return freshValue(m_activeSource);
+}
+
+std::optional<Message> DeviceStateCache::answer(const Message& query) const {
+    switch (query.type) {
+    case MessageType::CMD_QUERY_STATUS:
+        if (!freshPower(query.deviceId)) return std::nullopt;
+        break;
+    case MessageType::CMD_QUERY_DEVICES:
+        if (!m_lastFullScan || !isFresh(*m_lastFullScan)) return std::nullopt;
+        break;
+    case MessageType::CMD_QUERY_ACTIVE_SOURCE:
+        if (!freshActiveSource()) return std::nullopt;
+        break;
+    default:
+        break;
+    }
+    return snapshot(query);
+}
+
+Message DeviceStateCache::snapshot(const Message& query) const {
+    std::vector<DeviceState> states;
+    switch (query.type) {
+    case MessageType::CMD_QUERY_STATUS:
+        states.push_back(stateOf(query.deviceId));
+        break;
+
+    case MessageType::CMD_QUERY_DEVICES:
+        for (uint8_t logical = 0; logical < kBroadcastAddress; ++logical) {
+            const auto& seen = deviceFor(logical).lastSeen;
+            if (seen && isFresh(*seen)) states.push_back(stateOf(logical));
+        }
+        break;
+
+    case MessageType::CMD_QUERY_ACTIVE_SOURCE: {
+        DeviceState active;
+        if (auto physical = freshActiveSource()) {
+            active.physicalAddress = *physical;
+            for (uint8_t logical = 0; logical < kBroadcastAddress; ++logical) {
+                if (freshPhysicalAddress(logical) == physical) {
+                    active.logicalAddress = logical;
+                    active.powerStatus    = stateOf(logical).powerStatus;
+                    active.osdName        = stateOf(logical).osdName;
+                    break;
+                }
+            }
+        }
+        states.push_back(std::move(active));
+        break;
+    }
+
+    default:
+        return Message(MessageType::RESP_ERROR);
+    }
+    return Message(MessageType::RESP_SUCCESS, query.deviceId,
+                   encodeDeviceStates(states));
+}
+
+DeviceState DeviceStateCache::stateOf(uint8_t address) const {
+    DeviceState state;
+    state.logicalAddress = address % kDeviceCount;
+    if (auto power = freshPower(address)) {
+        state.powerStatus = static_cast<uint8_t>(*power);
+    }
+    if (auto physical = freshPhysicalAddress(address)) {
+        state.physicalAddress = *physical;
+    }
+    if (auto name = freshOsdName(address)) {
+        state.osdName = std::move(*name);
+    }
+    return state;
+}
+
+DeviceState DeviceStateCache::lastKnownState(uint8_t address) const {
+    const Device& device = deviceFor(address);
+    DeviceState state;
+    state.logicalAddress = address % kDeviceCount;
+    if (device.power) state.powerStatus = static_cast<uint8_t>(device.power->value);
+    if (device.physicalAddress) state.physicalAddress = device.physicalAddress->value;
+    return state;
+}
+
+std::optional<uint16_t> DeviceStateCache::lastKnownActiveSource() const {
+    if (!m_activeSource) return std::nullopt;
+    return m_activeSource->value;
+}
+
+std::optional<DeviceStateCache::TimePoint>
+DeviceStateCache::lastSeen(uint8_t address) const {
+    return deviceFor(address).lastSeen;
+}
+
+void DeviceStateCache::invalidate(uint8_t address) {
+    deviceFor(address) = Device{};
+}
+
+void DeviceStateCache::invalidateAll() {
+    m_devices.fill(Device{});
+    m_activeSource.reset();
+    m_lastFullScan.reset();
+
+    if (m_scan) {
+        // What the walk learned so far is gone with the rest; start
+        // over from a fresh device list.
+        LOG_DEBUG("Restarting topology scan after cache invalidation");
+        ++m_scanGeneration;
+        m_scan->present.reset();
+        m_scan->next  = 0;
+        m_scan->found = 0;
+        submitScanStep();
+    }
+}
+
+void DeviceStateCache::refresh(std::optional<uint8_t> address,
+                               WorkPriority           priority,
+                               RefreshDone            onDone) {
+    AdapterWorker::TaskOptions options;
+    options.priority = priority;
+    // The job is copied into the worker only if it is admitted, so the
+    // refused path below still owns onDone.
+    auto done = std::make_shared<RefreshDone>(std::move(onDone));
+    const auto admission = m_worker.submitTask(
+        [this, address, done, progress = RefreshProgress{}](ICecAdapter& adapter) mutable
+            -> std::optional<AdapterWorker::TimePoint> {
+            if (!probeSlice(adapter, address, progress)) {
+                // Yield; the worker resumes us once nothing of a
+                // higher class is waiting.
+                return AdapterWorker::Clock::now();
+            }
+            std::optional<ProbeResult> result;
+            if (!progress.failed) result = std::move(progress.result);
+            m_work.post([this, done, result = std::move(result)]() {
+                if (result) apply(*result);
+                if (*done) (*done)(result.has_value());
+                if (result && result->fullScan && m_trimHeapAfterScans) {
+                    trimHeap("a bus scan");
+                }
+            });
+            return std::nullopt;
+        },
+        std::move(options));
+    if (admission != AdapterWorker::Admission::Accepted) {
+        LOG_DEBUG("Device state refresh not queued");
+        if (*done) (*done)(false);
+    }
+}
+
+bool DeviceStateCache::probeSlice(ICecAdapter&           adapter,
+                                  std::optional<uint8_t> address,
+                                  RefreshProgress&       progress) {
+    // Worker thread.
+    if (!adapter.isConnected()) {
+        progress.failed = true;
+        return true;
+    }
+
+    ProbeResult& result = progress.result;
+    try {
+        if (address) {
+            result.devices.push_back(probeDevice(adapter, *address % kDeviceCount));
+            return true;
+        }
+
+        result.fullScan = true;
+        if (!progress.present) {
+            progress.present = adapter.getActiveDevices();
+            return false;
+        }
+
+        const CEC::cec_logical_addresses& present = *progress.present;
+        while (progress.next < kBroadcastAddress && !present[progress.next]) ++progress.next;
+        if (progress.next < kBroadcastAddress) {
+            result.devices.push_back(probeDevice(adapter, progress.next++));
+            return false;
+        }
+
+        const CEC::cec_logical_address active = adapter.getActiveSource();
+        if (active != CEC::CECDEVICE_UNKNOWN) {
+            for (const auto& device : result.devices) {
+                if (device.address == active &&
+                    device.physicalAddress != kPhysicalAddressUnknown) {
+                    result.activeSource = device.physicalAddress;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception during device state refresh: ", e.what());
+        progress.failed = true;
+    }
+    return true;
+}
+
+DeviceStateCache::Probe
+DeviceStateCache::probeDevice(ICecAdapter& adapter, uint8_t address) {
+    const auto cecAddress = static_cast<CEC::cec_logical_address>(address);
+    Probe found;
+    found.address         = address;
+    found.power           = adapter.getDevicePowerStatus(cecAddress);
+    found.physicalAddress = adapter.getDevicePhysicalAddress(cecAddress);
+    found.osdName         = adapter.getDeviceOSDName(cecAddress);
+    return found;
+}
+
+void DeviceStateCache::apply(const ProbeResult& result) {
+    const TimePoint now = Clock::now();
+
+    if (result.fullScan) {
+        // A device libcec no longer lists has left the bus.
+        std::array<bool, kDeviceCount> present{};
+        for (const auto& device : result.devices) present[device.address] = true;
+        for (uint8_t logical = 0; logical < kDeviceCount; ++logical) {
+            if (!present[logical]) invalidate(logical);
+        }
+        m_lastFullScan = now;
+    }
+
+    for (const auto& device : result.devices) {
+        // libcec listing a device is itself a sighting, even if it
+        // answered none of the getters.
+        if (result.fullScan) deviceFor(device.address).lastSeen = now;
+        applyDevice(device, now);
+    }
+    if (result.activeSource) recordActiveSource(*result.activeSource, now);
+}
+
+void DeviceStateCache::applyDevice(const Probe& device, TimePoint now) {
+    if (device.power != CEC::CEC_POWER_STATUS_UNKNOWN) {
+        recordPower(device.address, device.power, now);
+    }
+    if (device.physicalAddress != kPhysicalAddressUnknown) {
+        recordPhysicalAddress(device.address, device.physicalAddress, now);
+    }
+    Device& entry = deviceFor(device.address);
+    if (!device.osdName.empty()) {
+        entry.osdName  = Sample<std::string>{device.osdName, now};
+        entry.lastSeen = now;
+    }
+    if (device.vendorId != CEC::CEC_VENDOR_UNKNOWN) {
+        entry.vendorId = Sample<uint32_t>{device.vendorId, now};
+        entry.lastSeen = now;
+    }
+    if (device.cecVersion != CEC::CEC_VERSION_UNKNOWN) {
+        entry.cecVersion = Sample<CEC::cec_version>{device.cecVersion, now};
+        entry.lastSeen   = now;
+    }
+}
+
+void DeviceStateCache::scanTopology(RefreshDone onDone) {
+    if (m_scan) {
+        LOG_DEBUG("Topology scan already running");
+        return;
+    }
+    m_scan.emplace();
+    m_scan->startedAt = Clock::now();
+    m_scan->onDone    = std::move(onDone);
+    LOG_INFO("Scanning CEC bus topology in the background");
+    submitScanStep();
+}
+
+void DeviceStateCache::submitScanStep() {
+    AdapterWorker::TaskOptions options;
+    options.priority = WorkPriority::Background;
+    const auto admission = m_worker.submitTask(
+        [this, generation = m_scanGeneration, present = m_scan->present,
+         next = m_scan->next](ICecAdapter& adapter)
+            -> std::optional<AdapterWorker::TimePoint> {
+            // A probe result outgrows a main-thread closure, so it is
+            // boxed; scan steps are background work, off the request path.
+            auto step = std::make_unique<std::optional<ScanStep>>(
+                probeScanStep(adapter, present, next));
+            m_work.post([this, generation, step = std::move(step)] {
+                applyScanStep(generation, std::move(*step));
+            });
+            return std::nullopt;
+        },
+        std::move(options));
+    if (admission != AdapterWorker::Admission::Accepted) {
+        LOG_WARNING("Topology scan step not queued; scan abandoned");
+        finishScan(false);
+    }
+}
+
+std::optional<DeviceStateCache::ScanStep>
+DeviceStateCache::probeScanStep(ICecAdapter& adapter,
+                                std::optional<CEC::cec_logical_addresses> present,
+                                uint8_t next) {
+    // Worker thread.
+    if (!adapter.isConnected()) return std::nullopt;
+
+    ScanStep step;
+    try {
+        if (!present) {
+            // The listing is a step of its own, like any other probe.
+            step.present = adapter.getActiveDevices();
+            return step;
+        }
+        step.present = *present;
+
+        uint8_t logical = next;
+        while (logical < kBroadcastAddress && !step.present[logical]) ++logical;
+        if (logical == kBroadcastAddress) {
+            step.activeSource = adapter.getActiveSource();
+            return step;
+        }
+
+        const auto cecAddress = static_cast<CEC::cec_logical_address>(logical);
+        Probe found       = probeDevice(adapter, logical);
+        found.vendorId    = adapter.getDeviceVendorId(cecAddress);
+        found.cecVersion  = adapter.getDeviceCecVersion(cecAddress);
+        step.device       = std::move(found);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Exception during topology scan: ", e.what());
+        return std::nullopt;
+    }
+    return step;
+}
+
+void DeviceStateCache::applyScanStep(uint64_t generation, std::optional<ScanStep> step) {
+    if (!m_scan || generation != m_scanGeneration) return;
+    if (!step) {
+        LOG_INFO("Topology scan stopped: adapter unavailable");
+        finishScan(false);
+        return;
+    }
+
+    const TimePoint now = Clock::now();
+    if (!m_scan->present) {
+        m_scan->present = step->present;
+        submitScanStep();
+        return;
+    }
+
+    if (step->device) {
+        const Probe& device = *step->device;
+        deviceFor(device.address).lastSeen = now;
+        applyDevice(device, now);
+        ++m_scan->found;
+        LOG_INFO("Device ", static_cast<int>(device.address), ": \"", device.osdName,
+                 "\", physical ", dottedPhysicalAddress(device.physicalAddress),
+                 ", vendor ", vendorIdText(device.vendorId),
+                 ", CEC ", cecVersionName(device.cecVersion),
+                 ", power ", powerName(device.power));
+        m_scan->next = static_cast<uint8_t>(device.address + 1);
+        submitScanStep();
+        return;
+    }
+
+    // Walk complete: what libcec did not list has left the bus.
+    for (uint8_t logical = 0; logical < kDeviceCount; ++logical) {
+        if (!m_scan->present->IsSet(static_cast<CEC::cec_logical_address>(logical))) {
+            invalidate(logical);
+        }
+    }
+    if (step->activeSource != CEC::CECDEVICE_UNKNOWN) {
+        if (auto physical = freshPhysicalAddress(static_cast<uint8_t>(step->activeSource))) {
+            recordActiveSource(*physical, now);
+        }
+    }
+    m_lastFullScan = now;
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now - m_scan->startedAt);
+    LOG_INFO("Topology scan complete: ", m_scan->found, " device(s) in ",
+             elapsed.count(), "ms");
+    finishScan(true);
+}
+
+void DeviceStateCache::finishScan(bool ok) {
+    ++m_scanGeneration;
+    RefreshDone done = std::move(m_scan->onDone);
+    m_scan.reset();
+    if (done) done(ok);
+    // After the callback, so what it builds on the scan is in the
+    // resident size logged.
+    if (ok && m_trimHeapAfterScans) trimHeap("the topology scan");
+}
+
+void DeviceStateCache::recordPower(uint8_t address,
+                                   CEC::cec_power_status power,
+                                   TimePoint at) {
+    if (address >= kBroadcastAddress) return;
+    Device& entry = deviceFor(address);
+    entry.power    = Sample<CEC::cec_power_status>{power, at};
+    entry.lastSeen = at;
+}
+
+void DeviceStateCache::recordPhysicalAddress(uint8_t address,
+                                             uint16_t physicalAddress,
+                                             TimePoint at) {
+    if (address >= kBroadcastAddress) return;
+    Device& entry = deviceFor(address);
+    entry.physicalAddress = Sample<uint16_t>{physicalAddress, at};
+    entry.lastSeen        = at;
+}
+
+void DeviceStateCache::recordActiveSource(uint16_t physicalAddress, TimePoint at) {
+    m_activeSource = Sample<uint16_t>{physicalAddress, at};
+}
+
+} // namespace cec_control
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../common/messages.h"
+#include "app_config.h"
+#include "cec/adapter_interface.h"
+#include "cec/work_priority.h"
+
+namespace cec_control {
+
+class AdapterWorker;
+class MainThreadWork;
+
+/**
+ * @class DeviceStateCache
+ * @brief Last-known bus state per CEC logical address, with a
+ *        freshness window.
+ *
+ * Tracks, for each of the 16 logical addresses, the power status,
+ * physical address and OSD name last seen for that device, plus the
+ * bus-wide active source. Vendor ID and CEC version are known only
+ * for devices a topology scan has reached. Every fact carries the instant it was
+ * learned; a @c fresh* read returns it only while it is younger than
+ * @c StateCacheConfig::ttlMs, so a consumer can answer from the cache
+ * or fall back to the bus without reasoning about age itself.
+ *
+ * ## Inputs
+ *
+ *  - @c observe — bus traffic forwarded by the daemon: power and
+ *    physical-address reports, active-source announcements and
+ *    routing changes, TV standby.
+ *  - @c noteCommandSucceeded — the outcome of the daemon's own
+ *    commands. An acknowledged power-on, standby or source change is
+ *    recorded as the state it drove the bus to.
+ *  - @c refresh — an explicit bus query run on the adapter worker.
+ *    The probe uses libcec's blocking getters, so it is meant for
+ *    cache misses and operator requests, not the hot path.
+ *  - @c scanTopology — the same getters, plus vendor ID and CEC
+ *    version, spread over one Background job per device so the walk
+ *    never holds the worker while a user command waits.
+ *
+ * ## Threading
+ *
+ * Main thread only, like @c StandbyPolicy: observations reach
+ * @c observe through the daemon's @c ObservationBus, command
+ * outcomes arrive in the dispatcher's main-thread reply posts, and
+ * @c refresh and every @c scanTopology step post their probe results
+ * back before applying them.
+ *
+ * ## Ownership
+ *
+ * Held by @c unique_ptr on @c CECDaemon and destroyed after the
+ * worker has been joined, so no refresh job or posted result can
+ * outlive it. The dispatcher holds a non-owning reference.
+ */
+class DeviceStateCache {
+public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    /** One slot per CEC logical address. */
+    static constexpr std::size_t kDeviceCount = 16;
+
+    /** Completion of a @c refresh; @c false if the bus was not queried. */
+    using RefreshDone = std::function<void(bool ok)>;
+
+    /**
+     * @param config Freshness window; copied.
+     * @param worker Non-owning; must outlive @c this. Runs @c refresh
+     *               probes.
+     * @param work   Non-owning; must outlive @c this. Carries probe
+     *               results back to the main thread.
+     * @param trimHeapAfterScans Give free heap back to the kernel (see
+     *               @c trimHeap) once each full refresh or topology
+     *               scan has been applied; set under
+     *               @c DaemonConfig::lowMemory.
+     */
+    DeviceStateCache(StateCacheConfig config,
+                     AdapterWorker&   worker,
+                     MainThreadWork&  work,
+                     bool             trimHeapAfterScans = false);
+
+    DeviceStateCache(const DeviceStateCache&)            = delete;
+    DeviceStateCache& operator=(const DeviceStateCache&) = delete;
+
+    /** Fold a bus observation into the cache. Main thread only. */
+    void observe(const ICecAdapter::Observation& obs);
+
+    /**
+     * Record the state an acknowledged @p command left the bus in.
+     * Types that do not name a device state are ignored. Main thread
+     * only.
+     */
+    void noteCommandSucceeded(const Message& command);
+
+    /** The device state a queued command is about to change. */
+    struct PendingChange {
+        DeviceSet power        = 0;      ///< Devices whose power it sets.
+        bool      activeSource = false;  ///< Whether it moves the active source.
+
+        PendingChange& operator|=(const PendingChange& other) noexcept {
+            power |= other.power;
+            activeSource = activeSource || other.activeSource;
+            return *this;
+        }
+    };
+
+    /** What @p command would change; empty for types that change no cached state. */
+    [[nodiscard]] static PendingChange changeOf(const Message& command) noexcept;
+
+    /**
+     * Record that work making @p change has been queued for the
+     * adapter. Until it is passed to @c noteChangeSettled,
+     * @c changeQueued reports the state it touches, whatever the cache
+     * holds for it. Main thread only.
+     */
+    void noteChangeQueued(const PendingChange& change);
+
+    /**
+     * The work behind @p change has run, failed or been dropped. Main
+     * thread only; record a success first, so the cache never reports
+     * the state as settled before it holds the outcome.
+     */
+    void noteChangeSettled(const PendingChange& change);
+
+    /**
+     * Whether a queued command is still to change state that
+     * @p command would change: the cache then reflects less than what
+     * the adapter is about to do.
+     */
+    [[nodiscard]] bool changeQueued(const Message& command) const;
+
+    /** Power status of @p address, if learned within the TTL. */
+    [[nodiscard]] std::optional<CEC::cec_power_status>
+    freshPower(uint8_t address) const;
+
+    /** Physical address of @p address, if learned within the TTL. */
+    [[nodiscard]] std::optional<uint16_t>
+    freshPhysicalAddress(uint8_t address) const;
+
+    /** OSD name of @p address, if learned within the TTL. */
+    [[nodiscard]] std::optional<std::string>
+    freshOsdName(uint8_t address) const;
+
+    /** Vendor ID of @p address, if a scan learned it within the TTL. */
+    [[nodiscard]] std::optional<uint32_t> freshVendorId(uint8_t address) const;
+
+    /** CEC version of @p address, if a scan learned it within the TTL. */
+    [[nodiscard]] std::optional<CEC::cec_version>
+    freshCecVersion(uint8_t address) const;
+
+    /** Physical address of the active source, if learned within the TTL. */
+    [[nodiscard]] std::optional<uint16_t> freshActiveSource() const;
+
+    /**
+     * Answer a @c CMD_QUERY_* command from the cache, or
+     * @c std::nullopt when the fact it hinges on is not fresh: the
+     * device's power status for @c CMD_QUERY_STATUS, a full bus scan
+     * for @c CMD_QUERY_DEVICES, the active source for
+     * @c CMD_QUERY_ACTIVE_SOURCE. Other types answer @c RESP_ERROR.
+     */
+    [[nodiscard]] std::optional<Message> answer(const Message& query) const;
+
+    /**
+     * @c answer without the freshness requirement: whatever the cache
+     * holds fresh, with unknown fields marked as such. Used once a
+     * refresh has run and the bus simply had no more to say.
+     */
+    [[nodiscard]] Message snapshot(const Message& query) const;
+
+    /**
+     * Whatever the cache holds for @p address, however old: power
+     * status and physical address (unknown fields marked as such),
+     * without the OSD name. For publishing last-known state, where a
+     * value past the TTL is still the best available.
+     */
+    [[nodiscard]] DeviceState lastKnownState(uint8_t address) const;
+
+    /** Physical address of the active source, however old. */
+    [[nodiscard]] std::optional<uint16_t> lastKnownActiveSource() const;
+
+    /**
+     * Last time anything was heard from @p address, fresh or not;
+     * @c std::nullopt if it never has been.
+     */
+    [[nodiscard]] std::optional<TimePoint> lastSeen(uint8_t address) const;
+
+    /** Forget everything cached for @p address. Main thread only. */
+    void invalidate(uint8_t address);
+
+    /**
+     * Forget the whole bus, for a caller that knows it may have
+     * changed unobserved (an adapter reopen, a host resume).
+     */
+    void invalidateAll();
+
+    /**
+     * Query the bus on the worker at @p priority and fold the answer
+     * into the cache. With @p address, probes that device only;
+     * without, probes every device libcec reports active plus the
+     * active source, and forgets devices that have left the bus. A
+     * full probe runs one device per worker slice, so higher-class
+     * work can cut in between devices.
+     * @p onDone (may be empty) runs on the main thread once the
+     * result is applied, or with @c false if the worker refused the
+     * job or the adapter was disconnected.
+     */
+    void refresh(std::optional<uint8_t> address,
+                 WorkPriority           priority,
+                 RefreshDone            onDone);
+
+    /**
+     * Map the bus incrementally: one @c WorkPriority::Background job
+     * lists the devices libcec knows, then each following job probes
+     * a single one of them for power status, physical address, OSD
+     * name, vendor ID and CEC version. The next job is queued only
+     * once the previous result has been applied, so any Interactive
+     * work submitted meanwhile runs first and waits behind at most one
+     * device's getters. Each device found is logged.
+     *
+     * On completion the scan counts as a full refresh. An
+     * @c invalidateAll while it runs restarts it from the device
+     * list. @p onDone (may be empty) runs on the main thread with
+     * @c false if the worker refused a step or the adapter dropped.
+     * A call while a scan is already running is ignored and its
+     * @p onDone never runs.
+     */
+    void scanTopology(RefreshDone onDone);
+
+    /** True while a @c scanTopology walk is in progress. */
+    [[nodiscard]] bool scanning() const noexcept { return m_scan.has_value(); }
+
+private:
+    template <typename T>
+    struct Sample {
+        T         value{};
+        TimePoint at{};
+    };
+
+    struct Device {
+        std::optional<Sample<CEC::cec_power_status>> power;
+        std::optional<Sample<uint16_t>>              physicalAddress;
+        std::optional<Sample<std::string>>           osdName;
+        std::optional<Sample<uint32_t>>              vendorId;
+        std::optional<Sample<CEC::cec_version>>      cecVersion;
+        std::optional<TimePoint>                     lastSeen;
+    };
+
+    /** What one worker-side probe learned about one device. */
+    struct Probe {
+        uint8_t               address = 0;
+        CEC::cec_power_status power   = CEC::CEC_POWER_STATUS_UNKNOWN;
+        uint16_t              physicalAddress = kPhysicalAddressUnknown;
+        std::string           osdName;
+        // Filled by topology scan steps only.
+        uint32_t              vendorId   = CEC::CEC_VENDOR_UNKNOWN;
+        CEC::cec_version      cecVersion = CEC::CEC_VERSION_UNKNOWN;
+    };
+
+    /** Result of one @c refresh, carried back to the main thread. */
+    struct ProbeResult {
+        std::vector<Probe>      devices;
+        std::optional<uint16_t> activeSource;
+        bool                    fullScan = false;
+    };
+
+    /** Worker-side state of a @c refresh between its slices. */
+    struct RefreshProgress {
+        ProbeResult                               result;
+        std::optional<CEC::cec_logical_addresses> present;
+        uint8_t                                   next   = 0;
+        bool                                      failed = false;
+    };
+
+    /** Progress of a @c scanTopology walk. */
+    struct TopologyScan {
+        // libcec's device list, fetched by the first step.
+        std::optional<CEC::cec_logical_addresses> present;
+        uint8_t     next  = 0;
+        std::size_t found = 0;
+        TimePoint   startedAt{};
+        RefreshDone onDone;
+    };
+
+    /** What one @c scanTopology step brought back from the worker. */
+    struct ScanStep {
+        CEC::cec_logical_addresses present{};
+        // Empty once no listed device is left at or after the cursor.
+        std::optional<Probe>                     device;
+        CEC::cec_logical_address                 activeSource = CEC::CECDEVICE_UNKNOWN;
+    };
+
+    /** Cached state of @p address, fresh fields only. */
+    [[nodiscard]] DeviceState stateOf(uint8_t address) const;
+
+    /** Whether something learned at @p at is still inside the TTL. */
+    [[nodiscard]] bool isFresh(TimePoint at) const noexcept {
+        return Clock::now() - at <= m_ttl;
+    }
+
+    /**
+     * Worker side of @c refresh: one blocking libcec query per call,
+     * so a full scan yields to other work between devices. Returns
+     * @c true once @p progress holds the finished (or failed) result.
+     */
+    [[nodiscard]] static bool probeSlice(ICecAdapter&           adapter,
+                                         std::optional<uint8_t> address,
+                                         RefreshProgress&       progress);
+
+    /** Power, physical address and OSD name of one device. Worker thread. */
+    [[nodiscard]] static Probe probeDevice(ICecAdapter& adapter, uint8_t address);
+
+    /**
+     * Worker side of one @c scanTopology step: the device list when
+     * @p present is empty, then the first listed device at or after
+     * @p next.
+     */
+    [[nodiscard]] static std::optional<ScanStep>
+    probeScanStep(ICecAdapter& adapter,
+                  std::optional<CEC::cec_logical_addresses> present,
+                  uint8_t next);
+
+    /** Main-thread side of @c refresh. */
+    void apply(const ProbeResult& result);
+
+    /** Fold what a probe learned about one device in, as of @p now. */
+    void applyDevice(const Probe& device, TimePoint now);
+
+    /** Queue the next step of the running scan. */
+    void submitScanStep();
+
+    /** Main-thread side of a scan step; stale generations are dropped. */
+    void applyScanStep(uint64_t generation, std::optional<ScanStep> step);
+
+    /** End the running scan and report @p ok to its caller. */
+    void finishScan(bool ok);
+
+    void recordPower(uint8_t address, CEC::cec_power_status power, TimePoint at);
+    void recordPhysicalAddress(uint8_t address, uint16_t physicalAddress, TimePoint at);
+    void recordActiveSource(uint16_t physicalAddress, TimePoint at);
+
+    [[nodiscard]] Device& deviceFor(uint8_t address) noexcept {
+        return m_devices[address % kDeviceCount];
+    }
+    [[nodiscard]] const Device& deviceFor(uint8_t address) const noexcept {
+        return m_devices[address % kDeviceCount];
+    }
+
+    template <typename T>
+    [[nodiscard]] std::optional<T> freshValue(const std::optional<Sample<T>>& sample) const;
+
+    const std::chrono::milliseconds m_ttl;
+    AdapterWorker&                  m_worker;
+    MainThreadWork&                 m_work;
+    const bool                      m_trimHeapAfterScans;
+
+    std::array<Device, kDeviceCount> m_devices{};
+    std::optional<Sample<uint16_t>>  m_activeSource;
+
+    // Queued commands not yet settled, per device power and for the
+    // active source; see noteChangeQueued.
+    std::array<uint16_t, kDeviceCount> m_powerQueued{};
+    uint16_t                           m_sourceQueued = 0;
+
+    // Completion of the last full-bus refresh; the device list is only
+    // known to be complete while this is fresh.
+    std::optional<TimePoint> m_lastFullScan;
+
+    std::optional<TopologyScan> m_scan;
+    // Bumped whenever the running scan restarts or ends, so a step
+    // still on the worker cannot land in the wrong walk.
+    uint64_t m_scanGeneration = 0;
+};
+
+} // namespace cec_control
@@ -0,0 +1,167 @@
+#include "flight_recorder.h"
+
+#include "../common/logger.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace cec_control {
+
+namespace {
+
+int64_t unixMicros() noexcept {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+FlightRecorder& FlightRecorder::getInstance() noexcept {
+    static FlightRecorder instance;
+    return instance;
+}
+
+bool FlightRecorder::open(const std::string& path) {
+    if (isOpen()) return true;
+
+    // The previous run's recording is the one worth reading when this
+    // start is systemd restarting a daemon that died.
+    const std::string previous = path + ".1";
+    if (::rename(path.c_str(), previous.c_str()) != 0 && errno != ENOENT) {
+        LOG_WARNING("Cannot keep the previous flight recording as ", previous, ": ",
+                    std::strerror(errno));
+    }
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        LOG_WARNING("Cannot create flight recorder ", path, ": ", std::strerror(errno));
+        return false;
+    }
+    void* mapped = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(sizeof(flight_log::Layout))) == 0) {
+        mapped = ::mmap(nullptr, sizeof(flight_log::Layout), PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+    }
+    const int err = errno;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_WARNING("Cannot map flight recorder ", path, ": ", std::strerror(err));
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    // The fresh file reads as zeros, which is every ring unclaimed and
+    // every record unwritten; only the header needs filling in.
+    auto* log      = new (mapped) flight_log::Layout{};
+    log->magic     = flight_log::kMagic;
+    log->version   = flight_log::kVersion;
+    log->pid       = static_cast<uint32_t>(::getpid());
+    log->ringCount = flight_log::kRingCount;
+    log->startedUs = unixMicros();
+    m_log.store(log, std::memory_order_release);
+    LOG_INFO("Flight recorder at ", path);
+    return true;
+}
+
+namespace {
+
+/** The calling thread's ring; handed back, records kept, when the thread exits. */
+struct RingHold {
+    bool              claimed = false;
+    flight_log::Ring* ring    = nullptr;
+
+    ~RingHold() {
+        if (ring != nullptr) ring->claimed.store(flight_log::kRingReleased, std::memory_order_release);
+    }
+};
+
+/** When @p ring was last written; its released owner's last record. */
+int64_t lastWrittenUs(const flight_log::Ring& ring) noexcept {
+    const uint64_t next = ring.next.load(std::memory_order_relaxed);
+    if (next == 0) return 0;
+    return ring.records[(next - 1) % flight_log::kRingRecords].timeUs.load(
+        std::memory_order_relaxed);
+}
+
+/**
+ * Take over the released ring idle longest, emptied for a new owner;
+ * null if every ring is owned.
+ */
+flight_log::Ring* takeOverReleased(flight_log::Layout& log) noexcept {
+    for (;;) {
+        flight_log::Ring* oldest = nullptr;
+        for (flight_log::Ring& ring : log.rings) {
+            if (ring.claimed.load(std::memory_order_acquire) != flight_log::kRingReleased) continue;
+            if (oldest == nullptr || lastWrittenUs(ring) < lastWrittenUs(*oldest)) oldest = &ring;
+        }
+        if (oldest == nullptr) return nullptr;
+        uint32_t released = flight_log::kRingReleased;
+        // Unused while it is emptied, so a reader skips the ring
+        // rather than pairing the old records with the new owner.
+        if (oldest->claimed.compare_exchange_strong(released, flight_log::kRingUnused,
+                                                    std::memory_order_acq_rel)) {
+            for (flight_log::Record& record : oldest->records) {
+                record.sequence.store(0, std::memory_order_relaxed);
+            }
+            oldest->next.store(0, std::memory_order_relaxed);
+            return oldest;
+        }
+        // Another new thread took it first; look again.
+    }
+}
+
+} // namespace
+
+flight_log::Ring* FlightRecorder::ringForThisThread(flight_log::Layout& log) noexcept {
+    thread_local RingHold hold;
+    if (!hold.claimed) {
+        hold.claimed = true;
+        flight_log::Ring* ring = nullptr;
+        const uint32_t index = log.ringsClaimed.fetch_add(1, std::memory_order_relaxed);
+        if (index < flight_log::kRingCount) {
+            ring = &log.rings[index];
+        } else {
+            ring = takeOverReleased(log);
+        }
+        if (ring != nullptr) {
+            ring->tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+            ::pthread_getname_np(::pthread_self(), ring->name, sizeof(ring->name));
+            ring->claimed.store(flight_log::kRingOwned, std::memory_order_release);
+        }
+        hold.ring = ring;
+    }
+    return hold.ring;
+}
+
+void FlightRecorder::record(flight_log::Event event, uint8_t detail, uint16_t arg,
+                            uint32_t id, uint64_t value) noexcept {
+    flight_log::Layout* log = m_log.load(std::memory_order_acquire);
+    if (log == nullptr) return;
+    flight_log::Ring* ring = ringForThisThread(*log);
+    if (ring == nullptr) return;
+
+    // Single writer per ring, as in Tracer::record, and the same
+    // per-record sequence lock.
+    const uint64_t index = ring->next.load(std::memory_order_relaxed);
+    ring->next.store(index + 1, std::memory_order_relaxed);
+    flight_log::Record& slot = ring->records[index % flight_log::kRingRecords];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timeUs.store(unixMicros(), std::memory_order_relaxed);
+    slot.head.store(flight_log::packHead(event, detail, arg, id), std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+} // namespace cec_control
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "../common/flight_log.h"
+
+namespace cec_control {
+
+/**
+ * Daemon side of the flight recorder (see @c flight_log): maps the file
+ * and appends records to the calling thread's ring. Singleton, like
+ * @c Tracer, because its record sites span every thread and subsystem.
+ *
+ * Until @c open succeeds every record call is one atomic load and a
+ * branch; after it, a clock read and five stores into a ring only the
+ * calling thread writes, with no lock, allocation or syscall. The
+ * mapping is kept for the life of the process, never unmapped, so a
+ * record site can run on any thread at any point of shutdown.
+ */
+class FlightRecorder {
+public:
+    static FlightRecorder& getInstance() noexcept;
+
+    FlightRecorder(const FlightRecorder&)            = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    /**
+     * Keep any recording at @p path as @p path ".1", then create and
+     * map a fresh one there. Main thread, once.
+     * @return @c false, with the reason logged, if the file cannot be
+     *         made; recording then stays off.
+     */
+    [[nodiscard]] bool open(const std::string& path);
+
+    [[nodiscard]] bool isOpen() const noexcept {
+        return m_log.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    void milestone(flight_log::Milestone milestone, bool ok = true) noexcept {
+        record(flight_log::Event::Milestone, static_cast<uint8_t>(milestone), ok ? 1 : 0);
+    }
+
+    void request(uint64_t session, uint16_t requestId, uint8_t type, uint8_t device) noexcept {
+        record(flight_log::Event::Request, type, requestId, device, session);
+    }
+
+    void reply(uint64_t session, uint16_t requestId, uint8_t type) noexcept {
+        record(flight_log::Event::Reply, type, requestId, 0, session);
+    }
+
+    void jobStart(uint8_t priority, uint8_t lane) noexcept {
+        record(flight_log::Event::JobStart, priority, lane);
+    }
+
+    void jobEnd(uint8_t priority, uint8_t lane, flight_log::JobOutcome outcome,
+                uint64_t durationUs) noexcept {
+        record(flight_log::Event::JobEnd, priority, lane,
+               static_cast<uint32_t>(outcome), durationUs);
+    }
+
+    void throttle(flight_log::ThrottleDecision decision, uint8_t device,
+                  uint64_t waitUs = 0) noexcept {
+        record(flight_log::Event::Throttle, static_cast<uint8_t>(decision), device, 0, waitUs);
+    }
+
+    void observation(flight_log::ObservationKind kind, uint8_t device, uint32_t what) noexcept {
+        record(flight_log::Event::Observation, static_cast<uint8_t>(kind), device, what);
+    }
+
+private:
+    FlightRecorder() = default;
+
+    /** The calling thread's ring, claimed on first use; null if none is left. */
+    [[nodiscard]] flight_log::Ring* ringForThisThread(flight_log::Layout& log) noexcept;
+
+    void record(flight_log::Event event, uint8_t detail, uint16_t arg = 0,
+                uint32_t id = 0, uint64_t value = 0) noexcept;
+
+    std::atomic<flight_log::Layout*> m_log{nullptr};
+};
+
+} // namespace cec_control
@@ -1,15 +1,18 @@
 #include "cec_hook_subsystem.h"
 
 #include "../../common/logger.h"
-#include "../../common/timer_source.h"
+#include "../../common/loop_timer.h"
 #include "hook_executor.h"
+#include "hook_helper.h"
 
 #include <libcec/cec.h>
 
 #include <unistd.h>
 #include <time.h>
 
+#include <algorithm>
 #include <chrono>
+#include <iterator>
 #include <cstdio>
 #include <cstdlib>
 #include <string>
@@ -19,16 +22,10 @@ namespace cec_control {
 
 namespace {
 
-// Window over which back-to-back @c ActiveSource observations
-// collapse to a single @c InputSwitch fire. Sized to cover the
-// startup burst (observations arrive sub-millisecond apart) and
-// the AVR re-route ping-pong (seconds apart — out of scope, each
-// end fires) without introducing user-visible latency for a real
-// input switch (an AVR takes hundreds of milliseconds to respond
-// anyway). Fixed at a compile-time constant: a config knob is
-// easy to add if a real bus ever produces a wider burst, but
-// absent a reported need the simpler shape wins.
-constexpr auto kDebounceWindow = std::chrono::milliseconds(200);
+// Distinct intermediate addresses an @c InputSwitch firing lists in
+// @c CEC_SOURCE_VIA. A burst that visits more is a misbehaving bus;
+// the firing still carries its endpoints and merged count.
+constexpr std::size_t kMaxSourceTrail = 8;
 
 /**
  * Render a 16-bit CEC physical address in its conventional dotted-
@@ -91,22 +88,53 @@ void propagateIfSet(std::vector<std::string>& env,
 
 CecHookSubsystem::CecHookSubsystem(HooksConfig config,
                                     HookExecutor& executor,
-                                    TimerSource& debounceTimer)
+                                    LoopTimer& debounceTimer,
+                                    LoopTimer& tvPowerTimer,
+                                    HookHelper* helper)
     : m_config(std::move(config)),
       m_executor(executor),
       m_debounceTimer(debounceTimer),
-      m_daemonPid(::getpid()) {}
+      m_tvPowerTimer(tvPowerTimer),
+      m_helper(helper),
+      m_daemonPid(::getpid()),
+      m_parentEnv(sanitisedParentEnv()),
+      m_inputSwitchDebouncer(m_config.inputSwitchDebounce),
+      m_tvPowerDebouncer(m_config.tvPowerDebounce) {
+    buildImages();
+}
+
+void CecHookSubsystem::setScripts(const HooksConfig& config) {
+    m_config.inputSwitch     = config.inputSwitch;
+    m_config.tvStandby       = config.tvStandby;
+    m_config.tvWake          = config.tvWake;
+    m_config.hostActivated   = config.hostActivated;
+    m_config.hostDeactivated = config.hostDeactivated;
+    m_config.inputSwitchDebounce = config.inputSwitchDebounce;
+    m_config.tvPowerDebounce     = config.tvPowerDebounce;
+    m_inputSwitchDebouncer.setPolicy(m_config.inputSwitchDebounce);
+    m_tvPowerDebouncer.setPolicy(m_config.tvPowerDebounce);
+    buildImages();
+}
+
+void CecHookSubsystem::buildImages() {
+    auto image = [this](const std::string& path) -> std::shared_ptr<const hook::SpawnImage> {
+        if (path.empty()) return nullptr;
+        return std::make_shared<const hook::SpawnImage>(path, m_parentEnv);
+    };
+    m_inputSwitchImage     = image(m_config.inputSwitch);
+    m_tvStandbyImage       = image(m_config.tvStandby);
+    m_tvWakeImage          = image(m_config.tvWake);
+    m_hostActivatedImage   = image(m_config.hostActivated);
+    m_hostDeactivatedImage = image(m_config.hostDeactivated);
+}
 
 void CecHookSubsystem::observe(const ICecAdapter::Observation& obs) {
     using Kind = ICecAdapter::Observation::Kind;
     switch (obs.kind) {
     case Kind::TvStandby:
-        if (m_lastTvPower == CachedPower::Standby) {
-            LOG_DEBUG("Hook dedup: TV standby already cached; no fire");
-            return;
-        }
-        fireTvStandby();
-        m_lastTvPower = CachedPower::Standby;
+        m_pendingTvPower = CachedPower::Standby;
+        ++m_tvPowerMerged;
+        if (debounce(m_tvPowerDebouncer, m_tvPowerTimer)) commitTvPower();
         return;
 
     case Kind::TvPowerReport:
@@ -116,28 +144,25 @@ void CecHookSubsystem::observe(const ICecAdapter::Observation& obs) {
         if (obs.power != CEC::CEC_POWER_STATUS_ON) {
             return;
         }
-        if (m_lastTvPower == CachedPower::On) {
-            LOG_DEBUG("Hook dedup: TV already on; no wake fire");
-            return;
-        }
-        fireTvWake();
-        m_lastTvPower = CachedPower::On;
+        m_pendingTvPower = CachedPower::On;
+        ++m_tvPowerMerged;
+        if (debounce(m_tvPowerDebouncer, m_tvPowerTimer)) commitTvPower();
         return;
 
-    case Kind::ActiveSource:
-        m_pendingPhysical = obs.physicalAddress;
-        LOG_DEBUG("Hook debounce: pending active source = ",
-                  dottedPhysicalAddress(obs.physicalAddress),
-                  ", timer (re)armed");
-        if (!m_debounceTimer.armOnce(kDebounceWindow)) {
-            // armOnce logs its own failure. Fall back to an
-            // immediate commit so we never silently lose a
-            // transition — the debounce is a convenience, not a
-            // correctness requirement.
-            LOG_WARNING("Hook debounce timer arm failed; committing synchronously");
-            commitPending();
+    case Kind::ActiveSource: {
+        const uint16_t addr = obs.physicalAddress;
+        m_pendingPhysical = addr;
+        ++m_sourceMerged;
+        if (m_sourceTrail.size() < kMaxSourceTrail &&
+            std::find(m_sourceTrail.begin(), m_sourceTrail.end(), addr) ==
+                m_sourceTrail.end()) {
+            m_sourceTrail.push_back(addr);
         }
+        LOG_DEBUG("Hook debounce: pending active source = ",
+                  dottedPhysicalAddress(addr), " (", m_sourceMerged, " merged)");
+        if (debounce(m_inputSwitchDebouncer, m_debounceTimer)) commitPending();
         return;
+    }
 
     case Kind::HostActivated:
         fireHostActivated(obs.logical);
@@ -146,25 +171,51 @@ void CecHookSubsystem::observe(const ICecAdapter::Observation& obs) {
     case Kind::HostDeactivated:
         fireHostDeactivated(obs.logical);
         return;
+
+    case Kind::PowerReport:
+    case Kind::PhysicalAddressReport:
+    case Kind::RawFrame:
+        // Non-TV bus state feeds the device-state cache only, and raw
+        // frames only their subscribers; no hook is keyed on either.
+        return;
     }
 }
 
 void CecHookSubsystem::onDebounceTimerFired() {
-    // A zero expiration count means the read would have blocked —
-    // the most likely cause is that @c armOnce was called after
-    // the kernel flagged the fd ready but before this handler ran
-    // (e.g. an observation closure draining from @c MainThreadWork
-    // in the same epoll batch). @c timerfd_settime resets the
-    // expiration count, so the handler sees a spurious ready fd
-    // with nothing to commit; the freshly-armed timer will fire on
-    // its own schedule and commit then.
+    // A zero expiration count means the arming this wake belonged
+    // to was superseded: @c armOnce resets the count, and the
+    // freshly-armed timer will fire on its own schedule and commit
+    // then. Loop timers deliver the expiry and the handler call
+    // together, so this is defensive.
     if (m_debounceTimer.consume() == 0) {
         LOG_DEBUG("Hook debounce: spurious wake (arming superseded); skipping commit");
         return;
     }
+    m_inputSwitchDebouncer.close();
     commitPending();
 }
 
+void CecHookSubsystem::onTvPowerTimerFired() {
+    if (m_tvPowerTimer.consume() == 0) return;
+    m_tvPowerDebouncer.close();
+    commitTvPower();
+}
+
+bool CecHookSubsystem::debounce(hook::Debouncer& debouncer, LoopTimer& timer) {
+    if (debouncer.immediate()) return true;
+    const auto now = hook::Debouncer::Clock::now();
+    const bool leading = debouncer.observe(now);
+    if (!timer.armOnce(debouncer.remaining(now))) {
+        // armOnce logs its own failure. Fall back to an immediate
+        // commit so we never silently lose a transition — the
+        // debounce is a convenience, not a correctness requirement.
+        LOG_WARNING("Hook debounce timer arm failed; committing synchronously");
+        debouncer.close();
+        return true;
+    }
+    return leading;
+}
+
 void CecHookSubsystem::commitPending() {
     if (!m_pendingPhysical.has_value()) {
         // Normal when the timer fires after a shutdown/teardown
@@ -175,16 +226,34 @@ void CecHookSubsystem::commitPending() {
     if (m_lastFiredPhysical && *m_lastFiredPhysical == committed) {
         LOG_DEBUG("Hook debounce: active source settled unchanged (",
                   dottedPhysicalAddress(committed), ")");
-        m_pendingPhysical.reset();
-        return;
+    } else {
+        fireInputSwitch(committed);
+        m_lastFiredPhysical = committed;
     }
-    fireInputSwitch(committed);
-    m_lastFiredPhysical = committed;
     m_pendingPhysical.reset();
+    m_sourceTrail.clear();
+    m_sourceMerged = 0;
+}
+
+void CecHookSubsystem::commitTvPower() {
+    const CachedPower committed = std::exchange(m_pendingTvPower, CachedPower::Unknown);
+    const uint32_t    merged    = std::exchange(m_tvPowerMerged, 0);
+    if (committed == CachedPower::Unknown) return;
+    if (committed == m_lastTvPower) {
+        LOG_DEBUG("Hook dedup: TV power unchanged (",
+                  previousPowerString(committed), "); no fire");
+        return;
+    }
+    if (committed == CachedPower::Standby) {
+        fireTvStandby(merged);
+    } else {
+        fireTvWake(merged);
+    }
+    m_lastTvPower = committed;
 }
 
 void CecHookSubsystem::fireInputSwitch(uint16_t newAddr) {
-    auto env = baseEnv("InputSwitch");
+    auto env = baseFields("InputSwitch");
     env.push_back("CEC_SOURCE_PHYSICAL=" + dottedPhysicalAddress(newAddr));
     env.push_back("CEC_SOURCE_PHYSICAL_RAW=" + rawPhysicalAddress(newAddr));
     // First fire: no prior committed address, emit as empty string
@@ -193,73 +262,93 @@ void CecHookSubsystem::fireInputSwitch(uint16_t newAddr) {
                   (m_lastFiredPhysical
                        ? dottedPhysicalAddress(*m_lastFiredPhysical)
                        : std::string{}));
-    submit("InputSwitch", m_config.inputSwitch, std::move(env));
+    // The stops between the two endpoints, so a script that cares
+    // about the route (an AVR hop) still sees it after the merge.
+    std::string via;
+    for (const uint16_t addr : m_sourceTrail) {
+        if (addr == newAddr || (m_lastFiredPhysical && addr == *m_lastFiredPhysical)) continue;
+        if (!via.empty()) via.push_back(' ');
+        via += dottedPhysicalAddress(addr);
+    }
+    env.push_back("CEC_SOURCE_VIA=" + via);
+    env.push_back("CEC_EVENT_MERGED=" + std::to_string(std::max<uint32_t>(m_sourceMerged, 1)));
+    submit("InputSwitch", m_inputSwitchImage, std::move(env));
 }
 
-void CecHookSubsystem::fireTvStandby() {
-    auto env = baseEnv("TVStandby");
+void CecHookSubsystem::fireTvStandby(uint32_t merged) {
+    auto env = baseFields("TVStandby");
     env.push_back("CEC_TV_POWER=standby");
     env.push_back("CEC_TV_POWER_PREVIOUS=" +
                   std::string{previousPowerString(m_lastTvPower)});
-    submit("TVStandby", m_config.tvStandby, std::move(env));
+    env.push_back("CEC_EVENT_MERGED=" + std::to_string(merged));
+    submit("TVStandby", m_tvStandbyImage, std::move(env));
 }
 
-void CecHookSubsystem::fireTvWake() {
-    auto env = baseEnv("TVWake");
+void CecHookSubsystem::fireTvWake(uint32_t merged) {
+    auto env = baseFields("TVWake");
     env.push_back("CEC_TV_POWER=on");
     env.push_back("CEC_TV_POWER_PREVIOUS=" +
                   std::string{previousPowerString(m_lastTvPower)});
-    submit("TVWake", m_config.tvWake, std::move(env));
+    env.push_back("CEC_EVENT_MERGED=" + std::to_string(merged));
+    submit("TVWake", m_tvWakeImage, std::move(env));
 }
 
 void CecHookSubsystem::fireHostActivated(CEC::cec_logical_address logical) {
-    auto env = baseEnv("HostActivated");
+    auto env = baseFields("HostActivated");
     env.push_back("CEC_HOST_LOGICAL=" +
                   std::to_string(static_cast<int>(logical)));
-    submit("HostActivated", m_config.hostActivated, std::move(env));
+    submit("HostActivated", m_hostActivatedImage, std::move(env));
 }
 
 void CecHookSubsystem::fireHostDeactivated(CEC::cec_logical_address logical) {
-    auto env = baseEnv("HostDeactivated");
+    auto env = baseFields("HostDeactivated");
     env.push_back("CEC_HOST_LOGICAL=" +
                   std::to_string(static_cast<int>(logical)));
-    submit("HostDeactivated", m_config.hostDeactivated, std::move(env));
+    submit("HostDeactivated", m_hostDeactivatedImage, std::move(env));
 }
 
-std::vector<std::string>
-CecHookSubsystem::baseEnv(std::string_view eventName) const {
+std::vector<std::string> CecHookSubsystem::sanitisedParentEnv() {
     std::vector<std::string> env;
-    env.reserve(10);
-
-    // Sanitised parent env — five keys that real-world shell scripts
-    // commonly rely on. Anything else (TZ, DBUS_*, XDG_*, systemd-set
-    // internals) is deliberately stripped: the env contract for hook
-    // scripts should be small and predictable, not a reflection of
-    // whatever the daemon happens to have inherited from its unit.
+    // Five keys that real-world shell scripts commonly rely on.
+    // Anything else (TZ, DBUS_*, XDG_*, systemd-set internals) is
+    // deliberately stripped: the env contract for hook scripts should
+    // be small and predictable, not a reflection of whatever the
+    // daemon happens to have inherited from its unit.
     propagateIfSet(env, {"PATH", "HOME", "LANG", "LC_ALL", "USER"});
+    return env;
+}
+
+std::vector<std::string>
+CecHookSubsystem::baseFields(std::string_view eventName) const {
+    std::vector<std::string> fields;
+    fields.reserve(6);
 
     std::string eventEntry = "CEC_EVENT=";
     eventEntry.append(eventName);
-    env.push_back(std::move(eventEntry));
+    fields.push_back(std::move(eventEntry));
 
-    env.push_back("CEC_EVENT_TS=" + nowIso8601Utc());
-    env.push_back("CEC_DAEMON_PID=" + std::to_string(m_daemonPid));
-    return env;
+    fields.push_back("CEC_EVENT_TS=" + nowIso8601Utc());
+    fields.push_back("CEC_DAEMON_PID=" + std::to_string(m_daemonPid));
+    return fields;
 }
 
 void CecHookSubsystem::submit(std::string_view eventName,
-                               const std::string& scriptPath,
-                               std::vector<std::string> env) {
-    if (scriptPath.empty()) {
+                               const std::shared_ptr<const hook::SpawnImage>& image,
+                               std::vector<std::string> fields) {
+    if (m_helper != nullptr) {
+        m_helper->deliver(fields);
+    }
+    if (!image) {
         // Hook is disabled for this event; emit nothing — a DEBUG line
         // per bus event would flood the log with noise proportional to
         // bus chatter.
         return;
     }
-    LOG_INFO("Firing hook: ", eventName, " -> ", scriptPath);
+    LOG_INFO("Firing hook: ", eventName, " -> ", image->path());
     HookExecutor::Job job;
-    job.path = scriptPath;
-    job.env  = std::move(env);
+    job.name  = std::string(eventName);
+    job.image = image;
+    job.env   = std::move(fields);
     m_executor.submit(std::move(job));
 }
 
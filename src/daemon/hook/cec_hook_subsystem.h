@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -8,11 +9,14 @@
 
 #include "../app_config.h"            // HooksConfig
 #include "../cec/adapter_interface.h" // ICecAdapter::Observation
+#include "hook_debouncer.h"            // hook::Debouncer
+#include "hook_spawn.h"                // hook::SpawnImage
 
 namespace cec_control {
 
 class HookExecutor;
-class TimerSource;
+class HookHelper;
+class LoopTimer;
 
 /**
  * @class CecHookSubsystem
@@ -22,21 +26,24 @@ class TimerSource;
  *
  * ## Threading
  *
- * Main-thread only. @c observe and @c onDebounceTimerFired are both
- * invoked on the event loop — the former by the daemon's adapter-
- * observation forwarder after a @c MainThreadWork hop (the same path
- * @c StandbyPolicy uses), the latter by the loop's handler for the
- * subsystem's own timerfd. Cache state (@c m_pendingPhysical,
+ * Main-thread only. @c observe and the two timer entry points are all
+ * invoked on the event loop — the former by the daemon's
+ * @c ObservationBus on its main-thread drain (the same path
+ * @c StandbyPolicy uses), the latter by the handlers of the
+ * subsystem's own loop timers. Cache state (@c m_pendingPhysical,
  * @c m_lastFiredPhysical, @c m_lastTvPower) is therefore free of
  * atomics or mutexes.
  *
  * Spawn work is handed off to @c HookExecutor; this class never
- * touches @c posix_spawn or any signal primitive directly.
+ * touches @c posix_spawn or any signal primitive directly. When a
+ * @c HookHelper is configured, every event that passes the dedup rule
+ * is also written to it, whether or not a script is set for the event.
  *
  * ## Dedup rule
  *
  * Dedup is per-event last-value, on the main thread. The @c TvStandby
- * and @c TvPowerReport paths fire synchronously inline; the
+ * and @c TvPowerReport paths fire synchronously inline unless
+ * @c TVPowerDebounceMs is set; the
  * @c ActiveSource path runs through a short debounce timer so that
  * startup bursts and AVR ping-pong sequences — where the bus emits
  * several @c ACTIVE_SOURCE / @c ROUTING_CHANGE / @c SET_STREAM_PATH
@@ -64,6 +71,27 @@ class TimerSource;
  *    hook fires and the cache advances. Startup bursts and transient
  *    bus "settling" traffic therefore collapse to a single fire on
  *    the final address, not one fire per observation.
+ *  - With a TV power window, @c TvStandby and @c TvPowerReport(ON)
+ *    only set a pending power state, committed the same way: a TV
+ *    that flaps standby → on inside the window fires nothing, since
+ *    it settled where it started.
+ *
+ * ## Debounce edges
+ *
+ * Each debounced hook has its own @c HookDebounce — window, edge and
+ * max-wait — timed by a @c hook::Debouncer. On the trailing edge the
+ * burst fires once, after the last observation plus the window. On
+ * the leading edge its first observation fires at once, and the end
+ * of the burst fires again only if the state moved on, so a script
+ * sees the first change without waiting and the final state without
+ * missing it. A max-wait closes a burst that long after it opened,
+ * whichever edge is in use.
+ *
+ * Observations absorbed into one firing are not lost from it: the
+ * firing carries @c CEC_EVENT_MERGED, how many observations it
+ * stands for, and an @c InputSwitch firing carries
+ * @c CEC_SOURCE_VIA, the addresses the bus passed through between
+ * @c CEC_SOURCE_PREVIOUS_PHYSICAL and @c CEC_SOURCE_PHYSICAL.
  *  - @c HostActivated / @c HostDeactivated → fire the corresponding
  *    hook with @c CEC_HOST_LOGICAL set to the logical address that
  *    libcec reports transitioned. No cache, no dedup: libcec is the
@@ -75,10 +103,13 @@ class TimerSource;
  *
  * ## Config lifetime
  *
- * @c m_config is captured at construction and never mutated. A future
- * SIGHUP reload path must destroy and rebuild this subsystem rather
- * than patching in place — every dedup decision assumes the config is
- * frozen for the subsystem's lifetime.
+ * @c m_config is captured at construction. A SIGHUP reload replaces
+ * only the five per-event script paths and the debounce settings
+ * through @c setScripts; the
+ * dedup caches and the pending debounce carry over, since they track
+ * the TV rather than the scripts, so a reload neither re-fires nor
+ * swallows an event. The helper path and the executor limits belong
+ * to @c HookHelper and @c HookExecutor and need a restart.
  *
  * ## Why no suspend/resume awareness
  *
@@ -93,24 +124,30 @@ class TimerSource;
 class CecHookSubsystem {
 public:
     /**
-     * @param config          Captured by value; frozen for the
-     *                        subsystem's lifetime.
+     * @param config          Captured by value; only the script
+     *                        paths and debounce settings change
+     *                        afterwards (@c setScripts).
      * @param executor        Non-owning reference to the subsystem
      *                        that will spawn hook children. Must
      *                        outlive this object; enforced at the
      *                        daemon level by destruction order
      *                        (@c m_hooks is reset before
      *                        @c m_hookExecutor).
-     * @param debounceTimer   Non-owning reference to a timerfd
+     * @param debounceTimer   Non-owning reference to a loop timer
      *                        dedicated to this subsystem. The daemon
-     *                        registers its fd with the event loop
-     *                        and arranges for @c onDebounceTimerFired
-     *                        to be called on expiry. Must outlive
+     *                        installs its handler, which calls
+     *                        @c onDebounceTimerFired on expiry. Must outlive
      *                        this object.
+     * @param tvPowerTimer    The same, for the TV power window;
+     *                        its handler calls @c onTvPowerTimerFired.
+     * @param helper          Non-owning; null when no @c Helper is
+     *                        configured. Must outlive this object.
      */
     CecHookSubsystem(HooksConfig config,
                      HookExecutor& executor,
-                     TimerSource& debounceTimer);
+                     LoopTimer& debounceTimer,
+                     LoopTimer& tvPowerTimer,
+                     HookHelper* helper = nullptr);
 
     CecHookSubsystem(const CecHookSubsystem&)            = delete;
     CecHookSubsystem& operator=(const CecHookSubsystem&) = delete;
@@ -119,28 +156,46 @@ public:
 
     /**
      * Consume one CEC observation. Applies the dedup rule above and,
-     * for @c ActiveSource, (re)arms the debounce timer; the other
-     * kinds fire synchronously inline. Main thread only.
+     * for a hook with a debounce window, (re)arms its timer; the
+     * other kinds fire synchronously inline. Main thread only.
      */
     void observe(const ICecAdapter::Observation& obs);
 
     /**
      * Timer-fire entry point for the @c ActiveSource debounce. The
-     * daemon's event-loop handler calls this when the configured
-     * timerfd becomes readable. Commits the pending address if the
-     * read reports a real expiration (see @c TimerSource::consume);
-     * a zero expiration is treated as a racy supersede-then-read
-     * and the commit is skipped — the fresh arming will commit its
-     * own state when it fires. Main thread only.
+     * daemon's timer handler calls this when the configured timer
+     * expires. Commits the pending address if @c LoopTimer::consume
+     * reports a real expiration; a zero count is treated as a
+     * superseded arming and the commit is skipped — the fresh
+     * arming will commit its own state when it fires. Main thread only.
      */
     void onDebounceTimerFired();
 
+    /** The @c onDebounceTimerFired counterpart for the TV power window. */
+    void onTvPowerTimerFired();
+
+    /**
+     * Adopt the per-event script paths and debounce settings of
+     * @p config; its helper and limits are ignored. An event fired
+     * after this call runs the new script; children already running
+     * or queued finish as submitted, and an open burst keeps the
+     * deadline it was armed with.
+     * Main thread only.
+     */
+    void setScripts(const HooksConfig& config);
+
+    /**
+     * The parent-environment part of every hook child's environment:
+     * @c PATH, @c HOME, @c LANG, @c LC_ALL, @c USER, each if set.
+     */
+    [[nodiscard]] static std::vector<std::string> sanitisedParentEnv();
+
 private:
     enum class CachedPower { Unknown, On, Standby };
 
     void fireInputSwitch(uint16_t newAddr);
-    void fireTvStandby();
-    void fireTvWake();
+    void fireTvStandby(uint32_t merged);
+    void fireTvWake(uint32_t merged);
     void fireHostActivated(CEC::cec_logical_address logical);
     void fireHostDeactivated(CEC::cec_logical_address logical);
 
@@ -152,24 +207,40 @@ private:
      */
     void commitPending();
 
+    /** The @c commitPending counterpart for the pending TV power state. */
+    void commitTvPower();
+
+    /**
+     * Feed one observation to @p debouncer and arm @p timer for the
+     * burst's deadline.
+     * @return @c true if the caller should commit now: the window is
+     *         zero, the observation opened a leading-edge burst, or
+     *         the timer could not be armed.
+     */
+    bool debounce(hook::Debouncer& debouncer, LoopTimer& timer);
+
     /**
-     * Build the common base of the child environment: the sanitised
-     * parent env (@c PATH, @c HOME, @c LANG, @c LC_ALL, @c USER if
-     * set) plus @c CEC_EVENT, @c CEC_EVENT_TS, @c CEC_DAEMON_PID.
-     * Each entry is a @c "KEY=VALUE" string; the caller appends
-     * per-event additions before submitting.
+     * Build the fields every event carries: @c CEC_EVENT,
+     * @c CEC_EVENT_TS, @c CEC_DAEMON_PID. Each entry is a
+     * @c "KEY=VALUE" string; the caller appends per-event additions
+     * before submitting.
      */
-    [[nodiscard]] std::vector<std::string> baseEnv(std::string_view eventName) const;
+    [[nodiscard]] std::vector<std::string> baseFields(std::string_view eventName) const;
+
+    /** A spawn image per configured script of @c m_config; null for an empty path. */
+    void buildImages();
 
     /**
-     * Submit the job if @p scriptPath is non-empty; no-op otherwise.
+     * Hand @p fields to the helper, if any, and submit the job if
+     * @p image is set; the image puts the sanitised parent env in
+     * front of @p fields.
      * Non-const: spawning a child is a visible side effect on the
      * outside world even though no class member is mutated, so
      * marking this @c const would read wrong to a reviewer.
      */
     void submit(std::string_view eventName,
-                const std::string& scriptPath,
-                std::vector<std::string> env);
+                const std::shared_ptr<const hook::SpawnImage>& image,
+                std::vector<std::string> fields);
 
     /**
      * Textual form of a cached-power tag for the @c CEC_TV_POWER_PREVIOUS
@@ -180,9 +251,22 @@ private:
 
     HooksConfig         m_config;
     HookExecutor&       m_executor;
-    TimerSource&        m_debounceTimer;
+    LoopTimer&          m_debounceTimer;
+    LoopTimer&          m_tvPowerTimer;
+    HookHelper*         m_helper;
     const int           m_daemonPid;
 
+    // One per event, rebuilt with the script paths: the path and the
+    // parent env, packed once so a firing adds only its own fields.
+    // Shared with queued jobs, which keep the image they were
+    // submitted with across a reload.
+    const std::vector<std::string>          m_parentEnv;
+    std::shared_ptr<const hook::SpawnImage> m_inputSwitchImage;
+    std::shared_ptr<const hook::SpawnImage> m_tvStandbyImage;
+    std::shared_ptr<const hook::SpawnImage> m_tvWakeImage;
+    std::shared_ptr<const hook::SpawnImage> m_hostActivatedImage;
+    std::shared_ptr<const hook::SpawnImage> m_hostDeactivatedImage;
+
     // Active-source state split across the debounce boundary:
     //
     //  - @c m_pendingPhysical is written by @c observe every time an
@@ -199,6 +283,17 @@ private:
     std::optional<uint16_t> m_pendingPhysical;
     std::optional<uint16_t> m_lastFiredPhysical;
     CachedPower             m_lastTvPower = CachedPower::Unknown;
+
+    // What the open bursts have absorbed since their last commit:
+    // the addresses the active source passed through, in order and
+    // without repeats, and how many observations each burst holds.
+    // @c m_pendingTvPower is @c Unknown while no power change waits.
+    hook::Debouncer         m_inputSwitchDebouncer;
+    hook::Debouncer         m_tvPowerDebouncer;
+    std::vector<uint16_t>   m_sourceTrail;
+    uint32_t                m_sourceMerged   = 0;
+    CachedPower             m_pendingTvPower = CachedPower::Unknown;
+    uint32_t                m_tvPowerMerged  = 0;
 };
 
 } // namespace cec_control
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../app_config.h"  // HookDebounce
+
+#include <algorithm>
+#include <chrono>
+
+namespace cec_control {
+
+namespace hook {
+
+/**
+ * The timing half of one hook's debounce: when a burst opens, when it
+ * closes, and whether an observation fires at once. It holds no event
+ * state — the subsystem keeps the pending value and arms its
+ * @c LoopTimer for @c remaining after each @c observe, then calls
+ * @c close from the timer's handler.
+ *
+ * A burst's deadline is pushed back by every observation, but never
+ * past @c maxWaitMs after the observation that opened it, so a bus
+ * that keeps chattering still produces a firing at that cadence.
+ */
+class Debouncer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Debouncer(const HookDebounce& policy = {}) noexcept : m_policy(policy) {}
+
+    /** Takes effect from the next observation; an open burst keeps its deadline. */
+    void setPolicy(const HookDebounce& policy) noexcept { m_policy = policy; }
+    [[nodiscard]] const HookDebounce& policy() const noexcept { return m_policy; }
+
+    /** @c true when the window is zero and every observation fires inline. */
+    [[nodiscard]] bool immediate() const noexcept { return m_policy.windowMs == 0; }
+
+    /**
+     * Note an observation at @p now, opening a burst if none is open.
+     * @return @c true if it opened a burst under the leading edge: the
+     *         caller fires now, and again at @c close only if the
+     *         state has changed since.
+     */
+    bool observe(Clock::time_point now) noexcept {
+        const bool opens = !m_open;
+        if (opens) {
+            m_open       = true;
+            m_burstStart = now;
+        }
+        m_deadline = now + std::chrono::milliseconds(m_policy.windowMs);
+        if (m_policy.maxWaitMs != 0) {
+            m_deadline = std::min(m_deadline,
+                                  m_burstStart + std::chrono::milliseconds(m_policy.maxWaitMs));
+        }
+        return opens && m_policy.edge == HookDebounce::Edge::Leading;
+    }
+
+    /** Time from @p now to the open burst's deadline, rounded up; zero once it has passed. */
+    [[nodiscard]] std::chrono::milliseconds remaining(Clock::time_point now) const noexcept {
+        if (m_deadline <= now) return std::chrono::milliseconds(0);
+        return std::chrono::ceil<std::chrono::milliseconds>(m_deadline - now);
+    }
+
+    /** End the burst; the next observation opens a new one. */
+    void close() noexcept { m_open = false; }
+
+    [[nodiscard]] bool open() const noexcept { return m_open; }
+
+private:
+    HookDebounce      m_policy;
+    bool              m_open = false;
+    Clock::time_point m_burstStart{};
+    Clock::time_point m_deadline{};
+};
+
+} // namespace hook
+
+} // namespace cec_control
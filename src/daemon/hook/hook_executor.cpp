@@ -1,147 +1,85 @@
 #include "hook_executor.h"
 
 #include "../../common/logger.h"
+#include "../metrics.h"
+#include "hook_spawn.h"
 
-#include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
-#include <spawn.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
 #include <cstring>
 #include <utility>
-#include <vector>
 
 namespace cec_control {
 
 namespace {
 
-/**
- * RAII wrapper around @c posix_spawnattr_t so an early return path
- * cannot leak the structure. Plain @c posix_spawn_file_actions_t gets
- * the same treatment — both are trivially destructible from libc's
- * standpoint but require an explicit destroy call on some platforms.
- */
-class SpawnAttr {
-public:
-    SpawnAttr() {
-        m_ok = ::posix_spawnattr_init(&m_attr) == 0;
-    }
-    ~SpawnAttr() {
-        if (m_ok) ::posix_spawnattr_destroy(&m_attr);
-    }
-    SpawnAttr(const SpawnAttr&)            = delete;
-    SpawnAttr& operator=(const SpawnAttr&) = delete;
-
-    [[nodiscard]] bool valid() const noexcept { return m_ok; }
-    posix_spawnattr_t* get() noexcept { return &m_attr; }
-
-private:
-    posix_spawnattr_t m_attr{};
-    bool              m_ok{false};
-};
-
-class SpawnFileActions {
-public:
-    SpawnFileActions() {
-        m_ok = ::posix_spawn_file_actions_init(&m_actions) == 0;
-    }
-    ~SpawnFileActions() {
-        if (m_ok) ::posix_spawn_file_actions_destroy(&m_actions);
-    }
-    SpawnFileActions(const SpawnFileActions&)            = delete;
-    SpawnFileActions& operator=(const SpawnFileActions&) = delete;
-
-    [[nodiscard]] bool valid() const noexcept { return m_ok; }
-    posix_spawn_file_actions_t* get() noexcept { return &m_actions; }
-
-private:
-    posix_spawn_file_actions_t m_actions{};
-    bool                       m_ok{false};
-};
-
-/**
- * Issue one @c posix_spawn call for @p job. Logs and returns on error;
- * on success the child is running and the daemon will see the
- * eventual SIGCHLD via its signalfd.
- */
-void spawnOne(HookExecutor::Job& job) {
-    SpawnAttr attr;
-    SpawnFileActions actions;
-    if (!attr.valid() || !actions.valid()) {
-        LOG_WARNING("Hook spawn setup failed for ", job.path,
-                    ": posix_spawnattr/file_actions init failed");
-        return;
-    }
+// Raw syscalls: the glibc wrappers only arrived in 2.36, well after
+// the kernel interface (5.3 / 5.1).
+int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
 
-    // Undo the daemon's inherited SIG_BLOCK mask so the child sees a
-    // normal signal environment. Without this, shell scripts spawned
-    // from the daemon would inherit the blocked set and behave oddly
-    // under @c trap.
-    sigset_t emptyMask;
-    sigemptyset(&emptyMask);
-    if (::posix_spawnattr_setsigmask(attr.get(), &emptyMask) != 0 ||
-        ::posix_spawnattr_setflags(attr.get(), POSIX_SPAWN_SETSIGMASK) != 0) {
-        LOG_WARNING("Hook spawn setup failed for ", job.path,
-                    ": posix_spawnattr_setsigmask failed");
-        return;
-    }
+bool signalPidfd(int pidfd, int signum) {
+#ifdef SYS_pidfd_send_signal
+    return ::syscall(SYS_pidfd_send_signal, pidfd, signum, nullptr, 0) == 0;
+#else
+    (void)pidfd;
+    (void)signum;
+    errno = ENOSYS;
+    return false;
+#endif
+}
 
-    // Hook scripts must not read from the daemon's stdin — under
-    // systemd stdin is already closed, but belt-and-braces for the
-    // foreground / dev case where a stray @c read would otherwise
-    // hang forever on a terminal.
-    if (::posix_spawn_file_actions_addopen(
-            actions.get(), STDIN_FILENO, "/dev/null", O_RDONLY, 0) != 0) {
-        LOG_WARNING("Hook spawn setup failed for ", job.path,
-                    ": posix_spawn_file_actions_addopen(/dev/null) failed");
-        return;
-    }
-    // Stdout and stderr deliberately inherit: under systemd journald
-    // captures them under the daemon's unit; under a foreground run
-    // they reach the operator's terminal. Either is correct.
-
-    // posix_spawn takes char*[] (not const); std::string::data()
-    // returns a mutable char* in C++17 and posix_spawn does not
-    // modify its argv/envp. The job owns the backing strings until
-    // this function returns, which is after posix_spawn has copied
-    // the pointers into the child.
-    char*               argv0 = job.path.data();
-    std::vector<char*>  argv{argv0, nullptr};
-
-    std::vector<char*> envp;
-    envp.reserve(job.env.size() + 1);
-    for (auto& entry : job.env) {
-        envp.push_back(entry.data());
-    }
-    envp.push_back(nullptr);
-
-    pid_t pid = 0;
-    const int rc = ::posix_spawn(&pid, job.path.c_str(),
-                                  actions.get(), attr.get(),
-                                  argv.data(), envp.data());
-    if (rc != 0) {
-        LOG_WARNING("Hook spawn failed for ", job.path, ": ",
-                    std::strerror(rc));
-        return;
-    }
-    LOG_DEBUG("Hook spawned pid=", pid, " path=", job.path);
+void wake(int fd) {
+    const uint64_t one = 1;
+    // Only fails with EAGAIN on counter overflow, which still leaves
+    // the fd readable.
+    (void)!::write(fd, &one, sizeof(one));
 }
 
 } // namespace
 
+HookExecutor::HookExecutor(Limits limits) : m_limits(limits) {}
+
 HookExecutor::~HookExecutor() {
     stop();
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
 }
 
-void HookExecutor::start() {
+bool HookExecutor::start(ThreadSchedule schedule) {
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_started) return;
+    if (m_started) return true;
+    if (m_wakeFd < 0) {
+        m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_wakeFd < 0) {
+            LOG_ERROR("Failed to create HookExecutor eventfd: ", std::strerror(errno));
+            return false;
+        }
+    }
     // Spawn before latching m_started: if std::thread's constructor
     // throws (resource exhaustion), the object stays in its unstarted
     // state and a later retry / destructor walks a consistent path.
-    m_thread  = std::thread(&HookExecutor::run, this);
-    m_started = true;
+    m_schedule = std::move(schedule);
+    const ScopedThreadStack stack(m_schedule.stackKiB, "cec-hook-exec");
+    m_thread   = std::thread(&HookExecutor::run, this);
+    m_started  = true;
+    return true;
 }
 
 void HookExecutor::stop() {
@@ -149,56 +87,211 @@ void HookExecutor::stop() {
         std::lock_guard<std::mutex> lock(m_mutex);
         if (m_stopRequested) return;
         m_stopRequested = true;
+        if (m_wakeFd >= 0) wake(m_wakeFd);
     }
-    m_cv.notify_one();
     if (m_thread.joinable()) {
         m_thread.join();
     }
 }
 
 void HookExecutor::submit(Job job) {
-    if (job.path.empty()) return;
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_stopRequested) return;
-        m_jobs.push(std::move(job));
+    if (!job.image) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopRequested || m_wakeFd < 0) return;
+
+    auto& queue =
+        m_queues.try_emplace(job.name, m_limits.coalesce ? 1 : kMaxQueuedPerGroup).first->second;
+    std::size_t discarded = 0;
+    if (m_limits.coalesce) {
+        discarded = queue.size();
+        queue.clear();
+    } else if (queue.size() >= kMaxQueuedPerGroup) {
+        queue.pop_front();
+        discarded = 1;
+    }
+    if (discarded > 0) {
+        LOG_DEBUG("Hook ", job.name, ": ", discarded,
+                  " waiting job(s) superseded by a newer event");
+        Metrics::getInstance().increment(Metrics::Counter::HookJobsDiscarded, discarded);
     }
-    m_cv.notify_one();
+    queue.push_back(std::move(job));
+    wake(m_wakeFd);
 }
 
 void HookExecutor::run() {
     // Identifiable in `top -H` and `gdb thread apply all bt`. Kernel
     // truncates silently to 15 bytes.
     ::pthread_setname_np(::pthread_self(), "cec-hook-exec");
+    // SCHED_RESET_ON_FORK: the scripts this thread spawns are ordinary
+    // work and must not inherit a realtime policy or a negative nice.
+    // A positive nice carries over to them; the kernel only resets the
+    // negative kind, and raising a child back needs CAP_SYS_NICE.
+    if (!m_schedule.isDefault()) {
+        applyThreadSchedule(m_schedule, "cec-hook-exec", /*resetOnFork=*/true);
+    }
 
+    std::vector<pollfd> fds;
     while (true) {
-        Job job;
         {
-            std::unique_lock<std::mutex> lock(m_mutex);
-            m_cv.wait(lock, [this] {
-                return m_stopRequested || !m_jobs.empty();
-            });
+            std::lock_guard<std::mutex> lock(m_mutex);
             if (m_stopRequested) {
                 // Matches AdapterWorker::run: jobs queued but not yet
                 // spawned are dropped on stop. The main thread is
                 // already quitting; spawning now would only produce
                 // zombies that init reaps.
-                std::queue<Job> dropped;
-                dropped.swap(m_jobs);
+                m_queues.clear();
                 break;
             }
-            job = std::move(m_jobs.front());
-            m_jobs.pop();
         }
 
         try {
-            spawnOne(job);
+            spawnReady();
         } catch (const std::exception& e) {
             LOG_ERROR("HookExecutor spawn threw: ", e.what());
         } catch (...) {
             LOG_ERROR("HookExecutor spawn threw non-std exception");
         }
+
+        fds.clear();
+        fds.push_back(pollfd{m_wakeFd, POLLIN, 0});
+        for (const auto& child : m_children) {
+            fds.push_back(pollfd{child.pidfd, POLLIN, 0});
+        }
+        const int ready = ::poll(fds.data(), fds.size(), pollTimeoutMs());
+        if (ready < 0 && errno != EINTR) {
+            LOG_ERROR("HookExecutor poll failed: ", std::strerror(errno));
+            break;
+        }
+
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) {
+                uint64_t count = 0;
+                (void)!::read(m_wakeFd, &count, sizeof(count));
+            }
+            // Back to front, so erasing keeps the remaining indices
+            // lined up with their pollfd.
+            for (std::size_t i = m_children.size(); i-- > 0;) {
+                if (fds[i + 1].revents != 0) finishChild(i);
+            }
+        }
+        enforceDeadlines();
+    }
+
+    for (const auto& child : m_children) {
+        ::close(child.pidfd);
+    }
+    m_children.clear();
+    m_running.clear();
+    Metrics::getInstance().set(Metrics::Gauge::HookChildrenRunning, 0);
+}
+
+void HookExecutor::spawnReady() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& [name, queue] : m_queues) {
+            const std::size_t running = m_running[name];
+            std::size_t room = queue.size();
+            if (m_limits.maxConcurrent != 0) {
+                room = std::min(room, m_limits.maxConcurrent -
+                                          std::min(running, m_limits.maxConcurrent));
+            }
+            for (; room > 0; --room) {
+                m_ready.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+    }
+    for (const auto& job : m_ready) {
+        spawnJob(job);
+    }
+    m_ready.clear();
+}
+
+void HookExecutor::spawnJob(const Job& job) {
+    pid_t pid = -1;
+    {
+        ScopedLatency timer(Metrics::Latency::HookSpawn);
+        job.image->composeEnv(job.env, m_envp);
+        pid = hook::spawnChild(*job.image, m_envp.data());
+    }
+    if (pid < 0) {
+        Metrics::getInstance().increment(Metrics::Counter::HookSpawnFailures);
+        return;
+    }
+    Metrics::getInstance().increment(Metrics::Counter::HookSpawns);
+    LOG_DEBUG("Hook spawned pid=", pid, " path=", job.image->path());
+
+    // The child cannot have been reaped yet unless it has already
+    // exited, in which case pidfd_open fails with ESRCH and there is
+    // nothing to watch. The pid cannot have been reused in between:
+    // that would take the pid space wrapping in the same window.
+    const int pidfd = openPidfd(pid);
+    if (pidfd < 0) {
+        if (errno != ESRCH) {
+            static bool warned = false;
+            if (!std::exchange(warned, true)) {
+                LOG_WARNING("pidfd_open unavailable (", std::strerror(errno),
+                            "); hook concurrency and timeout limits are not enforced");
+            }
+        }
+        return;
+    }
+
+    const auto now = Clock::now();
+    const auto deadline = m_limits.timeout.count() > 0 ? now + m_limits.timeout
+                                                       : Clock::time_point::max();
+    m_children.push_back(Child{job.name, pid, pidfd, now, deadline});
+    ++m_running[job.name];
+    Metrics::getInstance().set(Metrics::Gauge::HookChildrenRunning,
+                               static_cast<int64_t>(m_children.size()));
+}
+
+void HookExecutor::finishChild(std::size_t index) {
+    Child& child = m_children[index];
+    Metrics::getInstance().record(Metrics::Latency::HookRunTime,
+                                  Clock::now() - child.started);
+    ::close(child.pidfd);
+
+    auto it = m_running.find(child.name);
+    if (it != m_running.end() && --it->second == 0) {
+        m_running.erase(it);
+    }
+    m_children.erase(m_children.begin() + static_cast<std::ptrdiff_t>(index));
+    Metrics::getInstance().set(Metrics::Gauge::HookChildrenRunning,
+                               static_cast<int64_t>(m_children.size()));
+}
+
+void HookExecutor::enforceDeadlines() {
+    const auto now = Clock::now();
+    for (auto& child : m_children) {
+        if (child.deadline > now) continue;
+        if (!child.terminated) {
+            LOG_WARNING("Hook ", child.name, " pid=", child.pid, " exceeded ",
+                        m_limits.timeout.count(), "ms; sending SIGTERM");
+            Metrics::getInstance().increment(Metrics::Counter::HookTimeouts);
+            (void)signalPidfd(child.pidfd, SIGTERM);
+            child.terminated = true;
+            child.deadline   = now + kKillGrace;
+        } else {
+            LOG_WARNING("Hook ", child.name, " pid=", child.pid,
+                        " ignored SIGTERM; sending SIGKILL");
+            (void)signalPidfd(child.pidfd, SIGKILL);
+            child.deadline = Clock::time_point::max();
+        }
+    }
+}
+
+int HookExecutor::pollTimeoutMs() const {
+    auto nearest = Clock::time_point::max();
+    for (const auto& child : m_children) {
+        nearest = std::min(nearest, child.deadline);
     }
+    if (nearest == Clock::time_point::max()) return -1;
+    const auto remaining = nearest - Clock::now();
+    if (remaining <= Clock::duration::zero()) return 0;
+    // Round up, so the wake-up is never early and spins.
+    return static_cast<int>(
+        std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
 }
 
 void hook::reapChildren() noexcept {
@@ -1,27 +1,51 @@
 #pragma once
 
-#include <condition_variable>
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
+#include "../../common/ring_queue.h"
+#include "../thread_schedule.h"
+#include "hook_spawn.h"
+
 namespace cec_control {
 
 /**
  * @class HookExecutor
- * @brief Dedicated thread that drains a queue of @c Job values and
- *        @c posix_spawn s each one. Fire-and-forget: no result is
- *        returned, no child PID is tracked beyond a debug log.
+ * @brief Dedicated thread that drains a queue of @c Job values,
+ *        @c posix_spawn s each one and watches the children it
+ *        started. Fire-and-forget from the caller's side: no result is
+ *        returned and no PID is surfaced.
  *
  * ## Why a dedicated thread
  *
- * @c posix_spawn is usually fast but not free — on a process of this
- * size (libcec, udev, sd-bus mappings) the underlying fork can
- * momentarily stall on kernel page-table duplication. Running it on
- * its own thread keeps the main loop snappy and isolates libcec's
- * worker from subprocess launch jitter.
+ * @c posix_spawn is usually fast but not free. It spawns with
+ * @c CLONE_VM | @c CLONE_VFORK, so no page tables are copied, but the
+ * exec itself and the wait for it still take time. Running it on its
+ * own thread keeps the main loop snappy and isolates libcec's worker
+ * from subprocess launch jitter.
+ *
+ * ## Limits
+ *
+ * Jobs are grouped by @c Job::name (one group per hook event). At most
+ * @c Limits::maxConcurrent children of a group run at once; further
+ * jobs wait in the group's queue and start as running ones exit. With
+ * @c Limits::coalesce a waiting job is replaced by a newer one, so a
+ * flapping input runs the script once more with the final state rather
+ * than once per flap. A child still running after @c Limits::timeout
+ * is sent @c SIGTERM, and @c SIGKILL @c kKillGrace later.
+ *
+ * Children are watched through pidfds, which stay valid after the
+ * main thread's @c reapChildren has collected the exit status, so the
+ * two never race over a pid. On a kernel without @c pidfd_open (before
+ * 5.3) children are spawned but not watched: no cap, no timeout.
  *
  * ## Threading contract
  *
@@ -41,17 +65,40 @@ namespace cec_control {
 class HookExecutor {
 public:
     /**
-     * A single spawn request. @c env holds @c "KEY=VALUE" strings and
-     * outlives the spawn call — the worker synthesises a @c char*[]
-     * from the strings' @c data() pointers and passes it to
-     * @c posix_spawn, which copies the pointers into the child.
+     * A single spawn request. @c image carries the script path and the
+     * environment entries every run of the script shares; @c env holds
+     * this run's own @c "KEY=VALUE" strings, appended after them. Both
+     * outlive the spawn call — the worker points a @c char*[] at them
+     * and passes it to @c posix_spawn, which copies the strings into
+     * the child. @c name selects the group the limits apply to.
      */
     struct Job {
-        std::string              path;
-        std::vector<std::string> env;
+        std::string                             name;
+        std::shared_ptr<const hook::SpawnImage> image;
+        std::vector<std::string>                env;
+    };
+
+    /** Per-group limits; see the class comment. */
+    struct Limits {
+        /** Children of one group running at once; 0 = unlimited. */
+        std::size_t               maxConcurrent = 0;
+        /** Keep only the newest waiting job of a group. */
+        bool                      coalesce      = false;
+        /** Run time before @c SIGTERM; zero = unlimited. */
+        std::chrono::milliseconds timeout{0};
     };
 
-    HookExecutor()  = default;
+    /** Time between @c SIGTERM and @c SIGKILL for a timed-out child. */
+    static constexpr auto kKillGrace = std::chrono::seconds(2);
+
+    /**
+     * Waiting jobs per group without @c coalesce; the oldest goes first.
+     * Also the size each group's queue is allocated at, once, when its
+     * first job arrives.
+     */
+    static constexpr std::size_t kMaxQueuedPerGroup = 16;
+
+    explicit HookExecutor(Limits limits);
     ~HookExecutor();
 
     HookExecutor(const HookExecutor&)            = delete;
@@ -59,14 +106,21 @@ public:
     HookExecutor(HookExecutor&&)                 = delete;
     HookExecutor& operator=(HookExecutor&&)      = delete;
 
-    /** Spawn the exec thread. Idempotent; main thread only. */
-    void start();
+    /**
+     * Spawn the exec thread, with a stack of @p schedule's @c stackKiB,
+     * which applies @p schedule to itself first.
+     * Hook processes it spawns start at normal priority regardless.
+     * Idempotent; main thread only. Returns false, after logging, if
+     * its wake-up eventfd cannot be created.
+     */
+    bool start(ThreadSchedule schedule = {});
 
     /**
      * Signal stop; join the exec thread; drop any queued but unspawned
-     * jobs. Already-spawned children are not tracked — they continue
-     * running and, when they exit after the daemon has quit, are
-     * reaped by @c init (pid 1). Idempotent; main thread only.
+     * jobs. Already-spawned children stop being watched — they continue
+     * running, without a timeout, and when they exit after the daemon
+     * has quit are reaped by @c init (pid 1). Idempotent; main thread
+     * only.
      */
     void stop();
 
@@ -78,13 +132,52 @@ public:
     void submit(Job job);
 
 private:
+    using Clock = std::chrono::steady_clock;
+
+    /** A child this thread started and is watching. */
+    struct Child {
+        std::string       name;
+        pid_t             pid;
+        int               pidfd;
+        Clock::time_point started;
+        /** Next escalation; @c time_point::max() when there is none. */
+        Clock::time_point deadline;
+        bool              terminated = false;  ///< SIGTERM already sent.
+    };
+
     void run();
 
-    mutable std::mutex      m_mutex;
-    std::condition_variable m_cv;
-    std::queue<Job>         m_jobs;
-    bool                    m_stopRequested = false;
-    bool                    m_started       = false;
+    /** Exec thread: start every waiting job its group has room for. */
+    void spawnReady();
+
+    /** Exec thread: spawn @p job and, if it can be watched, track it. */
+    void spawnJob(const Job& job);
+
+    /** Exec thread: forget @c m_children[index], which has exited. */
+    void finishChild(std::size_t index);
+
+    /** Exec thread: signal every child past its deadline. */
+    void enforceDeadlines();
+
+    /** Exec thread: poll timeout for the nearest deadline, or -1. */
+    [[nodiscard]] int pollTimeoutMs() const;
+
+    const Limits m_limits;
+    // Written by start() before the thread exists; read by it once.
+    ThreadSchedule m_schedule;
+
+    mutable std::mutex m_mutex;
+    // One queue per group, kept once created so that it is allocated once.
+    std::unordered_map<std::string, RingQueue<Job>> m_queues;
+    bool m_stopRequested = false;
+    bool m_started       = false;
+    int  m_wakeFd        = -1;  ///< eventfd; submit() and stop() write it.
+
+    // Exec thread only.
+    std::vector<char*>                           m_envp;  ///< Reused for every spawn.
+    std::vector<Job>                             m_ready; ///< spawnReady's batch, reused.
+    std::vector<Child>                           m_children;
+    std::unordered_map<std::string, std::size_t> m_running;  ///< Watched children per group.
 
     // Last field so the thread is joined before the synchronisation
     // primitives above are destroyed on an unexpected destruction path
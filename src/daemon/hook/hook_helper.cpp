@@ -0,0 +1,162 @@
+#include "hook_helper.h"
+
+#include "../../common/event_poller.h"
+#include "../../common/logger.h"
+#include "../metrics.h"
+#include "hook_spawn.h"
+
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace cec_control {
+
+namespace {
+
+constexpr std::uint32_t READ_BIT  = static_cast<std::uint32_t>(EventPoller::Event::READ);
+constexpr std::uint32_t WRITE_BIT = static_cast<std::uint32_t>(EventPoller::Event::WRITE);
+
+} // namespace
+
+HookHelper::HookHelper(EventLoop& loop, std::string path, std::vector<std::string> env)
+    : m_loop(loop), m_path(std::move(path)), m_env(std::move(env)) {}
+
+HookHelper::~HookHelper() {
+    stop();
+}
+
+bool HookHelper::start() {
+    m_stopped = false;
+    return m_socket.valid() || spawn();
+}
+
+void HookHelper::stop() {
+    m_stopped = true;
+    disconnect();
+}
+
+bool HookHelper::spawn() {
+    m_lastSpawn = std::chrono::steady_clock::now();
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        LOG_WARNING("Hook helper socketpair failed: ", std::strerror(errno));
+        return false;
+    }
+    UnixSocket ours(fds[0]);
+    UnixSocket theirs(fds[1]);  // closed here once the child has its copy
+
+    const pid_t pid = hook::spawnChild(m_path, m_env, theirs.get());
+    Metrics::getInstance().increment(pid >= 0 ? Metrics::Counter::HookSpawns
+                                              : Metrics::Counter::HookSpawnFailures);
+    if (pid < 0) return false;
+
+    if (!m_loop.add(ours.get(), READ_BIT,
+                    [this](std::uint32_t events) { onSocketEvent(events); })) {
+        LOG_WARNING("Failed to register hook helper socket with event loop");
+        return false;  // closing ours gives the helper end of input
+    }
+    m_socket     = std::move(ours);
+    m_pid        = pid;
+    m_writeArmed = false;
+    LOG_INFO("Hook helper started: pid=", pid, " path=", m_path);
+    return true;
+}
+
+void HookHelper::deliver(const std::vector<std::string>& fields) {
+    if (m_stopped || fields.empty()) return;
+
+    if (!m_socket.valid()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (m_lastSpawn && now - *m_lastSpawn < kRespawnDelay) {
+            LOG_DEBUG("Hook helper not running; event dropped");
+            Metrics::getInstance().increment(Metrics::Counter::HookEventsDropped);
+            return;
+        }
+        if (!spawn()) {
+            Metrics::getInstance().increment(Metrics::Counter::HookEventsDropped);
+            return;
+        }
+    }
+
+    std::string line;
+    for (const auto& field : fields) {
+        if (!line.empty()) line.push_back('\t');
+        line.append(field);
+    }
+    line.push_back('\n');
+
+    if (m_outbound.size() + line.size() > kMaxBufferedBytes) {
+        LOG_DEBUG("Hook helper is not keeping up; event dropped");
+        Metrics::getInstance().increment(Metrics::Counter::HookEventsDropped);
+        return;
+    }
+    m_outbound.append(line);
+    Metrics::getInstance().increment(Metrics::Counter::HookEventsDelivered);
+    if (!m_writeArmed) (void)flush();
+}
+
+bool HookHelper::flush() {
+    while (!m_outbound.empty()) {
+        const ssize_t sent = ::send(m_socket.get(), m_outbound.data(), m_outbound.size(),
+                                    MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            LOG_WARNING("Hook helper pid=", m_pid, " stopped reading (",
+                        std::strerror(errno), "); will respawn on the next event");
+            disconnect();
+            return false;
+        }
+        m_outbound.erase(0, static_cast<std::size_t>(sent));
+    }
+
+    const bool wantWrite = !m_outbound.empty();
+    if (wantWrite != m_writeArmed) {
+        if (!m_loop.modify(m_socket.get(), READ_BIT | (wantWrite ? WRITE_BIT : 0))) {
+            LOG_WARNING("Hook helper socket modify failed; dropping helper");
+            disconnect();
+            return false;
+        }
+        m_writeArmed = wantWrite;
+    }
+    return true;
+}
+
+void HookHelper::onSocketEvent(std::uint32_t events) {
+    if (events & READ_BIT) {
+        // The protocol is one-way; anything the helper writes back is
+        // discarded. End of file means it has closed its stdin, which
+        // in practice means it exited.
+        char scratch[256];
+        ssize_t n = 0;
+        do {
+            n = ::recv(m_socket.get(), scratch, sizeof(scratch), MSG_DONTWAIT);
+        } while (n > 0 || (n < 0 && errno == EINTR));
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            LOG_WARNING("Hook helper pid=", m_pid,
+                        " exited; will respawn on the next event");
+            disconnect();
+            return;
+        }
+    }
+    if (events & WRITE_BIT) {
+        if (!flush()) return;
+    }
+    if (events & EventPoller::ERROR_EVENTS) {
+        disconnect();
+    }
+}
+
+void HookHelper::disconnect() {
+    if (!m_socket.valid()) return;
+    m_loop.remove(m_socket.get());
+    m_socket.reset();
+    m_outbound.clear();
+    m_writeArmed = false;
+    m_pid        = -1;
+}
+
+} // namespace cec_control
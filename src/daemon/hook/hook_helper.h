@@ -0,0 +1,112 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../../common/event_loop.h"
+#include "../../common/unix_socket.h"
+
+namespace cec_control {
+
+/**
+ * @class HookHelper
+ * @brief Long-running co-process that receives every hook event as one
+ *        line on its stdin — the alternative to a @c posix_spawn per
+ *        event through @c HookExecutor.
+ *
+ * The helper is spawned once, with the same sanitised environment hook
+ * scripts get and a stream socket as its stdin. Each event is written
+ * as a single line of tab-separated @c KEY=VALUE fields — exactly the
+ * @c CEC_* variables a script for that event would see, @c CEC_EVENT
+ * first — so a helper is typically a @c while @c read loop or a small
+ * daemon of its own. End of input means the daemon is shutting down.
+ *
+ * ## Threading
+ *
+ * Main-thread only: @c deliver is called by @c CecHookSubsystem and
+ * the socket is serviced by the event loop. Writes never block. Lines
+ * the helper has not yet read wait in a buffer of
+ * @c kMaxBufferedBytes; events that do not fit are dropped whole and
+ * counted, so a stalled helper costs the daemon nothing but the
+ * events.
+ *
+ * ## Helper exit
+ *
+ * A helper that exits (or closes its stdin) is noticed when its end of
+ * the socket closes. It is respawned on the next event, but no sooner
+ * than @c kRespawnDelay after the previous spawn, so one that crashes
+ * on start-up is not respawned in a tight loop; events in between are
+ * dropped. Its exit status is collected by the daemon's SIGCHLD reap
+ * like any hook child's.
+ */
+class HookHelper {
+public:
+    /** Lines written but not yet read by the helper, in bytes. */
+    static constexpr std::size_t kMaxBufferedBytes = 64 * 1024;
+
+    /** Least time between two spawns of the helper. */
+    static constexpr auto kRespawnDelay = std::chrono::seconds(5);
+
+    /**
+     * @param loop  Non-owning; must outlive *this. Carries the socket.
+     * @param path  Absolute path of the helper executable.
+     * @param env   The helper's environment, @c "KEY=VALUE" strings.
+     */
+    HookHelper(EventLoop& loop, std::string path, std::vector<std::string> env);
+    ~HookHelper();
+
+    HookHelper(const HookHelper&)            = delete;
+    HookHelper& operator=(const HookHelper&) = delete;
+    HookHelper(HookHelper&&)                 = delete;
+    HookHelper& operator=(HookHelper&&)      = delete;
+
+    /**
+     * Spawn the helper. A failure is logged and retried by the next
+     * @c deliver, so the return value is informational.
+     */
+    bool start();
+
+    /**
+     * Close the helper's stdin; it sees end of input and is expected
+     * to exit. Buffered lines it has not read are lost. Idempotent.
+     */
+    void stop();
+
+    /** Write one event line built from @p fields, spawning the helper if needed. */
+    void deliver(const std::vector<std::string>& fields);
+
+private:
+    bool spawn();
+
+    /** Event-loop handler for the socket: writability or the helper's exit. */
+    void onSocketEvent(std::uint32_t events);
+
+    /**
+     * Write as much of @c m_outbound as the socket takes, and ask the
+     * loop for WRITE iff some remains. Returns false if the helper is
+     * gone (the connection has been dropped).
+     */
+    bool flush();
+
+    /** Forget the current helper: unregister and close its socket. */
+    void disconnect();
+
+    EventLoop&               m_loop;
+    const std::string        m_path;
+    const std::vector<std::string> m_env;
+
+    UnixSocket  m_socket;        ///< Our end; invalid while no helper runs.
+    pid_t       m_pid = -1;
+    std::string m_outbound;      ///< Lines not yet taken by the socket.
+    bool        m_writeArmed = false;
+    bool        m_stopped    = false;
+    std::optional<std::chrono::steady_clock::time_point> m_lastSpawn;
+};
+
+} // namespace cec_control
@@ -0,0 +1,168 @@
+#include "hook_spawn.h"
+
+#include "../../common/logger.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace cec_control {
+
+namespace {
+
+/**
+ * RAII wrapper around @c posix_spawnattr_t so an early return path
+ * cannot leak the structure. Plain @c posix_spawn_file_actions_t gets
+ * the same treatment — both are trivially destructible from libc's
+ * standpoint but require an explicit destroy call on some platforms.
+ */
+class SpawnAttr {
+public:
+    SpawnAttr() {
+        m_ok = ::posix_spawnattr_init(&m_attr) == 0;
+    }
+    ~SpawnAttr() {
+        if (m_ok) ::posix_spawnattr_destroy(&m_attr);
+    }
+    SpawnAttr(const SpawnAttr&)            = delete;
+    SpawnAttr& operator=(const SpawnAttr&) = delete;
+
+    [[nodiscard]] bool valid() const noexcept { return m_ok; }
+    posix_spawnattr_t* get() noexcept { return &m_attr; }
+
+private:
+    posix_spawnattr_t m_attr{};
+    bool              m_ok{false};
+};
+
+class SpawnFileActions {
+public:
+    SpawnFileActions() {
+        m_ok = ::posix_spawn_file_actions_init(&m_actions) == 0;
+    }
+    ~SpawnFileActions() {
+        if (m_ok) ::posix_spawn_file_actions_destroy(&m_actions);
+    }
+    SpawnFileActions(const SpawnFileActions&)            = delete;
+    SpawnFileActions& operator=(const SpawnFileActions&) = delete;
+
+    [[nodiscard]] bool valid() const noexcept { return m_ok; }
+    posix_spawn_file_actions_t* get() noexcept { return &m_actions; }
+
+private:
+    posix_spawn_file_actions_t m_actions{};
+    bool                       m_ok{false};
+};
+
+} // namespace
+
+hook::SpawnImage::SpawnImage(const std::string& path, const std::vector<std::string>& env) {
+    std::size_t size = path.size() + 1;
+    for (const auto& entry : env) size += entry.size() + 1;
+    m_arena.reserve(size);
+    m_envOffsets.reserve(env.size());
+
+    m_arena.insert(m_arena.end(), path.begin(), path.end());
+    m_arena.push_back('\0');
+    for (const auto& entry : env) {
+        m_envOffsets.push_back(m_arena.size());
+        m_arena.insert(m_arena.end(), entry.begin(), entry.end());
+        m_arena.push_back('\0');
+    }
+}
+
+std::array<char*, 2> hook::SpawnImage::argv() const noexcept {
+    // posix_spawn takes char*[] (not const) but does not modify its
+    // argv/envp.
+    return {const_cast<char*>(m_arena.data()), nullptr};
+}
+
+void hook::SpawnImage::composeEnv(const std::vector<std::string>& extra,
+                                  std::vector<char*>& envp) const {
+    envp.clear();
+    envp.reserve(m_envOffsets.size() + extra.size() + 1);
+    for (const std::size_t offset : m_envOffsets) {
+        envp.push_back(const_cast<char*>(m_arena.data() + offset));
+    }
+    for (const auto& entry : extra) {
+        envp.push_back(const_cast<char*>(entry.c_str()));
+    }
+    envp.push_back(nullptr);
+}
+
+pid_t hook::spawnChild(const std::string& path, const std::vector<std::string>& env,
+                       int stdinFd) {
+    const SpawnImage image(path, env);
+    std::vector<char*> envp;
+    image.composeEnv({}, envp);
+    return spawnChild(image, envp.data(), stdinFd);
+}
+
+pid_t hook::spawnChild(const SpawnImage& image, char* const envp[], int stdinFd) {
+    const char* const path = image.path();
+    SpawnAttr attr;
+    SpawnFileActions actions;
+    if (!attr.valid() || !actions.valid()) {
+        LOG_WARNING("Hook spawn setup failed for ", path,
+                    ": posix_spawnattr/file_actions init failed");
+        return -1;
+    }
+
+    // Undo the daemon's inherited SIG_BLOCK mask so the child sees a
+    // normal signal environment. Without this, shell scripts spawned
+    // from the daemon would inherit the blocked set and behave oddly
+    // under @c trap.
+    //
+    // USEVFORK: glibc 2.24 and later always spawn with
+    // clone(CLONE_VM | CLONE_VFORK) and ignore the flag; asking for it
+    // keeps older glibc and other libcs off the fork path, whose
+    // page-table copy grows with the daemon's mappings.
+    sigset_t emptyMask;
+    sigemptyset(&emptyMask);
+    short flags = POSIX_SPAWN_SETSIGMASK;
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    if (::posix_spawnattr_setsigmask(attr.get(), &emptyMask) != 0 ||
+        ::posix_spawnattr_setflags(attr.get(), flags) != 0) {
+        LOG_WARNING("Hook spawn setup failed for ", path,
+                    ": posix_spawnattr_setsigmask failed");
+        return -1;
+    }
+
+    // Hook scripts must not read from the daemon's stdin — under
+    // systemd stdin is already closed, but belt-and-braces for the
+    // foreground / dev case where a stray @c read would otherwise
+    // hang forever on a terminal. A caller-supplied descriptor is
+    // dup2'd instead, which also clears its close-on-exec flag.
+    const int stdinRc = stdinFd >= 0
+        ? ::posix_spawn_file_actions_adddup2(actions.get(), stdinFd, STDIN_FILENO)
+        : ::posix_spawn_file_actions_addopen(
+              actions.get(), STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    if (stdinRc != 0) {
+        LOG_WARNING("Hook spawn setup failed for ", path,
+                    ": could not set up the child's stdin");
+        return -1;
+    }
+    // Stdout and stderr deliberately inherit: under systemd journald
+    // captures them under the daemon's unit; under a foreground run
+    // they reach the operator's terminal. Either is correct.
+
+    // The image and envp outlive the call, after which the child has
+    // its own copies.
+    std::array<char*, 2> argv = image.argv();
+
+    pid_t pid = 0;
+    const int rc = ::posix_spawn(&pid, path, actions.get(), attr.get(),
+                                 argv.data(), envp);
+    if (rc != 0) {
+        LOG_WARNING("Hook spawn failed for ", path, ": ", std::strerror(rc));
+        return -1;
+    }
+    return pid;
+}
+
+} // namespace cec_control
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cec_control {
+
+namespace hook {
+
+/**
+ * The part of a child's argv and envp that is the same on every run:
+ * the program path and the fixed @c "KEY=VALUE" entries, packed once
+ * into one buffer. A firing then adds only its own few entries with
+ * @c composeEnv instead of rebuilding every string and pointer.
+ *
+ * Immutable after construction, so one image can be shared between
+ * the main thread that builds jobs and the thread that spawns them.
+ */
+class SpawnImage {
+public:
+    SpawnImage(const std::string& path, const std::vector<std::string>& env);
+
+    [[nodiscard]] const char* path() const noexcept { return m_arena.data(); }
+
+    /** @c {path, nullptr}, pointing into the image. */
+    [[nodiscard]] std::array<char*, 2> argv() const noexcept;
+
+    /**
+     * Replace @p envp with the fixed entries, then @p extra, then the
+     * terminating null. The pointers are valid while the image and
+     * @p extra are.
+     */
+    void composeEnv(const std::vector<std::string>& extra, std::vector<char*>& envp) const;
+
+private:
+    std::vector<char>        m_arena;       ///< path '\0' entry '\0' entry '\0' ...
+    std::vector<std::size_t> m_envOffsets;  ///< Start of each entry in @c m_arena.
+};
+
+/**
+ * @c posix_spawn @p image's program with environment @p envp and no
+ * arguments. The child starts with an empty signal mask; its stdin is
+ * @p stdinFd, or @c /dev/null when negative, and stdout / stderr are
+ * inherited from the daemon.
+ *
+ * The spawn asks for @c POSIX_SPAWN_USEVFORK: the child shares the
+ * daemon's address space until it execs, so no page tables are copied
+ * however large the daemon is.
+ *
+ * Returns the child's pid, or -1 after logging the failure. The child
+ * is reaped by @c reapChildren like any other.
+ */
+pid_t spawnChild(const SpawnImage& image, char* const envp[], int stdinFd = -1);
+
+/** As above for a one-off spawn of @p path with environment @p env. */
+pid_t spawnChild(const std::string& path, const std::vector<std::string>& env,
+                 int stdinFd = -1);
+
+} // namespace hook
+
+} // namespace cec_control
@@ -0,0 +1,166 @@
+#include "key_repeater.h"
+
+#include <ios>
+#include <utility>
+
+#include <libcec/cec.h>
+
+#include "../common/key_codes.h"
+#include "../common/logger.h"
+#include "../common/main_thread_work.h"
+#include "../common/loop_timer.h"
+#include "cec/adapter_interface.h"
+#include "cec/adapter_worker.h"
+
+namespace cec_control {
+
+namespace {
+
+/** Reply to the client, if one is waiting, with the frame's outcome. */
+void answer(const ResponseSink& reply, bool sent) {
+    if (reply) {
+        reply(Message(sent ? MessageType::RESP_SUCCESS : MessageType::RESP_ERROR));
+    }
+}
+
+/** Worker options for a hold frame: Interactive, ordered with @p address. */
+AdapterWorker::TaskOptions holdOptions(uint8_t address) {
+    AdapterWorker::TaskOptions options;
+    options.lane     = address;
+    options.priority = WorkPriority::Interactive;
+    return options;
+}
+
+} // namespace
+
+KeyRepeater::KeyRepeater(AdapterWorker& worker, MainThreadWork& work, LoopTimer& timer)
+    : m_worker(worker), m_work(work), m_timer(timer) {}
+
+void KeyRepeater::press(const Message& command, ResponseSink reply) {
+    if (command.data.empty() || findKeyByCode(command.data[0]) == nullptr) {
+        // Same allowlist CMD_KEY applies; only a hand-rolled wire
+        // message gets here.
+        LOG_WARNING("CMD_KEY_DOWN received without a known key code (malformed client)");
+        reply(Message(MessageType::RESP_ERROR));
+        return;
+    }
+    const uint8_t address = command.deviceId;
+    const uint8_t code    = command.data[0];
+    if (m_held) {
+        LOG_DEBUG("Key 0x", std::hex, static_cast<int>(m_held->code),
+                  " replaced by a new key-down");
+    }
+    stopHolding();
+    const uint64_t generation = m_generation;
+
+    // The task answers through its own copy of the sink; the original
+    // stays here for a refused submission.
+    const auto admission = m_worker.submitTask(
+        [this, reply, address, code, generation](ICecAdapter& adapter) mutable
+            -> std::optional<AdapterWorker::TimePoint> {
+            const bool sent = adapter.isConnected() &&
+                adapter.sendKeypress(static_cast<CEC::cec_logical_address>(address),
+                                     static_cast<CEC::cec_user_control_code>(code),
+                                     /*release=*/false);
+            m_work.post([this, reply = std::move(reply), address, code, generation, sent] {
+                // A key-up or another key-down that arrived while this
+                // press was queued has already moved the hold on.
+                if (sent && generation == m_generation) {
+                    if (m_timer.armPeriodic(kRepeatInterval)) {
+                        m_held = Held{address, code, Clock::now()};
+                    } else {
+                        LOG_WARNING("Failed to arm key repeat timer; key not held");
+                    }
+                }
+                answer(reply, sent);
+            });
+            return std::nullopt;
+        },
+        holdOptions(address));
+    if (admission == AdapterWorker::Admission::QueueFull) {
+        LOG_WARNING("Adapter worker queue full; answering busy");
+        reply(Message(MessageType::RESP_BUSY));
+    }
+}
+
+void KeyRepeater::release(const Message& command, ResponseSink reply) {
+    // The held key is released wherever the key-up is addressed;
+    // otherwise its device would sit out its own time-out.
+    if (m_held && m_held->address != command.deviceId) submitRelease(m_held->address, {});
+    stopHolding();
+    submitRelease(command.deviceId, std::move(reply));
+}
+
+void KeyRepeater::onTimerFired() {
+    if (m_timer.consume() == 0) return;
+    if (!m_held) {
+        m_timer.disarm();
+        return;
+    }
+    if (Clock::now() - m_held->since >= kMaxHold) {
+        LOG_WARNING("Key 0x", std::hex, static_cast<int>(m_held->code),
+                    std::dec, " held on device ", static_cast<int>(m_held->address),
+                    " without a key-up for ", kMaxHold.count(), " ms; releasing");
+        const uint8_t address = m_held->address;
+        stopHolding();
+        submitRelease(address, {});
+        return;
+    }
+    if (m_repeatInFlight) {
+        LOG_DEBUG("Key repeat still queued; skipping this tick");
+        return;
+    }
+
+    const Held held          = *m_held;
+    const uint64_t generation = m_generation;
+    auto options     = holdOptions(held.address);
+    options.deadline = AdapterWorker::Clock::now() + kRepeatInterval;
+    options.onExpired = [this] {
+        m_work.post([this] { m_repeatInFlight = false; });
+    };
+    const auto admission = m_worker.submitTask(
+        [this, held, generation](ICecAdapter& adapter)
+            -> std::optional<AdapterWorker::TimePoint> {
+            const bool sent = adapter.isConnected() &&
+                adapter.sendKeypress(static_cast<CEC::cec_logical_address>(held.address),
+                                     static_cast<CEC::cec_user_control_code>(held.code),
+                                     /*release=*/false);
+            m_work.post([this, held, generation, sent] {
+                m_repeatInFlight = false;
+                if (!sent && generation == m_generation) {
+                    LOG_WARNING("Key repeat to device ", static_cast<int>(held.address),
+                                " failed; key no longer held");
+                    stopHolding();
+                }
+            });
+            return std::nullopt;
+        },
+        std::move(options));
+    m_repeatInFlight = admission == AdapterWorker::Admission::Accepted;
+}
+
+void KeyRepeater::stopHolding() {
+    ++m_generation;
+    m_held.reset();
+    m_timer.disarm();
+}
+
+void KeyRepeater::submitRelease(uint8_t address, ResponseSink reply) {
+    const auto admission = m_worker.submitTask(
+        [this, reply, address](ICecAdapter& adapter) mutable
+            -> std::optional<AdapterWorker::TimePoint> {
+            const bool sent = adapter.isConnected() &&
+                adapter.sendKeypress(static_cast<CEC::cec_logical_address>(address),
+                                     CEC::CEC_USER_CONTROL_CODE_UNKNOWN,
+                                     /*release=*/true);
+            m_work.post([reply = std::move(reply), sent] { answer(reply, sent); });
+            return std::nullopt;
+        },
+        holdOptions(address));
+    if (admission == AdapterWorker::Admission::QueueFull) {
+        LOG_WARNING("Adapter worker queue full; key release not sent");
+        if (reply) reply(Message(MessageType::RESP_BUSY));
+    }
+}
+
+} // namespace cec_control
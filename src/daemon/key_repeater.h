@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "../common/messages.h"
+
+namespace cec_control {
+
+class AdapterWorker;
+class MainThreadWork;
+class LoopTimer;
+
+/**
+ * @class KeyRepeater
+ * @brief Keeps a remote-control key pressed on the bus between a
+ *        client's @c CMD_KEY_DOWN and @c CMD_KEY_UP.
+ *
+ * CEC has no "held" state: a follower treats a key as held for as long
+ * as <User Control Pressed> keeps arriving, and releases it on its own
+ * once the repeats stop. On key-down this class sends the first press,
+ * then re-sends it every @c kRepeatInterval from a periodic timer until
+ * key-up sends <User Control Released>. A TV menu therefore scrolls
+ * with the receiver's own repeat behaviour instead of one step per
+ * client message.
+ *
+ * One key is held at a time, as on a physical remote: a key-down while
+ * another key is held replaces it. A hold that sees no key-up within
+ * @c kMaxHold is released by the daemon, so a client that dies
+ * mid-hold cannot leave a key pressed. A repeat that fails to transmit
+ * ends the hold, and the follower's own time-out releases the key.
+ *
+ * Frames go straight to the adapter worker at Interactive priority,
+ * on the target device's ordering lane, without a throttle slot: a
+ * late or dropped repeat is corrected by the next one. A repeat still
+ * queued when the next tick fires is not doubled up, and one that
+ * waits longer than an interval is dropped unsent.
+ *
+ * Main thread only; worker completions come back through
+ * @c MainThreadWork.
+ */
+class KeyRepeater {
+public:
+    /**
+     * Gap between repeated presses. CEC asks initiators to repeat
+     * within 450 ms and followers to time out after 550 ms; the margin
+     * covers timer jitter and a busy worker queue.
+     */
+    static constexpr std::chrono::milliseconds kRepeatInterval{400};
+
+    /** Longest a key stays held without a key-up. */
+    static constexpr std::chrono::milliseconds kMaxHold{10000};
+
+    /**
+     * @param worker Non-owning; must outlive @c this.
+     * @param work   Non-owning; must outlive @c this.
+     * @param timer  Non-owning; the daemon installs its handler,
+     *               which calls @c onTimerFired when it fires.
+     */
+    KeyRepeater(AdapterWorker& worker, MainThreadWork& work, LoopTimer& timer);
+
+    KeyRepeater(const KeyRepeater&)            = delete;
+    KeyRepeater& operator=(const KeyRepeater&) = delete;
+
+    /**
+     * @c CMD_KEY_DOWN: press the key in @c data[0] on @c deviceId and
+     * start repeating it. Replies once the first press is on the bus.
+     */
+    void press(const Message& command, ResponseSink reply);
+
+    /**
+     * @c CMD_KEY_UP: stop repeating and send the release to
+     * @c deviceId, and to the held key's device if that is another.
+     * Sent even when nothing is held, so a client can always clear a
+     * key it may have left pressed.
+     */
+    void release(const Message& command, ResponseSink reply);
+
+    /** Timer handler: send the next repeat, or end an over-long hold. */
+    void onTimerFired();
+
+    /** @c true while a key is held. */
+    [[nodiscard]] bool holding() const noexcept { return m_held.has_value(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Held {
+        uint8_t           address;
+        uint8_t           code;
+        Clock::time_point since;
+    };
+
+    /** Forget the held key and stop the timer. */
+    void stopHolding();
+
+    /** Queue <User Control Released> to @p address; @p reply may be empty. */
+    void submitRelease(uint8_t address, ResponseSink reply);
+
+    AdapterWorker&  m_worker;
+    MainThreadWork& m_work;
+    LoopTimer&      m_timer;
+
+    std::optional<Held> m_held;
+
+    // Bumped whenever a hold starts or stops, so a worker completion
+    // for a hold that has since been replaced or released is ignored.
+    uint64_t m_generation = 0;
+
+    // A repeat is queued or running on the worker.
+    bool m_repeatInFlight = false;
+};
+
+} // namespace cec_control
@@ -0,0 +1,67 @@
+#include "memory_profile.h"
+
+#include "../common/logger.h"
+#include "metrics.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <cstdio>
+
+namespace cec_control {
+
+std::optional<MemoryUsage> readMemoryUsage() noexcept {
+    std::FILE* status = std::fopen("/proc/self/status", "re");
+    if (status == nullptr) return std::nullopt;
+    MemoryUsage usage;
+    bool found = false;
+    char line[128];
+    unsigned long long kib = 0;
+    while (std::fgets(line, sizeof(line), status) != nullptr) {
+        if (std::sscanf(line, "VmRSS: %llu kB", &kib) == 1) {
+            usage.rssKiB = kib;
+            found = true;
+        } else if (std::sscanf(line, "VmHWM: %llu kB", &kib) == 1) {
+            usage.peakKiB = kib;
+        }
+    }
+    std::fclose(status);
+    if (!found) return std::nullopt;
+    return usage;
+}
+
+void publishMemoryUsage() noexcept {
+    // A failed read leaves the last figures in place.
+    const auto usage = readMemoryUsage();
+    if (!usage) return;
+    auto& metrics = Metrics::getInstance();
+    metrics.set(Metrics::Gauge::MemoryRssKiB, static_cast<int64_t>(usage->rssKiB));
+    metrics.set(Metrics::Gauge::MemoryPeakKiB, static_cast<int64_t>(usage->peakKiB));
+}
+
+void limitMallocArenas() noexcept {
+#ifdef __GLIBC__
+    if (::mallopt(M_ARENA_MAX, 1) != 1) {
+        LOG_WARNING("Cannot limit malloc to one arena");
+        return;
+    }
+    LOG_INFO("Low-memory profile: malloc limited to one arena");
+#endif
+}
+
+void trimHeap(std::string_view after) noexcept {
+#ifdef __GLIBC__
+    const auto before = readMemoryUsage();
+    ::malloc_trim(0);
+    const auto now = readMemoryUsage();
+    if (before && now) {
+        LOG_INFO("Trimmed the heap after ", after, ": resident ", before->rssKiB, " -> ",
+                 now->rssKiB, " KiB, peak ", now->peakKiB, " KiB");
+    }
+#else
+    (void)after;
+#endif
+}
+
+} // namespace cec_control
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace cec_control {
+
+/** The process's resident set, now and at its peak, from @c /proc/self/status. */
+struct MemoryUsage {
+    uint64_t rssKiB  = 0;  ///< @c VmRSS.
+    uint64_t peakKiB = 0;  ///< @c VmHWM: the most the process has had resident.
+};
+
+/** This process's @c MemoryUsage; nullopt where @c /proc is not mounted. */
+[[nodiscard]] std::optional<MemoryUsage> readMemoryUsage() noexcept;
+
+/**
+ * Set the memory gauges to @c readMemoryUsage, so the next render of
+ * the metrics shows them; called by each renderer before rendering.
+ */
+void publishMemoryUsage() noexcept;
+
+/**
+ * Cap glibc malloc at one arena. Each thread that contends for the
+ * heap otherwise gets an arena of its own, with up to a 64 MiB
+ * reservation and free space that is never given back; one arena
+ * serialises allocation, which this daemon does little of. Call
+ * before the daemon's threads start, since arenas already made stay.
+ * A no-op outside glibc.
+ */
+void limitMallocArenas() noexcept;
+
+/**
+ * Give free heap back to the kernel, and log what the resident set
+ * was before and after; @p after names the step just finished. A
+ * no-op outside glibc.
+ */
+void trimHeap(std::string_view after) noexcept;
+
+} // namespace cec_control
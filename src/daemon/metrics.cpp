@@ -0,0 +1,275 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string_view>
+
+namespace cec_control {
+
+namespace {
+
+// Report names, indexed by enumerator. Extend alongside the enums;
+// the asserts catch a table that fell behind. Latency names carry no
+// unit; each renderer appends its own.
+constexpr std::array<std::string_view, Metrics::kCounterCount> kCounterNames = {
+    "throttle_retries",
+    "throttle_exhausted",
+    "worker_rejected",
+    "worker_expired",
+    "coalesced_merged",
+    "coalesced_dropped",
+    "redundant_skipped",
+    "sessions_accepted",
+    "sessions_refused",
+    "hook_spawns",
+    "hook_spawn_failures",
+    "hook_timeouts",
+    "hook_jobs_discarded",
+    "hook_events_delivered",
+    "hook_events_dropped",
+    "events_published",
+    "events_dropped",
+    "fanout_skipped",
+    "detached_succeeded",
+    "detached_failed",
+    "call_budget_exceeded",
+    "breaker_opened",
+    "breaker_rejected",
+    "requests_rate_limited",
+    "network_auth_failures",
+};
+static_assert(static_cast<std::size_t>(Metrics::Counter::NetworkAuthFailures) + 1 ==
+              Metrics::kCounterCount, "kCounterCount drift");
+
+constexpr std::array<std::string_view, Metrics::kGaugeCount> kGaugeNames = {
+    "worker_queue_depth",
+    "worker_parked",
+    "active_sessions",
+    "event_subscribers",
+    "hook_children_running",
+    "queued_sessions",
+    "memory_rss_kib",
+    "memory_peak_rss_kib",
+};
+static_assert(static_cast<std::size_t>(Metrics::Gauge::MemoryPeakKiB) + 1 ==
+              Metrics::kGaugeCount, "kGaugeCount drift");
+
+constexpr std::array<std::string_view, Metrics::kLatencyCount> kLatencyNames = {
+    "worker_queue_wait",
+    "throttle_delay",
+    "libcec_call",
+    "hook_spawn",
+    "hook_run",
+    "suspend_prep",
+};
+static_assert(static_cast<std::size_t>(Metrics::Latency::SuspendPrep) + 1 ==
+              Metrics::kLatencyCount, "kLatencyCount drift");
+
+} // namespace
+
+std::string_view dispatchLabel(MessageType type) noexcept {
+    switch (type) {
+    case MessageType::CMD_VOLUME_UP:           return "volume_up";
+    case MessageType::CMD_VOLUME_DOWN:         return "volume_down";
+    case MessageType::CMD_VOLUME_MUTE:         return "volume_mute";
+    case MessageType::CMD_POWER_ON:            return "power_on";
+    case MessageType::CMD_POWER_OFF:           return "power_off";
+    case MessageType::CMD_CHANGE_SOURCE:       return "source";
+    case MessageType::CMD_RESTART_ADAPTER:     return "restart";
+    case MessageType::CMD_SUSPEND:             return "suspend";
+    case MessageType::CMD_RESUME:              return "resume";
+    case MessageType::CMD_AUTO_STANDBY:        return "auto_standby";
+    case MessageType::CMD_KEY:                 return "key";
+    case MessageType::CMD_BATCH:               return "batch";
+    case MessageType::CMD_QUERY_STATUS:        return "status";
+    case MessageType::CMD_QUERY_DEVICES:       return "devices";
+    case MessageType::CMD_QUERY_ACTIVE_SOURCE: return "active_source";
+    case MessageType::CMD_STATS:               return "stats";
+    case MessageType::CMD_TRACE:               return "trace";
+    case MessageType::CMD_SUBSCRIBE:           return "subscribe";
+    case MessageType::CMD_SCENE:               return "scene";
+    case MessageType::CMD_VOLUME_SET:          return "volume_set";
+    case MessageType::CMD_KEY_DOWN:            return "key_down";
+    case MessageType::CMD_KEY_UP:              return "key_up";
+    case MessageType::CMD_RAW_TRANSMIT:        return "raw_transmit";
+    case MessageType::CMD_KEY_SEQUENCE:        return "key_sequence";
+    case MessageType::CMD_HELLO:               return "hello";
+    default:                                   return "unknown";
+    }
+}
+
+namespace {
+
+void renderHistogram(std::ostringstream& out, std::string_view name,
+                     const LatencyHistogram::Snapshot& snapshot) {
+    out << name << " count=" << snapshot.count << " sum_us=" << snapshot.sumUs
+        << " buckets=";
+    for (std::size_t i = 0; i < snapshot.buckets.size(); ++i) {
+        if (i > 0) out << ',';
+        out << snapshot.buckets[i];
+    }
+    out << '\n';
+}
+
+// Microseconds as a decimal count of seconds, exact and without
+// trailing zeros: 250 -> "0.00025", 1000000 -> "1".
+void writeSeconds(std::ostringstream& out, uint64_t us) {
+    out << us / 1'000'000;
+    uint64_t fraction = us % 1'000'000;
+    if (fraction == 0) return;
+    int digits = 6;
+    while (fraction % 10 == 0) {
+        fraction /= 10;
+        --digits;
+    }
+    const std::string text = std::to_string(fraction);
+    out << '.' << std::string(static_cast<std::size_t>(digits) - text.size(), '0')
+        << text;
+}
+
+// One OpenMetrics histogram sample set. @p label is either empty or a
+// complete `key="value",` prefix for the label set.
+void renderOpenMetricsHistogram(std::ostringstream& out, std::string_view family,
+                                std::string_view label,
+                                const LatencyHistogram::Snapshot& snapshot) {
+    uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < snapshot.buckets.size(); ++i) {
+        cumulative += snapshot.buckets[i];
+        out << family << "_bucket{" << label << "le=\"";
+        if (i < kLatencyBucketsUs.size()) {
+            writeSeconds(out, kLatencyBucketsUs[i]);
+        } else {
+            out << "+Inf";
+        }
+        out << "\"} " << cumulative << '\n';
+    }
+    const std::string_view labels =
+        label.empty() ? std::string_view{} : label.substr(0, label.size() - 1);
+    out << family << "_sum";
+    if (!labels.empty()) out << '{' << labels << '}';
+    out << ' ';
+    writeSeconds(out, snapshot.sumUs);
+    // _count must equal the +Inf bucket; use the bucket total rather
+    // than the separately loaded count so an in-flight record cannot
+    // make the two disagree.
+    out << '\n' << family << "_count";
+    if (!labels.empty()) out << '{' << labels << '}';
+    out << ' ' << cumulative << '\n';
+}
+
+constexpr std::string_view kOpenMetricsPrefix = "cec_control_";
+
+} // namespace
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration elapsed) noexcept {
+    const auto us = std::max<int64_t>(
+        0, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    const auto bucket = static_cast<std::size_t>(
+        std::lower_bound(kLatencyBucketsUs.begin(), kLatencyBucketsUs.end(),
+                         static_cast<uint64_t>(us)) - kLatencyBucketsUs.begin());
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumUs.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const noexcept {
+    Snapshot out;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        out.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    out.count = m_count.load(std::memory_order_relaxed);
+    out.sumUs = m_sumUs.load(std::memory_order_relaxed);
+    return out;
+}
+
+Metrics& Metrics::getInstance() noexcept {
+    static Metrics instance;
+    return instance;
+}
+
+void Metrics::recordDispatch(MessageType type,
+                             std::chrono::steady_clock::duration elapsed) noexcept {
+    const auto slot = static_cast<std::size_t>(type);
+    if (slot >= kDispatchSlots) return;
+    m_dispatch[slot].record(elapsed);
+}
+
+Metrics::Snapshot Metrics::snapshot() const noexcept {
+    Snapshot out;
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+        out.counters[i] = m_counters[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < kGaugeCount; ++i) {
+        out.gauges[i] = m_gauges[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < kLatencyCount; ++i) {
+        out.latencies[i] = m_latencies[i].snapshot();
+    }
+    for (std::size_t slot = 0; slot < kDispatchSlots; ++slot) {
+        out.dispatch[slot] = m_dispatch[slot].snapshot();
+    }
+    return out;
+}
+
+std::string Metrics::render() const {
+    const Snapshot snap = snapshot();
+    std::ostringstream out;
+    out << "# buckets_us=";
+    for (const uint32_t bound : kLatencyBucketsUs) out << bound << ',';
+    out << "inf\n";
+
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+        out << kCounterNames[i] << ' ' << snap.counters[i] << '\n';
+    }
+    for (std::size_t i = 0; i < kGaugeCount; ++i) {
+        out << kGaugeNames[i] << ' ' << snap.gauges[i] << '\n';
+    }
+    for (std::size_t i = 0; i < kLatencyCount; ++i) {
+        renderHistogram(out, std::string(kLatencyNames[i]) + "_us", snap.latencies[i]);
+    }
+    for (std::size_t slot = 0; slot < kDispatchSlots; ++slot) {
+        if (snap.dispatch[slot].count == 0) continue;
+        const std::string name = "dispatch_us{" +
+            std::string(dispatchLabel(static_cast<MessageType>(slot))) + "}";
+        renderHistogram(out, name, snap.dispatch[slot]);
+    }
+    return out.str();
+}
+
+std::string Metrics::renderOpenMetrics() const {
+    const Snapshot snap = snapshot();
+    std::ostringstream out;
+
+    for (std::size_t i = 0; i < kCounterCount; ++i) {
+        out << "# TYPE " << kOpenMetricsPrefix << kCounterNames[i] << " counter\n"
+            << kOpenMetricsPrefix << kCounterNames[i] << "_total "
+            << snap.counters[i] << '\n';
+    }
+    for (std::size_t i = 0; i < kGaugeCount; ++i) {
+        out << "# TYPE " << kOpenMetricsPrefix << kGaugeNames[i] << " gauge\n"
+            << kOpenMetricsPrefix << kGaugeNames[i] << ' '
+            << snap.gauges[i] << '\n';
+    }
+    for (std::size_t i = 0; i < kLatencyCount; ++i) {
+        const std::string family =
+            std::string(kOpenMetricsPrefix) + std::string(kLatencyNames[i]) + "_seconds";
+        out << "# TYPE " << family << " histogram\n"
+            << "# UNIT " << family << " seconds\n";
+        renderOpenMetricsHistogram(out, family, {}, snap.latencies[i]);
+    }
+
+    const std::string dispatch = std::string(kOpenMetricsPrefix) + "dispatch_seconds";
+    out << "# TYPE " << dispatch << " histogram\n"
+        << "# UNIT " << dispatch << " seconds\n";
+    for (std::size_t slot = 0; slot < kDispatchSlots; ++slot) {
+        if (snap.dispatch[slot].count == 0) continue;
+        const std::string label = "type=\"" +
+            std::string(dispatchLabel(static_cast<MessageType>(slot))) + "\",";
+        renderOpenMetricsHistogram(out, dispatch, label, snap.dispatch[slot]);
+    }
+
+    out << "# EOF\n";
+    return out.str();
+}
+
+} // namespace cec_control
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "../common/messages.h"
+
+namespace cec_control {
+
+/**
+ * Upper bounds, in microseconds, of every latency histogram's buckets.
+ * A final overflow bucket catches anything slower. Spans a sub-
+ * millisecond libcec getter up to a suspend that uses all of logind's
+ * ten-second inhibit delay.
+ */
+inline constexpr std::array<uint32_t, 16> kLatencyBucketsUs = {
+    100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000,
+    100'000, 250'000, 500'000, 1'000'000, 2'500'000, 5'000'000, 10'000'000,
+};
+
+/**
+ * Report label of a command type ("volume_up", "status", ...), as its
+ * dispatch histogram is named in @c CMD_STATS; "unknown" for anything
+ * that is not a command.
+ */
+[[nodiscard]] std::string_view dispatchLabel(MessageType type) noexcept;
+
+/**
+ * Fixed-bucket latency histogram over @c kLatencyBucketsUs. Lock-free:
+ * @c record is three relaxed atomic adds, so it is safe on any thread,
+ * including libcec's. A @c snapshot taken while writers are active may
+ * be off by the in-flight samples; counts are never torn.
+ */
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kBucketCount = kLatencyBucketsUs.size() + 1;
+
+    struct Snapshot {
+        std::array<uint64_t, kBucketCount> buckets{};
+        uint64_t                           count = 0;
+        uint64_t                           sumUs = 0;
+    };
+
+    void record(std::chrono::steady_clock::duration elapsed) noexcept;
+
+    [[nodiscard]] Snapshot snapshot() const noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> m_buckets{};
+    std::atomic<uint64_t>                           m_count{0};
+    std::atomic<uint64_t>                           m_sumUs{0};
+};
+
+/**
+ * Process-wide metrics registry. Singleton, like @c Logger: the
+ * instrumented sites span the worker, libcec's threads, the hook
+ * executor and the event loop, and threading a reference through each
+ * would widen every constructor for what is a write-only side channel.
+ *
+ * Every metric is a named slot in one of three fixed enums, so
+ * recording is an array index plus a relaxed atomic operation — no
+ * lock, no allocation, no lookup. @c render is the only reader; it is
+ * served by @c CMD_STATS.
+ */
+class Metrics {
+public:
+    /** Monotonic event counts. */
+    enum class Counter : uint8_t {
+        ThrottleRetries,
+        ThrottleExhausted,
+        WorkerRejected,
+        WorkerExpired,
+        CoalescedMerged,
+        CoalescedDropped,
+        RedundantSkipped,
+        SessionsAccepted,
+        SessionsRefused,
+        HookSpawns,
+        HookSpawnFailures,
+        /** Hook children sent SIGTERM for running past the timeout. */
+        HookTimeouts,
+        /** Waiting hook jobs replaced by a newer one, or pushed out of a full queue. */
+        HookJobsDiscarded,
+        /** Event lines written to the hook helper. */
+        HookEventsDelivered,
+        /** Events the hook helper missed: not running, or not keeping up. */
+        HookEventsDropped,
+        /** Bus events queued to a subscribed session, one per subscriber. */
+        EventsPublished,
+        /** Bus events discarded because a subscriber's queue was full. */
+        EventsDropped,
+        /** Suspend or wake frames not sent because the deadline was too close. */
+        FanoutSkipped,
+        /** Ack-on-accept commands that went on to succeed, or to fail. */
+        DetachedSucceeded,
+        DetachedFailed,
+        /** Adapter calls that overran @c CallBudgetMs and forced a reconnect. */
+        CallBudgetExceeded,
+        /** Device circuit breakers tripped by exhausted commands. */
+        BreakerOpened,
+        /** Commands failed unsent because their device's breaker was open. */
+        BreakerRejected,
+        /** Requests refused because their client's user was over its rate limit. */
+        RateLimited,
+        /** Network connections closed for a wrong, missing or late token. */
+        NetworkAuthFailures,
+    };
+    static constexpr std::size_t kCounterCount = 25;
+
+    /** Point-in-time levels. */
+    enum class Gauge : uint8_t {
+        WorkerQueueDepth,
+        WorkerParked,
+        ActiveSessions,
+        EventSubscribers,
+        /** Hook children the executor is watching. */
+        HookChildrenRunning,
+        /** Accepted clients waiting for a session slot. */
+        QueuedSessions,
+        /** Resident set, KiB; refreshed by @c publishMemoryUsage. */
+        MemoryRssKiB,
+        /** Largest resident set so far, KiB. */
+        MemoryPeakKiB,
+    };
+    static constexpr std::size_t kGaugeCount = 8;
+
+    /** Durations, each into its own @c LatencyHistogram. */
+    enum class Latency : uint8_t {
+        /** Submission to first run on the adapter worker. */
+        WorkerQueueWait,
+        /** Wait for a reserved throttle slot. */
+        ThrottleDelay,
+        /** One libcec API call. */
+        LibcecCall,
+        /** Setting up and issuing one hook @c posix_spawn. */
+        HookSpawn,
+        /** Spawn to exit of one hook child. */
+        HookRunTime,
+        /**
+         * Standby fan-out and adapter close for one suspend: how much
+         * of logind's @c InhibitDelayMaxSec each sleep actually used.
+         */
+        SuspendPrep,
+    };
+    static constexpr std::size_t kLatencyCount = 6;
+
+    static Metrics& getInstance() noexcept;
+
+    Metrics(const Metrics&)            = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    void increment(Counter counter, uint64_t by = 1) noexcept {
+        m_counters[static_cast<std::size_t>(counter)].fetch_add(by, std::memory_order_relaxed);
+    }
+
+    void set(Gauge gauge, int64_t value) noexcept {
+        m_gauges[static_cast<std::size_t>(gauge)].store(value, std::memory_order_relaxed);
+    }
+
+    void record(Latency latency, std::chrono::steady_clock::duration elapsed) noexcept {
+        m_latencies[static_cast<std::size_t>(latency)].record(elapsed);
+    }
+
+    /**
+     * Record the time from a wire command's arrival to its reply.
+     * Response types and values past the command range are ignored.
+     */
+    void recordDispatch(MessageType type, std::chrono::steady_clock::duration elapsed) noexcept;
+
+    /**
+     * Text report of every metric, one per line, for @c CMD_STATS:
+     * `name value` for counters and gauges, and
+     * `name count=N sum_us=S buckets=b0,b1,...` for histograms with the
+     * bucket bounds given once on a leading comment line. Dispatch
+     * histograms that never recorded a sample are omitted.
+     */
+    [[nodiscard]] std::string render() const;
+
+    /**
+     * The same metrics in OpenMetrics text exposition format, for the
+     * scrape endpoint: counters as @c _total, histograms with
+     * cumulative @c le buckets in seconds, dispatch latency as one
+     * histogram family labelled by command type, and a closing
+     * @c # EOF.
+     */
+    [[nodiscard]] std::string renderOpenMetrics() const;
+
+private:
+    Metrics() = default;
+
+    /** Dispatch histograms are indexed by raw type; commands sit below this. */
+    static constexpr std::size_t kDispatchSlots = 32;
+
+    /**
+     * Point-in-time copy of every slot, taken with relaxed loads only,
+     * so a reader never contends with a recorder. Both renderers
+     * format from one of these rather than from the live atomics.
+     */
+    struct Snapshot {
+        std::array<uint64_t, kCounterCount>                    counters{};
+        std::array<int64_t, kGaugeCount>                       gauges{};
+        std::array<LatencyHistogram::Snapshot, kLatencyCount>  latencies{};
+        std::array<LatencyHistogram::Snapshot, kDispatchSlots> dispatch{};
+    };
+
+    [[nodiscard]] Snapshot snapshot() const noexcept;
+
+    std::array<std::atomic<uint64_t>, kCounterCount> m_counters{};
+    std::array<std::atomic<int64_t>, kGaugeCount>    m_gauges{};
+    std::array<LatencyHistogram, kLatencyCount>      m_latencies;
+    std::array<LatencyHistogram, kDispatchSlots>     m_dispatch;
+};
+
+/**
+ * Records the lifetime of the enclosing scope into one
+ * @c Metrics::Latency histogram.
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(Metrics::Latency latency) noexcept
+        : m_latency(latency), m_start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        Metrics::getInstance().record(m_latency, std::chrono::steady_clock::now() - m_start);
+    }
+
+    ScopedLatency(const ScopedLatency&)            = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    Metrics::Latency                      m_latency;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace cec_control
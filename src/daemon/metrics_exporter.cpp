@@ -0,0 +1,276 @@
+#include "metrics_exporter.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../common/event_poller.h"
+#include "../common/inet_address.h"
+#include "../common/logger.h"
+#include "memory_profile.h"
+#include "metrics.h"
+
+namespace cec_control {
+
+namespace {
+
+constexpr int LISTEN_BACKLOG = 8;
+
+constexpr std::uint32_t READ_BIT  = static_cast<std::uint32_t>(EventPoller::Event::READ);
+constexpr std::uint32_t WRITE_BIT = static_cast<std::uint32_t>(EventPoller::Event::WRITE);
+constexpr std::uint32_t EDGE_BIT  = static_cast<std::uint32_t>(EventPoller::Event::EDGE);
+
+constexpr auto kSweepInterval = std::chrono::seconds(5);
+
+constexpr std::string_view kContentType =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+std::string httpResponse(std::string_view status, std::string_view contentType,
+                         std::string_view body) {
+    std::string out;
+    out.reserve(body.size() + 160);
+    out.append("HTTP/1.1 ").append(status).append("\r\n");
+    out.append("Content-Type: ").append(contentType).append("\r\n");
+    out.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+    out.append("Connection: close\r\n\r\n");
+    out.append(body);
+    return out;
+}
+
+/** Reply to one complete request head. */
+std::string answer(std::string_view head) {
+    const auto lineEnd = head.find("\r\n");
+    const std::string_view requestLine = head.substr(0, lineEnd);
+    const auto methodEnd = requestLine.find(' ');
+    const std::string_view method = requestLine.substr(0, methodEnd);
+    if (method != "GET") {
+        return httpResponse("405 Method Not Allowed", "text/plain", "GET only\n");
+    }
+
+    std::string_view target = methodEnd == std::string_view::npos
+        ? std::string_view{} : requestLine.substr(methodEnd + 1);
+    target = target.substr(0, target.find(' '));
+    target = target.substr(0, target.find('?'));
+    if (target != "/metrics" && target != "/") {
+        return httpResponse("404 Not Found", "text/plain", "Not found\n");
+    }
+    publishMemoryUsage();
+    return httpResponse("200 OK", kContentType,
+                        Metrics::getInstance().renderOpenMetrics());
+}
+
+} // namespace
+
+/**
+ * One scrape exchange. Reads until the request head is complete, then
+ * flips to writing @c response; never does both at once.
+ */
+struct MetricsExporter::Connection {
+    Connection(UnixSocket f, std::chrono::steady_clock::time_point t) noexcept
+        : fd(std::move(f)), openedAt(t) {}
+
+    UnixSocket                            fd;
+    std::chrono::steady_clock::time_point openedAt;
+    std::string                           request;
+    std::string                           response;
+    std::size_t                           sent = 0;
+};
+
+MetricsExporter::MetricsExporter(EventLoop& loop, std::string listen)
+    : m_loop(loop), m_listen(std::move(listen)) {}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start() {
+    if (m_listener.valid()) return true;
+    if (!m_sweepTimer.valid()) {
+        LOG_ERROR("Metrics exporter timer source not initialised");
+        return false;
+    }
+
+    const auto addr = parseInetAddress(m_listen);
+    if (!addr) {
+        LOG_ERROR("Invalid metrics listen address (want A.B.C.D:PORT): ", m_listen);
+        return false;
+    }
+
+    UnixSocket listener(::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+    if (!listener.valid()) {
+        LOG_ERROR("Metrics exporter socket() failed: ", std::strerror(errno));
+        return false;
+    }
+    const int reuse = 1;
+    (void)::setsockopt(listener.get(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (::bind(listener.get(), reinterpret_cast<const sockaddr*>(&*addr),
+               sizeof(*addr)) < 0) {
+        LOG_ERROR("Metrics exporter bind(", m_listen, ") failed: ", std::strerror(errno));
+        return false;
+    }
+    if (::listen(listener.get(), LISTEN_BACKLOG) < 0) {
+        LOG_ERROR("Metrics exporter listen() failed: ", std::strerror(errno));
+        return false;
+    }
+    m_listener = std::move(listener);
+
+    // Edge-triggered: onAcceptReady accepts until EAGAIN.
+    if (!m_loop.add(m_listener.get(), READ_BIT | EDGE_BIT,
+                    [this](std::uint32_t) { onAcceptReady(); })) {
+        LOG_ERROR("Failed to register metrics listener with event loop");
+        stop();
+        return false;
+    }
+    if (!m_loop.add(m_sweepTimer.fd(), READ_BIT,
+                    [this](std::uint32_t) { onSweep(); })) {
+        LOG_ERROR("Failed to register metrics sweep timer with event loop");
+        stop();
+        return false;
+    }
+    if (!m_sweepTimer.armPeriodic(
+            std::chrono::duration_cast<std::chrono::milliseconds>(kSweepInterval))) {
+        LOG_ERROR("Failed to arm metrics sweep timer");
+        stop();
+        return false;
+    }
+
+    LOG_INFO("Metrics exporter listening on ", m_listen);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!m_listener.valid() && m_connections.empty()) return;
+
+    if (m_sweepTimer.valid()) {
+        m_loop.remove(m_sweepTimer.fd());
+        m_sweepTimer.disarm();
+    }
+    if (m_listener.valid()) {
+        m_loop.remove(m_listener.get());
+        m_listener.reset();
+    }
+    for (auto& [_, conn] : m_connections) {
+        m_loop.remove(conn->fd.get());
+    }
+    m_connections.clear();
+
+    LOG_INFO("Metrics exporter stopped");
+}
+
+void MetricsExporter::onAcceptReady() {
+    if (!m_listener.valid()) return;
+
+    while (true) {
+        UnixSocket client(::accept4(m_listener.get(), nullptr, nullptr,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC));
+        if (!client.valid()) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            LOG_WARNING("Metrics exporter accept() failed: ", std::strerror(errno));
+            return;
+        }
+        if (m_connections.size() >= kMaxConnections) {
+            LOG_DEBUG("Metrics exporter connection limit reached; dropping scrape");
+            continue;  // UnixSocket dtor closes the fresh fd
+        }
+
+        const ConnectionId id = m_nextId++;
+        auto conn = std::make_unique<Connection>(std::move(client),
+                                                 std::chrono::steady_clock::now());
+        if (!m_loop.add(conn->fd.get(), READ_BIT,
+                        [this, id](std::uint32_t events) { onConnectionEvent(id, events); })) {
+            LOG_WARNING("Failed to register metrics connection with event loop");
+            continue;
+        }
+        m_connections.emplace(id, std::move(conn));
+    }
+}
+
+void MetricsExporter::onConnectionEvent(ConnectionId id, std::uint32_t events) {
+    auto it = m_connections.find(id);
+    if (it == m_connections.end()) return;
+    Connection& conn = *it->second;
+
+    if (conn.response.empty()) {
+        if (events & READ_BIT) {
+            readRequest(id, conn);
+            return;
+        }
+    } else if (events & WRITE_BIT) {
+        writeResponse(id, conn);
+        return;
+    }
+    if (events & EventPoller::ERROR_EVENTS) closeConnection(id);
+}
+
+void MetricsExporter::readRequest(ConnectionId id, Connection& conn) {
+    ssize_t received = 0;
+    do {
+        received = ::recv(conn.fd.get(), m_readBuffer.data(), m_readBuffer.size(), 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (received <= 0) {
+        closeConnection(id);
+        return;
+    }
+
+    conn.request.append(m_readBuffer.data(), static_cast<std::size_t>(received));
+    const auto headEnd = conn.request.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        if (conn.request.size() > kMaxRequestSize) closeConnection(id);
+        return;
+    }
+
+    conn.response = answer(std::string_view(conn.request).substr(0, headEnd));
+    conn.request.clear();
+    if (!m_loop.modify(conn.fd.get(), WRITE_BIT)) {
+        closeConnection(id);
+        return;
+    }
+    // Most replies fit the socket buffer; try now rather than waiting
+    // a loop iteration for WRITE.
+    writeResponse(id, conn);
+}
+
+void MetricsExporter::writeResponse(ConnectionId id, Connection& conn) {
+    while (conn.sent < conn.response.size()) {
+        ssize_t sent = 0;
+        do {
+            sent = ::send(conn.fd.get(), conn.response.data() + conn.sent,
+                          conn.response.size() - conn.sent, MSG_NOSIGNAL);
+        } while (sent < 0 && errno == EINTR);
+
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            closeConnection(id);
+            return;
+        }
+        conn.sent += static_cast<std::size_t>(sent);
+    }
+    closeConnection(id);
+}
+
+void MetricsExporter::onSweep() {
+    m_sweepTimer.consume();
+
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<ConnectionId> expired;
+    for (const auto& [id, conn] : m_connections) {
+        if (now - conn->openedAt > kConnectionTimeout) expired.push_back(id);
+    }
+    for (const ConnectionId id : expired) closeConnection(id);
+}
+
+void MetricsExporter::closeConnection(ConnectionId id) {
+    auto it = m_connections.find(id);
+    if (it == m_connections.end()) return;
+    m_loop.remove(it->second->fd.get());
+    m_connections.erase(it);  // UnixSocket dtor closes the fd
+}
+
+} // namespace cec_control
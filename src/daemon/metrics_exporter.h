@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "../common/event_loop.h"
+#include "../common/timer_source.h"
+#include "../common/unix_socket.h"
+
+namespace cec_control {
+
+/**
+ * Optional HTTP scrape endpoint serving @c Metrics in OpenMetrics text
+ * format, for Prometheus or any collector that speaks its exposition
+ * format.
+ *
+ * Runs entirely on the main event loop next to @c SocketServer: the
+ * listener and every connection are non-blocking fds registered with
+ * the same @c EventLoop, and a request is answered from
+ * @c Metrics::renderOpenMetrics, which reads the registry with relaxed
+ * atomic loads only. A scrape therefore never blocks the loop and
+ * never takes a lock the adapter worker holds.
+ *
+ * The HTTP side is deliberately minimal: one @c GET per connection,
+ * answered with @c Connection: close. @c /metrics (and @c /) return
+ * the report; any other path is 404, any other method 405. Peers that
+ * stall are closed by a periodic sweep after @c kConnectionTimeout.
+ *
+ * Listens on TCP, IPv4 numeric address only, so a typo cannot
+ * silently resolve to a public interface. Intended for loopback or a
+ * trusted management network; there is no authentication.
+ */
+class MetricsExporter {
+public:
+    /** Upper bound on simultaneous scrape connections. Excess accepts close. */
+    static constexpr std::size_t kMaxConnections = 4;
+
+    /** Close a connection that has not completed its exchange by then. */
+    static constexpr auto kConnectionTimeout = std::chrono::seconds(10);
+
+    /** Largest request head accepted before the connection is dropped. */
+    static constexpr std::size_t kMaxRequestSize = 4096;
+
+    /**
+     * @param loop   Non-owning reference; must outlive *this.
+     * @param listen @c ADDRESS:PORT to bind, e.g. @c 127.0.0.1:9750.
+     */
+    MetricsExporter(EventLoop& loop, std::string listen);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&)            = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * Bind, listen and register with the event loop. Returns false on
+     * any step (including a malformed listen address); a partial setup
+     * is rolled back before the call returns.
+     */
+    [[nodiscard]] bool start();
+
+    /** Close the listener and every connection. Idempotent. */
+    void stop();
+
+private:
+    using ConnectionId = std::uint64_t;
+    struct Connection;
+
+    void onAcceptReady();
+    void onConnectionEvent(ConnectionId id, std::uint32_t events);
+    void onSweep();
+
+    /** Read what the peer sent; once the head is complete, queue the reply. */
+    void readRequest(ConnectionId id, Connection& conn);
+
+    /** Write queued reply bytes; closes the connection once all are out. */
+    void writeResponse(ConnectionId id, Connection& conn);
+
+    void closeConnection(ConnectionId id);
+
+    EventLoop&  m_loop;
+    std::string m_listen;
+    // UnixSocket is used here purely as the owning fd wrapper; the
+    // descriptors are AF_INET.
+    UnixSocket  m_listener;
+    TimerSource m_sweepTimer;
+
+    std::unordered_map<ConnectionId, std::unique_ptr<Connection>> m_connections;
+    ConnectionId m_nextId = 1;
+
+    std::array<char, 1024> m_readBuffer{};
+};
+
+} // namespace cec_control
@@ -0,0 +1,535 @@
+#include "network_server.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <utility>
+
+#include "../common/event_poller.h"
+#include "../common/inet_address.h"
+#include "../common/logger.h"
+#include "../common/loop_timer.h"
+#include "../common/network_token.h"
+#include "../common/trace.h"
+#include "metrics.h"
+
+namespace cec_control {
+
+namespace {
+
+constexpr int LISTEN_BACKLOG = 16;
+
+constexpr std::uint32_t READ_BIT  = static_cast<std::uint32_t>(EventPoller::Event::READ);
+constexpr std::uint32_t WRITE_BIT = static_cast<std::uint32_t>(EventPoller::Event::WRITE);
+constexpr std::uint32_t EDGE_BIT  = static_cast<std::uint32_t>(EventPoller::Event::EDGE);
+
+// A controller that vanishes without a FIN is noticed after about
+// a minute and a half: idle for 60 s, then three unanswered probes.
+constexpr int kKeepaliveIdleSeconds     = 60;
+constexpr int kKeepaliveIntervalSeconds = 10;
+constexpr int kKeepaliveProbes          = 3;
+
+// Marks RequestOptions::session as a network connection, so its ids
+// never meet the Unix socket's session ids.
+constexpr std::uint64_t kSessionTag = std::uint64_t{1} << 63;
+
+void setIntOption(int fd, int level, int name, int value) {
+    (void)::setsockopt(fd, level, name, &value, sizeof(value));
+}
+
+/**
+ * Compare a presented token with the expected one in time that depends
+ * only on the expected token's length, so response timing cannot be
+ * used to guess it a byte at a time.
+ */
+bool tokenMatches(const std::string& expected, const std::uint8_t* presented,
+                  std::size_t len) noexcept {
+    std::size_t diff = expected.size() ^ len;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        const std::uint8_t byte = i < len ? presented[i] : 0;
+        diff |= static_cast<std::uint8_t>(expected[i]) ^ byte;
+    }
+    return diff == 0;
+}
+
+} // namespace
+
+/**
+ * One controller connection. Input is parsed a frame at a time from
+ * the front of @c input; replies are appended to @c output and written
+ * from @c outputSent on.
+ *
+ * Invariants, maintained by @c updateInterest:
+ *   - READ is in the epoll mask iff @c readable: not @c closing, below
+ *     the in-flight cap, with room in @c input and less than
+ *     @c kMaxQueuedOutput unsent.
+ *   - WRITE is in the mask iff output is unsent and no end-of-pass
+ *     flush is queued.
+ *   - @c handshakeTimer is armed iff not yet @c authenticated.
+ */
+struct NetworkServer::Connection {
+    Connection(UnixSocket f, std::uint32_t h, std::string p, EventLoop& loop)
+        : fd(std::move(f)), host(h), peer(std::move(p)), handshakeTimer(loop) {}
+
+    UnixSocket                fd;
+    std::uint32_t             host;  ///< Peer IPv4 address, network order.
+    std::string               peer;  ///< A.B.C.D:PORT, for log lines.
+    LoopTimer                 handshakeTimer;
+    bool                      authenticated = false;
+    bool                      closing       = false;  ///< Refused; close once output is out.
+    bool                      processing    = false;  ///< Inside processInput.
+    bool                      flushQueued   = false;
+    std::size_t               inFlight      = 0;
+    std::uint32_t             interest      = READ_BIT;
+    std::vector<std::uint8_t> input;
+    std::vector<std::uint8_t> output;
+    std::size_t               outputSent    = 0;
+
+    [[nodiscard]] bool readable() const noexcept {
+        return !closing && inFlight < kMaxInFlightPerConnection &&
+               input.size() < kInputCapacity &&
+               output.size() - outputSent < kMaxQueuedOutput;
+    }
+};
+
+NetworkServer::NetworkServer(EventLoop& loop, std::string listen, std::string tokenFile,
+                             ClientRateLimit rateLimit)
+    : m_loop(loop), m_listen(std::move(listen)), m_tokenFile(std::move(tokenFile)),
+      m_rateLimiter(rateLimit) {}
+
+NetworkServer::~NetworkServer() {
+    stop();
+}
+
+void NetworkServer::setCommandHandler(CommandHandler handler) {
+    m_handler = std::move(handler);
+}
+
+bool NetworkServer::readToken() {
+    if (m_tokenFile.empty()) {
+        LOG_ERROR("NetworkListen is set but NetworkTokenFile is not");
+        return false;
+    }
+    std::string error;
+    auto token = readNetworkToken(m_tokenFile, error);
+    if (!token) {
+        LOG_ERROR("Network token: ", error);
+        return false;
+    }
+    struct stat st{};
+    if (::stat(m_tokenFile.c_str(), &st) == 0 && (st.st_mode & S_IROTH) != 0) {
+        LOG_WARNING("Network token file ", m_tokenFile,
+                    " is readable by every user; restrict it with chmod o-r");
+    }
+    m_token = std::move(*token);
+    return true;
+}
+
+bool NetworkServer::start() {
+    if (m_listener.valid()) return true;
+    if (!readToken()) return false;
+
+    const auto addr = parseInetAddress(m_listen);
+    if (!addr) {
+        LOG_ERROR("Invalid network listen address (want A.B.C.D:PORT): ", m_listen);
+        return false;
+    }
+
+    UnixSocket listener(::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+    if (!listener.valid()) {
+        LOG_ERROR("Network endpoint socket() failed: ", std::strerror(errno));
+        return false;
+    }
+    setIntOption(listener.get(), SOL_SOCKET, SO_REUSEADDR, 1);
+    if (::bind(listener.get(), reinterpret_cast<const sockaddr*>(&*addr),
+               sizeof(*addr)) < 0) {
+        LOG_ERROR("Network endpoint bind(", m_listen, ") failed: ", std::strerror(errno));
+        return false;
+    }
+    if (::listen(listener.get(), LISTEN_BACKLOG) < 0) {
+        LOG_ERROR("Network endpoint listen() failed: ", std::strerror(errno));
+        return false;
+    }
+    m_listener = std::move(listener);
+
+    // Edge-triggered: onAcceptReady accepts until EAGAIN.
+    if (!m_loop.add(m_listener.get(), READ_BIT | EDGE_BIT,
+                    [this](std::uint32_t) { onAcceptReady(); })) {
+        LOG_ERROR("Failed to register network listener with event loop");
+        m_listener.reset();
+        return false;
+    }
+
+    LOG_INFO("Network control endpoint listening on ", m_listen);
+    return true;
+}
+
+void NetworkServer::stop() {
+    if (!m_listener.valid() && m_connections.empty()) return;
+
+    if (m_listener.valid()) {
+        m_loop.remove(m_listener.get());
+        m_listener.reset();
+    }
+    for (auto& [_, conn] : m_connections) {
+        m_loop.remove(conn->fd.get());
+    }
+    m_connections.clear();
+    m_authenticated = 0;
+    m_flushQueue.clear();
+
+    LOG_INFO("Network control endpoint stopped");
+}
+
+void NetworkServer::onAcceptReady() {
+    if (!m_listener.valid()) return;
+
+    while (true) {
+        sockaddr_in addr{};
+        socklen_t   addrLen = sizeof(addr);
+        UnixSocket client(::accept4(m_listener.get(), reinterpret_cast<sockaddr*>(&addr),
+                                    &addrLen, SOCK_NONBLOCK | SOCK_CLOEXEC));
+        if (!client.valid()) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            LOG_WARNING("Network endpoint accept() failed: ", std::strerror(errno));
+            return;
+        }
+        std::string peer = formatInetAddress(addr);
+        if (m_connections.size() - m_authenticated >= kMaxPendingConnections) {
+            LOG_WARNING("Too many network connections awaiting their hello; closing "
+                        "connection from ", peer);
+            continue;  // UnixSocket dtor closes the fresh fd
+        }
+
+        // Replies are small and latency is the point; never wait to
+        // coalesce them.
+        setIntOption(client.get(), IPPROTO_TCP, TCP_NODELAY, 1);
+        setIntOption(client.get(), SOL_SOCKET, SO_KEEPALIVE, 1);
+        setIntOption(client.get(), IPPROTO_TCP, TCP_KEEPIDLE, kKeepaliveIdleSeconds);
+        setIntOption(client.get(), IPPROTO_TCP, TCP_KEEPINTVL, kKeepaliveIntervalSeconds);
+        setIntOption(client.get(), IPPROTO_TCP, TCP_KEEPCNT, kKeepaliveProbes);
+
+        const ConnectionId id = m_nextId++;
+        auto conn = std::make_unique<Connection>(std::move(client), addr.sin_addr.s_addr,
+                                                 std::move(peer), m_loop);
+        conn->input.reserve(kInputCapacity);
+        conn->handshakeTimer.setHandler([this, id] {
+            if (Connection* c = findConnection(id)) {
+                LOG_WARNING("Network peer ", c->peer, " did not authenticate in time");
+                Metrics::getInstance().increment(Metrics::Counter::NetworkAuthFailures);
+            }
+            closeConnection(id);
+        });
+        if (!conn->handshakeTimer.armOnce(
+                std::chrono::duration_cast<std::chrono::milliseconds>(kHandshakeTimeout))) {
+            LOG_WARNING("Failed to arm handshake deadline; closing connection from ",
+                        conn->peer);
+            continue;
+        }
+        if (!m_loop.add(conn->fd.get(), READ_BIT,
+                        [this, id](std::uint32_t events) { onConnectionEvent(id, events); })) {
+            LOG_WARNING("Failed to register network connection with event loop");
+            continue;
+        }
+        LOG_DEBUG("Network connection ", id, " from ", conn->peer);
+        m_connections.emplace(id, std::move(conn));
+    }
+}
+
+void NetworkServer::onConnectionEvent(ConnectionId id, std::uint32_t events) {
+    if (events & WRITE_BIT) {
+        if (!drainOutput(id)) return;
+    }
+    Connection* conn = findConnection(id);
+    if (!conn) return;
+    if (events & READ_BIT) {
+        readInput(id, *conn);
+        return;
+    }
+    if (events & EventPoller::ERROR_EVENTS) closeConnection(id);
+}
+
+void NetworkServer::readInput(ConnectionId id, Connection& conn) {
+    const std::size_t room = kInputCapacity - conn.input.size();
+    if (conn.closing || room == 0) return;
+
+    ssize_t received = 0;
+    do {
+        received = ::recv(conn.fd.get(), m_readBuffer.data(), room, 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (received <= 0) {
+        LOG_DEBUG("Network peer ", conn.peer, " disconnected");
+        closeConnection(id);
+        return;
+    }
+    conn.input.insert(conn.input.end(), m_readBuffer.data(),
+                      m_readBuffer.data() + received);
+    processInput(id);
+}
+
+void NetworkServer::processInput(ConnectionId id) {
+    Connection* conn = findConnection(id);
+    if (!conn || conn->processing) return;
+    conn->processing = true;
+
+    std::size_t consumed = 0;
+    while (!conn->closing && conn->inFlight < kMaxInFlightPerConnection) {
+        const std::size_t available = conn->input.size() - consumed;
+        if (available < kStreamPrefixSize) break;
+        const std::uint8_t* prefix = conn->input.data() + consumed;
+        const std::size_t   len    = prefix[0] | (static_cast<std::size_t>(prefix[1]) << 8);
+        if (len == 0 || len > MAX_FRAME_SIZE) {
+            LOG_WARNING("Bad frame length ", len, " from network peer ", conn->peer,
+                        ", closing");
+            closeConnection(id);
+            return;
+        }
+        if (available < kStreamPrefixSize + len) break;
+        consumed += kStreamPrefixSize + len;
+        // The frame is parsed into a Message before anything runs, so
+        // the input may be compacted once the loop is done.
+        if (!processFrame(id, *conn, prefix + kStreamPrefixSize, len)) return;
+    }
+
+    conn->input.erase(conn->input.begin(),
+                      conn->input.begin() + static_cast<std::ptrdiff_t>(consumed));
+    conn->processing = false;
+    (void)updateInterest(id, *conn);
+}
+
+bool NetworkServer::processFrame(ConnectionId id, Connection& conn,
+                                 const std::uint8_t* frame, std::size_t len) {
+    auto request = deserializeFrame(kProtocolVersion, frame, len);
+    if (!request) {
+        LOG_WARNING("Malformed frame from network peer ", conn.peer, ", closing");
+        closeConnection(id);
+        return false;
+    }
+    if (!conn.authenticated) {
+        authenticate(id, conn, *request);
+        return true;
+    }
+
+    const RequestId requestId = request->requestId;
+    const bool      noReply   = request->options.noReply;
+    ++conn.inFlight;
+    const auto fail = [&] {
+        if (noReply) {
+            retireSilently(id);
+        } else {
+            sendResponse(id, requestId, Message(MessageType::RESP_ERROR));
+        }
+    };
+    if (request->message.type == MessageType::CMD_HELLO) {
+        LOG_WARNING("Hello from network peer ", conn.peer, " after it authenticated");
+        fail();
+        return findConnection(id) != nullptr;
+    }
+    if (request->message.type == MessageType::CMD_SUBSCRIBE || !m_handler) {
+        fail();
+        return findConnection(id) != nullptr;
+    }
+    // As on the Unix socket, a key release is never refused.
+    if (request->message.type != MessageType::CMD_KEY_UP && !takeRateToken(conn)) {
+        Metrics::getInstance().increment(Metrics::Counter::RateLimited);
+        if (noReply) {
+            retireSilently(id);
+        } else {
+            sendResponse(id, requestId, Message(MessageType::RESP_RATE_LIMITED));
+        }
+        return findConnection(id) != nullptr;
+    }
+
+    const TraceScope span(TracePoint::SocketRequest,
+                          static_cast<uint32_t>(request->message.type));
+    request->options.session = kSessionTag | id;
+    try {
+        m_handler(std::move(request->message),
+                  makeSink(id, requestId, request->message.type, noReply),
+                  request->options);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Handler threw for network peer ", conn.peer, ": ", e.what());
+        fail();
+    } catch (...) {
+        LOG_ERROR("Handler threw non-std exception for network peer ", conn.peer);
+        fail();
+    }
+    return findConnection(id) != nullptr;
+}
+
+void NetworkServer::authenticate(ConnectionId id, Connection& conn, const Frame& hello) {
+    const Message& message = hello.message;
+    const bool ok = message.type == MessageType::CMD_HELLO && !message.data.empty() &&
+                    message.data[0] >= kProtocolVersion &&
+                    tokenMatches(m_token, message.data.data() + 1, message.data.size() - 1);
+    conn.handshakeTimer.disarm();
+    if (!ok) {
+        LOG_WARNING("Network peer ", conn.peer, " failed to authenticate; closing");
+        Metrics::getInstance().increment(Metrics::Counter::NetworkAuthFailures);
+        conn.closing = true;
+        queueFrame(id, conn, hello.requestId, Message(MessageType::RESP_ERROR));
+        return;
+    }
+    if (m_authenticated >= kMaxConnections) {
+        LOG_WARNING("Network connection limit reached; closing connection from ", conn.peer);
+        conn.closing = true;
+        queueFrame(id, conn, hello.requestId, Message(MessageType::RESP_BUSY));
+        return;
+    }
+    conn.authenticated = true;
+    ++m_authenticated;
+    LOG_INFO("Network peer ", conn.peer, " authenticated");
+    queueFrame(id, conn, hello.requestId,
+               Message(MessageType::RESP_SUCCESS, 0, {kProtocolVersion}));
+}
+
+bool NetworkServer::takeRateToken(const Connection& conn) {
+    const auto verdict = m_rateLimiter.take(conn.host);
+    // Once per episode, not once per refused request.
+    if (verdict == RateLimiter<std::uint32_t>::Verdict::FirstRefused) {
+        LOG_WARNING("Requests from network peer ", conn.peer, " exceed ",
+                    m_rateLimiter.limit().perSecond,
+                    "/s; refusing them until the controller slows down");
+    }
+    return verdict == RateLimiter<std::uint32_t>::Verdict::Allowed;
+}
+
+void NetworkServer::sendResponse(ConnectionId id, RequestId requestId, Message response) {
+    const TraceScope span(TracePoint::SocketSend, static_cast<uint32_t>(response.type));
+    Connection* conn = findConnection(id);
+    if (!conn) return;  // closed; drop silently
+    if (conn->inFlight > 0) --conn->inFlight;
+    queueFrame(id, *conn, requestId, response);
+    // The freed slot may admit a frame already buffered.
+    processInput(id);
+}
+
+void NetworkServer::retireSilently(ConnectionId id) {
+    Connection* conn = findConnection(id);
+    if (!conn) return;
+    if (conn->inFlight > 0) --conn->inFlight;
+    processInput(id);
+}
+
+void NetworkServer::queueFrame(ConnectionId id, Connection& conn, RequestId requestId,
+                               const Message& response) {
+    const std::size_t len = serializeFrameTo(
+        kProtocolVersion, requestId, RequestOptions{}, response,
+        m_sendBuffer.data() + kStreamPrefixSize, m_sendBuffer.size() - kStreamPrefixSize);
+    if (len == 0) {
+        LOG_ERROR("Response type=", static_cast<int>(response.type), " of ",
+                  response.data.size(), " bytes exceeds MAX_MESSAGE_SIZE; dropped");
+        return;
+    }
+    m_sendBuffer[0] = static_cast<std::uint8_t>(len & 0xFF);
+    m_sendBuffer[1] = static_cast<std::uint8_t>(len >> 8);
+    conn.output.insert(conn.output.end(), m_sendBuffer.data(),
+                       m_sendBuffer.data() + kStreamPrefixSize + len);
+    scheduleFlush(id, conn);
+}
+
+void NetworkServer::scheduleFlush(ConnectionId id, Connection& conn) {
+    if (conn.flushQueued) return;
+    if (conn.interest & WRITE_BIT) return;  // socket full; WRITE flushes it
+    conn.flushQueued = true;
+    m_flushQueue.push_back(id);
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        m_loop.defer([this] { flushSends(); });
+    }
+}
+
+void NetworkServer::flushSends() {
+    m_flushScheduled = false;
+    m_flushing.swap(m_flushQueue);
+    for (const ConnectionId id : m_flushing) {
+        Connection* conn = findConnection(id);
+        if (!conn) continue;
+        conn->flushQueued = false;
+        (void)drainOutput(id);
+    }
+    m_flushing.clear();
+}
+
+bool NetworkServer::drainOutput(ConnectionId id) {
+    Connection* conn = findConnection(id);
+    if (!conn) return false;
+
+    while (conn->outputSent < conn->output.size()) {
+        ssize_t sent = 0;
+        do {
+            sent = ::send(conn->fd.get(), conn->output.data() + conn->outputSent,
+                          conn->output.size() - conn->outputSent, MSG_NOSIGNAL);
+        } while (sent < 0 && errno == EINTR);
+
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            LOG_DEBUG("send() failed for network peer ", conn->peer, ": ",
+                      std::strerror(errno));
+            closeConnection(id);
+            return false;
+        }
+        conn->outputSent += static_cast<std::size_t>(sent);
+    }
+    if (conn->outputSent == conn->output.size()) {
+        conn->output.clear();
+        conn->outputSent = 0;
+        if (conn->closing) {
+            closeConnection(id);
+            return false;
+        }
+    }
+    return updateInterest(id, *conn);
+}
+
+bool NetworkServer::updateInterest(ConnectionId id, Connection& conn) {
+    std::uint32_t mask = 0;
+    if (conn.readable()) mask |= READ_BIT;
+    if (!conn.flushQueued && conn.outputSent < conn.output.size()) mask |= WRITE_BIT;
+    if (mask == conn.interest) return true;
+    if (!m_loop.modify(conn.fd.get(), mask)) {
+        LOG_WARNING("Failed to update interest for network peer ", conn.peer, "; closing");
+        closeConnection(id);
+        return false;
+    }
+    conn.interest = mask;
+    return true;
+}
+
+void NetworkServer::closeConnection(ConnectionId id) {
+    auto it = m_connections.find(id);
+    if (it == m_connections.end()) return;
+    if (it->second->authenticated) --m_authenticated;
+    m_loop.remove(it->second->fd.get());
+    m_connections.erase(it);  // UnixSocket dtor closes the fd
+}
+
+NetworkServer::Connection* NetworkServer::findConnection(ConnectionId id) noexcept {
+    auto it = m_connections.find(id);
+    return it == m_connections.end() ? nullptr : it->second.get();
+}
+
+ResponseSink NetworkServer::makeSink(ConnectionId id, RequestId requestId, MessageType type,
+                                     bool noReply) {
+    return [this, id, requestId, type, noReply,
+            start = std::chrono::steady_clock::now()](Message response) {
+        Metrics::getInstance().recordDispatch(
+            type, std::chrono::steady_clock::now() - start);
+        if (noReply) {
+            retireSilently(id);
+        } else {
+            sendResponse(id, requestId, std::move(response));
+        }
+    };
+}
+
+} // namespace cec_control
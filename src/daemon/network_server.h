@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/event_loop.h"
+#include "../common/messages.h"
+#include "../common/unix_socket.h"
+#include "rate_limiter.h"
+#include "socket_server.h"
+
+namespace cec_control {
+
+/**
+ * Optional TCP control endpoint, for a controller that drives many
+ * daemons over the network and wants to keep one connection to each
+ * rather than pay an SSH handshake per command.
+ *
+ * Speaks the control socket's protocol over a byte stream: every frame
+ * carries its length in front (see @c kStreamPrefixSize) and uses
+ * version 2 framing throughout, so request ids, per-request flags and
+ * extensions, pipelining and CMD_BATCH all work as on the Unix socket.
+ * Requests go to the same @c SocketServer::CommandHandler. Event
+ * subscriptions are not served here; CMD_SUBSCRIBE is answered
+ * RESP_ERROR.
+ *
+ * A connection must open with a CMD_HELLO carrying the token read from
+ * the configured token file, within @c kHandshakeTimeout. A wrong token
+ * or any other first frame is answered RESP_ERROR, and the connection
+ * closed once the reply is out, with nothing behind it read. There
+ * is no transport encryption: bind to loopback, a management VLAN or a
+ * VPN interface, or put a TLS terminator in front.
+ *
+ * Runs on the main event loop next to @c SocketServer and shares its
+ * shape: at most @c kMaxInFlightPerConnection requests outstanding per
+ * connection, beyond which the connection is not read until a reply
+ * goes out, and replies gathered into one send per connection at the
+ * end of each loop pass. Authenticated connections have no idle
+ * timeout; TCP keepalive closes one whose controller has gone away.
+ *
+ * Connections still to authenticate are capped apart from the rest
+ * (@c kMaxPendingConnections), so peers that connect and never say
+ * hello cannot take the slots of real controllers. With a
+ * @c ClientRateLimit, each peer address's authenticated requests draw
+ * on a token bucket, as each user's do on the Unix socket.
+ */
+class NetworkServer {
+public:
+    using CommandHandler = SocketServer::CommandHandler;
+
+    /** Authenticated connections served at once; beyond this a hello is refused. */
+    static constexpr std::size_t kMaxConnections = 64;
+
+    /** Connections awaiting their hello at once; beyond this new ones are closed. */
+    static constexpr std::size_t kMaxPendingConnections = 8;
+
+    /** Requests one connection may have awaiting a reply at once. */
+    static constexpr std::size_t kMaxInFlightPerConnection = 16;
+
+    /** Close a connection that has not authenticated by then. */
+    static constexpr auto kHandshakeTimeout = std::chrono::seconds(5);
+
+    /**
+     * @param loop       Non-owning reference; must outlive *this.
+     * @param listen     @c ADDRESS:PORT to bind, e.g. @c 10.0.0.5:9751.
+     * @param tokenFile  File holding the shared token; see @c start.
+     * @param rateLimit  Requests each peer address may send.
+     */
+    NetworkServer(EventLoop& loop, std::string listen, std::string tokenFile,
+                  ClientRateLimit rateLimit = {});
+    ~NetworkServer();
+
+    NetworkServer(const NetworkServer&)            = delete;
+    NetworkServer& operator=(const NetworkServer&) = delete;
+
+    /**
+     * Read the token, bind, listen and register with the event loop.
+     * The token is the file's content less trailing whitespace,
+     * @c kMinNetworkTokenLength to @c kMaxNetworkTokenLength bytes.
+     * Returns false on any step, with the reason logged; a partial
+     * setup is rolled back before the call returns.
+     */
+    [[nodiscard]] bool start();
+
+    /** Close the listener and every connection. Idempotent. */
+    void stop();
+
+    /** Install/replace the per-request handler. Install before @c start(). */
+    void setCommandHandler(CommandHandler handler);
+
+private:
+    using ConnectionId = std::uint64_t;
+    struct Connection;
+
+    /** Input held per connection: room for one frame of the largest size. */
+    static constexpr std::size_t kInputCapacity = kStreamPrefixSize + MAX_FRAME_SIZE;
+
+    /** Unsent reply bytes past which a connection is not read. */
+    static constexpr std::size_t kMaxQueuedOutput = 64 * 1024;
+
+    /** Load and check @c m_token from @c m_tokenFile. */
+    [[nodiscard]] bool readToken();
+
+    void onAcceptReady();
+    void onConnectionEvent(ConnectionId id, std::uint32_t events);
+
+    /** Append what the socket has to the connection's input, then parse it. */
+    void readInput(ConnectionId id, Connection& conn);
+
+    /**
+     * Dispatch every complete frame in the input that the in-flight cap
+     * admits. Re-entrant calls, from a reply sent during dispatch, are
+     * no-ops; the outer loop picks up the slot they freed.
+     */
+    void processInput(ConnectionId id);
+
+    /** Handle one frame; false if the connection was closed. */
+    bool processFrame(ConnectionId id, Connection& conn, const std::uint8_t* frame,
+                      std::size_t len);
+
+    /** Check a hello's token and answer it. */
+    void authenticate(ConnectionId id, Connection& conn, const Frame& hello);
+
+    /** Spend one of @p conn's peer's tokens; false if it has none left. */
+    [[nodiscard]] bool takeRateToken(const Connection& conn);
+
+    /** Answer request @p requestId on @p id, if it is still open. Main thread. */
+    void sendResponse(ConnectionId id, RequestId requestId, Message response);
+
+    /** Retire a no-reply request whose response is discarded. */
+    void retireSilently(ConnectionId id);
+
+    /** Frame @p response onto @p conn's output; no in-flight accounting. */
+    void queueFrame(ConnectionId id, Connection& conn, RequestId requestId,
+                    const Message& response);
+
+    /** Queue @p id for the end-of-pass flush. */
+    void scheduleFlush(ConnectionId id, Connection& conn);
+    void flushSends();
+
+    /** Write what @p id has queued; false if the connection was closed. */
+    bool drainOutput(ConnectionId id);
+
+    /** Bring @p conn's epoll mask in line with its state; false if it was closed. */
+    bool updateInterest(ConnectionId id, Connection& conn);
+
+    void closeConnection(ConnectionId id);
+    [[nodiscard]] Connection* findConnection(ConnectionId id) noexcept;
+
+    /** Sink answering request @p requestId on @p id; see @c SocketServer::makeSink. */
+    ResponseSink makeSink(ConnectionId id, RequestId requestId, MessageType type,
+                          bool noReply);
+
+    EventLoop&     m_loop;
+    std::string    m_listen;
+    std::string    m_tokenFile;
+    std::string    m_token;
+    // UnixSocket is used here purely as the owning fd wrapper; the
+    // descriptors are AF_INET, as in MetricsExporter.
+    UnixSocket     m_listener;
+    CommandHandler m_handler;
+
+    std::unordered_map<ConnectionId, std::unique_ptr<Connection>> m_connections;
+    ConnectionId m_nextId = 1;
+    std::size_t  m_authenticated = 0;  ///< Of @c m_connections.
+
+    // Keyed on the peer's IPv4 address, so a controller's connections
+    // share one bucket.
+    RateLimiter<std::uint32_t> m_rateLimiter;
+
+    // Shared by every connection's reads, which are serialised on the
+    // main thread.
+    std::array<std::uint8_t, kInputCapacity> m_readBuffer{};
+
+    // Serialisation scratch for one outgoing frame, length prefix included.
+    std::array<std::uint8_t, kStreamPrefixSize + MAX_FRAME_SIZE> m_sendBuffer{};
+
+    // Connections with output to flush at the end of this loop pass.
+    std::vector<ConnectionId> m_flushQueue;
+    std::vector<ConnectionId> m_flushing;
+    bool                      m_flushScheduled = false;
+};
+
+} // namespace cec_control
@@ -0,0 +1,138 @@
+#include "observation_bus.h"
+
+#include "../common/logger.h"
+#include "../common/main_thread_work.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <utility>
+
+namespace cec_control {
+
+ObservationBus::ObservationBus(MainThreadWork& overflow) : m_overflow(overflow) {
+    for (std::size_t i = 0; i < kCapacity; ++i) {
+        m_slots[i].turn.store(i, std::memory_order_relaxed);
+    }
+    m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeFd < 0) {
+        LOG_ERROR("Failed to create ObservationBus eventfd: ", std::strerror(errno));
+    }
+}
+
+ObservationBus::~ObservationBus() {
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+        m_wakeFd = -1;
+    }
+}
+
+void ObservationBus::subscribe(KindMask kinds, Consumer consumer) {
+    if (!consumer || kinds == 0) return;
+    m_subscriptions.push_back(Subscription{kinds, std::move(consumer)});
+}
+
+void ObservationBus::publish(const Observation& obs) noexcept {
+    // While overflow posts are outstanding, later observations follow
+    // them through the work queue too, or they could overtake.
+    if (m_overflowing.load(std::memory_order_acquire) == 0 && tryPush(obs)) {
+        wake();
+        return;
+    }
+    // Full: the main thread is far behind. Drain ahead of this one so
+    // it is delivered after what the ring already holds.
+    m_overflowing.fetch_add(1, std::memory_order_acq_rel);
+    m_overflow.post([this, obs]() {
+        drain();
+        deliver(obs);
+        m_overflowing.fetch_sub(1, std::memory_order_acq_rel);
+    });
+}
+
+bool ObservationBus::tryPush(const Observation& obs) noexcept {
+    std::size_t pos = m_pushPos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_slots[pos & kMask];
+        const std::size_t turn = slot.turn.load(std::memory_order_acquire);
+        const auto lag = static_cast<std::ptrdiff_t>(turn - pos);
+        if (lag == 0) {
+            if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.obs = obs;
+                slot.turn.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (lag < 0) {
+            return false;  // The slot still holds an undrained lap.
+        } else {
+            pos = m_pushPos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void ObservationBus::wake() noexcept {
+    // Same coalescing as MainThreadWork: the first push since the last
+    // drain writes the eventfd, the rest of the burst rides on it.
+    if (m_wakePending.exchange(true, std::memory_order_acq_rel)) return;
+    if (m_wakeFd < 0) return;
+    const uint64_t one = 1;
+    ssize_t r = ::write(m_wakeFd, &one, sizeof(one));
+    (void)r;  // Best-effort wake; counter saturation is harmless.
+}
+
+void ObservationBus::drain() {
+    if (m_wakeFd >= 0) {
+        uint64_t scratch;
+        while (::read(m_wakeFd, &scratch, sizeof(scratch)) > 0) {
+        }
+    }
+    // Re-open the wake before collecting, so a push that lands after
+    // the loop below has stopped writes the eventfd again.
+    m_wakePending.exchange(false, std::memory_order_acq_rel);
+
+    for (;;) {
+        Slot& slot = m_slots[m_popPos & kMask];
+        if (slot.turn.load(std::memory_order_acquire) != m_popPos + 1) break;
+        const Observation obs = slot.obs;
+        slot.turn.store(m_popPos + kCapacity, std::memory_order_release);
+        ++m_popPos;
+        deliver(obs);
+    }
+}
+
+void ObservationBus::deliver(const Observation& obs) {
+    const KindMask bit = kindBit(obs.kind);
+    for (const Subscription& sub : m_subscriptions) {
+        if ((sub.kinds & bit) == 0) continue;
+        try {
+            sub.consumer(obs);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Observation consumer threw: ", e.what());
+        } catch (...) {
+            LOG_ERROR("Observation consumer threw non-std exception");
+        }
+    }
+}
+
+std::optional<uint8_t> ObservationBus::heardFrom(const Observation& obs) noexcept {
+    switch (obs.kind) {
+    case Kind::TvStandby:
+    case Kind::TvPowerReport:
+        return static_cast<uint8_t>(CEC::CECDEVICE_TV);
+    case Kind::PowerReport:
+    case Kind::PhysicalAddressReport:
+    case Kind::ActiveSource:
+        if (obs.logical == CEC::CECDEVICE_UNKNOWN) return std::nullopt;
+        return static_cast<uint8_t>(obs.logical);
+    case Kind::RawFrame:
+        return obs.frame.initiator;
+    case Kind::HostActivated:
+    case Kind::HostDeactivated:
+        break;
+    }
+    return std::nullopt;
+}
+
+} // namespace cec_control
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "cec/adapter_interface.h"
+
+namespace cec_control {
+
+class MainThreadWork;
+
+/**
+ * Fan-out of adapter observations to the daemon's consumers, from the
+ * backend threads that produce them to the main thread that acts on
+ * them.
+ *
+ * A producer copies each observation into a fixed ring of
+ * @c kCapacity slots — a claim and a release store, no allocation —
+ * and writes the bus's eventfd only when no wake is already pending.
+ * The main thread's @c drain then hands every queued observation to
+ * each consumer whose kind filter includes it, in arrival order. The
+ * burst of frames a TV sends on an input switch costs one wakeup and
+ * one pass over the consumers, instead of a closure per frame.
+ *
+ * The ring takes several producers: libcec delivers bus commands and
+ * active-source changes on two different threads. There is only ever
+ * one consumer.
+ *
+ * A full ring does not lose an observation. The producer posts it
+ * through @c MainThreadWork instead, as a closure that drains the
+ * ring before delivering it, and later observations take the same
+ * route until those posts have run, so each producer's observations
+ * still reach consumers in the order it published them.
+ */
+class ObservationBus {
+public:
+    using Observation = ICecAdapter::Observation;
+    using Kind        = Observation::Kind;
+
+    /** A consumer; runs on the main thread inside @c drain. */
+    using Consumer = std::function<void(const Observation&)>;
+
+    /** Bitmask over @c Kind, one bit per kind. */
+    using KindMask = uint32_t;
+
+    /** Observations queued before producers fall back to posts. A power of two. */
+    static constexpr std::size_t kCapacity = 256;
+
+    [[nodiscard]] static constexpr KindMask kindBit(Kind kind) noexcept {
+        return KindMask{1} << static_cast<unsigned>(kind);
+    }
+
+    /** Every kind. */
+    static constexpr KindMask kAllKinds = ~KindMask{0};
+
+    /**
+     * The device whose frame produced @p obs, if it names one. The
+     * host's own activation changes come from libcec, not from the bus.
+     */
+    [[nodiscard]] static std::optional<uint8_t> heardFrom(const Observation& obs) noexcept;
+
+    /** @param overflow Non-owning; must outlive @c this. Carries what a full ring cannot. */
+    explicit ObservationBus(MainThreadWork& overflow);
+    ~ObservationBus();
+
+    ObservationBus(const ObservationBus&)            = delete;
+    ObservationBus& operator=(const ObservationBus&) = delete;
+
+    /** True if the wake eventfd was created. */
+    [[nodiscard]] bool valid() const noexcept { return m_wakeFd >= 0; }
+
+    /** The fd to register with the event loop (READ); its handler calls @c drain. */
+    [[nodiscard]] int fd() const noexcept { return m_wakeFd; }
+
+    /**
+     * Deliver observations of the kinds in @p kinds to @p consumer,
+     * after those of consumers subscribed earlier. Main thread only.
+     */
+    void subscribe(KindMask kinds, Consumer consumer);
+
+    /** Queue @p obs and wake the main thread. Any thread. */
+    void publish(const Observation& obs) noexcept;
+
+    /**
+     * Deliver every queued observation. Main thread only; safe to
+     * call outside the eventfd handler to flush the ring early.
+     */
+    void drain();
+
+private:
+    struct Slot {
+        // Vyukov's bounded-queue turn counter: equal to the ring
+        // position while free, one past it once filled.
+        std::atomic<std::size_t> turn{0};
+        Observation              obs{};
+    };
+
+    struct Subscription {
+        KindMask kinds;
+        Consumer consumer;
+    };
+
+    /** Claim a slot and fill it; @c false when the ring is full. */
+    [[nodiscard]] bool tryPush(const Observation& obs) noexcept;
+
+    /** Write the eventfd unless a wake is already pending. */
+    void wake() noexcept;
+
+    void deliver(const Observation& obs);
+
+    static constexpr std::size_t kMask = kCapacity - 1;
+    static_assert((kCapacity & kMask) == 0, "ObservationBus capacity must be a power of two");
+
+    MainThreadWork& m_overflow;
+    int             m_wakeFd = -1;
+
+    std::array<Slot, kCapacity> m_slots{};
+    alignas(64) std::atomic<std::size_t> m_pushPos{0};
+    // Main thread only.
+    alignas(64) std::size_t              m_popPos = 0;
+    std::atomic<bool>                    m_wakePending{false};
+    // Overflow posts not yet delivered.
+    std::atomic<uint32_t>                m_overflowing{0};
+
+    std::vector<Subscription> m_subscriptions;
+};
+
+} // namespace cec_control
@@ -13,6 +13,24 @@ void AdapterReconnect::resetCycle() noexcept {
     m_state = State::Idle;
     m_schedule.reset();
     m_nextAttemptNumber = 0;
+    m_appearedDuringAttempt = false;
+}
+
+AdapterReconnect::Output AdapterReconnect::restartCycle() noexcept {
+    m_schedule.reset();
+    m_state = State::Attempting;
+    m_nextAttemptNumber = 1;
+    m_appearedDuringAttempt = false;
+    return {Effect::StartAttempt, {}, /*attemptNumber*/ 1, totalAttempts()};
+}
+
+AdapterReconnect::Output AdapterReconnect::awaitAdapter() noexcept {
+    // The cycle stays open, so a later ConnectionLost is absorbed, but
+    // nothing is armed: only AdapterAppeared (or a suspend/resume
+    // reset) moves it on.
+    m_state = State::WaitingForAdapter;
+    m_nextAttemptNumber = 0;
+    return {Effect::AwaitAdapter, {}, 0, totalAttempts()};
 }
 
 AdapterReconnect::Output
@@ -22,6 +40,10 @@ AdapterReconnect::seedCycle(std::chrono::milliseconds initialDelay) noexcept {
     // beats the post-resume completion through MainThreadWork — the
     // running cycle already covers the adapter-gone condition.
     if (m_state != State::Idle) return {};
+    if (!m_adapterPresent) {
+        m_schedule.reset();
+        return awaitAdapter();
+    }
 
     // Defensive: a clean entry into Idle resets the schedule (see
     // resetCycle), but explicit reset documents that the seeded cycle
@@ -43,11 +65,16 @@ AdapterReconnect::Output AdapterReconnect::onEvent(Event event) noexcept {
         // is stale (an attempt result or timer tick that raced a
         // transition into Idle) or inapplicable (suspend/resume while
         // already at rest).
+        if (event == Event::AdapterRemoved || event == Event::AdapterAppeared) {
+            m_adapterPresent = (event == Event::AdapterAppeared);
+            return {};
+        }
         if (event == Event::ConnectionLost) {
             // Defensive: entry into Idle already resets the schedule,
             // but keeping the reset here makes the starting state
             // locally explicit and mirrors seedCycle.
             m_schedule.reset();
+            if (!m_adapterPresent) return awaitAdapter();
             m_nextAttemptNumber = 1;
             if (m_connectionLostDelay > std::chrono::milliseconds::zero()) {
                 // Hand the hardware a settle window before the first
@@ -72,6 +99,8 @@ AdapterReconnect::Output AdapterReconnect::onEvent(Event event) noexcept {
             return {};
 
         case Event::AttemptFailed: {
+            if (!m_adapterPresent) return awaitAdapter();
+            if (m_appearedDuringAttempt) return restartCycle();
             const auto attempt = m_schedule.nextDelay();
             if (attempt) {
                 // Overall attempt number is one higher than the
@@ -101,8 +130,19 @@ AdapterReconnect::Output AdapterReconnect::onEvent(Event event) noexcept {
 
         case Event::RetryTimerFired:
         case Event::TimerArmFailed:
-            // Unreachable under normal flow. Absorb defensively: a
-            // timerfd read may race a disarm via epoll readiness.
+            // Unreachable under normal flow: disarming a loop timer
+            // cancels its pending expiry. Absorb defensively.
+            return {};
+
+        case Event::AdapterRemoved:
+            // Let the in-flight attempt resolve; its failure parks
+            // the cycle.
+            m_adapterPresent = false;
+            return {};
+
+        case Event::AdapterAppeared:
+            m_appearedDuringAttempt = !m_adapterPresent;
+            m_adapterPresent = true;
             return {};
         }
         break;
@@ -141,6 +181,46 @@ AdapterReconnect::Output AdapterReconnect::onEvent(Event event) noexcept {
             // Attempt results only originate from Attempting. Absorb
             // defensively.
             return {};
+
+        case Event::AdapterRemoved:
+            // No point waking up to probe for a device that is not
+            // there; AwaitAdapter implies the dispatcher disarms.
+            m_adapterPresent = false;
+            return awaitAdapter();
+
+        case Event::AdapterAppeared:
+            // Supersede the pending backoff; StartAttempt implies the
+            // disarm.
+            m_adapterPresent = true;
+            return restartCycle();
+        }
+        break;
+
+    case State::WaitingForAdapter:
+        switch (event) {
+        case Event::AdapterAppeared:
+            m_adapterPresent = true;
+            return restartCycle();
+
+        case Event::AdapterRemoved:
+            m_adapterPresent = false;
+            return {};
+
+        case Event::SystemSuspend:
+        case Event::SystemResume:
+            // Nothing armed; the resume path reopens on its own and
+            // reseeds if that fails.
+            resetCycle();
+            return {};
+
+        case Event::ConnectionLost:
+        case Event::AttemptSucceeded:
+        case Event::AttemptFailed:
+        case Event::RetryTimerFired:
+        case Event::TimerArmFailed:
+            // The open cycle already covers a lost connection; the
+            // rest are stale.
+            return {};
         }
         break;
     }
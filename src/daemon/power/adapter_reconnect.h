@@ -29,13 +29,20 @@ namespace cec_control {
  *    therefore @c schedule.size() + 1 for both entry points.
  *  - @c StartAttempt implies that any armed retry timer is stale. The
  *    dispatcher must @c disarm() the timer before submitting the
- *    attempt; @c TimerSource::disarm is idempotent so the effect
+ *    attempt; @c LoopTimer::disarm is idempotent so the effect
  *    handler can call it unconditionally.
  *  - Stale @c AttemptSucceeded / @c AttemptFailed results arriving
  *    after a lifecycle transition are absorbed as no-ops: the FSM has
  *    already moved to @c Idle in response to @c SystemSuspend /
  *    @c SystemResume, and @c Idle answers every non-@c ConnectionLost
  *    event with @c Effect::None.
+ *  - @c AdapterRemoved / @c AdapterAppeared come from the udev
+ *    hotplug monitor and keep a presence flag that outlives cycles.
+ *    While the adapter is known to be absent a cycle does not retry:
+ *    it parks in @c WaitingForAdapter (@c Effect::AwaitAdapter) and
+ *    starts over at attempt 1 the moment the adapter appears, without
+ *    waiting out a backoff delay. Without a monitor neither event is
+ *    ever fed and the presence flag stays @c true.
  *
  * ## Scope vs. CMD_RESTART_ADAPTER
  *
@@ -62,6 +69,8 @@ public:
         SystemResume,
         RetryTimerFired,
         TimerArmFailed,   ///< Dispatcher failed to arm the retry timer.
+        AdapterRemoved,   ///< udev: the adapter's device node went away.
+        AdapterAppeared,  ///< udev: an adapter's device node appeared.
     };
 
     /**
@@ -73,6 +82,8 @@ public:
      *  - @c ScheduleRetry   arm the retry timer with @c Output::delay.
      *  - @c CancelRetry     disarm the retry timer.
      *  - @c AbandonCycle    log that the cycle has been abandoned.
+     *  - @c AwaitAdapter    disarm the retry timer and log that retries
+     *                       are paused until the adapter is plugged in.
      */
     enum class Effect {
         None,
@@ -80,6 +91,7 @@ public:
         ScheduleRetry,
         CancelRetry,
         AbandonCycle,
+        AwaitAdapter,
     };
 
     /**
@@ -134,7 +146,9 @@ public:
      * silently (returns @c Effect::None) if the FSM is non-Idle — a
      * cycle is already covering the same adapter-gone condition —
      * whereas @c ConnectionLost from @c WaitingForRetry supersedes
-     * the pending retry with an immediate attempt.
+     * the pending retry with an immediate attempt. With the adapter
+     * known to be absent the cycle parks in @c WaitingForAdapter
+     * instead of arming the delay.
      */
     [[nodiscard]] Output seedCycle(std::chrono::milliseconds initialDelay) noexcept;
 
@@ -143,9 +157,10 @@ private:
      * Internal lifecycle. @c Idle is the rest state; @c Attempting is
      * "a reopen is in flight on the adapter worker"; @c
      * WaitingForRetry is "the retry timer is armed for the next
-     * attempt".
+     * attempt"; @c WaitingForAdapter is "a cycle is open but the
+     * adapter is unplugged, so nothing is scheduled".
      */
-    enum class State { Idle, Attempting, WaitingForRetry };
+    enum class State { Idle, Attempting, WaitingForRetry, WaitingForAdapter };
 
     /** Total attempts in the active cycle. Immediate first + scheduled N. */
     [[nodiscard]] std::size_t totalAttempts() const noexcept {
@@ -155,6 +170,12 @@ private:
     /** Return to @c Idle with a fresh schedule and no pending attempt. */
     void resetCycle() noexcept;
 
+    /** Start the cycle over with an immediate attempt 1. */
+    [[nodiscard]] Output restartCycle() noexcept;
+
+    /** Park the open cycle until @c AdapterAppeared. */
+    [[nodiscard]] Output awaitAdapter() noexcept;
+
     State           m_state = State::Idle;
     BackoffSchedule m_schedule;
     /**
@@ -173,6 +194,18 @@ private:
      * exposes no post-advance peek API.
      */
     std::size_t m_nextAttemptNumber = 0;
+    /**
+     * Last presence reported by the hotplug monitor. Deliberately not
+     * touched by @c resetCycle: it describes the hardware, not the
+     * cycle, and must survive suspend/resume resets.
+     */
+    bool m_adapterPresent = true;
+    /**
+     * Set when the adapter reappears while an attempt is in flight;
+     * that attempt probably ran before the device node existed, so
+     * its failure restarts the cycle instead of backing off.
+     */
+    bool m_appearedDuringAttempt = false;
 };
 
 } // namespace cec_control
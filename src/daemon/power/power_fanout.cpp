@@ -0,0 +1,156 @@
+#include "power_fanout.h"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+
+#include "../../common/logger.h"
+#include "../cec/adapter_interface.h"
+#include "../metrics.h"
+
+namespace cec_control {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * What a frame is assumed to cost before any has been timed in the
+ * pass: an acknowledged @c <Standby> on an idle bus takes 30-50ms.
+ */
+constexpr std::chrono::milliseconds kMinFrameCost{50};
+
+/**
+ * Send order: the TV first, since it is the device a user notices left
+ * on, then the audio system, then the rest by address. Whatever the
+ * deadline cuts off is therefore the least visible.
+ */
+constexpr std::array<CEC::cec_logical_address, 15> kFanoutOrder = {
+    CEC::CECDEVICE_TV,
+    CEC::CECDEVICE_AUDIOSYSTEM,
+    CEC::CECDEVICE_RECORDINGDEVICE1,
+    CEC::CECDEVICE_RECORDINGDEVICE2,
+    CEC::CECDEVICE_TUNER1,
+    CEC::CECDEVICE_PLAYBACKDEVICE1,
+    CEC::CECDEVICE_TUNER2,
+    CEC::CECDEVICE_TUNER3,
+    CEC::CECDEVICE_PLAYBACKDEVICE2,
+    CEC::CECDEVICE_RECORDINGDEVICE3,
+    CEC::CECDEVICE_TUNER4,
+    CEC::CECDEVICE_PLAYBACKDEVICE3,
+    CEC::CECDEVICE_RESERVED1,
+    CEC::CECDEVICE_RESERVED2,
+    CEC::CECDEVICE_FREEUSE,
+};
+
+std::chrono::milliseconds since(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+}
+
+std::string_view resultName(PowerFanoutReport::Result result) noexcept {
+    switch (result) {
+        case PowerFanoutReport::Result::Acked:   return "acked";
+        case PowerFanoutReport::Result::Failed:  return "failed";
+        case PowerFanoutReport::Result::Skipped: return "skipped";
+    }
+    return "failed";
+}
+
+/**
+ * Run @p send for each address in @p addresses below the broadcast
+ * address, in @c kFanoutOrder, until @p deadline.
+ *
+ * A device is skipped once the time left is less than the slowest
+ * frame of the pass so far (or @c kMinFrameCost before the first), so
+ * the pass stops before a frame it cannot finish rather than overrunning
+ * the deadline with it.
+ */
+template <typename Send>
+PowerFanoutReport fanOut(const CEC::cec_logical_addresses& addresses,
+                         Deadline deadline, Send send) {
+    PowerFanoutReport report;
+    const auto start     = Clock::now();
+    auto       frameCost = kMinFrameCost;
+    for (const auto address : kFanoutOrder) {
+        if (!addresses.IsSet(address)) continue;
+
+        PowerFanoutReport::Device device{address, PowerFanoutReport::Result::Skipped};
+        const int remaining = deadline.remainingMs();
+        if (remaining >= 0 && remaining < frameCost.count()) {
+            Metrics::getInstance().increment(Metrics::Counter::FanoutSkipped);
+            report.devices.push_back(device);
+            continue;
+        }
+
+        const auto sentAt = Clock::now();
+        bool acked = false;
+        try {
+            acked = send(address);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Exception sending to device ", static_cast<int>(address), ": ",
+                      e.what());
+        }
+        device.result  = acked ? PowerFanoutReport::Result::Acked
+                               : PowerFanoutReport::Result::Failed;
+        device.elapsed = since(sentAt);
+        frameCost      = std::max(frameCost, device.elapsed);
+        report.devices.push_back(device);
+    }
+    report.elapsed = since(start);
+    return report;
+}
+
+} // namespace
+
+std::string PowerFanoutReport::describe() const {
+    std::ostringstream out;
+    for (std::size_t i = 0; i < devices.size(); ++i) {
+        const Device& device = devices[i];
+        if (i != 0) out << ", ";
+        if (device.address == CEC::CECDEVICE_BROADCAST) {
+            out << "broadcast";
+        } else {
+            out << static_cast<int>(device.address);
+        }
+        out << ' ' << resultName(device.result);
+        if (device.result != Result::Skipped) {
+            out << ' ' << device.elapsed.count() << "ms";
+        }
+    }
+    return out.str();
+}
+
+PowerFanoutReport standbyFanout(ICecAdapter& adapter,
+                                const CEC::cec_logical_addresses& devices,
+                                Deadline deadline) {
+    if (devices.IsSet(CEC::CECDEVICE_BROADCAST)) {
+        // One unacknowledged frame reaches every device, listed or not.
+        PowerFanoutReport report;
+        const auto start = Clock::now();
+        bool sent = false;
+        try {
+            sent = adapter.broadcastStandby();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Exception sending broadcast standby: ", e.what());
+        }
+        report.elapsed = since(start);
+        report.devices.push_back({CEC::CECDEVICE_BROADCAST,
+                                  sent ? PowerFanoutReport::Result::Acked
+                                       : PowerFanoutReport::Result::Failed,
+                                  report.elapsed});
+        return report;
+    }
+    return fanOut(devices, deadline, [&](CEC::cec_logical_address address) {
+        return adapter.standbyDevice(address);
+    });
+}
+
+PowerFanoutReport powerOnFanout(ICecAdapter& adapter,
+                                const CEC::cec_logical_addresses& devices,
+                                Deadline deadline) {
+    return fanOut(devices, deadline, [&](CEC::cec_logical_address address) {
+        return adapter.powerOnDevice(address);
+    });
+}
+
+} // namespace cec_control
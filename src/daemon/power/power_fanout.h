@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <libcec/cec.h>
+
+#include "../../common/deadline.h"
+
+namespace cec_control {
+
+class ICecAdapter;
+
+/**
+ * Devices the daemon powers off before sleep and wakes after resume,
+ * as configured by @c PowerOffDevices / @c WakeDevices. Address 15
+ * (@c CECDEVICE_BROADCAST) in @c powerOffDevices selects a single
+ * broadcast @c <Standby> in place of the per-device frames — the CEC
+ * spec allows broadcast for @c <Standby> only, so it is ignored in
+ * @c wakeDevices.
+ */
+struct PowerFanoutConfig {
+    CEC::cec_logical_addresses wakeDevices;
+    CEC::cec_logical_addresses powerOffDevices;
+
+    PowerFanoutConfig() noexcept {
+        wakeDevices.Clear();
+        powerOffDevices.Clear();
+    }
+};
+
+/**
+ * Outcome of one suspend-time standby or resume-time wake pass, for
+ * the log: what was sent to whom, how long each took, and what the
+ * deadline cut off.
+ */
+struct PowerFanoutReport {
+    enum class Result {
+        Acked,    ///< The frame was acknowledged.
+        Failed,   ///< libcec gave up on the frame (no ack, bus error).
+        Skipped,  ///< Not sent: too little of the deadline was left for it.
+    };
+
+    struct Device {
+        CEC::cec_logical_address  address;
+        Result                    result;
+        std::chrono::milliseconds elapsed{0};
+    };
+
+    /** One entry per device, in send order; a broadcast is one entry. */
+    std::vector<Device>       devices;
+    std::chrono::milliseconds elapsed{0};
+
+    [[nodiscard]] bool empty() const noexcept { return devices.empty(); }
+
+    /** E.g. @c "0 acked 42ms, 5 failed 1210ms, 4 skipped". */
+    [[nodiscard]] std::string describe() const;
+};
+
+/**
+ * Send @c <Standby> to every address in @p devices, or a single
+ * broadcast when the set includes 15. Worker thread only.
+ *
+ * libcec's transmit path blocks until each frame is acknowledged or
+ * retried out, so the frames go back to back with no throttle or
+ * retry pacing of our own between them — the bus's signal-free time
+ * is the only gap. The TV goes first and the audio system second, so
+ * the devices @p deadline leaves no time for — reported as skipped
+ * rather than delaying sleep further — are the least visible ones.
+ */
+[[nodiscard]] PowerFanoutReport standbyFanout(ICecAdapter& adapter,
+                                              const CEC::cec_logical_addresses& devices,
+                                              Deadline deadline);
+
+/** As @c standbyFanout, waking each address in @p devices. Worker thread only. */
+[[nodiscard]] PowerFanoutReport powerOnFanout(ICecAdapter& adapter,
+                                              const CEC::cec_logical_addresses& devices,
+                                              Deadline deadline);
+
+} // namespace cec_control
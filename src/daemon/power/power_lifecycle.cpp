@@ -83,12 +83,13 @@ PowerLifecycle::Output PowerLifecycle::onSuspendCompleted() noexcept {
 
     Output o;
     // Always disarm to match the historical unconditional disarm on
-    // completion; TimerSource::disarm is idempotent when already disarmed.
+    // completion; LoopTimer::disarm is idempotent when already disarmed.
     o.safetyTimer = Output::Timer::Disarm;
     if (firedFirst) {
         o.safety = Output::SafetyOutcome::Overrun;
     } else if (src == Source::DBus) {
         o.lock = Output::Lock::Release;
+        m_lockReleased = true;
     }
     return o;
 }
@@ -106,7 +107,10 @@ PowerLifecycle::onResumeCompleted(bool /*adapterValid*/) noexcept {
     // signature symmetry with onSuspendCompleted and so callers still
     // see a self-documenting call site.
     Output o;
-    if (src == Source::DBus) o.lock = Output::Lock::Take;
+    if (src == Source::DBus) {
+        o.lock = Output::Lock::Take;
+        m_lockReleased = false;
+    }
     return o;
 }
 
@@ -116,7 +120,21 @@ PowerLifecycle::Output PowerLifecycle::onSafetyTimerFired() noexcept {
 
     Output o;
     o.safety = Output::SafetyOutcome::Fired;
-    if (m_phaseSource == Source::DBus) o.lock = Output::Lock::Release;
+    if (m_phaseSource == Source::DBus) {
+        o.lock = Output::Lock::Release;
+        m_lockReleased = true;
+    }
+    return o;
+}
+
+PowerLifecycle::Output PowerLifecycle::onInhibitLockAcquired() noexcept {
+    // The Inhibit request went out while the lock was wanted (startup,
+    // bus reconnect, resume), but a sleep cycle released it before
+    // logind answered. Holding the fresh lock would only make logind
+    // wait out InhibitDelayMaxSec, so hand it straight back; the
+    // resume retakes it as usual.
+    Output o;
+    if (m_lockReleased) o.lock = Output::Lock::Release;
     return o;
 }
 
@@ -124,12 +124,19 @@ public:
      */
     [[nodiscard]] Output onResumeCompleted(bool adapterValid) noexcept;
 
-    /** The suspend-safety timerfd became readable. */
+    /** The suspend-safety timer fired. */
     [[nodiscard]] Output onSafetyTimerFired() noexcept;
 
-    /** Dispatcher feedback: arming the safety timerfd failed. */
+    /** Dispatcher feedback: arming the safety timer failed. */
     [[nodiscard]] Output onSafetyTimerArmFailed() noexcept;
 
+    /**
+     * logind answered an Inhibit request with a lock. Releases it
+     * again if a DBus suspend has given the lock up since and no
+     * resume has asked for it back.
+     */
+    [[nodiscard]] Output onInhibitLockAcquired() noexcept;
+
     /**
      * If Idle with a non-empty queue, pop and emit the entry Output
      * for the next event. Otherwise returns an inert Output. The
@@ -157,6 +164,8 @@ private:
     Phase  m_phase = Phase::Idle;
     Source m_phaseSource = Source::DBus;
     bool   m_safetyFiredFirst = false;
+    // Set by every Lock::Release output, cleared by every Lock::Take.
+    bool   m_lockReleased = false;
     std::deque<Pending> m_pending;
 };
 
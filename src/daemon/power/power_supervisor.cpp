@@ -1,31 +1,69 @@
 #include "power_supervisor.h"
 
+#include <time.h>
+
+#include <algorithm>
 #include <chrono>
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "../../common/logger.h"
 #include "../../common/messages.h"
-#include "../../common/timer_source.h"
+#include "../../common/loop_timer.h"
 #include "../adapter_lifecycle.h"
-#include "../cec/adapter_worker.h"
 #include "../command_dispatcher.h"
 #include "../dbus_monitor.h"
+#include "../metrics.h"
 
 namespace cec_control {
 
-PowerSupervisor::PowerSupervisor(CommandDispatcher& dispatcher,
-                                 AdapterLifecycle&  lifecycle,
-                                 AdapterWorker&     worker,
-                                 TimerSource&       suspendSafety,
-                                 TimerSource&       reconnectRetry,
-                                 AdapterUnrecoverableCallback onAdapterUnrecoverable) noexcept
-    : m_dispatcher(dispatcher),
-      m_lifecycle(lifecycle),
-      m_worker(worker),
-      m_suspendSafetyTimer(suspendSafety),
-      m_reconnectRetryTimer(reconnectRetry),
-      m_onAdapterUnrecoverable(std::move(onAdapterUnrecoverable)) {}
+namespace {
+
+/** " on adapter NAME" for a named bus; nothing for the default one. */
+std::string onBus(const std::string& name) {
+    return name.empty() ? std::string() : " on adapter " + name;
+}
+
+/** One line per pass: every device's outcome and timing. */
+void logFanout(std::string_view what, const std::string& bus,
+               const PowerFanoutReport& report) {
+    if (report.empty()) return;
+    std::size_t skipped = 0;
+    for (const auto& device : report.devices) {
+        if (device.result == PowerFanoutReport::Result::Skipped) ++skipped;
+    }
+    LOG_INFO("CEC ", what, onBus(bus), " took ", report.elapsed.count(), "ms: ",
+             report.describe());
+    if (skipped > 0) {
+        LOG_WARNING("CEC ", what, onBus(bus), " deadline reached; ", skipped,
+                    " device(s) not sent to");
+    }
+}
+
+/** Time the system has spent suspended since boot. */
+std::chrono::nanoseconds timeAsleep() noexcept {
+    timespec boot{};
+    timespec mono{};
+    ::clock_gettime(CLOCK_BOOTTIME, &boot);
+    ::clock_gettime(CLOCK_MONOTONIC, &mono);
+    return std::chrono::seconds(boot.tv_sec - mono.tv_sec) +
+           std::chrono::nanoseconds(boot.tv_nsec - mono.tv_nsec);
+}
+
+} // namespace
+
+PowerSupervisor::PowerSupervisor(std::vector<Bus> buses,
+                                 LoopTimer&       suspendSafety,
+                                 LoopTimer&       wakeProbe,
+                                 AdapterUnrecoverableCallback onAdapterUnrecoverable)
+    : m_suspendSafetyTimer(suspendSafety),
+      m_wakeProbeTimer(wakeProbe),
+      m_onAdapterUnrecoverable(std::move(onAdapterUnrecoverable)) {
+    m_buses.reserve(buses.size());
+    for (auto& bus : buses) m_buses.emplace_back(std::move(bus));
+}
 
 void PowerSupervisor::setDBusMonitor(DBusMonitor* dbusMonitor) noexcept {
     m_dbusMonitor = dbusMonitor;
@@ -39,7 +77,23 @@ void PowerSupervisor::onResumeRequested(PowerLifecycle::Source source) {
     applyLifecycle(m_powerLifecycle.onResumeRequested(source));
 }
 
+void PowerSupervisor::onInhibitLockReply(bool held) {
+    if (!held) {
+        LOG_WARNING("No sleep delay lock from logind; a suspend may not wait "
+                    "for the CEC standby commands");
+        return;
+    }
+    applyLifecycle(m_powerLifecycle.onInhibitLockAcquired());
+}
+
+void PowerSupervisor::onSuspendCallReply(bool accepted) {
+    if (accepted) return;
+    LOG_WARNING("logind refused the auto-standby suspend; the system stays awake");
+}
+
 void PowerSupervisor::onSuspendCompleted(std::chrono::milliseconds workDuration) {
+    Metrics::getInstance().record(Metrics::Latency::SuspendPrep, workDuration);
+
     // Whichever path (completion vs. safety timer) fires first
     // discharges the inhibit-lock release; the other path takes the
     // overrun branch.
@@ -54,22 +108,29 @@ void PowerSupervisor::onSuspendCompleted(std::chrono::milliseconds workDuration)
         }
     }
     applyLifecycle(out);
+    armWakeProbe();
 }
 
-void PowerSupervisor::onResumeCompleted(bool adapterValid) {
+void PowerSupervisor::onResumeCompleted() {
+    m_wakeProbeTimer.disarm();
+
     // Apply the lifecycle FSM output first (Resuming → Idle, lock
-    // retake on DBus sources). If the adapter is still disconnected
-    // after the worker-side reopen, seed the reconnect FSM with a
-    // delayed first attempt to let USB re-enumeration settle.
+    // retake on DBus sources). Each bus whose adapter is still
+    // disconnected after the worker-side reopen seeds its reconnect FSM
+    // with a delayed first attempt to let USB re-enumeration settle.
     // Subsequent failures fall through to AdapterReconnect's backoff
     // schedule — no second timer is involved.
-    applyLifecycle(m_powerLifecycle.onResumeCompleted(adapterValid));
-    if (adapterValid) return;
-
-    LOG_INFO("CEC adapter not connected after resume; seeding reconnect cycle");
-    execute(m_adapterReconnect.seedCycle(
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            kPostResumeRetryDelay)));
+    const bool allValid = std::all_of(m_buses.begin(), m_buses.end(),
+                                      [](const BusState& state) { return state.resumed; });
+    applyLifecycle(m_powerLifecycle.onResumeCompleted(allValid));
+    for (std::size_t i = 0; i < m_buses.size(); ++i) {
+        if (m_buses[i].resumed) continue;
+        LOG_INFO("CEC adapter", onBus(m_buses[i].bus.name),
+                 " not connected after resume; seeding reconnect cycle");
+        execute(i, m_buses[i].reconnect.seedCycle(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                kPostResumeRetryDelay)));
+    }
 }
 
 void PowerSupervisor::onSafetyTimerFired() {
@@ -83,31 +144,85 @@ void PowerSupervisor::onSafetyTimerFired() {
     applyLifecycle(out);
 }
 
-void PowerSupervisor::onConnectionLost() {
-    LOG_WARNING("CEC connection lost, attempting to reconnect");
-    execute(m_adapterReconnect.onEvent(AdapterReconnect::Event::ConnectionLost));
+void PowerSupervisor::armWakeProbe() {
+    if (!isSuspended()) return;
+    m_sleepBaseline = timeAsleep();
+    if (!m_wakeProbeTimer.armPeriodic(kWakeProbeInterval)) {
+        // Only the early start is lost; PrepareForSleep(false) still
+        // resumes the adapter.
+        LOG_WARNING("Failed to arm wake-probe timer; resume waits for logind");
+    }
+}
+
+void PowerSupervisor::onWakeProbeTimerFired() {
+    m_wakeProbeTimer.consume();
+    const auto slept = timeAsleep() - m_sleepBaseline;
+    if (slept < kWakeGapThreshold) return;
+
+    m_wakeProbeTimer.disarm();
+    LOG_INFO("System woke after ",
+             std::chrono::duration_cast<std::chrono::milliseconds>(slept).count(),
+             "ms asleep; reopening CEC adapter ahead of logind");
+    for (auto& state : m_buses) {
+        state.bus.lifecycle.prewarmAsync(
+            [&bus = state.bus](bool adapterValid, std::vector<Message> queued,
+                               PowerFanoutReport report) {
+                if (!adapterValid) {
+                    LOG_INFO("Early adapter reopen", onBus(bus.name),
+                             " failed; waiting for logind's resume");
+                    return;
+                }
+                logFanout("wake", bus.name, report);
+                if (!queued.empty()) bus.dispatcher.replay(std::move(queued));
+            });
+    }
+}
+
+void PowerSupervisor::onConnectionLost(std::size_t bus) {
+    LOG_WARNING("CEC connection lost", onBus(m_buses[bus].bus.name),
+                ", attempting to reconnect");
+    execute(bus, m_buses[bus].reconnect.onEvent(AdapterReconnect::Event::ConnectionLost));
 }
 
-void PowerSupervisor::onReconnectResult(bool ok) {
+void PowerSupervisor::onReconnectResult(std::size_t bus, bool ok) {
     // A result arriving after a SystemSuspend/Resume has already moved
     // the FSM to Idle is absorbed as a no-op; no state check needed.
     if (ok) {
-        LOG_INFO("Successfully reconnected to CEC adapter");
+        LOG_INFO("Successfully reconnected to CEC adapter", onBus(m_buses[bus].bus.name));
     } else {
-        LOG_WARNING("CEC reconnect attempt failed");
+        LOG_WARNING("CEC reconnect attempt failed", onBus(m_buses[bus].bus.name));
     }
-    execute(m_adapterReconnect.onEvent(
+    execute(bus, m_buses[bus].reconnect.onEvent(
         ok ? AdapterReconnect::Event::AttemptSucceeded
            : AdapterReconnect::Event::AttemptFailed));
 }
 
-void PowerSupervisor::onReconnectRetryTimerFired() {
-    m_reconnectRetryTimer.consume();
-    execute(m_adapterReconnect.onEvent(AdapterReconnect::Event::RetryTimerFired));
+void PowerSupervisor::onDeferredOpenCompleted(std::size_t bus, bool adapterValid) {
+    if (adapterValid) return;
+    LOG_INFO("CEC adapter", onBus(m_buses[bus].bus.name),
+             " not connected after startup; seeding reconnect cycle");
+    execute(bus, m_buses[bus].reconnect.seedCycle(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            kConnectionLostRetryDelay)));
+}
+
+void PowerSupervisor::onAdapterHotplug(bool present) {
+    for (std::size_t i = 0; i < m_buses.size(); ++i) {
+        execute(i, m_buses[i].reconnect.onEvent(
+            present ? AdapterReconnect::Event::AdapterAppeared
+                    : AdapterReconnect::Event::AdapterRemoved));
+    }
+}
+
+void PowerSupervisor::onReconnectRetryTimerFired(std::size_t bus) {
+    m_buses[bus].bus.reconnectRetry.consume();
+    execute(bus, m_buses[bus].reconnect.onEvent(AdapterReconnect::Event::RetryTimerFired));
 }
 
 bool PowerSupervisor::isSuspended() const noexcept {
-    return m_lifecycle.isSuspended();
+    return std::any_of(m_buses.begin(), m_buses.end(), [](const BusState& state) {
+        return state.bus.lifecycle.isSuspended();
+    });
 }
 
 void PowerSupervisor::applyLifecycle(PowerLifecycle::Output output) {
@@ -136,22 +251,20 @@ void PowerSupervisor::executeEffects(const PowerLifecycle::Output& out) {
     }
 
     // Disarm stale timers first so a subsequent Arm on the same axis
-    // starts from a clean slate. TimerSource::disarm is idempotent.
+    // starts from a clean slate. LoopTimer::disarm is idempotent.
     if (out.safetyTimer == Timer::Disarm) m_suspendSafetyTimer.disarm();
 
     // Notify the reconnect FSM. Its effects are carried out inline by
     // execute(); a SystemSuspend/SystemResume there cancels any armed
     // reconnect retry, including a seeded post-resume retry still
     // waiting on its delay.
-    switch (out.reconnectNotify) {
-    case Notify::SystemSuspend:
-        execute(m_adapterReconnect.onEvent(AdapterReconnect::Event::SystemSuspend));
-        break;
-    case Notify::SystemResume:
-        execute(m_adapterReconnect.onEvent(AdapterReconnect::Event::SystemResume));
-        break;
-    case Notify::None:
-        break;
+    if (out.reconnectNotify != Notify::None) {
+        const auto event = out.reconnectNotify == Notify::SystemSuspend
+            ? AdapterReconnect::Event::SystemSuspend
+            : AdapterReconnect::Event::SystemResume;
+        for (std::size_t i = 0; i < m_buses.size(); ++i) {
+            execute(i, m_buses[i].reconnect.onEvent(event));
+        }
     }
 
     // Arm new timers. On syscall failure, feed back to the FSM so its
@@ -194,9 +307,35 @@ void PowerSupervisor::submitSuspendWork() {
     // synchronous path land on the main thread by construction, and
     // the supervisor's reference to the lifecycle is valid for the
     // supervisor's entire lifetime.
-    m_lifecycle.suspendAsync([this](std::chrono::milliseconds elapsed) {
-        this->onSuspendCompleted(elapsed);
-    });
+    //
+    // Every bus starts at once on its own worker, so the passes run in
+    // parallel and share one budget. An early return counts down like
+    // a worker completion; the count starts full, so the last bus
+    // cannot finish before the others are submitted.
+    const auto budget = suspendFanoutBudget();
+    m_pendingBuses   = m_buses.size();
+    m_slowestSuspend = std::chrono::milliseconds(0);
+    for (auto& state : m_buses) {
+        state.bus.lifecycle.suspendAsync(budget,
+            [this, &bus = state.bus](std::chrono::milliseconds elapsed,
+                                     PowerFanoutReport report) {
+                logFanout("standby", bus.name, report);
+                m_slowestSuspend = std::max(m_slowestSuspend, elapsed);
+                if (--m_pendingBuses == 0) this->onSuspendCompleted(m_slowestSuspend);
+            });
+    }
+}
+
+std::chrono::milliseconds PowerSupervisor::suspendFanoutBudget() const {
+    using std::chrono::milliseconds;
+    auto limit = std::chrono::duration_cast<milliseconds>(
+        PowerLifecycle::kSuspendSafetyDeadline);
+    if (m_dbusMonitor) {
+        if (const auto delayMax = m_dbusMonitor->inhibitDelayMax()) {
+            limit = std::min(limit, std::chrono::duration_cast<milliseconds>(*delayMax));
+        }
+    }
+    return std::max(limit - kSuspendCloseReserve, kMinSuspendFanoutBudget);
 }
 
 void PowerSupervisor::submitResumeWork() {
@@ -205,34 +344,43 @@ void PowerSupervisor::submitResumeWork() {
     // adapter validity. Forward the drained commands to the dispatcher
     // first so the worker submissions land before the FSM transition
     // observes the resume completion — preserving the pre-refactor
-    // ordering where replays were submitted before onDone fired.
-    m_lifecycle.resumeAsync(
-        [this](bool adapterValid, std::vector<Message> queued) {
-            if (!queued.empty()) m_dispatcher.replay(std::move(queued));
-            this->onResumeCompleted(adapterValid);
-        });
+    // ordering where replays were submitted before onDone fired. The
+    // buses reopen in parallel, as they suspended.
+    m_pendingBuses = m_buses.size();
+    for (auto& state : m_buses) {
+        state.resumed = false;
+        state.bus.lifecycle.resumeAsync(
+            [this, &state](bool adapterValid, std::vector<Message> queued,
+                           PowerFanoutReport report) {
+                logFanout("wake", state.bus.name, report);
+                if (!queued.empty()) state.bus.dispatcher.replay(std::move(queued));
+                state.resumed = adapterValid;
+                if (--m_pendingBuses == 0) this->onResumeCompleted();
+            });
+    }
 }
 
-void PowerSupervisor::submitReconnectAttempt() {
-    m_lifecycle.reconnectAsync([this](bool ok) {
-        this->onReconnectResult(ok);
+void PowerSupervisor::submitReconnectAttempt(std::size_t bus) {
+    m_buses[bus].bus.lifecycle.reconnectAsync([this, bus](bool ok) {
+        this->onReconnectResult(bus, ok);
     });
 }
 
-void PowerSupervisor::execute(AdapterReconnect::Output out) {
+void PowerSupervisor::execute(std::size_t bus, AdapterReconnect::Output out) {
     using E = AdapterReconnect::Effect;
+    BusState& state = m_buses[bus];
     switch (out.effect) {
     case E::None:
         break;
     case E::StartAttempt:
         // StartAttempt supersedes any armed retry timer; disarm()
         // unconditionally so the dispatcher stays free of state checks.
-        m_reconnectRetryTimer.disarm();
+        state.bus.reconnectRetry.disarm();
         if (out.attemptNumber > 1) {
-            LOG_INFO("Performing retried CEC reconnection (attempt ",
-                     out.attemptNumber, "/", out.totalAttempts, ")");
+            LOG_INFO("Performing retried CEC reconnection", onBus(state.bus.name),
+                     " (attempt ", out.attemptNumber, "/", out.totalAttempts, ")");
         }
-        submitReconnectAttempt();
+        submitReconnectAttempt(bus);
         break;
     case E::ScheduleRetry:
         // Uniform phrasing: this effect now serves both the seeded
@@ -240,17 +388,22 @@ void PowerSupervisor::execute(AdapterReconnect::Output out) {
         // retries (from AttemptFailed). The "attempt failed" signal is
         // logged at onReconnectResult, not here; this message reports
         // only the scheduling itself.
-        LOG_INFO("CEC reconnect scheduled in ", out.delay.count(),
-                 "ms (attempt ", out.attemptNumber, "/",
+        LOG_INFO("CEC reconnect", onBus(state.bus.name), " scheduled in ",
+                 out.delay.count(), "ms (attempt ", out.attemptNumber, "/",
                  out.totalAttempts, ")");
-        if (!m_reconnectRetryTimer.armOnce(out.delay)) {
+        if (!state.bus.reconnectRetry.armOnce(out.delay)) {
             LOG_ERROR("Failed to arm reconnect-retry timer");
-            execute(m_adapterReconnect.onEvent(
+            execute(bus, state.reconnect.onEvent(
                 AdapterReconnect::Event::TimerArmFailed));
         }
         break;
     case E::CancelRetry:
-        m_reconnectRetryTimer.disarm();
+        state.bus.reconnectRetry.disarm();
+        break;
+    case E::AwaitAdapter:
+        state.bus.reconnectRetry.disarm();
+        LOG_INFO("CEC adapter", onBus(state.bus.name),
+                 " unplugged; reconnect paused until it is plugged back in");
         break;
     case E::AbandonCycle:
         // "Waiting for next connection-lost event" is a dead state:
@@ -258,7 +411,13 @@ void PowerSupervisor::execute(AdapterReconnect::Output out) {
         // alert thread is gone and no further CEC_ALERT_CONNECTION_LOST
         // can fire. Escalate to the owner instead; the daemon's policy
         // is to request a clean shutdown so a service manager restarts
-        // us into a fresh libcec state.
+        // us into a fresh libcec state. A further bus only takes its
+        // own adapter with it; the next resume tries it again.
+        if (bus != kDefaultBus) {
+            LOG_ERROR("CEC reconnect", onBus(state.bus.name), " abandoned after ",
+                      out.totalAttempts, " attempts; adapter stays closed");
+            break;
+        }
         LOG_ERROR("CEC reconnect abandoned after ", out.totalAttempts,
                   " attempts; requesting daemon shutdown for supervisor restart");
         if (m_onAdapterUnrecoverable) m_onAdapterUnrecoverable();
@@ -1,19 +1,23 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <functional>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "../../common/backoff_schedule.h"
 #include "adapter_reconnect.h"
+#include "power_fanout.h"
 #include "power_lifecycle.h"
 
 namespace cec_control {
 
 class AdapterLifecycle;
-class AdapterWorker;
 class CommandDispatcher;
 class DBusMonitor;
-class TimerSource;
+class LoopTimer;
 
 /**
  * @class PowerSupervisor
@@ -23,8 +27,9 @@ class TimerSource;
  *
  * Both FSMs are pure decision types: they emit @c Output values
  * describing the side effects to execute. This class is the executor.
- * It holds non-owning references to the timers, the adapter worker,
- * the adapter lifecycle, and the command dispatcher, plus a may-be-
+ * It holds non-owning references to the timers and, for every adapter
+ * the daemon drives, that adapter's lifecycle and command dispatcher
+ * (a @c Bus), plus a may-be-
  * null pointer to the D-Bus monitor (which is constructed conditionally
  * on the @c [Daemon] config flag and may also be torn down on attach
  * failure). The supervisor is itself owned by @c CECDaemon and never
@@ -62,10 +67,20 @@ class TimerSource;
  * follows the FSM's overrun branch, or a stale fire could re-trigger
  * the warning path after the lock has already been dropped).
  *
+ * ## Several adapters
+ *
+ * One system suspend or resume moves every bus: the supervisor starts
+ * the pass on each bus's own worker at once, so the buses' standby and
+ * wake fan-outs overlap, and feeds the lifecycle FSM a single
+ * completion once the last bus reports. The inhibit lock is therefore
+ * held until every bus has sent its standby frames. Each bus has its
+ * own reconnect FSM and retry timer; a lost adapter reconnects without
+ * disturbing the others.
+ *
  * ## Post-resume reconnect
  *
- * When @c onResumeCompleted observes @c adapterValid == false, the
- * supervisor seeds @c AdapterReconnect with @c kPostResumeRetryDelay
+ * When @c onResumeCompleted finds a bus whose adapter did not reopen,
+ * the supervisor seeds that bus's @c AdapterReconnect with @c kPostResumeRetryDelay
  * as the initial-attempt delay. From that point the unified reconnect
  * cycle owns the backoff (attempt 1 after the seed delay, then
  * schedule-driven retries). Prior to unification this path ran a
@@ -74,13 +89,15 @@ class TimerSource;
  *
  * ## Unrecoverable escalation
  *
- * When @c AdapterReconnect abandons its cycle after exhausting the
- * backoff schedule, the supervisor invokes the install-once
+ * When the default bus's @c AdapterReconnect abandons its cycle after
+ * exhausting the backoff schedule, the supervisor invokes the install-once
  * @c AdapterUnrecoverableCallback supplied at construction. The
  * callback's owner (the daemon) decides what "unrecoverable" means
  * in policy terms — today: request a clean process shutdown so a
  * service manager such as systemd can restart us into a fresh libcec
- * state. The supervisor itself only signals; no policy lives here.
+ * state. The supervisor itself only signals; no policy lives here. A
+ * further bus that abandons is logged and left closed until the next
+ * resume reopens it.
  */
 class PowerSupervisor {
 public:
@@ -95,12 +112,28 @@ public:
      */
     using AdapterUnrecoverableCallback = std::function<void()>;
 
+    /**
+     * One adapter to coordinate: the dispatcher that replays its
+     * suspend queue, its lifecycle, and the timer its reconnect cycle
+     * retries on. @p name is its @c [Adapter.NAME] section, empty for
+     * the default adapter; it only labels the log.
+     */
+    struct Bus {
+        std::string        name;
+        CommandDispatcher& dispatcher;
+        AdapterLifecycle&  lifecycle;
+        LoopTimer&         reconnectRetry;
+    };
+
+    /** Index of the default @c [Adapter] bus, passed first at construction. */
+    static constexpr std::size_t kDefaultBus = 0;
+
     /**
      * Capture references to every subsystem the supervisor must
-     * coordinate. The references must outlive @c this; the daemon
-     * achieves this by destroying the supervisor first in @c stop()
-     * and by declaring it after the timers / dispatcher / lifecycle /
-     * worker.
+     * coordinate; @p buses holds at least the default bus, first. The
+     * references must outlive @c this; the daemon achieves this by
+     * destroying the supervisor first in @c stop() and by declaring it
+     * after the timers / dispatchers / lifecycles.
      *
      * The D-Bus monitor pointer is intentionally absent here — it is
      * wired post-construction via @c setDBusMonitor once
@@ -112,12 +145,10 @@ public:
      * the contract; empty is acceptable and makes abandonment a
      * log-only event.
      */
-    PowerSupervisor(CommandDispatcher& dispatcher,
-                    AdapterLifecycle&  lifecycle,
-                    AdapterWorker&     worker,
-                    TimerSource&       suspendSafety,
-                    TimerSource&       reconnectRetry,
-                    AdapterUnrecoverableCallback onAdapterUnrecoverable) noexcept;
+    PowerSupervisor(std::vector<Bus> buses,
+                    LoopTimer&       suspendSafety,
+                    LoopTimer&       wakeProbe,
+                    AdapterUnrecoverableCallback onAdapterUnrecoverable);
 
     ~PowerSupervisor() = default;
 
@@ -144,7 +175,22 @@ public:
     void onResumeRequested(PowerLifecycle::Source source);
 
     /**
-     * Worker-completion handler for the suspend phase. Public so the
+     * logind answered an Inhibit request: @p held when the delay lock
+     * came with it. A lock that arrives after a sleep cycle has given
+     * it up is released again. Main thread only.
+     */
+    void onInhibitLockReply(bool held);
+
+    /**
+     * logind answered the Suspend request the auto-standby policy
+     * sent; @p accepted is @c false when it refused (no authorization,
+     * a block inhibitor). Main thread only.
+     */
+    void onSuspendCallReply(bool accepted);
+
+    /**
+     * Completion handler for the suspend phase, run once the last bus
+     * has finished; @p workDuration is the slowest bus's. Public so the
      * lambda installed in @c submitSuspendWork (which posts completion
      * to the main thread via @c MainThreadWork::post) can name it.
      * Reads the lifecycle FSM's outcome to choose between the happy
@@ -152,27 +198,57 @@ public:
      */
     void onSuspendCompleted(std::chrono::milliseconds workDuration);
 
-    /** Worker-completion handler for the resume phase. */
-    void onResumeCompleted(bool adapterValid);
+    /**
+     * Completion handler for the resume phase, run once the last bus
+     * has reopened or failed to; a bus that failed seeds its reconnect
+     * cycle.
+     */
+    void onResumeCompleted();
 
-    /** The suspend-safety timerfd became readable. */
+    /** The suspend-safety timer fired. */
     void onSafetyTimerFired();
 
-    /** The reconnect-retry timerfd became readable. */
-    void onReconnectRetryTimerFired();
+    /** The reconnect-retry timer of @p bus fired. */
+    void onReconnectRetryTimerFired(std::size_t bus);
+
+    /**
+     * The wake-probe timer fired. The probe ticks from the
+     * end of the pre-sleep work until the resume completes; a tick
+     * that finds @c CLOCK_BOOTTIME has run ahead of @c CLOCK_MONOTONIC
+     * since the probe was armed means the machine slept and has just
+     * been thawed, typically well before logind's
+     * @c PrepareForSleep(false). Every adapter is then reopened on the
+     * spot through @c AdapterLifecycle::prewarmAsync.
+     */
+    void onWakeProbeTimerFired();
+
+    /**
+     * Main-thread entry point for a libcec connection-lost alert on
+     * @p bus. The libcec callback fires on the alert thread; the
+     * daemon hops it through @c MainThreadWork::post and lands here.
+     */
+    void onConnectionLost(std::size_t bus);
+
+    /** Worker-completion handler for a single reconnect attempt on @p bus. */
+    void onReconnectResult(std::size_t bus, bool ok);
 
     /**
-     * Main-thread entry point for a libcec connection-lost alert. The
-     * libcec callback fires on the alert thread; the daemon hops it
-     * through @c MainThreadWork::post and lands here.
+     * A startup open (@c AdapterLifecycle::openAsync) on @p bus has
+     * completed. A failure seeds the reconnect cycle, as a failed
+     * resume does, rather than leaving the daemon without an adapter.
      */
-    void onConnectionLost();
+    void onDeferredOpenCompleted(std::size_t bus, bool adapterValid);
 
-    /** Worker-completion handler for a single reconnect attempt. */
-    void onReconnectResult(bool ok);
+    /**
+     * The udev monitor saw an adapter plugged in (@p present) or
+     * removed. The event does not say which, so every bus hears it.
+     * Retries pause while the adapter is gone and an attempt starts
+     * the moment it is back; see @c AdapterReconnect.
+     */
+    void onAdapterHotplug(bool present);
 
     /**
-     * @c true iff the adapter is currently considered suspended. Reads
+     * @c true iff any adapter is currently considered suspended. Reads
      * @c AdapterLifecycle's @c SuspendQueue flag — the actual gate
      * that routes inbound dispatches into the queue; the lifecycle
      * FSM's @c Phase is a finer-grained "in-progress" view that does
@@ -195,22 +271,36 @@ private:
      */
     void executeEffects(const PowerLifecycle::Output& output);
 
-    /** Kick off @c AdapterLifecycle::suspendAsync with completion wiring. */
+    /**
+     * Kick off @c AdapterLifecycle::suspendAsync on every bus, counting
+     * the completions into @c onSuspendCompleted.
+     */
     void submitSuspendWork();
 
     /**
-     * Kick off @c AdapterLifecycle::resumeAsync. The completion lambda
-     * receives the drained queue alongside the adapter validity and
-     * hands it to @c CommandDispatcher::replay before forwarding the
-     * adapter validity to @c onResumeCompleted for the FSM transition.
+     * Time the pre-sleep standby pass may take: logind's
+     * @c InhibitDelayMaxUSec when the D-Bus monitor knows it, capped
+     * by the safety deadline, less @c kSuspendCloseReserve for closing
+     * the adapter afterwards.
+     */
+    [[nodiscard]] std::chrono::milliseconds suspendFanoutBudget() const;
+
+    /**
+     * Kick off @c AdapterLifecycle::resumeAsync on every bus. Each
+     * completion hands its drained queue to that bus's
+     * @c CommandDispatcher::replay and records the adapter validity;
+     * the last one calls @c onResumeCompleted for the FSM transition.
      */
     void submitResumeWork();
 
+    /** Start the wake probe after the pre-sleep work, if still suspended. */
+    void armWakeProbe();
+
     /** Submit one reconnect attempt; the result lands in @c onReconnectResult. */
-    void submitReconnectAttempt();
+    void submitReconnectAttempt(std::size_t bus);
 
-    /** Carry out the side effect emitted by the reconnect FSM. */
-    void execute(AdapterReconnect::Output out);
+    /** Carry out the side effect emitted by @p bus's reconnect FSM. */
+    void execute(std::size_t bus, AdapterReconnect::Output out);
 
     /**
      * Delay before the seeded post-resume reconnect attempt. Covers
@@ -232,11 +322,52 @@ private:
      */
     static constexpr auto kConnectionLostRetryDelay = std::chrono::milliseconds(1500);
 
-    CommandDispatcher& m_dispatcher;
-    AdapterLifecycle&  m_lifecycle;
-    AdapterWorker&     m_worker;
-    TimerSource&       m_suspendSafetyTimer;
-    TimerSource&       m_reconnectRetryTimer;
+    /** Part of the suspend budget kept for @c closeConnection. */
+    static constexpr auto kSuspendCloseReserve = std::chrono::milliseconds(1000);
+
+    /** Floor for @c suspendFanoutBudget, so one frame always gets out. */
+    static constexpr auto kMinSuspendFanoutBudget = std::chrono::milliseconds(500);
+
+    /** Wake-probe tick; bounds how late after thaw the wake is seen. */
+    static constexpr auto kWakeProbeInterval = std::chrono::milliseconds(200);
+
+    /**
+     * Growth of @c CLOCK_BOOTTIME over @c CLOCK_MONOTONIC that counts
+     * as a sleep. Well above scheduling noise, well below any real
+     * suspend.
+     */
+    static constexpr auto kWakeGapThreshold = std::chrono::seconds(1);
+
+    /** A bus, its connection-lost reconnect cycle, and its resume outcome. */
+    struct BusState {
+        explicit BusState(Bus b) : bus(std::move(b)) {}
+
+        Bus              bus;
+        AdapterReconnect reconnect{
+            BackoffSchedule{
+                std::chrono::seconds(5),
+                std::chrono::seconds(10),
+                std::chrono::seconds(20),
+            },
+            kConnectionLostRetryDelay,
+        };
+        bool             resumed = false;
+    };
+
+    // Fixed at construction, so an index stays valid in completions.
+    std::vector<BusState> m_buses;
+    LoopTimer&            m_suspendSafetyTimer;
+    LoopTimer&            m_wakeProbeTimer;
+
+    // Buses still running the current suspend or resume pass, and the
+    // slowest suspend so far. The lifecycle FSM runs one pass at a
+    // time, so one count serves both.
+    std::size_t               m_pendingBuses = 0;
+    std::chrono::milliseconds m_slowestSuspend{0};
+
+    // CLOCK_BOOTTIME minus CLOCK_MONOTONIC when the wake probe was
+    // armed; time spent asleep is the growth of this difference.
+    std::chrono::nanoseconds m_sleepBaseline{0};
 
     // Wired post-construction; null until setupPowerMonitor succeeds,
     // and reset back to null on attach failure or shutdown teardown.
@@ -248,20 +379,11 @@ private:
     // empty callback is legal.
     const AdapterUnrecoverableCallback m_onAdapterUnrecoverable;
 
-    // Pure decision types driving suspend/resume arbitration and the
-    // connection-lost reconnect cycle. Both main-thread only; no
-    // atomics or mutexes. The supervisor is the sole executor of their
-    // outputs. Named to match their class types so they are unambiguous
-    // alongside @c m_lifecycle (the @c AdapterLifecycle reference).
-    PowerLifecycle   m_powerLifecycle;
-    AdapterReconnect m_adapterReconnect{
-        BackoffSchedule{
-            std::chrono::seconds(5),
-            std::chrono::seconds(10),
-            std::chrono::seconds(20),
-        },
-        kConnectionLostRetryDelay,
-    };
+    // Pure decision type driving suspend/resume arbitration, shared by
+    // every bus; each bus's reconnect FSM sits in its BusState. Main-
+    // thread only; no atomics or mutexes. The supervisor is the sole
+    // executor of their outputs.
+    PowerLifecycle m_powerLifecycle;
 };
 
 } // namespace cec_control
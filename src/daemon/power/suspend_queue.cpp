@@ -1,9 +1,59 @@
 #include "suspend_queue.h"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
 #include <utility>
 
+#include "../../common/logger.h"
+
 namespace cec_control {
 
+namespace {
+
+constexpr std::size_t kDeviceCount = 16;
+
+/** Every device a power command reaches; empty for any other command. */
+DeviceSet powerTargets(const Message& command) {
+    if (command.type != MessageType::CMD_POWER_ON &&
+        command.type != MessageType::CMD_POWER_OFF) {
+        return 0;
+    }
+    constexpr DeviceSet kBroadcastBit = 1u << kBroadcastAddress;
+    constexpr DeviceSet kEveryDevice  = 0xFFFF;
+    const bool off = command.type == MessageType::CMD_POWER_OFF;
+    DeviceSet targets = static_cast<DeviceSet>(1u << (command.deviceId % kDeviceCount));
+    if (!command.data.empty()) {
+        // A malformed payload covers nothing, so nothing is dropped for it.
+        targets = decodeDeviceSet(command.data).value_or(0);
+    }
+    if (targets & kBroadcastBit) {
+        // A standby to the broadcast address reaches everyone; a wake
+        // cannot be broadcast and ignores the bit.
+        return off ? kEveryDevice : static_cast<DeviceSet>(targets & ~kBroadcastBit);
+    }
+    return targets;
+}
+
+/**
+ * Replay rank of a surviving command: power before anything else, so a
+ * device woken at resume is listening when its volume changes arrive.
+ */
+int replayRank(const Message& command) {
+    return powerTargets(command) != 0 ? 0 : 1;
+}
+
+/** The up and down steps queued for one device since its last mute or set. */
+struct VolumeRun {
+    int                      net = 0;
+    std::vector<std::size_t> members;
+};
+
+} // namespace
+
 void SuspendQueue::enterSuspended() noexcept {
     m_suspended = true;
 }
@@ -16,13 +66,109 @@ bool SuspendQueue::isSuspended() const noexcept {
     return m_suspended;
 }
 
-void SuspendQueue::push(const Message& command) {
-    if (!isSuspended()) return;
-    m_queued.push_back(command);
+void SuspendQueue::setLimits(const Limits& limits) noexcept {
+    m_limits = limits;
 }
 
-std::vector<Message> SuspendQueue::drain() {
-    return std::exchange(m_queued, std::vector<Message>{});
+bool SuspendQueue::push(const Message& command, Clock::time_point now) {
+    if (!isSuspended()) return true;
+    if (m_limits.capacity > 0 && m_queued.size() >= m_limits.capacity) {
+        discardExpired(now);
+        if (m_queued.size() >= m_limits.capacity) return false;
+    }
+    const Clock::time_point expiresAt =
+        m_limits.ttl.count() > 0 ? now + m_limits.ttl : Clock::time_point::max();
+    m_queued.push_back(Entry{command, expiresAt});
+    return true;
+}
+
+std::size_t SuspendQueue::discardExpired(Clock::time_point now) {
+    const auto kept = std::remove_if(m_queued.begin(), m_queued.end(),
+                                     [now](const Entry& e) { return e.expiresAt <= now; });
+    const auto expired = static_cast<std::size_t>(m_queued.end() - kept);
+    m_queued.erase(kept, m_queued.end());
+    if (expired > 0) {
+        LOG_INFO("Dropped ", expired, " queued commands older than ",
+                 m_limits.ttl.count(), " ms");
+    }
+    return expired;
+}
+
+std::vector<Message> SuspendQueue::drain(Clock::time_point now) {
+    discardExpired(now);
+    std::vector<Message> queued;
+    queued.reserve(m_queued.size());
+    for (Entry& entry : m_queued) queued.push_back(std::move(entry.command));
+    m_queued.clear();
+    if (queued.size() < 2) return queued;
+
+    // What each queued command becomes: itself, nothing, or a run of
+    // volume steps.
+    std::vector<std::vector<Message>> slots(queued.size());
+    for (std::size_t i = 0; i < queued.size(); ++i) slots[i].push_back(queued[i]);
+
+    // Power, newest first: a command survives only if some device it
+    // targets has no later power command.
+    DeviceSet covered = 0;
+    for (std::size_t i = queued.size(); i-- > 0;) {
+        const DeviceSet targets = powerTargets(queued[i]);
+        if (targets == 0) continue;
+        if ((targets & ~covered) == 0) slots[i].clear();
+        covered |= targets;
+    }
+
+    // Volume, oldest first.
+    std::array<VolumeRun, kDeviceCount> runs;
+    std::array<std::optional<std::size_t>, kDeviceCount> lastSet;
+    auto settle = [&](VolumeRun& run, uint8_t device) {
+        if (run.members.empty()) return;
+        for (const std::size_t member : run.members) slots[member].clear();
+        const Message step(run.net > 0 ? MessageType::CMD_VOLUME_UP
+                                         : MessageType::CMD_VOLUME_DOWN, device);
+        slots[run.members.back()].assign(static_cast<std::size_t>(std::abs(run.net)), step);
+        run = VolumeRun{};
+    };
+    for (std::size_t i = 0; i < queued.size(); ++i) {
+        const Message& command = queued[i];
+        const uint8_t device   = command.deviceId % kDeviceCount;
+        VolumeRun& run = runs[device];
+        switch (command.type) {
+        case MessageType::CMD_VOLUME_UP:
+        case MessageType::CMD_VOLUME_DOWN:
+            run.net += command.type == MessageType::CMD_VOLUME_UP ? 1 : -1;
+            run.members.push_back(i);
+            break;
+        case MessageType::CMD_VOLUME_SET:
+            // The level it asks for makes what came before it moot.
+            for (const std::size_t member : run.members) slots[member].clear();
+            run = VolumeRun{};
+            if (lastSet[device]) slots[*lastSet[device]].clear();
+            lastSet[device] = i;
+            break;
+        case MessageType::CMD_VOLUME_MUTE:
+            settle(run, command.deviceId);
+            lastSet[device].reset();
+            break;
+        default:
+            break;
+        }
+    }
+    for (std::size_t device = 0; device < kDeviceCount; ++device) {
+        settle(runs[device], static_cast<uint8_t>(device));
+    }
+
+    std::vector<Message> compacted;
+    for (auto& slot : slots) {
+        for (auto& command : slot) compacted.push_back(std::move(command));
+    }
+    if (compacted.size() < queued.size()) {
+        LOG_INFO("Compacted ", queued.size(), " queued commands to ", compacted.size());
+    }
+    std::stable_sort(compacted.begin(), compacted.end(),
+                     [](const Message& a, const Message& b) {
+                         return replayRank(a) < replayRank(b);
+                     });
+    return compacted;
 }
 
 } // namespace cec_control
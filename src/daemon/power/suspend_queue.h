@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <vector>
 
+#include "../../common/boot_clock.h"
 #include "../../common/messages.h"
 
 namespace cec_control {
@@ -32,6 +35,15 @@ namespace cec_control {
  *  - Shutdown gating. Distinct state with a distinct lifecycle,
  *    handled by @c AdapterLifecycle directly.
  *
+ * ## Limits
+ *
+ * A suspend can last all night. @c setLimits bounds how many commands
+ * are kept and how long each stays worth running; a client was told
+ * its command was accepted when it was queued, so an expired entry is
+ * dropped with a log line rather than answered. Ages are kept on
+ * @c BootClock, which runs through the suspend itself; on the
+ * monotonic clock a night asleep would not count toward the TTL.
+ *
  * ## Thread-safety
  *
  * Every public method must be called on the main thread. The single-
@@ -41,6 +53,14 @@ namespace cec_control {
  */
 class SuspendQueue {
 public:
+    using Clock = BootClock;
+
+    /** How many commands are kept, and for how long. 0 = no limit. */
+    struct Limits {
+        std::size_t               capacity = 0;
+        std::chrono::milliseconds ttl{0};
+    };
+
     SuspendQueue() = default;
 
     SuspendQueue(const SuspendQueue&) = delete;
@@ -60,19 +80,51 @@ public:
     /** Read the suspend flag. */
     [[nodiscard]] bool isSuspended() const noexcept;
 
+    /** Apply @p limits to later pushes; entries already queued keep their expiry. */
+    void setLimits(const Limits& limits) noexcept;
+
     /**
      * Append @p command if currently suspended; otherwise no-op. The
      * check is internal so this primitive is safe to call without a
-     * prior @c isSuspended test.
+     * prior @c isSuspended test. Expired entries are discarded first;
+     * if the queue is still at capacity the command is refused.
+     *
+     * @return @c false only when the queue was full.
      */
-    void push(const Message& command);
+    [[nodiscard]] bool push(const Message& command, Clock::time_point now = Clock::now());
 
-    /** Take the queued messages; leave the queue empty. */
-    [[nodiscard]] std::vector<Message> drain();
+    /**
+     * Take the queued messages, compacted to the least work with the
+     * same end state, and leave the queue empty. Arrival order is kept
+     * among what survives:
+     *
+     *  - Power: a power command is dropped when later ones cover every
+     *    device it targets, so each device gets only its last one.
+     *  - Volume: per device, the up and down steps between two mutes
+     *    or absolute sets net out to one run of identical steps, put
+     *    where the last of them was; @c CommandDispatcher::replay sends
+     *    such a run as one coalesced command. A set drops the steps
+     *    and any set before it back to the previous mute.
+     *
+     * Mutes are toggles and are kept as they are. Entries past their
+     * expiry are dropped before any of this, and what survives is
+     * ordered power first: a device has to be awake before a volume
+     * change means anything to it.
+     */
+    [[nodiscard]] std::vector<Message> drain(Clock::time_point now = Clock::now());
 
 private:
-    bool                 m_suspended = false;
-    std::vector<Message> m_queued;
+    struct Entry {
+        Message           command;
+        Clock::time_point expiresAt;
+    };
+
+    /** Drop the entries past their expiry; returns how many went. */
+    std::size_t discardExpired(Clock::time_point now);
+
+    bool               m_suspended = false;
+    Limits             m_limits;
+    std::vector<Entry> m_queued;
 };
 
 } // namespace cec_control
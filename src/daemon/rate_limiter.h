@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+namespace cec_control {
+
+/**
+ * Requests each client may send: a token bucket of @c burst requests,
+ * refilled at @c perSecond. The Unix socket tells clients apart by
+ * user (@c SO_PEERCRED uid) rather than process, because every CLI
+ * invocation is a fresh pid; the network endpoint by peer address.
+ */
+struct ClientRateLimit {
+    std::uint32_t perSecond = 0;  ///< 0 = no limit.
+    std::uint32_t burst     = 1;
+};
+
+/**
+ * One token bucket per client @p Key for a @c ClientRateLimit. A
+ * bucket starts full on its client's first request, is topped up
+ * lazily as later ones arrive, and is kept after the client
+ * disconnects, so reconnecting cannot refill it. Main thread only.
+ */
+template <typename Key>
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /** Outcome of @c take. */
+    enum class Verdict {
+        Allowed,
+        Refused,       ///< Refused again in the same episode.
+        FirstRefused,  ///< Refused after an allowed request: log this one.
+    };
+
+    explicit RateLimiter(ClientRateLimit limit) noexcept
+        : m_limit{limit.perSecond, std::max<std::uint32_t>(limit.burst, 1)} {}
+
+    [[nodiscard]] const ClientRateLimit& limit() const noexcept { return m_limit; }
+
+    /** Spend one of @p client's tokens, if it has one. */
+    [[nodiscard]] Verdict take(const Key& client, Clock::time_point now = Clock::now()) {
+        if (m_limit.perSecond == 0) return Verdict::Allowed;
+
+        const double cap = m_limit.burst;
+        auto [it, inserted] = m_buckets.try_emplace(client);
+        Bucket& bucket = it->second;
+        if (inserted) {
+            bucket.tokens = cap;
+        } else {
+            const std::chrono::duration<double> elapsed = now - bucket.refilled;
+            bucket.tokens = std::min(cap, bucket.tokens + elapsed.count() * m_limit.perSecond);
+        }
+        bucket.refilled = now;
+
+        if (bucket.tokens >= 1.0) {
+            bucket.tokens -= 1.0;
+            bucket.limited = false;
+            return Verdict::Allowed;
+        }
+        return std::exchange(bucket.limited, true) ? Verdict::Refused : Verdict::FirstRefused;
+    }
+
+private:
+    struct Bucket {
+        double            tokens = 0;
+        Clock::time_point refilled;
+        bool              limited = false;  ///< Last request refused.
+    };
+
+    ClientRateLimit                   m_limit;
+    std::unordered_map<Key, Bucket>   m_buckets;
+};
+
+} // namespace cec_control
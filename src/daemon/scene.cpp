@@ -0,0 +1,147 @@
+#include "scene.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+#include "../common/command_registry.h"
+#include "command_dispatch.h"
+
+namespace cec_control {
+
+namespace {
+
+/** Split @p text on @p sep, trimming whitespace; empty pieces are kept. */
+std::vector<std::string_view> splitTrimmed(std::string_view text, char sep) {
+    std::vector<std::string_view> out;
+    std::size_t begin = 0;
+    while (true) {
+        const std::size_t end = std::min(text.find(sep, begin), text.size());
+        std::string_view piece = text.substr(begin, end - begin);
+        while (!piece.empty() && std::isspace(static_cast<unsigned char>(piece.front()))) {
+            piece.remove_prefix(1);
+        }
+        while (!piece.empty() && std::isspace(static_cast<unsigned char>(piece.back()))) {
+            piece.remove_suffix(1);
+        }
+        out.push_back(piece);
+        if (end == text.size()) return out;
+        begin = end + 1;
+    }
+}
+
+/** Whitespace-separated words of @p text. */
+std::vector<std::string_view> words(std::string_view text) {
+    std::vector<std::string_view> out;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+        const std::size_t begin = pos;
+        while (pos < text.size() && !std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+        if (pos > begin) out.push_back(text.substr(begin, pos - begin));
+    }
+    return out;
+}
+
+/** `wait MS`: the pause in milliseconds, or nullopt with @p err set. */
+std::optional<std::chrono::milliseconds>
+parseWait(const std::vector<std::string_view>& args, std::string& err) {
+    if (args.size() != 1 || args[0].empty() ||
+        !std::all_of(args[0].begin(), args[0].end(),
+                     [](unsigned char c) { return std::isdigit(c) != 0; })) {
+        err = "wait requires a duration in milliseconds";
+        return std::nullopt;
+    }
+    // Digits only, so anything longer than the ceiling's width is over it.
+    if (args[0].size() > 5) {
+        err = "wait is longer than " + std::to_string(kMaxSceneWait.count()) + " ms";
+        return std::nullopt;
+    }
+    return std::chrono::milliseconds(std::stoi(std::string(args[0])));
+}
+
+} // namespace
+
+std::optional<Scene> compileScene(std::string name, std::string_view steps,
+                                  std::string& err) {
+    if (!isValidSceneName(name)) {
+        err = "invalid scene name";
+        return std::nullopt;
+    }
+
+    Scene scene;
+    scene.name = std::move(name);
+    std::chrono::milliseconds pending{0};
+    std::chrono::milliseconds totalWait{0};
+
+    const auto pieces = splitTrimmed(steps, ',');
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+        const std::string where = "step " + std::to_string(i + 1) + ": ";
+        const auto tokens = words(pieces[i]);
+        if (tokens.empty()) {
+            err = where + "empty step";
+            return std::nullopt;
+        }
+        const std::vector<std::string_view> args(tokens.begin() + 1, tokens.end());
+
+        if (tokens[0] == "wait") {
+            const auto wait = parseWait(args, err);
+            if (!wait) {
+                err = where + err;
+                return std::nullopt;
+            }
+            pending   += *wait;
+            totalWait += *wait;
+            if (totalWait > kMaxSceneWait) {
+                err = "waits add up to more than " +
+                      std::to_string(kMaxSceneWait.count()) + " ms";
+                return std::nullopt;
+            }
+            continue;
+        }
+
+        const CommandSpec* spec = findByName(tokens[0]);
+        if (spec == nullptr) {
+            err = where + "unknown command '" + std::string(tokens[0]) + "'";
+            return std::nullopt;
+        }
+        auto command = spec->parse(args, err);
+        if (!command) {
+            err = where + err;
+            return std::nullopt;
+        }
+        // The same gate submitBatchWork applies, plus the class: a
+        // scene runs at Interactive and must not carry recovery work.
+        const DispatchSpec* row = findDispatchByType(command->type);
+        if (row == nullptr || row->dispatch != DispatchClass::AdapterCall ||
+            row->priority != WorkPriority::Interactive) {
+            err = where + "'" + std::string(tokens[0]) + "' cannot run in a scene";
+            return std::nullopt;
+        }
+        if (scene.steps.size() == kMaxSceneSteps) {
+            err = "more than " + std::to_string(kMaxSceneSteps) + " commands";
+            return std::nullopt;
+        }
+        scene.steps.push_back(SceneStep{std::move(*command), pending});
+        pending = std::chrono::milliseconds{0};
+    }
+
+    if (scene.steps.empty()) {
+        err = "no commands";
+        return std::nullopt;
+    }
+    if (pending.count() > 0) {
+        err = "ends with a wait";
+        return std::nullopt;
+    }
+    return scene;
+}
+
+const Scene* findScene(const SceneTable& scenes, std::string_view name) noexcept {
+    for (const auto& scene : scenes) {
+        if (scene.name == name) return &scene;
+    }
+    return nullptr;
+}
+
+} // namespace cec_control
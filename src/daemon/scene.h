@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../common/messages.h"
+
+namespace cec_control {
+
+/** Most commands one scene may run. */
+inline constexpr std::size_t kMaxSceneSteps = 32;
+
+/**
+ * Ceiling on the sum of a scene's waits. The client waits 10 s for a
+ * reply, so a scene must finish well inside that with its commands'
+ * own bus time added.
+ */
+inline constexpr std::chrono::milliseconds kMaxSceneWait{8000};
+
+/**
+ * One command of a compiled scene, with the pause the scene asks for
+ * between the previous command finishing and this one starting.
+ */
+struct SceneStep {
+    Message                   command;
+    std::chrono::milliseconds pauseBefore{0};
+};
+
+/**
+ * A named, validated command sequence from a @c [Scene.NAME] config
+ * section, run by @c CMD_SCENE. Every step is an Interactive adapter
+ * command that has already passed its own argument parser, so running
+ * the scene needs no further checking.
+ */
+struct Scene {
+    std::string            name;
+    std::vector<SceneStep> steps;
+};
+
+using SceneTable = std::vector<Scene>;
+
+/**
+ * Compile the @c Steps value of a scene section: comma-separated
+ * steps, each either a client command in command-line syntax
+ * (`power on 0`, `source 0 3`, `key select`) or `wait MS`. Consecutive
+ * waits add up; a trailing wait is rejected as a likely mistake.
+ * Returns @c std::nullopt with @p err set when a step does not parse,
+ * names a command that is not an Interactive adapter command (queries,
+ * @c batch, @c restart, @c suspend ...), or the scene exceeds
+ * @c kMaxSceneSteps or @c kMaxSceneWait.
+ */
+[[nodiscard]] std::optional<Scene> compileScene(std::string name,
+                                                std::string_view steps,
+                                                std::string& err);
+
+/** Scene called @p name in @p scenes, or @c nullptr. */
+[[nodiscard]] const Scene* findScene(const SceneTable& scenes,
+                                     std::string_view name) noexcept;
+
+} // namespace cec_control
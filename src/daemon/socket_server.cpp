@@ -2,14 +2,24 @@
 
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <utility>
 #include <vector>
 
 #include "../common/event_poller.h"
 #include "../common/logger.h"
+#include "../common/loop_timer.h"
+#include "../common/ring_queue.h"
+#include "../common/systemd_notify.h"
+#include "../common/trace.h"
+#include "command_dispatch.h"
+#include "flight_recorder.h"
+#include "metrics.h"
 
 namespace cec_control {
 
@@ -20,30 +30,58 @@ constexpr mode_t SOCKET_FILE_PERMISSIONS = 0660;
 
 constexpr std::uint32_t READ_BIT  = static_cast<std::uint32_t>(EventPoller::Event::READ);
 constexpr std::uint32_t WRITE_BIT = static_cast<std::uint32_t>(EventPoller::Event::WRITE);
+constexpr std::uint32_t EDGE_BIT  = static_cast<std::uint32_t>(EventPoller::Event::EDGE);
 
 } // namespace
 
 /**
  * Per-session state held entirely on the main thread.
  *
- * Invariants (maintained across every main-thread transition):
- *   - @c requestInFlight ⇒ READ is NOT in the epoll mask.
- *   - @c !pendingResponse.empty() ⇒ WRITE IS in the epoll mask.
- *   - At most one of the two is truthy at any moment.
+ * Invariants (maintained across every main-thread transition, via
+ * @c updateInterest):
+ *   - READ is in the epoll mask iff @c inFlight < kMaxInFlightPerSession
+ *     and @c peer->inFlight < kMaxInFlightPerPeer (see @c readable).
+ *   - WRITE is in the epoll mask iff @c pendingResponses or
+ *     @c pendingEvents is non-empty and no end-of-pass flush is
+ *     queued (@c flushQueued); @c interest mirrors the mask last
+ *     given to the loop, so an unchanged mask costs no syscall.
+ *   - Queued responses go out in the order they were produced; a new
+ *     response never overtakes one already queued. Likewise for events,
+ *     which wait behind every queued response.
+ *   - @c pendingEvents holds at most @c kMaxQueuedEventsPerSession
+ *     frames, and is empty unless @c subscribedMask is non-zero.
+ *   - @c idleTimer is armed iff @c inFlight is 0 and @c subscribedMask
+ *     is 0, due @c kClientIdleTimeout after the last request or send
+ *     (see @c refreshIdleDeadline).
  */
 struct SocketServer::Session {
-    Session(SessionId i, UnixSocket f, std::chrono::steady_clock::time_point t) noexcept
-        : id(i), fd(std::move(f)), lastActivity(t) {}
+    Session(SessionId i, UnixSocket f, EventLoop& loop) noexcept
+        : id(i), fd(std::move(f)), idleTimer(loop) {}
 
     SessionId                              id;
     UnixSocket                             fd;
-    std::chrono::steady_clock::time_point  lastActivity;
-    std::vector<std::uint8_t>              pendingResponse;
-    bool                                   requestInFlight = false;
+    LoopTimer                              idleTimer;
+    Peer*                                  peer = nullptr;  // Never null once admitted.
+    RingQueue<InlineBytes>                 pendingResponses;
+    std::size_t                            inFlight = 0;
+    std::uint32_t                          interest = READ_BIT;
+    bool                                   flushQueued = false;
+    // Framing both ways; moves past legacy only on the first frame.
+    std::uint8_t                           protocol = kProtocolLegacy;
+    bool                                   opened = false;
+
+    // Event subscription; inactive while subscribedMask is 0.
+    BusEventMask                           subscribedMask = 0;
+    RequestId                              subscriptionId = 0;
+    RingQueue<InlineBytes>                 pendingEvents;
+    std::uint32_t                          droppedEvents = 0;
 };
 
-SocketServer::SocketServer(EventLoop& loop, std::string socketPath)
-    : m_loop(loop), m_socketPath(std::move(socketPath)) {}
+SocketServer::SocketServer(EventLoop& loop, std::string socketPath,
+                           std::size_t maxConnections, ClientRateLimit rateLimit)
+    : m_loop(loop), m_socketPath(std::move(socketPath)),
+      m_maxConnections(std::max<std::size_t>(maxConnections, 1)),
+      m_rateLimiter(rateLimit) {}
 
 SocketServer::~SocketServer() {
     stop();
@@ -53,58 +91,161 @@ void SocketServer::setCommandHandler(CommandHandler handler) {
     m_handler = std::move(handler);
 }
 
+void SocketServer::setSubscriptionHandler(SubscriptionHandler handler) {
+    m_subscriptionHandler = std::move(handler);
+}
+
 bool SocketServer::start() {
     if (m_listener.valid()) {
         LOG_WARNING("Socket server already running");
         return true;
     }
-    if (!m_idleTimer.valid()) {
-        LOG_ERROR("Idle timer source not initialised");
+    if (!m_loop.timersValid()) {
+        LOG_ERROR("Event loop timers not initialised; idle sessions cannot expire");
         return false;
     }
 
-    // The parent directory is provisioned by DaemonBootstrap. Verify that we
-    // can actually write into it; surface a clear error if a packaging or
-    // permissions regression has left the path unusable.
-    if (auto slash = m_socketPath.find_last_of('/'); slash != std::string::npos) {
-        const std::string parent = m_socketPath.substr(0, slash);
-        if (::access(parent.c_str(), W_OK) != 0) {
-            LOG_ERROR("Socket directory not writable: ", parent,
-                      " (", std::strerror(errno), ")");
-            return false;
-        }
+    if (SystemdNotify::fdStoreCapacity() == 0) {
+        LOG_INFO("No file descriptor store ($FDSTORE unset; needs systemd 254 or newer "
+                 "and FileDescriptorStoreMax=): clients are disconnected across a restart");
     }
 
-    m_listener = UnixSocket::listen(m_socketPath, SOCKET_FILE_PERMISSIONS, LISTEN_BACKLOG);
-    if (!m_listener.valid()) {
-        return false;
+    auto inherited = SystemdNotify::takeInheritedFds(m_socketPath);
+    // Owned from here, so every early return below closes them.
+    std::vector<std::pair<UnixSocket, std::string>> handedOver;
+    for (auto& passed : inherited.sessions) {
+        handedOver.emplace_back(UnixSocket(passed.fd), std::move(passed.name));
     }
+    if (inherited.listener >= 0) {
+        m_listener       = UnixSocket(inherited.listener);
+        m_listenerStored = inherited.listenerStored;
+        m_activated      = !m_listenerStored;
+        LOG_INFO(m_activated ? "Using socket-activated listener"
+                             : "Using the listener kept from the previous daemon");
+    } else {
+        m_activated      = false;
+        m_listenerStored = false;
+        // The parent directory is provisioned by DaemonBootstrap. Verify
+        // that we can actually write into it; surface a clear error if a
+        // packaging or permissions regression has left the path unusable.
+        if (auto slash = m_socketPath.find_last_of('/'); slash != std::string::npos) {
+            const std::string parent = m_socketPath.substr(0, slash);
+            if (::access(parent.c_str(), W_OK) != 0) {
+                LOG_ERROR("Socket directory not writable: ", parent,
+                          " (", std::strerror(errno), ")");
+                return false;
+            }
+        }
 
-    // Register listener + idle sweep timer. On any failure we unwind through
-    // stop(), which idempotently cleans up whichever pieces we committed.
-    if (!m_loop.add(m_listener.get(), READ_BIT,
+        m_listener = UnixSocket::listen(m_socketPath, SOCKET_FILE_PERMISSIONS, LISTEN_BACKLOG);
+        if (!m_listener.valid()) {
+            return false;
+        }
+        // With a copy in the service manager's keeping, the socket
+        // goes on listening while the daemon restarts: clients that
+        // connect in between wait in its backlog for the next one.
+        if (SystemdNotify::fdStoreCapacity() > 0) {
+            m_listenerStored = SystemdNotify::storeFd(m_listener.get(),
+                                                      SystemdNotify::kListenerFdName);
+        }
+    }
+
+    // Register the listener, edge-triggered: onAcceptReady always
+    // accepts until EAGAIN. On failure we unwind through stop(), which
+    // idempotently cleans up whichever pieces we committed.
+    if (!m_loop.add(m_listener.get(), READ_BIT | EDGE_BIT,
                     [this](std::uint32_t) { onAcceptReady(); })) {
         LOG_ERROR("Failed to register listener with event loop");
         stop();
         return false;
     }
-    if (!m_loop.add(m_idleTimer.fd(), READ_BIT,
-                    [this](std::uint32_t) { onIdleSweep(); })) {
-        LOG_ERROR("Failed to register idle timer with event loop");
-        stop();
-        return false;
-    }
-    if (!m_idleTimer.armOnce(
-            std::chrono::duration_cast<std::chrono::milliseconds>(kIdleSweepInterval))) {
-        LOG_ERROR("Failed to arm idle sweep timer");
-        stop();
-        return false;
-    }
 
     LOG_INFO("Socket server listening on ", m_socketPath);
+    if (!handedOver.empty()) adoptSessions(std::move(handedOver));
     return true;
 }
 
+void SocketServer::handOver() {
+    std::size_t room = SystemdNotify::fdStoreCapacity();
+    if (room == 0 || !m_listener.valid()) return;
+    if (m_listenerStored) --room;
+
+    char name[64];
+    std::size_t handed = 0;
+    const std::size_t total = m_sessions.size() + m_acceptQueue.size();
+    for (const auto& [id, session] : m_sessions) {
+        // A request the next daemon cannot answer, or a reply it never
+        // saw, would leave the client waiting: those sessions close.
+        if (room == 0) break;
+        if (session->inFlight > 0 || !session->pendingResponses.empty()) continue;
+        const std::uint32_t lost = session->subscribedMask != 0
+            ? session->droppedEvents + static_cast<std::uint32_t>(session->pendingEvents.size())
+            : 0;
+        std::snprintf(name, sizeof(name), "%.*s%u.%u.%u.%u.%u",
+                      static_cast<int>(SystemdNotify::kSessionFdPrefix.size()),
+                      SystemdNotify::kSessionFdPrefix.data(),
+                      static_cast<unsigned>(session->protocol), session->opened ? 1u : 0u,
+                      static_cast<unsigned>(session->subscribedMask),
+                      static_cast<unsigned>(session->subscriptionId), lost);
+        if (SystemdNotify::storeFd(session->fd.get(), name)) {
+            ++handed;
+            --room;
+        }
+    }
+    // Accepted clients still waiting for a slot have said nothing yet.
+    std::snprintf(name, sizeof(name), "%.*s%u.0.0.0.0",
+                  static_cast<int>(SystemdNotify::kSessionFdPrefix.size()),
+                  SystemdNotify::kSessionFdPrefix.data(),
+                  static_cast<unsigned>(kProtocolLegacy));
+    for (const UnixSocket& client : m_acceptQueue) {
+        if (room == 0) break;
+        if (SystemdNotify::storeFd(client.get(), name)) {
+            ++handed;
+            --room;
+        }
+    }
+    if (total > 0) {
+        LOG_INFO("Handed ", handed, " of ", total, " client sessions to the next daemon");
+    }
+}
+
+void SocketServer::adoptSessions(std::vector<std::pair<UnixSocket, std::string>> handedOver) {
+    std::size_t adopted = 0;
+    std::vector<std::string> names;
+    for (auto& [client, name] : handedOver) {
+        unsigned protocol = 0, opened = 0, mask = 0, subscriptionId = 0, lost = 0;
+        char extra = 0;
+        const std::string state = name.substr(SystemdNotify::kSessionFdPrefix.size());
+        if (std::sscanf(state.c_str(), "%u.%u.%u.%u.%u%c", &protocol, &opened, &mask,
+                        &subscriptionId, &lost, &extra) != 5 ||
+            protocol < kProtocolLegacy || protocol > kProtocolVersion ||
+            (mask & ~static_cast<unsigned>(kAllBusEvents)) != 0 || subscriptionId > UINT16_MAX) {
+            LOG_WARNING("Closing handed-over session with unknown state ", name);
+        } else if (Session* session = admitSession(std::move(client))) {
+            session->protocol       = static_cast<std::uint8_t>(protocol);
+            session->opened         = opened != 0;
+            session->subscribedMask = static_cast<BusEventMask>(mask);
+            session->subscriptionId = static_cast<RequestId>(subscriptionId);
+            refreshIdleDeadline(*session);
+            // What the old daemon still had queued is gone; the
+            // subscriber hears how much once it is read again.
+            if (session->subscribedMask != 0 && lost > 0) {
+                session->droppedEvents = lost;
+                scheduleFlush(session->id, *session);
+            }
+            ++adopted;
+        }
+        if (std::find(names.begin(), names.end(), name) == names.end()) {
+            names.push_back(std::move(name));
+        }
+    }
+    // The store keeps what it passes; left there, a copy would hold
+    // each client's connection open after its session here closes.
+    for (const std::string& name : names) SystemdNotify::removeStoredFds(name);
+    updateSubscriptions();
+    LOG_INFO("Took over ", adopted, " client sessions from the previous daemon");
+}
+
 void SocketServer::stop() {
     if (!m_listener.valid() && m_sessions.empty()) {
         return;
@@ -112,12 +253,6 @@ void SocketServer::stop() {
 
     LOG_INFO("Stopping socket server");
 
-    // Idle timer first so it cannot fire while we are tearing the map down.
-    if (m_idleTimer.valid()) {
-        m_loop.remove(m_idleTimer.fd());
-        m_idleTimer.disarm();
-    }
-
     // Listener next so no new accepts can land during session teardown.
     if (m_listener.valid()) {
         m_loop.remove(m_listener.get());
@@ -127,12 +262,22 @@ void SocketServer::stop() {
     // Every session fd must come out of the loop before its UnixSocket
     // destructor closes it; otherwise a future add() against a freshly
     // recycled fd could conflict with a stale epoll registration.
+    // Queued clients were never registered.
+    m_acceptQueue.clear();
+    m_flushQueue.clear();
     for (auto& [_, session] : m_sessions) {
         m_loop.remove(session->fd.get());
     }
     m_sessions.clear();
-
-    if (::unlink(m_socketPath.c_str()) < 0 && errno != ENOENT) {
+    m_peers.clear();
+    Metrics::getInstance().set(Metrics::Gauge::QueuedSessions, 0);
+    Metrics::getInstance().set(Metrics::Gauge::ActiveSessions, 0);
+    Metrics::getInstance().set(Metrics::Gauge::EventSubscribers, 0);
+
+    // An activated socket's file stays: systemd keeps listening on it
+    // and starts the daemon again on the next connection. So does one
+    // the fd store keeps for the next daemon.
+    if (!m_activated && !m_listenerStored && ::unlink(m_socketPath.c_str()) < 0 && errno != ENOENT) {
         LOG_WARNING("Failed to unlink socket file ", m_socketPath, ": ",
                     std::strerror(errno));
     }
@@ -149,27 +294,78 @@ void SocketServer::onAcceptReady() {
         if (!client.valid()) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) return;
             if (errno == EINTR || errno == ECONNABORTED) continue;
+            // The listener is edge-triggered, so clients left in the
+            // backlog now wait for the next connection to wake us —
+            // rather than spinning the loop on, say, EMFILE.
             LOG_WARNING("accept() failed: ", std::strerror(errno));
             return;
         }
-        if (m_sessions.size() >= kMaxConnections) {
-            LOG_WARNING("Connection limit reached; dropping new client");
+        if (m_sessions.size() < m_maxConnections) {
+            admitSession(std::move(client));
+            continue;
+        }
+        if (m_acceptQueue.size() >= kAcceptQueueDepth) {
+            LOG_WARNING("Connection limit reached and accept queue full; dropping new client");
+            Metrics::getInstance().increment(Metrics::Counter::SessionsRefused);
             continue;  // UnixSocket dtor closes the fresh fd
         }
+        if (m_acceptQueue.empty()) {
+            LOG_DEBUG("Connection limit reached; queueing new clients");
+        }
+        m_acceptQueue.push_back(std::move(client));
+        Metrics::getInstance().set(Metrics::Gauge::QueuedSessions,
+                                   static_cast<int64_t>(m_acceptQueue.size()));
+    }
+}
 
-        const SessionId id = m_nextId++;
-        auto session = std::make_unique<Session>(
-            id, std::move(client), std::chrono::steady_clock::now());
-        const int fd = session->fd.get();
+SocketServer::Session* SocketServer::admitSession(UnixSocket client) {
+    // A process that cannot be identified is pooled under pid 0 with
+    // every other such peer; the kernel always reports it for AF_UNIX,
+    // so this is defensive.
+    const auto cred = client.peerCredentials();
+    const pid_t pid = cred ? cred->pid : 0;
+
+    const SessionId id = m_nextId++;
+    auto session = std::make_unique<Session>(id, std::move(client), m_loop);
+    const int fd = session->fd.get();
+
+    if (!m_loop.add(fd, READ_BIT,
+                    [this, id](std::uint32_t events) { onSessionEvent(id, events); })) {
+        LOG_WARNING("Failed to register session ", id, " with event loop; dropping");
+        return nullptr;  // session dtor closes fd
+    }
+    Peer& peer = m_peers[pid];
+    if (peer.sessions.empty()) {
+        peer.pid = pid;
+        if (cred) peer.uid = cred->uid;
+    }
+    peer.sessions.push_back(id);
+    session->peer = &peer;
+    LOG_DEBUG("Session ", id, " opened by pid ", pid, " (uid ", peer.uid, ")");
+
+    session->idleTimer.setHandler([this, id] { onSessionIdle(id); });
+    refreshIdleDeadline(*session);
+    Session& admitted = *m_sessions.emplace(id, std::move(session)).first->second;
+    auto& metrics = Metrics::getInstance();
+    metrics.increment(Metrics::Counter::SessionsAccepted);
+    metrics.set(Metrics::Gauge::ActiveSessions,
+                static_cast<int64_t>(m_sessions.size()));
+    // A peer already at its cap starts out unread, like its others.
+    if (!readable(admitted)) {
+        if (!updateInterest(id, admitted)) return nullptr;
+    }
+    return &admitted;
+}
 
-        if (!m_loop.add(fd, READ_BIT,
-                        [this, id](std::uint32_t events) { onSessionEvent(id, events); })) {
-            LOG_WARNING("Failed to register session ", id,
-                        " with event loop; dropping");
-            continue;  // session dtor closes fd
-        }
-        m_sessions.emplace(id, std::move(session));
+void SocketServer::admitQueued() {
+    if (m_acceptQueue.empty()) return;
+    while (!m_acceptQueue.empty() && m_sessions.size() < m_maxConnections) {
+        UnixSocket client = std::move(m_acceptQueue.front());
+        m_acceptQueue.pop_front();
+        admitSession(std::move(client));
     }
+    Metrics::getInstance().set(Metrics::Gauge::QueuedSessions,
+                               static_cast<int64_t>(m_acceptQueue.size()));
 }
 
 void SocketServer::onSessionEvent(SessionId id, std::uint32_t events) {
@@ -182,62 +378,129 @@ void SocketServer::onSessionEvent(SessionId id, std::uint32_t events) {
 
     if (events & READ_BIT) {
         Session* s = findSession(id);
-        if (s && !s->requestInFlight) {
-            processRequest(id, *s);
+        if (s && readable(*s)) {
+            processRequests(id, *s);
             return;
         }
     }
 
     // Hang-up or error with nothing to read/write: the peer is gone.
     // A clean close delivers READ+HANGUP together and the READ branch
-    // above handles it via recv returning 0 + closeSession.
+    // above handles it via a zero-length datagram + closeSession.
     if (events & EventPoller::ERROR_EVENTS) {
         closeSession(id);
     }
 }
 
-void SocketServer::processRequest(SessionId id, Session& session) {
-    ssize_t received = 0;
+void SocketServer::processRequests(SessionId id, Session& session) {
+    // Never read more than the caps could admit: the rest stays in the
+    // kernel buffer, which is what back-pressures the client.
+    const std::size_t budget = std::min({kIoBatch,
+                                         kMaxInFlightPerSession - session.inFlight,
+                                         kMaxInFlightPerPeer - session.peer->inFlight});
+    std::array<mmsghdr, kIoBatch> msgs{};
+    std::array<iovec, kIoBatch>   iov{};
+    for (std::size_t i = 0; i < budget; ++i) {
+        iov[i] = {m_readBuffers[i].data(), m_readBuffers[i].size()};
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int received = 0;
     do {
-        received = ::recv(session.fd.get(), m_readBuffer.data(),
-                          m_readBuffer.size(), MSG_TRUNC);
+        received = ::recvmmsg(session.fd.get(), msgs.data(),
+                              static_cast<unsigned int>(budget), MSG_DONTWAIT, nullptr);
     } while (received < 0 && errno == EINTR);
 
-    if (received == 0) {
-        closeSession(id);
-        return;
-    }
     if (received < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) return;  // spurious
-        LOG_DEBUG("recv() failed for session ", id, ": ", std::strerror(errno));
+        LOG_DEBUG("recvmmsg() failed for session ", id, ": ", std::strerror(errno));
         closeSession(id);
         return;
     }
-    if (static_cast<std::size_t>(received) > m_readBuffer.size()) {
-        // MSG_TRUNC exposed that the datagram was larger than our buffer.
-        // Every legitimate peer uses MAX_MESSAGE_SIZE as its upper bound; a
-        // larger frame is a protocol-level divergence (mismatched constant,
-        // bespoke client, truncation probe) rather than a malformed message.
-        LOG_WARNING("Oversized datagram from session ", id, ": ", received,
-                    " bytes exceeds MAX_MESSAGE_SIZE=", m_readBuffer.size(),
-                    "; closing session (protocol divergence)");
-        closeSession(id);
-        return;
+
+    for (int i = 0; i < received; ++i) {
+        // A handler may close the session; re-resolve it every time.
+        Session* s = findSession(id);
+        if (!s) return;
+        if (msgs[i].msg_len == 0) {
+            closeSession(id);  // orderly shutdown by the peer
+            return;
+        }
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            // The datagram was larger than our buffer. Every legitimate
+            // peer uses MAX_FRAME_SIZE as its upper bound; a larger frame
+            // is a protocol-level divergence (mismatched constant, bespoke
+            // client, truncation probe) rather than a malformed message.
+            LOG_WARNING("Oversized datagram from session ", id,
+                        " exceeds MAX_FRAME_SIZE=", MAX_FRAME_SIZE,
+                        "; closing session (protocol divergence)");
+            closeSession(id);
+            return;
+        }
+        processRequest(id, *s, m_readBuffers[i].data(), msgs[i].msg_len);
     }
+}
 
-    auto request = Message::deserialize(m_readBuffer.data(),
-                                        static_cast<std::size_t>(received));
+void SocketServer::processRequest(SessionId id, Session& session,
+                                  const std::uint8_t* frame, std::size_t len) {
+    auto request = deserializeFrame(session.protocol, frame, len);
     if (!request) {
         LOG_WARNING("Malformed message from session ", id, ", closing");
         closeSession(id);
         return;
     }
 
-    session.requestInFlight = true;
-    session.lastActivity    = std::chrono::steady_clock::now();
-    if (!m_loop.modify(session.fd.get(), 0)) {
-        LOG_WARNING("modify(mask=0) failed for session ", id);
-        closeSession(id);
+    const RequestId requestId = request->requestId;
+    FlightRecorder::getInstance().request(id, requestId,
+                                          static_cast<std::uint8_t>(request->message.type),
+                                          request->message.deviceId);
+    // Tags every line logged on behalf of this request, here and — via
+    // AdapterWorker — on the adapter thread.
+    const LogContextScope logContext(LogContext{
+        LogSubsystem::None,
+        targetsDevice(request->message.type) ? request->message.deviceId : -1,
+        static_cast<int>(request->message.type), id});
+    ++session.inFlight;
+    ++session.peer->inFlight;
+    refreshIdleDeadline(session);
+    if (session.peer->inFlight == kMaxInFlightPerPeer) {
+        // Stops reading every session of the peer, this one included.
+        LOG_DEBUG("Peer pid ", session.peer->pid, " at its in-flight cap; pausing reads");
+        updatePeerInterest(*session.peer);
+        if (!findSession(id)) return;
+    } else if (session.inFlight == kMaxInFlightPerSession &&
+               !updateInterest(id, session)) {
+        return;
+    }
+
+    const bool first = !std::exchange(session.opened, true);
+    if (request->message.type == MessageType::CMD_HELLO) {
+        if (first) {
+            greet(id, requestId, request->message);
+        } else {
+            LOG_WARNING("Hello from session ", id, " after its first request");
+            sendResponse(id, requestId, Message(MessageType::RESP_ERROR));
+        }
+        return;
+    }
+
+    const bool noReply = request->options.noReply;
+    // Refused here, ahead of the handler, a flood costs one reply
+    // apiece and never reaches the adapter worker's queue. A key
+    // release is free: refusing one would leave the key held.
+    if (request->message.type != MessageType::CMD_KEY_UP &&
+        !takeRateToken(session.peer->uid)) {
+        Metrics::getInstance().increment(Metrics::Counter::RateLimited);
+        if (noReply) {
+            retireSilently(id);
+        } else {
+            sendResponse(id, requestId, Message(MessageType::RESP_RATE_LIMITED));
+        }
+        return;
+    }
+    if (request->message.type == MessageType::CMD_SUBSCRIBE) {
+        subscribe(id, session, requestId, request->message, noReply);
         return;
     }
 
@@ -245,106 +508,293 @@ void SocketServer::processRequest(SessionId id, Session& session) {
     // that hits EPIPE, for instance). The reference @p session must not be
     // touched after the invocation returns — every subsequent access goes
     // through sendResponse → findSession.
+    const auto fail = [&] {
+        if (noReply) {
+            retireSilently(id);
+        } else {
+            sendResponse(id, requestId, Message(MessageType::RESP_ERROR));
+        }
+    };
     if (!m_handler) {
-        sendResponse(id, Message(MessageType::RESP_ERROR));
+        fail();
         return;
     }
+    const TraceScope span(TracePoint::SocketRequest,
+                          static_cast<uint32_t>(request->message.type));
+    request->options.session = id;
     try {
-        m_handler(std::move(*request), makeSink(id));
+        m_handler(std::move(request->message),
+                  makeSink(id, requestId, request->message.type, noReply),
+                  request->options);
     } catch (const std::exception& e) {
         LOG_ERROR("Handler threw for session ", id, ": ", e.what());
-        sendResponse(id, Message(MessageType::RESP_ERROR));
+        fail();
     } catch (...) {
         LOG_ERROR("Handler threw non-std exception for session ", id);
-        sendResponse(id, Message(MessageType::RESP_ERROR));
+        fail();
+    }
+}
+
+void SocketServer::greet(SessionId id, RequestId requestId, const Message& request) {
+    if (request.data.size() != 1 || request.data[0] < kProtocolLegacy) {
+        LOG_WARNING("Invalid hello from session ", id);
+        sendResponse(id, requestId, Message(MessageType::RESP_ERROR));
+        return;
+    }
+    const std::uint8_t agreed = std::min(request.data[0], kProtocolVersion);
+    // The reply is serialised before the switch, so it goes out in the
+    // framing the hello came in.
+    sendResponse(id, requestId, Message(MessageType::RESP_SUCCESS, 0, {agreed}));
+    if (Session* s = findSession(id)) {
+        s->protocol = agreed;
+        LOG_DEBUG("Session ", id, " speaks framing version ", static_cast<int>(agreed));
     }
 }
 
+void SocketServer::subscribe(SessionId id, Session& session, RequestId requestId,
+                             const Message& request, bool noReply) {
+    const BusEventMask mask = request.data.empty() ? kAllBusEvents : request.data[0];
+    if (request.data.size() > 1 || (mask & ~kAllBusEvents) != 0) {
+        LOG_WARNING("Invalid subscription from session ", id);
+        if (noReply) {
+            retireSilently(id);
+        } else {
+            sendResponse(id, requestId, Message(MessageType::RESP_ERROR));
+        }
+        return;
+    }
+
+    session.subscribedMask = mask;
+    session.subscriptionId = requestId;
+    refreshIdleDeadline(session);
+    if (mask == 0) {
+        session.pendingEvents.clear();
+        session.droppedEvents = 0;
+        LOG_DEBUG("Session ", id, " unsubscribed from events");
+    } else {
+        LOG_DEBUG("Session ", id, " subscribed to events (mask=",
+                  static_cast<int>(mask), ")");
+    }
+    updateSubscriptions();
+    if (noReply) {
+        retireSilently(id);
+    } else {
+        sendResponse(id, requestId, Message(MessageType::RESP_SUCCESS));
+    }
+}
+
+void SocketServer::publishEvent(const BusEvent& event) {
+    const BusEventMask bit = busEventBit(event.kind);
+    auto& metrics = Metrics::getInstance();
+
+    for (auto& [id, session] : m_sessions) {
+        if ((session->subscribedMask & bit) == 0) continue;
+
+        // Room for the event, plus the overflow notice owed ahead of it.
+        const std::size_t needed = session->droppedEvents > 0 ? 2 : 1;
+        if (session->pendingEvents.size() + needed > kMaxQueuedEventsPerSession) {
+            ++session->droppedEvents;
+            metrics.increment(Metrics::Counter::EventsDropped);
+            continue;
+        }
+        if (session->droppedEvents > 0) {
+            BusEvent notice;
+            notice.dropped = std::exchange(session->droppedEvents, 0);
+            queueEvent(*session, notice);
+        }
+        queueEvent(*session, event);
+        metrics.increment(Metrics::Counter::EventsPublished);
+        // Sending waits for the end of the pass, so the walk is safe.
+        scheduleFlush(id, *session);
+    }
+}
+
+void SocketServer::queueEvent(Session& session, const BusEvent& event) {
+    const std::size_t len = serializeFrameTo(
+        session.protocol, session.subscriptionId, RequestOptions{},
+        Message(MessageType::RESP_EVENT, 0, encodeBusEvent(event)),
+        m_sendBuffer.data(), m_sendBuffer.size());
+    session.pendingEvents.push_back(InlineBytes(m_sendBuffer.data(), len));
+}
+
+bool SocketServer::scheduleFlush(SessionId id, Session& session) {
+    if (session.flushQueued) return true;
+    if (session.interest & WRITE_BIT) return false;  // socket full; WRITE flushes it
+    session.flushQueued = true;
+    m_flushQueue.push_back(id);
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        m_loop.defer([this] { flushSends(); });
+    }
+    return true;
+}
+
+void SocketServer::flushSends() {
+    m_flushScheduled = false;
+    m_flushing.swap(m_flushQueue);
+    for (const SessionId id : m_flushing) {
+        Session* s = findSession(id);
+        if (!s) continue;
+        s->flushQueued = false;
+        (void)drainPendingSend(id);
+    }
+    m_flushing.clear();
+}
+
 bool SocketServer::drainPendingSend(SessionId id) {
     Session* s = findSession(id);
     if (!s) return false;
 
-    ssize_t sent = 0;
-    do {
-        sent = ::send(s->fd.get(), s->pendingResponse.data(),
-                      s->pendingResponse.size(), MSG_NOSIGNAL);
-    } while (sent < 0 && errno == EINTR);
-
-    if (sent >= 0) {
-        // SOCK_SEQPACKET is all-or-nothing: success ⇒ whole datagram out.
-        s->pendingResponse.clear();
-        s->requestInFlight = false;
-        s->lastActivity    = std::chrono::steady_clock::now();
-        if (!m_loop.modify(s->fd.get(), READ_BIT)) {
-            LOG_WARNING("modify(READ) failed after send for session ", id);
+    bool sentAny = false;
+    while (true) {
+        if (s->pendingResponses.empty() && s->pendingEvents.empty()) {
+            // Caught up after losing events: tell the subscriber how many.
+            if (s->droppedEvents == 0) break;
+            BusEvent notice;
+            notice.dropped = std::exchange(s->droppedEvents, 0);
+            queueEvent(*s, notice);
+        }
+
+        // Next batch in send order: every response ahead of any event.
+        std::array<mmsghdr, kIoBatch> msgs{};
+        std::array<iovec, kIoBatch>   iov{};
+        unsigned int count = 0;
+        for (auto* queue : {&s->pendingResponses, &s->pendingEvents}) {
+            for (auto it = queue->begin(); it != queue->end() && count < kIoBatch; ++it) {
+                iov[count] = {it->data(), it->size()};
+                msgs[count].msg_hdr.msg_iov    = &iov[count];
+                msgs[count].msg_hdr.msg_iovlen = 1;
+                ++count;
+            }
+        }
+
+        int sent = 0;
+        do {
+            sent = ::sendmmsg(s->fd.get(), msgs.data(), count, MSG_NOSIGNAL);
+        } while (sent < 0 && errno == EINTR);
+
+        if (sent < 0) {
+            // Level-triggered epoll fires WRITE again when the kernel
+            // buffer drains; the rest stay queued until then.
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            LOG_DEBUG("sendmmsg() failed for session ", id, ": ", std::strerror(errno));
             closeSession(id);
             return false;
         }
-        return true;
-    }
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        // Level-triggered epoll fires WRITE again when the kernel buffer
-        // drains. Stay in Sending until the retry succeeds.
-        return true;
+
+        // SOCK_SEQPACKET is all-or-nothing: each datagram counted went
+        // out whole.
+        for (int i = 0; i < sent; ++i) {
+            auto& queue = !s->pendingResponses.empty() ? s->pendingResponses
+                                                       : s->pendingEvents;
+            queue.pop_front();
+        }
+        sentAny = sentAny || sent > 0;
+        // A short batch means the socket filled; a hard error behind it
+        // surfaces on the next attempt.
+        if (static_cast<unsigned int>(sent) < count) break;
     }
-    LOG_DEBUG("send() failed for session ", id, ": ", std::strerror(errno));
-    closeSession(id);
-    return false;
+    if (sentAny) refreshIdleDeadline(*s);
+    return updateInterest(id, *s);
 }
 
-void SocketServer::sendResponse(SessionId id, Message response) {
-    Session* s = findSession(id);
+void SocketServer::sendResponse(SessionId id, RequestId requestId, Message response) {
+    const TraceScope span(TracePoint::SocketSend, static_cast<uint32_t>(response.type));
+    FlightRecorder::getInstance().reply(id, requestId, static_cast<std::uint8_t>(response.type));
+    // Every response retires one request, sent or queued; the freed
+    // slot may re-enable READ below.
+    Session* s = retireRequest(id);
     if (!s) return;  // closed; drop silently
 
-    auto bytes = response.serialize();
-    ssize_t sent = 0;
-    do {
-        sent = ::send(s->fd.get(), bytes.data(), bytes.size(), MSG_NOSIGNAL);
-    } while (sent < 0 && errno == EINTR);
-
-    if (sent >= 0) {
-        s->pendingResponse.clear();
-        s->requestInFlight = false;
-        s->lastActivity    = std::chrono::steady_clock::now();
-        if (!m_loop.modify(s->fd.get(), READ_BIT)) {
-            LOG_WARNING("modify(READ) failed after send for session ", id);
-            closeSession(id);
-        }
+    const std::size_t len = serializeFrameTo(s->protocol, requestId, RequestOptions{}, response,
+                                             m_sendBuffer.data(), m_sendBuffer.size());
+    if (len == 0) {
+        LOG_ERROR("Response type=", static_cast<int>(response.type), " of ",
+                  response.data.size(), " bytes exceeds MAX_MESSAGE_SIZE; dropped");
+        (void)updateInterest(id, *s);
         return;
     }
-    if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        s->pendingResponse = std::move(bytes);
-        if (!m_loop.modify(s->fd.get(), WRITE_BIT)) {
-            LOG_WARNING("modify(WRITE) failed for session ", id);
-            closeSession(id);
+    // Queued behind anything still waiting, and sent with the rest of
+    // this pass's output. The flush re-derives the mask, picking up a
+    // READ the retired request re-opened; without one, do it now.
+    s->pendingResponses.push_back(InlineBytes(m_sendBuffer.data(), len));
+    if (!scheduleFlush(id, *s)) (void)updateInterest(id, *s);
+}
+
+SocketServer::Session* SocketServer::retireRequest(SessionId id) {
+    Session* s = findSession(id);
+    if (!s) return nullptr;
+    if (s->inFlight > 0) {
+        --s->inFlight;
+        if (s->peer->inFlight-- == kMaxInFlightPerPeer) {
+            updatePeerInterest(*s->peer);
+            s = findSession(id);
+            if (!s) return nullptr;
         }
-        return;
     }
-    LOG_DEBUG("send() failed for session ", id, ": ", std::strerror(errno));
-    closeSession(id);
+    refreshIdleDeadline(*s);
+    return s;
 }
 
-void SocketServer::onIdleSweep() {
-    m_idleTimer.consume();
+void SocketServer::retireSilently(SessionId id) {
+    if (Session* s = retireRequest(id)) (void)updateInterest(id, *s);
+}
 
-    const auto now = std::chrono::steady_clock::now();
-    std::vector<SessionId> expired;
-    for (const auto& [id, session] : m_sessions) {
-        // Skip sessions with work in flight — "idle" is about the peer,
-        // not about whatever the daemon is currently doing for them.
-        if (session->requestInFlight) continue;
-        if (now - session->lastActivity > kClientIdleTimeout) {
-            expired.push_back(id);
-        }
+bool SocketServer::takeRateToken(uid_t uid) {
+    const auto verdict = m_rateLimiter.take(uid);
+    // Once per episode, not once per refused request.
+    if (verdict == RateLimiter<uid_t>::Verdict::FirstRefused) {
+        LOG_WARNING("Requests from uid ", uid, " exceed ", m_rateLimiter.limit().perSecond,
+                    "/s; refusing them until the client slows down");
     }
-    for (const SessionId id : expired) {
-        LOG_DEBUG("Closing idle session ", id);
+    return verdict == RateLimiter<uid_t>::Verdict::Allowed;
+}
+
+bool SocketServer::updateInterest(SessionId id, Session& session) {
+    std::uint32_t mask = 0;
+    if (readable(session)) mask |= READ_BIT;
+    if (!session.flushQueued &&
+        (!session.pendingResponses.empty() || !session.pendingEvents.empty())) {
+        mask |= WRITE_BIT;
+    }
+    if (mask == session.interest) return true;
+    if (!m_loop.modify(session.fd.get(), mask)) {
+        LOG_WARNING("modify(mask=", mask, ") failed for session ", id);
         closeSession(id);
+        return false;
+    }
+    session.interest = mask;
+    return true;
+}
+
+bool SocketServer::readable(const Session& session) noexcept {
+    return session.inFlight < kMaxInFlightPerSession &&
+           session.peer->inFlight < kMaxInFlightPerPeer;
+}
+
+void SocketServer::updatePeerInterest(const Peer& peer) {
+    // Any update may close a session and, with its last one, the peer.
+    const std::vector<SessionId> ids = peer.sessions;
+    for (const SessionId id : ids) {
+        if (Session* s = findSession(id)) (void)updateInterest(id, *s);
     }
+}
 
-    if (!m_idleTimer.armOnce(
-            std::chrono::duration_cast<std::chrono::milliseconds>(kIdleSweepInterval))) {
-        LOG_WARNING("Failed to re-arm idle sweep timer");
+void SocketServer::onSessionIdle(SessionId id) {
+    LOG_DEBUG("Closing idle session ", id);
+    closeSession(id);
+}
+
+void SocketServer::refreshIdleDeadline(Session& session) {
+    // "Idle" is about the peer, not about whatever the daemon is
+    // currently doing for it, and a subscriber waits on the bus.
+    if (session.inFlight > 0 || session.subscribedMask != 0) {
+        session.idleTimer.disarm();
+        return;
+    }
+    if (!session.idleTimer.armOnce(
+            std::chrono::duration_cast<std::chrono::milliseconds>(kClientIdleTimeout))) {
+        LOG_WARNING("Failed to arm idle deadline for session ", session.id);
     }
 }
 
@@ -352,7 +802,41 @@ void SocketServer::closeSession(SessionId id) {
     auto it = m_sessions.find(id);
     if (it == m_sessions.end()) return;
     m_loop.remove(it->second->fd.get());
+    const bool subscribed = it->second->subscribedMask != 0;
+
+    // Requests still running for this session no longer count against
+    // its peer; their replies find the session gone and are dropped.
+    Peer& peer = *it->second->peer;
+    const bool wasCapped = peer.inFlight >= kMaxInFlightPerPeer;
+    peer.inFlight -= it->second->inFlight;
+    peer.sessions.erase(std::find(peer.sessions.begin(), peer.sessions.end(), id));
+
     m_sessions.erase(it);  // UnixSocket dtor closes the fd
+    Metrics::getInstance().set(Metrics::Gauge::ActiveSessions,
+                               static_cast<int64_t>(m_sessions.size()));
+    if (subscribed) updateSubscriptions();
+
+    if (peer.sessions.empty()) {
+        m_peers.erase(peer.pid);
+    } else if (wasCapped && peer.inFlight < kMaxInFlightPerPeer) {
+        updatePeerInterest(peer);
+    }
+    admitQueued();
+}
+
+void SocketServer::updateSubscriptions() {
+    int64_t subscribers = 0;
+    BusEventMask subscribed = 0;
+    for (const auto& [id, session] : m_sessions) {
+        if (session->subscribedMask == 0) continue;
+        ++subscribers;
+        subscribed |= session->subscribedMask;
+    }
+    Metrics::getInstance().set(Metrics::Gauge::EventSubscribers, subscribers);
+    if (subscribed != m_subscribedEvents) {
+        m_subscribedEvents = subscribed;
+        if (m_subscriptionHandler) m_subscriptionHandler(subscribed);
+    }
 }
 
 SocketServer::Session* SocketServer::findSession(SessionId id) noexcept {
@@ -360,9 +844,17 @@ SocketServer::Session* SocketServer::findSession(SessionId id) noexcept {
     return it == m_sessions.end() ? nullptr : it->second.get();
 }
 
-ResponseSink SocketServer::makeSink(SessionId id) {
-    return [this, id](Message response) {
-        sendResponse(id, std::move(response));
+ResponseSink SocketServer::makeSink(SessionId id, RequestId requestId, MessageType type,
+                                   bool noReply) {
+    return [this, id, requestId, type, noReply,
+            start = std::chrono::steady_clock::now()](Message response) {
+        Metrics::getInstance().recordDispatch(
+            type, std::chrono::steady_clock::now() - start);
+        if (noReply) {
+            retireSilently(id);
+        } else {
+            sendResponse(id, requestId, std::move(response));
+        }
     };
 }
 
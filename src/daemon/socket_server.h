@@ -4,15 +4,19 @@
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
+#include <sys/types.h>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../common/event_loop.h"
 #include "../common/messages.h"
-#include "../common/timer_source.h"
 #include "../common/unix_socket.h"
+#include "rate_limiter.h"
 
 namespace cec_control {
 
@@ -26,6 +30,63 @@ namespace cec_control {
  * response queued by a worker that completes after the peer has
  * disconnected is quietly dropped rather than misrouted to a reused fd.
  *
+ * Requests are pipelined: a session may have up to
+ * @c kMaxInFlightPerSession requests outstanding, and each response is
+ * framed with the @c RequestId of the request it answers, so a fast
+ * mute can overtake a slow power-on. At the cap the session stops
+ * being read until a reply goes out; the kernel socket buffer then
+ * applies back-pressure to the client.
+ *
+ * Sessions are also grouped by peer process (@c SO_PEERCRED pid): all
+ * of one process's sessions together may have @c kMaxInFlightPerPeer
+ * requests outstanding. A client that opens many connections is read
+ * no faster than that, so it cannot fill the adapter worker's queue
+ * ahead of everyone else. With a @c ClientRateLimit, each user's requests
+ * also draw on a token bucket, and one that arrives with the bucket
+ * empty is answered @c RESP_RATE_LIMITED before it reaches the
+ * command handler. Each ready session is read once per loop
+ * pass — up to @c kIoBatch datagrams in one @c recvmmsg, never more
+ * than its caps leave room for — so sessions are served in turn.
+ *
+ * Replies are not written as they are produced. A response or event
+ * joins its session's queue, and the queues touched during a loop pass
+ * are flushed once that pass's handlers have all run, each in
+ * @c sendmmsg batches of up to @c kIoBatch frames. A burst of worker
+ * completions drained from @c MainThreadWork in one pass thus leaves
+ * in one syscall per session rather than one per reply.
+ *
+ * Past the session limit, accepted clients wait in a queue of
+ * @c kAcceptQueueDepth and are admitted, oldest first, as sessions
+ * close. Only a client arriving with that queue full is dropped.
+ *
+ * A session speaks the legacy framing until it opens with
+ * @c CMD_HELLO, and from the reply on every frame either way uses the
+ * version agreed (see @c kProtocolVersion). Per-request flags and
+ * extensions reach the command handler as @c RequestOptions; a
+ * no-reply request counts against the in-flight caps until its sink
+ * fires like any other, and then sends nothing.
+ *
+ * A session that sends @c CMD_SUBSCRIBE also becomes an event stream:
+ * @c publishEvent pushes each matching @c BusEvent to it as a
+ * @c RESP_EVENT. The session keeps issuing ordinary requests, whose
+ * replies go out ahead of queued events. Events wait in a per-session
+ * queue of @c kMaxQueuedEventsPerSession; a subscriber that lets it
+ * fill loses further events, and is told how many with an
+ * @c BusEventKind::Overflow event once it has caught up. Nothing a
+ * subscriber does can stall the daemon or the other sessions.
+ *
+ * Under systemd socket activation the listener is the one the service
+ * manager passed in rather than a freshly bound socket; the socket
+ * file then belongs to the socket unit and is left in place on
+ * @c stop() so the next connection can start the daemon again.
+ *
+ * When the unit has an fd store (@c FileDescriptorStoreMax=) a freshly
+ * bound listener is also stored there, and on the way out @c handOver
+ * stores each idle session under a name recording its framing version
+ * and subscription. A restarted daemon gets both back: it serves the
+ * same listening socket, whose backlog held every connect made in the
+ * meantime, and carries on with the sessions as if nothing happened.
+ *
  * Shutdown is a straight map clear: every session fd is removed from the
  * loop and closed by its @c UnixSocket destructor. There is no
  * cross-thread wait; any worker that completes after @c stop() posts a
@@ -47,25 +108,64 @@ public:
      * Worker threads that produce a response must route the invocation
      * through @c MainThreadWork::post first — see
      * @c CECDaemon::handleCommand for the canonical pattern.
+     *
+     * @p options is what the request's frame asked for; always the
+     * defaults on a legacy session. A no-reply request still gets a
+     * sink, which retires the request without sending anything.
      */
-    using CommandHandler = std::function<void(Message request, ResponseSink reply)>;
+    using CommandHandler = std::function<void(Message request, ResponseSink reply,
+                                              const RequestOptions& options)>;
 
-    /** Upper bound on simultaneous client sessions. Excess accepts close. */
-    static constexpr std::size_t kMaxConnections = 10;
+    /**
+     * Invoked on the main thread with the union of every session's
+     * subscription whenever that union changes, so the publisher can
+     * stop producing kinds nobody listens to.
+     */
+    using SubscriptionHandler = std::function<void(BusEventMask subscribed)>;
 
-    /** Close a session after this long without activity on our side. */
-    static constexpr auto kClientIdleTimeout = std::chrono::seconds(60);
+    /**
+     * Simultaneous client sessions allowed when the caller does not say;
+     * excess accepts close. @c [Daemon] MaxConnections overrides it.
+     */
+    static constexpr std::size_t kDefaultMaxConnections = 10;
+
+    /** Clients held for a free session slot before new ones are dropped. */
+    static constexpr std::size_t kAcceptQueueDepth = 16;
+
+    /** Requests one session may have awaiting a reply at once. */
+    static constexpr std::size_t kMaxInFlightPerSession = 8;
+
+    /**
+     * Requests all sessions of one peer process may have awaiting a
+     * reply at once; half the default adapter worker queue.
+     */
+    static constexpr std::size_t kMaxInFlightPerPeer = 16;
 
-    /** How often the main thread sweeps the session map for idle peers. */
-    static constexpr auto kIdleSweepInterval = std::chrono::seconds(15);
+    /** Datagrams moved per @c recvmmsg or @c sendmmsg call. */
+    static constexpr std::size_t kIoBatch = 8;
+
+    /** Events one subscriber may have waiting to be sent. */
+    static constexpr std::size_t kMaxQueuedEventsPerSession = 64;
+
+    /**
+     * Close a session after this long without activity on our side.
+     * Each session carries its own deadline on the loop's timer wheel,
+     * armed only while it has nothing in flight; subscribed sessions
+     * are exempt, since a quiet bus is not an idle peer.
+     */
+    static constexpr auto kClientIdleTimeout = std::chrono::seconds(60);
 
     /**
-     * @param loop        Non-owning reference; must outlive *this. Used
-     *                    for the listener, the idle-sweep timer, and
-     *                    per-session fd registration.
-     * @param socketPath  Filesystem path of the listening socket.
+     * @param loop            Non-owning reference; must outlive *this.
+     *                        Used for the listener, per-session fd
+     *                        registration, and the idle deadlines.
+     * @param socketPath      Filesystem path of the listening socket.
+     * @param maxConnections  Simultaneous sessions to accept; at least 1.
+     * @param rateLimit       Per-user request allowance; off by default.
      */
-    SocketServer(EventLoop& loop, std::string socketPath);
+    SocketServer(EventLoop& loop, std::string socketPath,
+                 std::size_t maxConnections = kDefaultMaxConnections,
+                 ClientRateLimit rateLimit = {});
     ~SocketServer();
 
     SocketServer(const SocketServer&) = delete;
@@ -74,7 +174,7 @@ public:
     SocketServer& operator=(SocketServer&&) = delete;
 
     /**
-     * Open the listener, arm the idle sweep, and register both with the
+     * Take the activated listener or open one and register it with the
      * event loop. Returns false on any step; a partial setup is rolled
      * back before the call returns.
      */
@@ -83,49 +183,197 @@ public:
     /** Close the listener and every session. Idempotent. */
     void stop();
 
+    /**
+     * Before @c stop() on the way out: give the service manager's fd
+     * store (see @c SystemdNotify::fdStoreCapacity) a copy of every
+     * session with nothing outstanding, and of every client still
+     * waiting for a slot, so the next daemon carries on with them. A
+     * session with a request in flight or a reply unsent is not handed
+     * over and closes as before. No-op without an fd store.
+     */
+    void handOver();
+
     /** Install/replace the per-request handler. Install before @c start(). */
     void setCommandHandler(CommandHandler handler);
 
+    /** Install/replace the subscription-change handler. Install before @c start(). */
+    void setSubscriptionHandler(SubscriptionHandler handler);
+
     /**
-     * Send a response to an open session. No-op if the session has
-     * closed. Must be called on the main thread.
+     * Send the response to request @p requestId on an open session.
+     * No-op if the session has closed. Must be called on the main
+     * thread, once per request.
      */
-    void sendResponse(SessionId id, Message response);
+    void sendResponse(SessionId id, RequestId requestId, Message response);
+
+    /**
+     * Queue @p event to every session subscribed to its kind. Main
+     * thread only.
+     */
+    void publishEvent(const BusEvent& event);
 
 private:
     struct Session;
 
+    /** Sessions sharing one peer process, and their combined load. */
+    struct Peer {
+        pid_t                  pid      = 0;
+        uid_t                  uid      = 0;
+        std::size_t            inFlight = 0;
+        std::vector<SessionId> sessions;
+    };
+
     void onAcceptReady();
+
+    /** Register @p client as a new session; null if it was dropped. */
+    Session* admitSession(UnixSocket client);
+
+    /**
+     * Register the sessions a previous daemon handed over, each with
+     * the framing and subscription its store name records, then take
+     * them out of the fd store. They are admitted whatever the session
+     * limit; only later clients wait for a slot.
+     */
+    void adoptSessions(std::vector<std::pair<UnixSocket, std::string>> handedOver);
+
+    /** Move queued clients into free session slots. */
+    void admitQueued();
     void onSessionEvent(SessionId id, std::uint32_t events);
-    void onIdleSweep();
 
-    /** Read one datagram from @p session, parse, and invoke the handler. */
-    void processRequest(SessionId id, Session& session);
+    /** @p id's idle deadline passed: close it. */
+    void onSessionIdle(SessionId id);
+
+    /**
+     * Restart @p session's idle deadline from now if it is eligible to
+     * idle out (nothing in flight, not subscribed), else cancel it.
+     */
+    static void refreshIdleDeadline(Session& session);
+
+    /**
+     * Read what @p session has waiting, up to @c kIoBatch datagrams and
+     * its remaining in-flight room, and handle each in arrival order.
+     */
+    void processRequests(SessionId id, Session& session);
+
+    /** Parse one received frame and invoke the handler. */
+    void processRequest(SessionId id, Session& session,
+                        const std::uint8_t* frame, std::size_t len);
+
+    /** Apply a @c CMD_SUBSCRIBE on @p session and answer it, unless @p noReply. */
+    void subscribe(SessionId id, Session& session, RequestId requestId,
+                   const Message& request, bool noReply);
+
+    /**
+     * Answer a @c CMD_HELLO, in the framing it arrived in, and move
+     * session @p id to the version agreed. Only the first frame of a
+     * session may be a hello; a later one is refused.
+     */
+    void greet(SessionId id, RequestId requestId, const Message& request);
 
-    /** Retry a queued send for a session armed on WRITE. */
+    /** Append @p event to @p session's event queue, framed for its subscription. */
+    void queueEvent(Session& session, const BusEvent& event);
+
+    /**
+     * Have @p session's queues flushed at the end of this loop pass.
+     * Returns false, doing nothing, if the session is waiting on WRITE
+     * instead; its queues then go out when the socket drains.
+     */
+    bool scheduleFlush(SessionId id, Session& session);
+
+    /** Deferred from the loop: flush every session queued this pass. */
+    void flushSends();
+
+    /**
+     * Send @p id's queued frames until they run out or the socket
+     * fills. Returns false if the session was closed.
+     */
     [[nodiscard]] bool drainPendingSend(SessionId id);
 
+    /**
+     * Re-derive @p session's epoll mask from its state (see the
+     * @c Session invariants). Closes the session and returns false if
+     * the loop rejects the update.
+     */
+    [[nodiscard]] bool updateInterest(SessionId id, Session& session);
+
+    /** Whether @p session may have another request read. */
+    [[nodiscard]] static bool readable(const Session& session) noexcept;
+
+    /**
+     * Re-derive the epoll mask of every session of @p peer, after its
+     * combined in-flight count crossed @c kMaxInFlightPerPeer.
+     */
+    void updatePeerInterest(const Peer& peer);
+
     /** Remove a session from the loop and erase it. Idempotent. */
     void closeSession(SessionId id);
 
+    /**
+     * Republish the subscriber-count gauge, and tell the subscription
+     * handler if the union of the subscriptions has changed.
+     */
+    void updateSubscriptions();
+
     /** Lookup helper. Returns null if the session has closed. */
     [[nodiscard]] Session* findSession(SessionId id) noexcept;
 
-    /** Response sink closure for a given session. */
-    [[nodiscard]] ResponseSink makeSink(SessionId id);
+    /**
+     * Response sink closure for one request of @p type on a given
+     * session. Records the request's dispatch latency when invoked, so
+     * the figure covers inline and worker-hopped replies alike.
+     */
+    [[nodiscard]] ResponseSink makeSink(SessionId id, RequestId requestId, MessageType type,
+                                        bool noReply);
+
+    /**
+     * Retire one of @p id's in-flight requests: free its slot, re-opening
+     * READ on the session or its peer where that lifts a cap, and restart
+     * the idle deadline. Returns the session, or null if it has closed.
+     */
+    Session* retireRequest(SessionId id);
+
+    /** Retire a no-reply request whose response is discarded. */
+    void retireSilently(SessionId id);
+
+    /** Spend one of @p uid's tokens; false if it has none left. */
+    [[nodiscard]] bool takeRateToken(uid_t uid);
 
     EventLoop&     m_loop;
     std::string    m_socketPath;
     UnixSocket     m_listener;
-    TimerSource    m_idleTimer;
+    bool           m_activated = false;  ///< Listener came from a socket unit.
+    bool           m_listenerStored = false;  ///< A copy is kept in the fd store.
+    std::size_t    m_maxConnections;
+    std::deque<UnixSocket> m_acceptQueue;  ///< Accepted, waiting for a slot.
     CommandHandler m_handler;
+    SubscriptionHandler m_subscriptionHandler;
+    BusEventMask   m_subscribedEvents = 0;  ///< Union over every session.
 
     std::unordered_map<SessionId, std::unique_ptr<Session>> m_sessions;
     SessionId m_nextId = 1;
 
-    // Shared across all session reads; safe because reads are serialised
-    // on the main thread. Avoids one allocation per dispatch.
-    std::array<std::uint8_t, MAX_MESSAGE_SIZE> m_readBuffer{};
+    // Keyed on peer pid. Node-based, so the Peer each Session points
+    // at stays put while other peers come and go.
+    std::unordered_map<pid_t, Peer> m_peers;
+
+    // Keyed on uid, so every process and session of one user shares
+    // a bucket.
+    RateLimiter<uid_t> m_rateLimiter;
+
+    // Shared across all session reads, one slot per datagram of a
+    // recvmmsg batch; safe because reads are serialised on the main
+    // thread. Avoids one allocation per dispatch.
+    std::array<std::array<std::uint8_t, MAX_FRAME_SIZE>, kIoBatch> m_readBuffers{};
+
+    // Outgoing frames are serialised here, the same way, then copied
+    // into their session's queue — inline unless it is a large reply.
+    std::array<std::uint8_t, MAX_FRAME_SIZE> m_sendBuffer{};
+
+    // Sessions with frames to flush at the end of this loop pass, and
+    // the batch being flushed; swapped to keep both allocations.
+    std::vector<SessionId> m_flushQueue;
+    std::vector<SessionId> m_flushing;
+    bool                   m_flushScheduled = false;  ///< flushSends() is deferred.
 };
 
 } // namespace cec_control
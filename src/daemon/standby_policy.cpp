@@ -51,6 +51,10 @@ void StandbyPolicy::arm() {
               "be processed");
 }
 
+void StandbyPolicy::setEnabled(bool enabled) noexcept {
+    m_enabled = enabled;
+}
+
 bool StandbyPolicy::isEnabled() const noexcept {
     return m_enabled;
 }
@@ -14,7 +14,7 @@ namespace cec_control {
  *
  * Extracted from @c CommandDispatcher. The dispatcher routes the
  * @c CMD_AUTO_STANDBY wire command to @c apply, and the daemon's
- * adapter-observation forwarder routes @c TvStandby observations to
+ * observation bus delivers @c TvStandby observations to
  * @c observe — keeping everything auto-standby owns in one place.
  *
  * ## Threading
@@ -35,10 +35,10 @@ namespace cec_control {
  *
  * @c observe short-circuits until @c arm() has been called. The
  * daemon posts @c arm() onto @c MainThreadWork at the end of
- * @c start(); any @c TvStandby observation libcec emitted between
- * @c Open() returning and the loop's first drain therefore runs
- * *before* the arming post in FIFO order, sees @c !m_armed, and is
- * absorbed. Without this gate a @c STANDBY opcode that happened to
+ * @c start(), and that post flushes the observation bus before arming;
+ * any @c TvStandby observation libcec emitted between @c Open()
+ * returning and that post therefore runs first, sees @c !m_armed, and
+ * is absorbed. Without this gate a @c STANDBY opcode that happened to
  * arrive during the narrow pre-drain window would trigger a system
  * suspend the moment the loop started — the blast radius of
  * "your machine suspended immediately after boot". The policy is
@@ -99,11 +99,18 @@ public:
      * configured suspend callback subject to the usual enabled check.
      * Idempotent — subsequent calls are no-ops. Main thread only; the
      * daemon posts this onto @c MainThreadWork at the end of
-     * @c start() so that any observations already queued at that
-     * point drain (and are absorbed) ahead of it in FIFO order.
+     * @c start(), behind a flush of the observation bus, so that any
+     * observations already queued at that point are absorbed first.
      */
     void arm();
 
+    /**
+     * Set the flag directly, as a config reload does when
+     * @c PowerOffOnStandby changed in the file. Overrides whatever
+     * @c CMD_AUTO_STANDBY last chose. Main thread only.
+     */
+    void setEnabled(bool enabled) noexcept;
+
     /** Flag snapshot. Main thread only. */
     [[nodiscard]] bool isEnabled() const noexcept;
 
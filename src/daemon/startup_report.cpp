@@ -0,0 +1,135 @@
+#include "startup_report.h"
+
+#include "../common/logger.h"
+#include "../common/systemd_notify.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace cec_control {
+
+namespace {
+
+struct PhaseInfo {
+    std::string_view name;
+    /** What @c STATUS= says while the phase runs. */
+    std::string_view status;
+};
+
+constexpr std::array<PhaseInfo, kStartupPhaseCount> kPhases{{
+    {"logging",        "Starting: setting up logging"},
+    {"config_load",    "Starting: loading configuration"},
+    {"libcec_init",    "Starting: loading libcec"},
+    {"detect_adapter", "Starting: detecting CEC adapters"},
+    {"adapter_open",   "Starting: opening the CEC adapter"},
+    {"device_scan",    "Starting: scanning CEC devices"},
+    {"socket_listen",  "Starting: opening the control socket"},
+    {"dbus_connect",   "Starting: connecting to D-Bus"},
+    {"inhibitor_lock", "Starting: taking the logind sleep inhibitor"},
+}};
+
+constexpr std::size_t index(StartupPhase phase) noexcept {
+    return static_cast<std::size_t>(phase);
+}
+
+/** @p us as milliseconds to one decimal place: 1234 us -> "1.2". */
+std::string millis(int64_t us) {
+    std::ostringstream out;
+    out << us / 1000 << '.' << (us % 1000) / 100;
+    return out.str();
+}
+
+} // namespace
+
+StartupReport& StartupReport::getInstance() noexcept {
+    static StartupReport instance;
+    return instance;
+}
+
+std::string_view StartupReport::name(StartupPhase phase) noexcept {
+    return kPhases[index(phase)].name;
+}
+
+void StartupReport::begin() noexcept {
+    int64_t unset = 0;
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+    m_beginNs.compare_exchange_strong(unset, now, std::memory_order_acq_rel);
+}
+
+int64_t StartupReport::sinceBegin() const noexcept {
+    const int64_t begun = m_beginNs.load(std::memory_order_acquire);
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+    return begun == 0 ? 1 : std::max<int64_t>((now - begun) / 1000, 1);
+}
+
+void StartupReport::start(StartupPhase phase) noexcept {
+    if (m_beginNs.load(std::memory_order_acquire) == 0) return;
+    int64_t unset = 0;
+    if (!m_phases[index(phase)].startUs.compare_exchange_strong(unset, sinceBegin(),
+                                                               std::memory_order_acq_rel)) {
+        return;
+    }
+    if (m_readyUs.load(std::memory_order_acquire) == 0) {
+        SystemdNotify::status(kPhases[index(phase)].status);
+    }
+}
+
+void StartupReport::finish(StartupPhase phase) noexcept {
+    Span& span = m_phases[index(phase)];
+    const int64_t started = span.startUs.load(std::memory_order_acquire);
+    if (started == 0) return;
+    int64_t unset = 0;
+    const int64_t now = sinceBegin();
+    if (!span.endUs.compare_exchange_strong(unset, now, std::memory_order_acq_rel)) return;
+    // Phases that end before readiness are in its summary line.
+    if (m_readyUs.load(std::memory_order_acquire) != 0) {
+        LOG_INFO("Startup: ", name(phase), " took ", millis(now - started), " ms, done ",
+                 millis(now), " ms after start");
+    }
+}
+
+void StartupReport::markReady() noexcept {
+    int64_t unset = 0;
+    if (!m_readyUs.compare_exchange_strong(unset, sinceBegin(), std::memory_order_acq_rel)) {
+        return;
+    }
+    LOG_INFO("Startup: ", summary());
+    SystemdNotify::status("Running");
+}
+
+std::string StartupReport::summary() const {
+    std::ostringstream out;
+    out << "ready after " << millis(m_readyUs.load(std::memory_order_acquire)) << " ms";
+    for (std::size_t i = 0; i < kStartupPhaseCount; ++i) {
+        const int64_t started = m_phases[i].startUs.load(std::memory_order_acquire);
+        if (started == 0) continue;
+        const int64_t ended = m_phases[i].endUs.load(std::memory_order_acquire);
+        out << ", " << kPhases[i].name << ' ';
+        if (ended == 0) {
+            out << "still running";
+        } else {
+            out << millis(ended - started) << " ms";
+        }
+    }
+    return out.str();
+}
+
+std::string StartupReport::render() const {
+    std::ostringstream out;
+    if (const int64_t ready = m_readyUs.load(std::memory_order_acquire); ready != 0) {
+        out << "startup_ready_ms " << millis(ready) << '\n';
+    }
+    for (std::size_t i = 0; i < kStartupPhaseCount; ++i) {
+        const int64_t started = m_phases[i].startUs.load(std::memory_order_acquire);
+        if (started == 0) continue;
+        const int64_t ended = m_phases[i].endUs.load(std::memory_order_acquire);
+        out << "startup_phase{" << kPhases[i].name << "} start_ms=" << millis(started);
+        if (ended != 0) out << " duration_ms=" << millis(ended - started);
+        out << '\n';
+    }
+    return out.str();
+}
+
+} // namespace cec_control
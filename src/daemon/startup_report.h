@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace cec_control {
+
+/** The steps of a daemon start that @c StartupReport times. */
+enum class StartupPhase : uint8_t {
+    Logging,
+    ConfigLoad,
+    LibcecInit,
+    DetectAdapter,
+    AdapterOpen,
+    DeviceScan,
+    SocketListen,
+    DbusConnect,
+    InhibitorLock,
+};
+
+inline constexpr std::size_t kStartupPhaseCount =
+    static_cast<std::size_t>(StartupPhase::InhibitorLock) + 1;
+
+/**
+ * Where the daemon's startup time goes, for deciding which of the
+ * deferred-startup options (@c DeferAdapterOpen, @c ScanDevicesAtStartup,
+ * the known-port cache) a host needs.
+ *
+ * Each @c StartupPhase is timed once on the monotonic clock, relative to
+ * @c begin: the first run of a phase is the startup one, and a later
+ * reopen or rescan leaves it alone. Phases may end off the main thread
+ * (a deferred open on the adapter worker) and after readiness (the
+ * device scan, logind's inhibitor reply), so each is a pair of atomics
+ * and a late finish is logged on its own line.
+ *
+ * Until @c markReady, starting a phase also names it in the unit's
+ * @c STATUS=, so a slow start shows what it is waiting on in
+ * @c systemctl @c status. @c markReady logs the whole report; @c render
+ * appends it to @c cec-control @c stats.
+ */
+class StartupReport {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static StartupReport& getInstance() noexcept;
+
+    StartupReport(const StartupReport&)            = delete;
+    StartupReport& operator=(const StartupReport&) = delete;
+
+    /** Start the clock every phase is measured from. Idempotent. */
+    void begin() noexcept;
+
+    /** @p phase started now, unless it already has. Any thread. */
+    void start(StartupPhase phase) noexcept;
+
+    /** @p phase finished now, if it started and has not finished. Any thread. */
+    void finish(StartupPhase phase) noexcept;
+
+    /**
+     * The daemon reported readiness: log the report and hand @c STATUS=
+     * back to the running daemon.
+     */
+    void markReady() noexcept;
+
+    /**
+     * @c startup_ready_ms and one @c startup_phase line per phase that
+     * ran, with its start offset and duration in milliseconds; a phase
+     * still running has no duration yet.
+     */
+    [[nodiscard]] std::string render() const;
+
+    /** Report name of @p phase, as rendered. */
+    [[nodiscard]] static std::string_view name(StartupPhase phase) noexcept;
+
+private:
+    StartupReport() = default;
+
+    /** Microseconds since @c begin, never 0 so 0 can mean "not yet". */
+    [[nodiscard]] int64_t sinceBegin() const noexcept;
+
+    /** One line summarising every phase so far. */
+    [[nodiscard]] std::string summary() const;
+
+    struct Span {
+        std::atomic<int64_t> startUs{0};
+        std::atomic<int64_t> endUs{0};
+    };
+
+    std::atomic<int64_t> m_beginNs{0};
+    std::atomic<int64_t> m_readyUs{0};
+    std::array<Span, kStartupPhaseCount> m_phases{};
+};
+
+/** Times @p phase of the startup for the lifetime of the scope. */
+class ScopedStartupPhase {
+public:
+    explicit ScopedStartupPhase(StartupPhase phase) noexcept : m_phase(phase) {
+        StartupReport::getInstance().start(phase);
+    }
+    ~ScopedStartupPhase() { StartupReport::getInstance().finish(m_phase); }
+
+    ScopedStartupPhase(const ScopedStartupPhase&)            = delete;
+    ScopedStartupPhase& operator=(const ScopedStartupPhase&) = delete;
+
+private:
+    StartupPhase m_phase;
+};
+
+} // namespace cec_control
@@ -0,0 +1,107 @@
+#include "status_page_writer.h"
+
+#include "../common/logger.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace cec_control {
+
+StatusPageWriter::StatusPageWriter(std::string path) : m_path(std::move(path)) {}
+
+StatusPageWriter::~StatusPageWriter() {
+    stop();
+}
+
+bool StatusPageWriter::start() {
+    if (m_page != nullptr) return true;
+
+    const std::string temp = m_path + ".tmp";
+    const int fd = ::open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_WARNING("Cannot create status page ", temp, ": ", std::strerror(errno));
+        return false;
+    }
+    // The umask may have masked the read bits off; every local user
+    // is meant to be able to map the page.
+    void* mapped = MAP_FAILED;
+    if (::fchmod(fd, 0644) == 0 &&
+        ::ftruncate(fd, static_cast<off_t>(sizeof(status_page::Layout))) == 0) {
+        mapped = ::mmap(nullptr, sizeof(status_page::Layout), PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+    }
+    const int err = errno;
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_WARNING("Cannot map status page ", temp, ": ", std::strerror(err));
+        ::unlink(temp.c_str());
+        return false;
+    }
+
+    auto* page    = new (mapped) status_page::Layout{};
+    page->magic   = status_page::kMagic;
+    page->version = status_page::kVersion;
+    page->pid     = static_cast<uint32_t>(::getpid());
+    m_published   = status_page::StatusSnapshot{};
+    m_published.daemonRunning = true;
+    page->adapter.store(status_page::packAdapter(m_published), std::memory_order_relaxed);
+    for (auto& word : page->devices) word.store(0, std::memory_order_relaxed);
+    page->sequence.store(0, std::memory_order_release);
+
+    if (::rename(temp.c_str(), m_path.c_str()) != 0) {
+        LOG_WARNING("Cannot publish status page ", m_path, ": ", std::strerror(errno));
+        ::munmap(mapped, sizeof(status_page::Layout));
+        ::unlink(temp.c_str());
+        return false;
+    }
+    m_page = page;
+    LOG_INFO("Publishing bus status at ", m_path);
+    return true;
+}
+
+void StatusPageWriter::publish(const status_page::StatusSnapshot& snapshot) noexcept {
+    if (m_page == nullptr) return;
+
+    const uint32_t adapter = status_page::packAdapter(snapshot);
+    const bool adapterChanged = adapter != status_page::packAdapter(m_published);
+    if (!adapterChanged && snapshot.devices == m_published.devices) return;
+
+    const uint32_t seq = m_page->sequence.load(std::memory_order_relaxed);
+    m_page->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (adapterChanged) m_page->adapter.store(adapter, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < status_page::kDeviceCount; ++i) {
+        if (snapshot.devices[i] != m_published.devices[i]) {
+            m_page->devices[i].store(status_page::packDevice(snapshot.devices[i]),
+                                     std::memory_order_relaxed);
+        }
+    }
+    m_page->sequence.store(seq + 2, std::memory_order_release);
+    status_page::futexWakeAll(m_page->sequence);
+
+    m_published = snapshot;
+}
+
+void StatusPageWriter::stop() {
+    if (m_page == nullptr) return;
+
+    auto stopped = m_published;
+    stopped.daemonRunning = false;
+    publish(stopped);
+
+    ::munmap(m_page, sizeof(status_page::Layout));
+    m_page = nullptr;
+    if (::unlink(m_path.c_str()) != 0 && errno != ENOENT) {
+        LOG_WARNING("Cannot remove status page ", m_path, ": ", std::strerror(errno));
+    }
+}
+
+} // namespace cec_control
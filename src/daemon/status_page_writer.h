@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+
+#include "../common/status_page.h"
+
+namespace cec_control {
+
+/**
+ * Daemon side of the status page (see @c status_page): creates the
+ * file, keeps it mapped read-write, and rewrites it under the sequence
+ * lock whenever @c publish is handed a snapshot that differs from the
+ * last one. Publishing an unchanged snapshot costs a comparison and no
+ * store, so the daemon can offer one after every batch of work. A
+ * change costs one futex wake, whether no reader is waiting or many.
+ *
+ * The page is built under a temporary name and renamed into place, so
+ * a reader never maps a half-initialised file. Main thread only.
+ */
+class StatusPageWriter {
+public:
+    /** @param path Where to publish; see @c SystemPaths::getStatusPagePath. */
+    explicit StatusPageWriter(std::string path);
+    ~StatusPageWriter();
+
+    StatusPageWriter(const StatusPageWriter&)            = delete;
+    StatusPageWriter& operator=(const StatusPageWriter&) = delete;
+
+    /**
+     * Create and map the page, world-readable, with nothing known yet.
+     * @return @c false, with the reason logged and nothing left
+     *         behind, if any step fails.
+     */
+    [[nodiscard]] bool start();
+
+    /** Write @p snapshot if it differs from what the page holds. No-op before @c start. */
+    void publish(const status_page::StatusSnapshot& snapshot) noexcept;
+
+    /**
+     * Mark the daemon stopped, so mapped readers see it, then unmap
+     * and remove the file. Idempotent.
+     */
+    void stop();
+
+private:
+    std::string                    m_path;
+    status_page::Layout*           m_page = nullptr;
+    status_page::StatusSnapshot    m_published;
+};
+
+} // namespace cec_control
@@ -0,0 +1,133 @@
+#include "thread_schedule.h"
+
+#include "../common/logger.h"
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+namespace cec_control {
+
+namespace {
+
+/** Kernel id of the calling thread, which setpriority treats as its own process. */
+id_t currentTid() {
+    return static_cast<id_t>(::syscall(SYS_gettid));
+}
+
+int policyValue(ThreadSchedule::Policy policy) noexcept {
+    switch (policy) {
+        case ThreadSchedule::Policy::Fifo:       return SCHED_FIFO;
+        case ThreadSchedule::Policy::RoundRobin: return SCHED_RR;
+        case ThreadSchedule::Policy::Normal:
+        case ThreadSchedule::Policy::Inherit:    break;
+    }
+    return SCHED_OTHER;
+}
+
+/** Swap the default thread stack size for @p bytes; the old size in @p previous. */
+int exchangeDefaultStack(std::size_t bytes, std::size_t* previous) {
+    pthread_attr_t attr;
+    int err = ::pthread_getattr_default_np(&attr);
+    if (err != 0) return err;
+    if (previous != nullptr) err = ::pthread_attr_getstacksize(&attr, previous);
+    if (err == 0) err = ::pthread_attr_setstacksize(&attr, bytes);
+    if (err == 0) err = ::pthread_setattr_default_np(&attr);
+    ::pthread_attr_destroy(&attr);
+    return err;
+}
+
+} // namespace
+
+bool applyThreadSchedule(const ThreadSchedule& schedule, std::string_view who,
+                         bool resetOnFork) {
+    bool ok = true;
+
+    if (!schedule.cpus.empty()) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (const int cpu : schedule.cpus) CPU_SET(static_cast<std::size_t>(cpu), &cpus);
+        if (::sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            LOG_WARNING("Cannot pin the ", who, " thread to its CPUs: ", std::strerror(errno));
+            ok = false;
+        }
+    }
+
+    // Nice is per thread on Linux, so the tid, not the process, is
+    // the target.
+    if (schedule.nice != 0 &&
+        ::setpriority(PRIO_PROCESS, currentTid(), schedule.nice) != 0) {
+        LOG_WARNING("Cannot set nice ", schedule.nice, " on the ", who, " thread: ",
+                    std::strerror(errno));
+        ok = false;
+    }
+
+    if (schedule.policy != ThreadSchedule::Policy::Inherit || resetOnFork) {
+        int policy = schedule.policy == ThreadSchedule::Policy::Inherit
+                         ? ::sched_getscheduler(0)
+                         : policyValue(schedule.policy);
+        sched_param param{};
+        if (schedule.policy == ThreadSchedule::Policy::Inherit) {
+            ::sched_getparam(0, &param);
+        } else if (policy == SCHED_FIFO || policy == SCHED_RR) {
+            param.sched_priority = schedule.priority;
+        }
+        if (policy >= 0 && resetOnFork) policy |= SCHED_RESET_ON_FORK;
+        if (policy < 0 || ::sched_setscheduler(0, policy, &param) != 0) {
+            LOG_WARNING("Cannot set the scheduling policy of the ", who, " thread: ",
+                        std::strerror(errno));
+            ok = false;
+        }
+    }
+
+    if (!schedule.isDefault()) {
+        LOG_INFO("Applied the [Scheduling] settings to the ", who, " thread");
+    }
+    return ok;
+}
+
+ScopedThreadSchedule::ScopedThreadSchedule(const ThreadSchedule& schedule,
+                                           std::string_view who) {
+    if (schedule.isDefault()) return;
+    CPU_ZERO(&m_cpus);
+    errno = 0;
+    m_nice = ::getpriority(PRIO_PROCESS, currentTid());
+    if (::sched_getaffinity(0, sizeof(m_cpus), &m_cpus) != 0 || errno != 0) return;
+    m_policy = ::sched_getscheduler(0);
+    if (m_policy < 0 || ::sched_getparam(0, &m_param) != 0) return;
+    m_active = true;
+    applyThreadSchedule(schedule, who);
+}
+
+ScopedThreadSchedule::~ScopedThreadSchedule() {
+    if (!m_active) return;
+    // Best effort: dropping back to a lower priority is always allowed,
+    // and a positive nice the schedule set may need CAP_SYS_NICE to
+    // undo. The main thread is not latency critical either way.
+    (void)::sched_setscheduler(0, m_policy, &m_param);
+    (void)::setpriority(PRIO_PROCESS, currentTid(), m_nice);
+    (void)::sched_setaffinity(0, sizeof(m_cpus), &m_cpus);
+}
+
+ScopedThreadStack::ScopedThreadStack(std::size_t stackKiB, std::string_view who) {
+    if (stackKiB == 0) return;
+    const std::size_t bytes = std::max<std::size_t>(stackKiB * 1024, PTHREAD_STACK_MIN);
+    if (const int err = exchangeDefaultStack(bytes, &m_previous); err != 0) {
+        LOG_WARNING("Cannot give the ", who, " thread a ", stackKiB, " KiB stack: ",
+                    std::strerror(err));
+        return;
+    }
+    m_active = true;
+}
+
+ScopedThreadStack::~ScopedThreadStack() {
+    if (m_active) (void)exchangeDefaultStack(m_previous, nullptr);
+}
+
+} // namespace cec_control
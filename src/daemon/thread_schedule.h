@@ -0,0 +1,121 @@
+#pragma once
+
+#include <sched.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cec_control {
+
+/**
+ * CPU affinity, nice value and scheduling policy for one of the
+ * daemon's own threads, from @c [Scheduling]. Every field defaults to
+ * "leave as inherited", so an empty @c [Scheduling] section changes
+ * nothing.
+ *
+ * On a host whose cores are saturated (a media server transcoding),
+ * a thread waiting to run for a few hundred milliseconds delays the
+ * CEC frame it was about to send by as much; pinning the adapter
+ * thread to a quiet core, or giving it a realtime priority, takes it
+ * out of that queue.
+ */
+struct ThreadSchedule {
+    enum class Policy {
+        Inherit,     ///< Keep whatever the creating thread had.
+        Normal,      ///< @c SCHED_OTHER.
+        Fifo,        ///< @c SCHED_FIFO at @c priority.
+        RoundRobin,  ///< @c SCHED_RR at @c priority.
+    };
+
+    /** CPUs the thread may run on; empty leaves the affinity alone. */
+    std::vector<int> cpus;
+    /** Nice value, -20 to 19; 0 leaves it alone. */
+    int              nice     = 0;
+    Policy           policy   = Policy::Inherit;
+    /** Realtime priority, 1-99; used with @c Fifo and @c RoundRobin only. */
+    int              priority = 0;
+    /**
+     * Stack the thread is created with, in KiB; 0 keeps the process
+     * default. Fixed at creation, so not part of @c isDefault, which
+     * asks whether there is anything to apply to a running thread.
+     */
+    uint32_t         stackKiB = 0;
+
+    [[nodiscard]] bool isDefault() const noexcept {
+        return cpus.empty() && nice == 0 && policy == Policy::Inherit;
+    }
+
+    [[nodiscard]] bool operator==(const ThreadSchedule& other) const noexcept {
+        return cpus == other.cpus && nice == other.nice && policy == other.policy &&
+               priority == other.priority && stackKiB == other.stackKiB;
+    }
+    [[nodiscard]] bool operator!=(const ThreadSchedule& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+/**
+ * Apply @p schedule to the calling thread, logging (under @p who) each
+ * part the kernel refuses — a realtime policy needs @c CAP_SYS_NICE or
+ * an @c RLIMIT_RTPRIO allowance — and carrying on with the rest.
+ *
+ * With @p resetOnFork the policy is set with @c SCHED_RESET_ON_FORK,
+ * so processes the thread spawns start at @c SCHED_OTHER whatever the
+ * thread itself runs at, and at nice 0 if its nice is negative. A
+ * positive nice is the kernel's to keep: the children inherit it. Threads the caller creates
+ * afterwards inherit the schedule unless it is set.
+ *
+ * @return @c true if every requested part was applied.
+ */
+bool applyThreadSchedule(const ThreadSchedule& schedule, std::string_view who,
+                         bool resetOnFork = false);
+
+/**
+ * Apply a schedule to the calling thread for one scope and put back
+ * what it had before on exit. For running a call that creates threads
+ * — libcec's Open — under the schedule those threads should inherit.
+ */
+class ScopedThreadSchedule {
+public:
+    ScopedThreadSchedule(const ThreadSchedule& schedule, std::string_view who);
+    ~ScopedThreadSchedule();
+
+    ScopedThreadSchedule(const ScopedThreadSchedule&)            = delete;
+    ScopedThreadSchedule& operator=(const ScopedThreadSchedule&) = delete;
+
+private:
+    bool        m_active = false;
+    cpu_set_t   m_cpus{};
+    int         m_nice     = 0;
+    int         m_policy   = SCHED_OTHER;
+    sched_param m_param{};
+};
+
+/**
+ * Create the threads of one scope with a stack of @p stackKiB KiB, then
+ * put the previous size back. Wrap the @c std::thread construction of
+ * a thread whose @c ThreadSchedule::stackKiB is set; 0 changes nothing.
+ *
+ * @c std::thread takes no attributes, so this sets the process-wide
+ * default that every new thread starts from (glibc takes it from
+ * @c RLIMIT_STACK, commonly 8 MiB). A thread another thread creates
+ * meanwhile gets the size as well; keep the scope to the one
+ * @c std::thread constructor, on the main thread. Sizes below
+ * @c PTHREAD_STACK_MIN are raised to it.
+ */
+class ScopedThreadStack {
+public:
+    ScopedThreadStack(std::size_t stackKiB, std::string_view who);
+    ~ScopedThreadStack();
+
+    ScopedThreadStack(const ScopedThreadStack&)            = delete;
+    ScopedThreadStack& operator=(const ScopedThreadStack&) = delete;
+
+private:
+    bool        m_active   = false;
+    std::size_t m_previous = 0;  ///< Bytes.
+};
+
+} // namespace cec_control
@@ -0,0 +1,199 @@
+#include "udev_monitor.h"
+
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "../common/event_poller.h"
+#include "../common/logger.h"
+
+namespace cec_control {
+
+namespace {
+
+/** Multicast group systemd-udevd re-broadcasts processed events on. */
+constexpr std::uint32_t kUdevMonitorGroup = 2;
+
+/** @c "libudev" prefix and magic that open every udevd message. */
+constexpr std::string_view kUdevPrefix = "libudev";
+constexpr std::uint32_t    kUdevMagic  = 0xfeedcafe;
+
+/** USB vendor ID udev reports for Pulse-Eight adapters. */
+constexpr std::string_view kPulseEightVendorId = "2548";
+
+/** Wire header of a udevd message; fields after these are unused here. */
+struct UdevHeader {
+    char          prefix[8];
+    std::uint32_t magic;           ///< Big-endian.
+    std::uint32_t headerSize;
+    std::uint32_t propertiesOff;
+    std::uint32_t propertiesLen;
+};
+
+/** A udevd message's properties: NUL-separated @c KEY=VALUE strings. */
+class Properties {
+public:
+    Properties(const char* data, std::size_t size) noexcept : m_data(data, size) {}
+
+    /** Value of @p key, or empty when the message does not carry it. */
+    [[nodiscard]] std::string_view get(std::string_view key) const noexcept {
+        std::size_t pos = 0;
+        while (pos < m_data.size()) {
+            std::size_t end = m_data.find('\0', pos);
+            if (end == std::string_view::npos) end = m_data.size();
+            const std::string_view entry = m_data.substr(pos, end - pos);
+            if (entry.size() > key.size() && entry[key.size()] == '=' &&
+                entry.compare(0, key.size(), key) == 0) {
+                return entry.substr(key.size() + 1);
+            }
+            pos = end + 1;
+        }
+        return {};
+    }
+
+private:
+    std::string_view m_data;
+};
+
+bool isCecAdapter(const Properties& props) noexcept {
+    const std::string_view subsystem = props.get("SUBSYSTEM");
+    if (subsystem == "cec") return true;
+    return subsystem == "tty" && props.get("ID_VENDOR_ID") == kPulseEightVendorId;
+}
+
+} // namespace
+
+UdevMonitor::UdevMonitor(EventLoop& loop, Callback callback)
+    : m_loop(loop), m_callback(std::move(callback)) {}
+
+UdevMonitor::~UdevMonitor() {
+    stop();
+}
+
+bool UdevMonitor::start() {
+    if (m_socket.valid()) return true;
+
+    UnixSocket sock(::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                             NETLINK_KOBJECT_UEVENT));
+    if (!sock.valid()) {
+        LOG_WARNING("Cannot open udev netlink socket: ", std::strerror(errno));
+        return false;
+    }
+
+    const int on = 1;
+    if (::setsockopt(sock.get(), SOL_SOCKET, SO_PASSCRED, &on, sizeof(on)) != 0) {
+        LOG_WARNING("Cannot enable credentials on udev socket: ", std::strerror(errno));
+        return false;
+    }
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = kUdevMonitorGroup;
+    if (::bind(sock.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        LOG_WARNING("Cannot bind udev netlink socket: ", std::strerror(errno));
+        return false;
+    }
+
+    const auto READ = static_cast<std::uint32_t>(EventPoller::Event::READ);
+    if (!m_loop.add(sock.get(), READ, [this](std::uint32_t) { onReadable(); })) {
+        LOG_WARNING("Failed to register udev monitor with event loop");
+        return false;
+    }
+
+    m_socket = std::move(sock);
+    LOG_INFO("Watching udev for CEC adapter hotplug");
+    return true;
+}
+
+void UdevMonitor::stop() {
+    if (!m_socket.valid()) return;
+    m_loop.remove(m_socket.get());
+    m_socket.reset();
+}
+
+void UdevMonitor::onReadable() {
+    // udevd messages carry the full property set; 8 KiB holds any a
+    // tty or cec node produces. Larger ones are truncated and dropped.
+    std::array<char, 8192> buffer;
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(ucred))> control;
+
+    while (m_socket.valid()) {
+        iovec iov{buffer.data(), buffer.size()};
+        sockaddr_nl sender{};
+        msghdr msg{};
+        msg.msg_name       = &sender;
+        msg.msg_namelen    = sizeof(sender);
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control.data();
+        msg.msg_controllen = control.size();
+
+        const ssize_t n = ::recvmsg(m_socket.get(), &msg, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                // The kernel dropped events while we were busy; the
+                // next adapter event still arrives, so just go on.
+                LOG_DEBUG("udev monitor receive buffer overrun");
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARNING("udev monitor receive failed: ", std::strerror(errno));
+            }
+            return;
+        }
+        if ((msg.msg_flags & MSG_TRUNC) != 0 || sender.nl_pid == 0) continue;
+
+        const cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET ||
+            cmsg->cmsg_type != SCM_CREDENTIALS) {
+            continue;
+        }
+        ucred cred;
+        std::memcpy(&cred, CMSG_DATA(cmsg), sizeof(cred));
+        if (cred.uid != 0) continue;
+
+        handleMessage(buffer.data(), static_cast<std::size_t>(n));
+    }
+}
+
+void UdevMonitor::handleMessage(const char* data, std::size_t size) {
+    UdevHeader header;
+    if (size < sizeof(header)) return;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::string_view(header.prefix, kUdevPrefix.size()) != kUdevPrefix ||
+        header.prefix[kUdevPrefix.size()] != '\0' ||
+        ntohl(header.magic) != kUdevMagic) {
+        return;
+    }
+    if (header.propertiesOff < sizeof(header) || header.propertiesOff > size ||
+        header.propertiesLen > size - header.propertiesOff) {
+        return;
+    }
+
+    const Properties props(data + header.propertiesOff, header.propertiesLen);
+    if (!isCecAdapter(props)) return;
+
+    const std::string_view action = props.get("ACTION");
+    Action kind;
+    if (action == "add") {
+        kind = Action::Added;
+    } else if (action == "remove") {
+        kind = Action::Removed;
+    } else {
+        return;
+    }
+
+    const std::string devnode(props.get("DEVNAME"));
+    LOG_INFO("CEC adapter ", kind == Action::Added ? "plugged in" : "removed",
+             devnode.empty() ? "" : ": ", devnode);
+    if (m_callback) m_callback(kind, devnode);
+}
+
+} // namespace cec_control
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "../common/event_loop.h"
+#include "../common/unix_socket.h"
+
+namespace cec_control {
+
+/**
+ * @class UdevMonitor
+ * @brief Watches udev for CEC adapters being plugged in and pulled out.
+ *
+ * Listens on the netlink multicast group systemd-udevd announces
+ * processed device events on, so an @c Added event arrives once the
+ * device node exists and its properties are known — the adapter can
+ * be opened straight away. The socket is registered on the main
+ * @c EventLoop; there is no thread.
+ *
+ * An event is reported when it is for a CEC adapter: a tty whose USB
+ * vendor is Pulse-Eight (what libcec's USB driver opens), or a node in
+ * the kernel's @c cec subsystem. Everything else on the group is
+ * discarded after the header check.
+ *
+ * Messages not sent by root are ignored, as udev's own monitor does.
+ *
+ * The raw group is read instead of going through sd-device: libsystemd's
+ * device monitor hands its fd only to an sd-event loop, which this
+ * daemon does not run.
+ */
+class UdevMonitor {
+public:
+    enum class Action {
+        Added,
+        Removed,
+    };
+
+    /** Main thread; @p devnode is e.g. @c /dev/ttyACM0, possibly empty. */
+    using Callback = std::function<void(Action action, const std::string& devnode)>;
+
+    /** @param loop Non-owning; must outlive *this. */
+    UdevMonitor(EventLoop& loop, Callback callback);
+    ~UdevMonitor();
+
+    UdevMonitor(const UdevMonitor&)            = delete;
+    UdevMonitor& operator=(const UdevMonitor&) = delete;
+
+    /**
+     * Open the netlink socket and register it with the loop. Returns
+     * false, logged, when either step fails; the daemon then relies on
+     * libcec's connection-lost alert and the retry schedule alone.
+     */
+    [[nodiscard]] bool start();
+
+    /** Unregister and close the socket. Idempotent. */
+    void stop();
+
+private:
+    /** Drain every queued message; the socket is non-blocking. */
+    void onReadable();
+
+    /** Check one datagram's header and sender, then report it if it matches. */
+    void handleMessage(const char* data, std::size_t size);
+
+    EventLoop& m_loop;
+    Callback   m_callback;
+    // UnixSocket is used here purely as the owning fd wrapper; the
+    // descriptor is AF_NETLINK.
+    UnixSocket m_socket;
+};
+
+} // namespace cec_control
@@ -0,0 +1,36 @@
+#include "common/argument_parser.h"
+#include "common/help_printer.h"
+#include "common/system_paths.h"
+#include "daemon/daemon_bootstrap.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <type_traits>
+#include <variant>
+
+/**
+ * Entry point of cec-controld, the daemon: argv holds the options that
+ * follow `cec-control daemon`, which execs this binary. DaemonBootstrap
+ * catches its own exceptions; main holds no state and never throws.
+ */
+int main(int argc, char* argv[]) {
+    using namespace cec_control;
+
+    const Action action = ArgumentParser::parseDaemon(argc, argv);
+
+    return std::visit([](auto&& a) -> int {
+        using T = std::decay_t<decltype(a)>;
+        if constexpr (std::is_same_v<T, ParseError>) {
+            std::cerr << a.message << '\n';
+            return EXIT_FAILURE;
+        } else if constexpr (std::is_same_v<T, ShowHelp>) {
+            // Documented as `cec-control daemon`, which reaches here too.
+            HelpPrinter::printHelp(a.target, SystemPaths::APP_NAME.c_str());
+            return EXIT_SUCCESS;
+        } else if constexpr (std::is_same_v<T, RunDaemon>) {
+            return DaemonBootstrap::runDaemon(a);
+        } else {
+            return EXIT_FAILURE;  // parseDaemon yields nothing else.
+        }
+    }, action);
+}
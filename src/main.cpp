@@ -1,7 +1,6 @@
 #include "client/client_runner.h"
 #include "common/argument_parser.h"
 #include "common/help_printer.h"
-#include "daemon/daemon_bootstrap.h"
 
 #include <cstdlib>
 #include <iostream>
@@ -9,9 +8,12 @@
 #include <variant>
 
 /**
- * Entry point: parse argv, then dispatch on the resulting Action variant.
- * Each runner (ClientRunner / DaemonBootstrap) catches its own exceptions
- * and returns an exit code; main holds no state and never throws.
+ * Entry point of the cec-control CLI: parse argv, then dispatch on the
+ * resulting Action variant. ClientRunner catches its own exceptions and
+ * returns an exit code; main holds no state and never throws.
+ *
+ * The daemon is a separate executable (daemon_main.cpp), so this binary
+ * links neither libcec nor the daemon; `cec-control daemon` execs it.
  */
 int main(int argc, char* argv[]) {
     using namespace cec_control;
@@ -19,7 +21,7 @@ int main(int argc, char* argv[]) {
     const Action action = ArgumentParser::parse(argc, argv);
     const char* programName = argv[0];
 
-    return std::visit([programName](auto&& a) -> int {
+    return std::visit([programName, argc, argv](auto&& a) -> int {
         using T = std::decay_t<decltype(a)>;
         if constexpr (std::is_same_v<T, ParseError>) {
             std::cerr << a.message << '\n';
@@ -29,8 +31,15 @@ int main(int argc, char* argv[]) {
             return EXIT_SUCCESS;
         } else if constexpr (std::is_same_v<T, RunClient>) {
             return ClientRunner::run(a);
+        } else if constexpr (std::is_same_v<T, RunSession>) {
+            return ClientRunner::runSession(a);
+        } else if constexpr (std::is_same_v<T, RunFlightDump>) {
+            return ClientRunner::runFlightDump(a);
+        } else if constexpr (std::is_same_v<T, RunFleet>) {
+            return ClientRunner::runFleet(a);
         } else if constexpr (std::is_same_v<T, RunDaemon>) {
-            return DaemonBootstrap::runDaemon(a);
+            // Validated here; the daemon parses the same options again.
+            return ClientRunner::execDaemon(argc, argv);
         }
     }, action);
 }